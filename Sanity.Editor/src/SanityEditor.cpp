@@ -1,8 +1,10 @@
 #include "SanityEditor.hpp"
 
+#include <cstring>
 #include <filesystem>
 
 #include "Tracy.hpp"
+#include "benchmark/content_benchmarks.hpp"
 #include "entity/Components.hpp"
 #include "entt/entity/registry.hpp"
 #include "nlohmann/json.hpp"
@@ -26,6 +28,11 @@ int main(int argc, char** argv) {
 
     auto* editor = sanity::editor::initialize_editor(R"(E:\Documents\SanityEngine\Sanity.Game\SumerianGame.json)");
 
+    if(argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        sanity::editor::run_content_benchmarks(editor->get_content_directory());
+        return 0;
+    }
+
     editor->run_until_quit();
 
     return 0;
@@ -42,6 +49,7 @@ namespace sanity::editor {
 
         auto& renderer = g_engine->get_renderer();
         asset_loader = Rx::make_ptr<AssetLoader>(RX_SYSTEM_ALLOCATOR, &renderer);
+        g_engine->register_tick_function([&](const Float32 /* delta_time */) { asset_loader->tick(); });
 
         g_engine->register_tick_function([&](const Float32 delta_time) {
             auto* window = g_engine->get_window();
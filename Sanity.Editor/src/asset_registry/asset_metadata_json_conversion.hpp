@@ -4,14 +4,20 @@
 #include "nlohmann/json.hpp"
 
 namespace sanity::editor {
-    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(SceneImportSettings,
-                                       import_meshes,
-                                       scaling_factor,
-                                       import_materials,
-                                       generate_collision_geometry,
-                                       import_lights,
-                                       import_empties,
-                                       import_object_hierarchy);
+    // Settings that are missing from a metadata file keep their default values, so that metadata from before a setting existed still
+    // loads
+    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(SceneImportSettings,
+                                                    import_meshes,
+                                                    scaling_factor,
+                                                    import_materials,
+                                                    generate_collision_geometry,
+                                                    import_lights,
+                                                    import_empties,
+                                                    import_object_hierarchy,
+                                                    quantize_vertices,
+                                                    num_lods,
+                                                    lod_error,
+                                                    generate_meshlets);
 
     template <typename ImportSettingsType>
     void from_json(const nlohmann::json & j, AssetMetadata<ImportSettingsType>& asset_metadata) {
@@ -19,6 +19,31 @@ namespace sanity::editor {
 
     	bool import_object_hierarchy{true};
 
+        /*!
+         * \brief Whether to store the scene's vertices as PackedVertices, which are less than half the size of StandardVertices but
+         * lose some precision
+         *
+         * The importer logs how much precision the vertices lost. Packed meshes are drawn from the renderer's packed mesh store, and
+         * aren't raytraced
+         */
+        bool quantize_vertices{false};
+
+        /*!
+         * \brief How many simplified LODs to generate for each mesh, at most. 0 generates none
+         */
+        Uint32 num_lods{3};
+
+        /*!
+         * \brief How far the first LOD's surface may be from the mesh's surface, relative to the size of the mesh. Each further LOD may
+         * be off by twice as much as the one before it
+         */
+        float lod_error{0.01f};
+
+        /*!
+         * \brief Whether to split each mesh into meshlets, with bounds that let each meshlet be culled on its own
+         */
+        bool generate_meshlets{true};
+
        /*!
         * \brief Source file for this mesh asset
         *
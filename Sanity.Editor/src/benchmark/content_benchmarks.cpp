@@ -0,0 +1,307 @@
+#include "content_benchmarks.hpp"
+
+#include <chrono>
+
+#include "Tracy.hpp"
+#include "asset_registry/asset_registry_structs.hpp"
+#include "entt/entity/registry.hpp"
+#include "import/scene_importer.hpp"
+#include "loading/image_loading.hpp"
+#include "loading/mesh_simplification.hpp"
+#include "loading/pixel_conversion.hpp"
+#include "loading/texture_compression.hpp"
+#include "loading/texture_container.hpp"
+#include "renderer/bvh.hpp"
+#include "renderer/renderer.hpp"
+#include "rx/core/array.h"
+#include "rx/core/log.h"
+#include "rx/core/utility/move.h"
+#include "rx/core/vector.h"
+#include "sanity_engine.hpp"
+
+using namespace sanity::engine;
+
+namespace sanity::editor {
+    RX_LOG("ContentBenchmarks", logger);
+
+    static Rx::Vector<std::filesystem::path> find_files(const std::filesystem::path& directory, const Rx::Vector<const char*>& extensions) {
+        Rx::Vector<std::filesystem::path> paths;
+
+        std::error_code error;
+        for(const auto& entry : std::filesystem::recursive_directory_iterator{directory, error}) {
+            if(!entry.is_regular_file()) {
+                continue;
+            }
+
+            const auto extension = entry.path().extension();
+            extensions.each_fwd([&](const char* wanted_extension) {
+                if(extension == wanted_extension) {
+                    paths.push_back(entry.path());
+                    return RX_ITERATION_STOP;
+                }
+
+                return RX_ITERATION_CONTINUE;
+            });
+        }
+
+        return paths;
+    }
+
+    static void run_texture_compression_benchmark(const Rx::Vector<std::filesystem::path>& image_paths) {
+        ZoneScoped;
+
+        struct FormatTotals {
+            renderer::TextureFormat format;
+            const char* name;
+            Float64 compression_ms{0};
+            Float64 psnr{0};
+            Float64 megapixels{0};
+        };
+
+        Rx::Vector<FormatTotals> totals = Rx::Array{FormatTotals{.format = renderer::TextureFormat::Bc1, .name = "BC1"},
+                                                    FormatTotals{.format = renderer::TextureFormat::Bc4, .name = "BC4"},
+                                                    FormatTotals{.format = renderer::TextureFormat::Bc5, .name = "BC5"},
+                                                    FormatTotals{.format = renderer::TextureFormat::Bc7, .name = "BC7"}};
+
+        auto& thread_pool = g_engine->get_thread_pool();
+
+        Uint32 num_images{0};
+        image_paths.each_fwd([&](const std::filesystem::path& image_path) {
+            Uint32 width, height;
+            renderer::TextureFormat format;
+            auto* pixels = load_texture(image_path, width, height, format);
+            if(pixels == nullptr) {
+                return;
+            }
+
+            // Only LDR images get block compressed
+            if(format == renderer::TextureFormat::Rgba8) {
+                const auto megapixels = static_cast<Float64>(width) * height / 1000000.0;
+                totals.each_fwd([&](FormatTotals& format_totals) {
+                    const auto result = benchmark_texture_compression(static_cast<const Uint8*>(pixels),
+                                                                      width,
+                                                                      height,
+                                                                      format_totals.format,
+                                                                      &thread_pool);
+                    format_totals.compression_ms += result.compression_ms;
+                    format_totals.psnr += result.psnr;
+                    format_totals.megapixels += megapixels;
+                });
+
+                num_images++;
+            }
+
+            free_texture_data(pixels, format);
+        });
+
+        if(num_images == 0) {
+            logger->warning("No LDR images to compress");
+            return;
+        }
+
+        totals.each_fwd([&](const FormatTotals& format_totals) {
+            logger->info("%s: compressed %u images (%.1f MP) in %.2f ms, %.1f MP/s, %.2f dB average PSNR",
+                         format_totals.name,
+                         num_images,
+                         format_totals.megapixels,
+                         format_totals.compression_ms,
+                         format_totals.megapixels / (format_totals.compression_ms / 1000.0),
+                         format_totals.psnr / num_images);
+        });
+    }
+
+    static void run_pixel_conversion_benchmark() {
+        ZoneScoped;
+
+        // The size of a typical skybox face or large material texture
+        constexpr Uint32 IMAGE_SIZE = 2048;
+
+        const auto result = benchmark_pixel_conversion(IMAGE_SIZE, IMAGE_SIZE);
+
+        for(Uint32 num_channels = 1; num_channels <= 3; num_channels++) {
+            const auto per_pixel_ms = result.per_pixel_rgba8_ms[num_channels - 1];
+            const auto vectorized_ms = result.vectorized_rgba8_ms[num_channels - 1];
+            logger->info("%u-channel 8-bit to RGBA8: per-pixel loop %.2f ms, expand_to_rgba8 %.2f ms, %.1fx",
+                         num_channels,
+                         per_pixel_ms,
+                         vectorized_ms,
+                         vectorized_ms > 0 ? per_pixel_ms / vectorized_ms : 0);
+        }
+
+        logger->info("3-channel float to RGBA: per-pixel loop to RGBA32F %.2f ms, expand_to_rgba16f %.2f ms, %.1fx",
+                     result.per_pixel_rgba32f_ms,
+                     result.vectorized_rgba16f_ms,
+                     result.vectorized_rgba16f_ms > 0 ? result.per_pixel_rgba32f_ms / result.vectorized_rgba16f_ms : 0);
+    }
+
+    static Rx::Vector<import::DecodedPrimitive> load_primitives(const Rx::Vector<std::filesystem::path>& scene_paths) {
+        ZoneScoped;
+
+        import::SceneImporter importer{g_engine->get_renderer()};
+
+        Rx::Vector<import::DecodedPrimitive> primitives;
+        scene_paths.each_fwd([&](const std::filesystem::path& scene_path) {
+            auto scene_primitives = importer.load_gltf_primitives(scene_path);
+            scene_primitives.each_fwd([&](import::DecodedPrimitive& primitive) { primitives.push_back(Rx::Utility::move(primitive)); });
+        });
+
+        return primitives;
+    }
+
+    static void run_lod_generation_benchmark(const Rx::Vector<import::DecodedPrimitive>& primitives) {
+        ZoneScoped;
+
+        // Use the same LOD settings as a default import
+        const SceneImportSettings import_settings{};
+
+        Uint32 num_primitives{0};
+        Uint32 num_triangles{0};
+
+        // Triangles in each LOD, and how many primitives got that LOD. The LOD chain of a primitive which can't be simplified ends early
+        Rx::Vector<Uint32> num_lod_triangles;
+        num_lod_triangles.resize(import_settings.num_lods, 0);
+        Rx::Vector<Uint32> num_lod_primitives;
+        num_lod_primitives.resize(import_settings.num_lods, 0);
+
+        Float64 simplification_ms{0};
+        primitives.each_fwd([&](const import::DecodedPrimitive& primitive) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            const auto lods = generate_lods(primitive.vertices, primitive.indices, import_settings.num_lods, import_settings.lod_error);
+            simplification_ms += std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            for(Size lod_idx = 0; lod_idx < lods.size(); lod_idx++) {
+                num_lod_triangles[lod_idx] += static_cast<Uint32>(lods[lod_idx].indices.size() / 3);
+                num_lod_primitives[lod_idx]++;
+            }
+
+            num_triangles += static_cast<Uint32>(primitive.indices.size() / 3);
+            num_primitives++;
+        });
+
+        if(num_primitives == 0) {
+            logger->warning("No meshes to simplify");
+            return;
+        }
+
+        logger->info("LOD generation: simplified %u primitives (%u triangles) in %.2f ms",
+                     num_primitives,
+                     num_triangles,
+                     simplification_ms);
+        for(Uint32 lod_idx = 0; lod_idx < num_lod_triangles.size(); lod_idx++) {
+            logger->info("LOD %u: %u of %u primitives, %u triangles",
+                         lod_idx + 1,
+                         num_lod_primitives[lod_idx],
+                         num_primitives,
+                         num_lod_triangles[lod_idx]);
+        }
+    }
+
+    static void log_bvh_benchmark_result(const char* name, const renderer::BvhBenchmarkResult& result) {
+        logger->info("%s: %u triangles, %u nodes built in %.2f ms, SAH cost %.1f. %u of %u rays hit in %.2f ms, %.2f Mrays/s",
+                     name,
+                     result.num_triangles,
+                     result.num_nodes,
+                     result.build_ms,
+                     result.sah_cost,
+                     result.num_hits,
+                     result.num_rays,
+                     result.trace_ms,
+                     result.megarays_per_second);
+    }
+
+    static void run_mesh_bvh_benchmark(const Rx::Vector<import::DecodedPrimitive>& primitives) {
+        ZoneScoped;
+
+        auto& thread_pool = g_engine->get_thread_pool();
+
+        // Benchmark the largest primitive, since small ones are over before the thread pool gets going
+        const import::DecodedPrimitive* largest_primitive = nullptr;
+        primitives.each_fwd([&](const import::DecodedPrimitive& primitive) {
+            if(largest_primitive == nullptr || primitive.indices.size() > largest_primitive->indices.size()) {
+                largest_primitive = &primitive;
+            }
+        });
+
+        if(largest_primitive == nullptr) {
+            logger->warning("No meshes to build a BVH over");
+            return;
+        }
+
+        Rx::Vector<glm::vec3> locations;
+        locations.reserve(largest_primitive->vertices.size());
+        largest_primitive->vertices.each_fwd([&](const renderer::StandardVertex& vertex) { locations.push_back(vertex.location); });
+
+        const auto result = renderer::benchmark_bvh(locations.data(),
+                                                    static_cast<Uint32>(locations.size()),
+                                                    largest_primitive->indices.data(),
+                                                    static_cast<Uint32>(largest_primitive->indices.size()),
+                                                    &thread_pool);
+        log_bvh_benchmark_result("Mesh BVH", result);
+    }
+
+    /*!
+     * \brief Imports the scenes into a registry of their own, and builds and traces a two-level BVH over everything in them
+     *
+     * Unlike the other benchmarks, this one uploads the scenes' meshes to the GPU, since it gets the mesh BVHs from the static mesh store
+     */
+    static void run_scene_bvh_benchmark(const Rx::Vector<std::filesystem::path>& scene_paths) {
+        ZoneScoped;
+
+        auto& renderer = g_engine->get_renderer();
+        auto& mesh_store = renderer.get_static_mesh_store();
+
+        import::SceneImporter importer{renderer};
+        const SceneImportSettings import_settings{};
+        entt::registry registry;
+
+        mesh_store.set_keep_vertex_locations(true);
+        scene_paths.each_fwd([&](const std::filesystem::path& scene_path) {
+            if(!importer.import_gltf_scene(scene_path, import_settings, registry)) {
+                logger->warning("Could not import %s, so it's not in the scene BVH", scene_path);
+            }
+        });
+        mesh_store.set_keep_vertex_locations(false);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        const auto instances = renderer.get_bvh_instances(registry);
+        const auto mesh_bvh_ms = std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if(instances.is_empty()) {
+            logger->warning("No meshes to build a scene BVH over");
+            return;
+        }
+
+        logger->info("Scene BVH: built the BVHs of %u instances' meshes in %.2f ms", instances.size(), mesh_bvh_ms);
+        log_bvh_benchmark_result("Scene BVH", renderer::benchmark_scene_bvh(instances, &g_engine->get_thread_pool()));
+    }
+
+    void run_content_benchmarks(const std::filesystem::path& content_directory) {
+        ZoneScoped;
+
+        logger->info("Running content benchmarks on %s", content_directory);
+
+        const Rx::Vector<const char*> image_extensions = Rx::Array{".png", ".jpg", ".jpeg", ".tga", ".bmp", ".hdr"};
+        const auto image_paths = find_files(content_directory, image_extensions);
+        logger->info("Found %u images", image_paths.size());
+
+        run_texture_compression_benchmark(image_paths);
+
+        run_pixel_conversion_benchmark();
+
+        const auto loading_result = benchmark_texture_loading(content_directory);
+        logger->info("Texture loading: %.1f MB decoded by stb_image, %.1f MB read from texture containers",
+                     static_cast<Float64>(loading_result.decoded_size) / (1024.0 * 1024.0),
+                     static_cast<Float64>(loading_result.container_size) / (1024.0 * 1024.0));
+
+        const Rx::Vector<const char*> scene_extensions = Rx::Array{".gltf", ".glb"};
+        const auto scene_paths = find_files(content_directory, scene_extensions);
+        logger->info("Found %u scenes", scene_paths.size());
+
+        const auto primitives = load_primitives(scene_paths);
+
+        run_lod_generation_benchmark(primitives);
+
+        run_mesh_bvh_benchmark(primitives);
+
+        run_scene_bvh_benchmark(scene_paths);
+    }
+} // namespace sanity::editor
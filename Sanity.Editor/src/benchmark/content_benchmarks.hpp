@@ -0,0 +1,13 @@
+#pragma once
+
+#include <filesystem>
+
+namespace sanity::editor {
+    /*!
+     * \brief Runs the content pipeline's benchmarks on the images and meshes in a content directory, and logs their results
+     *
+     * Run the editor with `--benchmark` to run these on the project's content and quit. Only the scene BVH benchmark uses the GPU, to
+     * upload the scenes' meshes like a normal import
+     */
+    void run_content_benchmarks(const std::filesystem::path& content_directory);
+} // namespace sanity::editor
@@ -0,0 +1,478 @@
+#include "scene_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "asset_registry/asset_registry_structs.hpp"
+#include "core/align.hpp"
+#include "core/fs/path_ops.hpp"
+#include "core/hash.hpp"
+#include "rx/core/log.h"
+#include "rx/core/optional.h"
+
+namespace sanity::editor::import {
+    RX_LOG("SceneCache", logger);
+
+    constexpr Uint32 SCENE_CACHE_MAGIC = 0x4E435353; // "SSCN"
+
+    /*!
+     * \brief Increment this when the file format or the way the importer processes scenes changes, so that old caches get rewritten
+     */
+    constexpr Uint32 SCENE_CACHE_VERSION = 8;
+
+    /*!
+     * \brief Alignment of each section of a cache file, so that the mapped sections can be read in place
+     */
+    constexpr Uint64 SCENE_CACHE_SECTION_ALIGNMENT = 16;
+
+    struct SceneCacheSection {
+        Uint64 offset{0};
+
+        /*!
+         * \brief Number of elements in the section
+         */
+        Uint64 size{0};
+    };
+
+    struct SceneCacheDependency {
+        Uint64 hash{0};
+
+        /*!
+         * \brief Offset of the dependency's URI in the cache's dependency paths
+         */
+        Uint32 path_offset{0};
+
+        Uint32 padding{0};
+    };
+
+    struct SceneCacheHeader {
+        Uint32 magic{SCENE_CACHE_MAGIC};
+
+        Uint32 version{SCENE_CACHE_VERSION};
+
+        /*!
+         * \brief Hash of the scene file's contents
+         */
+        Uint64 source_hash{0};
+
+        Uint64 settings_hash{0};
+
+        SceneCacheSection dependencies;
+
+        SceneCacheSection dependency_paths;
+
+        SceneCacheSection vertices;
+
+        SceneCacheSection packed_vertices;
+
+        SceneCacheSection indices;
+
+        SceneCacheSection meshlets;
+
+        SceneCacheSection meshlet_bounds;
+
+        SceneCacheSection meshlet_vertices;
+
+        SceneCacheSection meshlet_triangles;
+
+        SceneCacheSection primitives;
+
+        SceneCacheSection meshes;
+
+        SceneCacheSection textures;
+
+        SceneCacheSection texture_data;
+
+        SceneCacheSection materials;
+
+        SceneCacheSection nodes;
+
+        SceneCacheSection strings;
+    };
+
+    static Rx::Optional<Uint64> hash_file(const std::filesystem::path& path) {
+        ZoneScoped;
+
+        engine::MappedFile file;
+        if(!file.open(path)) {
+            return Rx::nullopt;
+        }
+
+        return engine::hash_bytes(file.get_data(), file.get_size());
+    }
+
+    static Uint64 hash_import_settings(const SceneImportSettings& import_settings) {
+        // Only the settings which change what the importer makes. source_file is where the scene came from, which the hash of the scene
+        // file already covers
+        struct HashedSettings {
+            Float32 scaling_factor;
+            Float32 lod_error;
+            Uint32 num_lods;
+            Uint8 import_meshes;
+            Uint8 import_materials;
+            Uint8 generate_collision_geometry;
+            Uint8 import_lights;
+            Uint8 import_empties;
+            Uint8 import_object_hierarchy;
+            Uint8 quantize_vertices;
+            Uint8 generate_meshlets;
+        };
+
+        const auto settings = HashedSettings{.scaling_factor = import_settings.scaling_factor,
+                                             .lod_error = import_settings.lod_error,
+                                             .num_lods = import_settings.num_lods,
+                                             .import_meshes = import_settings.import_meshes,
+                                             .import_materials = import_settings.import_materials,
+                                             .generate_collision_geometry = import_settings.generate_collision_geometry,
+                                             .import_lights = import_settings.import_lights,
+                                             .import_empties = import_settings.import_empties,
+                                             .import_object_hierarchy = import_settings.import_object_hierarchy,
+                                             .quantize_vertices = import_settings.quantize_vertices,
+                                             .generate_meshlets = import_settings.generate_meshlets};
+
+        return engine::hash_bytes(&settings, sizeof(HashedSettings));
+    }
+
+    template <typename ElementType>
+    static SceneArray<ElementType> get_section(const Uint8* file_data, const SceneCacheSection& section) {
+        return SceneArray<ElementType>{.data = reinterpret_cast<const ElementType*>(file_data + section.offset), .size = section.size};
+    }
+
+    bool SceneCache::open(const std::filesystem::path& cache_path) {
+        ZoneScoped;
+
+        close();
+
+        if(!file.open(cache_path)) {
+            return false;
+        }
+
+        if(file.get_size() < sizeof(SceneCacheHeader)) {
+            close();
+            return false;
+        }
+
+        header = reinterpret_cast<const SceneCacheHeader*>(file.get_data());
+        if(!is_valid()) {
+            logger->warning("Scene cache %s is invalid or out of date", cache_path);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void SceneCache::close() {
+        header = nullptr;
+        file.close();
+    }
+
+    bool SceneCache::is_open() const { return header != nullptr; }
+
+    bool SceneCache::is_up_to_date(const std::filesystem::path& scene_path, const SceneImportSettings& import_settings) const {
+        ZoneScoped;
+
+        if(header->settings_hash != hash_import_settings(import_settings)) {
+            return false;
+        }
+
+        if(const auto source_hash = hash_file(scene_path); !source_hash || *source_hash != header->source_hash) {
+            return false;
+        }
+
+        const auto scene_directory = scene_path.parent_path();
+        const auto dependencies = get_section<SceneCacheDependency>(file.get_data(), header->dependencies);
+        const auto dependency_paths = get_section<char>(file.get_data(), header->dependency_paths);
+        for(Size i = 0; i < dependencies.size; i++) {
+            const auto& dependency = dependencies[i];
+            const auto hash = hash_file(scene_directory / (dependency_paths.data + dependency.path_offset));
+            if(!hash || *hash != dependency.hash) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    SceneDataView SceneCache::get_view() const {
+        const auto* file_data = file.get_data();
+        return SceneDataView{.vertices = get_section<engine::renderer::StandardVertex>(file_data, header->vertices),
+                             .packed_vertices = get_section<engine::renderer::PackedVertex>(file_data, header->packed_vertices),
+                             .indices = get_section<Uint32>(file_data, header->indices),
+                             .meshlets = get_section<engine::renderer::Meshlet>(file_data, header->meshlets),
+                             .meshlet_bounds = get_section<engine::renderer::MeshletBounds>(file_data, header->meshlet_bounds),
+                             .meshlet_vertices = get_section<Uint32>(file_data, header->meshlet_vertices),
+                             .meshlet_triangles = get_section<Uint8>(file_data, header->meshlet_triangles),
+                             .primitives = get_section<ScenePrimitive>(file_data, header->primitives),
+                             .meshes = get_section<SceneMesh>(file_data, header->meshes),
+                             .textures = get_section<SceneTexture>(file_data, header->textures),
+                             .texture_data = get_section<Uint8>(file_data, header->texture_data),
+                             .materials = get_section<SceneMaterial>(file_data, header->materials),
+                             .nodes = get_section<SceneNode>(file_data, header->nodes),
+                             .strings = get_section<char>(file_data, header->strings)};
+    }
+
+    template <typename ElementType>
+    static bool is_section_in_file(const SceneCacheSection& section, const Size file_size) {
+        return section.offset % SCENE_CACHE_SECTION_ALIGNMENT == 0 && section.offset <= file_size &&
+               section.size <= (file_size - section.offset) / sizeof(ElementType);
+    }
+
+    static bool is_string_in_bounds(const SceneArray<char>& strings, const Uint32 offset) {
+        // The last string ends at the end of the section, so a string that starts in the section ends in it too
+        return offset < strings.size && strings[strings.size - 1] == '\0';
+    }
+
+    static bool is_texture_reference_valid(const Int32 texture, const Size num_textures) {
+        return texture == NO_TEXTURE || texture == MISSING_TEXTURE || (texture >= 0 && static_cast<Size>(texture) < num_textures);
+    }
+
+    static bool is_meshlet_valid(const SceneDataView& scene, const engine::renderer::Meshlet& meshlet, const Uint32 num_vertices) {
+        if(meshlet.num_vertices > engine::renderer::MAX_MESHLET_VERTICES ||
+           static_cast<Uint64>(meshlet.vertex_offset) + meshlet.num_vertices > scene.meshlet_vertices.size ||
+           (static_cast<Uint64>(meshlet.triangle_offset) + meshlet.num_triangles) * 3 > scene.meshlet_triangles.size) {
+            return false;
+        }
+
+        for(Uint32 i = 0; i < meshlet.num_vertices; i++) {
+            if(scene.meshlet_vertices[meshlet.vertex_offset + i] >= num_vertices) {
+                return false;
+            }
+        }
+
+        for(Uint32 i = 0; i < meshlet.num_triangles * 3; i++) {
+            if(scene.meshlet_triangles[meshlet.triangle_offset * 3 + i] >= meshlet.num_vertices) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool SceneCache::is_valid() const {
+        ZoneScoped;
+
+        if(header->magic != SCENE_CACHE_MAGIC || header->version != SCENE_CACHE_VERSION) {
+            return false;
+        }
+
+        const auto file_size = file.get_size();
+        const auto sections_in_file = is_section_in_file<SceneCacheDependency>(header->dependencies, file_size) &&
+                                      is_section_in_file<char>(header->dependency_paths, file_size) &&
+                                      is_section_in_file<engine::renderer::StandardVertex>(header->vertices, file_size) &&
+                                      is_section_in_file<engine::renderer::PackedVertex>(header->packed_vertices, file_size) &&
+                                      is_section_in_file<Uint32>(header->indices, file_size) &&
+                                      is_section_in_file<engine::renderer::Meshlet>(header->meshlets, file_size) &&
+                                      is_section_in_file<engine::renderer::MeshletBounds>(header->meshlet_bounds, file_size) &&
+                                      is_section_in_file<Uint32>(header->meshlet_vertices, file_size) &&
+                                      is_section_in_file<Uint8>(header->meshlet_triangles, file_size) &&
+                                      is_section_in_file<ScenePrimitive>(header->primitives, file_size) &&
+                                      is_section_in_file<SceneMesh>(header->meshes, file_size) &&
+                                      is_section_in_file<SceneTexture>(header->textures, file_size) &&
+                                      is_section_in_file<Uint8>(header->texture_data, file_size) &&
+                                      is_section_in_file<SceneMaterial>(header->materials, file_size) &&
+                                      is_section_in_file<SceneNode>(header->nodes, file_size) &&
+                                      is_section_in_file<char>(header->strings, file_size);
+        if(!sections_in_file) {
+            return false;
+        }
+
+        // The importer indexes into the scene without checking anything, so make sure that every index in the file is in bounds
+        const auto dependencies = get_section<SceneCacheDependency>(file.get_data(), header->dependencies);
+        const auto dependency_paths = get_section<char>(file.get_data(), header->dependency_paths);
+        for(Size i = 0; i < dependencies.size; i++) {
+            if(!is_string_in_bounds(dependency_paths, dependencies[i].path_offset)) {
+                return false;
+            }
+        }
+
+        const auto scene = get_view();
+        for(Size i = 0; i < scene.primitives.size; i++) {
+            const auto& primitive = scene.primitives[i];
+            const auto num_vertices = primitive.is_packed ? scene.packed_vertices.size : scene.vertices.size;
+            if(static_cast<Uint64>(primitive.first_vertex) + primitive.num_vertices > num_vertices ||
+               static_cast<Uint64>(primitive.first_index) + primitive.num_indices > scene.indices.size ||
+               primitive.num_lods > engine::renderer::MAX_MESH_LODS) {
+                return false;
+            }
+
+            for(Uint32 lod_idx = 0; lod_idx < primitive.num_lods; lod_idx++) {
+                const auto& lod = primitive.lods[lod_idx];
+                if(static_cast<Uint64>(lod.index_offset) + lod.num_indices > primitive.num_indices) {
+                    return false;
+                }
+            }
+
+            if(static_cast<Uint64>(primitive.first_meshlet) + primitive.num_meshlets > scene.meshlets.size ||
+               scene.meshlet_bounds.size != scene.meshlets.size) {
+                return false;
+            }
+
+            for(auto meshlet_idx = primitive.first_meshlet; meshlet_idx < primitive.first_meshlet + primitive.num_meshlets; meshlet_idx++) {
+                if(!is_meshlet_valid(scene, scene.meshlets[meshlet_idx], primitive.num_vertices)) {
+                    return false;
+                }
+            }
+        }
+
+        for(Size i = 0; i < scene.meshes.size; i++) {
+            const auto& mesh = scene.meshes[i];
+            if(static_cast<Uint64>(mesh.first_primitive) + mesh.num_primitives > scene.primitives.size) {
+                return false;
+            }
+        }
+
+        for(Size i = 0; i < scene.textures.size; i++) {
+            const auto& texture = scene.textures[i];
+            const auto mip_chain_size = engine::renderer::get_mip_chain_size_in_bytes(texture.format,
+                                                                                      texture.width,
+                                                                                      texture.height,
+                                                                                      texture.num_mips);
+            if(!is_string_in_bounds(scene.strings, texture.name_offset) ||
+               texture.format > engine::renderer::TextureFormat::Bc7 || texture.data_size != mip_chain_size ||
+               texture.data_offset > scene.texture_data.size || texture.data_size > scene.texture_data.size - texture.data_offset) {
+                return false;
+            }
+        }
+
+        for(Size i = 0; i < scene.materials.size; i++) {
+            const auto& material = scene.materials[i];
+            if(!is_texture_reference_valid(material.base_color_texture, scene.textures.size) ||
+               !is_texture_reference_valid(material.metallic_roughness_texture, scene.textures.size) ||
+               !is_texture_reference_valid(material.normal_texture, scene.textures.size) ||
+               !is_texture_reference_valid(material.emission_texture, scene.textures.size)) {
+                return false;
+            }
+        }
+
+        for(Size i = 0; i < scene.nodes.size; i++) {
+            const auto& node = scene.nodes[i];
+            if(!is_string_in_bounds(scene.strings, node.name_offset) || node.parent_idx >= static_cast<Int32>(i) ||
+               node.mesh_idx >= static_cast<Int64>(scene.meshes.size)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::filesystem::path get_scene_cache_path(const std::filesystem::path& scene_path) {
+        return engine::append_extension(scene_path, "scene_cache");
+    }
+
+    template <typename ElementType>
+    static void add_section(SceneCacheSection& section, const Rx::Vector<ElementType>& elements, Uint64& file_size) {
+        section.offset = ALIGN(SCENE_CACHE_SECTION_ALIGNMENT, file_size);
+        section.size = elements.size();
+        file_size = section.offset + elements.size() * sizeof(ElementType);
+    }
+
+    template <typename ElementType>
+    static bool write_section(FILE* cache_file, const SceneCacheSection& section, const Rx::Vector<ElementType>& elements) {
+        // Pad up to the start of the section
+        constexpr Uint8 padding[SCENE_CACHE_SECTION_ALIGNMENT] = {};
+        const auto position = static_cast<Uint64>(_ftelli64(cache_file));
+        if(fwrite(padding, sizeof(Uint8), section.offset - position, cache_file) != section.offset - position) {
+            return false;
+        }
+
+        return fwrite(elements.data(), sizeof(ElementType), elements.size(), cache_file) == elements.size();
+    }
+
+    bool write_scene_cache(const std::filesystem::path& cache_path,
+                           const std::filesystem::path& scene_path,
+                           const Rx::Vector<Rx::String>& dependencies,
+                           const SceneImportSettings& import_settings,
+                           const SceneData& scene) {
+        ZoneScoped;
+
+        const auto source_hash = hash_file(scene_path);
+        if(!source_hash) {
+            return false;
+        }
+
+        auto header = SceneCacheHeader{.source_hash = *source_hash, .settings_hash = hash_import_settings(import_settings)};
+
+        const auto scene_directory = scene_path.parent_path();
+
+        Rx::Vector<SceneCacheDependency> cache_dependencies;
+        Rx::Vector<char> dependency_paths;
+        cache_dependencies.reserve(dependencies.size());
+        for(Size i = 0; i < dependencies.size(); i++) {
+            const auto& dependency = dependencies[i];
+
+            const auto hash = hash_file(scene_directory / dependency.data());
+            if(!hash) {
+                logger->warning("Could not read %s, which scene %s references. Not caching the scene", dependency, scene_path);
+                return false;
+            }
+
+            const auto path_offset = static_cast<Uint32>(dependency_paths.size());
+            dependency_paths.resize(path_offset + dependency.size() + 1);
+            memcpy(dependency_paths.data() + path_offset, dependency.data(), dependency.size() + 1);
+
+            cache_dependencies.push_back(SceneCacheDependency{.hash = *hash, .path_offset = path_offset});
+        }
+
+        Uint64 file_size{sizeof(SceneCacheHeader)};
+        add_section(header.dependencies, cache_dependencies, file_size);
+        add_section(header.dependency_paths, dependency_paths, file_size);
+        add_section(header.vertices, scene.vertices, file_size);
+        add_section(header.packed_vertices, scene.packed_vertices, file_size);
+        add_section(header.indices, scene.indices, file_size);
+        add_section(header.meshlets, scene.meshlets, file_size);
+        add_section(header.meshlet_bounds, scene.meshlet_bounds, file_size);
+        add_section(header.meshlet_vertices, scene.meshlet_vertices, file_size);
+        add_section(header.meshlet_triangles, scene.meshlet_triangles, file_size);
+        add_section(header.primitives, scene.primitives, file_size);
+        add_section(header.meshes, scene.meshes, file_size);
+        add_section(header.textures, scene.textures, file_size);
+        add_section(header.texture_data, scene.texture_data, file_size);
+        add_section(header.materials, scene.materials, file_size);
+        add_section(header.nodes, scene.nodes, file_size);
+        add_section(header.strings, scene.strings, file_size);
+
+        // Write to a temporary file and move it into place, so that nothing maps a half-written cache
+        const auto temp_path = engine::append_extension(cache_path, "tmp");
+        const auto temp_path_string = temp_path.string();
+        auto* cache_file = fopen(temp_path_string.c_str(), "wb");
+        if(cache_file == nullptr) {
+            logger->error("Could not open scene cache %s for writing", temp_path);
+            return false;
+        }
+
+        const auto wrote_data = fwrite(&header, sizeof(SceneCacheHeader), 1, cache_file) == 1 &&
+                                write_section(cache_file, header.dependencies, cache_dependencies) &&
+                                write_section(cache_file, header.dependency_paths, dependency_paths) &&
+                                write_section(cache_file, header.vertices, scene.vertices) &&
+                                write_section(cache_file, header.packed_vertices, scene.packed_vertices) &&
+                                write_section(cache_file, header.indices, scene.indices) &&
+                                write_section(cache_file, header.meshlets, scene.meshlets) &&
+                                write_section(cache_file, header.meshlet_bounds, scene.meshlet_bounds) &&
+                                write_section(cache_file, header.meshlet_vertices, scene.meshlet_vertices) &&
+                                write_section(cache_file, header.meshlet_triangles, scene.meshlet_triangles) &&
+                                write_section(cache_file, header.primitives, scene.primitives) &&
+                                write_section(cache_file, header.meshes, scene.meshes) &&
+                                write_section(cache_file, header.textures, scene.textures) &&
+                                write_section(cache_file, header.texture_data, scene.texture_data) &&
+                                write_section(cache_file, header.materials, scene.materials) &&
+                                write_section(cache_file, header.nodes, scene.nodes) &&
+                                write_section(cache_file, header.strings, scene.strings);
+        fclose(cache_file);
+
+        std::error_code error;
+        if(wrote_data) {
+            std::filesystem::rename(temp_path, cache_path, error);
+        }
+
+        if(!wrote_data || error) {
+            logger->error("Could not write scene cache %s", cache_path);
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+
+        return true;
+    }
+} // namespace sanity::editor::import
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/fs/mapped_file.hpp"
+#include "import/scene_data.hpp"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+
+namespace sanity::editor {
+    struct SceneImportSettings;
+
+    namespace import {
+        struct SceneCacheHeader;
+
+        /*!
+         * \brief A scene which the importer made from a glTF file, mapped from the cache file it was written to
+         *
+         * Importing a scene from its cache skips parsing the glTF file, decoding and compressing its images, and converting its vertices.
+         * The cache's vertices, indices, and texture data get copied straight from the mapped file into staging memory
+         */
+        class SceneCache {
+        public:
+            SceneCache() = default;
+
+            SceneCache(const SceneCache& other) = delete;
+            SceneCache& operator=(const SceneCache& other) = delete;
+
+            SceneCache(SceneCache&& old) noexcept = delete;
+            SceneCache& operator=(SceneCache&& old) noexcept = delete;
+
+            ~SceneCache() = default;
+
+            /*!
+             * \brief Maps a cache file and checks that everything in it is in bounds
+             *
+             * \return false if the file doesn't exist, is from an older version of the editor, or is corrupt
+             */
+            bool open(const std::filesystem::path& cache_path);
+
+            void close();
+
+            [[nodiscard]] bool is_open() const;
+
+            /*!
+             * \brief Checks if the cache was made from the current contents of the scene file and of every file that the scene references,
+             * with the same import settings
+             *
+             * Hashes all of those files, rather than trusting their modification times
+             */
+            [[nodiscard]] bool is_up_to_date(const std::filesystem::path& scene_path, const SceneImportSettings& import_settings) const;
+
+            /*!
+             * \brief The scene in the cache, pointing into the mapped file. Only valid while the cache is open
+             */
+            [[nodiscard]] SceneDataView get_view() const;
+
+        private:
+            engine::MappedFile file;
+
+            const SceneCacheHeader* header{nullptr};
+
+            [[nodiscard]] bool is_valid() const;
+        };
+
+        /*!
+         * \brief Path of the cache file of a scene. It sits next to the scene file
+         */
+        [[nodiscard]] std::filesystem::path get_scene_cache_path(const std::filesystem::path& scene_path);
+
+        /*!
+         * \brief Writes a scene to a cache file
+         *
+         * \param dependencies URIs of the files that the scene references, such as buffers and images, relative to the scene file. The
+         * cache stores their hashes, so that it knows when they change
+         */
+        bool write_scene_cache(const std::filesystem::path& cache_path,
+                               const std::filesystem::path& scene_path,
+                               const Rx::Vector<Rx::String>& dependencies,
+                               const SceneImportSettings& import_settings,
+                               const SceneData& scene);
+    } // namespace import
+} // namespace sanity::editor
@@ -0,0 +1,39 @@
+#include "scene_data.hpp"
+
+#include <cstring>
+
+namespace sanity::editor::import {
+    template <typename ElementType>
+    static SceneArray<ElementType> get_array(const Rx::Vector<ElementType>& vector) {
+        return SceneArray<ElementType>{.data = vector.data(), .size = vector.size()};
+    }
+
+    const char* SceneDataView::get_string(const Uint32 offset) const { return strings.data + offset; }
+
+    Uint32 SceneData::add_string(const char* string) {
+        const auto offset = static_cast<Uint32>(strings.size());
+        const auto length = strlen(string);
+
+        strings.resize(offset + length + 1);
+        memcpy(strings.data() + offset, string, length + 1);
+
+        return offset;
+    }
+
+    SceneDataView SceneData::get_view() const {
+        return SceneDataView{.vertices = get_array(vertices),
+                             .packed_vertices = get_array(packed_vertices),
+                             .indices = get_array(indices),
+                             .meshlets = get_array(meshlets),
+                             .meshlet_bounds = get_array(meshlet_bounds),
+                             .meshlet_vertices = get_array(meshlet_vertices),
+                             .meshlet_triangles = get_array(meshlet_triangles),
+                             .primitives = get_array(primitives),
+                             .meshes = get_array(meshes),
+                             .textures = get_array(textures),
+                             .texture_data = get_array(texture_data),
+                             .materials = get_array(materials),
+                             .nodes = get_array(nodes),
+                             .strings = get_array(strings)};
+    }
+} // namespace sanity::editor::import
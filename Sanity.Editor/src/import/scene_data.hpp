@@ -0,0 +1,243 @@
+#pragma once
+
+#include "core/transform.hpp"
+#include "core/types.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "renderer/hlsl/standard_material.hpp"
+#include "renderer/lights.hpp"
+#include "renderer/mesh.hpp"
+#include "renderer/rhi/resources.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::editor::import {
+    /*!
+     * \brief Value of a material's texture reference when the material doesn't use that texture
+     */
+    constexpr Int32 NO_TEXTURE = -1;
+
+    /*!
+     * \brief Value of a material's texture reference when the material uses a texture that couldn't be imported. Such materials get the
+     * renderer's pink texture
+     */
+    constexpr Int32 MISSING_TEXTURE = -2;
+
+    // Everything the importer makes from a glTF scene, in a form that can be written to the scene's cache file as it is and used straight
+    // from the mapped file. Each of these structs must be trivially copyable and without pointers
+
+    struct ScenePrimitive {
+        /*!
+         * \brief Index of the primitive's first vertex in the scene's vertices
+         */
+        Uint32 first_vertex{0};
+
+        Uint32 num_vertices{0};
+
+        /*!
+         * \brief Index of the primitive's first index in the scene's indices. The indices are relative to the primitive's first vertex
+         */
+        Uint32 first_index{0};
+
+        /*!
+         * \brief Number of indices of the primitive and of its LODs. The indices of the primitive's LODs follow its own indices
+         */
+        Uint32 num_indices{0};
+
+        engine::BoundingBox bounds{};
+
+        Int32 material_idx{-1};
+
+        /*!
+         * \brief Whether the primitive's vertices are in the scene's packed vertices rather than in its vertices
+         */
+        Uint32 is_packed{0};
+
+        /*!
+         * \brief How to decode the primitive's packed vertices, if it has them
+         */
+        engine::renderer::MeshDequantization dequantization{};
+
+        Uint32 num_lods{0};
+
+        /*!
+         * \brief The primitive's simplified LODs. Their index offsets are relative to the primitive's first index
+         */
+        engine::renderer::MeshLod lods[engine::renderer::MAX_MESH_LODS]{};
+
+        /*!
+         * \brief The primitive's meshlets in the scene's meshlets and meshlet bounds
+         *
+         * The meshlets' vertex and triangle offsets point into the scene's meshlet vertices and meshlet triangles, and their vertices are
+         * relative to the primitive's first vertex
+         */
+        Uint32 first_meshlet{0};
+
+        Uint32 num_meshlets{0};
+    };
+
+    struct SceneMesh {
+        Uint32 first_primitive{0};
+
+        Uint32 num_primitives{0};
+    };
+
+    /*!
+     * \brief A texture with all its mips, ready to upload
+     */
+    struct SceneTexture {
+        /*!
+         * \brief Offset of the texture's name in the scene's strings
+         */
+        Uint32 name_offset{0};
+
+        engine::renderer::TextureFormat format{engine::renderer::TextureFormat::Rgba8};
+
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        Uint32 num_mips{1};
+
+        Uint32 padding{0};
+
+        /*!
+         * \brief Offset of the texture's mips in the scene's texture data. The mips are tightly packed one after another
+         */
+        Uint64 data_offset{0};
+
+        Uint64 data_size{0};
+    };
+
+    struct SceneMaterial {
+        /*!
+         * \brief The material's values. Its texture indices get filled in from the texture references below when the material is
+         * allocated
+         */
+        engine::renderer::StandardMaterial material{};
+
+        // Indices of the material's textures in the scene's textures, or NO_TEXTURE or MISSING_TEXTURE
+
+        Int32 base_color_texture{NO_TEXTURE};
+
+        Int32 metallic_roughness_texture{NO_TEXTURE};
+
+        Int32 normal_texture{NO_TEXTURE};
+
+        Int32 emission_texture{NO_TEXTURE};
+    };
+
+    /*!
+     * \brief A node of the scene's hierarchy. Nodes are stored in the order they get created in, parents before their children
+     */
+    struct SceneNode {
+        Uint32 name_offset{0};
+
+        /*!
+         * \brief Index of the node's parent in the scene's nodes, or -1 if the node is a child of the scene's root
+         */
+        Int32 parent_idx{-1};
+
+        /*!
+         * \brief Index of the node's mesh in the scene's meshes, or -1 if the node has no mesh
+         */
+        Int32 mesh_idx{-1};
+
+        engine::Transform transform{};
+
+        Uint32 has_light{0};
+
+        engine::renderer::LightType light_type{engine::renderer::LightType::Directional};
+
+        glm::vec3 light_color{0};
+
+        Float32 light_size{0};
+    };
+
+    template <typename ElementType>
+    struct SceneArray {
+        const ElementType* data{nullptr};
+
+        Size size{0};
+
+        [[nodiscard]] const ElementType& operator[](const Size idx) const { return data[idx]; }
+    };
+
+    /*!
+     * \brief Read-only view of a scene, either in a SceneData or in a mapped cache file
+     */
+    struct SceneDataView {
+        SceneArray<engine::renderer::StandardVertex> vertices;
+
+        SceneArray<engine::renderer::PackedVertex> packed_vertices;
+
+        SceneArray<Uint32> indices;
+
+        SceneArray<engine::renderer::Meshlet> meshlets;
+
+        SceneArray<engine::renderer::MeshletBounds> meshlet_bounds;
+
+        SceneArray<Uint32> meshlet_vertices;
+
+        SceneArray<Uint8> meshlet_triangles;
+
+        SceneArray<ScenePrimitive> primitives;
+
+        SceneArray<SceneMesh> meshes;
+
+        SceneArray<SceneTexture> textures;
+
+        SceneArray<Uint8> texture_data;
+
+        SceneArray<SceneMaterial> materials;
+
+        SceneArray<SceneNode> nodes;
+
+        /*!
+         * \brief Null-terminated names of the scene's textures and nodes, one after another
+         */
+        SceneArray<char> strings;
+
+        [[nodiscard]] const char* get_string(Uint32 offset) const;
+    };
+
+    /*!
+     * \brief A scene which is being built from a glTF file
+     */
+    struct SceneData {
+        Rx::Vector<engine::renderer::StandardVertex> vertices;
+
+        Rx::Vector<engine::renderer::PackedVertex> packed_vertices;
+
+        Rx::Vector<Uint32> indices;
+
+        Rx::Vector<engine::renderer::Meshlet> meshlets;
+
+        Rx::Vector<engine::renderer::MeshletBounds> meshlet_bounds;
+
+        Rx::Vector<Uint32> meshlet_vertices;
+
+        Rx::Vector<Uint8> meshlet_triangles;
+
+        Rx::Vector<ScenePrimitive> primitives;
+
+        Rx::Vector<SceneMesh> meshes;
+
+        Rx::Vector<SceneTexture> textures;
+
+        Rx::Vector<Uint8> texture_data;
+
+        Rx::Vector<SceneMaterial> materials;
+
+        Rx::Vector<SceneNode> nodes;
+
+        Rx::Vector<char> strings;
+
+        /*!
+         * \brief Copies a string into the scene's strings
+         *
+         * \return The string's offset
+         */
+        Uint32 add_string(const char* string);
+
+        [[nodiscard]] SceneDataView get_view() const;
+    };
+} // namespace sanity::editor::import
@@ -4,15 +4,21 @@
 
 #include "scene_importer.hpp"
 
+#include <chrono>
+#include <cstring>
 #include <ranges>
 
 #include "Tracy.hpp"
 #include "actor/actor.hpp"
 #include "asset_registry/asset_registry.hpp"
+#include "core/align.hpp"
 #include "core/components.hpp"
 #include "core/types.hpp"
 #include "entity/entity_operations.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "import/scene_cache.hpp"
+#include "loading/compressed_texture_cache.hpp"
+#include "loading/pixel_conversion.hpp"
 #include "renderer/hlsl/standard_material.hpp"
 #include "renderer/mesh_data_store.hpp"
 #include "renderer/renderer.cpp"
@@ -111,14 +117,158 @@ namespace sanity::editor::import {
         }
     } // namespace detail
 
-    SceneImporter::SceneImporter(engine::renderer::Renderer& renderer_in) : renderer{&renderer_in} {}
+    static Float64 milliseconds_since(const std::chrono::high_resolution_clock::time_point start) {
+        const auto duration = std::chrono::high_resolution_clock::now() - start;
+        return static_cast<Float64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000000.0;
+    }
+
+    SceneImporter::SceneImporter(engine::renderer::Renderer& renderer_in) : renderer{&renderer_in} {
+        importer.SetImageLoader(&SceneImporter::store_encoded_image, nullptr);
+    }
 
     Rx::Optional<entt::entity> SceneImporter::import_gltf_scene(const std::filesystem::path& scene_path,
                                                                 const SceneImportSettings& import_settings,
                                                                 entt::registry& registry) {
         ZoneScoped;
 
+        scene_directory = scene_path.parent_path();
+        last_import_timings = {};
+
+        const auto cache_path = get_scene_cache_path(scene_path);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Try the scene's cache first. Everything in it is ready to upload, so nothing has to be parsed or processed
+        SceneCache cache;
+        if(cache.open(cache_path) && cache.is_up_to_date(scene_path, import_settings)) {
+            last_import_timings.used_cache = true;
+            last_import_timings.load_ms = milliseconds_since(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            const auto scene_entity = instantiate_scene(cache.get_view(), import_settings, registry);
+            last_import_timings.instantiate_ms = milliseconds_since(start);
+
+            logger->info("Imported scene %s from its cache in %f ms (load %f ms, instantiate %f ms)",
+                         scene_path,
+                         last_import_timings.load_ms + last_import_timings.instantiate_ms,
+                         last_import_timings.load_ms,
+                         last_import_timings.instantiate_ms);
+
+            return scene_entity;
+        }
+
+        // The cache gets rewritten below, so it can't stay mapped
+        cache.close();
+
         tinygltf::Model scene;
+        if(!load_gltf_scene(scene_path, scene)) {
+            return Rx::nullopt;
+        }
+        last_import_timings.load_ms = milliseconds_since(start);
+
+        // How to import a scene?
+        // First, process all the meshes, textures, materials, and nodes into a form that can be cached and uploaded as-is;
+
+        start = std::chrono::high_resolution_clock::now();
+        texture_jobs.clear();
+        primitive_jobs.clear();
+        processed_textures.clear();
+
+        SceneData scene_data;
+        if(import_settings.import_materials) {
+            process_all_materials(scene, scene_data);
+        }
+
+        if(import_settings.import_meshes) {
+            add_all_primitive_jobs(scene, import_settings);
+        }
+
+        // Decode the textures and primitives in parallel, then gather the results in order
+        run_all_jobs(scene);
+
+        gather_texture_results(scene_data);
+
+        if(import_settings.import_meshes) {
+            gather_primitive_results(scene, scene_data);
+        }
+
+        // The scene data has its own copy of everything now
+        texture_jobs.clear();
+        primitive_jobs.clear();
+
+        if(import_settings.import_object_hierarchy) {
+            process_object_hierarchy(scene, import_settings.scaling_factor, scene_data);
+        }
+        last_import_timings.process_ms = milliseconds_since(start);
+
+        // Then, cache the processed scene so that the next import of the scene can skip all that;
+
+        start = std::chrono::high_resolution_clock::now();
+        if(!write_scene_cache(cache_path, scene_path, get_scene_dependencies(scene), import_settings, scene_data)) {
+            logger->warning("Could not cache scene %s. It will be processed again the next time it's imported", scene_path);
+        }
+        last_import_timings.write_cache_ms = milliseconds_since(start);
+
+        // Finally, create the scene's resources and entities, and return the root entity
+        start = std::chrono::high_resolution_clock::now();
+        const auto scene_entity = instantiate_scene(scene_data.get_view(), import_settings, registry);
+        last_import_timings.instantiate_ms = milliseconds_since(start);
+
+        logger->info("Imported scene %s in %f ms (load %f ms, process %f ms, write cache %f ms, instantiate %f ms)",
+                     scene_path,
+                     last_import_timings.load_ms + last_import_timings.process_ms + last_import_timings.write_cache_ms +
+                         last_import_timings.instantiate_ms,
+                     last_import_timings.load_ms,
+                     last_import_timings.process_ms,
+                     last_import_timings.write_cache_ms,
+                     last_import_timings.instantiate_ms);
+
+        return scene_entity;
+    }
+
+    const SceneImportTimings& SceneImporter::get_last_import_timings() const { return last_import_timings; }
+
+    Rx::Vector<DecodedPrimitive> SceneImporter::load_gltf_primitives(const std::filesystem::path& scene_path) {
+        ZoneScoped;
+
+        tinygltf::Model scene;
+        if(!load_gltf_scene(scene_path, scene)) {
+            return {};
+        }
+
+        Rx::Vector<DecodedPrimitive> primitives;
+        for(const auto& mesh : scene.meshes) {
+            for(const auto& primitive : mesh.primitives) {
+                auto decoded_primitive = DecodedPrimitive{.vertices = get_vertices_from_primitive(primitive, scene),
+                                                          .indices = get_indices_from_primitive(primitive, scene)};
+                if(decoded_primitive.vertices.is_empty() || decoded_primitive.indices.is_empty()) {
+                    continue;
+                }
+
+                engine::optimize_mesh(decoded_primitive.vertices, decoded_primitive.indices);
+                primitives.push_back(Rx::Utility::move(decoded_primitive));
+            }
+        }
+
+        return primitives;
+    }
+
+    bool SceneImporter::store_encoded_image(tinygltf::Image* image,
+                                            int /* image_idx */,
+                                            std::string* /* err */,
+                                            std::string* /* warn */,
+                                            int /* req_width */,
+                                            int /* req_height */,
+                                            const unsigned char* bytes,
+                                            const int size,
+                                            void* /* user_data */) {
+        image->image.assign(bytes, bytes + size);
+        return true;
+    }
+
+    bool SceneImporter::load_gltf_scene(const std::filesystem::path& scene_path, tinygltf::Model& scene) {
+        ZoneScoped;
+
         std::string err;
         std::string warn;
         bool success;
@@ -132,7 +282,7 @@ namespace sanity::editor::import {
 
         } else {
             gltf_logger->error("Invalid scene file %s", scene_path);
-            return Rx::nullopt;
+            return false;
         }
 
         if(!warn.empty()) {
@@ -143,46 +293,47 @@ namespace sanity::editor::import {
         }
         if(!success) {
             gltf_logger->error("Could not read scene %s", scene_path);
-            return Rx::nullopt;
+            return false;
         }
 
         gltf_logger->info("Loaded scene %s", scene_path);
 
-        // How to import a scene?
-        // First, load all the meshes, textures, materials, and other primitives;
+        return true;
+    }
 
-        // auto& backend = renderer->get_render_backend();
-        // backend.begin_frame_capture();
+    Rx::Vector<Rx::String> SceneImporter::get_scene_dependencies(const tinygltf::Model& scene) {
+        Rx::Vector<Rx::String> dependencies;
 
-        if(import_settings.import_meshes) {
-            meshes = import_all_meshes(scene);
-        }
+        // Buffers and images embedded in the GLTF file are covered by the hash of the file itself
+        const auto add_dependency = [&](const std::string& uri) {
+            if(!uri.empty() && uri.rfind("data:", 0) != 0) {
+                dependencies.push_back(Rx::String{uri.c_str()});
+            }
+        };
 
-        if(import_settings.import_materials) {
-            materials = import_all_materials(scene);
+        for(const auto& buffer : scene.buffers) {
+            add_dependency(buffer.uri);
         }
 
-        // Then, walk the node hierarchy, creating an hierarchy of entt::entities
-        Rx::Optional<entt::entity> scene_entity{Rx::nullopt};
-        if(import_settings.import_object_hierarchy) {
-            scene_entity = import_object_hierarchy(scene, import_settings.scaling_factor, registry);
+        for(const auto& image : scene.images) {
+            add_dependency(image.uri);
         }
 
-        // Finally, return the root entity
-        return scene_entity;
+        return dependencies;
     }
 
-    Rx::Vector<engine::renderer::StandardMaterialHandle> SceneImporter::import_all_materials(const tinygltf::Model& scene) {
+    void SceneImporter::process_all_materials(const tinygltf::Model& scene, SceneData& scene_data) {
         ZoneScoped;
 
-        Rx::Vector<engine::renderer::StandardMaterialHandle> imported_materials;
+        scene_data.materials.reserve(scene.materials.size());
 
         for(const auto& material : scene.materials) {
             ZoneScopedN(material.name.c_str());
 
             gltf_logger->info("Importing material %s", material.name);
 
-            engine::renderer::StandardMaterial sanity_material{};
+            SceneMaterial scene_material{};
+            auto& sanity_material = scene_material.material;
 
             // Extract the texture indices
 
@@ -211,189 +362,471 @@ namespace sanity::editor::import {
 
             const auto normal_texture_idx{material.normalTexture.index};
 
-            if(base_color_texture_idx != -1) {
-                if(const auto handle = import_texture(base_color_texture_idx, scene); handle.has_value()) {
-                    sanity_material.base_color_texture_idx = handle->index;
+            // Masked materials are alpha tested, so the mips of their base color have to keep the same alpha coverage
+            Rx::Optional<Float32> alpha_cutoff;
+            if(material.alphaMode == "MASK") {
+                alpha_cutoff = static_cast<Float32>(material.alphaCutoff);
+            }
 
-                } else {
-                    gltf_logger->error("Could not import base color texture %d (from material %s) into SanityEngine",
-                                       base_color_texture_idx,
-                                       material.name);
-                    sanity_material.base_color_texture_idx = renderer->get_pink_texture().index;
-                }
+            if(base_color_texture_idx != -1) {
+                scene_material.base_color_texture = add_texture_job(base_color_texture_idx,
+                                                                    scene,
+                                                                    engine::TextureCompressionUsage::BaseColor,
+                                                                    alpha_cutoff);
             }
 
             if(metalness_roughness_texture_idx != -1) {
-                if(const auto handle = import_texture(metalness_roughness_texture_idx, scene); handle.has_value()) {
-                    sanity_material.metallic_roughness_texture_idx = handle->index;
-
-                } else {
-                    gltf_logger->error("Could not import metallic/roughness texture %d (from material %s) into SanityEngine",
-                                       metalness_roughness_texture_idx,
-                                       material.name);
-                    sanity_material.metallic_roughness_texture_idx = renderer->get_pink_texture().index;
-                }
+                scene_material.metallic_roughness_texture = add_texture_job(metalness_roughness_texture_idx,
+                                                                            scene,
+                                                                            engine::TextureCompressionUsage::MetallicRoughness);
             }
 
             if(normal_texture_idx != -1) {
-                if(const auto handle = import_texture(normal_texture_idx, scene); handle.has_value()) {
-                    sanity_material.normal_texture_idx = handle->index;
-
-                } else {
-                    gltf_logger->error("Could not import normalmap texture %d (from material %s) into SanityEngine",
-                                       normal_texture_idx,
-                                       material.name);
-                    sanity_material.normal_texture_idx = renderer->get_pink_texture().index;
-                }
+                scene_material.normal_texture = add_texture_job(normal_texture_idx, scene, engine::TextureCompressionUsage::NormalMap);
             }
 
             if(emission_texture_idx != -1) {
-                if(const auto handle = import_texture(emission_texture_idx, scene); handle.has_value()) {
-                    sanity_material.emission_texture_idx = handle->index;
-
-                } else {
-                    gltf_logger->error("Could not import emission texture %d (from material %s) into SanityEngine",
-                                       emission_texture_idx,
-                                       material.name);
-                    sanity_material.emission_texture_idx = renderer->get_pink_texture().index;
-                }
+                scene_material.emission_texture = add_texture_job(emission_texture_idx, scene, engine::TextureCompressionUsage::Emission);
             }
 
-            // Allocate material on GPU
+            scene_data.materials.push_back(scene_material);
+        }
+    }
 
-            const auto handle = renderer->allocate_standard_material(sanity_material);
-            imported_materials.push_back(handle);
+    Int32 SceneImporter::add_texture_job(const Int32 texture_idx,
+                                         const tinygltf::Model& scene,
+                                         const engine::TextureCompressionUsage usage,
+                                         const Rx::Optional<Float32>& alpha_cutoff) {
+        if(texture_idx < 0 || static_cast<Size>(texture_idx) >= scene.textures.size()) {
+            gltf_logger->error("Texture index %d is out of range", texture_idx);
+            return MISSING_TEXTURE;
         }
 
-        return imported_materials;
+        // Textures which use the same image the same way produce the same texture, and would write the same compressed texture cache
+        // file, so they share a job. glTF textures often have no name, so the image is what identifies them
+        const auto job_key = Rx::String::format("%d %s %f",
+                                                scene.textures[texture_idx].source,
+                                                engine::to_string(usage),
+                                                alpha_cutoff.value_or(-1.0f));
+        if(const auto* job_idx = processed_textures.find(job_key); job_idx != nullptr) {
+            return *job_idx;
+        }
+
+        const auto job_idx = static_cast<Int32>(texture_jobs.size());
+        texture_jobs.push_back(TextureJob{.texture_idx = texture_idx, .usage = usage, .alpha_cutoff = alpha_cutoff});
+        processed_textures.insert(job_key, job_idx);
+
+        return job_idx;
     }
 
-    Rx::Optional<engine::renderer::TextureHandle> SceneImporter::import_texture(const Int32 texture_idx, const tinygltf::Model& scene) {
-        static Byte* padding_buffer{nullptr};
+    void SceneImporter::add_all_primitive_jobs(const tinygltf::Model& scene, const SceneImportSettings& import_settings) {
+        for(Uint32 mesh_idx = 0; mesh_idx < scene.meshes.size(); mesh_idx++) {
+            const auto& mesh = scene.meshes[mesh_idx];
+
+            gltf_logger->info("Importing mesh %s", mesh.name);
 
+            for(Uint32 primitive_idx = 0; primitive_idx < mesh.primitives.size(); primitive_idx++) {
+                primitive_jobs.push_back(PrimitiveJob{.mesh_idx = mesh_idx,
+                                                      .primitive_idx = primitive_idx,
+                                                      .quantize_vertices = import_settings.quantize_vertices,
+                                                      .num_lods = glm::min(import_settings.num_lods, engine::renderer::MAX_MESH_LODS),
+                                                      .lod_error = import_settings.lod_error,
+                                                      .generate_meshlets = import_settings.generate_meshlets});
+            }
+        }
+    }
+
+    void SceneImporter::run_all_jobs(const tinygltf::Model& scene) {
         ZoneScoped;
 
-        if(texture_idx < 0) {
-            return Rx::nullopt;
+        const auto num_texture_jobs = static_cast<Uint32>(texture_jobs.size());
+        const auto num_jobs = num_texture_jobs + static_cast<Uint32>(primitive_jobs.size());
+        if(num_jobs == 0) {
+            return;
         }
 
-        const auto& texture = scene.textures[texture_idx];
-        const auto& texture_name = Rx::String{texture.name.c_str()};
+        // Texture jobs spread their mips and blocks over the thread pool too. parallel_for lets the thread that calls it work on its own
+        // batches, so a texture job waiting for its rows never waits on the other jobs
+        auto& thread_pool = g_engine->get_thread_pool();
+        thread_pool.parallel_for(num_jobs, 1, [&](const Uint32 first_job, const Uint32 last_job) {
+            for(Uint32 job_idx = first_job; job_idx < last_job; job_idx++) {
+                if(job_idx < num_texture_jobs) {
+                    run_texture_job(texture_jobs[job_idx], scene);
 
-        if(!texture_name.is_empty()) {
-            if(const auto* texture_ptr = loaded_textures.find(texture_name); texture_ptr != nullptr) {
-                return *texture_ptr;
+                } else {
+                    run_primitive_job(primitive_jobs[job_idx - num_texture_jobs], scene);
+                }
             }
-        }
+        });
+    }
 
-        if(texture.source < 0) {
-            gltf_logger->error("Texture %s has an invalid source", texture.name);
-            return Rx::nullopt;
+    void SceneImporter::run_texture_job(TextureJob& job, const tinygltf::Model& scene) const {
+        ZoneScoped;
+
+        const auto& texture = scene.textures[job.texture_idx];
+        job.name = texture.name.empty() ? Rx::String::format("Imported GLTF texture %d", job.texture_idx)
+                                        : Rx::String{texture.name.c_str()};
+
+        if(texture.source < 0 || static_cast<Size>(texture.source) >= scene.images.size()) {
+            gltf_logger->error("Texture %s has an invalid source", job.name);
+            return;
         }
 
-        // We only support three- or four-channel textures, with eight bits per chanel
         const auto& source_image = scene.images[texture.source];
-        if(source_image.component != 3 && source_image.component != 4) {
-            gltf_logger->error("Source image %s does not have either three or four components", source_image.name);
-            return Rx::nullopt;
+        if(source_image.image.empty()) {
+            gltf_logger->error("Source image %s of texture %s has no data", source_image.name, job.name);
+            return;
         }
-        if(source_image.bits != 8) {
-            gltf_logger->error("Source image does not have eight bits per component. Unable to load");
-            return Rx::nullopt;
+
+        const auto mip_options = engine::get_mip_generation_options(job.usage, job.alpha_cutoff);
+
+        // Images embedded in the GLTF file don't have a file to put a cache file next to, so they get compressed on every import. Images
+        // with a cache file don't even need to be decoded
+        Rx::Optional<engine::CompressedTexture> compressed_texture;
+        const auto has_image_file = !source_image.uri.empty() && source_image.uri.rfind("data:", 0) != 0;
+        if(has_image_file) {
+            compressed_texture = engine::read_compressed_texture_cache(scene_directory / source_image.uri, job.usage, mip_options);
         }
 
-        const void* image_data = &source_image.image.at(0);
-        if(source_image.component == 3) {
-            // We have to pad out the data because GPUs don't like multiples of 3
-            padding_buffer = RX_SYSTEM_ALLOCATOR.reallocate(padding_buffer,
-                                                            static_cast<std::size_t>(source_image.width) * source_image.height * 4);
+        if(!compressed_texture) {
+            int width;
+            int height;
+            int num_channels;
+            auto* decoded_pixels = stbi_load_from_memory(source_image.image.data(),
+                                                         static_cast<int>(source_image.image.size()),
+                                                         &width,
+                                                         &height,
+                                                         &num_channels,
+                                                         0);
+            if(decoded_pixels == nullptr) {
+                gltf_logger->error("Could not decode source image %s of texture %s: %s",
+                                   source_image.name,
+                                   job.name,
+                                   stbi_failure_reason());
+                return;
+            }
 
-            std::size_t read_idx{0};
-            Size write_idx{0};
+            const Uint8* pixels = decoded_pixels;
 
-            for(Uint32 pixel_idx = 0; pixel_idx < static_cast<Uint32>(source_image.width * source_image.height); pixel_idx++) {
-                padding_buffer[write_idx] = source_image.image[read_idx];
-                padding_buffer[write_idx + 1] = source_image.image[read_idx + 1];
-                padding_buffer[write_idx + 2] = source_image.image[read_idx + 2];
-                padding_buffer[write_idx + 3] = 0xFF;
+            Rx::Vector<Uint8> padded_pixels;
+            if(num_channels != 4) {
+                // We have to pad out the data because GPUs don't like multiples of 3, and the mip generator and compressor want RGBA
+                const auto num_pixels = static_cast<Size>(width) * height;
+                padded_pixels.resize(num_pixels * 4);
+                engine::expand_to_rgba8(decoded_pixels, static_cast<Uint32>(num_channels), num_pixels, padded_pixels.data());
 
-                read_idx++;
-                write_idx++;
+                pixels = padded_pixels.data();
             }
 
-            image_data = padding_buffer;
+            job.texture.width = static_cast<Uint32>(width);
+            job.texture.height = static_cast<Uint32>(height);
+
+            compressed_texture = compress_image(source_image, pixels, job.texture.width, job.texture.height, job.usage, mip_options);
+            if(!compressed_texture) {
+                auto* thread_pool = &g_engine->get_thread_pool();
+                job.data = engine::generate_mip_chain(pixels, job.texture.width, job.texture.height, mip_options, thread_pool);
+                job.texture.num_mips = engine::renderer::get_num_mips(job.texture.width, job.texture.height);
+            }
+
+            stbi_image_free(decoded_pixels);
         }
 
-        const auto image_name = texture_name.is_empty() ? Rx::String::format("Imported GLTF texture %d", texture_idx) : texture_name;
+        if(compressed_texture) {
+            job.texture.format = compressed_texture->format;
+            job.texture.width = compressed_texture->width;
+            job.texture.height = compressed_texture->height;
+            job.texture.num_mips = compressed_texture->num_mips;
+            job.data = Rx::Utility::move(compressed_texture->blocks);
+        }
 
-        const auto create_info = engine::renderer::TextureCreateInfo{.name = image_name,
-                                                                     .usage = engine::renderer::TextureUsage::SampledTexture,
-                                                                     .format = engine::renderer::TextureFormat::Rgba8,
-                                                                     .width = static_cast<Uint32>(source_image.width),
-                                                                     .height = static_cast<Uint32>(source_image.height)};
+        job.succeeded = true;
+    }
 
-        const auto handle = renderer->create_texture(create_info, image_data);
-        loaded_textures.insert(texture_name, handle);
+    Rx::Optional<engine::CompressedTexture> SceneImporter::compress_image(const tinygltf::Image& image,
+                                                                          const Uint8* pixels,
+                                                                          const Uint32 width,
+                                                                          const Uint32 height,
+                                                                          const engine::TextureCompressionUsage usage,
+                                                                          const engine::MipGenerationOptions& mip_options) const {
+        ZoneScoped;
 
-        return handle;
+        if(!engine::can_block_compress(width, height)) {
+            return Rx::nullopt;
+        }
+
+        auto* thread_pool = &g_engine->get_thread_pool();
+        const auto format = engine::get_compressed_format(usage, engine::has_alpha(pixels, width, height));
+        const auto num_mips = engine::renderer::get_num_mips(width, height);
+
+        const auto mip_chain = engine::generate_mip_chain(pixels, width, height, mip_options, thread_pool);
+        auto blocks = engine::compress_mip_chain(mip_chain.data(), width, height, num_mips, format, thread_pool);
+        auto texture = engine::CompressedTexture{.format = format,
+                                                 .width = width,
+                                                 .height = height,
+                                                 .num_mips = num_mips,
+                                                 .blocks = Rx::Utility::move(blocks)};
+
+        if(!image.uri.empty() && image.uri.rfind("data:", 0) != 0) {
+            engine::write_compressed_texture_cache(scene_directory / image.uri, usage, mip_options, texture);
+        }
+
+        return texture;
     }
 
-    Rx::Vector<SceneImporter::GltfMesh> SceneImporter::import_all_meshes(const tinygltf::Model& scene) const {
+    void SceneImporter::run_primitive_job(PrimitiveJob& job, const tinygltf::Model& scene) {
         ZoneScoped;
 
-        auto cmds = renderer->get_render_backend().create_copy_command_list();
+        const auto& primitive = scene.meshes[job.mesh_idx].primitives[job.primitive_idx];
 
-        auto& mesh_store = renderer->get_static_mesh_store();
-        const auto uploader = mesh_store.begin_adding_meshes(*cmds);
+        job.indices = get_indices_from_primitive(primitive, scene);
+        job.vertices = get_vertices_from_primitive(primitive, scene);
 
-        Rx::Vector<GltfMesh> imported_meshes;
-        imported_meshes.reserve(scene.meshes.size());
+        if(job.indices.is_empty() || job.vertices.is_empty()) {
+            gltf_logger->error("Could not read primitive data");
+            return;
+        }
 
-        for(const auto& mesh : scene.meshes) {
-            ZoneScopedN(mesh.name.c_str());
+        job.unoptimized_statistics = engine::analyze_vertex_cache(job.indices, static_cast<Uint32>(job.vertices.size()));
+        if(engine::optimize_mesh(job.vertices, job.indices)) {
+            job.optimized_statistics = engine::analyze_vertex_cache(job.indices, static_cast<Uint32>(job.vertices.size()));
 
-            gltf_logger->info("Importing mesh %s", mesh.name);
+        } else {
+            gltf_logger->warning("Primitive %d of mesh %d isn't a valid triangle list, so it can't be optimized",
+                                 job.primitive_idx,
+                                 job.mesh_idx);
+            job.optimized_statistics = job.unoptimized_statistics;
+        }
 
-            GltfMesh imported_mesh{};
-            imported_mesh.primitives.reserve(mesh.primitives.size());
+        job.bounds = engine::renderer::compute_mesh_bounds(job.vertices.data(), static_cast<Uint32>(job.vertices.size()));
 
-            for(Uint32 primitive_idx = 0; primitive_idx < mesh.primitives.size(); primitive_idx++) {
-                gltf_logger->verbose("Importing primitive %d", primitive_idx);
+        // LODs use the optimized vertices, and they're reordered for the vertex cache on their own. Packing doesn't move vertices, so
+        // the LODs can be generated first
+        if(job.num_lods > 0) {
+            const auto simplification_start = std::chrono::high_resolution_clock::now();
+            job.lods = engine::generate_lods(job.vertices, job.indices, job.num_lods, job.lod_error);
+            job.simplification_ms = std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                               simplification_start)
+                                        .count();
+        }
+
+        if(job.generate_meshlets) {
+            const auto meshlet_start = std::chrono::high_resolution_clock::now();
+            job.meshlets = engine::build_meshlets(job.vertices, job.indices);
+            job.meshlet_ms = std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() - meshlet_start).count();
+        }
 
-                const auto& primitive = mesh.primitives[primitive_idx];
+        if(job.quantize_vertices) {
+            job.packed_vertices = engine::quantize_vertices(job.vertices, job.dequantization);
+            job.quantization_error = engine::measure_quantization_error(job.vertices, job.packed_vertices, job.dequantization);
+        }
 
-                const auto& primitive_mesh = get_data_from_primitive(primitive, scene, uploader);
-                if(!primitive_mesh) {
-                    gltf_logger->error("Could not read data for primitive %d in mesh %s", primitive_idx, mesh.name);
-                    continue;
-                }
+        job.succeeded = true;
+    }
 
-                imported_mesh.primitives.push_back(*primitive_mesh);
+    void SceneImporter::gather_texture_results(SceneData& scene_data) {
+        ZoneScoped;
+
+        Rx::Vector<Int32> scene_texture_indices;
+        scene_texture_indices.reserve(texture_jobs.size());
+
+        for(Size job_idx = 0; job_idx < texture_jobs.size(); job_idx++) {
+            const auto& job = texture_jobs[job_idx];
+
+            auto texture = job.texture;
+            texture.data_size = engine::renderer::get_mip_chain_size_in_bytes(texture.format,
+                                                                              texture.width,
+                                                                              texture.height,
+                                                                              texture.num_mips);
+            if(!job.succeeded || job.data.size() != texture.data_size) {
+                gltf_logger->error("Could not import texture %d into SanityEngine", job.texture_idx);
+                scene_texture_indices.push_back(MISSING_TEXTURE);
+                continue;
             }
 
-            imported_meshes.push_back(imported_mesh);
+            texture.name_offset = scene_data.add_string(job.name.data());
+            texture.data_offset = ALIGN(16, scene_data.texture_data.size());
+            scene_data.texture_data.resize(texture.data_offset + texture.data_size);
+            memcpy(scene_data.texture_data.data() + texture.data_offset, job.data.data(), texture.data_size);
+
+            scene_texture_indices.push_back(static_cast<Int32>(scene_data.textures.size()));
+            scene_data.textures.push_back(texture);
         }
 
-        return imported_meshes;
+        // Point the materials at the textures instead of at the jobs
+        const auto get_scene_texture = [&](const Int32 job_idx) { return job_idx >= 0 ? scene_texture_indices[job_idx] : job_idx; };
+        for(Size i = 0; i < scene_data.materials.size(); i++) {
+            auto& material = scene_data.materials[i];
+            material.base_color_texture = get_scene_texture(material.base_color_texture);
+            material.metallic_roughness_texture = get_scene_texture(material.metallic_roughness_texture);
+            material.normal_texture = get_scene_texture(material.normal_texture);
+            material.emission_texture = get_scene_texture(material.emission_texture);
+        }
     }
 
-    Rx::Optional<SceneImporter::GltfPrimitive> SceneImporter::get_data_from_primitive(const tinygltf::Primitive& primitive,
-                                                                                      const tinygltf::Model& scene,
-                                                                                      const engine::renderer::MeshUploader& uploader) {
+    void SceneImporter::gather_primitive_results(const tinygltf::Model& scene, SceneData& scene_data) {
         ZoneScoped;
 
-        const auto indices = get_indices_from_primitive(primitive, scene);
-        const auto vertices = get_vertices_from_primitive(primitive, scene);
+        scene_data.meshes.reserve(scene.meshes.size());
 
-        if(indices.is_empty() || vertices.is_empty()) {
-            gltf_logger->error("Could not read primitive data");
-            return Rx::nullopt;
+        engine::VertexCacheStatistics unoptimized_statistics;
+        engine::VertexCacheStatistics optimized_statistics;
+        engine::VertexQuantizationError quantization_error;
+
+        Uint32 num_lods{0};
+        Uint32 num_simplified_primitives{0};
+        Uint32 num_simplified_triangles{0};
+        Uint32 num_least_detailed_lod_triangles{0};
+        Float64 simplification_ms{0};
+
+        Uint32 num_meshlet_triangles{0};
+        Uint32 num_meshlets_with_cones{0};
+        Float64 meshlet_ms{0};
+
+        Size job_idx{0};
+        for(const auto& mesh : scene.meshes) {
+            auto scene_mesh = SceneMesh{.first_primitive = static_cast<Uint32>(scene_data.primitives.size())};
+
+            for(Uint32 primitive_idx = 0; primitive_idx < mesh.primitives.size(); primitive_idx++, job_idx++) {
+                const auto& job = primitive_jobs[job_idx];
+                if(!job.succeeded) {
+                    gltf_logger->error("Could not read data for primitive %d in mesh %s", primitive_idx, mesh.name);
+                    continue;
+                }
+
+                const auto is_packed = job.quantize_vertices;
+                const auto first_vertex = is_packed ? scene_data.packed_vertices.size() : scene_data.vertices.size();
+                auto scene_primitive = ScenePrimitive{.first_vertex = static_cast<Uint32>(first_vertex),
+                                                      .num_vertices = static_cast<Uint32>(job.vertices.size()),
+                                                      .first_index = static_cast<Uint32>(scene_data.indices.size()),
+                                                      .num_indices = static_cast<Uint32>(job.indices.size()),
+                                                      .bounds = job.bounds,
+                                                      .material_idx = mesh.primitives[primitive_idx].material,
+                                                      .is_packed = is_packed ? 1u : 0u,
+                                                      .dequantization = job.dequantization,
+                                                      .num_lods = static_cast<Uint32>(job.lods.size()),
+                                                      .first_meshlet = static_cast<Uint32>(scene_data.meshlets.size()),
+                                                      .num_meshlets = static_cast<Uint32>(job.meshlets.meshlets.size())};
+
+                // The LODs' indices go right after the primitive's own
+                for(Uint32 lod_idx = 0; lod_idx < scene_primitive.num_lods; lod_idx++) {
+                    const auto& lod = job.lods[lod_idx];
+                    scene_primitive.lods[lod_idx] = engine::renderer::MeshLod{.index_offset = scene_primitive.num_indices,
+                                                                              .num_indices = static_cast<Uint32>(lod.indices.size()),
+                                                                              .error = lod.error};
+                    scene_primitive.num_indices += static_cast<Uint32>(lod.indices.size());
+                }
+
+                if(is_packed) {
+                    scene_data.packed_vertices.resize(scene_primitive.first_vertex + scene_primitive.num_vertices);
+                    memcpy(scene_data.packed_vertices.data() + scene_primitive.first_vertex,
+                           job.packed_vertices.data(),
+                           job.packed_vertices.size() * sizeof(engine::renderer::PackedVertex));
+
+                } else {
+                    scene_data.vertices.resize(scene_primitive.first_vertex + scene_primitive.num_vertices);
+                    memcpy(scene_data.vertices.data() + scene_primitive.first_vertex,
+                           job.vertices.data(),
+                           job.vertices.size() * sizeof(engine::renderer::StandardVertex));
+                }
+
+                scene_data.indices.resize(scene_primitive.first_index + scene_primitive.num_indices);
+                memcpy(scene_data.indices.data() + scene_primitive.first_index, job.indices.data(), job.indices.size() * sizeof(Uint32));
+                for(Uint32 lod_idx = 0; lod_idx < scene_primitive.num_lods; lod_idx++) {
+                    const auto& lod_indices = job.lods[lod_idx].indices;
+                    memcpy(scene_data.indices.data() + scene_primitive.first_index + scene_primitive.lods[lod_idx].index_offset,
+                           lod_indices.data(),
+                           lod_indices.size() * sizeof(Uint32));
+                }
+
+                // The meshlets' offsets move from the job's meshlet data to the scene's
+                const auto first_meshlet_vertex = static_cast<Uint32>(scene_data.meshlet_vertices.size());
+                const auto first_meshlet_triangle = static_cast<Uint32>(scene_data.meshlet_triangles.size() / 3);
+                for(Uint32 meshlet_idx = 0; meshlet_idx < scene_primitive.num_meshlets; meshlet_idx++) {
+                    auto meshlet = job.meshlets.meshlets[meshlet_idx];
+                    meshlet.vertex_offset += first_meshlet_vertex;
+                    meshlet.triangle_offset += first_meshlet_triangle;
+                    scene_data.meshlets.push_back(meshlet);
+
+                    const auto& bounds = job.meshlets.bounds[meshlet_idx];
+                    scene_data.meshlet_bounds.push_back(bounds);
+
+                    num_meshlet_triangles += meshlet.num_triangles;
+                    if(bounds.cone_cutoff < 1.0f) {
+                        num_meshlets_with_cones++;
+                    }
+                }
+
+                scene_data.meshlet_vertices.resize(first_meshlet_vertex + job.meshlets.vertices.size());
+                memcpy(scene_data.meshlet_vertices.data() + first_meshlet_vertex,
+                       job.meshlets.vertices.data(),
+                       job.meshlets.vertices.size() * sizeof(Uint32));
+
+                scene_data.meshlet_triangles.resize(first_meshlet_triangle * 3 + job.meshlets.triangles.size());
+                memcpy(scene_data.meshlet_triangles.data() + first_meshlet_triangle * 3,
+                       job.meshlets.triangles.data(),
+                       job.meshlets.triangles.size());
+
+                meshlet_ms += job.meshlet_ms;
+
+                scene_data.primitives.push_back(scene_primitive);
+                scene_mesh.num_primitives++;
+
+                unoptimized_statistics += job.unoptimized_statistics;
+                optimized_statistics += job.optimized_statistics;
+                quantization_error += job.quantization_error;
+
+                if(!job.lods.is_empty()) {
+                    num_lods += static_cast<Uint32>(job.lods.size());
+                    num_simplified_primitives++;
+                    num_simplified_triangles += static_cast<Uint32>(job.indices.size() / 3);
+                    num_least_detailed_lod_triangles += static_cast<Uint32>(job.lods.last().indices.size() / 3);
+                }
+                simplification_ms += job.simplification_ms;
+            }
+
+            scene_data.meshes.push_back(scene_mesh);
         }
 
-        const auto fixed_indices = detail::flip_triangle_winding_order(indices);
+        logger->info("Optimized %u triangles for the vertex cache: ACMR %f -> %f, ATVR %f -> %f",
+                     optimized_statistics.num_triangles,
+                     unoptimized_statistics.get_acmr(),
+                     optimized_statistics.get_acmr(),
+                     unoptimized_statistics.get_atvr(),
+                     optimized_statistics.get_atvr());
+
+        if(simplification_ms > 0) {
+            logger->info("Generated %u LODs for %u primitives in %f ms of worker time. Their least detailed LODs have %u triangles "
+                         "instead of %u",
+                         num_lods,
+                         num_simplified_primitives,
+                         simplification_ms,
+                         num_least_detailed_lod_triangles,
+                         num_simplified_triangles);
+        }
+
+        if(!scene_data.meshlets.is_empty()) {
+            const auto num_meshlets = static_cast<Uint32>(scene_data.meshlets.size());
+            logger->info("Built %u meshlets in %f ms of worker time, with %f vertices and %f triangles each on average. %u of them have a "
+                         "normal cone that can cull them",
+                         num_meshlets,
+                         meshlet_ms,
+                         static_cast<Float64>(scene_data.meshlet_vertices.size()) / num_meshlets,
+                         static_cast<Float64>(num_meshlet_triangles) / num_meshlets,
+                         num_meshlets_with_cones);
+        }
 
-        const auto mesh = uploader.add_mesh(vertices, indices);
-        return GltfPrimitive{.mesh = mesh, .material_idx = primitive.material};
+        if(quantization_error.num_vertices > 0) {
+            logger->info("Packed %u vertices into %u bytes instead of %u. Location error max %f mean %f, normal error max %f mean %f "
+                         "degrees, texcoord error max %f",
+                         quantization_error.num_vertices,
+                         quantization_error.num_vertices * sizeof(engine::renderer::PackedVertex),
+                         quantization_error.num_vertices * sizeof(engine::renderer::StandardVertex),
+                         quantization_error.max_location_error,
+                         quantization_error.get_mean_location_error(),
+                         quantization_error.max_normal_error,
+                         quantization_error.get_mean_normal_error(),
+                         quantization_error.max_texcoord_error);
+        }
     }
 
     Rx::Vector<Uint32> SceneImporter::get_indices_from_primitive(const tinygltf::Primitive& primitive, const tinygltf::Model& scene) {
@@ -504,92 +937,54 @@ namespace sanity::editor::import {
         return vertices;
     }
 
-    entt::entity SceneImporter::import_object_hierarchy(const tinygltf::Model& model, const float import_scale, entt::registry& registry) {
+    void SceneImporter::process_object_hierarchy(const tinygltf::Model& model, const float import_scale, SceneData& scene_data) {
         ZoneScoped;
 
         // Assume that the files we'll be importing have a single scene
         const auto& default_scene = model.scenes[model.defaultScene];
 
-        // Create an entity for the scene and reference one of its components
-        const auto& scene_entity = engine::create_actor(registry, "Imported scene");
-
-        // Add entities for all the nodes in the scene, and all their children
+        // Add nodes for all the nodes in the scene, and all their children
         for(const auto node_idx : default_scene.nodes) {
             const auto& node = model.nodes[node_idx];
-            create_entity_for_node(node, scene_entity.entity, import_scale, model, registry);
+            process_node(node, -1, import_scale, model, scene_data);
         }
-
-        return scene_entity.entity;
     }
 
-    void SceneImporter::import_node_mesh(const tinygltf::Node& node, entt::registry& registry, entt::entity node_entity) {
-        if(node.mesh > -1 && static_cast<Size>(node.mesh) < meshes.size()) {
-            const auto& mesh = meshes[node.mesh];
-            Uint32 i{0};
-
-            auto cmds = renderer->get_render_backend().create_copy_command_list();
-
-            auto mesh_adder = renderer->get_static_mesh_store().begin_adding_meshes(*cmds);
-            mesh_adder.prepare_for_raytracing_geometry_build();
-
-            const auto& vertex_buffer = renderer->get_static_mesh_store().get_vertex_buffer();
-            const auto& index_buffer = renderer->get_static_mesh_store().get_index_buffer();
-
-            Rx::Vector<engine::renderer::RaytracingObject> raytracing_objects;
-
-            mesh.primitives.each_fwd([&](const GltfPrimitive& primitive) {
-                // Create entity and components
-                const auto primitive_node_name = Rx::String::format("%s primitive %d", node.name, i);
-                auto& primitive_actor = engine::create_actor(registry, primitive_node_name);
-
-                auto& primitive_transform_component = primitive_actor.get_component<engine::TransformComponent>();
-                primitive_transform_component.parent = node_entity;
-
-                auto& parent_transform_component = registry.get<engine::TransformComponent>(node_entity);
-                parent_transform_component.children.push_back(primitive_actor.entity);
-
-                auto& renderable = primitive_actor.add_component<engine::renderer::StandardRenderableComponent>();
-                renderable.mesh = primitive.mesh;
-                renderable.material = materials[primitive.material_idx];
-
-                // Build raytracing acceleration structure. We make a separate BLAS for each primitive because they
-                // might have separate materials. However, this will create too many BLASs if primitives share
-                // materials. This will be addressed in a future revision
-
-                const auto model_matrix = primitive_transform_component.get_local_matrix();
-                const auto as_handle = renderer->create_raytracing_geometry(vertex_buffer,
-                                                                            index_buffer,
-                                                                            Rx::Array{
-                                                                                engine::renderer::PlacedMesh{.mesh = primitive.mesh,
-                                                                                                             .model_matrix = model_matrix}},
-                                                                            *cmds);
+    void SceneImporter::process_node(const tinygltf::Node& node,
+                                     const Int32 parent_idx,
+                                     const float import_scale,
+                                     const tinygltf::Model& model,
+                                     SceneData& scene_data) {
+        ZoneScoped;
 
-                auto& raytracing_object_component = primitive_actor.add_component<engine::renderer::RaytracingObjectComponent>();
-                raytracing_object_component.as_handle = as_handle;
+        auto scene_node = SceneNode{.name_offset = scene_data.add_string(node.name.empty() ? "New Node" : node.name.c_str()),
+                                    .parent_idx = parent_idx,
+                                    .transform = get_node_transform(node, import_scale)};
 
-                const auto ray_material = engine::renderer::RaytracingMaterial{.handle = renderable.material.index};
+        if(node.mesh > -1 && static_cast<Size>(node.mesh) < scene_data.meshes.size()) {
+            scene_node.mesh_idx = node.mesh;
+        }
 
-                const auto ray_object = engine::renderer::RaytracingObject{.as_handle = as_handle,
-                                                                           .material = ray_material,
-                                                                           .transform = parent_transform_component.get_model_matrix(
-                                                                               registry)};
+        // Light
+        process_node_light(node, model, scene_node);
 
-                raytracing_objects.push_back(ray_object);
+        const auto node_idx = static_cast<Int32>(scene_data.nodes.size());
+        scene_data.nodes.push_back(scene_node);
 
-                i++;
-            });
+        // Children
+        for(const auto child_node_idx : node.children) {
+            if(child_node_idx < 0 || static_cast<Size>(child_node_idx) >= model.nodes.size()) {
+                // Invalid node index
+                continue;
+            }
 
-            renderer->add_raytracing_objects_to_scene(raytracing_objects);
+            const auto& child_node = model.nodes.at(child_node_idx);
+            process_node(child_node, node_idx, import_scale, model, scene_data);
         }
     }
 
-    void SceneImporter::import_node_transform(const tinygltf::Node& node,
-                                              const entt::entity& parent_entity,
-                                              const float import_scale,
-                                              entt::registry& registry,
-                                              engine::Actor& node_actor) const {
-        auto& node_transform_component = node_actor.get_component<engine::TransformComponent>();
-        auto& node_transform = node_transform_component.transform;
+    engine::Transform SceneImporter::get_node_transform(const tinygltf::Node& node, const float import_scale) {
+        engine::Transform node_transform{};
 
         if(!node.matrix.empty()) {
             const auto transform_matrix = glm::make_mat4(node.matrix.data());
@@ -631,24 +1026,10 @@ namespace sanity::editor::import {
             }
         }
 
-        if(registry.valid(parent_entity)) {
-            node_transform_component.parent = parent_entity;
-
-            auto& parent_transform = registry.get<engine::TransformComponent>(parent_entity);
-            parent_transform.children.push_back(node_actor.entity);
-        }
-
-        logger->verbose("Created node %s with transform translation=%s rotation=%s scale=%s",
-                        node.name.empty() ? "New Entity" : node.name,
-                        node_transform.location,
-                        node_transform.rotation,
-                        node_transform.scale);
+        return node_transform;
     }
 
-    void SceneImporter::import_node_light(const tinygltf::Node& node,
-                                          const tinygltf::Model& model,
-                                          entt::registry& registry,
-                                          const entt::entity node_entity) const {
+    void SceneImporter::process_node_light(const tinygltf::Node& node, const tinygltf::Model& model, SceneNode& scene_node) {
         const auto light_extension_itr = node.extensions.find(PUNCTUAL_LIGHTS_EXTENSION_NAME);
         if(light_extension_itr == node.extensions.end()) {
             // No lights :(
@@ -676,53 +1057,292 @@ namespace sanity::editor::import {
 
         const auto gltf_light = model.lights.at(light_index);
 
-        auto& light_component = registry.emplace<engine::renderer::LightComponent>(node_entity);
-        light_component.handle = renderer->next_next_free_light_handle();
+        const auto default_light = engine::renderer::LightComponent{};
+        scene_node.has_light = 1;
+        scene_node.light_type = default_light.type;
+        scene_node.light_size = default_light.size;
 
         if(gltf_light.type == "directional") {
-            light_component.type = engine::renderer::LightType::Directional;
+            scene_node.light_type = engine::renderer::LightType::Directional;
 
         } else if(gltf_light.type == "point" || gltf_light.type == "spot") {
-            light_component.type = engine::renderer::LightType::Sphere;
-            light_component.size = 0.01f; // 1 cm radius because it feels fine
+            scene_node.light_type = engine::renderer::LightType::Sphere;
+            scene_node.light_size = 0.01f; // 1 cm radius because it feels fine
 
         } else {
             gltf_logger->error("Invalid light type %s", gltf_light.type);
         }
 
-        light_component.color = glm::vec3{gltf_light.color[0], gltf_light.color[1], gltf_light.color[2]} *
-                                static_cast<float>(gltf_light.intensity);
+        scene_node.light_color = glm::vec3{gltf_light.color[0], gltf_light.color[1], gltf_light.color[2]} *
+                                 static_cast<float>(gltf_light.intensity);
     }
 
-    entt::entity SceneImporter::create_entity_for_node(const tinygltf::Node& node,
-                                                       const entt::entity& parent_entity,
-                                                       const float import_scale,
-                                                       const tinygltf::Model& model,
-                                                       entt::registry& registry) {
+    Rx::Optional<entt::entity> SceneImporter::instantiate_scene(const SceneDataView& scene_data,
+                                                                const SceneImportSettings& import_settings,
+                                                                entt::registry& registry) {
         ZoneScoped;
 
-        auto& node_actor = engine::create_actor(registry, node.name.empty() ? "New Node" : node.name.c_str());
-        const auto node_entity = node_actor.entity;
+        // auto& backend = renderer->get_render_backend();
+        // backend.begin_frame_capture();
 
-        // Transform
-        import_node_transform(node, parent_entity, import_scale, registry, node_actor);
+        const auto textures = instantiate_all_textures(scene_data);
+        materials = instantiate_all_materials(scene_data, textures);
+        meshes = instantiate_all_meshes(scene_data);
 
-        import_node_mesh(node, registry, node_entity);
+        // Then, walk the node hierarchy, creating an hierarchy of entt::entities
+        Rx::Optional<entt::entity> scene_entity{Rx::nullopt};
+        if(import_settings.import_object_hierarchy) {
+            scene_entity = instantiate_object_hierarchy(scene_data, registry);
+        }
 
-        // Light
-        import_node_light(node, model, registry, node_entity);
+        return scene_entity;
+    }
 
-        // Children
-        for(const auto child_node_idx : node.children) {
-            if(child_node_idx < 0 || static_cast<Size>(child_node_idx) > model.nodes.size()) {
-                // Invalid node index
-                continue;
+    Rx::Vector<engine::renderer::TextureHandle> SceneImporter::instantiate_all_textures(const SceneDataView& scene_data) const {
+        ZoneScoped;
+
+        Rx::Vector<engine::renderer::TextureHandle> textures;
+        textures.reserve(scene_data.textures.size);
+
+        for(Size i = 0; i < scene_data.textures.size; i++) {
+            const auto& texture = scene_data.textures[i];
+
+            const auto create_info = engine::renderer::TextureCreateInfo{.name = scene_data.get_string(texture.name_offset),
+                                                                         .usage = engine::renderer::TextureUsage::SampledTexture,
+                                                                         .format = texture.format,
+                                                                         .width = texture.width,
+                                                                         .height = texture.height,
+                                                                         .num_mips = texture.num_mips};
+
+            textures.push_back(renderer->create_texture(create_info, scene_data.texture_data.data + texture.data_offset));
+        }
+
+        return textures;
+    }
+
+    Rx::Vector<engine::renderer::StandardMaterialHandle> SceneImporter::instantiate_all_materials(
+        const SceneDataView& scene_data, const Rx::Vector<engine::renderer::TextureHandle>& textures) const {
+        ZoneScoped;
+
+        const auto get_texture_idx = [&](const Int32 texture, auto& texture_idx) {
+            if(texture == MISSING_TEXTURE) {
+                texture_idx = renderer->get_pink_texture().index;
+
+            } else if(texture != NO_TEXTURE) {
+                texture_idx = textures[texture].index;
             }
+        };
 
-            const auto& child_node = model.nodes.at(child_node_idx);
-            create_entity_for_node(child_node, node_entity, import_scale, model, registry);
+        Rx::Vector<engine::renderer::StandardMaterialHandle> imported_materials;
+        imported_materials.reserve(scene_data.materials.size);
+
+        for(Size i = 0; i < scene_data.materials.size; i++) {
+            const auto& scene_material = scene_data.materials[i];
+
+            auto sanity_material = scene_material.material;
+            get_texture_idx(scene_material.base_color_texture, sanity_material.base_color_texture_idx);
+            get_texture_idx(scene_material.metallic_roughness_texture, sanity_material.metallic_roughness_texture_idx);
+            get_texture_idx(scene_material.normal_texture, sanity_material.normal_texture_idx);
+            get_texture_idx(scene_material.emission_texture, sanity_material.emission_texture_idx);
+
+            // Allocate material on GPU
+
+            const auto handle = renderer->allocate_standard_material(sanity_material);
+            imported_materials.push_back(handle);
+        }
+
+        return imported_materials;
+    }
+
+    Rx::Vector<SceneImporter::GltfMesh> SceneImporter::instantiate_all_meshes(const SceneDataView& scene_data) const {
+        ZoneScoped;
+
+        auto cmds = renderer->get_render_backend().create_copy_command_list();
+
+        const auto uploader = renderer->get_static_mesh_store().begin_adding_meshes(*cmds);
+        const auto packed_uploader = renderer->get_packed_mesh_store().begin_adding_meshes(*cmds);
+
+        Rx::Vector<GltfMesh> imported_meshes;
+        imported_meshes.reserve(scene_data.meshes.size);
+
+        for(Size mesh_idx = 0; mesh_idx < scene_data.meshes.size; mesh_idx++) {
+            const auto& scene_mesh = scene_data.meshes[mesh_idx];
+
+            GltfMesh imported_mesh{};
+            imported_mesh.primitives.reserve(scene_mesh.num_primitives);
+
+            for(Uint32 i = 0; i < scene_mesh.num_primitives; i++) {
+                const auto& primitive = scene_data.primitives[scene_mesh.first_primitive + i];
+
+                // Straight from the scene data to the staging buffer, without an intermediate vector. Packed vertices stay packed, and
+                // the packed mesh store's vertex shader unpacks them
+                const auto* indices = scene_data.indices.data + primitive.first_index;
+                const auto* meshlet_bounds = scene_data.meshlet_bounds.data + primitive.first_meshlet;
+
+                // Take the bounds from the mesh store rather than the scene, since they have to match the vertices that were uploaded,
+                // and packed vertices lose some precision
+                const auto mesh_object = primitive.is_packed ?
+                                             packed_uploader.add_mesh(scene_data.packed_vertices.data + primitive.first_vertex,
+                                                                      primitive.num_vertices,
+                                                                      primitive.dequantization,
+                                                                      indices,
+                                                                      primitive.num_indices,
+                                                                      primitive.lods,
+                                                                      primitive.num_lods,
+                                                                      meshlet_bounds,
+                                                                      primitive.num_meshlets) :
+                                             uploader.add_mesh(scene_data.vertices.data + primitive.first_vertex,
+                                                               primitive.num_vertices,
+                                                               indices,
+                                                               primitive.num_indices,
+                                                               primitive.lods,
+                                                               primitive.num_lods,
+                                                               meshlet_bounds,
+                                                               primitive.num_meshlets);
+
+                imported_mesh.primitives.push_back(
+                    GltfPrimitive{.mesh = mesh_object.mesh, .bounds = mesh_object.bounds, .material_idx = primitive.material_idx});
+            }
+
+            imported_meshes.push_back(imported_mesh);
         }
 
-        return node_entity;
+        return imported_meshes;
+    }
+
+    entt::entity SceneImporter::instantiate_object_hierarchy(const SceneDataView& scene_data, entt::registry& registry) {
+        ZoneScoped;
+
+        // Create an entity for the scene and reference one of its components
+        const auto& scene_entity = engine::create_actor(registry, "Imported scene");
+
+        // Nodes come before their children, so every node's parent already has an entity when the node gets to it
+        Rx::Vector<entt::entity> node_entities;
+        node_entities.reserve(scene_data.nodes.size);
+
+        for(Size i = 0; i < scene_data.nodes.size; i++) {
+            const auto& node = scene_data.nodes[i];
+            const auto* node_name = scene_data.get_string(node.name_offset);
+
+            auto& node_actor = engine::create_actor(registry, node_name);
+            const auto node_entity = node_actor.entity;
+            node_entities.push_back(node_entity);
+
+            // Transform
+            auto& node_transform_component = node_actor.get_component<engine::TransformComponent>();
+            node_transform_component.transform = node.transform;
+
+            const auto parent_entity = node.parent_idx >= 0 ? node_entities[node.parent_idx] : scene_entity.entity;
+            node_transform_component.parent = parent_entity;
+
+            auto& parent_transform = registry.get<engine::TransformComponent>(parent_entity);
+            parent_transform.children.push_back(node_entity);
+
+            logger->verbose("Created node %s with transform translation=%s rotation=%s scale=%s",
+                            node_name,
+                            node.transform.location,
+                            node.transform.rotation,
+                            node.transform.scale);
+
+            instantiate_node_mesh(node, node_name, registry, node_entity);
+
+            // Light
+            instantiate_node_light(node, registry, node_entity);
+        }
+
+        return scene_entity.entity;
+    }
+
+    void SceneImporter::instantiate_node_mesh(const SceneNode& node,
+                                              const char* node_name,
+                                              entt::registry& registry,
+                                              const entt::entity node_entity) {
+        if(node.mesh_idx > -1 && static_cast<Size>(node.mesh_idx) < meshes.size()) {
+            const auto& mesh = meshes[node.mesh_idx];
+            Uint32 i{0};
+
+            auto cmds = renderer->get_render_backend().create_copy_command_list();
+
+            auto mesh_adder = renderer->get_static_mesh_store().begin_adding_meshes(*cmds);
+            mesh_adder.prepare_for_raytracing_geometry_build();
+
+            const auto& vertex_buffer = renderer->get_static_mesh_store().get_vertex_buffer();
+            const auto& index_buffer = renderer->get_static_mesh_store().get_index_buffer();
+
+            Rx::Vector<engine::renderer::RaytracingObject> raytracing_objects;
+            Rx::Vector<entt::entity> raytracing_entities;
+
+            mesh.primitives.each_fwd([&](const GltfPrimitive& primitive) {
+                // Create entity and components
+                const auto primitive_node_name = Rx::String::format("%s primitive %d", node_name, i);
+                auto& primitive_actor = engine::create_actor(registry, primitive_node_name);
+
+                auto& primitive_transform_component = primitive_actor.get_component<engine::TransformComponent>();
+                primitive_transform_component.parent = node_entity;
+
+                auto& parent_transform_component = registry.get<engine::TransformComponent>(node_entity);
+                parent_transform_component.children.push_back(primitive_actor.entity);
+
+                auto& renderable = primitive_actor.add_component<engine::renderer::StandardRenderableComponent>();
+                renderable.mesh = primitive.mesh;
+                renderable.bounds = primitive.bounds;
+
+                // Scenes imported without their materials, or primitives without a material, keep the default material
+                if(primitive.material_idx > -1 && static_cast<Size>(primitive.material_idx) < materials.size()) {
+                    renderable.material = materials[primitive.material_idx];
+                }
+
+                // Acceleration structures are built from the static mesh store, which doesn't have packed meshes
+                if(primitive.mesh.is_packed) {
+                    i++;
+                    return;
+                }
+
+                // Build raytracing acceleration structure. We make a separate BLAS for each primitive because they
+                // might have separate materials. However, this will create too many BLASs if primitives share
+                // materials. This will be addressed in a future revision
+
+                const auto model_matrix = primitive_transform_component.get_local_matrix();
+                const auto as_handle = renderer->create_raytracing_geometry(vertex_buffer,
+                                                                            index_buffer,
+                                                                            Rx::Array{
+                                                                                engine::renderer::PlacedMesh{.mesh = primitive.mesh,
+                                                                                                             .model_matrix = model_matrix}},
+                                                                            *cmds);
+
+                auto& raytracing_object_component = primitive_actor.add_component<engine::renderer::RaytracingObjectComponent>();
+                raytracing_object_component.as_handle = as_handle;
+
+                const auto ray_material = engine::renderer::RaytracingMaterial{.handle = renderable.material.index};
+
+                const auto ray_object = engine::renderer::RaytracingObject{.as_handle = as_handle,
+                                                                           .material = ray_material,
+                                                                           .transform = parent_transform_component.get_model_matrix(
+                                                                               registry)};
+
+                raytracing_objects.push_back(ray_object);
+                raytracing_entities.push_back(primitive_actor.entity);
+
+                i++;
+            });
+
+            const auto raytracing_object_handles = renderer->add_raytracing_objects_to_scene(raytracing_objects);
+            for(Uint32 object_idx = 0; object_idx < raytracing_object_handles.size(); object_idx++) {
+                registry.get<engine::renderer::RaytracingObjectComponent>(raytracing_entities[object_idx]).object =
+                    raytracing_object_handles[object_idx];
+            }
+        }
+    }
+
+    void SceneImporter::instantiate_node_light(const SceneNode& node, entt::registry& registry, const entt::entity node_entity) const {
+        if(node.has_light == 0) {
+            return;
+        }
+
+        auto& light_component = registry.emplace<engine::renderer::LightComponent>(node_entity);
+        light_component.handle = renderer->next_next_free_light_handle();
+        light_component.type = node.light_type;
+        light_component.color = node.light_color;
+        light_component.size = node.light_size;
     }
 } // namespace sanity::editor::import
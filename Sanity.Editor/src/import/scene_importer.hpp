@@ -2,7 +2,13 @@
 
 #include "actor/actor.hpp"
 #include "entt/entity/fwd.hpp"
+#include "import/scene_data.hpp"
 #include "loading/asset_loader.hpp"
+#include "loading/mesh_optimization.hpp"
+#include "loading/mesh_simplification.hpp"
+#include "loading/meshlet_builder.hpp"
+#include "loading/texture_compression.hpp"
+#include "loading/vertex_quantization.hpp"
 #include "renderer/handles.hpp"
 #include "renderer/hlsl/mesh_data.hpp"
 #include "renderer/hlsl/standard_material.hpp"
@@ -22,18 +28,68 @@ namespace sanity {
         struct SceneImportSettings;
 
         namespace import {
+            /*!
+             * \brief How long each step of the last scene import took, in milliseconds
+             */
+            struct SceneImportTimings {
+                /*!
+                 * \brief Whether the scene came from its cache file. If so, nothing was parsed or processed
+                 */
+                bool used_cache{false};
+
+                /*!
+                 * \brief Time spent parsing the glTF file, or mapping and validating the cache file
+                 */
+                Float64 load_ms{0};
+
+                /*!
+                 * \brief Time spent converting the parsed scene into the importer's format, including compressing textures
+                 */
+                Float64 process_ms{0};
+
+                Float64 write_cache_ms{0};
+
+                /*!
+                 * \brief Time spent creating textures, materials, meshes, and entities from the scene
+                 */
+                Float64 instantiate_ms{0};
+            };
+
+            /*!
+             * \brief A primitive's triangles, reordered for the GPU like an import would, without any of the import's other processing
+             */
+            struct DecodedPrimitive {
+                Rx::Vector<engine::renderer::StandardVertex> vertices;
+
+                Rx::Vector<Uint32> indices;
+            };
+
             class SceneImporter {
             public:
                 explicit SceneImporter(engine::renderer::Renderer& renderer_in);
 
+                /*!
+                 * \brief Imports a glTF scene, from the scene's cache file if it's up to date
+                 *
+                 * If the cache is missing or out of date, the scene gets parsed and processed and the cache gets rewritten
+                 */
                 [[nodiscard]] Rx::Optional<entt::entity> import_gltf_scene(const std::filesystem::path& scene_path,
                                                                            const SceneImportSettings& import_settings,
                                                                            entt::registry& registry);
 
+                [[nodiscard]] const SceneImportTimings& get_last_import_timings() const;
+
+                /*!
+                 * \brief Decodes and optimizes the primitives of every mesh in a glTF scene, ignoring its cache, for the content benchmarks
+                 */
+                [[nodiscard]] Rx::Vector<DecodedPrimitive> load_gltf_primitives(const std::filesystem::path& scene_path);
+
             private:
                 struct GltfPrimitive {
                     engine::renderer::Mesh mesh{};
 
+                    engine::BoundingBox bounds{};
+
                     engine::renderer::RaytracingAsHandle ray_geo_handle{};
 
                     Int32 material_idx{-1};
@@ -43,27 +99,203 @@ namespace sanity {
                     Rx::Vector<GltfPrimitive> primitives;
                 };
 
+                /*!
+                 * \brief A texture which a material uses, to be decoded and processed on a worker thread
+                 */
+                struct TextureJob {
+                    Int32 texture_idx{-1};
+
+                    engine::TextureCompressionUsage usage{engine::TextureCompressionUsage::BaseColor};
+
+                    /*!
+                     * \brief Alpha test threshold of the material which uses the texture, if it has one
+                     */
+                    Rx::Optional<Float32> alpha_cutoff;
+
+                    // Results of the job. The texture's offsets in the scene data get filled in when the results are gathered
+
+                    bool succeeded{false};
+
+                    Rx::String name;
+
+                    SceneTexture texture{};
+
+                    Rx::Vector<Uint8> data;
+                };
+
+                /*!
+                 * \brief A primitive of a mesh, to be decoded on a worker thread
+                 */
+                struct PrimitiveJob {
+                    Uint32 mesh_idx{0};
+
+                    Uint32 primitive_idx{0};
+
+                    /*!
+                     * \brief Whether to pack the primitive's vertices
+                     */
+                    bool quantize_vertices{false};
+
+                    /*!
+                     * \brief How many LODs to generate for the primitive, at most, and how far the first one may be from the primitive's
+                     * surface, relative to its size
+                     */
+                    Uint32 num_lods{0};
+                    Float32 lod_error{0};
+
+                    bool generate_meshlets{false};
+
+                    // Results of the job
+
+                    bool succeeded{false};
+
+                    Rx::Vector<engine::renderer::StandardVertex> vertices;
+
+                    Rx::Vector<Uint32> indices;
+
+                    engine::BoundingBox bounds{};
+
+                    // How well the primitive used the vertex cache before and after its triangles and vertices were reordered
+
+                    engine::VertexCacheStatistics unoptimized_statistics;
+
+                    engine::VertexCacheStatistics optimized_statistics;
+
+                    // The primitive's packed vertices, if it was asked to pack them, and how much precision they lost
+
+                    Rx::Vector<engine::renderer::PackedVertex> packed_vertices;
+
+                    engine::renderer::MeshDequantization dequantization{};
+
+                    engine::VertexQuantizationError quantization_error;
+
+                    /*!
+                     * \brief The primitive's LODs, which index into the same vertices as the primitive, and how long generating them took
+                     */
+                    Rx::Vector<engine::SimplifiedMesh> lods;
+
+                    Float64 simplification_ms{0};
+
+                    /*!
+                     * \brief The primitive's meshlets, if it was asked to build them, and how long building them took
+                     */
+                    engine::MeshletData meshlets;
+
+                    Float64 meshlet_ms{0};
+                };
+
                 tinygltf::TinyGLTF importer;
 
                 engine::renderer::Renderer* renderer;
 
-                // Textures, materials, and meshes that were loaded from the current GLTF file
+                /*!
+                 * \brief Directory of the GLTF file being imported. Image URIs are relative to it
+                 */
+                std::filesystem::path scene_directory;
+
+                // Work for the current GLTF file. The jobs run in parallel, and their results get gathered into the scene data in the order
+                // the jobs were added, so the scene data is the same no matter how many threads did the work
+
+                Rx::Vector<TextureJob> texture_jobs;
+                Rx::Vector<PrimitiveJob> primitive_jobs;
+
+                /*!
+                 * \brief Indices of the texture jobs of the current GLTF file, by source image, compression usage, and alpha cutoff
+                 */
+                Rx::Map<Rx::String, Int32> processed_textures;
+
+                // Meshes and materials that were created for the current GLTF file
 
-                Rx::Map<Rx::String, engine::renderer::TextureHandle> loaded_textures;
                 Rx::Vector<GltfMesh> meshes;
                 Rx::Vector<engine::renderer::StandardMaterialHandle> materials;
 
                 // Rx::Vector<engine::renderer::AnimationHandle> animations;
 
-                [[nodiscard]] Rx::Vector<engine::renderer::StandardMaterialHandle> import_all_materials(const tinygltf::Model& scene);
+                SceneImportTimings last_import_timings;
+
+                /*!
+                 * \brief Stands in for tinygltf's image loader. Keeps each image's encoded bytes, so that the importer can decode the
+                 * images in parallel, and skip decoding the ones which have an up-to-date compressed texture cache
+                 */
+                static bool store_encoded_image(tinygltf::Image* image,
+                                                int image_idx,
+                                                std::string* err,
+                                                std::string* warn,
+                                                int req_width,
+                                                int req_height,
+                                                const unsigned char* bytes,
+                                                int size,
+                                                void* user_data);
+
+                [[nodiscard]] bool load_gltf_scene(const std::filesystem::path& scene_path, tinygltf::Model& scene);
+
+                /*!
+                 * \brief URIs of the files that a scene references, relative to the scene file
+                 */
+                [[nodiscard]] static Rx::Vector<Rx::String> get_scene_dependencies(const tinygltf::Model& scene);
+
+                /*!
+                 * \brief Adds the scene's materials to the scene data, and adds a texture job for each texture they use
+                 *
+                 * The materials' texture references are texture job indices until the results of the texture jobs are gathered
+                 */
+                void process_all_materials(const tinygltf::Model& scene, SceneData& scene_data);
 
-                [[nodiscard]] Rx::Optional<engine::renderer::TextureHandle> import_texture(Int32 texture_idx, const tinygltf::Model& scene);
+                /*!
+                 * \return The index of the texture's job, or MISSING_TEXTURE if the texture doesn't exist
+                 */
+                [[nodiscard]] Int32 add_texture_job(Int32 texture_idx,
+                                                    const tinygltf::Model& scene,
+                                                    engine::TextureCompressionUsage usage,
+                                                    const Rx::Optional<Float32>& alpha_cutoff = Rx::nullopt);
 
-                [[nodiscard]] Rx::Vector<GltfMesh> import_all_meshes(const tinygltf::Model& scene) const;
+                /*!
+                 * \brief Adds a primitive job for each primitive of each of the scene's meshes
+                 */
+                void add_all_primitive_jobs(const tinygltf::Model& scene, const SceneImportSettings& import_settings);
 
-                [[nodiscard]] static Rx::Optional<GltfPrimitive> get_data_from_primitive(const tinygltf::Primitive& primitive,
-                                                                                         const tinygltf::Model& scene,
-                                                                                         const engine::renderer::MeshUploader& uploader);
+                /*!
+                 * \brief Runs all the texture and primitive jobs on the engine's thread pool, and waits for them to finish
+                 *
+                 * Texture jobs go first, since they take much longer than primitive jobs
+                 */
+                void run_all_jobs(const tinygltf::Model& scene);
+
+                /*!
+                 * \brief Decodes a texture's image, generates its mips, and block compresses them if its size allows
+                 */
+                void run_texture_job(TextureJob& job, const tinygltf::Model& scene) const;
+
+                /*!
+                 * \brief Generates an image's mips and block compresses them, and writes the result to the image's cache file
+                 *
+                 * \return The compressed texture, or Rx::nullopt if the image can't be block compressed
+                 */
+                [[nodiscard]] Rx::Optional<engine::CompressedTexture> compress_image(const tinygltf::Image& image,
+                                                                                     const Uint8* pixels,
+                                                                                     Uint32 width,
+                                                                                     Uint32 height,
+                                                                                     engine::TextureCompressionUsage usage,
+                                                                                     const engine::MipGenerationOptions& mip_options) const;
+
+                /*!
+                 * \brief Decodes a primitive, and reorders its triangles and vertices for the GPU's vertex cache, overdraw, and vertex
+                 * fetch. Generates the primitive's LODs and meshlets, and packs its vertices, if the job asks for them
+                 */
+                static void run_primitive_job(PrimitiveJob& job, const tinygltf::Model& scene);
+
+                /*!
+                 * \brief Adds the textures of the texture jobs to the scene data, and points the scene's materials at them
+                 */
+                void gather_texture_results(SceneData& scene_data);
+
+                /*!
+                 * \brief Adds the primitives of the primitive jobs to the scene data, and adds the scene's meshes
+                 *
+                 * Logs how much optimizing the primitives improved their vertex cache use, how much their LODs reduced their triangle
+                 * counts, how full their meshlets are, and how much precision packing their vertices lost
+                 */
+                void gather_primitive_results(const tinygltf::Model& scene, SceneData& scene_data);
 
                 [[nodiscard]] static Rx::Vector<Uint32> get_indices_from_primitive(const tinygltf::Primitive& primitive,
                                                                                    const tinygltf::Model& scene);
@@ -71,27 +303,46 @@ namespace sanity {
                 [[nodiscard]] static Rx::Vector<engine::renderer::StandardVertex> get_vertices_from_primitive(const tinygltf::Primitive& primitive,
                                                                                                               const tinygltf::Model& scene);
 
-                [[nodiscard]] entt::entity import_object_hierarchy(const tinygltf::Model& model,
-                                                                   float import_scale,
-                                                                   entt::registry& registry);
-                void import_node_mesh(const tinygltf::Node& node, entt::registry& registry, entt::entity node_entity);
+                static void process_object_hierarchy(const tinygltf::Model& model, float import_scale, SceneData& scene_data);
+
+                static void process_node(const tinygltf::Node& node,
+                                         Int32 parent_idx,
+                                         float import_scale,
+                                         const tinygltf::Model& model,
+                                         SceneData& scene_data);
+
+                [[nodiscard]] static engine::Transform get_node_transform(const tinygltf::Node& node, float import_scale);
+
+                static void process_node_light(const tinygltf::Node& node, const tinygltf::Model& model, SceneNode& scene_node);
 
-                void import_node_transform(const tinygltf::Node& node,
-                                           const entt::entity& parent_entity,
-                                           float import_scale,
+                /*!
+                 * \brief Creates the textures, materials, meshes, and entities of a scene
+                 *
+                 * \return The scene's root entity, if the import settings ask for the object hierarchy
+                 */
+                [[nodiscard]] Rx::Optional<entt::entity> instantiate_scene(const SceneDataView& scene_data,
+                                                                           const SceneImportSettings& import_settings,
+                                                                           entt::registry& registry);
+
+                [[nodiscard]] Rx::Vector<engine::renderer::TextureHandle> instantiate_all_textures(const SceneDataView& scene_data) const;
+
+                [[nodiscard]] Rx::Vector<engine::renderer::StandardMaterialHandle> instantiate_all_materials(
+                    const SceneDataView& scene_data, const Rx::Vector<engine::renderer::TextureHandle>& textures) const;
+
+                /*!
+                 * \brief Uploads the scene's primitives to the renderer's static mesh store, or to its packed mesh store if their vertices
+                 * are packed
+                 */
+                [[nodiscard]] Rx::Vector<GltfMesh> instantiate_all_meshes(const SceneDataView& scene_data) const;
+
+                [[nodiscard]] entt::entity instantiate_object_hierarchy(const SceneDataView& scene_data, entt::registry& registry);
+
+                void instantiate_node_mesh(const SceneNode& node,
+                                           const char* node_name,
                                            entt::registry& registry,
-                                           engine::Actor& node_actor) const;
-
-                void import_node_light(const tinygltf::Node& node,
-                                       const tinygltf::Model& model,
-                                       entt::registry& registry,
-                                       entt::entity node_entity) const;
-
-                entt::entity create_entity_for_node(const tinygltf::Node& node,
-                                                    const entt::entity& parent_entity,
-                                                    float import_scale,
-                                                    const tinygltf::Model& model,
-                                                    entt::registry& registry);
+                                           entt::entity node_entity);
+
+                void instantiate_node_light(const SceneNode& node, entt::registry& registry, entt::entity node_entity) const;
             };
         } // namespace import
     }     // namespace editor
@@ -29,6 +29,10 @@ namespace sanity::editor::ui {
         draw_property("Import lights", import_settings.import_lights);
         draw_property("Import entities", import_settings.import_empties);
         draw_property("Import object hierarchies", import_settings.import_object_hierarchy);
+        draw_property("Quantize vertices", import_settings.quantize_vertices);
+        draw_property("Number of LODs", import_settings.num_lods);
+        draw_property("LOD error", import_settings.lod_error);
+        draw_property("Generate meshlets", import_settings.generate_meshlets);
 
         // Intentionally not drawing a property editor for source_file - source_file gets set automatically when you
         // import a mesh
@@ -44,7 +44,9 @@ SurfaceInfo get_surface_info(const in StandardVertex vertex, const in StandardMa
 
     if(material.normal_texture_idx != 0 && material.normal_texture_idx != INVALID_RESOURCE_HANDLE) {
         Texture2D normal_texture = textures[material.normal_texture_idx];
-        surface.normal = normal_texture.Sample(bilinear_sampler, vertex.texcoord).xyz * 2.0 - 1.0;
+        // Normalmaps are BC5, which only stores x and y, so we rebuild z from them
+        const float2 normal_xy = normal_texture.Sample(bilinear_sampler, vertex.texcoord).xy * 2.0 - 1.0;
+        surface.normal = float3(normal_xy, sqrt(saturate(1.0 - dot(normal_xy, normal_xy))));
         surface.normal.y *= -1; // Convert from right-handed normalmaps to left-handed normals
 
         FrameConstants data = get_frame_constants();
@@ -0,0 +1,137 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+#include "Tracy.hpp"
+#include "rx/core/concurrency/scope_lock.h"
+#include "rx/core/log.h"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine {
+    RX_LOG("ThreadPool", logger);
+
+    void ThreadPool::ParallelForTask::run_batches() {
+        for(auto batch_idx = next_batch.fetch_add(1); batch_idx < num_batches; batch_idx = next_batch.fetch_add(1)) {
+            const auto begin = batch_idx * batch_size;
+            const auto end = std::min(begin + batch_size, num_items);
+            (*job)(begin, end);
+        }
+    }
+
+    bool ThreadPool::ParallelForTask::has_remaining_batches() const { return next_batch.load() < num_batches; }
+
+    ThreadPool::ThreadPool(const Uint32 num_threads) {
+        threads.reserve(num_threads);
+        for(auto i = 0u; i < num_threads; i++) {
+            threads.push_back(Rx::make_ptr<Rx::Concurrency::Thread>(RX_SYSTEM_ALLOCATOR, "Worker thread", [&](Int32) { run_worker(); }));
+        }
+
+        logger->info("Started %u worker threads", num_threads);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            Rx::Concurrency::ScopeLock lock{mutex};
+            should_stop = true;
+        }
+        work_available.broadcast();
+
+        threads.each_fwd([](Rx::Ptr<Rx::Concurrency::Thread>& thread) { thread->join(); });
+    }
+
+    void ThreadPool::submit(Rx::Function<void()>&& job) {
+        {
+            Rx::Concurrency::ScopeLock lock{mutex};
+            jobs.push(Rx::Utility::move(job));
+        }
+        work_available.signal();
+    }
+
+    void ThreadPool::parallel_for(const Uint32 num_items, const Uint32 batch_size, const Rx::Function<void(Uint32, Uint32)>& job) {
+        ZoneScoped;
+
+        if(num_items == 0) {
+            return;
+        }
+
+        ParallelForTask task;
+        task.job = &job;
+        task.num_items = num_items;
+        task.batch_size = std::max(batch_size, 1u);
+        task.num_batches = (num_items + task.batch_size - 1) / task.batch_size;
+
+        // No point in waking up the workers when we'd be done before they get going
+        if(task.num_batches == 1 || threads.is_empty()) {
+            task.run_batches();
+            return;
+        }
+
+        {
+            Rx::Concurrency::ScopeLock lock{mutex};
+            parallel_tasks.push_back(&task);
+        }
+        work_available.broadcast();
+
+        task.run_batches();
+
+        // Every batch has been claimed. Stop workers from picking up the task, then wait for the ones that already did
+        Rx::Concurrency::ScopeLock lock{mutex};
+        if(const auto task_idx = parallel_tasks.find(&task)) {
+            parallel_tasks[*task_idx] = parallel_tasks.last();
+            parallel_tasks.pop_back();
+        }
+
+        while(task.num_helpers > 0) {
+            helper_finished.wait(lock);
+        }
+    }
+
+    Uint32 ThreadPool::get_num_threads() const { return static_cast<Uint32>(threads.size()); }
+
+    void ThreadPool::run_worker() {
+        Rx::Concurrency::ScopeLock lock{mutex};
+
+        while(true) {
+            if(auto* task = find_parallel_task()) {
+                task->num_helpers++;
+
+                mutex.unlock();
+                task->run_batches();
+                mutex.lock();
+
+                task->num_helpers--;
+                if(task->num_helpers == 0) {
+                    helper_finished.broadcast();
+                }
+
+            } else if(!jobs.empty()) {
+                auto job = Rx::Utility::move(jobs.front());
+                jobs.pop();
+
+                mutex.unlock();
+                job();
+                mutex.lock();
+
+            } else if(should_stop) {
+                return;
+
+            } else {
+                work_available.wait(lock);
+            }
+        }
+    }
+
+    ThreadPool::ParallelForTask* ThreadPool::find_parallel_task() const {
+        ParallelForTask* task_with_batches = nullptr;
+        parallel_tasks.each_fwd([&](ParallelForTask* task) {
+            if(task->has_remaining_batches()) {
+                task_with_batches = task;
+                return false;
+            }
+
+            return true;
+        });
+
+        return task_with_batches;
+    }
+} // namespace sanity::engine
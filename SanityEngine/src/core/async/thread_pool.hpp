@@ -0,0 +1,105 @@
+#pragma once
+
+#include <queue>
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/concurrency/condition_variable.h"
+#include "rx/core/concurrency/mutex.h"
+#include "rx/core/concurrency/thread.h"
+#include "rx/core/function.h"
+#include "rx/core/ptr.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief A fixed set of worker threads which run jobs for the rest of the engine
+     *
+     * Jobs submitted with `submit` are fire-and-forget. `parallel_for` splits a range of items into batches and blocks until they're all
+     * done. The calling thread processes batches itself, and idle workers join in, so `parallel_for` never waits on an unrelated job that's
+     * hogging the workers
+     */
+    class ThreadPool {
+    public:
+        explicit ThreadPool(Uint32 num_threads);
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        ThreadPool(ThreadPool&& old) noexcept = delete;
+        ThreadPool& operator=(ThreadPool&& old) noexcept = delete;
+
+        ~ThreadPool();
+
+        /*!
+         * \brief Runs a job on one of the worker threads at some point in the future
+         */
+        void submit(Rx::Function<void()>&& job);
+
+        /*!
+         * \brief Calls `job` for every batch of `batch_size` items in `[0, num_items)`, and waits for all the batches to finish
+         *
+         * \param job Function which processes the items in `[begin, end)`. It's called concurrently from multiple threads
+         */
+        void parallel_for(Uint32 num_items, Uint32 batch_size, const Rx::Function<void(Uint32, Uint32)>& job);
+
+        [[nodiscard]] Uint32 get_num_threads() const;
+
+    private:
+        /*!
+         * \brief A `parallel_for` call which workers may help with
+         *
+         * Lives on the stack of the thread which called `parallel_for`. That thread doesn't return until `num_helpers` drops to zero
+         */
+        struct ParallelForTask {
+            const Rx::Function<void(Uint32, Uint32)>* job{nullptr};
+
+            Uint32 num_items{0};
+
+            Uint32 batch_size{0};
+
+            Uint32 num_batches{0};
+
+            Rx::Concurrency::Atomic<Uint32> next_batch{0};
+
+            /*!
+             * \brief Number of worker threads currently running batches of this task. Guarded by `mutex`
+             */
+            Uint32 num_helpers{0};
+
+            /*!
+             * \brief Processes batches until there are none left
+             */
+            void run_batches();
+
+            [[nodiscard]] bool has_remaining_batches() const;
+        };
+
+        Rx::Vector<Rx::Ptr<Rx::Concurrency::Thread>> threads;
+
+        Rx::Concurrency::Mutex mutex;
+
+        /*!
+         * \brief Signalled when there's a new job or parallel task for the workers, or when the pool is shutting down
+         */
+        Rx::Concurrency::ConditionVariable work_available;
+
+        /*!
+         * \brief Signalled when a worker stops helping with a parallel task
+         */
+        Rx::Concurrency::ConditionVariable helper_finished;
+
+        std::queue<Rx::Function<void()>> jobs;
+
+        Rx::Vector<ParallelForTask*> parallel_tasks;
+
+        bool should_stop{false};
+
+        void run_worker();
+
+        /*!
+         * \brief Finds a parallel task that still has batches left. Must be called with `mutex` locked
+         */
+        [[nodiscard]] ParallelForTask* find_parallel_task() const;
+    };
+} // namespace sanity::engine
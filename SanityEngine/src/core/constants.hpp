@@ -9,6 +9,10 @@ constexpr Uint32 NVIDIA_PCI_VENDOR_ID = 0x10DE;
 constexpr Uint32 STATIC_MESH_VERTEX_BUFFER_SIZE = 64 << 20;
 constexpr Uint32 STATIC_MESH_INDEX_BUFFER_SIZE = 64 << 20;
 
+constexpr Uint32 PACKED_MESH_VERTEX_BUFFER_SIZE = 32 << 20;
+constexpr Uint32 PACKED_MESH_INDEX_BUFFER_SIZE = 32 << 20;
+constexpr Uint32 MAX_NUM_PACKED_MESHES = 65536;
+
 constexpr Uint32 MAX_NUM_BUFFERS = 65536;
 constexpr Uint32 MAX_NUM_TEXTURES = 65536;
 constexpr Uint32 MAX_NUM_CAMERAS = 256;
@@ -0,0 +1,79 @@
+#include "mapped_file.hpp"
+
+#include <Windows.h>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "rx/core/log.h"
+#include "windows/windows_helpers.hpp"
+
+namespace sanity::engine {
+    RX_LOG("MappedFile", logger);
+
+    MappedFile::~MappedFile() { close(); }
+
+    bool MappedFile::open(const std::filesystem::path& path) {
+        ZoneScoped;
+
+        close();
+
+        auto* file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if(file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            // Windows can't map empty files
+            CloseHandle(file);
+            return false;
+        }
+
+        auto* mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping == nullptr) {
+            logger->error("Could not create a mapping of file %s: %s", path, get_last_windows_error());
+            CloseHandle(file);
+            return false;
+        }
+
+        const auto* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(view == nullptr) {
+            logger->error("Could not map file %s: %s", path, get_last_windows_error());
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        file_handle = file;
+        mapping_handle = mapping;
+        data = static_cast<const Uint8*>(view);
+        size = static_cast<Size>(file_size.QuadPart);
+
+        return true;
+    }
+
+    void MappedFile::close() {
+        if(data != nullptr) {
+            UnmapViewOfFile(data);
+            data = nullptr;
+        }
+
+        if(mapping_handle != nullptr) {
+            CloseHandle(mapping_handle);
+            mapping_handle = nullptr;
+        }
+
+        if(file_handle != nullptr) {
+            CloseHandle(file_handle);
+            file_handle = nullptr;
+        }
+
+        size = 0;
+    }
+
+    bool MappedFile::is_open() const { return data != nullptr; }
+
+    const Uint8* MappedFile::get_data() const { return data; }
+
+    Size MappedFile::get_size() const { return size; }
+} // namespace sanity::engine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/types.hpp"
+
+namespace sanity::engine {
+    /*!
+     * \brief A read-only view of a whole file, mapped into memory
+     *
+     * The OS pages the file in as it's read, so reading a mapped file doesn't copy it into a buffer first
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        MappedFile(MappedFile&& old) noexcept = delete;
+        MappedFile& operator=(MappedFile&& old) noexcept = delete;
+
+        ~MappedFile();
+
+        /*!
+         * \brief Maps a file into memory, unmapping the file which was mapped before
+         *
+         * \return false if the file couldn't be opened or mapped
+         */
+        bool open(const std::filesystem::path& path);
+
+        void close();
+
+        [[nodiscard]] bool is_open() const;
+
+        [[nodiscard]] const Uint8* get_data() const;
+
+        [[nodiscard]] Size get_size() const;
+
+    private:
+        void* file_handle{nullptr};
+
+        void* mapping_handle{nullptr};
+
+        const Uint8* data{nullptr};
+
+        Size size{0};
+    };
+} // namespace sanity::engine
@@ -13,4 +13,22 @@ namespace sanity::engine {
 
     	return path_string + '.' + extension_c_str;
     }
+
+    bool get_file_size_and_write_time(const fs::path& path, Uint64& size, Int64& write_time) {
+        std::error_code error;
+        const auto file_size = fs::file_size(path, error);
+        if(error) {
+            return false;
+        }
+
+        const auto file_write_time = fs::last_write_time(path, error);
+        if(error) {
+            return false;
+        }
+
+        size = file_size;
+        write_time = static_cast<Int64>(file_write_time.time_since_epoch().count());
+
+        return true;
+    }
 } // namespace sanity::engine
\ No newline at end of file
@@ -2,8 +2,17 @@
 
 #include <filesystem>
 
+#include "core/types.hpp"
+
 namespace fs = std::filesystem;
 
 namespace sanity::engine {
     fs::path append_extension(const fs::path& path, const fs::path& extension);
+
+    /*!
+     * \brief Gets the size and last modification time of a file, so that files generated from it can tell if they're out of date
+     *
+     * \return false if the file doesn't exist or can't be read
+     */
+    bool get_file_size_and_write_time(const fs::path& path, Uint64& size, Int64& write_time);
 }
@@ -0,0 +1,88 @@
+#include "hash.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace sanity::engine {
+    constexpr Uint64 PRIME_1 = 0x9E3779B185EBCA87ull;
+    constexpr Uint64 PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr Uint64 PRIME_3 = 0x165667B19E3779F9ull;
+    constexpr Uint64 PRIME_4 = 0x85EBCA77C2B2AE63ull;
+    constexpr Uint64 PRIME_5 = 0x27D4EB2F165667C5ull;
+
+    static Uint64 read_64(const Uint8* bytes) {
+        Uint64 value;
+        memcpy(&value, bytes, sizeof(Uint64));
+        return value;
+    }
+
+    static Uint32 read_32(const Uint8* bytes) {
+        Uint32 value;
+        memcpy(&value, bytes, sizeof(Uint32));
+        return value;
+    }
+
+    static Uint64 round(Uint64 accumulator, const Uint64 input) {
+        accumulator += input * PRIME_2;
+        accumulator = std::rotl(accumulator, 31);
+        return accumulator * PRIME_1;
+    }
+
+    static Uint64 merge_round(Uint64 hash, const Uint64 accumulator) {
+        hash ^= round(0, accumulator);
+        return hash * PRIME_1 + PRIME_4;
+    }
+
+    Uint64 hash_bytes(const void* data, const Size size, const Uint64 seed) {
+        const auto* bytes = static_cast<const Uint8*>(data);
+        const auto* end = bytes + size;
+
+        Uint64 hash;
+        if(size >= 32) {
+            // Four independent accumulators, so that the CPU can work on them in parallel
+            Uint64 accumulators[4] = {seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1};
+            for(; bytes + 32 <= end; bytes += 32) {
+                accumulators[0] = round(accumulators[0], read_64(bytes));
+                accumulators[1] = round(accumulators[1], read_64(bytes + 8));
+                accumulators[2] = round(accumulators[2], read_64(bytes + 16));
+                accumulators[3] = round(accumulators[3], read_64(bytes + 24));
+            }
+
+            hash = std::rotl(accumulators[0], 1) + std::rotl(accumulators[1], 7) + std::rotl(accumulators[2], 12) +
+                   std::rotl(accumulators[3], 18);
+            for(const auto accumulator : accumulators) {
+                hash = merge_round(hash, accumulator);
+            }
+
+        } else {
+            hash = seed + PRIME_5;
+        }
+
+        hash += size;
+
+        for(; bytes + 8 <= end; bytes += 8) {
+            hash ^= round(0, read_64(bytes));
+            hash = std::rotl(hash, 27) * PRIME_1 + PRIME_4;
+        }
+
+        if(bytes + 4 <= end) {
+            hash ^= read_32(bytes) * PRIME_1;
+            hash = std::rotl(hash, 23) * PRIME_2 + PRIME_3;
+            bytes += 4;
+        }
+
+        for(; bytes < end; bytes++) {
+            hash ^= *bytes * PRIME_5;
+            hash = std::rotl(hash, 11) * PRIME_1;
+        }
+
+        // Avalanche, so that every input bit affects every output bit
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        hash *= PRIME_3;
+        hash ^= hash >> 32;
+
+        return hash;
+    }
+} // namespace sanity::engine
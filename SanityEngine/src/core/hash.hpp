@@ -0,0 +1,13 @@
+#pragma once
+
+#include "core/types.hpp"
+
+namespace sanity::engine {
+    /*!
+     * \brief Hashes a block of memory with xxHash64
+     *
+     * Fast enough to hash whole source assets every time they're loaded, so that files which are generated from them can tell if they're
+     * out of date. Not suitable for anything that needs to resist tampering
+     */
+    [[nodiscard]] Uint64 hash_bytes(const void* data, Size size, Uint64 seed = 0);
+} // namespace sanity::engine
@@ -0,0 +1,312 @@
+#include "range_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "Tracy.hpp"
+#include "rx/core/log.h"
+
+namespace sanity::engine {
+    RX_LOG("RangeAllocator", logger);
+
+    Float32 RangeAllocatorStats::fragmentation() const {
+        const auto free_units = capacity - used_units;
+        if(free_units == 0) {
+            return 0;
+        }
+
+        return 1.0f - static_cast<Float32>(largest_free_block) / static_cast<Float32>(free_units);
+    }
+
+    RangeAllocator::RangeAllocator(const Uint32 capacity_in) : capacity{capacity_in} {
+        for(auto& first_level : free_list_heads) {
+            for(auto& head : first_level) {
+                head = INVALID_BLOCK;
+            }
+        }
+
+        // The first block always starts at offset 0 and is never merged into anything, so it stays at index 0 forever
+        last_block = create_block(0, capacity);
+        if(capacity > 0) {
+            insert_free_block(last_block);
+        }
+    }
+
+    Rx::Optional<RangeAllocation> RangeAllocator::allocate(const Uint32 size) {
+        if(size == 0) {
+            logger->warning("Can not allocate a zero-sized range");
+            return Rx::nullopt;
+        }
+
+        const auto block_idx = find_free_block(size);
+        if(block_idx == INVALID_BLOCK) {
+            num_failed_allocations++;
+            return Rx::nullopt;
+        }
+
+        remove_free_block(block_idx);
+        use_block(block_idx, size);
+
+        const auto offset = blocks[block_idx].offset;
+        allocated_blocks.insert(offset, block_idx);
+        used_units += size;
+
+        return RangeAllocation{.offset = offset, .size = size};
+    }
+
+    void RangeAllocator::free(const Uint32 offset) {
+        const auto* block_idx_ptr = allocated_blocks.find(offset);
+        if(block_idx_ptr == nullptr) {
+            logger->error("No allocation starts at offset %u", offset);
+            return;
+        }
+
+        auto block_idx = *block_idx_ptr;
+        allocated_blocks.erase(offset);
+
+        used_units -= blocks[block_idx].size;
+
+        const auto next_idx = blocks[block_idx].next_physical;
+        if(next_idx != INVALID_BLOCK && blocks[next_idx].is_free) {
+            remove_free_block(next_idx);
+            merge_with_previous(next_idx);
+        }
+
+        const auto prev_idx = blocks[block_idx].prev_physical;
+        if(prev_idx != INVALID_BLOCK && blocks[prev_idx].is_free) {
+            remove_free_block(prev_idx);
+            merge_with_previous(block_idx);
+            block_idx = prev_idx;
+        }
+
+        insert_free_block(block_idx);
+    }
+
+    Rx::Vector<RangeMove> RangeAllocator::plan_compaction(const Uint32 max_units_to_move) {
+        ZoneScoped;
+
+        Rx::Vector<RangeMove> moves;
+        Rx::Vector<Uint32> destination_blocks;
+
+        Uint32 units_moved = 0;
+        auto cursor = last_block;
+        while(cursor != INVALID_BLOCK && units_moved < max_units_to_move) {
+            const auto prev_idx = blocks[cursor].prev_physical;
+            const auto source = blocks[cursor];
+
+            if(!source.is_free && source.size <= max_units_to_move - units_moved && !destination_blocks.find(cursor)) {
+                // Find the lowest free block that can hold this allocation. If there's no free space before the allocation at all, nothing
+                // further down can move either
+                auto destination_idx = INVALID_BLOCK;
+                auto found_free_space_below = false;
+                for(auto block_idx = 0u; block_idx != INVALID_BLOCK && blocks[block_idx].offset < source.offset;
+                    block_idx = blocks[block_idx].next_physical) {
+                    const auto& block = blocks[block_idx];
+                    if(block.is_free) {
+                        found_free_space_below = true;
+                        if(block.size >= source.size) {
+                            destination_idx = block_idx;
+                            break;
+                        }
+                    }
+                }
+
+                if(!found_free_space_below) {
+                    break;
+                }
+
+                if(destination_idx != INVALID_BLOCK) {
+                    remove_free_block(destination_idx);
+                    use_block(destination_idx, source.size);
+
+                    const auto destination_offset = blocks[destination_idx].offset;
+                    allocated_blocks.insert(destination_offset, destination_idx);
+                    used_units += source.size;
+
+                    destination_blocks.push_back(destination_idx);
+                    moves.push_back(
+                        RangeMove{.source_offset = source.offset, .destination_offset = destination_offset, .size = source.size});
+
+                    units_moved += source.size;
+                }
+            }
+
+            cursor = prev_idx;
+        }
+
+        return moves;
+    }
+
+    Uint32 RangeAllocator::get_capacity() const { return capacity; }
+
+    RangeAllocatorStats RangeAllocator::get_stats() const {
+        auto stats = RangeAllocatorStats{.capacity = capacity,
+                                         .used_units = used_units,
+                                         .num_allocations = static_cast<Uint32>(allocated_blocks.size()),
+                                         .num_failed_allocations = num_failed_allocations};
+
+        for(auto block_idx = 0u; block_idx != INVALID_BLOCK; block_idx = blocks[block_idx].next_physical) {
+            const auto& block = blocks[block_idx];
+            if(block.is_free) {
+                stats.num_free_blocks++;
+                stats.largest_free_block = std::max(stats.largest_free_block, block.size);
+            }
+        }
+
+        return stats;
+    }
+
+    Rx::Pair<Uint32, Uint32> RangeAllocator::get_list_indices(const Uint32 size) {
+        const auto most_significant_bit = static_cast<Uint32>(std::bit_width(size)) - 1;
+        if(most_significant_bit < SECOND_LEVEL_LOG2) {
+            // Small sizes all go in the first first-level list, one second-level list per size
+            return {0, size};
+        }
+
+        const auto first_level = most_significant_bit - SECOND_LEVEL_LOG2 + 1;
+        const auto second_level = (size >> (most_significant_bit - SECOND_LEVEL_LOG2)) - SECOND_LEVEL_COUNT;
+        return {first_level, second_level};
+    }
+
+    Uint32 RangeAllocator::find_free_block(const Uint32 size) const {
+        // Round the size up to the next list boundary so that every block in the list we find is large enough
+        Uint64 rounded_size = size;
+        const auto most_significant_bit = static_cast<Uint32>(std::bit_width(size)) - 1;
+        if(most_significant_bit >= SECOND_LEVEL_LOG2) {
+            rounded_size += (1ull << (most_significant_bit - SECOND_LEVEL_LOG2)) - 1;
+        }
+
+        if(rounded_size <= 0xFFFFFFFF) {
+            const auto indices = get_list_indices(static_cast<Uint32>(rounded_size));
+            auto first_level = indices.first;
+
+            auto second_level_map = second_level_bitmaps[first_level] & (~0u << indices.second);
+            if(second_level_map == 0) {
+                const auto first_level_map = first_level_bitmap & (~0u << (first_level + 1));
+                if(first_level_map != 0) {
+                    first_level = static_cast<Uint32>(std::countr_zero(first_level_map));
+                    second_level_map = second_level_bitmaps[first_level];
+                }
+            }
+
+            if(second_level_map != 0) {
+                return free_list_heads[first_level][std::countr_zero(second_level_map)];
+            }
+        }
+
+        // Every larger list is empty, but blocks in the list that `size` itself maps to might still be large enough
+        const auto indices = get_list_indices(size);
+        for(auto block_idx = free_list_heads[indices.first][indices.second]; block_idx != INVALID_BLOCK;
+            block_idx = blocks[block_idx].next_free) {
+            if(blocks[block_idx].size >= size) {
+                return block_idx;
+            }
+        }
+
+        return INVALID_BLOCK;
+    }
+
+    Uint32 RangeAllocator::create_block(const Uint32 offset, const Uint32 size) {
+        auto block_idx = 0u;
+        if(!unused_blocks.is_empty()) {
+            block_idx = unused_blocks.last();
+            unused_blocks.pop_back();
+        } else {
+            block_idx = static_cast<Uint32>(blocks.size());
+            blocks.emplace_back();
+        }
+
+        blocks[block_idx] = Block{.offset = offset, .size = size};
+
+        return block_idx;
+    }
+
+    void RangeAllocator::destroy_block(const Uint32 block_idx) {
+        blocks[block_idx] = Block{};
+        unused_blocks.push_back(block_idx);
+    }
+
+    void RangeAllocator::insert_free_block(const Uint32 block_idx) {
+        auto& block = blocks[block_idx];
+        const auto indices = get_list_indices(block.size);
+        auto& head = free_list_heads[indices.first][indices.second];
+
+        block.is_free = true;
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = head;
+        if(head != INVALID_BLOCK) {
+            blocks[head].prev_free = block_idx;
+        }
+        head = block_idx;
+
+        first_level_bitmap |= 1u << indices.first;
+        second_level_bitmaps[indices.first] |= 1u << indices.second;
+    }
+
+    void RangeAllocator::remove_free_block(const Uint32 block_idx) {
+        auto& block = blocks[block_idx];
+        const auto indices = get_list_indices(block.size);
+        auto& head = free_list_heads[indices.first][indices.second];
+
+        if(block.prev_free != INVALID_BLOCK) {
+            blocks[block.prev_free].next_free = block.next_free;
+        }
+        if(block.next_free != INVALID_BLOCK) {
+            blocks[block.next_free].prev_free = block.prev_free;
+        }
+
+        if(head == block_idx) {
+            head = block.next_free;
+            if(head == INVALID_BLOCK) {
+                second_level_bitmaps[indices.first] &= ~(1u << indices.second);
+                if(second_level_bitmaps[indices.first] == 0) {
+                    first_level_bitmap &= ~(1u << indices.first);
+                }
+            }
+        }
+
+        block.is_free = false;
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = INVALID_BLOCK;
+    }
+
+    void RangeAllocator::use_block(const Uint32 block_idx, const Uint32 size) {
+        const auto remaining_size = blocks[block_idx].size - size;
+        if(remaining_size == 0) {
+            return;
+        }
+
+        // `create_block` may grow `blocks`, so don't hold references across it
+        const auto remainder_idx = create_block(blocks[block_idx].offset + size, remaining_size);
+        const auto next_idx = blocks[block_idx].next_physical;
+
+        blocks[remainder_idx].prev_physical = block_idx;
+        blocks[remainder_idx].next_physical = next_idx;
+        if(next_idx != INVALID_BLOCK) {
+            blocks[next_idx].prev_physical = remainder_idx;
+        } else {
+            last_block = remainder_idx;
+        }
+
+        blocks[block_idx].next_physical = remainder_idx;
+        blocks[block_idx].size = size;
+
+        insert_free_block(remainder_idx);
+    }
+
+    void RangeAllocator::merge_with_previous(const Uint32 block_idx) {
+        const auto& block = blocks[block_idx];
+        const auto prev_idx = block.prev_physical;
+        const auto next_idx = block.next_physical;
+
+        blocks[prev_idx].size += block.size;
+        blocks[prev_idx].next_physical = next_idx;
+        if(next_idx != INVALID_BLOCK) {
+            blocks[next_idx].prev_physical = prev_idx;
+        } else {
+            last_block = prev_idx;
+        }
+
+        destroy_block(block_idx);
+    }
+} // namespace sanity::engine
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/map.h"
+#include "rx/core/optional.h"
+#include "rx/core/utility/pair.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief A range of units handed out by a RangeAllocator
+     */
+    struct RangeAllocation {
+        Uint32 offset{0};
+        Uint32 size{0};
+    };
+
+    /*!
+     * \brief A relocation that the compaction planner wants the owner of a RangeAllocator to perform
+     *
+     * The planner has already reserved the destination range. The source range stays allocated until the owner frees it, so the owner can
+     * keep reading from it until the data has actually been copied
+     */
+    struct RangeMove {
+        Uint32 source_offset{0};
+        Uint32 destination_offset{0};
+        Uint32 size{0};
+    };
+
+    struct RangeAllocatorStats {
+        Uint32 capacity{0};
+
+        Uint32 used_units{0};
+
+        Uint32 num_allocations{0};
+
+        Uint32 num_free_blocks{0};
+
+        Uint32 largest_free_block{0};
+
+        /*!
+         * \brief Number of allocation requests that could not be satisfied since this allocator was created
+         */
+        Uint64 num_failed_allocations{0};
+
+        /*!
+         * \brief How much of the free space is unusable for an allocation as large as the total free space. 0 means all free space is
+         * contiguous, values close to 1 mean that the free space is split into many small holes
+         */
+        [[nodiscard]] Float32 fragmentation() const;
+    };
+
+    /*!
+     * \brief Sub-allocates ranges out of a linear space of `capacity` units
+     *
+     * This is a two-level segregated fit (TLSF) allocator: free blocks live in size-segregated free lists, found in constant time with two
+     * levels of bitmaps, and neighboring free blocks are coalesced as soon as they're freed. It only does bookkeeping - it doesn't know or
+     * care what the units are, so it can be driven with recorded allocation traces without a GPU around
+     */
+    class RangeAllocator {
+    public:
+        explicit RangeAllocator(Uint32 capacity_in);
+
+        RangeAllocator(const RangeAllocator& other) = delete;
+        RangeAllocator& operator=(const RangeAllocator& other) = delete;
+
+        RangeAllocator(RangeAllocator&& old) noexcept = default;
+        RangeAllocator& operator=(RangeAllocator&& old) noexcept = default;
+
+        ~RangeAllocator() = default;
+
+        /*!
+         * \brief Allocates a range of `size` units
+         *
+         * \return The new allocation, or an empty optional if there's no free block large enough to hold `size` units
+         */
+        [[nodiscard]] Rx::Optional<RangeAllocation> allocate(Uint32 size);
+
+        /*!
+         * \brief Frees the allocation that starts at `offset`
+         */
+        void free(Uint32 offset);
+
+        /*!
+         * \brief Plans moves that pack live allocations towards the start of the range
+         *
+         * Allocations are considered from the end of the range backwards, and each one is moved into the lowest free block that can hold
+         * it. The destination of each move is reserved immediately, but the source is not freed - the caller should free it with `free`
+         * once the data has been copied and nothing reads from the old location any more
+         *
+         * \param max_units_to_move Upper bound on the total size of the moved allocations, so compaction can be spread over many frames
+         */
+        [[nodiscard]] Rx::Vector<RangeMove> plan_compaction(Uint32 max_units_to_move);
+
+        [[nodiscard]] Uint32 get_capacity() const;
+
+        [[nodiscard]] RangeAllocatorStats get_stats() const;
+
+    private:
+        static constexpr Uint32 INVALID_BLOCK = 0xFFFFFFFF;
+
+        static constexpr Uint32 SECOND_LEVEL_LOG2 = 4;
+
+        static constexpr Uint32 SECOND_LEVEL_COUNT = 1 << SECOND_LEVEL_LOG2;
+
+        static constexpr Uint32 FIRST_LEVEL_COUNT = 32 - SECOND_LEVEL_LOG2 + 1;
+
+        struct Block {
+            Uint32 offset{0};
+            Uint32 size{0};
+
+            Uint32 prev_physical{INVALID_BLOCK};
+            Uint32 next_physical{INVALID_BLOCK};
+
+            Uint32 prev_free{INVALID_BLOCK};
+            Uint32 next_free{INVALID_BLOCK};
+
+            bool is_free{false};
+        };
+
+        Uint32 capacity;
+
+        Rx::Vector<Block> blocks;
+
+        /*!
+         * \brief Indices of entries in `blocks` that don't currently describe a block
+         */
+        Rx::Vector<Uint32> unused_blocks;
+
+        /*!
+         * \brief Physically last block, so that compaction can walk allocations from the end of the range
+         */
+        Uint32 last_block{INVALID_BLOCK};
+
+        Uint32 first_level_bitmap{0};
+
+        Uint32 second_level_bitmaps[FIRST_LEVEL_COUNT]{};
+
+        Uint32 free_list_heads[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+
+        /*!
+         * \brief Map from the offset of a live allocation to the block that holds it
+         */
+        Rx::Map<Uint32, Uint32> allocated_blocks;
+
+        Uint32 used_units{0};
+
+        Uint64 num_failed_allocations{0};
+
+        [[nodiscard]] static Rx::Pair<Uint32, Uint32> get_list_indices(Uint32 size);
+
+        [[nodiscard]] Uint32 find_free_block(Uint32 size) const;
+
+        [[nodiscard]] Uint32 create_block(Uint32 offset, Uint32 size);
+
+        void destroy_block(Uint32 block_idx);
+
+        void insert_free_block(Uint32 block_idx);
+
+        void remove_free_block(Uint32 block_idx);
+
+        /*!
+         * \brief Marks the first `size` units of a free block as used, splitting any remainder off into a new free block
+         */
+        void use_block(Uint32 block_idx, Uint32 size);
+
+        /*!
+         * \brief Merges the block at `block_idx` into its physical predecessor. Both must already be out of the free lists
+         */
+        void merge_with_previous(Uint32 block_idx);
+    };
+} // namespace sanity::engine
@@ -0,0 +1,49 @@
+#include "ring_allocator.hpp"
+
+#include "rx/core/log.h"
+
+namespace sanity::engine {
+    RX_LOG("RingAllocator", logger);
+
+    RingAllocator::RingAllocator(const Uint32 capacity_in, const Uint32 num_frames_in) : capacity{capacity_in} {
+        frame_starts.resize(num_frames_in, 0);
+    }
+
+    Rx::Optional<Uint32> RingAllocator::allocate(const Uint32 size) {
+        if(size == 0 || size > capacity) {
+            logger->error("Can not allocate %u units from a ring of %u units", size, capacity);
+            return Rx::nullopt;
+        }
+
+        auto cur_head = head.load();
+        while(true) {
+            auto start = cur_head;
+
+            const auto offset_in_ring = start % capacity;
+            if(offset_in_ring + size > capacity) {
+                start += capacity - offset_in_ring;
+            }
+
+            const auto new_head = start + size;
+            if(new_head - tail.load() > capacity) {
+                return Rx::nullopt;
+            }
+
+            // If another thread moved the head since we loaded it, this reloads it and we try again
+            if(head.compare_exchange_weak(cur_head, new_head)) {
+                return static_cast<Uint32>(start % capacity);
+            }
+        }
+    }
+
+    void RingAllocator::begin_frame(const Uint32 frame_idx) {
+        frame_starts[frame_idx] = head.load();
+
+        // The frame which used this slot before is done, so the oldest frame still in flight is the one after it
+        tail.store(frame_starts[(frame_idx + 1) % frame_starts.size()]);
+    }
+
+    Uint32 RingAllocator::get_capacity() const { return capacity; }
+
+    Uint32 RingAllocator::get_used_units() const { return static_cast<Uint32>(head.load() - tail.load()); }
+} // namespace sanity::engine
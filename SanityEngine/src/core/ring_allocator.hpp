@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief Hands out short-lived ranges from a linear space of `capacity` units, which get reclaimed a fixed number of frames later
+     *
+     * Allocation is lock-free, so any number of threads may allocate at once. Ranges are never freed individually - once the GPU is done
+     * with a frame, `begin_frame` reclaims everything allocated during it. Like RangeAllocator, this only does bookkeeping, so it can be
+     * tested without a GPU
+     */
+    class RingAllocator {
+    public:
+        /*!
+         * \param capacity_in Number of units in the ring
+         * \param num_frames_in Number of frames that may be in flight at once
+         */
+        RingAllocator(Uint32 capacity_in, Uint32 num_frames_in);
+
+        RingAllocator(const RingAllocator& other) = delete;
+        RingAllocator& operator=(const RingAllocator& other) = delete;
+
+        RingAllocator(RingAllocator&& old) noexcept = delete;
+        RingAllocator& operator=(RingAllocator&& old) noexcept = delete;
+
+        ~RingAllocator() = default;
+
+        /*!
+         * \brief Allocates a contiguous range of `size` units. May be called from any thread
+         *
+         * Ranges never wrap around the end of the ring. If there's not enough room before the end, the units there are skipped
+         *
+         * \return The offset of the new range, or an empty optional if the frames in flight are using too much of the ring
+         */
+        [[nodiscard]] Rx::Optional<Uint32> allocate(Uint32 size);
+
+        /*!
+         * \brief Reclaims everything that was allocated the last time `frame_idx` was recorded
+         *
+         * Must be called after the GPU has finished that frame, and not concurrently with `allocate`
+         */
+        void begin_frame(Uint32 frame_idx);
+
+        [[nodiscard]] Uint32 get_capacity() const;
+
+        /*!
+         * \brief Number of units which are allocated by the frames in flight, including units skipped at the end of the ring
+         */
+        [[nodiscard]] Uint32 get_used_units() const;
+
+    private:
+        Uint32 capacity;
+
+        /*!
+         * \brief Total number of units ever allocated. The offset into the ring is this modulo the capacity. 64 bits, so that it never
+         * wraps
+         */
+        Rx::Concurrency::Atomic<Uint64> head{0};
+
+        /*!
+         * \brief Value of `head` when the oldest frame in flight began. Nothing at or after this may be overwritten
+         */
+        Rx::Concurrency::Atomic<Uint64> tail{0};
+
+        /*!
+         * \brief Value of `head` when each frame began
+         */
+        Rx::Vector<Uint64> frame_starts;
+    };
+} // namespace sanity::engine
@@ -0,0 +1,257 @@
+#include "transform_hierarchy.hpp"
+
+#include "Tracy.hpp"
+#include "core/async/thread_pool.hpp"
+#include "core/components.hpp"
+#include "entt/entity/registry.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/log.h"
+
+namespace sanity::engine {
+    RX_LOG("TransformHierarchy", logger);
+
+    static bool operator==(const Transform& lhs, const Transform& rhs) {
+        return lhs.location == rhs.location && lhs.rotation == rhs.rotation && lhs.scale == rhs.scale;
+    }
+
+    void TransformHierarchy::update(entt::registry& registry, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        if(is_structure_outdated(registry)) {
+            rebuild(registry);
+        }
+
+        gather_local_transforms(registry, thread_pool);
+
+        num_updated_nodes = 0;
+
+        for(auto level_idx = 0u; level_idx + 1 < level_starts.size(); level_idx++) {
+            const auto level_begin = level_starts[level_idx];
+            const auto level_end = level_starts[level_idx + 1];
+
+            if(thread_pool != nullptr && level_end - level_begin >= MIN_NODES_FOR_PARALLEL_UPDATE) {
+                Rx::Concurrency::Atomic<Uint32> num_updated_nodes_in_level{0};
+                thread_pool->parallel_for(level_end - level_begin, NODES_PER_BATCH, [&](const Uint32 begin, const Uint32 end) {
+                    num_updated_nodes_in_level.fetch_add(update_world_matrices(level_begin + begin, level_begin + end));
+                });
+
+                num_updated_nodes += num_updated_nodes_in_level.load();
+
+            } else {
+                num_updated_nodes += update_world_matrices(level_begin, level_end);
+            }
+        }
+
+        all_nodes_dirty = false;
+    }
+
+    glm::mat4 TransformHierarchy::get_world_matrix(const entt::entity entity, const entt::registry& registry) const {
+        if(const auto node_idx = get_node_idx(entity); node_idx != NO_NODE) {
+            return world_matrices[node_idx];
+        }
+
+        return registry.get<TransformComponent>(entity).get_model_matrix(registry);
+    }
+
+    glm::mat4 TransformHierarchy::get_parent_world_matrix(const entt::entity entity, const entt::registry& registry) const {
+        const auto& transform = registry.get<TransformComponent>(entity);
+        if(!transform.parent) {
+            return glm::mat4{1};
+        }
+
+        return get_world_matrix(*transform.parent, registry);
+    }
+
+    Uint32 TransformHierarchy::get_node_idx(const entt::entity entity) const {
+        const auto* node_idx = node_by_entity.find(static_cast<Uint32>(entity));
+        return node_idx != nullptr ? *node_idx : NO_NODE;
+    }
+
+    const glm::mat4& TransformHierarchy::get_node_world_matrix(const Uint32 node_idx) const { return world_matrices[node_idx]; }
+
+    bool TransformHierarchy::is_node_updated(const Uint32 node_idx) const { return dirty_flags[node_idx] != 0; }
+
+    Uint32 TransformHierarchy::get_num_rebuilds() const { return num_rebuilds; }
+
+    Uint32 TransformHierarchy::get_num_nodes() const { return static_cast<Uint32>(entities.size()); }
+
+    Uint32 TransformHierarchy::get_num_updated_nodes() const { return num_updated_nodes; }
+
+    bool TransformHierarchy::is_structure_outdated(entt::registry& registry) const {
+        ZoneScoped;
+
+        if(registry.view<TransformComponent>().size() != entities.size()) {
+            return true;
+        }
+
+        for(auto node_idx = 0u; node_idx < entities.size(); node_idx++) {
+            const auto entity = entities[node_idx];
+            if(!registry.valid(entity)) {
+                return true;
+            }
+
+            const auto* transform = registry.try_get<TransformComponent>(entity);
+            if(transform == nullptr) {
+                return true;
+            }
+
+            const auto parent_idx = parents[node_idx];
+            if(transform->parent) {
+                if(parent_idx == NO_PARENT || entities[parent_idx] != *transform->parent) {
+                    return true;
+                }
+
+            } else if(parent_idx != NO_PARENT) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void TransformHierarchy::rebuild(entt::registry& registry) {
+        ZoneScoped;
+
+        const auto transform_view = registry.view<TransformComponent>();
+        const auto num_nodes = static_cast<Uint32>(transform_view.size());
+
+        // Find the depth of every entity. Each entity's parent chain is walked until it reaches an entity with a known depth, so every
+        // entity is visited a constant number of times
+        Rx::Map<Uint32, Uint32> depth_by_entity;
+        Rx::Vector<entt::entity> unresolved_chain;
+        Uint32 num_levels = 0;
+
+        transform_view.each([&](const entt::entity entity, const TransformComponent& /* transform */) {
+            auto cur_entity = entity;
+            Uint32 depth = 0;
+
+            while(true) {
+                if(const auto* known_depth = depth_by_entity.find(static_cast<Uint32>(cur_entity))) {
+                    depth = *known_depth + 1;
+                    break;
+                }
+
+                unresolved_chain.push_back(cur_entity);
+
+                const auto& parent = registry.get<TransformComponent>(cur_entity).parent;
+                if(!parent || !registry.valid(*parent) || registry.try_get<TransformComponent>(*parent) == nullptr) {
+                    break;
+                }
+
+                if(unresolved_chain.size() > num_nodes) {
+                    logger->error("Entity %u is its own ancestor! Treating it as a root", static_cast<Uint32>(entity));
+                    unresolved_chain.clear();
+                    unresolved_chain.push_back(entity);
+                    break;
+                }
+
+                cur_entity = *parent;
+            }
+
+            unresolved_chain.each_rev([&](const entt::entity chain_entity) {
+                depth_by_entity.insert(static_cast<Uint32>(chain_entity), depth);
+                num_levels = depth + 1 > num_levels ? depth + 1 : num_levels;
+                depth++;
+            });
+            unresolved_chain.clear();
+        });
+
+        // Counting sort by depth
+        level_starts.clear();
+        level_starts.resize(num_levels + 1, 0);
+        depth_by_entity.each_pair([&](const Uint32 /* entity */, const Uint32 depth) { level_starts[depth + 1]++; });
+        for(auto level_idx = 1u; level_idx < level_starts.size(); level_idx++) {
+            level_starts[level_idx] += level_starts[level_idx - 1];
+        }
+
+        entities.resize(num_nodes);
+        Rx::Vector<Uint32> next_node_in_level = level_starts;
+        transform_view.each([&](const entt::entity entity, const TransformComponent& /* transform */) {
+            const auto depth = *depth_by_entity.find(static_cast<Uint32>(entity));
+            entities[next_node_in_level[depth]] = entity;
+            next_node_in_level[depth]++;
+        });
+
+        node_by_entity.clear();
+        for(auto node_idx = 0u; node_idx < num_nodes; node_idx++) {
+            node_by_entity.insert(static_cast<Uint32>(entities[node_idx]), node_idx);
+        }
+
+        parents.resize(num_nodes);
+        for(auto node_idx = 0u; node_idx < num_nodes; node_idx++) {
+            parents[node_idx] = NO_PARENT;
+
+            const auto& parent = registry.get<TransformComponent>(entities[node_idx]).parent;
+            if(parent) {
+                if(const auto* parent_idx = node_by_entity.find(static_cast<Uint32>(*parent))) {
+                    // Nodes which were made roots to break a cycle have a parent, but that parent isn't sorted before them
+                    if(*parent_idx < node_idx) {
+                        parents[node_idx] = *parent_idx;
+                    }
+                }
+            }
+        }
+
+        local_transforms.resize(num_nodes);
+        world_matrices.resize(num_nodes);
+        dirty_flags.resize(num_nodes);
+
+        all_nodes_dirty = true;
+        num_rebuilds++;
+
+        logger->verbose("Sorted %u transforms into %u levels", num_nodes, num_levels);
+    }
+
+    void TransformHierarchy::gather_local_transforms(entt::registry& registry, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        const auto gather_range = [&](const Uint32 begin, const Uint32 end) {
+            for(auto node_idx = begin; node_idx < end; node_idx++) {
+                const auto& transform = registry.get<TransformComponent>(entities[node_idx]).transform;
+                if(all_nodes_dirty || transform != local_transforms[node_idx]) {
+                    local_transforms[node_idx] = transform;
+                    dirty_flags[node_idx] = 1;
+
+                } else {
+                    dirty_flags[node_idx] = 0;
+                }
+            }
+        };
+
+        const auto num_nodes = static_cast<Uint32>(entities.size());
+        if(thread_pool != nullptr && num_nodes >= MIN_NODES_FOR_PARALLEL_UPDATE) {
+            thread_pool->parallel_for(num_nodes, NODES_PER_BATCH, gather_range);
+
+        } else {
+            gather_range(0, num_nodes);
+        }
+    }
+
+    Uint32 TransformHierarchy::update_world_matrices(const Uint32 begin, const Uint32 end) {
+        Uint32 num_updated = 0;
+
+        for(auto node_idx = begin; node_idx < end; node_idx++) {
+            const auto parent_idx = parents[node_idx];
+            if(parent_idx != NO_PARENT && dirty_flags[parent_idx] != 0) {
+                dirty_flags[node_idx] = 1;
+            }
+
+            if(dirty_flags[node_idx] == 0) {
+                continue;
+            }
+
+            const auto local_matrix = local_transforms[node_idx].to_matrix();
+            if(parent_idx == NO_PARENT) {
+                world_matrices[node_idx] = local_matrix;
+
+            } else {
+                // Same order as TransformComponent::get_model_matrix
+                world_matrices[node_idx] = local_matrix * world_matrices[parent_idx];
+            }
+
+            num_updated++;
+        }
+
+        return num_updated;
+    }
+} // namespace sanity::engine
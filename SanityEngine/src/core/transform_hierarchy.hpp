@@ -0,0 +1,156 @@
+#pragma once
+
+#include "core/transform.hpp"
+#include "core/types.hpp"
+#include "entt/entity/fwd.hpp"
+#include "glm/mat4x4.hpp"
+#include "rx/core/map.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+
+    /*!
+     * \brief Caches the world matrix of every entity with a TransformComponent
+     *
+     * The hierarchy is stored as flat arrays, sorted so that every node comes after its parent. Nodes are grouped by their depth in the
+     * hierarchy, so all the nodes in one level can be updated in parallel once the level above them is done. Only nodes whose local
+     * transform changed, or which have an ancestor whose local transform changed, get their world matrix recomputed
+     */
+    class TransformHierarchy {
+    public:
+        static constexpr Uint32 NO_NODE = 0xFFFFFFFF;
+
+        TransformHierarchy() = default;
+
+        TransformHierarchy(const TransformHierarchy& other) = delete;
+        TransformHierarchy& operator=(const TransformHierarchy& other) = delete;
+
+        TransformHierarchy(TransformHierarchy&& old) noexcept = default;
+        TransformHierarchy& operator=(TransformHierarchy&& old) noexcept = default;
+
+        ~TransformHierarchy() = default;
+
+        /*!
+         * \brief Picks up changes to the TransformComponents in the registry and recomputes the world matrices which need it
+         *
+         * Entities which were added, removed, or re-parented since the last update cause the whole hierarchy to be re-sorted
+         *
+         * \param thread_pool Thread pool to spread large levels of the hierarchy over. If this is nullptr, all work happens on the calling
+         * thread
+         */
+        void update(entt::registry& registry, ThreadPool* thread_pool = nullptr);
+
+        /*!
+         * \brief Gets the matrix from the entity's local space to world space
+         *
+         * Entities which didn't exist at the last `update` fall back to walking up their parents
+         */
+        [[nodiscard]] glm::mat4 get_world_matrix(entt::entity entity, const entt::registry& registry) const;
+
+        /*!
+         * \brief Gets the world matrix of the entity's parent, or the identity matrix if the entity has no parent
+         */
+        [[nodiscard]] glm::mat4 get_parent_world_matrix(entt::entity entity, const entt::registry& registry) const;
+
+        /*!
+         * \brief Gets the index of the entity's node, or NO_NODE if the entity didn't exist at the last `update`
+         *
+         * Node indices stay the same until the hierarchy is re-sorted, which `get_num_rebuilds` tells you about
+         */
+        [[nodiscard]] Uint32 get_node_idx(entt::entity entity) const;
+
+        [[nodiscard]] const glm::mat4& get_node_world_matrix(Uint32 node_idx) const;
+
+        /*!
+         * \brief Checks if the last `update` recomputed the node's world matrix
+         */
+        [[nodiscard]] bool is_node_updated(Uint32 node_idx) const;
+
+        /*!
+         * \brief Number of times the hierarchy has been re-sorted
+         */
+        [[nodiscard]] Uint32 get_num_rebuilds() const;
+
+        [[nodiscard]] Uint32 get_num_nodes() const;
+
+        /*!
+         * \brief Number of world matrices which the last `update` recomputed
+         */
+        [[nodiscard]] Uint32 get_num_updated_nodes() const;
+
+    private:
+        static constexpr Uint32 NO_PARENT = 0xFFFFFFFF;
+
+        /*!
+         * \brief Levels with fewer nodes than this are updated on the calling thread, because waking the workers would cost more than
+         * it saves
+         */
+        static constexpr Uint32 MIN_NODES_FOR_PARALLEL_UPDATE = 1024;
+
+        static constexpr Uint32 NODES_PER_BATCH = 256;
+
+        Rx::Vector<entt::entity> entities;
+
+        /*!
+         * \brief Index of each node's parent node, or NO_PARENT for root nodes
+         */
+        Rx::Vector<Uint32> parents;
+
+        /*!
+         * \brief Each node's local transform as of the last update, so we can tell which nodes changed
+         */
+        Rx::Vector<Transform> local_transforms;
+
+        Rx::Vector<glm::mat4> world_matrices;
+
+        /*!
+         * \brief Whether each node's world matrix must be recomputed in the current update. Uint8 rather than bool so that threads can
+         * write to neighboring flags
+         */
+        Rx::Vector<Uint8> dirty_flags;
+
+        /*!
+         * \brief Index of the first node of each level of the hierarchy, plus one final entry for the total number of nodes
+         */
+        Rx::Vector<Uint32> level_starts;
+
+        /*!
+         * \brief Map from entity ID to the index of that entity's node
+         */
+        Rx::Map<Uint32, Uint32> node_by_entity;
+
+        /*!
+         * \brief Set when the hierarchy has been re-sorted, so that the next update recomputes every world matrix
+         */
+        bool all_nodes_dirty{true};
+
+        Uint32 num_updated_nodes{0};
+
+        Uint32 num_rebuilds{0};
+
+        /*!
+         * \brief Checks if entities were added, removed, or re-parented since the hierarchy was last sorted
+         */
+        [[nodiscard]] bool is_structure_outdated(entt::registry& registry) const;
+
+        /*!
+         * \brief Sorts all entities with a TransformComponent into levels
+         */
+        void rebuild(entt::registry& registry);
+
+        /*!
+         * \brief Copies the local transforms out of the registry, marking the nodes whose transform changed as dirty
+         */
+        void gather_local_transforms(entt::registry& registry, ThreadPool* thread_pool);
+
+        /*!
+         * \brief Recomputes the world matrices of the dirty nodes in `[begin, end)`, marking the children of dirty nodes as dirty as well
+         *
+         * All the nodes in the range must be in the same level, and all levels above them must already be up to date
+         *
+         * \return The number of world matrices which were recomputed
+         */
+        Uint32 update_world_matrices(Uint32 begin, Uint32 end);
+    };
+} // namespace sanity::engine
@@ -1,7 +1,12 @@
 #include "asset_loader.hpp"
 
+#include "core/async/thread_pool.hpp"
 #include "loading/image_loading.hpp"
-#include "rx/core/concurrency/scope_lock.h "
+#include "renderer/renderer.hpp"
+#include "renderer/rhi/render_backend.hpp"
+#include "rx/core/concurrency/scope_lock.h"
+#include "rx/core/utility/move.h"
+#include "sanity_engine.hpp"
 #include "tracy/Tracy.hpp"
 
 namespace sanity::engine {
@@ -16,14 +21,57 @@ namespace sanity::engine {
                                                  const Size index_in)
         : AssetLoadResultHandle{asset_loader_in, container_in, index_in} {}
 
-    ImageLoadResultHandle::~ImageLoadResultHandle() { asset_loader->release_image_at_idx(get_index()); }
+    ImageLoadResultHandle::ImageLoadResultHandle(ImageLoadResultHandle&& old) noexcept : AssetLoadResultHandle{old} {
+        old.asset_loader = nullptr;
+    }
+
+    ImageLoadResultHandle& ImageLoadResultHandle::operator=(ImageLoadResultHandle&& old) noexcept {
+        if(this != &old) {
+            if(asset_loader != nullptr) {
+                asset_loader->release_image_at_idx(get_index());
+            }
+
+            AssetLoadResultHandle::operator=(old);
+            old.asset_loader = nullptr;
+        }
+
+        return *this;
+    }
+
+    ImageLoadResultHandle::~ImageLoadResultHandle() {
+        // Moved-from handles don't own their result
+        if(asset_loader != nullptr) {
+            asset_loader->release_image_at_idx(get_index());
+        }
+    }
 
     AssetLoader::AssetLoader(renderer::Renderer* renderer_in) : renderer{renderer_in} {}
 
+    AssetLoader::~AssetLoader() {
+        // The worker threads write to the pending loads, so we can't free them while they're decoding
+        pending_image_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) { load->is_cancelled.store(true); });
+
+        {
+            Rx::Concurrency::ScopeLock lock{decode_mutex};
+            pending_image_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) {
+                while(!load->is_decoded.load()) {
+                    image_decoded.wait(lock);
+                }
+            });
+        }
+
+        pending_image_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) { load->release_image_data(); });
+    }
+
     ImageLoadResultHandle AssetLoader::load_image(const std::filesystem::path& path, const Rx::Function<void(const ImageLoadResult&)>& on_complete) {
         ZoneScoped;
         auto idx = Size{0};
 
+        auto pending_load = Rx::make_ptr<PendingImageLoad>(RX_SYSTEM_ALLOCATOR);
+        pending_load->path = path;
+        pending_load->on_complete = on_complete;
+        auto* load = pending_load.get();
+
         {
             ZoneScopedN("Initialize results");
 
@@ -51,33 +99,189 @@ namespace sanity::engine {
                 image_load_results.emplace_back();
                 image_load_result_availability.push_back(false);
             }
+
+            pending_load->result_idx = idx;
+            pending_image_loads.push_back(Rx::Utility::move(pending_load));
         }
 
-        auto accessor = ImageLoadResultHandle{*this, &image_load_results, idx};
+        // The load stays in pending_image_loads until it's decoded, so the worker thread may hold on to a raw pointer
+        g_engine->get_thread_pool().submit([this, load] {
+            ZoneScopedN("Decode image");
+
+            // If the image has no container and one can't be written, e.g. because its directory is read-only, use the image that was
+            // decoded to write the container
+            DecodedImage decoded_image;
+            if(!load->is_cancelled.load() &&
+               !load_texture_container(load->path, load->texture_container, Rx::nullopt, nullptr, &decoded_image)) {
+                load->pixels = decoded_image.pixels;
+                load->mip_chain = Rx::Utility::move(decoded_image.mip_chain);
+                load->width = decoded_image.width;
+                load->height = decoded_image.height;
+                load->format = decoded_image.format;
+            }
+
+            // The destructor may free the load and this loader as soon as it sees that the load is decoded, so don't touch either after
+            // unlocking
+            Rx::Concurrency::ScopeLock lock{decode_mutex};
+            load->is_decoded.store(true);
+            image_decoded.broadcast();
+        });
+
+        return ImageLoadResultHandle{*this, &image_load_results, idx};
+    }
+
+    void AssetLoader::tick() {
+        ZoneScoped;
+
+        upload_decoded_images();
+
+        complete_uploaded_images();
+    }
+
+    void AssetLoader::release_image_at_idx(const Size idx) {
+        Rx::Concurrency::ScopeLock _{image_load_results_mutex};
+        image_load_result_availability[idx] = true;
+
+        // Cancel the load if it's still going. tick will clean it up
+        pending_image_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) {
+            if(load->result_idx == idx && !load->is_cancelled.load()) {
+                load->is_cancelled.store(true);
+
+                return RX_ITERATION_STOP;
+            }
+
+            return RX_ITERATION_CONTINUE;
+        });
+    }
+
+    void AssetLoader::upload_decoded_images() {
+        ZoneScoped;
+
+        Rx::Concurrency::ScopeLock _{image_load_results_mutex};
+
+        Rx::Vector<PendingImageLoad*> loads_to_upload;
+        pending_image_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) {
+            if(!load->is_decoded.load() || !load->has_image_data()) {
+                return;
+            }
 
-        // TODO: Eventually we'll probably want to make this method async, but that's hard
-        auto final_result = ImageLoadResult{};
+            if(load->is_cancelled.load()) {
+                load->release_image_data();
+
+            } else {
+                loads_to_upload.push_back(load.get());
+            }
+        });
 
-        const auto handle_maybe = load_texture_to_gpu(path, *renderer);
-        if(handle_maybe) {
-            final_result.is_complete = true;
-            final_result.succeeded = true;
-            final_result.asset = Rx::make_ptr<renderer::TextureHandle>(RX_SYSTEM_ALLOCATOR, *handle_maybe);
+        if(loads_to_upload.is_empty()) {
+            return;
         }
 
+        // Record all the uploads into one command list, so they execute in one batch at the beginning of the next frame
+        auto& backend = renderer->get_render_backend();
+        auto cmds = backend.create_render_command_list();
+
+        loads_to_upload.each_fwd([&](PendingImageLoad* load) {
+            const auto texture_name = load->path.string();
+
+            if(load->texture_container.is_open()) {
+                const auto create_info = load->texture_container.get_create_info(texture_name.c_str());
+                load->texture = renderer->create_texture(create_info, load->texture_container.get_placed_data(), cmds);
+
+            } else {
+                const auto has_mip_chain = !load->mip_chain.is_empty();
+                const auto create_info = renderer::TextureCreateInfo{
+                    .name = texture_name.c_str(),
+                    .usage = renderer::TextureUsage::SampledTexture,
+                    .format = load->format,
+                    .width = load->width,
+                    .height = load->height,
+                    .num_mips = has_mip_chain ? renderer::get_num_mips(load->width, load->height) : 0,
+                };
+                load->texture = renderer->create_texture(create_info, has_mip_chain ? load->mip_chain.data() : load->pixels, cmds);
+            }
+
+            load->release_image_data();
+        });
+
+        cmds->Close();
+
+        const auto upload_fence_value = backend.submit_copy_command_list(cmds);
+        loads_to_upload.each_fwd([&](PendingImageLoad* load) { load->upload_fence_value = upload_fence_value; });
+    }
+
+    void AssetLoader::complete_uploaded_images() {
+        ZoneScoped;
+
+        const auto completed_upload_fence_value = renderer->get_render_backend().get_completed_upload_fence_value();
+
+        Rx::Vector<Rx::Ptr<PendingImageLoad>> completed_loads;
+
         {
             Rx::Concurrency::ScopeLock _{image_load_results_mutex};
-            image_load_results[idx] = Rx::Utility::move(final_result);
 
-            ZoneScopedN("on_complete");
-            on_complete(image_load_results[idx]);
+            Rx::Vector<Rx::Ptr<PendingImageLoad>> remaining_loads;
+            remaining_loads.reserve(pending_image_loads.size());
+
+            pending_image_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) {
+                const auto is_waiting_for_decode = !load->is_decoded.load() || load->has_image_data();
+                const auto is_waiting_for_upload = load->texture && load->upload_fence_value > completed_upload_fence_value;
+                if(is_waiting_for_decode || is_waiting_for_upload) {
+                    remaining_loads.push_back(Rx::Utility::move(load));
+
+                } else {
+                    completed_loads.push_back(Rx::Utility::move(load));
+                }
+            });
+
+            pending_image_loads = Rx::Utility::move(remaining_loads);
         }
 
-        return accessor;
+        // Callbacks may load or release images, so call them without holding the lock
+        completed_loads.each_fwd([&](Rx::Ptr<PendingImageLoad>& load) {
+            // A load can make `image_load_results` reallocate, so the callback gets its own copy of the result
+            ImageLoadResult result_copy;
+            Rx::Function<void(const ImageLoadResult&)> on_complete;
+
+            {
+                Rx::Concurrency::ScopeLock _{image_load_results_mutex};
+
+                // Check under the lock, since the result may have been released just now
+                if(load->is_cancelled.load()) {
+                    if(load->texture) {
+                        renderer->schedule_texture_destruction(*load->texture);
+                    }
+
+                    return;
+                }
+
+                auto& result = image_load_results[load->result_idx];
+                result.is_complete = true;
+                result.succeeded = load->texture.has_value();
+                if(load->texture) {
+                    result.asset = Rx::make_ptr<renderer::TextureHandle>(RX_SYSTEM_ALLOCATOR, *load->texture);
+                    result_copy.asset = Rx::make_ptr<renderer::TextureHandle>(RX_SYSTEM_ALLOCATOR, *load->texture);
+                }
+
+                result_copy.is_complete = result.is_complete;
+                result_copy.succeeded = result.succeeded;
+                on_complete = Rx::Utility::move(load->on_complete);
+            }
+
+            ZoneScopedN("on_complete");
+            on_complete(result_copy);
+        });
     }
 
-    void AssetLoader::release_image_at_idx(const Size idx) {
-        Rx::Concurrency::ScopeLock _{image_load_results_mutex};
-        image_load_result_availability[idx] = true;
+    bool AssetLoader::PendingImageLoad::has_image_data() const { return pixels != nullptr || texture_container.is_open(); }
+
+    void AssetLoader::PendingImageLoad::release_image_data() {
+        if(pixels != nullptr) {
+            free_texture_data(pixels, format);
+            pixels = nullptr;
+        }
+
+        mip_chain.clear();
+        texture_container.close();
     }
 } // namespace sanity::engine
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <filesystem>
+
 #include "adapters/rex/rex_wrapper.hpp"
 #include "core/VectorHandle.hpp"
+#include "loading/texture_container.hpp"
 #include "renderer/handles.hpp"
 #include "renderer/rhi/resources.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/concurrency/condition_variable.h"
 #include "rx/core/concurrency/mutex.h"
 #include "rx/core/function.h"
+#include "rx/core/optional.h"
 #include "rx/core/ptr.h"
+#include "rx/core/vector.h"
 
 namespace sanity::engine {
     namespace renderer {
@@ -41,27 +48,130 @@ namespace sanity::engine {
     public:
         ImageLoadResultHandle(AssetLoader& asset_loader_in, Rx::Vector<ImageLoadResult>* container_in, Size index_in);
 
+        ImageLoadResultHandle(const ImageLoadResultHandle& other) = delete;
+        ImageLoadResultHandle& operator=(const ImageLoadResultHandle& other) = delete;
+
+        ImageLoadResultHandle(ImageLoadResultHandle&& old) noexcept;
+        ImageLoadResultHandle& operator=(ImageLoadResultHandle&& old) noexcept;
+
+        /*!
+         * \brief Releases the load result. If the image hasn't finished loading, the load is cancelled and its callback is never called
+         */
         ~ImageLoadResultHandle() override;
     };
 
     /*!
      * \brief A class to keep track of asset loading tasks
+     *
+     * Images are decoded on the engine's thread pool. `tick` uploads the images which finished decoding in one command list, and calls the
+     * completion callbacks of the images whose uploads the GPU has finished. Everything but the decoding happens on the main thread
      */
     class AssetLoader {
     public:
         explicit AssetLoader(renderer::Renderer* renderer_in);
 
+        AssetLoader(const AssetLoader& other) = delete;
+        AssetLoader& operator=(const AssetLoader& other) = delete;
+
+        AssetLoader(AssetLoader&& old) noexcept = delete;
+        AssetLoader& operator=(AssetLoader&& old) noexcept = delete;
+
+        /*!
+         * \brief Waits for the worker threads to finish decoding any images that they're working on
+         */
+        ~AssetLoader();
+
+        /*!
+         * \brief Starts loading an image in the background
+         *
+         * \param on_complete Called from `tick` once the image is on the GPU, or once loading it has failed
+         */
         [[nodiscard]] ImageLoadResultHandle load_image(const std::filesystem::path& path,
                                                        const Rx::Function<void(const ImageLoadResult&)>& on_complete);
 
+        /*!
+         * \brief Uploads the newly decoded images and dispatches the callbacks of the loads which have completed. Call once per frame
+         */
+        void tick();
+
         void release_image_at_idx(Size idx);
 
     private:
+        /*!
+         * \brief An image which is being decoded, waiting to be uploaded, or waiting for its upload to finish
+         *
+         * The worker thread which decodes the image opens its texture container or writes the pixels, size and format, then sets
+         * `is_decoded`. After that only the main thread touches the load
+         */
+        struct PendingImageLoad {
+            std::filesystem::path path;
+
+            Rx::Function<void(const ImageLoadResult&)> on_complete;
+
+            Size result_idx{0};
+
+            Rx::Concurrency::Atomic<bool> is_cancelled{false};
+
+            Rx::Concurrency::Atomic<bool> is_decoded{false};
+
+            /*!
+             * \brief The image's texture container. If this is open, the image is uploaded straight from it and `pixels` is never set
+             */
+            TextureContainer texture_container;
+
+            /*!
+             * \brief Decoded pixels, or `nullptr` if decoding failed or the pixels have been uploaded
+             */
+            void* pixels{nullptr};
+
+            /*!
+             * \brief All the mips of an RGBA8 image, generated on the worker thread. Empty for HDR images, which get their mips generated
+             * on the GPU
+             */
+            Rx::Vector<Uint8> mip_chain;
+
+            Uint32 width{0};
+
+            Uint32 height{0};
+
+            renderer::TextureFormat format{renderer::TextureFormat::Rgba8};
+
+            Rx::Optional<renderer::TextureHandle> texture;
+
+            /*!
+             * \brief Value of the render backend's upload fence at which the texture's upload has finished
+             */
+            Uint64 upload_fence_value{0};
+
+            /*!
+             * \brief Checks if the load holds image data which hasn't been uploaded yet
+             */
+            [[nodiscard]] bool has_image_data() const;
+
+            void release_image_data();
+        };
+
         Rx::Concurrency::Mutex image_load_results_mutex;
         Rx::Vector<ImageLoadResult> image_load_results;
         Rx::Vector<bool> image_load_result_availability;
 
+        Rx::Vector<Rx::Ptr<PendingImageLoad>> pending_image_loads;
+
+        /*!
+         * \brief Guards setting `is_decoded`, so that the destructor can wait on `image_decoded` instead of spinning
+         */
+        Rx::Concurrency::Mutex decode_mutex;
+
+        /*!
+         * \brief Signalled when a worker thread is done with an image
+         */
+        Rx::Concurrency::ConditionVariable image_decoded;
+
         renderer::Renderer* renderer{nullptr};
+
+        void upload_decoded_images();
+
+        void complete_uploaded_images();
     };
 
 } // namespace sanity::engine
@@ -0,0 +1,215 @@
+#include "compressed_texture_cache.hpp"
+
+#include <cstdio> // fopen, fread, fwrite, fclose
+
+#include "Tracy.hpp"
+#include "core/fs/path_ops.hpp"
+#include "loading/image_loading.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/log.h"
+#include "rx/core/utility/move.h"
+#include "sanity_engine.hpp"
+
+namespace sanity::engine {
+    RX_LOG("CompressedTextureCache", logger);
+
+    constexpr Uint32 COMPRESSED_TEXTURE_FILE_MAGIC = 0x4E434253; // "SBCN"
+
+    /*!
+     * \brief Increment this when the file format or the encoder's output changes, so that old cache files get rewritten
+     */
+    constexpr Uint32 COMPRESSED_TEXTURE_FILE_VERSION = 2;
+
+    /*!
+     * \brief Value of `alpha_cutoff` in the file header when the mips weren't generated for alpha testing
+     */
+    constexpr Float32 NO_ALPHA_CUTOFF = -1.0f;
+
+    static Rx::Concurrency::Atomic<Uint32> next_temp_file_idx{0};
+
+    struct CompressedTextureFileHeader {
+        Uint32 magic{COMPRESSED_TEXTURE_FILE_MAGIC};
+
+        Uint32 version{COMPRESSED_TEXTURE_FILE_VERSION};
+
+        Uint32 format{0};
+
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        Uint32 num_mips{0};
+
+        Uint32 mip_filter{0};
+
+        Uint32 is_srgb{0};
+
+        Float32 alpha_cutoff{NO_ALPHA_CUTOFF};
+
+        Uint32 padding{0};
+
+        /*!
+         * \brief Size of the image which the texture was compressed from, when it was compressed
+         */
+        Uint64 source_size{0};
+
+        /*!
+         * \brief Modification time of the image which the texture was compressed from, when it was compressed
+         */
+        Int64 source_write_time{0};
+
+        Uint64 data_size{0};
+    };
+
+    static std::filesystem::path get_full_path(const std::filesystem::path& image_path) {
+        // Same as load_texture, so that the cache file is next to the image that was loaded
+        return SanityEngine::executable_directory / image_path;
+    }
+
+    std::filesystem::path get_compressed_texture_cache_path(const std::filesystem::path& image_path, const TextureCompressionUsage usage) {
+        const auto extension = Rx::String::format("%s.bcn", to_string(usage));
+        return append_extension(get_full_path(image_path), extension.data());
+    }
+
+    static bool is_generated_with(const CompressedTextureFileHeader& header, const MipGenerationOptions& mip_options) {
+        return header.mip_filter == static_cast<Uint32>(mip_options.filter) && header.is_srgb == (mip_options.is_srgb ? 1u : 0u) &&
+               header.alpha_cutoff == mip_options.alpha_cutoff.value_or(NO_ALPHA_CUTOFF);
+    }
+
+    Rx::Optional<CompressedTexture> read_compressed_texture_cache(const std::filesystem::path& image_path,
+                                                                  const TextureCompressionUsage usage,
+                                                                  const MipGenerationOptions& mip_options) {
+        ZoneScoped;
+
+        Uint64 source_size;
+        Int64 source_write_time;
+        if(!get_file_size_and_write_time(get_full_path(image_path), source_size, source_write_time)) {
+            return Rx::nullopt;
+        }
+
+        const auto cache_path = get_compressed_texture_cache_path(image_path, usage).string();
+        auto* cache_file = fopen(cache_path.c_str(), "rb");
+        if(cache_file == nullptr) {
+            return Rx::nullopt;
+        }
+
+        auto header = CompressedTextureFileHeader{};
+        const auto read_header = fread(&header, sizeof(header), 1, cache_file) == 1;
+
+        const auto is_up_to_date = read_header && header.magic == COMPRESSED_TEXTURE_FILE_MAGIC &&
+                                   header.version == COMPRESSED_TEXTURE_FILE_VERSION && header.source_size == source_size &&
+                                   header.source_write_time == source_write_time && is_generated_with(header, mip_options);
+        if(!is_up_to_date) {
+            fclose(cache_file);
+            return Rx::nullopt;
+        }
+
+        auto texture = CompressedTexture{.format = static_cast<renderer::TextureFormat>(header.format),
+                                         .width = header.width,
+                                         .height = header.height,
+                                         .num_mips = header.num_mips};
+        texture.blocks.resize(header.data_size);
+
+        const auto read_data = fread(texture.blocks.data(), sizeof(Uint8), header.data_size, cache_file) == header.data_size;
+        fclose(cache_file);
+
+        if(!read_data) {
+            logger->warning("Compressed texture cache file %s is truncated", cache_path.c_str());
+            return Rx::nullopt;
+        }
+
+        return texture;
+    }
+
+    bool write_compressed_texture_cache(const std::filesystem::path& image_path,
+                                        const TextureCompressionUsage usage,
+                                        const MipGenerationOptions& mip_options,
+                                        const CompressedTexture& texture) {
+        ZoneScoped;
+
+        auto header = CompressedTextureFileHeader{.format = static_cast<Uint32>(texture.format),
+                                                  .width = texture.width,
+                                                  .height = texture.height,
+                                                  .num_mips = texture.num_mips,
+                                                  .mip_filter = static_cast<Uint32>(mip_options.filter),
+                                                  .is_srgb = mip_options.is_srgb ? 1u : 0u,
+                                                  .alpha_cutoff = mip_options.alpha_cutoff.value_or(NO_ALPHA_CUTOFF),
+                                                  .data_size = texture.blocks.size()};
+        if(!get_file_size_and_write_time(get_full_path(image_path), header.source_size, header.source_write_time)) {
+            return false;
+        }
+
+        // Write to a temporary file and move it into place, so that a reader never sees a half-written cache file. Each write gets its own
+        // temporary file, so that two threads which compress the same image don't write into the same file
+        const auto cache_path = get_compressed_texture_cache_path(image_path, usage);
+        const auto temp_extension = Rx::String::format("%u.tmp", next_temp_file_idx.fetch_add(1));
+        const auto temp_path = append_extension(cache_path, temp_extension.data());
+        const auto temp_path_string = temp_path.string();
+        auto* cache_file = fopen(temp_path_string.c_str(), "wb");
+        if(cache_file == nullptr) {
+            logger->error("Could not open compressed texture cache file %s for writing", temp_path);
+            return false;
+        }
+
+        const auto wrote_header = fwrite(&header, sizeof(header), 1, cache_file) == 1;
+        const auto wrote_data = fwrite(texture.blocks.data(), sizeof(Uint8), texture.blocks.size(), cache_file) == texture.blocks.size();
+        fclose(cache_file);
+
+        std::error_code error;
+        if(wrote_header && wrote_data) {
+            std::filesystem::rename(temp_path, cache_path, error);
+        }
+
+        if(!wrote_header || !wrote_data || error) {
+            logger->error("Could not write compressed texture cache file %s", cache_path);
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    Rx::Optional<CompressedTexture> load_compressed_texture(const std::filesystem::path& image_path,
+                                                            const TextureCompressionUsage usage,
+                                                            const MipGenerationOptions& mip_options,
+                                                            ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        if(auto cached_texture = read_compressed_texture_cache(image_path, usage, mip_options); cached_texture) {
+            return cached_texture;
+        }
+
+        Uint32 width, height;
+        renderer::TextureFormat format;
+        auto* pixels = load_texture(image_path, width, height, format);
+        if(pixels == nullptr) {
+            return Rx::nullopt;
+        }
+
+        if(format != renderer::TextureFormat::Rgba8 || !can_block_compress(width, height)) {
+            logger->verbose("Not compressing image %s", image_path);
+            free_texture_data(pixels, format);
+            return Rx::nullopt;
+        }
+
+        const auto* rgba_pixels = static_cast<const Uint8*>(pixels);
+        const auto compressed_format = get_compressed_format(usage, has_alpha(rgba_pixels, width, height));
+
+        const auto num_mips = renderer::get_num_mips(width, height);
+        const auto mip_chain = generate_mip_chain(rgba_pixels, width, height, mip_options, thread_pool);
+        free_texture_data(pixels, format);
+
+        auto blocks = compress_mip_chain(mip_chain.data(), width, height, num_mips, compressed_format, thread_pool);
+        auto texture = CompressedTexture{.format = compressed_format,
+                                         .width = width,
+                                         .height = height,
+                                         .num_mips = num_mips,
+                                         .blocks = Rx::Utility::move(blocks)};
+
+        write_compressed_texture_cache(image_path, usage, mip_options, texture);
+
+        return texture;
+    }
+
+    bool can_block_compress(const Uint32 width, const Uint32 height) { return width % 4 == 0 && height % 4 == 0; }
+} // namespace sanity::engine
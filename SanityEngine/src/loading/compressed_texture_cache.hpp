@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+
+#include "loading/texture_compression.hpp"
+#include "rx/core/optional.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+
+    /*!
+     * \brief Path of the file which holds the compressed version of an image. It sits next to the image
+     */
+    [[nodiscard]] std::filesystem::path get_compressed_texture_cache_path(const std::filesystem::path& image_path,
+                                                                          TextureCompressionUsage usage);
+
+    /*!
+     * \brief Reads the compressed version of an image from its cache file
+     *
+     * \return The compressed texture, or `Rx::nullopt` if there's no cache file, the image changed after the cache file was written, or
+     * the cached mips were generated with different options
+     */
+    [[nodiscard]] Rx::Optional<CompressedTexture> read_compressed_texture_cache(const std::filesystem::path& image_path,
+                                                                                TextureCompressionUsage usage,
+                                                                                const MipGenerationOptions& mip_options);
+
+    /*!
+     * \brief Writes the compressed version of an image to its cache file, tagged with the image's current size and modification time
+     *
+     * The data goes into a temporary file which is then renamed to the cache file, so readers never see a partly written cache file
+     */
+    bool write_compressed_texture_cache(const std::filesystem::path& image_path,
+                                        TextureCompressionUsage usage,
+                                        const MipGenerationOptions& mip_options,
+                                        const CompressedTexture& texture);
+
+    /*!
+     * \brief Gets the compressed version of an image and its mips, generating and compressing them and writing the cache file if the
+     * cache file is out of date
+     *
+     * \return The compressed texture, or `Rx::nullopt` if the image can't be loaded or can't be block compressed. HDR images and images
+     * whose size isn't a multiple of four can't be block compressed
+     */
+    [[nodiscard]] Rx::Optional<CompressedTexture> load_compressed_texture(const std::filesystem::path& image_path,
+                                                                          TextureCompressionUsage usage,
+                                                                          const MipGenerationOptions& mip_options,
+                                                                          ThreadPool* thread_pool = nullptr);
+
+    /*!
+     * \brief Checks if an image with the given size can be a block compressed texture. The GPU needs the size of the top mip to be a
+     * multiple of the block size
+     */
+    [[nodiscard]] bool can_block_compress(Uint32 width, Uint32 height);
+} // namespace sanity::engine
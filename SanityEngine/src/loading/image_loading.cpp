@@ -3,6 +3,8 @@
 #include "Tracy.hpp"
 #include "TracyD3D12.hpp"
 #include "adapters/rex/rex_wrapper.hpp"
+#include "loading/pixel_conversion.hpp"
+#include "loading/texture_container.hpp"
 #include "renderer/renderer.hpp"
 #include "renderer/rhi/d3d12_private_data.hpp"
 #include "renderer/rhi/helpers.hpp"
@@ -15,12 +17,6 @@
 namespace sanity::engine {
     RX_LOG("TextureLoading", logger);
 
-    template <typename ComponentDataType>
-    ComponentDataType* copy_and_pad_texture_data(ComponentDataType* original_data,
-                                                 Uint32 width,
-                                                 Uint32 height,
-                                                 Uint32 original_num_components);
-
     void* load_texture(const std::filesystem::path& texture_name, Uint32& width, Uint32& height, renderer::TextureFormat& format) {
         ZoneScoped;
 
@@ -33,21 +29,30 @@ namespace sanity::engine {
 
         const auto full_texture_path_string = full_texture_path.string();
         if(stbi_is_hdr(full_texture_path_string.c_str())) {
-            logger->verbose("Loading image %s as RGBA32f HDR", texture_name);
+            // Half floats have plenty of range and precision for HDR images, and take half the memory of floats
+            logger->verbose("Loading image %s as RGBA16f HDR", texture_name);
             auto* data = stbi_loadf(full_texture_path_string.c_str(), &raw_width, &raw_height, &num_components, 0);
             if(data != nullptr) {
-                format = renderer::TextureFormat::Rgba32F;
-                texture_data = copy_and_pad_texture_data(data, raw_width, raw_height, num_components);
+                const auto num_pixels = static_cast<Size>(raw_width) * raw_height;
+                auto* pixels = new Uint16[num_pixels * 4];
+                expand_to_rgba16f(data, num_components, num_pixels, pixels);
                 stbi_image_free(data);
+
+                format = renderer::TextureFormat::Rgba16F;
+                texture_data = pixels;
             }
 
         } else {
             logger->verbose("Loading image %s as RGBA8 LDR", texture_name);
             auto* data = stbi_load(full_texture_path_string.c_str(), &raw_width, &raw_height, &num_components, 0);
             if(data != nullptr) {
-                format = renderer::TextureFormat::Rgba8;
-                texture_data = copy_and_pad_texture_data(data, raw_width, raw_height, num_components);
+                const auto num_pixels = static_cast<Size>(raw_width) * raw_height;
+                auto* pixels = new Uint8[num_pixels * 4];
+                expand_to_rgba8(data, num_components, num_pixels, pixels);
                 stbi_image_free(data);
+
+                format = renderer::TextureFormat::Rgba8;
+                texture_data = pixels;
             }
         }
 
@@ -66,57 +71,40 @@ namespace sanity::engine {
     Rx::Optional<renderer::TextureHandle> load_texture_to_gpu(const std::filesystem::path& texture_name, renderer::Renderer& renderer) {
         ZoneScoped;
 
+        const auto texture_name_string = texture_name.string();
+
+        if(TextureContainer container; load_texture_container(texture_name, container)) {
+            // The container's data is already laid out for the GPU, so it only needs one copy into the staging buffer
+            return renderer.create_texture(container.get_create_info(texture_name_string.c_str()), container.get_placed_data());
+        }
+
         Uint32 width, height;
         renderer::TextureFormat format;
-        const auto* pixels = load_texture(texture_name, width, height, format);
+        auto* pixels = load_texture(texture_name, width, height, format);
         if(pixels == nullptr) {
             return Rx::nullopt;
         }
 
-        const auto texture_name_string = texture_name.string();
         const auto create_info = renderer::TextureCreateInfo{.name = texture_name_string.c_str(),
                                                              .usage = renderer::TextureUsage::SampledTexture,
                                                              .format = format,
                                                              .width = width,
                                                              .height = height};
-        return renderer.create_texture(create_info, pixels);
-    }
+        const auto handle = renderer.create_texture(create_info, pixels);
 
-    constexpr const Uint64 DESIRED_NUM_COMPONENTS = 4;
+        // create_texture copied the pixels into a staging buffer, so we're done with them
+        free_texture_data(pixels, format);
 
-    template <typename ComponentDataType>
-    ComponentDataType* copy_and_pad_texture_data(ComponentDataType* original_data,
-                                                 const Uint32 width,
-                                                 const Uint32 height,
-                                                 const Uint32 original_num_components) {
-        ZoneScoped;
-
-        const auto num_pixels = static_cast<Size>(width) * height;
-
-        auto* pixels = new ComponentDataType[num_pixels * DESIRED_NUM_COMPONENTS];
+        return handle;
+    }
 
-        if(original_num_components == DESIRED_NUM_COMPONENTS) {
-            memcpy(pixels, original_data, num_pixels * DESIRED_NUM_COMPONENTS * sizeof(ComponentDataType));
+    void free_texture_data(void* pixels, const renderer::TextureFormat format) {
+        // load_texture allocated the pixels as an array of their component type
+        if(format == renderer::TextureFormat::Rgba16F) {
+            delete[] static_cast<Uint16*>(pixels);
 
         } else {
-            for(Uint32 i = 0; i < num_pixels; i++) {
-                const auto read_idx = i * original_num_components;
-                const auto write_idx = i * DESIRED_NUM_COMPONENTS;
-
-                pixels[write_idx] = original_data[read_idx];
-                pixels[write_idx + 1] = original_data[read_idx + 1];
-                pixels[write_idx + 2] = original_data[read_idx + 2];
-
-                if(original_num_components == DESIRED_NUM_COMPONENTS) {
-                    pixels[write_idx + 3] = original_data[read_idx + 3];
-
-                } else {
-                    pixels[write_idx + 3] = 0xFF;
-                }
-            }
+            delete[] static_cast<Uint8*>(pixels);
         }
-
-        return pixels;
     }
-
 } // namespace sanity::engine
@@ -11,7 +11,19 @@ namespace sanity::engine {
         class Renderer;
     }
 
+    /*!
+     * \brief Decodes an image and pads it to four components per pixel. Does not touch the renderer, so it may be called from any thread
+     *
+     * LDR images are returned as RGBA8, HDR images as RGBA16F
+     *
+     * \return The image's pixels, which must be freed with `free_texture_data`, or `nullptr` if the image could not be loaded
+     */
     void* load_texture(const std::filesystem::path& texture_name, Uint32& width, Uint32& height, renderer::TextureFormat& format);
 
+    /*!
+     * \brief Frees pixels which `load_texture` returned
+     */
+    void free_texture_data(void* pixels, renderer::TextureFormat format);
+
     Rx::Optional<renderer::TextureHandle> load_texture_to_gpu(const std::filesystem::path& texture_name, renderer::Renderer& renderer);
 } // namespace sanity::engine
@@ -0,0 +1,400 @@
+#include "mesh_optimization.hpp"
+
+#include <algorithm>
+
+#include "Tracy.hpp"
+#include "glm/geometric.hpp"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief A FIFO vertex cache, simulated with the time each vertex last entered the cache
+     */
+    class VertexCacheSimulator {
+    public:
+        VertexCacheSimulator(const Uint32 num_vertices, const Uint32 cache_size_in) : cache_size{cache_size_in} {
+            entry_times.resize(num_vertices, 0);
+            flush();
+        }
+
+        /*!
+         * \brief Uses a vertex, adding it to the cache if it isn't there
+         *
+         * \return true if the vertex had to be transformed
+         */
+        bool use(const Uint32 vertex) {
+            if(time - entry_times[vertex] > cache_size) {
+                entry_times[vertex] = time;
+                time++;
+                return true;
+            }
+
+            return false;
+        }
+
+        [[nodiscard]] bool is_in_cache(const Uint32 vertex) const { return time - entry_times[vertex] <= cache_size; }
+
+        /*!
+         * \brief How many vertices entered the cache after this one. Only meaningful if the vertex is in the cache
+         */
+        [[nodiscard]] Uint32 get_age(const Uint32 vertex) const { return time - entry_times[vertex]; }
+
+        /*!
+         * \brief Empties the cache
+         */
+        void flush() { time += cache_size + 1; }
+
+    private:
+        Uint32 cache_size;
+
+        Rx::Vector<Uint32> entry_times;
+
+        Uint32 time{0};
+    };
+
+    Float32 VertexCacheStatistics::get_acmr() const {
+        return num_triangles > 0 ? static_cast<Float32>(num_transformed_vertices) / static_cast<Float32>(num_triangles) : 0;
+    }
+
+    Float32 VertexCacheStatistics::get_atvr() const {
+        return num_vertices > 0 ? static_cast<Float32>(num_transformed_vertices) / static_cast<Float32>(num_vertices) : 0;
+    }
+
+    VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& other) {
+        num_transformed_vertices += other.num_transformed_vertices;
+        num_triangles += other.num_triangles;
+        num_vertices += other.num_vertices;
+
+        return *this;
+    }
+
+    VertexCacheStatistics analyze_vertex_cache(const Rx::Vector<Uint32>& indices, const Uint32 num_vertices, const Uint32 cache_size) {
+        ZoneScoped;
+
+        auto statistics = VertexCacheStatistics{.num_triangles = indices.size() / 3, .num_vertices = num_vertices};
+
+        VertexCacheSimulator cache{num_vertices, cache_size};
+        for(Size i = 0; i < indices.size(); i++) {
+            if(cache.use(indices[i])) {
+                statistics.num_transformed_vertices++;
+            }
+        }
+
+        return statistics;
+    }
+
+    Rx::Vector<Uint32> optimize_vertex_cache(const Rx::Vector<Uint32>& indices,
+                                             const Uint32 num_vertices,
+                                             Rx::Vector<Uint32>* clusters,
+                                             const Uint32 cache_size) {
+        ZoneScoped;
+
+        const auto num_triangles = static_cast<Uint32>(indices.size() / 3);
+
+        // Triangles which use each vertex, and how many of them haven't been emitted yet
+        Rx::Vector<Uint32> num_live_triangles;
+        num_live_triangles.resize(num_vertices, 0);
+        for(Size i = 0; i < indices.size(); i++) {
+            num_live_triangles[indices[i]]++;
+        }
+
+        Rx::Vector<Uint32> adjacency_offsets;
+        adjacency_offsets.resize(num_vertices + 1, 0);
+        for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+            adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + num_live_triangles[vertex];
+        }
+
+        Rx::Vector<Uint32> adjacency;
+        adjacency.resize(indices.size());
+
+        auto adjacency_ends = adjacency_offsets;
+        for(Uint32 triangle = 0; triangle < num_triangles; triangle++) {
+            for(Uint32 corner = 0; corner < 3; corner++) {
+                const auto vertex = indices[triangle * 3 + corner];
+                adjacency[adjacency_ends[vertex]] = triangle;
+                adjacency_ends[vertex]++;
+            }
+        }
+
+        Rx::Vector<Uint8> is_emitted;
+        is_emitted.resize(num_triangles, 0);
+
+        // Vertices of recently emitted triangles, to go back to when Tipsify runs out of good candidates
+        Rx::Vector<Uint32> dead_end_stack;
+        dead_end_stack.reserve(indices.size());
+
+        Uint32 next_input_vertex{0};
+
+        const auto skip_dead_end = [&]() -> Int64 {
+            while(!dead_end_stack.is_empty()) {
+                const auto vertex = dead_end_stack.last();
+                dead_end_stack.pop_back();
+
+                if(num_live_triangles[vertex] > 0) {
+                    return vertex;
+                }
+            }
+
+            while(next_input_vertex < num_vertices) {
+                if(num_live_triangles[next_input_vertex] > 0) {
+                    return next_input_vertex;
+                }
+
+                next_input_vertex++;
+            }
+
+            return -1;
+        };
+
+        Rx::Vector<Uint32> optimized_indices;
+        optimized_indices.reserve(indices.size());
+
+        VertexCacheSimulator cache{num_vertices, cache_size};
+        Rx::Vector<Uint32> candidates;
+
+        auto fanning_vertex = skip_dead_end();
+        if(clusters != nullptr && fanning_vertex >= 0) {
+            clusters->push_back(0);
+        }
+
+        while(fanning_vertex >= 0) {
+            // Emit all the remaining triangles around the fanning vertex
+            candidates.clear();
+
+            const auto vertex = static_cast<Uint32>(fanning_vertex);
+            for(auto i = adjacency_offsets[vertex]; i < adjacency_offsets[vertex + 1]; i++) {
+                const auto triangle = adjacency[i];
+                if(is_emitted[triangle] != 0) {
+                    continue;
+                }
+
+                for(Uint32 corner = 0; corner < 3; corner++) {
+                    const auto corner_vertex = indices[triangle * 3 + corner];
+                    optimized_indices.push_back(corner_vertex);
+                    dead_end_stack.push_back(corner_vertex);
+                    candidates.push_back(corner_vertex);
+
+                    num_live_triangles[corner_vertex]--;
+                    cache.use(corner_vertex);
+                }
+
+                is_emitted[triangle] = 1;
+            }
+
+            // Fan around the vertex that has been in the cache longest, but will still be in the cache after all its triangles are emitted
+            Int64 best_candidate{-1};
+            Int64 best_priority{-1};
+            for(Size i = 0; i < candidates.size(); i++) {
+                const auto candidate = candidates[i];
+                if(num_live_triangles[candidate] == 0) {
+                    continue;
+                }
+
+                Int64 priority{0};
+                if(cache.is_in_cache(candidate) && cache.get_age(candidate) + 2 * num_live_triangles[candidate] <= cache_size) {
+                    priority = cache.get_age(candidate);
+                }
+
+                if(priority > best_priority) {
+                    best_candidate = candidate;
+                    best_priority = priority;
+                }
+            }
+
+            if(best_candidate < 0) {
+                // Dead end. Jump somewhere else in the mesh, which starts a new cluster
+                best_candidate = skip_dead_end();
+                if(clusters != nullptr && best_candidate >= 0) {
+                    clusters->push_back(static_cast<Uint32>(optimized_indices.size() / 3));
+                }
+            }
+
+            fanning_vertex = best_candidate;
+        }
+
+        return optimized_indices;
+    }
+
+    Rx::Vector<Uint32> optimize_overdraw(const Rx::Vector<Uint32>& indices,
+                                         const Rx::Vector<renderer::StandardVertex>& vertices,
+                                         const Rx::Vector<Uint32>& clusters,
+                                         const Float32 threshold,
+                                         const Uint32 cache_size) {
+        ZoneScoped;
+
+        const auto num_triangles = static_cast<Uint32>(indices.size() / 3);
+        const auto num_vertices = static_cast<Uint32>(vertices.size());
+
+        const auto get_cluster_end = [&](const Rx::Vector<Uint32>& cluster_starts, const Size cluster_idx) {
+            return cluster_idx + 1 < cluster_starts.size() ? cluster_starts[cluster_idx + 1] : num_triangles;
+        };
+
+        VertexCacheSimulator cache{num_vertices, cache_size};
+        const auto count_transforms = [&](const Uint32 triangle) {
+            Uint32 num_transforms{0};
+            for(Uint32 corner = 0; corner < 3; corner++) {
+                num_transforms += cache.use(indices[triangle * 3 + corner]) ? 1 : 0;
+            }
+
+            return num_transforms;
+        };
+
+        // Split each cluster wherever the part of the cluster before the split has an ACMR within the threshold of the whole cluster's
+        Rx::Vector<Uint32> split_clusters;
+        split_clusters.reserve(clusters.size());
+        for(Size cluster_idx = 0; cluster_idx < clusters.size(); cluster_idx++) {
+            const auto start = clusters[cluster_idx];
+            const auto end = get_cluster_end(clusters, cluster_idx);
+
+            cache.flush();
+            Uint32 cluster_transforms{0};
+            for(auto triangle = start; triangle < end; triangle++) {
+                cluster_transforms += count_transforms(triangle);
+            }
+
+            const auto acmr_threshold = threshold * static_cast<Float32>(cluster_transforms) / static_cast<Float32>(end - start);
+
+            cache.flush();
+            split_clusters.push_back(start);
+
+            Uint32 num_transforms{0};
+            Uint32 num_cluster_triangles{0};
+            for(auto triangle = start; triangle < end; triangle++) {
+                num_transforms += count_transforms(triangle);
+                num_cluster_triangles++;
+
+                const auto acmr_so_far = static_cast<Float32>(num_transforms) / static_cast<Float32>(num_cluster_triangles);
+                if(triangle + 1 < end && acmr_so_far <= acmr_threshold) {
+                    split_clusters.push_back(triangle + 1);
+
+                    cache.flush();
+                    num_transforms = 0;
+                    num_cluster_triangles = 0;
+                }
+            }
+        }
+
+        // Sort the clusters by how far from the mesh's center they are, in the direction they face. Those clusters are the most likely to
+        // cover other parts of the mesh. Vertex normals point out of the mesh however the triangles are wound, so they say which way each
+        // triangle faces
+        const auto get_triangle = [&](const Uint32 triangle, glm::vec3& centroid, glm::vec3& normal) {
+            const auto& a = vertices[indices[triangle * 3]];
+            const auto& b = vertices[indices[triangle * 3 + 1]];
+            const auto& c = vertices[indices[triangle * 3 + 2]];
+
+            const auto area = glm::length(glm::cross(b.location - a.location, c.location - a.location)) * 0.5f;
+            centroid = (a.location + b.location + c.location) / 3.0f;
+            normal = a.normal + b.normal + c.normal;
+
+            return area;
+        };
+
+        auto mesh_centroid = glm::vec3{0};
+        Float32 mesh_area{0};
+        for(Uint32 triangle = 0; triangle < num_triangles; triangle++) {
+            glm::vec3 centroid;
+            glm::vec3 normal;
+            const auto area = get_triangle(triangle, centroid, normal);
+            mesh_centroid += centroid * area;
+            mesh_area += area;
+        }
+
+        if(mesh_area > 0) {
+            mesh_centroid /= mesh_area;
+        }
+
+        Rx::Vector<Float32> sort_keys;
+        sort_keys.reserve(split_clusters.size());
+        for(Size cluster_idx = 0; cluster_idx < split_clusters.size(); cluster_idx++) {
+            auto cluster_centroid = glm::vec3{0};
+            auto cluster_normal = glm::vec3{0};
+            Float32 cluster_area{0};
+            for(auto triangle = split_clusters[cluster_idx]; triangle < get_cluster_end(split_clusters, cluster_idx); triangle++) {
+                glm::vec3 centroid;
+                glm::vec3 normal;
+                const auto area = get_triangle(triangle, centroid, normal);
+                cluster_centroid += centroid * area;
+                cluster_normal += normal * area;
+                cluster_area += area;
+            }
+
+            if(cluster_area > 0 && glm::length(cluster_normal) > 0) {
+                cluster_centroid /= cluster_area;
+                sort_keys.push_back(glm::dot(cluster_centroid - mesh_centroid, glm::normalize(cluster_normal)));
+
+            } else {
+                sort_keys.push_back(0);
+            }
+        }
+
+        Rx::Vector<Uint32> cluster_order;
+        cluster_order.resize(split_clusters.size());
+        for(Uint32 i = 0; i < cluster_order.size(); i++) {
+            cluster_order[i] = i;
+        }
+
+        std::stable_sort(cluster_order.data(),
+                         cluster_order.data() + cluster_order.size(),
+                         [&](const Uint32 lhs, const Uint32 rhs) { return sort_keys[lhs] > sort_keys[rhs]; });
+
+        Rx::Vector<Uint32> optimized_indices;
+        optimized_indices.reserve(indices.size());
+        for(Size i = 0; i < cluster_order.size(); i++) {
+            const auto cluster_idx = cluster_order[i];
+            for(auto triangle = split_clusters[cluster_idx]; triangle < get_cluster_end(split_clusters, cluster_idx); triangle++) {
+                optimized_indices.push_back(indices[triangle * 3]);
+                optimized_indices.push_back(indices[triangle * 3 + 1]);
+                optimized_indices.push_back(indices[triangle * 3 + 2]);
+            }
+        }
+
+        return optimized_indices;
+    }
+
+    void optimize_vertex_fetch(Rx::Vector<renderer::StandardVertex>& vertices, Rx::Vector<Uint32>& indices) {
+        ZoneScoped;
+
+        constexpr auto UNUSED_VERTEX = 0xFFFFFFFF;
+
+        Rx::Vector<Uint32> new_vertex_indices;
+        new_vertex_indices.resize(vertices.size(), UNUSED_VERTEX);
+
+        Rx::Vector<renderer::StandardVertex> optimized_vertices;
+        optimized_vertices.reserve(vertices.size());
+
+        for(Size i = 0; i < indices.size(); i++) {
+            auto& new_vertex_index = new_vertex_indices[indices[i]];
+            if(new_vertex_index == UNUSED_VERTEX) {
+                new_vertex_index = static_cast<Uint32>(optimized_vertices.size());
+                optimized_vertices.push_back(vertices[indices[i]]);
+            }
+
+            indices[i] = new_vertex_index;
+        }
+
+        vertices = Rx::Utility::move(optimized_vertices);
+    }
+
+    bool optimize_mesh(Rx::Vector<renderer::StandardVertex>& vertices, Rx::Vector<Uint32>& indices) {
+        ZoneScoped;
+
+        if(indices.is_empty() || indices.size() % 3 != 0) {
+            return false;
+        }
+
+        const auto num_vertices = static_cast<Uint32>(vertices.size());
+        for(Size i = 0; i < indices.size(); i++) {
+            if(indices[i] >= num_vertices) {
+                return false;
+            }
+        }
+
+        Rx::Vector<Uint32> clusters;
+        const auto cache_optimized_indices = optimize_vertex_cache(indices, num_vertices, &clusters);
+        indices = optimize_overdraw(cache_optimized_indices, vertices, clusters);
+
+        optimize_vertex_fetch(vertices, indices);
+
+        return true;
+    }
+} // namespace sanity::engine
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief Number of entries in the FIFO post-transform vertex cache that the optimizations target and the statistics simulate
+     */
+    constexpr Uint32 VERTEX_CACHE_SIZE = 16;
+
+    /*!
+     * \brief How well a triangle list uses a FIFO post-transform vertex cache
+     */
+    struct VertexCacheStatistics {
+        /*!
+         * \brief Number of times a vertex had to be transformed because it wasn't in the cache
+         */
+        Uint64 num_transformed_vertices{0};
+
+        Uint64 num_triangles{0};
+
+        Uint64 num_vertices{0};
+
+        /*!
+         * \brief Average cache miss ratio: transformed vertices per triangle. 3 is the worst case, and about 0.5 is the best a regular grid
+         * can get
+         */
+        [[nodiscard]] Float32 get_acmr() const;
+
+        /*!
+         * \brief Average transform to vertex ratio: transformed vertices per vertex. 1 is perfect
+         */
+        [[nodiscard]] Float32 get_atvr() const;
+
+        VertexCacheStatistics& operator+=(const VertexCacheStatistics& other);
+    };
+
+    /*!
+     * \brief Simulates a FIFO vertex cache running over a triangle list
+     */
+    [[nodiscard]] VertexCacheStatistics analyze_vertex_cache(const Rx::Vector<Uint32>& indices,
+                                                             Uint32 num_vertices,
+                                                             Uint32 cache_size = VERTEX_CACHE_SIZE);
+
+    /*!
+     * \brief Reorders the triangles of a triangle list so that the GPU's post-transform vertex cache hits as often as possible, using
+     * Tipsify (Sander, Nehab, and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+     *
+     * Triangles keep their winding order. All the indices must be less than `num_vertices`
+     *
+     * \param clusters If this isn't nullptr, it gets the index of the first triangle of each run of triangles which Tipsify emitted
+     * without jumping to a far away part of the mesh. optimize_overdraw reorders those runs
+     *
+     * \return The reordered indices
+     */
+    [[nodiscard]] Rx::Vector<Uint32> optimize_vertex_cache(const Rx::Vector<Uint32>& indices,
+                                                           Uint32 num_vertices,
+                                                           Rx::Vector<Uint32>* clusters = nullptr,
+                                                           Uint32 cache_size = VERTEX_CACHE_SIZE);
+
+    /*!
+     * \brief Reorders the clusters of a triangle list that optimize_vertex_cache made, so that the clusters which are most likely to
+     * occlude the rest of the mesh are drawn first
+     *
+     * Clusters get split further where that costs little vertex cache efficiency, then sorted by how far out of the mesh they face
+     *
+     * \param threshold How much worse the ACMR of each cluster may get from splitting it. 1.05 allows 5% more vertex transforms
+     *
+     * \return The reordered indices
+     */
+    [[nodiscard]] Rx::Vector<Uint32> optimize_overdraw(const Rx::Vector<Uint32>& indices,
+                                                       const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                       const Rx::Vector<Uint32>& clusters,
+                                                       Float32 threshold = 1.05f,
+                                                       Uint32 cache_size = VERTEX_CACHE_SIZE);
+
+    /*!
+     * \brief Reorders vertices into the order the indices first use them, so that the GPU fetches them from memory sequentially
+     *
+     * Vertices which no index uses are removed. The indices are rewritten to point at the reordered vertices
+     */
+    void optimize_vertex_fetch(Rx::Vector<renderer::StandardVertex>& vertices, Rx::Vector<Uint32>& indices);
+
+    /*!
+     * \brief Runs optimize_vertex_cache, optimize_overdraw, and optimize_vertex_fetch on a mesh
+     *
+     * \return false if the mesh isn't a valid triangle list, in which case it's left as it is
+     */
+    bool optimize_mesh(Rx::Vector<renderer::StandardVertex>& vertices, Rx::Vector<Uint32>& indices);
+} // namespace sanity::engine
@@ -0,0 +1,736 @@
+#include "mesh_simplification.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "Tracy.hpp"
+#include "glm/geometric.hpp"
+#include "loading/mesh_optimization.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief Weight of the planes that keep border vertices on the border, relative to the planes of the mesh's triangles
+     */
+    constexpr Float32 BORDER_PLANE_WEIGHT = 2.0f;
+
+    /*!
+     * \brief A LOD with more than this fraction of the indices of the LOD before it isn't worth having, and ends the LOD chain
+     */
+    constexpr Float32 MAX_LOD_INDEX_RATIO = 0.9f;
+
+    enum class VertexKind : Uint8 {
+        /*!
+         * \brief Inside the mesh. May collapse onto any of its neighbours
+         */
+        Manifold,
+
+        /*!
+         * \brief On a border of the mesh. May only collapse along the border
+         */
+        Border,
+
+        /*!
+         * \brief One of the two vertices on either side of a seam, such as a UV seam or a hard edge. May only collapse along the seam, and
+         * its twin on the other side of the seam collapses with it
+         */
+        Seam,
+
+        /*!
+         * \brief Where seams meet or end, or somewhere with topology that's too complex to collapse safely
+         */
+        Locked,
+    };
+
+    /*!
+     * \brief Weighted sum of the squared distances from a point to a set of planes
+     */
+    struct Quadric {
+        // Symmetric 3x3 matrix
+
+        Float32 a00{0};
+        Float32 a11{0};
+        Float32 a22{0};
+        Float32 a10{0};
+        Float32 a20{0};
+        Float32 a21{0};
+
+        Float32 b0{0};
+        Float32 b1{0};
+        Float32 b2{0};
+
+        Float32 c{0};
+
+        /*!
+         * \brief Sum of the weights of the planes
+         */
+        Float32 weight{0};
+
+        /*!
+         * \brief Adds the plane of points p where dot(normal, p) + distance = 0
+         */
+        void add_plane(const glm::vec3& normal, const Float32 distance, const Float32 plane_weight) {
+            a00 += plane_weight * normal.x * normal.x;
+            a11 += plane_weight * normal.y * normal.y;
+            a22 += plane_weight * normal.z * normal.z;
+            a10 += plane_weight * normal.y * normal.x;
+            a20 += plane_weight * normal.z * normal.x;
+            a21 += plane_weight * normal.z * normal.y;
+
+            b0 += plane_weight * normal.x * distance;
+            b1 += plane_weight * normal.y * distance;
+            b2 += plane_weight * normal.z * distance;
+
+            c += plane_weight * distance * distance;
+
+            weight += plane_weight;
+        }
+
+        Quadric& operator+=(const Quadric& other) {
+            a00 += other.a00;
+            a11 += other.a11;
+            a22 += other.a22;
+            a10 += other.a10;
+            a20 += other.a20;
+            a21 += other.a21;
+
+            b0 += other.b0;
+            b1 += other.b1;
+            b2 += other.b2;
+
+            c += other.c;
+
+            weight += other.weight;
+
+            return *this;
+        }
+
+        [[nodiscard]] Float32 evaluate(const glm::vec3& p) const {
+            const auto rx = a00 * p.x + a10 * p.y + a20 * p.z;
+            const auto ry = a10 * p.x + a11 * p.y + a21 * p.z;
+            const auto rz = a20 * p.x + a21 * p.y + a22 * p.z;
+
+            const auto error = p.x * rx + p.y * ry + p.z * rz + 2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+
+            // Rounding can push the error of a point that's on all the planes slightly below zero
+            return glm::abs(error);
+        }
+    };
+
+    struct EdgeCollapse {
+        Uint32 from;
+
+        Uint32 to;
+
+        /*!
+         * \brief Mean squared distance that the collapse moves the surface by
+         */
+        Float32 error;
+    };
+
+    /*!
+     * \return For each vertex, the first vertex with the same location
+     */
+    static Rx::Vector<Uint32> get_location_ids(const Rx::Vector<glm::vec3>& locations) {
+        Rx::Vector<Uint32> sorted_vertices;
+        sorted_vertices.resize(locations.size());
+        for(Uint32 i = 0; i < sorted_vertices.size(); i++) {
+            sorted_vertices[i] = i;
+        }
+
+        std::sort(sorted_vertices.data(), sorted_vertices.data() + sorted_vertices.size(), [&](const Uint32 a, const Uint32 b) {
+            const auto& location_a = locations[a];
+            const auto& location_b = locations[b];
+            if(location_a.x != location_b.x) {
+                return location_a.x < location_b.x;
+            }
+            if(location_a.y != location_b.y) {
+                return location_a.y < location_b.y;
+            }
+            if(location_a.z != location_b.z) {
+                return location_a.z < location_b.z;
+            }
+
+            return a < b;
+        });
+
+        Rx::Vector<Uint32> location_ids;
+        location_ids.resize(locations.size());
+        for(Size i = 0; i < sorted_vertices.size(); i++) {
+            const auto vertex = sorted_vertices[i];
+            const auto has_same_location = i > 0 && locations[sorted_vertices[i - 1]].x == locations[vertex].x &&
+                                           locations[sorted_vertices[i - 1]].y == locations[vertex].y &&
+                                           locations[sorted_vertices[i - 1]].z == locations[vertex].z;
+            location_ids[vertex] = has_same_location ? location_ids[sorted_vertices[i - 1]] : vertex;
+        }
+
+        return location_ids;
+    }
+
+    /*!
+     * \brief The vertices at each location, so that the vertices at a location can be found from its location id
+     */
+    struct LocationVertices {
+        /*!
+         * \brief Index in `vertices` of the first vertex at each location id. Ids which aren't location ids have no vertices
+         */
+        Rx::Vector<Uint32> first_vertex;
+
+        Rx::Vector<Uint32> vertices;
+    };
+
+    static LocationVertices get_location_vertices(const Rx::Vector<Uint32>& location_ids) {
+        const auto num_vertices = static_cast<Uint32>(location_ids.size());
+
+        LocationVertices location_vertices;
+        location_vertices.first_vertex.resize(num_vertices + 1, 0);
+        for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+            location_vertices.first_vertex[location_ids[vertex] + 1]++;
+        }
+        for(Uint32 location = 0; location < num_vertices; location++) {
+            location_vertices.first_vertex[location + 1] += location_vertices.first_vertex[location];
+        }
+
+        location_vertices.vertices.resize(num_vertices);
+        auto next_vertex = location_vertices.first_vertex;
+        for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+            location_vertices.vertices[next_vertex[location_ids[vertex]]++] = vertex;
+        }
+
+        return location_vertices;
+    }
+
+    static Uint64 get_edge_key(const Uint32 from, const Uint32 to) { return (static_cast<Uint64>(from) << 32) | to; }
+
+    /*!
+     * \return The directed edges of every triangle, between the ids that `get_id` gives their vertices, sorted so that they can be
+     * searched
+     */
+    template <typename IdFunction>
+    static Rx::Vector<Uint64> get_sorted_edges(const Rx::Vector<Uint32>& indices, IdFunction&& get_id) {
+        Rx::Vector<Uint64> edges;
+        edges.reserve(indices.size());
+        for(Size triangle = 0; triangle < indices.size(); triangle += 3) {
+            for(Size corner = 0; corner < 3; corner++) {
+                const auto from = get_id(indices[triangle + corner]);
+                const auto to = get_id(indices[triangle + (corner + 1) % 3]);
+                edges.push_back(get_edge_key(from, to));
+            }
+        }
+
+        std::sort(edges.data(), edges.data() + edges.size());
+
+        return edges;
+    }
+
+    /*!
+     * \brief Edges between the location ids of the vertices, which tell where the borders of the surface are
+     */
+    static Rx::Vector<Uint64> get_sorted_location_edges(const Rx::Vector<Uint32>& indices, const Rx::Vector<Uint32>& location_ids) {
+        return get_sorted_edges(indices, [&](const Uint32 vertex) { return location_ids[vertex]; });
+    }
+
+    /*!
+     * \brief Edges between the vertices themselves, which tell where the seams are
+     */
+    static Rx::Vector<Uint64> get_sorted_vertex_edges(const Rx::Vector<Uint32>& indices) {
+        return get_sorted_edges(indices, [](const Uint32 vertex) { return vertex; });
+    }
+
+    static bool has_edge(const Rx::Vector<Uint64>& sorted_edges, const Uint32 from, const Uint32 to) {
+        return std::binary_search(sorted_edges.data(), sorted_edges.data() + sorted_edges.size(), get_edge_key(from, to));
+    }
+
+    /*!
+     * \brief Checks if an edge has a triangle on only one side, that is, if no triangle has the edge in the opposite direction
+     */
+    static bool is_border_edge(const Rx::Vector<Uint64>& sorted_edges, const Uint32 from, const Uint32 to) {
+        return !has_edge(sorted_edges, to, from);
+    }
+
+    /*!
+     * \brief Checks if an edge between two vertices is part of a seam: there's a triangle on its other side, but that triangle uses other
+     * vertices at the same locations
+     */
+    static bool is_seam_edge(const Rx::Vector<Uint64>& sorted_location_edges,
+                             const Rx::Vector<Uint64>& sorted_vertex_edges,
+                             const Rx::Vector<Uint32>& location_ids,
+                             const Uint32 from,
+                             const Uint32 to) {
+        return is_border_edge(sorted_vertex_edges, from, to) &&
+               !is_border_edge(sorted_location_edges, location_ids[from], location_ids[to]);
+    }
+
+    /*!
+     * \param twins Gets the vertex on the other side of the seam of each seam vertex
+     */
+    static Rx::Vector<VertexKind> classify_vertices(const Rx::Vector<Uint32>& indices,
+                                                    const Rx::Vector<Uint32>& location_ids,
+                                                    const LocationVertices& location_vertices,
+                                                    Rx::Vector<Uint32>& twins) {
+        const auto num_vertices = location_ids.size();
+
+        const auto location_edges = get_sorted_location_edges(indices, location_ids);
+        const auto vertex_edges = get_sorted_vertex_edges(indices);
+
+        Rx::Vector<Uint32> num_border_edges;
+        num_border_edges.resize(num_vertices, 0);
+        for(Size i = 0; i < location_edges.size(); i++) {
+            const auto from = static_cast<Uint32>(location_edges[i] >> 32);
+            const auto to = static_cast<Uint32>(location_edges[i] & 0xFFFFFFFF);
+            if(is_border_edge(location_edges, from, to)) {
+                num_border_edges[from]++;
+                num_border_edges[to]++;
+            }
+        }
+
+        // Seam edges going out of and coming into each vertex
+        Rx::Vector<Uint32> num_outgoing_seam_edges;
+        num_outgoing_seam_edges.resize(num_vertices, 0);
+        Rx::Vector<Uint32> num_incoming_seam_edges;
+        num_incoming_seam_edges.resize(num_vertices, 0);
+        for(Size i = 0; i < vertex_edges.size(); i++) {
+            const auto from = static_cast<Uint32>(vertex_edges[i] >> 32);
+            const auto to = static_cast<Uint32>(vertex_edges[i] & 0xFFFFFFFF);
+            if(is_seam_edge(location_edges, vertex_edges, location_ids, from, to)) {
+                num_outgoing_seam_edges[from]++;
+                num_incoming_seam_edges[to]++;
+            }
+        }
+
+        twins.clear();
+        twins.resize(num_vertices, 0);
+
+        Rx::Vector<VertexKind> kinds;
+        kinds.resize(num_vertices, VertexKind::Locked);
+        for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+            const auto location = location_ids[vertex];
+            const auto first_vertex_at_location = location_vertices.first_vertex[location];
+            const auto num_vertices_at_location = location_vertices.first_vertex[location + 1] - first_vertex_at_location;
+
+            if(num_vertices_at_location == 1) {
+                // A vertex on a simple border has one border edge coming in and one going out
+                if(num_border_edges[location] == 0) {
+                    kinds[vertex] = VertexKind::Manifold;
+
+                } else if(num_border_edges[location] == 2) {
+                    kinds[vertex] = VertexKind::Border;
+                }
+
+            } else if(num_vertices_at_location == 2 && num_border_edges[location] == 0) {
+                // The middle of a seam has two vertices, each with one seam edge coming in and one going out. Vertices where seams cross
+                // or end have more or fewer
+                const auto twin = location_vertices.vertices[first_vertex_at_location] == vertex
+                                      ? location_vertices.vertices[first_vertex_at_location + 1]
+                                      : location_vertices.vertices[first_vertex_at_location];
+                if(num_outgoing_seam_edges[vertex] == 1 && num_incoming_seam_edges[vertex] == 1 && num_outgoing_seam_edges[twin] == 1 &&
+                   num_incoming_seam_edges[twin] == 1) {
+                    kinds[vertex] = VertexKind::Seam;
+                    twins[vertex] = twin;
+                }
+            }
+        }
+
+        return kinds;
+    }
+
+    /*!
+     * \brief Makes the quadric of each location from the planes of the triangles around it, plus planes that keep borders and seams where
+     * they are
+     */
+    static Rx::Vector<Quadric> make_quadrics(const Rx::Vector<glm::vec3>& locations,
+                                             const Rx::Vector<Uint32>& indices,
+                                             const Rx::Vector<Uint32>& location_ids) {
+        const auto vertex_edges = get_sorted_vertex_edges(indices);
+
+        Rx::Vector<Quadric> quadrics;
+        quadrics.resize(locations.size());
+
+        for(Size triangle = 0; triangle < indices.size(); triangle += 3) {
+            const auto& p0 = locations[indices[triangle]];
+            const auto& p1 = locations[indices[triangle + 1]];
+            const auto& p2 = locations[indices[triangle + 2]];
+
+            auto normal = glm::cross(p1 - p0, p2 - p0);
+            const auto double_area = glm::length(normal);
+            if(double_area <= 0.0f) {
+                continue;
+            }
+            normal /= double_area;
+
+            const auto distance = -glm::dot(normal, p0);
+            for(Size corner = 0; corner < 3; corner++) {
+                quadrics[location_ids[indices[triangle + corner]]].add_plane(normal, distance, double_area * 0.5f);
+            }
+
+            // Planes through each border and seam edge, perpendicular to the triangle. Seam edges get a plane from each side
+            for(Size corner = 0; corner < 3; corner++) {
+                const auto from = indices[triangle + corner];
+                const auto to = indices[triangle + (corner + 1) % 3];
+                if(!is_border_edge(vertex_edges, from, to)) {
+                    continue;
+                }
+
+                const auto edge = locations[to] - locations[from];
+                const auto edge_length = glm::length(edge);
+                if(edge_length <= 0.0f) {
+                    continue;
+                }
+
+                const auto border_normal = glm::normalize(glm::cross(edge, normal));
+                const auto border_distance = -glm::dot(border_normal, locations[from]);
+                const auto border_weight = edge_length * edge_length * BORDER_PLANE_WEIGHT;
+                quadrics[location_ids[from]].add_plane(border_normal, border_distance, border_weight);
+                quadrics[location_ids[to]].add_plane(border_normal, border_distance, border_weight);
+            }
+        }
+
+        return quadrics;
+    }
+
+    /*!
+     * \brief Finds where a seam vertex's twin goes when the seam vertex collapses along the seam: the vertex at the destination's location
+     * which the twin shares a seam edge with
+     *
+     * \return The twin's destination, or an empty optional if the twin has no seam edge to the destination's location
+     */
+    static Rx::Optional<Uint32> find_seam_destination(const Uint32 twin,
+                                                      const Uint32 to_location,
+                                                      const LocationVertices& location_vertices,
+                                                      const Rx::Vector<Uint64>& sorted_location_edges,
+                                                      const Rx::Vector<Uint64>& sorted_vertex_edges,
+                                                      const Rx::Vector<Uint32>& location_ids) {
+        for(auto i = location_vertices.first_vertex[to_location]; i < location_vertices.first_vertex[to_location + 1]; i++) {
+            const auto vertex = location_vertices.vertices[i];
+            const auto is_outgoing_seam_edge = has_edge(sorted_vertex_edges, twin, vertex) &&
+                                               is_seam_edge(sorted_location_edges, sorted_vertex_edges, location_ids, twin, vertex);
+            const auto is_incoming_seam_edge = has_edge(sorted_vertex_edges, vertex, twin) &&
+                                               is_seam_edge(sorted_location_edges, sorted_vertex_edges, location_ids, vertex, twin);
+            if(is_outgoing_seam_edge || is_incoming_seam_edge) {
+                return vertex;
+            }
+        }
+
+        return Rx::nullopt;
+    }
+
+    /*!
+     * \brief Checks if moving a vertex onto another vertex would turn any of the triangles around it over
+     *
+     * \param collapse_remap Where each vertex has collapsed to so far
+     */
+    static bool collapse_flips_triangles(const EdgeCollapse& collapse,
+                                         const Rx::Vector<glm::vec3>& locations,
+                                         const Rx::Vector<Uint32>& location_ids,
+                                         const Rx::Vector<Uint32>& indices,
+                                         const Rx::Vector<Uint32>& collapse_remap,
+                                         const Rx::Vector<Uint32>& first_vertex_triangle,
+                                         const Rx::Vector<Uint32>& vertex_triangles) {
+        const auto to_location_id = location_ids[collapse.to];
+
+        for(auto i = first_vertex_triangle[collapse.from]; i < first_vertex_triangle[collapse.from + 1]; i++) {
+            const auto triangle = vertex_triangles[i];
+            const Uint32 corners[3] = {collapse_remap[indices[triangle * 3]],
+                                       collapse_remap[indices[triangle * 3 + 1]],
+                                       collapse_remap[indices[triangle * 3 + 2]]};
+
+            Uint32 from_corner = 0;
+            while(from_corner < 2 && corners[from_corner] != collapse.from) {
+                from_corner++;
+            }
+
+            const auto other_0 = corners[(from_corner + 1) % 3];
+            const auto other_1 = corners[(from_corner + 2) % 3];
+
+            // Triangles with both vertices on the edge disappear, and triangles that an earlier collapse made degenerate are going away
+            // too
+            if(location_ids[other_0] == to_location_id || location_ids[other_1] == to_location_id ||
+               location_ids[other_0] == location_ids[other_1]) {
+                continue;
+            }
+
+            const auto& from_location = locations[collapse.from];
+            const auto& to_location = locations[collapse.to];
+            const auto old_normal = glm::cross(locations[other_0] - from_location, locations[other_1] - from_location);
+            const auto new_normal = glm::cross(locations[other_0] - to_location, locations[other_1] - to_location);
+            if(glm::dot(old_normal, new_normal) <= 0.0f) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    Rx::Vector<Uint32> simplify_mesh(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                     const Rx::Vector<Uint32>& indices,
+                                     const Uint32 target_num_indices,
+                                     const Float32 target_error,
+                                     Float32* result_error) {
+        ZoneScoped;
+
+        if(result_error != nullptr) {
+            *result_error = 0;
+        }
+
+        const auto num_vertices = static_cast<Uint32>(vertices.size());
+        if(indices.size() <= target_num_indices || indices.size() % 3 != 0 || num_vertices == 0) {
+            return indices;
+        }
+
+        for(Size i = 0; i < indices.size(); i++) {
+            if(indices[i] >= num_vertices) {
+                return indices;
+            }
+        }
+
+        // Work in a unit cube, so that errors are relative to the size of the mesh
+        auto min = vertices[0].location;
+        auto max = vertices[0].location;
+        for(Uint32 vertex = 1; vertex < num_vertices; vertex++) {
+            min = glm::min(min, vertices[vertex].location);
+            max = glm::max(max, vertices[vertex].location);
+        }
+
+        const auto size = glm::max(max.x - min.x, glm::max(max.y - min.y, max.z - min.z));
+        const auto scale = size > 0.0f ? 1.0f / size : 1.0f;
+
+        Rx::Vector<glm::vec3> locations;
+        locations.reserve(num_vertices);
+        for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+            locations.push_back((vertices[vertex].location - min) * scale);
+        }
+
+        const auto location_ids = get_location_ids(locations);
+        const auto location_vertices = get_location_vertices(location_ids);
+
+        Rx::Vector<Uint32> twins;
+        const auto kinds = classify_vertices(indices, location_ids, location_vertices, twins);
+        const auto has_seams = std::find(kinds.data(), kinds.data() + kinds.size(), VertexKind::Seam) != kinds.data() + kinds.size();
+        auto quadrics = make_quadrics(locations, indices, location_ids);
+
+        const auto get_collapse_error = [&](const Uint32 from, const Uint32 to) {
+            auto quadric = quadrics[location_ids[from]];
+            quadric += quadrics[location_ids[to]];
+            return quadric.weight > 0.0f ? quadric.evaluate(locations[to]) / quadric.weight : 0.0f;
+        };
+
+        const auto max_error = target_error * target_error;
+        auto largest_error = 0.0f;
+
+        auto simplified_indices = indices;
+
+        Rx::Vector<Uint32> first_vertex_triangle;
+        Rx::Vector<Uint32> vertex_triangles;
+        Rx::Vector<EdgeCollapse> collapses;
+        Rx::Vector<Uint32> collapse_remap;
+        Rx::Vector<Uint8> is_collapse_locked;
+
+        // Each pass collapses as many edges as it can without any two collapses touching the same vertex, so that the errors of the
+        // collapses are still right when they're made
+        while(simplified_indices.size() > target_num_indices) {
+            const auto num_triangles = static_cast<Uint32>(simplified_indices.size() / 3);
+
+            first_vertex_triangle.clear();
+            first_vertex_triangle.resize(num_vertices + 1, 0);
+            for(Size i = 0; i < simplified_indices.size(); i++) {
+                first_vertex_triangle[simplified_indices[i] + 1]++;
+            }
+            for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+                first_vertex_triangle[vertex + 1] += first_vertex_triangle[vertex];
+            }
+
+            vertex_triangles.resize(simplified_indices.size());
+            auto next_vertex_triangle = first_vertex_triangle;
+            for(Size i = 0; i < simplified_indices.size(); i++) {
+                vertex_triangles[next_vertex_triangle[simplified_indices[i]]++] = static_cast<Uint32>(i / 3);
+            }
+
+            const auto location_edges = get_sorted_location_edges(simplified_indices, location_ids);
+            const auto vertex_edges = has_seams ? get_sorted_vertex_edges(simplified_indices) : Rx::Vector<Uint64>{};
+
+            collapses.clear();
+            for(Size i = 0; i < simplified_indices.size(); i++) {
+                const auto a = simplified_indices[i];
+                const auto b = simplified_indices[i - i % 3 + (i + 1) % 3];
+                const auto a_location = location_ids[a];
+                const auto b_location = location_ids[b];
+                if(a_location == b_location) {
+                    continue;
+                }
+
+                // Edges inside the mesh show up once from each side, seam edges included
+                const auto is_border = is_border_edge(location_edges, a_location, b_location);
+                if(!is_border && a_location > b_location) {
+                    continue;
+                }
+
+                const auto is_seam = !is_border && (kinds[a] == VertexKind::Seam || kinds[b] == VertexKind::Seam) &&
+                                     is_border_edge(vertex_edges, a, b);
+
+                const auto can_collapse = [&](const Uint32 vertex) {
+                    return kinds[vertex] == VertexKind::Manifold || (kinds[vertex] == VertexKind::Border && is_border) ||
+                           (kinds[vertex] == VertexKind::Seam && is_seam);
+                };
+
+                const auto can_collapse_a = can_collapse(a);
+                const auto can_collapse_b = can_collapse(b);
+                if(!can_collapse_a && !can_collapse_b) {
+                    continue;
+                }
+
+                const auto a_to_b_error = can_collapse_a ? get_collapse_error(a, b) : FLT_MAX;
+                const auto b_to_a_error = can_collapse_b ? get_collapse_error(b, a) : FLT_MAX;
+                if(a_to_b_error <= b_to_a_error) {
+                    collapses.push_back(EdgeCollapse{.from = a, .to = b, .error = a_to_b_error});
+
+                } else {
+                    collapses.push_back(EdgeCollapse{.from = b, .to = a, .error = b_to_a_error});
+                }
+            }
+
+            std::sort(collapses.data(), collapses.data() + collapses.size(), [](const EdgeCollapse& a, const EdgeCollapse& b) {
+                return a.error < b.error;
+            });
+
+            collapse_remap.resize(num_vertices);
+            for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+                collapse_remap[vertex] = vertex;
+            }
+
+            is_collapse_locked.clear();
+            is_collapse_locked.resize(num_vertices, 0);
+
+            const auto target_num_triangles = target_num_indices / 3;
+            auto estimated_num_triangles = num_triangles;
+            Uint32 num_collapses = 0;
+            for(Size i = 0; i < collapses.size() && estimated_num_triangles > target_num_triangles; i++) {
+                const auto& collapse = collapses[i];
+                if(collapse.error > max_error) {
+                    break;
+                }
+
+                if(is_collapse_locked[collapse.from] != 0 || is_collapse_locked[collapse.to] != 0) {
+                    continue;
+                }
+
+                const auto flips_triangles = [&](const EdgeCollapse& vertex_collapse) {
+                    return collapse_flips_triangles(vertex_collapse,
+                                                    locations,
+                                                    location_ids,
+                                                    simplified_indices,
+                                                    collapse_remap,
+                                                    first_vertex_triangle,
+                                                    vertex_triangles);
+                };
+
+                if(flips_triangles(collapse)) {
+                    continue;
+                }
+
+                // A seam vertex takes its twin along, onto the vertex at the collapse's destination on the twin's side of the seam
+                if(kinds[collapse.from] == VertexKind::Seam) {
+                    const auto twin_to = find_seam_destination(twins[collapse.from],
+                                                               location_ids[collapse.to],
+                                                               location_vertices,
+                                                               location_edges,
+                                                               vertex_edges,
+                                                               location_ids);
+                    if(!twin_to) {
+                        continue;
+                    }
+
+                    const auto twin_collapse = EdgeCollapse{.from = twins[collapse.from], .to = *twin_to, .error = collapse.error};
+                    if(is_collapse_locked[twin_collapse.from] != 0 || is_collapse_locked[twin_collapse.to] != 0 ||
+                       flips_triangles(twin_collapse)) {
+                        continue;
+                    }
+
+                    collapse_remap[twin_collapse.from] = twin_collapse.to;
+                    is_collapse_locked[twin_collapse.from] = 1;
+                    is_collapse_locked[twin_collapse.to] = 1;
+                }
+
+                collapse_remap[collapse.from] = collapse.to;
+                quadrics[location_ids[collapse.to]] += quadrics[location_ids[collapse.from]];
+
+                is_collapse_locked[collapse.from] = 1;
+                is_collapse_locked[collapse.to] = 1;
+
+                // Collapsing an edge inside the mesh removes the triangles on both sides of it, which for a seam edge are on different
+                // sides of the seam. Border edges only have one
+                const auto num_removed_triangles = kinds[collapse.from] == VertexKind::Border ? 1u : 2u;
+                estimated_num_triangles -= glm::min(estimated_num_triangles, num_removed_triangles);
+
+                largest_error = glm::max(largest_error, collapse.error);
+                num_collapses++;
+            }
+
+            if(num_collapses == 0) {
+                break;
+            }
+
+            Size num_indices = 0;
+            for(Size triangle = 0; triangle < simplified_indices.size(); triangle += 3) {
+                const auto i0 = collapse_remap[simplified_indices[triangle]];
+                const auto i1 = collapse_remap[simplified_indices[triangle + 1]];
+                const auto i2 = collapse_remap[simplified_indices[triangle + 2]];
+                if(location_ids[i0] == location_ids[i1] || location_ids[i1] == location_ids[i2] || location_ids[i0] == location_ids[i2]) {
+                    continue;
+                }
+
+                simplified_indices[num_indices] = i0;
+                simplified_indices[num_indices + 1] = i1;
+                simplified_indices[num_indices + 2] = i2;
+                num_indices += 3;
+            }
+
+            simplified_indices.resize(num_indices);
+        }
+
+        if(result_error != nullptr) {
+            *result_error = glm::sqrt(largest_error) * size;
+        }
+
+        return simplified_indices;
+    }
+
+    Rx::Vector<SimplifiedMesh> generate_lods(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                             const Rx::Vector<Uint32>& indices,
+                                             const Uint32 max_lods,
+                                             const Float32 first_lod_error,
+                                             const Float32 triangle_ratio) {
+        ZoneScoped;
+
+        Rx::Vector<SimplifiedMesh> lods;
+        if(indices.size() % 3 != 0) {
+            return lods;
+        }
+
+        const auto num_vertices = static_cast<Uint32>(vertices.size());
+
+        auto previous_num_indices = static_cast<Float32>(indices.size());
+        auto target_num_triangles = static_cast<Float32>(indices.size() / 3);
+        auto lod_error = first_lod_error;
+
+        // Each LOD is simplified from the original mesh, so that its error is measured against the original surface
+        for(Uint32 lod_idx = 0; lod_idx < max_lods; lod_idx++) {
+            target_num_triangles *= triangle_ratio;
+
+            SimplifiedMesh lod;
+            lod.indices = simplify_mesh(vertices, indices, static_cast<Uint32>(target_num_triangles) * 3, lod_error, &lod.error);
+            if(lod.indices.is_empty() || static_cast<Float32>(lod.indices.size()) > previous_num_indices * MAX_LOD_INDEX_RATIO) {
+                break;
+            }
+
+            previous_num_indices = static_cast<Float32>(lod.indices.size());
+            lod.indices = optimize_vertex_cache(lod.indices, num_vertices);
+
+            lods.push_back(Rx::Utility::move(lod));
+
+            lod_error *= 2.0f;
+        }
+
+        return lods;
+    }
+} // namespace sanity::engine
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief A simplified version of a mesh, which uses the same vertices as the mesh
+     */
+    struct SimplifiedMesh {
+        Rx::Vector<Uint32> indices;
+
+        /*!
+         * \brief How far the simplified surface may be from the original surface, in the mesh's units
+         */
+        Float32 error{0};
+    };
+
+    /*!
+     * \brief Simplifies a triangle list by collapsing edges in the order of the quadric error metric (Garland and Heckbert, "Surface
+     * Simplification Using Quadric Error Metrics")
+     *
+     * Vertices only collapse onto other vertices of the mesh, so the simplified indices use the same vertices as the original indices.
+     * Vertices on the borders of the mesh only move along the border. Vertices on seams, such as UV seams and hard edges, only move along
+     * the seam, together with their twin on the other side of it, so the two sides of a seam stay stitched together. Vertices where seams
+     * meet or end never move
+     *
+     * \param target_num_indices Simplification stops once the mesh has this many indices or fewer
+     * \param target_error Simplification stops before any collapse that would move the surface more than this, relative to the size of the
+     * mesh. 0.01 allows 1% of the mesh's largest dimension
+     * \param result_error If this isn't nullptr, it gets the largest error of the collapses that were made, in the mesh's units
+     *
+     * \return The simplified indices. All the indices must be less than the number of vertices
+     */
+    [[nodiscard]] Rx::Vector<Uint32> simplify_mesh(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                   const Rx::Vector<Uint32>& indices,
+                                                   Uint32 target_num_indices,
+                                                   Float32 target_error,
+                                                   Float32* result_error = nullptr);
+
+    /*!
+     * \brief Makes a chain of levels of detail for a mesh, each with about `triangle_ratio` times the triangles of the one before
+     *
+     * The first LOD may move the surface by `first_lod_error`, relative to the size of the mesh, and each further LOD by twice as much as
+     * the one before. The chain stops early at a LOD which can't get much simpler than the one before it. Each LOD's triangles are
+     * reordered for the vertex cache
+     *
+     * \return The LODs, from the most detailed to the least. The original mesh isn't one of them
+     */
+    [[nodiscard]] Rx::Vector<SimplifiedMesh> generate_lods(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                           const Rx::Vector<Uint32>& indices,
+                                                           Uint32 max_lods,
+                                                           Float32 first_lod_error,
+                                                           Float32 triangle_ratio = 0.5f);
+} // namespace sanity::engine
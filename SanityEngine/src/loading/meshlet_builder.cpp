@@ -0,0 +1,322 @@
+#include "meshlet_builder.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "Tracy.hpp"
+#include "glm/geometric.hpp"
+
+namespace sanity::engine {
+    /*!
+     * \brief Meshlets with a triangle normal more than about 84 degrees away from their cone's axis could only be culled from almost right
+     * behind them, so they get a cone that never culls them
+     */
+    constexpr Float32 MIN_NORMAL_CONE_DOT = 0.1f;
+
+    /*!
+     * \brief Meshlet vertex slot of a vertex that isn't in the meshlet being built
+     */
+    constexpr Uint8 NOT_IN_MESHLET = 0xFF;
+
+    /*!
+     * \brief Spreads the low 10 bits of a value out to every third bit, for interleaving into a 30-bit Morton code
+     */
+    static Uint32 spread_bits(Uint32 value) {
+        value &= 0x3FF;
+        value = (value | (value << 16)) & 0x030000FF;
+        value = (value | (value << 8)) & 0x0300F00F;
+        value = (value | (value << 4)) & 0x030C30C3;
+        value = (value | (value << 2)) & 0x09249249;
+
+        return value;
+    }
+
+    /*!
+     * \return The indices of the triangles, sorted along a Morton curve through their centroids
+     */
+    static Rx::Vector<Uint32> get_triangles_in_morton_order(const Rx::Vector<glm::vec3>& centroids) {
+        auto min = glm::vec3{FLT_MAX};
+        auto max = glm::vec3{-FLT_MAX};
+        centroids.each_fwd([&](const glm::vec3& centroid) {
+            min = glm::min(min, centroid);
+            max = glm::max(max, centroid);
+        });
+
+        const auto extents = max - min;
+        const auto size = glm::max(extents.x, glm::max(extents.y, extents.z));
+        const auto scale = size > 0.0f ? 1023.0f / size : 0.0f;
+
+        // The Morton code in the high bits and the triangle in the low bits, so that sorting the keys sorts the triangles
+        Rx::Vector<Uint64> keys;
+        keys.reserve(centroids.size());
+        for(Uint32 triangle = 0; triangle < centroids.size(); triangle++) {
+            const auto cell = (centroids[triangle] - min) * scale;
+            const auto morton_code = spread_bits(static_cast<Uint32>(cell.x)) | (spread_bits(static_cast<Uint32>(cell.y)) << 1) |
+                                     (spread_bits(static_cast<Uint32>(cell.z)) << 2);
+            keys.push_back((static_cast<Uint64>(morton_code) << 32) | triangle);
+        }
+
+        std::sort(keys.data(), keys.data() + keys.size());
+
+        Rx::Vector<Uint32> triangles;
+        triangles.reserve(keys.size());
+        keys.each_fwd([&](const Uint64 key) { triangles.push_back(static_cast<Uint32>(key & 0xFFFFFFFF)); });
+
+        return triangles;
+    }
+
+    MeshletData build_meshlets(const Rx::Vector<renderer::StandardVertex>& vertices,
+                               const Rx::Vector<Uint32>& indices,
+                               const Uint32 max_vertices,
+                               const Uint32 max_triangles) {
+        ZoneScoped;
+
+        MeshletData meshlet_data;
+
+        const auto num_vertices = static_cast<Uint32>(vertices.size());
+        const auto num_triangles = static_cast<Uint32>(indices.size() / 3);
+        if(indices.size() % 3 != 0 || max_vertices < 3 || max_vertices >= NOT_IN_MESHLET || max_triangles == 0) {
+            return meshlet_data;
+        }
+
+        Rx::Vector<glm::vec3> centroids;
+        centroids.reserve(num_triangles);
+        for(Uint32 triangle = 0; triangle < num_triangles; triangle++) {
+            const auto& location_0 = vertices[indices[triangle * 3]].location;
+            const auto& location_1 = vertices[indices[triangle * 3 + 1]].location;
+            const auto& location_2 = vertices[indices[triangle * 3 + 2]].location;
+            centroids.push_back((location_0 + location_1 + location_2) / 3.0f);
+        }
+
+        // The triangles which use each vertex
+        Rx::Vector<Uint32> first_vertex_triangle;
+        first_vertex_triangle.resize(num_vertices + 1, 0);
+        for(Size i = 0; i < indices.size(); i++) {
+            first_vertex_triangle[indices[i] + 1]++;
+        }
+        for(Uint32 vertex = 0; vertex < num_vertices; vertex++) {
+            first_vertex_triangle[vertex + 1] += first_vertex_triangle[vertex];
+        }
+
+        Rx::Vector<Uint32> vertex_triangles;
+        vertex_triangles.resize(indices.size());
+        auto next_vertex_triangle = first_vertex_triangle;
+        for(Size i = 0; i < indices.size(); i++) {
+            vertex_triangles[next_vertex_triangle[indices[i]]++] = static_cast<Uint32>(i / 3);
+        }
+
+        const auto triangle_order = get_triangles_in_morton_order(centroids);
+        Size next_triangle_in_order = 0;
+
+        Rx::Vector<Uint8> is_triangle_used;
+        is_triangle_used.resize(num_triangles, 0);
+
+        // Where each vertex is in the meshlet being built
+        Rx::Vector<Uint8> meshlet_vertex_slots;
+        meshlet_vertex_slots.resize(num_vertices, NOT_IN_MESHLET);
+
+        auto meshlet = renderer::Meshlet{.vertex_offset = 0, .triangle_offset = 0, .num_vertices = 0, .num_triangles = 0};
+        auto meshlet_centroid_sum = glm::vec3{0};
+
+        const auto count_new_vertices = [&](const Uint32 triangle) {
+            const auto vertex_0 = indices[triangle * 3];
+            const auto vertex_1 = indices[triangle * 3 + 1];
+            const auto vertex_2 = indices[triangle * 3 + 2];
+
+            Uint32 num_new_vertices = meshlet_vertex_slots[vertex_0] == NOT_IN_MESHLET ? 1 : 0;
+            if(meshlet_vertex_slots[vertex_1] == NOT_IN_MESHLET && vertex_1 != vertex_0) {
+                num_new_vertices++;
+            }
+            if(meshlet_vertex_slots[vertex_2] == NOT_IN_MESHLET && vertex_2 != vertex_0 && vertex_2 != vertex_1) {
+                num_new_vertices++;
+            }
+
+            return num_new_vertices;
+        };
+
+        const auto finish_meshlet = [&] {
+            for(Uint32 i = 0; i < meshlet.num_vertices; i++) {
+                meshlet_vertex_slots[meshlet_data.vertices[meshlet.vertex_offset + i]] = NOT_IN_MESHLET;
+            }
+
+            meshlet_data.meshlets.push_back(meshlet);
+
+            meshlet = renderer::Meshlet{.vertex_offset = static_cast<Uint32>(meshlet_data.vertices.size()),
+                                        .triangle_offset = static_cast<Uint32>(meshlet_data.triangles.size() / 3),
+                                        .num_vertices = 0,
+                                        .num_triangles = 0};
+            meshlet_centroid_sum = glm::vec3{0};
+        };
+
+        for(Uint32 num_used_triangles = 0; num_used_triangles < num_triangles; num_used_triangles++) {
+            // Grow the meshlet with the triangle that adds the fewest vertices to it, and that's closest to its center out of those
+            auto best_triangle = UINT32_MAX;
+            auto best_num_new_vertices = UINT32_MAX;
+            auto best_distance = FLT_MAX;
+
+            if(meshlet.num_triangles > 0) {
+                const auto meshlet_center = meshlet_centroid_sum / static_cast<Float32>(meshlet.num_triangles);
+
+                for(Uint32 i = 0; i < meshlet.num_vertices; i++) {
+                    const auto vertex = meshlet_data.vertices[meshlet.vertex_offset + i];
+                    for(auto j = first_vertex_triangle[vertex]; j < first_vertex_triangle[vertex + 1]; j++) {
+                        const auto triangle = vertex_triangles[j];
+                        if(is_triangle_used[triangle] != 0) {
+                            continue;
+                        }
+
+                        const auto num_new_vertices = count_new_vertices(triangle);
+                        if(num_new_vertices > best_num_new_vertices) {
+                            continue;
+                        }
+
+                        const auto offset = centroids[triangle] - meshlet_center;
+                        const auto distance = glm::dot(offset, offset);
+                        if(num_new_vertices < best_num_new_vertices || distance < best_distance) {
+                            best_triangle = triangle;
+                            best_num_new_vertices = num_new_vertices;
+                            best_distance = distance;
+                        }
+                    }
+                }
+            }
+
+            // With no connected triangle left, continue along the Morton curve. Triangles never become unused again, so the cursor only
+            // moves forward
+            if(best_triangle == UINT32_MAX) {
+                while(is_triangle_used[triangle_order[next_triangle_in_order]] != 0) {
+                    next_triangle_in_order++;
+                }
+
+                best_triangle = triangle_order[next_triangle_in_order];
+                best_num_new_vertices = count_new_vertices(best_triangle);
+            }
+
+            // A triangle that doesn't fit starts the next meshlet, which then grows from where this one stopped
+            if(meshlet.num_vertices + best_num_new_vertices > max_vertices || meshlet.num_triangles + 1 > max_triangles) {
+                finish_meshlet();
+            }
+
+            for(Uint32 corner = 0; corner < 3; corner++) {
+                const auto vertex = indices[best_triangle * 3 + corner];
+                if(meshlet_vertex_slots[vertex] == NOT_IN_MESHLET) {
+                    meshlet_vertex_slots[vertex] = static_cast<Uint8>(meshlet.num_vertices);
+                    meshlet_data.vertices.push_back(vertex);
+                    meshlet.num_vertices++;
+                }
+
+                meshlet_data.triangles.push_back(meshlet_vertex_slots[vertex]);
+            }
+
+            meshlet.num_triangles++;
+            meshlet_centroid_sum += centroids[best_triangle];
+            is_triangle_used[best_triangle] = 1;
+        }
+
+        if(meshlet.num_triangles > 0) {
+            finish_meshlet();
+        }
+
+        meshlet_data.bounds.reserve(meshlet_data.meshlets.size());
+        meshlet_data.meshlets.each_fwd([&](const renderer::Meshlet& built_meshlet) {
+            meshlet_data.bounds.push_back(compute_meshlet_bounds(vertices, meshlet_data, built_meshlet));
+        });
+
+        return meshlet_data;
+    }
+
+    renderer::MeshletBounds compute_meshlet_bounds(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                   const MeshletData& meshlet_data,
+                                                   const renderer::Meshlet& meshlet) {
+        const auto get_location = [&](const Uint32 meshlet_vertex) -> const glm::vec3& {
+            return vertices[meshlet_data.vertices[meshlet.vertex_offset + meshlet_vertex]].location;
+        };
+
+        const auto get_triangle_normal = [&](const Uint32 triangle, glm::vec3& location_0) {
+            const auto* triangle_vertices = &meshlet_data.triangles[(meshlet.triangle_offset + triangle) * 3];
+            location_0 = get_location(triangle_vertices[0]);
+            const auto edge_1 = get_location(triangle_vertices[1]) - location_0;
+            const auto edge_2 = get_location(triangle_vertices[2]) - location_0;
+            const auto normal = glm::cross(edge_1, edge_2);
+            const auto length = glm::length(normal);
+            return length > 0.0f ? normal / length : glm::vec3{0};
+        };
+
+        // Ritter's bounding sphere: start with the sphere through two far apart vertices, then grow it to cover the vertices outside it
+        const auto get_farthest_vertex = [&](const glm::vec3& location) {
+            Uint32 farthest_vertex = 0;
+            auto farthest_distance = -1.0f;
+            for(Uint32 i = 0; i < meshlet.num_vertices; i++) {
+                const auto offset = get_location(i) - location;
+                if(const auto distance = glm::dot(offset, offset); distance > farthest_distance) {
+                    farthest_vertex = i;
+                    farthest_distance = distance;
+                }
+            }
+
+            return get_location(farthest_vertex);
+        };
+
+        const auto extreme_0 = get_farthest_vertex(get_location(0));
+        const auto extreme_1 = get_farthest_vertex(extreme_0);
+
+        auto center = (extreme_0 + extreme_1) * 0.5f;
+        auto radius = glm::length(extreme_1 - extreme_0) * 0.5f;
+        for(Uint32 i = 0; i < meshlet.num_vertices; i++) {
+            const auto offset = get_location(i) - center;
+            const auto distance = glm::length(offset);
+            if(distance > radius) {
+                const auto new_radius = (radius + distance) * 0.5f;
+                center += offset * ((new_radius - radius) / distance);
+                radius = new_radius;
+            }
+        }
+
+        auto bounds = renderer::MeshletBounds{.center = center,
+                                              .radius = radius,
+                                              .cone_apex = center,
+                                              .cone_cutoff = 1.0f,
+                                              .cone_axis = glm::vec3{0}};
+
+        // The cone's axis is the average of the triangles' normals, and its angle is the largest angle from the axis to a normal
+        glm::vec3 location_0;
+        auto axis = glm::vec3{0};
+        for(Uint32 triangle = 0; triangle < meshlet.num_triangles; triangle++) {
+            axis += get_triangle_normal(triangle, location_0);
+        }
+
+        const auto axis_length = glm::length(axis);
+        if(axis_length <= 0.0f) {
+            return bounds;
+        }
+        axis /= axis_length;
+
+        auto min_normal_dot = 1.0f;
+        for(Uint32 triangle = 0; triangle < meshlet.num_triangles; triangle++) {
+            const auto normal = get_triangle_normal(triangle, location_0);
+            if(normal != glm::vec3{0}) {
+                min_normal_dot = glm::min(min_normal_dot, glm::dot(normal, axis));
+            }
+        }
+
+        if(min_normal_dot <= MIN_NORMAL_CONE_DOT) {
+            return bounds;
+        }
+
+        // Move the apex back along the axis until every triangle's plane is in front of it, so that a camera which sees the apex from
+        // behind sees every triangle from behind
+        auto apex_distance = 0.0f;
+        for(Uint32 triangle = 0; triangle < meshlet.num_triangles; triangle++) {
+            const auto normal = get_triangle_normal(triangle, location_0);
+            if(normal != glm::vec3{0}) {
+                apex_distance = glm::max(apex_distance, glm::dot(center - location_0, normal) / glm::dot(axis, normal));
+            }
+        }
+
+        bounds.cone_apex = center - axis * apex_distance;
+        bounds.cone_axis = axis;
+        bounds.cone_cutoff = glm::sqrt(1.0f - min_normal_dot * min_normal_dot);
+
+        return bounds;
+    }
+} // namespace sanity::engine
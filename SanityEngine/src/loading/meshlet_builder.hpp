@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief A mesh split into meshlets
+     */
+    struct MeshletData {
+        Rx::Vector<renderer::Meshlet> meshlets;
+
+        /*!
+         * \brief The bounds of each meshlet, in the same order as `meshlets`
+         */
+        Rx::Vector<renderer::MeshletBounds> bounds;
+
+        /*!
+         * \brief The vertices of every meshlet, as indices of the mesh's vertices
+         */
+        Rx::Vector<Uint32> vertices;
+
+        /*!
+         * \brief The triangles of every meshlet, as three indices into the meshlet's vertices each
+         */
+        Rx::Vector<Uint8> triangles;
+    };
+
+    /*!
+     * \brief Splits a triangle list into meshlets of at most `max_vertices` vertices and `max_triangles` triangles, and computes each
+     * meshlet's bounding sphere and normal cone
+     *
+     * Meshlets grow across the triangles that share the most vertices with them, so that they're compact and their normal cones are
+     * narrow. When a meshlet runs out of connected triangles, it continues with the first unused triangle along a Morton curve through all
+     * the triangles' centroids, which is usually close by, so that meshes with split vertices, such as flat shaded meshes, still get
+     * fairly compact meshlets
+     *
+     * Triangles keep their winding order. All the indices must be less than the number of vertices, and `max_vertices` must be less than
+     * 256
+     */
+    [[nodiscard]] MeshletData build_meshlets(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                             const Rx::Vector<Uint32>& indices,
+                                             Uint32 max_vertices = renderer::MAX_MESHLET_VERTICES,
+                                             Uint32 max_triangles = renderer::MAX_MESHLET_TRIANGLES);
+
+    /*!
+     * \brief Computes the bounding sphere and normal cone of one of a mesh's meshlets
+     */
+    [[nodiscard]] renderer::MeshletBounds compute_meshlet_bounds(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                                 const MeshletData& meshlet_data,
+                                                                 const renderer::Meshlet& meshlet);
+} // namespace sanity::engine
@@ -0,0 +1,450 @@
+#include "mip_generation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#include "Tracy.hpp"
+#include "core/async/thread_pool.hpp"
+#include "renderer/rhi/resources.hpp"
+#include "rx/core/function.h"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief Number of rows of texels in each batch of a parallel filtering pass
+     */
+    constexpr Uint32 ROWS_PER_BATCH = 16;
+
+    constexpr Uint32 KAISER_NUM_TAPS = 6;
+
+    /*!
+     * \brief Offset from the first of the two source texels under a destination texel to the Kaiser filter's first tap
+     */
+    constexpr Int32 KAISER_FIRST_TAP = -2;
+
+    /*!
+     * \brief Half the width of the Kaiser window, in source texels
+     */
+    constexpr Float32 KAISER_WINDOW_RADIUS = 3.0f;
+
+    /*!
+     * \brief Shape of the Kaiser window. Higher values suppress more ringing, but blur more
+     */
+    constexpr Float32 KAISER_ALPHA = 4.0f;
+
+    constexpr Float32 PI = 3.14159265358979f;
+
+    /*!
+     * \brief Number of steps in the binary search for each mip's alpha scale
+     */
+    constexpr Uint32 ALPHA_SCALE_SEARCH_STEPS = 16;
+
+    constexpr Float32 MAX_ALPHA_SCALE = 4.0f;
+
+    constexpr Uint32 LINEAR_TO_SRGB_TABLE_SIZE = 4096;
+
+    /*!
+     * \brief An image with four floats per texel, with the color channels in linear space
+     */
+    struct LinearImage {
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        Rx::Vector<Float32> texels;
+
+        [[nodiscard]] Float32* get_row(const Uint32 y) { return texels.data() + static_cast<Size>(y) * width * 4; }
+
+        [[nodiscard]] const Float32* get_row(const Uint32 y) const { return texels.data() + static_cast<Size>(y) * width * 4; }
+    };
+
+    struct ConversionTables {
+        Float32 srgb_to_linear[256];
+
+        Float32 unorm_to_float[256];
+
+        /*!
+         * \brief sRGB value of evenly spaced linear values. Fine enough that looking values up is no more than half a step off
+         */
+        Uint8 linear_to_srgb[LINEAR_TO_SRGB_TABLE_SIZE];
+    };
+
+    struct KaiserKernel {
+        Float32 weights[KAISER_NUM_TAPS];
+    };
+
+    static Float32 srgb_to_linear(const Float32 value) {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static Float32 linear_to_srgb(const Float32 value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    static const ConversionTables& get_conversion_tables() {
+        static const auto tables = [] {
+            ConversionTables new_tables{};
+            for(Uint32 i = 0; i < 256; i++) {
+                new_tables.srgb_to_linear[i] = srgb_to_linear(static_cast<Float32>(i) / 255.0f);
+                new_tables.unorm_to_float[i] = static_cast<Float32>(i) / 255.0f;
+            }
+
+            for(Uint32 i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; i++) {
+                const auto linear = static_cast<Float32>(i) / static_cast<Float32>(LINEAR_TO_SRGB_TABLE_SIZE - 1);
+                new_tables.linear_to_srgb[i] = static_cast<Uint8>(std::lround(linear_to_srgb(linear) * 255.0f));
+            }
+
+            return new_tables;
+        }();
+
+        return tables;
+    }
+
+    /*!
+     * \brief Modified Bessel function of the first kind, of order zero, from its power series
+     */
+    static Float32 bessel_i0(const Float32 x) {
+        const auto quarter_x_squared = x * x / 4.0f;
+
+        Float32 sum{1};
+        Float32 term{1};
+        for(Uint32 k = 1; k < 32; k++) {
+            term *= quarter_x_squared / static_cast<Float32>(k * k);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    static const KaiserKernel& get_kaiser_kernel() {
+        static const auto kernel = [] {
+            KaiserKernel new_kernel{};
+
+            Float32 total_weight{0};
+            for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                // Distance from the tap's texel to the center of the destination texel, in source texels. It's never zero, because the
+                // center of the destination texel lies between two source texels
+                const auto distance = static_cast<Float32>(static_cast<Int32>(tap) + KAISER_FIRST_TAP) - 0.5f;
+
+                // The destination holds half the frequencies of the source, so the sinc is twice as wide
+                const auto sinc_x = PI * distance / 2.0f;
+                const auto sinc = std::sin(sinc_x) / sinc_x;
+
+                const auto window_x = distance / KAISER_WINDOW_RADIUS;
+                const auto window = bessel_i0(KAISER_ALPHA * std::sqrt(1.0f - window_x * window_x)) / bessel_i0(KAISER_ALPHA);
+
+                new_kernel.weights[tap] = sinc * window;
+                total_weight += new_kernel.weights[tap];
+            }
+
+            for(auto& weight : new_kernel.weights) {
+                weight /= total_weight;
+            }
+
+            return new_kernel;
+        }();
+
+        return kernel;
+    }
+
+    static void for_each_row_batch(const Uint32 num_rows, ThreadPool* thread_pool, const Rx::Function<void(Uint32, Uint32)>& job) {
+        if(thread_pool != nullptr && num_rows > ROWS_PER_BATCH) {
+            thread_pool->parallel_for(num_rows, ROWS_PER_BATCH, job);
+
+        } else {
+            job(0, num_rows);
+        }
+    }
+
+    static LinearImage to_linear_image(
+        const Uint8* pixels, const Uint32 width, const Uint32 height, const bool is_srgb, ThreadPool* thread_pool) {
+        auto image = LinearImage{.width = width, .height = height};
+        image.texels.resize(static_cast<Size>(width) * height * 4);
+
+        const auto& tables = get_conversion_tables();
+        const auto* color_table = is_srgb ? tables.srgb_to_linear : tables.unorm_to_float;
+
+        for_each_row_batch(height, thread_pool, [&](const Uint32 first_row, const Uint32 last_row) {
+            for(auto y = first_row; y < last_row; y++) {
+                const auto* row_pixels = pixels + static_cast<Size>(y) * width * 4;
+                auto* row_texels = image.get_row(y);
+
+                for(Uint32 i = 0; i < width * 4; i += 4) {
+                    row_texels[i] = color_table[row_pixels[i]];
+                    row_texels[i + 1] = color_table[row_pixels[i + 1]];
+                    row_texels[i + 2] = color_table[row_pixels[i + 2]];
+                    row_texels[i + 3] = tables.unorm_to_float[row_pixels[i + 3]];
+                }
+            }
+        });
+
+        return image;
+    }
+
+    static void downsample_box(const LinearImage& source, LinearImage& destination, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        for_each_row_batch(destination.height, thread_pool, [&](const Uint32 first_row, const Uint32 last_row) {
+            const auto quarter = _mm_set1_ps(0.25f);
+
+            for(auto y = first_row; y < last_row; y++) {
+                const auto* top_row = source.get_row(std::min(2 * y, source.height - 1));
+                const auto* bottom_row = source.get_row(std::min(2 * y + 1, source.height - 1));
+                auto* destination_row = destination.get_row(y);
+
+                Uint32 x{0};
+#ifdef __AVX__
+                // Two destination texels at a time, while all four source texels under them are in the image
+                const auto quarter_x2 = _mm256_set1_ps(0.25f);
+                for(; x + 1 < destination.width && 2 * x + 3 < source.width; x += 2) {
+                    const auto* top = top_row + 8 * x;
+                    const auto* bottom = bottom_row + 8 * x;
+                    const auto left = _mm256_add_ps(_mm256_loadu_ps(top), _mm256_loadu_ps(bottom));
+                    const auto right = _mm256_add_ps(_mm256_loadu_ps(top + 8), _mm256_loadu_ps(bottom + 8));
+
+                    // Lines up the left texel of each pair with the right texel of each pair
+                    const auto sum = _mm256_add_ps(_mm256_permute2f128_ps(left, right, 0x20), _mm256_permute2f128_ps(left, right, 0x31));
+                    _mm256_storeu_ps(destination_row + 4 * x, _mm256_mul_ps(sum, quarter_x2));
+                }
+#endif
+
+                for(; x < destination.width; x++) {
+                    const auto left_x = std::min(2 * x, source.width - 1) * 4;
+                    const auto right_x = std::min(2 * x + 1, source.width - 1) * 4;
+
+                    const auto top = _mm_add_ps(_mm_loadu_ps(top_row + left_x), _mm_loadu_ps(top_row + right_x));
+                    const auto bottom = _mm_add_ps(_mm_loadu_ps(bottom_row + left_x), _mm_loadu_ps(bottom_row + right_x));
+                    _mm_storeu_ps(destination_row + 4 * x, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+                }
+            }
+        });
+    }
+
+    static void downsample_kaiser(const LinearImage& source, LinearImage& destination, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        const auto& kernel = get_kaiser_kernel();
+
+        // The filter is separable, so we filter the rows into an image with the destination's width, then filter that image's columns
+        auto filtered_rows = LinearImage{.width = destination.width, .height = source.height};
+        filtered_rows.texels.resize(static_cast<Size>(filtered_rows.width) * filtered_rows.height * 4);
+
+        for_each_row_batch(source.height, thread_pool, [&](const Uint32 first_row, const Uint32 last_row) {
+            __m128 weights[KAISER_NUM_TAPS];
+            for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                weights[tap] = _mm_set1_ps(kernel.weights[tap]);
+            }
+
+            const auto max_x = static_cast<Int32>(source.width) - 1;
+
+            for(auto y = first_row; y < last_row; y++) {
+                const auto* source_row = source.get_row(y);
+                auto* destination_row = filtered_rows.get_row(y);
+
+                for(Uint32 x = 0; x < filtered_rows.width; x++) {
+                    const auto first_tap_x = static_cast<Int32>(2 * x) + KAISER_FIRST_TAP;
+
+                    auto sum = _mm_setzero_ps();
+                    for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                        const auto source_x = std::clamp(first_tap_x + static_cast<Int32>(tap), 0, max_x);
+                        sum = _mm_add_ps(sum, _mm_mul_ps(weights[tap], _mm_loadu_ps(source_row + 4 * source_x)));
+                    }
+
+                    _mm_storeu_ps(destination_row + 4 * x, sum);
+                }
+            }
+        });
+
+        for_each_row_batch(destination.height, thread_pool, [&](const Uint32 first_row, const Uint32 last_row) {
+            __m128 weights[KAISER_NUM_TAPS];
+            for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                weights[tap] = _mm_set1_ps(kernel.weights[tap]);
+            }
+
+            const auto zero = _mm_setzero_ps();
+            const auto one = _mm_set1_ps(1.0f);
+
+#ifdef __AVX__
+            __m256 weights_x2[KAISER_NUM_TAPS];
+            for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                weights_x2[tap] = _mm256_set1_ps(kernel.weights[tap]);
+            }
+
+            const auto zero_x2 = _mm256_setzero_ps();
+            const auto one_x2 = _mm256_set1_ps(1.0f);
+#endif
+
+            const auto max_y = static_cast<Int32>(filtered_rows.height) - 1;
+            const auto num_floats = destination.width * 4;
+
+            for(auto y = first_row; y < last_row; y++) {
+                const Float32* source_rows[KAISER_NUM_TAPS];
+                const auto first_tap_y = static_cast<Int32>(2 * y) + KAISER_FIRST_TAP;
+                for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                    source_rows[tap] = filtered_rows.get_row(std::clamp(first_tap_y + static_cast<Int32>(tap), 0, max_y));
+                }
+
+                auto* destination_row = destination.get_row(y);
+
+                // The negative lobes of the filter can push values out of range. We clamp them so that the ringing doesn't build up over
+                // the mip chain
+                Uint32 i{0};
+#ifdef __AVX__
+                for(; i + 8 <= num_floats; i += 8) {
+                    auto sum = _mm256_setzero_ps();
+                    for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                        sum = _mm256_add_ps(sum, _mm256_mul_ps(weights_x2[tap], _mm256_loadu_ps(source_rows[tap] + i)));
+                    }
+
+                    _mm256_storeu_ps(destination_row + i, _mm256_min_ps(_mm256_max_ps(sum, zero_x2), one_x2));
+                }
+#endif
+
+                for(; i < num_floats; i += 4) {
+                    auto sum = _mm_setzero_ps();
+                    for(Uint32 tap = 0; tap < KAISER_NUM_TAPS; tap++) {
+                        sum = _mm_add_ps(sum, _mm_mul_ps(weights[tap], _mm_loadu_ps(source_rows[tap] + i)));
+                    }
+
+                    _mm_storeu_ps(destination_row + i, _mm_min_ps(_mm_max_ps(sum, zero), one));
+                }
+            }
+        });
+    }
+
+    /*!
+     * \brief Fraction of an image's texels which pass the alpha test after their alpha is multiplied by `alpha_scale`
+     */
+    static Float32 get_alpha_coverage(const LinearImage& image, const Float32 alpha_cutoff, const Float32 alpha_scale) {
+        const auto num_texels = static_cast<Size>(image.width) * image.height;
+
+        Size num_covered_texels{0};
+        for(Size i = 0; i < num_texels; i++) {
+            if(image.texels[i * 4 + 3] * alpha_scale >= alpha_cutoff) {
+                num_covered_texels++;
+            }
+        }
+
+        return static_cast<Float32>(num_covered_texels) / static_cast<Float32>(num_texels);
+    }
+
+    /*!
+     * \brief Finds the value to multiply an image's alpha by so that the given fraction of its texels pass the alpha test
+     */
+    static Float32 find_alpha_scale(const LinearImage& image, const Float32 alpha_cutoff, const Float32 target_coverage) {
+        ZoneScoped;
+
+        Float32 best_scale{1};
+        auto best_error = std::abs(get_alpha_coverage(image, alpha_cutoff, best_scale) - target_coverage);
+
+        // Coverage only grows with the scale, so we can binary search for it
+        Float32 min_scale{0};
+        auto max_scale = MAX_ALPHA_SCALE;
+        for(Uint32 step = 0; step < ALPHA_SCALE_SEARCH_STEPS; step++) {
+            const auto scale = (min_scale + max_scale) / 2.0f;
+            const auto coverage = get_alpha_coverage(image, alpha_cutoff, scale);
+
+            const auto error = std::abs(coverage - target_coverage);
+            if(error < best_error) {
+                best_scale = scale;
+                best_error = error;
+            }
+
+            if(coverage < target_coverage) {
+                min_scale = scale;
+            } else {
+                max_scale = scale;
+            }
+        }
+
+        return best_scale;
+    }
+
+    static void to_rgba8(const LinearImage& image, const bool is_srgb, const Float32 alpha_scale, Uint8* pixels, ThreadPool* thread_pool) {
+        const auto& tables = get_conversion_tables();
+
+        // sRGB colors get looked up in the conversion table, so they're scaled to its indices instead of to [0, 255]
+        const auto color_scale = is_srgb ? static_cast<Float32>(LINEAR_TO_SRGB_TABLE_SIZE - 1) : 255.0f;
+
+        for_each_row_batch(image.height, thread_pool, [&](const Uint32 first_row, const Uint32 last_row) {
+            const auto zero = _mm_setzero_ps();
+            const auto one = _mm_set1_ps(1.0f);
+            const auto pre_clamp_scale = _mm_setr_ps(1.0f, 1.0f, 1.0f, alpha_scale);
+            const auto post_clamp_scale = _mm_setr_ps(color_scale, color_scale, color_scale, 255.0f);
+
+            alignas(16) Int32 values[4];
+
+            for(auto y = first_row; y < last_row; y++) {
+                const auto* row_texels = image.get_row(y);
+                auto* row_pixels = pixels + static_cast<Size>(y) * image.width * 4;
+
+                for(Uint32 i = 0; i < image.width * 4; i += 4) {
+                    const auto texel = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(row_texels + i), pre_clamp_scale), zero), one);
+                    _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_cvtps_epi32(_mm_mul_ps(texel, post_clamp_scale)));
+
+                    if(is_srgb) {
+                        row_pixels[i] = tables.linear_to_srgb[values[0]];
+                        row_pixels[i + 1] = tables.linear_to_srgb[values[1]];
+                        row_pixels[i + 2] = tables.linear_to_srgb[values[2]];
+
+                    } else {
+                        row_pixels[i] = static_cast<Uint8>(values[0]);
+                        row_pixels[i + 1] = static_cast<Uint8>(values[1]);
+                        row_pixels[i + 2] = static_cast<Uint8>(values[2]);
+                    }
+
+                    row_pixels[i + 3] = static_cast<Uint8>(values[3]);
+                }
+            }
+        });
+    }
+
+    Rx::Vector<Uint8> generate_mip_chain(
+        const Uint8* pixels, const Uint32 width, const Uint32 height, const MipGenerationOptions& options, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        const auto num_mips = renderer::get_num_mips(width, height);
+
+        Rx::Vector<Uint8> mip_chain;
+        mip_chain.resize(renderer::get_mip_chain_size_in_bytes(renderer::TextureFormat::Rgba8, width, height, num_mips));
+
+        const auto top_mip_size = static_cast<Size>(width) * height * 4;
+        std::memcpy(mip_chain.data(), pixels, top_mip_size);
+
+        if(num_mips == 1) {
+            return mip_chain;
+        }
+
+        auto source = to_linear_image(pixels, width, height, options.is_srgb, thread_pool);
+
+        const auto target_coverage = options.alpha_cutoff ? get_alpha_coverage(source, *options.alpha_cutoff, 1.0f) : 0.0f;
+
+        // Each mip is filtered from the one above it. The alpha scale is only applied to the RGBA8 output, so it doesn't compound
+        auto* mip_pixels = mip_chain.data() + top_mip_size;
+        for(Uint32 mip_level = 1; mip_level < num_mips; mip_level++) {
+            auto destination = LinearImage{.width = renderer::get_mip_dimension(width, mip_level),
+                                           .height = renderer::get_mip_dimension(height, mip_level)};
+            destination.texels.resize(static_cast<Size>(destination.width) * destination.height * 4);
+
+            switch(options.filter) {
+                case MipFilter::Box:
+                    downsample_box(source, destination, thread_pool);
+                    break;
+
+                case MipFilter::Kaiser:
+                    downsample_kaiser(source, destination, thread_pool);
+                    break;
+            }
+
+            const auto alpha_scale = options.alpha_cutoff ? find_alpha_scale(destination, *options.alpha_cutoff, target_coverage) : 1.0f;
+            to_rgba8(destination, options.is_srgb, alpha_scale, mip_pixels, thread_pool);
+
+            mip_pixels += static_cast<Size>(destination.width) * destination.height * 4;
+            source = Rx::Utility::move(destination);
+        }
+
+        return mip_chain;
+    }
+} // namespace sanity::engine
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+
+    enum class MipFilter {
+        /*!
+         * \brief Averages each 2x2 square of texels. Fast, but blurs the lower mips
+         */
+        Box,
+
+        /*!
+         * \brief Kaiser-windowed sinc over 6x6 texels. Keeps lower mips sharper than the box filter does
+         */
+        Kaiser,
+    };
+
+    struct MipGenerationOptions {
+        MipFilter filter{MipFilter::Kaiser};
+
+        /*!
+         * \brief Whether the RGB channels hold sRGB-encoded colors. sRGB images are filtered in linear space, so that their mips don't get
+         * darker. Alpha is always linear
+         */
+        bool is_srgb{true};
+
+        /*!
+         * \brief Alpha value below which the shaders discard texels
+         *
+         * If this is set, the alpha of each mip is scaled so that the same fraction of its texels pass the alpha test as in the top mip.
+         * Without this, cutout textures such as foliage fade away in the distance
+         */
+        Rx::Optional<Float32> alpha_cutoff{Rx::nullopt};
+    };
+
+    /*!
+     * \brief Generates the full mip chain of an RGBA8 image
+     *
+     * \param thread_pool Thread pool to spread the rows of each mip over. If this is nullptr, all work happens on the calling thread
+     *
+     * \return All the mips of the image, starting with a copy of the image itself, tightly packed one after another
+     */
+    [[nodiscard]] Rx::Vector<Uint8> generate_mip_chain(const Uint8* pixels,
+                                                       Uint32 width,
+                                                       Uint32 height,
+                                                       const MipGenerationOptions& options = {},
+                                                       ThreadPool* thread_pool = nullptr);
+} // namespace sanity::engine
@@ -0,0 +1,334 @@
+#include "pixel_conversion.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <immintrin.h>
+
+#include "Tracy.hpp"
+#include "glm/gtc/packing.hpp"
+#include "rx/core/array.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    constexpr Uint8 OPAQUE_ALPHA_8 = 0xFF;
+
+    constexpr Float32 OPAQUE_ALPHA_32F = 1.0f;
+
+    /*!
+     * \brief Number of pixels which `expand_to_rgba16f` expands to floats before converting them. Small enough that the floats stay in
+     * the L1 cache
+     */
+    constexpr Size HALF_CONVERSION_BATCH_SIZE = 256;
+
+    /*!
+     * \brief Expands pixels `first_pixel` to `last_pixel` one at a time. The vectorized kernels use this for the pixels at the end of an
+     * image which don't fill a whole vector
+     */
+    template <typename ComponentType>
+    static void expand_pixels(const ComponentType* pixels,
+                              const Uint32 num_channels,
+                              const Size first_pixel,
+                              const Size last_pixel,
+                              ComponentType* rgba_pixels,
+                              const ComponentType opaque_alpha) {
+        for(auto i = first_pixel; i < last_pixel; i++) {
+            const auto* pixel = pixels + i * num_channels;
+            auto* rgba_pixel = rgba_pixels + i * 4;
+
+            switch(num_channels) {
+                case 1:
+                    rgba_pixel[0] = pixel[0];
+                    rgba_pixel[1] = pixel[0];
+                    rgba_pixel[2] = pixel[0];
+                    rgba_pixel[3] = opaque_alpha;
+                    break;
+
+                case 2:
+                    rgba_pixel[0] = pixel[0];
+                    rgba_pixel[1] = pixel[0];
+                    rgba_pixel[2] = pixel[0];
+                    rgba_pixel[3] = pixel[1];
+                    break;
+
+                case 3:
+                    rgba_pixel[0] = pixel[0];
+                    rgba_pixel[1] = pixel[1];
+                    rgba_pixel[2] = pixel[2];
+                    rgba_pixel[3] = opaque_alpha;
+                    break;
+
+                default:
+                    rgba_pixel[0] = pixel[0];
+                    rgba_pixel[1] = pixel[1];
+                    rgba_pixel[2] = pixel[2];
+                    rgba_pixel[3] = pixel[3];
+                    break;
+            }
+        }
+    }
+
+#ifdef __AVX2__
+    // Each of these kernels expands as many pixels as it can with whole vectors, and returns how many that was
+
+    static Size expand_grey8(const Uint8* pixels, const Size num_pixels, Uint8* rgba_pixels) {
+        // Shuffle indices with the high bit set write zero, which the alpha gets ORed into
+        const auto low_shuffle = _mm256_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1,
+                                                  4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1);
+        const auto high_shuffle = _mm256_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1,
+                                                   12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1);
+        const auto alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        Size i{0};
+        for(; i + 16 <= num_pixels; i += 16) {
+            // Byte shuffles can't cross 128-bit lanes, so both lanes get all 16 pixels
+            const auto grey = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i)));
+
+            auto* destination = reinterpret_cast<__m256i*>(rgba_pixels + 4 * i);
+            _mm256_storeu_si256(destination, _mm256_or_si256(_mm256_shuffle_epi8(grey, low_shuffle), alpha));
+            _mm256_storeu_si256(destination + 1, _mm256_or_si256(_mm256_shuffle_epi8(grey, high_shuffle), alpha));
+        }
+
+        return i;
+    }
+
+    static Size expand_grey_alpha8(const Uint8* pixels, const Size num_pixels, Uint8* rgba_pixels) {
+        const auto shuffle = _mm256_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7,
+                                              8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+
+        Size i{0};
+        for(; i + 8 <= num_pixels; i += 8) {
+            const auto grey_alpha = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 2 * i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba_pixels + 4 * i), _mm256_shuffle_epi8(grey_alpha, shuffle));
+        }
+
+        return i;
+    }
+
+    static Size expand_rgb8(const Uint8* pixels, const Size num_pixels, Uint8* rgba_pixels) {
+        const auto shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                              0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const auto alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        // Each lane loads 16 bytes to get four 3-byte pixels, so stop while the second lane's load is still in the image
+        Size i{0};
+        for(; 3 * i + 28 <= 3 * num_pixels; i += 8) {
+            const auto* source = pixels + 3 * i;
+            const auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+            const auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 12));
+            const auto rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+
+            const auto rgba = _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba_pixels + 4 * i), rgba);
+        }
+
+        return i;
+    }
+
+    static Size expand_float_pixels(const Float32* pixels, const Uint32 num_channels, const Size num_pixels, Float32* rgba_pixels) {
+        const auto alpha = _mm_set1_ps(OPAQUE_ALPHA_32F);
+
+        Size i{0};
+        switch(num_channels) {
+            case 1:
+                for(; i < num_pixels; i++) {
+                    _mm_storeu_ps(rgba_pixels + 4 * i, _mm_blend_ps(_mm_set1_ps(pixels[i]), alpha, 0b1000));
+                }
+                break;
+
+            case 2:
+                for(; i < num_pixels; i++) {
+                    const auto grey_alpha = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(pixels + 2 * i)));
+                    _mm_storeu_ps(rgba_pixels + 4 * i, _mm_shuffle_ps(grey_alpha, grey_alpha, _MM_SHUFFLE(1, 0, 0, 0)));
+                }
+                break;
+
+            case 3:
+                // Loading a pixel reads the red channel of the next one, so the last pixel has to be expanded separately
+                for(; 3 * i + 4 <= 3 * num_pixels; i++) {
+                    _mm_storeu_ps(rgba_pixels + 4 * i, _mm_blend_ps(_mm_loadu_ps(pixels + 3 * i), alpha, 0b1000));
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        return i;
+    }
+#endif
+
+    void expand_to_rgba8(const Uint8* pixels, const Uint32 num_channels, const Size num_pixels, Uint8* rgba_pixels) {
+        ZoneScoped;
+
+        if(num_channels == 4) {
+            memcpy(rgba_pixels, pixels, num_pixels * 4);
+            return;
+        }
+
+        Size first_unexpanded_pixel{0};
+#ifdef __AVX2__
+        switch(num_channels) {
+            case 1:
+                first_unexpanded_pixel = expand_grey8(pixels, num_pixels, rgba_pixels);
+                break;
+
+            case 2:
+                first_unexpanded_pixel = expand_grey_alpha8(pixels, num_pixels, rgba_pixels);
+                break;
+
+            case 3:
+                first_unexpanded_pixel = expand_rgb8(pixels, num_pixels, rgba_pixels);
+                break;
+
+            default:
+                break;
+        }
+#endif
+
+        expand_pixels(pixels, num_channels, first_unexpanded_pixel, num_pixels, rgba_pixels, OPAQUE_ALPHA_8);
+    }
+
+    void expand_to_rgba32f(const Float32* pixels, const Uint32 num_channels, const Size num_pixels, Float32* rgba_pixels) {
+        if(num_channels == 4) {
+            memcpy(rgba_pixels, pixels, num_pixels * 4 * sizeof(Float32));
+            return;
+        }
+
+        Size first_unexpanded_pixel{0};
+#ifdef __AVX2__
+        first_unexpanded_pixel = expand_float_pixels(pixels, num_channels, num_pixels, rgba_pixels);
+#endif
+
+        expand_pixels(pixels, num_channels, first_unexpanded_pixel, num_pixels, rgba_pixels, OPAQUE_ALPHA_32F);
+    }
+
+    void expand_to_rgba16f(const Float32* pixels, const Uint32 num_channels, const Size num_pixels, Uint16* rgba_pixels) {
+        ZoneScoped;
+
+        Rx::Array<Float32[HALF_CONVERSION_BATCH_SIZE * 4]> rgba_batch;
+
+        for(Size batch_start = 0; batch_start < num_pixels; batch_start += HALF_CONVERSION_BATCH_SIZE) {
+            const auto batch_size = std::min(HALF_CONVERSION_BATCH_SIZE, num_pixels - batch_start);
+
+            expand_to_rgba32f(pixels + batch_start * num_channels, num_channels, batch_size, rgba_batch.data());
+            convert_to_half(rgba_batch.data(), batch_size * 4, rgba_pixels + batch_start * 4);
+        }
+    }
+
+    void convert_to_half(const Float32* values, const Size num_values, Uint16* half_values) {
+        Size i{0};
+#ifdef __AVX2__
+        // Every CPU with AVX2 has F16C
+        for(; i + 8 <= num_values; i += 8) {
+            const auto halves = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(half_values + i), halves);
+        }
+
+        for(; i < num_values; i++) {
+            half_values[i] = _cvtss_sh(values[i], _MM_FROUND_TO_NEAREST_INT);
+        }
+#else
+        for(; i < num_values; i++) {
+            half_values[i] = glm::packHalf1x16(values[i]);
+        }
+#endif
+    }
+
+    /*!
+     * \brief The loop that `load_texture` expanded images with before the vectorized kernels, kept to benchmark them against
+     *
+     * It copies three channels of every pixel no matter how many the image has, so one- and two-channel images need two components of
+     * padding at the end
+     */
+    template <typename ComponentType>
+    static ComponentType* copy_and_pad_texture_data(const ComponentType* original_data,
+                                                    const Uint32 width,
+                                                    const Uint32 height,
+                                                    const Uint32 original_num_components) {
+        const auto num_pixels = static_cast<Size>(width) * height;
+
+        auto* pixels = new ComponentType[num_pixels * 4];
+
+        if(original_num_components == 4) {
+            memcpy(pixels, original_data, num_pixels * 4 * sizeof(ComponentType));
+
+        } else {
+            for(Size i = 0; i < num_pixels; i++) {
+                const auto read_idx = i * original_num_components;
+                const auto write_idx = i * 4;
+
+                pixels[write_idx] = original_data[read_idx];
+                pixels[write_idx + 1] = original_data[read_idx + 1];
+                pixels[write_idx + 2] = original_data[read_idx + 2];
+                pixels[write_idx + 3] = static_cast<ComponentType>(0xFF);
+            }
+        }
+
+        return pixels;
+    }
+
+    template <typename FunctionType>
+    static Float64 time_ms(const Uint32 num_iterations, FunctionType&& function) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for(Uint32 i = 0; i < num_iterations; i++) {
+            function();
+        }
+        const auto duration = std::chrono::high_resolution_clock::now() - start;
+
+        const auto total_ms = static_cast<Float64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000000.0;
+        return total_ms / num_iterations;
+    }
+
+    PixelConversionBenchmarkResult benchmark_pixel_conversion(const Uint32 width, const Uint32 height, Uint32 num_iterations) {
+        ZoneScoped;
+
+        num_iterations = std::max(num_iterations, 1u);
+
+        const auto num_pixels = static_cast<Size>(width) * height;
+
+        // xorshift32, so the images don't depend on the standard library's random engines
+        Uint32 state = 1;
+        const auto next_random = [&] {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        };
+
+        // Two extra components so the old loop can read three channels of the last pixel of a one-channel image
+        Rx::Vector<Uint8> ldr_pixels;
+        ldr_pixels.resize(num_pixels * 3 + 2);
+        ldr_pixels.each_fwd([&](Uint8& component) { component = static_cast<Uint8>(next_random()); });
+
+        Rx::Vector<Float32> hdr_pixels;
+        hdr_pixels.resize(num_pixels * 3);
+        hdr_pixels.each_fwd([&](Float32& component) { component = static_cast<Float32>(next_random() % 65536) / 256.0f; });
+
+        PixelConversionBenchmarkResult result;
+
+        for(Uint32 num_channels = 1; num_channels <= 3; num_channels++) {
+            result.per_pixel_rgba8_ms[num_channels - 1] = time_ms(num_iterations, [&] {
+                delete[] copy_and_pad_texture_data(ldr_pixels.data(), width, height, num_channels);
+            });
+
+            result.vectorized_rgba8_ms[num_channels - 1] = time_ms(num_iterations, [&] {
+                auto* rgba_pixels = new Uint8[num_pixels * 4];
+                expand_to_rgba8(ldr_pixels.data(), num_channels, num_pixels, rgba_pixels);
+                delete[] rgba_pixels;
+            });
+        }
+
+        result.per_pixel_rgba32f_ms = time_ms(num_iterations, [&] {
+            delete[] copy_and_pad_texture_data(hdr_pixels.data(), width, height, 3);
+        });
+
+        result.vectorized_rgba16f_ms = time_ms(num_iterations, [&] {
+            auto* rgba_pixels = new Uint16[num_pixels * 4];
+            expand_to_rgba16f(hdr_pixels.data(), 3, num_pixels, rgba_pixels);
+            delete[] rgba_pixels;
+        });
+
+        return result;
+    }
+} // namespace sanity::engine
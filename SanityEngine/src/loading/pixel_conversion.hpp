@@ -0,0 +1,63 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/array.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief Expands an 8-bit image with one to four channels, laid out like stb_image returns them, to RGBA
+     *
+     * One-channel images are grey, two-channel images are grey and alpha. Images without alpha get opaque alpha
+     *
+     * \param rgba_pixels Memory for `num_pixels` RGBA8 pixels
+     */
+    void expand_to_rgba8(const Uint8* pixels, Uint32 num_channels, Size num_pixels, Uint8* rgba_pixels);
+
+    /*!
+     * \brief Expands a float image with one to four channels to RGBA, like `expand_to_rgba8` does. Missing alpha becomes 1
+     */
+    void expand_to_rgba32f(const Float32* pixels, Uint32 num_channels, Size num_pixels, Float32* rgba_pixels);
+
+    /*!
+     * \brief Expands a float image with one to four channels to RGBA and converts it to half floats, in one pass
+     *
+     * Values which are too large for a half float become infinity
+     *
+     * \param rgba_pixels Memory for `num_pixels` RGBA16F pixels
+     */
+    void expand_to_rgba16f(const Float32* pixels, Uint32 num_channels, Size num_pixels, Uint16* rgba_pixels);
+
+    /*!
+     * \brief Converts floats to half floats, rounding to the nearest half float
+     */
+    void convert_to_half(const Float32* values, Size num_values, Uint16* half_values);
+
+    struct PixelConversionBenchmarkResult {
+        /*!
+         * \brief Time that the old per-pixel loop took to expand a one-, two- and three-channel 8-bit image to RGBA8
+         */
+        Rx::Array<Float64[3]> per_pixel_rgba8_ms{};
+
+        /*!
+         * \brief Time that `expand_to_rgba8` took for a one-, two- and three-channel 8-bit image
+         */
+        Rx::Array<Float64[3]> vectorized_rgba8_ms{};
+
+        /*!
+         * \brief Time that the old per-pixel loop took to expand a three-channel float image to RGBA32F, like HDR images used to be loaded
+         */
+        Float64 per_pixel_rgba32f_ms{0};
+
+        /*!
+         * \brief Time that `expand_to_rgba16f` took for a three-channel float image
+         */
+        Float64 vectorized_rgba16f_ms{0};
+    };
+
+    /*!
+     * \brief Times the channel expansion kernels against the per-pixel loop that `load_texture` used before them, on generated images
+     *
+     * Every timed run allocates its output, like `load_texture` does
+     */
+    [[nodiscard]] PixelConversionBenchmarkResult benchmark_pixel_conversion(Uint32 width, Uint32 height, Uint32 num_iterations = 4);
+} // namespace sanity::engine
@@ -0,0 +1,937 @@
+#include "texture_compression.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include <limits>
+
+#include "Tracy.hpp"
+#include "core/async/thread_pool.hpp"
+#include "rx/core/assert.h"
+
+namespace sanity::engine {
+    using renderer::TextureFormat;
+
+    constexpr Uint32 BLOCK_DIMENSION = 4;
+
+    constexpr Uint32 TEXELS_PER_BLOCK = BLOCK_DIMENSION * BLOCK_DIMENSION;
+
+    /*!
+     * \brief Number of rows of blocks in each batch of a parallel compression
+     */
+    constexpr Uint32 BLOCK_ROWS_PER_BATCH = 4;
+
+    constexpr Float32 BC1_WEIGHTS[4] = {0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f};
+
+    /*!
+     * \brief Maps a texel's position between the two BC1 endpoints to its index in the block
+     */
+    constexpr Uint32 BC1_INDICES[4] = {0, 2, 3, 1};
+
+    /*!
+     * \brief Maps a texel's position between the two BC4 endpoints to its index in the block
+     */
+    constexpr Uint32 BC4_INDICES[8] = {0, 2, 3, 4, 5, 6, 7, 1};
+
+    /*!
+     * \brief Interpolation weights of BC7's four-bit indices, out of 64
+     */
+    constexpr Uint32 BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    constexpr Float32 BC7_FLOAT_WEIGHTS[16] = {0.0f / 64.0f,
+                                               4.0f / 64.0f,
+                                               9.0f / 64.0f,
+                                               13.0f / 64.0f,
+                                               17.0f / 64.0f,
+                                               21.0f / 64.0f,
+                                               26.0f / 64.0f,
+                                               30.0f / 64.0f,
+                                               34.0f / 64.0f,
+                                               38.0f / 64.0f,
+                                               43.0f / 64.0f,
+                                               47.0f / 64.0f,
+                                               51.0f / 64.0f,
+                                               55.0f / 64.0f,
+                                               60.0f / 64.0f,
+                                               64.0f / 64.0f};
+
+    constexpr Uint32 BC7_MODE_6 = 6;
+
+    /*!
+     * \brief The texels of one block, with each channel in its own array so that SSE can work on four texels at once
+     */
+    struct alignas(16) BlockTexels {
+        Float32 channels[4][TEXELS_PER_BLOCK];
+    };
+
+    struct BlockEndpoints {
+        Float32 start[4]{};
+
+        Float32 end[4]{};
+    };
+
+    /*!
+     * \brief Writes bits into a 128-bit block, starting from the least significant bit of the first byte
+     */
+    class BlockBitWriter {
+    public:
+        explicit BlockBitWriter(Uint8* block_in) : block{block_in} { memset(block, 0, 16); }
+
+        void write(const Uint32 value, const Uint32 num_bits) {
+            for(Uint32 i = 0; i < num_bits; i++) {
+                if(((value >> i) & 1) != 0) {
+                    block[position / 8] |= static_cast<Uint8>(1 << (position % 8));
+                }
+                position++;
+            }
+        }
+
+    private:
+        Uint8* block;
+
+        Uint32 position{0};
+    };
+
+    class BlockBitReader {
+    public:
+        explicit BlockBitReader(const Uint8* block_in) : block{block_in} {}
+
+        [[nodiscard]] Uint32 read(const Uint32 num_bits) {
+            Uint32 value = 0;
+            for(Uint32 i = 0; i < num_bits; i++) {
+                value |= ((block[position / 8] >> (position % 8)) & 1) << i;
+                position++;
+            }
+
+            return value;
+        }
+
+    private:
+        const Uint8* block;
+
+        Uint32 position{0};
+    };
+
+    static void load_block(
+        const Uint8* pixels, const Uint32 width, const Uint32 height, const Uint32 block_x, const Uint32 block_y, BlockTexels& texels) {
+        for(Uint32 y = 0; y < BLOCK_DIMENSION; y++) {
+            // Blocks which hang over the edge of the image repeat the last row and column
+            const auto source_y = std::min(block_y * BLOCK_DIMENSION + y, height - 1);
+            for(Uint32 x = 0; x < BLOCK_DIMENSION; x++) {
+                const auto source_x = std::min(block_x * BLOCK_DIMENSION + x, width - 1);
+                const auto* pixel = pixels + (static_cast<Size>(source_y) * width + source_x) * 4;
+
+                const auto texel = y * BLOCK_DIMENSION + x;
+                for(Uint32 channel = 0; channel < 4; channel++) {
+                    texels.channels[channel][texel] = static_cast<Float32>(pixel[channel]);
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Finds endpoints on the principal axis of the block's colors which enclose all the texels
+     */
+    static BlockEndpoints find_endpoints(const BlockTexels& texels, const Uint32 num_channels) {
+        Float32 mean[4]{};
+        for(Uint32 channel = 0; channel < num_channels; channel++) {
+            for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+                mean[channel] += texels.channels[channel][texel];
+            }
+            mean[channel] /= TEXELS_PER_BLOCK;
+        }
+
+        Float32 covariance[4][4]{};
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            for(Uint32 row = 0; row < num_channels; row++) {
+                const auto row_offset = texels.channels[row][texel] - mean[row];
+                for(Uint32 column = row; column < num_channels; column++) {
+                    covariance[row][column] += row_offset * (texels.channels[column][texel] - mean[column]);
+                }
+            }
+        }
+        for(Uint32 row = 0; row < num_channels; row++) {
+            for(Uint32 column = 0; column < row; column++) {
+                covariance[row][column] = covariance[column][row];
+            }
+        }
+
+        // Power iteration, starting from the channel which varies the most
+        Uint32 max_variance_channel = 0;
+        for(Uint32 channel = 1; channel < num_channels; channel++) {
+            if(covariance[channel][channel] > covariance[max_variance_channel][max_variance_channel]) {
+                max_variance_channel = channel;
+            }
+        }
+
+        Float32 axis[4]{};
+        for(Uint32 channel = 0; channel < num_channels; channel++) {
+            axis[channel] = covariance[max_variance_channel][channel];
+        }
+
+        for(Uint32 iteration = 0; iteration < 8; iteration++) {
+            Float32 new_axis[4]{};
+            Float32 max_component = 0;
+            for(Uint32 row = 0; row < num_channels; row++) {
+                for(Uint32 column = 0; column < num_channels; column++) {
+                    new_axis[row] += covariance[row][column] * axis[column];
+                }
+                max_component = std::max(max_component, std::abs(new_axis[row]));
+            }
+
+            if(max_component < 1e-6f) {
+                break;
+            }
+
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                axis[channel] = new_axis[channel] / max_component;
+            }
+        }
+
+        Float32 axis_length_squared = 0;
+        for(Uint32 channel = 0; channel < num_channels; channel++) {
+            axis_length_squared += axis[channel] * axis[channel];
+        }
+
+        BlockEndpoints endpoints;
+        if(axis_length_squared < 1e-6f) {
+            // Every texel has the same color
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                endpoints.start[channel] = mean[channel];
+                endpoints.end[channel] = mean[channel];
+            }
+
+            return endpoints;
+        }
+
+        auto min_projection = std::numeric_limits<Float32>::max();
+        auto max_projection = std::numeric_limits<Float32>::lowest();
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            Float32 projection = 0;
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                projection += (texels.channels[channel][texel] - mean[channel]) * axis[channel];
+            }
+
+            min_projection = std::min(min_projection, projection);
+            max_projection = std::max(max_projection, projection);
+        }
+
+        for(Uint32 channel = 0; channel < num_channels; channel++) {
+            const auto direction = axis[channel] / axis_length_squared;
+            endpoints.start[channel] = std::clamp(mean[channel] + direction * min_projection, 0.0f, 255.0f);
+            endpoints.end[channel] = std::clamp(mean[channel] + direction * max_projection, 0.0f, 255.0f);
+        }
+
+        return endpoints;
+    }
+
+    /*!
+     * \brief Finds the closest of `num_levels` evenly spaced points between the endpoints for every texel in the block
+     *
+     * \param levels Receives each texel's point, where 0 is the start endpoint and `num_levels - 1` is the end endpoint
+     */
+    static void fit_levels(const BlockTexels& texels,
+                           const Uint32 num_channels,
+                           const BlockEndpoints& endpoints,
+                           const Uint32 num_levels,
+                           Uint8 (&levels)[TEXELS_PER_BLOCK]) {
+        Float32 axis[4]{};
+        Float32 axis_length_squared = 0;
+        for(Uint32 channel = 0; channel < num_channels; channel++) {
+            axis[channel] = endpoints.end[channel] - endpoints.start[channel];
+            axis_length_squared += axis[channel] * axis[channel];
+        }
+
+        if(axis_length_squared < 1e-6f) {
+            memset(levels, 0, sizeof(levels));
+            return;
+        }
+
+        const auto scale = _mm_set1_ps(static_cast<Float32>(num_levels - 1) / axis_length_squared);
+        const auto max_level = _mm_set1_ps(static_cast<Float32>(num_levels - 1));
+
+        for(Uint32 first_texel = 0; first_texel < TEXELS_PER_BLOCK; first_texel += 4) {
+            auto projection = _mm_setzero_ps();
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                const auto offset = _mm_sub_ps(_mm_load_ps(&texels.channels[channel][first_texel]), _mm_set1_ps(endpoints.start[channel]));
+                projection = _mm_add_ps(projection, _mm_mul_ps(offset, _mm_set1_ps(axis[channel])));
+            }
+
+            const auto level = _mm_min_ps(_mm_max_ps(_mm_mul_ps(projection, scale), _mm_setzero_ps()), max_level);
+
+            alignas(16) Int32 texel_levels[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(texel_levels), _mm_cvtps_epi32(level));
+            for(Uint32 i = 0; i < 4; i++) {
+                levels[first_texel + i] = static_cast<Uint8>(texel_levels[i]);
+            }
+        }
+    }
+
+    /*!
+     * \brief Squared error of the block when each texel is replaced by its point between the endpoints
+     */
+    static Float32 get_block_error(const BlockTexels& texels,
+                                   const Uint32 num_channels,
+                                   const BlockEndpoints& endpoints,
+                                   const Uint8 (&levels)[TEXELS_PER_BLOCK],
+                                   const Float32* level_weights) {
+        alignas(16) Float32 weights[TEXELS_PER_BLOCK];
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            weights[texel] = level_weights[levels[texel]];
+        }
+
+        auto error = _mm_setzero_ps();
+        for(Uint32 first_texel = 0; first_texel < TEXELS_PER_BLOCK; first_texel += 4) {
+            const auto weight = _mm_load_ps(&weights[first_texel]);
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                const auto start = _mm_set1_ps(endpoints.start[channel]);
+                const auto end = _mm_set1_ps(endpoints.end[channel]);
+                const auto value = _mm_add_ps(start, _mm_mul_ps(_mm_sub_ps(end, start), weight));
+
+                const auto difference = _mm_sub_ps(_mm_load_ps(&texels.channels[channel][first_texel]), value);
+                error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+            }
+        }
+
+        alignas(16) Float32 errors[4];
+        _mm_store_ps(errors, error);
+
+        return errors[0] + errors[1] + errors[2] + errors[3];
+    }
+
+    /*!
+     * \brief Moves the endpoints to minimize the squared error of the block, keeping every texel at its point between the endpoints
+     */
+    static void refine_endpoints(const BlockTexels& texels,
+                                 const Uint32 num_channels,
+                                 const Uint8 (&levels)[TEXELS_PER_BLOCK],
+                                 const Float32* level_weights,
+                                 BlockEndpoints& endpoints) {
+        // Least squares fit of texel = start * (1 - weight) + end * weight
+        Float32 start_start = 0;
+        Float32 start_end = 0;
+        Float32 end_end = 0;
+        Float32 start_texel[4]{};
+        Float32 end_texel[4]{};
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            const auto end_weight = level_weights[levels[texel]];
+            const auto start_weight = 1.0f - end_weight;
+
+            start_start += start_weight * start_weight;
+            start_end += start_weight * end_weight;
+            end_end += end_weight * end_weight;
+
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                start_texel[channel] += start_weight * texels.channels[channel][texel];
+                end_texel[channel] += end_weight * texels.channels[channel][texel];
+            }
+        }
+
+        const auto determinant = start_start * end_end - start_end * start_end;
+        if(std::abs(determinant) < 1e-6f) {
+            // All the texels use the same point
+            return;
+        }
+
+        for(Uint32 channel = 0; channel < num_channels; channel++) {
+            const auto start = (start_texel[channel] * end_end - end_texel[channel] * start_end) / determinant;
+            const auto end = (end_texel[channel] * start_start - start_texel[channel] * start_end) / determinant;
+
+            endpoints.start[channel] = std::clamp(start, 0.0f, 255.0f);
+            endpoints.end[channel] = std::clamp(end, 0.0f, 255.0f);
+        }
+    }
+
+    static Uint16 to_rgb565(const Float32* color) {
+        const auto red = static_cast<Uint32>(std::lround(color[0] * 31.0f / 255.0f));
+        const auto green = static_cast<Uint32>(std::lround(color[1] * 63.0f / 255.0f));
+        const auto blue = static_cast<Uint32>(std::lround(color[2] * 31.0f / 255.0f));
+
+        return static_cast<Uint16>((red << 11) | (green << 5) | blue);
+    }
+
+    static void from_rgb565(const Uint16 color, Uint32 (&rgb)[3]) {
+        const auto red = (color >> 11) & 0x1F;
+        const auto green = (color >> 5) & 0x3F;
+        const auto blue = color & 0x1F;
+
+        rgb[0] = (red << 3) | (red >> 2);
+        rgb[1] = (green << 2) | (green >> 4);
+        rgb[2] = (blue << 3) | (blue >> 2);
+    }
+
+    static void from_rgb565(const Uint16 color, Float32* rgb) {
+        Uint32 integer_rgb[3];
+        from_rgb565(color, integer_rgb);
+
+        for(Uint32 channel = 0; channel < 3; channel++) {
+            rgb[channel] = static_cast<Float32>(integer_rgb[channel]);
+        }
+    }
+
+    static void write_little_endian(Uint8* destination, const Uint64 value, const Uint32 num_bytes) {
+        for(Uint32 i = 0; i < num_bytes; i++) {
+            destination[i] = static_cast<Uint8>(value >> (i * 8));
+        }
+    }
+
+    [[nodiscard]] static Uint64 read_little_endian(const Uint8* source, const Uint32 num_bytes) {
+        Uint64 value = 0;
+        for(Uint32 i = 0; i < num_bytes; i++) {
+            value |= static_cast<Uint64>(source[i]) << (i * 8);
+        }
+
+        return value;
+    }
+
+    static void encode_bc1_block(const BlockTexels& texels, Uint8* block) {
+        constexpr Uint32 NUM_CHANNELS = 3;
+
+        auto endpoints = find_endpoints(texels, NUM_CHANNELS);
+
+        auto best_error = std::numeric_limits<Float32>::max();
+        Uint16 best_colors[2]{};
+        Uint8 best_levels[TEXELS_PER_BLOCK]{};
+
+        // Try the principal axis endpoints, then the least squares fit of the texels to them
+        for(Uint32 iteration = 0; iteration < 2; iteration++) {
+            const Uint16 colors[2] = {to_rgb565(endpoints.start), to_rgb565(endpoints.end)};
+
+            BlockEndpoints quantized_endpoints;
+            from_rgb565(colors[0], quantized_endpoints.start);
+            from_rgb565(colors[1], quantized_endpoints.end);
+
+            Uint8 levels[TEXELS_PER_BLOCK];
+            fit_levels(texels, NUM_CHANNELS, quantized_endpoints, 4, levels);
+
+            const auto error = get_block_error(texels, NUM_CHANNELS, quantized_endpoints, levels, BC1_WEIGHTS);
+            if(error < best_error) {
+                best_error = error;
+                best_colors[0] = colors[0];
+                best_colors[1] = colors[1];
+                memcpy(best_levels, levels, sizeof(levels));
+            }
+
+            refine_endpoints(texels, NUM_CHANNELS, levels, BC1_WEIGHTS, endpoints);
+        }
+
+        // The first color must be greater than the second, otherwise the block is in three color mode
+        if(best_colors[0] < best_colors[1]) {
+            std::swap(best_colors[0], best_colors[1]);
+            for(auto& level : best_levels) {
+                level = static_cast<Uint8>(3 - level);
+            }
+        }
+
+        Uint32 indices = 0;
+        if(best_colors[0] != best_colors[1]) {
+            for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+                indices |= BC1_INDICES[best_levels[texel]] << (texel * 2);
+            }
+        }
+
+        write_little_endian(block, best_colors[0], 2);
+        write_little_endian(block + 2, best_colors[1], 2);
+        write_little_endian(block + 4, indices, 4);
+    }
+
+    static void encode_bc4_block(const BlockTexels& texels, const Uint32 channel, Uint8* block) {
+        const auto* values = texels.channels[channel];
+
+        auto min_value = values[0];
+        auto max_value = values[0];
+        for(Uint32 texel = 1; texel < TEXELS_PER_BLOCK; texel++) {
+            min_value = std::min(min_value, values[texel]);
+            max_value = std::max(max_value, values[texel]);
+        }
+
+        // The first endpoint must be greater than the second to get eight interpolated values
+        const auto start = static_cast<Uint8>(std::lround(max_value));
+        const auto end = static_cast<Uint8>(std::lround(min_value));
+
+        Uint64 indices = 0;
+        if(start != end) {
+            const auto scale = 7.0f / static_cast<Float32>(start - end);
+            for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+                const auto level = std::clamp(std::lround((static_cast<Float32>(start) - values[texel]) * scale), 0l, 7l);
+                indices |= static_cast<Uint64>(BC4_INDICES[level]) << (texel * 3);
+            }
+        }
+
+        block[0] = start;
+        block[1] = end;
+        write_little_endian(block + 2, indices, 6);
+    }
+
+    /*!
+     * \brief Quantizes an endpoint to BC7 mode 6's seven bits per channel plus a shared lowest bit, picking the lowest bit which fits best
+     */
+    static void quantize_bc7_endpoint(const Float32* endpoint, Uint32 (&quantized)[4], Uint32& p_bit, Float32* dequantized) {
+        // Try a set lowest bit first, so that ties keep 255 - and with it opaque alpha - exact
+        auto best_error = std::numeric_limits<Float32>::max();
+        for(const Uint32 candidate_p_bit : {1u, 0u}) {
+            Uint32 candidate[4];
+            Float32 error = 0;
+            for(Uint32 channel = 0; channel < 4; channel++) {
+                const auto value = std::lround((endpoint[channel] - static_cast<Float32>(candidate_p_bit)) / 2.0f);
+                candidate[channel] = static_cast<Uint32>(std::clamp(value, 0l, 127l));
+
+                const auto difference = static_cast<Float32>((candidate[channel] << 1) | candidate_p_bit) - endpoint[channel];
+                error += difference * difference;
+            }
+
+            if(error < best_error) {
+                best_error = error;
+                p_bit = candidate_p_bit;
+                memcpy(quantized, candidate, sizeof(candidate));
+            }
+        }
+
+        for(Uint32 channel = 0; channel < 4; channel++) {
+            dequantized[channel] = static_cast<Float32>((quantized[channel] << 1) | p_bit);
+        }
+    }
+
+    static void encode_bc7_block(const BlockTexels& texels, Uint8* block) {
+        constexpr Uint32 NUM_CHANNELS = 4;
+
+        auto endpoints = find_endpoints(texels, NUM_CHANNELS);
+
+        auto best_error = std::numeric_limits<Float32>::max();
+        Uint32 best_endpoints[2][4]{};
+        Uint32 best_p_bits[2]{};
+        Uint8 best_levels[TEXELS_PER_BLOCK]{};
+
+        for(Uint32 iteration = 0; iteration < 2; iteration++) {
+            Uint32 quantized[2][4];
+            Uint32 p_bits[2];
+            BlockEndpoints quantized_endpoints;
+            quantize_bc7_endpoint(endpoints.start, quantized[0], p_bits[0], quantized_endpoints.start);
+            quantize_bc7_endpoint(endpoints.end, quantized[1], p_bits[1], quantized_endpoints.end);
+
+            Uint8 levels[TEXELS_PER_BLOCK];
+            fit_levels(texels, NUM_CHANNELS, quantized_endpoints, 16, levels);
+
+            const auto error = get_block_error(texels, NUM_CHANNELS, quantized_endpoints, levels, BC7_FLOAT_WEIGHTS);
+            if(error < best_error) {
+                best_error = error;
+                memcpy(best_endpoints, quantized, sizeof(quantized));
+                memcpy(best_p_bits, p_bits, sizeof(p_bits));
+                memcpy(best_levels, levels, sizeof(levels));
+            }
+
+            refine_endpoints(texels, NUM_CHANNELS, levels, BC7_FLOAT_WEIGHTS, endpoints);
+        }
+
+        // The first texel's index has an implicit leading zero, so it must be in the first half of the range
+        if(best_levels[0] >= 8) {
+            for(Uint32 channel = 0; channel < 4; channel++) {
+                std::swap(best_endpoints[0][channel], best_endpoints[1][channel]);
+            }
+            std::swap(best_p_bits[0], best_p_bits[1]);
+
+            for(auto& level : best_levels) {
+                level = static_cast<Uint8>(15 - level);
+            }
+        }
+
+        auto writer = BlockBitWriter{block};
+        writer.write(1 << BC7_MODE_6, BC7_MODE_6 + 1);
+
+        for(Uint32 channel = 0; channel < 4; channel++) {
+            writer.write(best_endpoints[0][channel], 7);
+            writer.write(best_endpoints[1][channel], 7);
+        }
+
+        writer.write(best_p_bits[0], 1);
+        writer.write(best_p_bits[1], 1);
+
+        writer.write(best_levels[0], 3);
+        for(Uint32 texel = 1; texel < TEXELS_PER_BLOCK; texel++) {
+            writer.write(best_levels[texel], 4);
+        }
+    }
+
+    static void encode_block(const BlockTexels& texels, const TextureFormat format, Uint8* block) {
+        switch(format) {
+            case TextureFormat::Bc1:
+                encode_bc1_block(texels, block);
+                break;
+
+            case TextureFormat::Bc3:
+                encode_bc4_block(texels, 3, block);
+                encode_bc1_block(texels, block + 8);
+                break;
+
+            case TextureFormat::Bc4:
+                encode_bc4_block(texels, 0, block);
+                break;
+
+            case TextureFormat::Bc5:
+                encode_bc4_block(texels, 0, block);
+                encode_bc4_block(texels, 1, block + 8);
+                break;
+
+            case TextureFormat::Bc7:
+                encode_bc7_block(texels, block);
+                break;
+
+            default:
+                RX_ASSERT(false, "Format %u is not block compressed", static_cast<Uint32>(format));
+        }
+    }
+
+    static void decode_bc1_block(const Uint8* block, Uint8 (&texels)[TEXELS_PER_BLOCK][4]) {
+        const auto first_color = static_cast<Uint16>(read_little_endian(block, 2));
+        const auto second_color = static_cast<Uint16>(read_little_endian(block + 2, 2));
+        const auto indices = static_cast<Uint32>(read_little_endian(block + 4, 4));
+
+        Uint32 first_rgb[3];
+        Uint32 second_rgb[3];
+        from_rgb565(first_color, first_rgb);
+        from_rgb565(second_color, second_rgb);
+
+        Uint32 palette[4][4];
+        for(Uint32 channel = 0; channel < 3; channel++) {
+            palette[0][channel] = first_rgb[channel];
+            palette[1][channel] = second_rgb[channel];
+            if(first_color > second_color) {
+                palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+                palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+
+            } else {
+                palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+                palette[3][channel] = 0;
+            }
+        }
+        palette[0][3] = 255;
+        palette[1][3] = 255;
+        palette[2][3] = 255;
+        palette[3][3] = first_color > second_color ? 255 : 0;
+
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            const auto index = (indices >> (texel * 2)) & 0x3;
+            for(Uint32 channel = 0; channel < 4; channel++) {
+                texels[texel][channel] = static_cast<Uint8>(palette[index][channel]);
+            }
+        }
+    }
+
+    static void decode_bc4_block(const Uint8* block, const Uint32 channel, Uint8 (&texels)[TEXELS_PER_BLOCK][4]) {
+        const Uint32 start = block[0];
+        const Uint32 end = block[1];
+        const auto indices = read_little_endian(block + 2, 6);
+
+        Uint32 palette[8] = {start, end};
+        if(start > end) {
+            for(Uint32 i = 2; i < 8; i++) {
+                palette[i] = ((8 - i) * start + (i - 1) * end) / 7;
+            }
+
+        } else {
+            for(Uint32 i = 2; i < 6; i++) {
+                palette[i] = ((6 - i) * start + (i - 1) * end) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            texels[texel][channel] = static_cast<Uint8>(palette[(indices >> (texel * 3)) & 0x7]);
+        }
+    }
+
+    static void decode_bc7_block(const Uint8* block, Uint8 (&texels)[TEXELS_PER_BLOCK][4]) {
+        auto reader = BlockBitReader{block};
+        if(reader.read(BC7_MODE_6 + 1) != 1 << BC7_MODE_6) {
+            memset(texels, 0, sizeof(texels));
+            return;
+        }
+
+        Uint32 endpoints[2][4];
+        for(Uint32 channel = 0; channel < 4; channel++) {
+            endpoints[0][channel] = reader.read(7);
+            endpoints[1][channel] = reader.read(7);
+        }
+
+        const Uint32 p_bits[2] = {reader.read(1), reader.read(1)};
+        for(Uint32 endpoint = 0; endpoint < 2; endpoint++) {
+            for(Uint32 channel = 0; channel < 4; channel++) {
+                endpoints[endpoint][channel] = (endpoints[endpoint][channel] << 1) | p_bits[endpoint];
+            }
+        }
+
+        for(Uint32 texel = 0; texel < TEXELS_PER_BLOCK; texel++) {
+            const auto weight = BC7_WEIGHTS[reader.read(texel == 0 ? 3 : 4)];
+            for(Uint32 channel = 0; channel < 4; channel++) {
+                const auto value = ((64 - weight) * endpoints[0][channel] + weight * endpoints[1][channel] + 32) >> 6;
+                texels[texel][channel] = static_cast<Uint8>(value);
+            }
+        }
+    }
+
+    static void decode_block(const Uint8* block, const TextureFormat format, Uint8 (&texels)[TEXELS_PER_BLOCK][4]) {
+        switch(format) {
+            case TextureFormat::Bc1:
+                decode_bc1_block(block, texels);
+                break;
+
+            case TextureFormat::Bc3:
+                decode_bc1_block(block + 8, texels);
+                decode_bc4_block(block, 3, texels);
+                break;
+
+            case TextureFormat::Bc4:
+                for(auto& texel : texels) {
+                    texel[1] = 0;
+                    texel[2] = 0;
+                    texel[3] = 255;
+                }
+                decode_bc4_block(block, 0, texels);
+                break;
+
+            case TextureFormat::Bc5:
+                for(auto& texel : texels) {
+                    texel[2] = 0;
+                    texel[3] = 255;
+                }
+                decode_bc4_block(block, 0, texels);
+                decode_bc4_block(block + 8, 1, texels);
+                break;
+
+            case TextureFormat::Bc7:
+                decode_bc7_block(block, texels);
+                break;
+
+            default:
+                RX_ASSERT(false, "Format %u is not block compressed", static_cast<Uint32>(format));
+        }
+    }
+
+    renderer::TextureFormat get_compressed_format(const TextureCompressionUsage usage, const bool has_alpha) {
+        switch(usage) {
+            case TextureCompressionUsage::BaseColor:
+                return has_alpha ? TextureFormat::Bc7 : TextureFormat::Bc1;
+
+            case TextureCompressionUsage::Emission:
+                return TextureFormat::Bc1;
+
+            case TextureCompressionUsage::NormalMap:
+                return TextureFormat::Bc5;
+
+            case TextureCompressionUsage::Roughness:
+                [[fallthrough]];
+            case TextureCompressionUsage::Metallic:
+                return TextureFormat::Bc4;
+
+            case TextureCompressionUsage::MetallicRoughness:
+                [[fallthrough]];
+            default:
+                return TextureFormat::Bc7;
+        }
+    }
+
+    MipGenerationOptions get_mip_generation_options(const TextureCompressionUsage usage, const Rx::Optional<Float32>& alpha_cutoff) {
+        const auto is_srgb = usage == TextureCompressionUsage::BaseColor || usage == TextureCompressionUsage::Emission;
+
+        // Only base color has the alpha that the alpha test reads
+        return MipGenerationOptions{.filter = MipFilter::Kaiser,
+                                    .is_srgb = is_srgb,
+                                    .alpha_cutoff = usage == TextureCompressionUsage::BaseColor ? alpha_cutoff : Rx::nullopt};
+    }
+
+    bool has_alpha(const Uint8* pixels, const Uint32 width, const Uint32 height) {
+        const auto num_pixels = static_cast<Size>(width) * height;
+        for(Size pixel = 0; pixel < num_pixels; pixel++) {
+            if(pixels[pixel * 4 + 3] != 0xFF) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    Rx::Vector<Uint8> compress_texture(
+        const Uint8* pixels, const Uint32 width, const Uint32 height, const renderer::TextureFormat format, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        RX_ASSERT(renderer::is_block_compressed(format), "Can not compress a texture to format %u", static_cast<Uint32>(format));
+
+        const auto num_blocks_x = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+        const auto num_blocks_y = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+        const auto block_size = renderer::get_block_size_in_bytes(format);
+
+        Rx::Vector<Uint8> blocks;
+        blocks.resize(static_cast<Size>(num_blocks_x) * num_blocks_y * block_size);
+
+        const auto compress_rows = [&](const Uint32 first_row, const Uint32 last_row) {
+            BlockTexels texels;
+            for(auto block_y = first_row; block_y < last_row; block_y++) {
+                for(Uint32 block_x = 0; block_x < num_blocks_x; block_x++) {
+                    load_block(pixels, width, height, block_x, block_y, texels);
+
+                    auto* block = blocks.data() + (static_cast<Size>(block_y) * num_blocks_x + block_x) * block_size;
+                    encode_block(texels, format, block);
+                }
+            }
+        };
+
+        if(thread_pool != nullptr && num_blocks_y > BLOCK_ROWS_PER_BATCH) {
+            thread_pool->parallel_for(num_blocks_y, BLOCK_ROWS_PER_BATCH, compress_rows);
+
+        } else {
+            compress_rows(0, num_blocks_y);
+        }
+
+        return blocks;
+    }
+
+    Rx::Vector<Uint8> compress_mip_chain(const Uint8* mip_chain,
+                                         const Uint32 width,
+                                         const Uint32 height,
+                                         const Uint32 num_mips,
+                                         const renderer::TextureFormat format,
+                                         ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        Rx::Vector<Uint8> blocks;
+        blocks.resize(renderer::get_mip_chain_size_in_bytes(format, width, height, num_mips));
+
+        auto* mip_blocks = blocks.data();
+        const auto* mip_pixels = mip_chain;
+        for(Uint32 mip_level = 0; mip_level < num_mips; mip_level++) {
+            const auto mip_width = renderer::get_mip_dimension(width, mip_level);
+            const auto mip_height = renderer::get_mip_dimension(height, mip_level);
+
+            const auto compressed_mip = compress_texture(mip_pixels, mip_width, mip_height, format, thread_pool);
+            std::memcpy(mip_blocks, compressed_mip.data(), compressed_mip.size());
+
+            mip_blocks += compressed_mip.size();
+            mip_pixels += static_cast<Size>(mip_width) * mip_height * 4;
+        }
+
+        return blocks;
+    }
+
+    Rx::Vector<Uint8> decompress_texture(const Uint8* blocks, const Uint32 width, const Uint32 height, const renderer::TextureFormat format) {
+        ZoneScoped;
+
+        const auto num_blocks_x = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+        const auto num_blocks_y = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+        const auto block_size = renderer::get_block_size_in_bytes(format);
+
+        Rx::Vector<Uint8> pixels;
+        pixels.resize(static_cast<Size>(width) * height * 4);
+
+        Uint8 texels[TEXELS_PER_BLOCK][4];
+        for(Uint32 block_y = 0; block_y < num_blocks_y; block_y++) {
+            for(Uint32 block_x = 0; block_x < num_blocks_x; block_x++) {
+                decode_block(blocks + (static_cast<Size>(block_y) * num_blocks_x + block_x) * block_size, format, texels);
+
+                for(Uint32 y = 0; y < BLOCK_DIMENSION; y++) {
+                    const auto pixel_y = block_y * BLOCK_DIMENSION + y;
+                    for(Uint32 x = 0; x < BLOCK_DIMENSION; x++) {
+                        const auto pixel_x = block_x * BLOCK_DIMENSION + x;
+                        if(pixel_x < width && pixel_y < height) {
+                            memcpy(&pixels[(static_cast<Size>(pixel_y) * width + pixel_x) * 4], texels[y * BLOCK_DIMENSION + x], 4);
+                        }
+                    }
+                }
+            }
+        }
+
+        return pixels;
+    }
+
+    Uint32 get_num_compressed_channels(const renderer::TextureFormat format) {
+        switch(format) {
+            case TextureFormat::Bc1:
+                return 3;
+
+            case TextureFormat::Bc4:
+                return 1;
+
+            case TextureFormat::Bc5:
+                return 2;
+
+            default:
+                return 4;
+        }
+    }
+
+    Float64 get_psnr(const Uint8* original, const Uint8* compressed, const Uint32 width, const Uint32 height, const Uint32 num_channels) {
+        const auto num_pixels = static_cast<Size>(width) * height;
+
+        Float64 squared_error = 0;
+        for(Size pixel = 0; pixel < num_pixels; pixel++) {
+            for(Uint32 channel = 0; channel < num_channels; channel++) {
+                const auto difference = static_cast<Float64>(original[pixel * 4 + channel]) - compressed[pixel * 4 + channel];
+                squared_error += difference * difference;
+            }
+        }
+
+        if(squared_error == 0) {
+            return std::numeric_limits<Float64>::infinity();
+        }
+
+        const auto mean_squared_error = squared_error / static_cast<Float64>(num_pixels * num_channels);
+        return 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+    }
+
+    TextureCompressionBenchmarkResult benchmark_texture_compression(const Uint8* pixels,
+                                                                    const Uint32 width,
+                                                                    const Uint32 height,
+                                                                    const renderer::TextureFormat format,
+                                                                    ThreadPool* thread_pool,
+                                                                    const Uint32 num_iterations) {
+        ZoneScoped;
+
+        Rx::Vector<Uint8> blocks;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for(Uint32 i = 0; i < std::max(num_iterations, 1u); i++) {
+            blocks = compress_texture(pixels, width, height, format, thread_pool);
+        }
+        const auto duration = std::chrono::high_resolution_clock::now() - start;
+
+        const auto total_ms = static_cast<Float64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000000.0;
+        const auto compression_ms = total_ms / std::max(num_iterations, 1u);
+
+        const auto decompressed_pixels = decompress_texture(blocks.data(), width, height, format);
+
+        const auto megapixels = static_cast<Float64>(width) * height / 1000000.0;
+        return TextureCompressionBenchmarkResult{
+            .format = format,
+            .psnr = get_psnr(pixels, decompressed_pixels.data(), width, height, get_num_compressed_channels(format)),
+            .compression_ms = compression_ms,
+            .megapixels_per_second = compression_ms > 0 ? megapixels / (compression_ms / 1000.0) : 0,
+        };
+    }
+
+    const char* to_string(const TextureCompressionUsage usage) {
+        switch(usage) {
+            case TextureCompressionUsage::BaseColor:
+                return "base_color";
+
+            case TextureCompressionUsage::Emission:
+                return "emission";
+
+            case TextureCompressionUsage::NormalMap:
+                return "normal_map";
+
+            case TextureCompressionUsage::Roughness:
+                return "roughness";
+
+            case TextureCompressionUsage::Metallic:
+                return "metallic";
+
+            case TextureCompressionUsage::MetallicRoughness:
+                return "metallic_roughness";
+
+            default:
+                return "unknown";
+        }
+    }
+} // namespace sanity::engine
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "loading/mip_generation.hpp"
+#include "renderer/rhi/resources.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+
+    /*!
+     * \brief What a texture is used for. Decides which block compressed format it gets
+     */
+    enum class TextureCompressionUsage {
+        BaseColor,
+        Emission,
+        NormalMap,
+
+        /*!
+         * \brief Single-channel roughness map, read from the red channel
+         */
+        Roughness,
+
+        /*!
+         * \brief Single-channel metalness map, read from the red channel
+         */
+        Metallic,
+
+        /*!
+         * \brief glTF-style packed texture with roughness in green and metalness in blue
+         */
+        MetallicRoughness,
+    };
+
+    struct CompressedTexture {
+        renderer::TextureFormat format{renderer::TextureFormat::Bc7};
+
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        Uint32 num_mips{1};
+
+        /*!
+         * \brief The texture's 4x4 blocks, one row of blocks after another, with each mip after the one above it
+         */
+        Rx::Vector<Uint8> blocks;
+    };
+
+    /*!
+     * \brief Selects the block compressed format for a texture
+     *
+     * Base color gets BC1 if it's opaque and BC7 if it isn't, normal maps get BC5, and single-channel maps get BC4. Packed textures get
+     * BC7, so that the shaders can keep reading each value from its channel
+     */
+    [[nodiscard]] renderer::TextureFormat get_compressed_format(TextureCompressionUsage usage, bool has_alpha);
+
+    /*!
+     * \brief Selects how to generate the mips of a texture. Base color and emission are sRGB, everything else is linear data
+     *
+     * \param alpha_cutoff Alpha test threshold of the material which uses the texture, if it has one
+     */
+    [[nodiscard]] MipGenerationOptions get_mip_generation_options(TextureCompressionUsage usage,
+                                                                  const Rx::Optional<Float32>& alpha_cutoff = Rx::nullopt);
+
+    /*!
+     * \brief Checks if any pixel of an RGBA8 image isn't fully opaque
+     */
+    [[nodiscard]] bool has_alpha(const Uint8* pixels, Uint32 width, Uint32 height);
+
+    /*!
+     * \brief Compresses an RGBA8 image to BC1, BC3, BC4, BC5, or BC7
+     *
+     * BC4 compresses the red channel, and BC5 compresses the red and green channels. BC7 blocks are all written in mode 6. Images whose
+     * size isn't a multiple of four are padded by repeating their last row and column
+     *
+     * \param thread_pool Thread pool to spread the rows of blocks over. If this is nullptr, all work happens on the calling thread
+     */
+    [[nodiscard]] Rx::Vector<Uint8> compress_texture(
+        const Uint8* pixels, Uint32 width, Uint32 height, renderer::TextureFormat format, ThreadPool* thread_pool = nullptr);
+
+    /*!
+     * \brief Compresses every mip of an RGBA8 mip chain, such as the one `generate_mip_chain` returns
+     *
+     * \return The blocks of all the mips, with each mip after the one above it
+     */
+    [[nodiscard]] Rx::Vector<Uint8> compress_mip_chain(const Uint8* mip_chain,
+                                                       Uint32 width,
+                                                       Uint32 height,
+                                                       Uint32 num_mips,
+                                                       renderer::TextureFormat format,
+                                                       ThreadPool* thread_pool = nullptr);
+
+    /*!
+     * \brief Decompresses blocks which `compress_texture` wrote back to RGBA8, like a GPU would sample them
+     *
+     * Only supports BC7 mode 6, because that's the only mode which `compress_texture` writes
+     */
+    [[nodiscard]] Rx::Vector<Uint8> decompress_texture(const Uint8* blocks, Uint32 width, Uint32 height, renderer::TextureFormat format);
+
+    /*!
+     * \brief Number of channels which a block compressed format stores. These are the channels which get compared when measuring quality
+     */
+    [[nodiscard]] Uint32 get_num_compressed_channels(renderer::TextureFormat format);
+
+    /*!
+     * \brief Peak signal-to-noise ratio between two RGBA8 images, over their first `num_channels` channels. Identical images give infinity
+     */
+    [[nodiscard]] Float64 get_psnr(const Uint8* original, const Uint8* compressed, Uint32 width, Uint32 height, Uint32 num_channels);
+
+    struct TextureCompressionBenchmarkResult {
+        renderer::TextureFormat format{renderer::TextureFormat::Bc7};
+
+        /*!
+         * \brief Quality of the compressed texture, in dB
+         */
+        Float64 psnr{0};
+
+        /*!
+         * \brief Average time that compressing the texture took
+         */
+        Float64 compression_ms{0};
+
+        Float64 megapixels_per_second{0};
+    };
+
+    /*!
+     * \brief Compresses an RGBA8 image a few times, then measures the quality of the result. Doesn't need a GPU
+     */
+    [[nodiscard]] TextureCompressionBenchmarkResult benchmark_texture_compression(const Uint8* pixels,
+                                                                                  Uint32 width,
+                                                                                  Uint32 height,
+                                                                                  renderer::TextureFormat format,
+                                                                                  ThreadPool* thread_pool = nullptr,
+                                                                                  Uint32 num_iterations = 4);
+
+    [[nodiscard]] const char* to_string(TextureCompressionUsage usage);
+} // namespace sanity::engine
@@ -0,0 +1,425 @@
+#include "texture_container.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio> // fopen, fwrite, fclose
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "adapters/rex/rex_wrapper.hpp"
+#include "core/align.hpp"
+#include "core/fs/path_ops.hpp"
+#include "loading/compressed_texture_cache.hpp"
+#include "loading/image_loading.hpp"
+#include "renderer/rhi/helpers.hpp"
+#include "rx/core/log.h"
+#include "rx/core/utility/move.h"
+#include "sanity_engine.hpp"
+
+namespace sanity::engine {
+    RX_LOG("TextureContainer", logger);
+
+    constexpr Uint32 TEXTURE_CONTAINER_MAGIC = 0x58455453; // "STEX"
+
+    /*!
+     * \brief Increment this when the file format or the way images are converted changes, so that old containers get rewritten
+     */
+    constexpr Uint32 TEXTURE_CONTAINER_VERSION = 2;
+
+    /*!
+     * \brief More mips than a 64k x 64k texture has, so a container claiming more is corrupt
+     */
+    constexpr Uint32 MAX_NUM_CONTAINER_MIPS = 17;
+
+    struct TextureContainerHeader {
+        Uint32 magic{TEXTURE_CONTAINER_MAGIC};
+
+        Uint32 version{TEXTURE_CONTAINER_VERSION};
+
+        Uint32 format{0};
+
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        Uint32 num_mips{0};
+
+        Uint64 source_size{0};
+
+        Int64 source_write_time{0};
+
+        /*!
+         * \brief Offset of the mip data from the start of the file. Aligned like the mips themselves, so that the data can be copied to
+         * staging memory as one block
+         */
+        Uint64 data_offset{0};
+
+        Uint64 data_size{0};
+    };
+
+    /*!
+     * \brief Where a mip is in the container's data and how its rows are laid out. The mip table comes right after the header
+     */
+    struct TextureContainerMip {
+        /*!
+         * \brief Offset of the mip from the start of the container's data
+         */
+        Uint64 offset{0};
+
+        /*!
+         * \brief Width of the mip's footprint. Rounded up to whole blocks for block compressed formats
+         */
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        Uint32 row_pitch{0};
+
+        Uint32 num_rows{0};
+    };
+
+    static std::filesystem::path get_full_path(const std::filesystem::path& image_path) {
+        // Same as load_texture, so that the container is next to the image that was loaded
+        return SanityEngine::executable_directory / image_path;
+    }
+
+    bool TextureContainer::open(const std::filesystem::path& container_path) {
+        ZoneScoped;
+
+        close();
+
+        if(!file.open(container_path)) {
+            return false;
+        }
+
+        const auto* file_data = file.get_data();
+        const auto file_size = file.get_size();
+        if(file_size < sizeof(TextureContainerHeader)) {
+            close();
+            return false;
+        }
+
+        const auto* new_header = reinterpret_cast<const TextureContainerHeader*>(file_data);
+        const auto mip_table_end = sizeof(TextureContainerHeader) + static_cast<Size>(new_header->num_mips) * sizeof(TextureContainerMip);
+        const auto is_valid = new_header->magic == TEXTURE_CONTAINER_MAGIC && new_header->version == TEXTURE_CONTAINER_VERSION &&
+                              new_header->num_mips > 0 && new_header->num_mips <= MAX_NUM_CONTAINER_MIPS &&
+                              new_header->format <= static_cast<Uint32>(renderer::TextureFormat::Bc7) &&
+                              new_header->data_offset >= mip_table_end && new_header->data_offset + new_header->data_size <= file_size;
+        if(!is_valid) {
+            logger->warning("Texture container %s is invalid or out of date", container_path);
+            close();
+            return false;
+        }
+
+        const auto* new_mips = reinterpret_cast<const TextureContainerMip*>(file_data + sizeof(TextureContainerHeader));
+        for(Uint32 mip_level = 0; mip_level < new_header->num_mips; mip_level++) {
+            const auto& mip = new_mips[mip_level];
+            if(mip.offset + static_cast<Uint64>(mip.row_pitch) * mip.num_rows > new_header->data_size) {
+                logger->warning("Mip %u of texture container %s is past the end of the file", mip_level, container_path);
+                close();
+                return false;
+            }
+        }
+
+        header = new_header;
+        mips = new_mips;
+
+        return true;
+    }
+
+    void TextureContainer::close() {
+        header = nullptr;
+        mips = nullptr;
+        file.close();
+    }
+
+    bool TextureContainer::is_open() const { return header != nullptr; }
+
+    renderer::TextureFormat TextureContainer::get_format() const { return static_cast<renderer::TextureFormat>(header->format); }
+
+    Uint32 TextureContainer::get_width() const { return header->width; }
+
+    Uint32 TextureContainer::get_height() const { return header->height; }
+
+    Uint32 TextureContainer::get_num_mips() const { return header->num_mips; }
+
+    bool TextureContainer::is_up_to_date(const std::filesystem::path& full_image_path) const {
+        Uint64 source_size;
+        Int64 source_write_time;
+        if(!get_file_size_and_write_time(full_image_path, source_size, source_write_time)) {
+            return false;
+        }
+
+        return header->source_size == source_size && header->source_write_time == source_write_time;
+    }
+
+    renderer::TextureCreateInfo TextureContainer::get_create_info(const Rx::String& name) const {
+        const auto has_all_mips = renderer::is_block_compressed(get_format()) ||
+                                  header->num_mips == renderer::get_num_mips(header->width, header->height);
+
+        return renderer::TextureCreateInfo{.name = name,
+                                           .usage = renderer::TextureUsage::SampledTexture,
+                                           .format = get_format(),
+                                           .width = header->width,
+                                           .height = header->height,
+                                           .num_mips = has_all_mips ? header->num_mips : 0};
+    }
+
+    renderer::PlacedTextureData TextureContainer::get_placed_data() const {
+        const auto dxgi_format = renderer::to_dxgi_format(get_format());
+
+        auto placed_data = renderer::PlacedTextureData{.data = file.get_data() + header->data_offset, .size = header->data_size};
+        placed_data.mip_footprints.reserve(header->num_mips);
+
+        for(Uint32 mip_level = 0; mip_level < header->num_mips; mip_level++) {
+            const auto& mip = mips[mip_level];
+            placed_data.mip_footprints.push_back(D3D12_PLACED_SUBRESOURCE_FOOTPRINT{
+                .Offset = mip.offset,
+                .Footprint = {.Format = dxgi_format, .Width = mip.width, .Height = mip.height, .Depth = 1, .RowPitch = mip.row_pitch},
+            });
+        }
+
+        return placed_data;
+    }
+
+    std::filesystem::path get_texture_container_path(const std::filesystem::path& image_path,
+                                                     const Rx::Optional<TextureCompressionUsage>& compression_usage) {
+        // Compressed and uncompressed versions of an image are different textures, so they need different files
+        const auto extension = compression_usage ? Rx::String::format("%s.stex", to_string(*compression_usage)) : Rx::String{"stex"};
+        return append_extension(get_full_path(image_path), extension.data());
+    }
+
+    bool write_texture_container(const std::filesystem::path& container_path,
+                                 const renderer::TextureFormat format,
+                                 const Uint32 width,
+                                 const Uint32 height,
+                                 const Uint32 num_mips,
+                                 const Uint8* mip_chain,
+                                 const std::filesystem::path& full_image_path) {
+        ZoneScoped;
+
+        auto header = TextureContainerHeader{.format = static_cast<Uint32>(format), .width = width, .height = height, .num_mips = num_mips};
+        if(!get_file_size_and_write_time(full_image_path, header.source_size, header.source_write_time)) {
+            return false;
+        }
+
+        const auto footprints = renderer::get_placed_mip_footprints(format, width, height, num_mips, header.data_size);
+
+        const auto mip_table_end = sizeof(TextureContainerHeader) + static_cast<Size>(num_mips) * sizeof(TextureContainerMip);
+        header.data_offset = ALIGN(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, mip_table_end);
+
+        // Build the whole file in memory, so that it's written with one call. The padding gets zeroed
+        Rx::Vector<Uint8> file_data;
+        file_data.resize(header.data_offset + header.data_size, 0);
+
+        memcpy(file_data.data(), &header, sizeof(TextureContainerHeader));
+
+        auto* mip_table = reinterpret_cast<TextureContainerMip*>(file_data.data() + sizeof(TextureContainerHeader));
+        auto* data = file_data.data() + header.data_offset;
+
+        const auto* mip_pixels = mip_chain;
+        for(Uint32 mip_level = 0; mip_level < num_mips; mip_level++) {
+            const auto& footprint = footprints[mip_level];
+            const auto tight_row_pitch = renderer::get_row_pitch(format, renderer::get_mip_dimension(width, mip_level));
+            const auto num_rows = renderer::get_num_rows(format, renderer::get_mip_dimension(height, mip_level));
+
+            mip_table[mip_level] = TextureContainerMip{.offset = footprint.Offset,
+                                                       .width = footprint.Footprint.Width,
+                                                       .height = footprint.Footprint.Height,
+                                                       .row_pitch = footprint.Footprint.RowPitch,
+                                                       .num_rows = num_rows};
+
+            for(Uint32 row = 0; row < num_rows; row++) {
+                memcpy(data + footprint.Offset + static_cast<Uint64>(row) * footprint.Footprint.RowPitch, mip_pixels, tight_row_pitch);
+                mip_pixels += tight_row_pitch;
+            }
+        }
+
+        // Write to a temporary file and move it into place, so that nothing maps a half-written container
+        const auto temp_path = append_extension(container_path, "tmp");
+        const auto temp_path_string = temp_path.string();
+        auto* container_file = fopen(temp_path_string.c_str(), "wb");
+        if(container_file == nullptr) {
+            logger->error("Could not open texture container %s for writing", temp_path);
+            return false;
+        }
+
+        const auto wrote_data = fwrite(file_data.data(), sizeof(Uint8), file_data.size(), container_file) == file_data.size();
+        fclose(container_file);
+
+        std::error_code error;
+        if(wrote_data) {
+            std::filesystem::rename(temp_path, container_path, error);
+        }
+
+        if(!wrote_data || error) {
+            logger->error("Could not write texture container %s", container_path);
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool load_texture_container(const std::filesystem::path& image_path,
+                                TextureContainer& container,
+                                const Rx::Optional<TextureCompressionUsage>& compression_usage,
+                                ThreadPool* thread_pool,
+                                DecodedImage* decoded_image) {
+        ZoneScoped;
+
+        const auto full_image_path = get_full_path(image_path);
+        const auto container_path = get_texture_container_path(image_path, compression_usage);
+        if(container.open(container_path)) {
+            if(container.is_up_to_date(full_image_path)) {
+                return true;
+            }
+
+            container.close();
+        }
+
+        logger->verbose("Converting image %s to a texture container", image_path);
+
+        Uint32 width, height;
+        renderer::TextureFormat format;
+        auto* pixels = load_texture(image_path, width, height, format);
+        if(pixels == nullptr) {
+            return false;
+        }
+
+        auto wrote_container = false;
+        Rx::Vector<Uint8> mip_chain;
+        if(format == renderer::TextureFormat::Rgba8) {
+            const auto* rgba_pixels = static_cast<const Uint8*>(pixels);
+
+            const auto mip_options = compression_usage ? get_mip_generation_options(*compression_usage) : MipGenerationOptions{};
+            const auto num_mips = renderer::get_num_mips(width, height);
+            mip_chain = generate_mip_chain(rgba_pixels, width, height, mip_options, thread_pool);
+
+            if(compression_usage && can_block_compress(width, height)) {
+                const auto compressed_format = get_compressed_format(*compression_usage, has_alpha(rgba_pixels, width, height));
+                const auto blocks = compress_mip_chain(mip_chain.data(), width, height, num_mips, compressed_format, thread_pool);
+                wrote_container = write_texture_container(container_path,
+                                                          compressed_format,
+                                                          width,
+                                                          height,
+                                                          num_mips,
+                                                          blocks.data(),
+                                                          full_image_path);
+
+            } else {
+                wrote_container = write_texture_container(container_path,
+                                                          format,
+                                                          width,
+                                                          height,
+                                                          num_mips,
+                                                          mip_chain.data(),
+                                                          full_image_path);
+            }
+
+        } else {
+            // The mip generator only handles LDR images, so HDR containers only have the top mip
+            wrote_container = write_texture_container(container_path,
+                                                      format,
+                                                      width,
+                                                      height,
+                                                      1,
+                                                      static_cast<const Uint8*>(pixels),
+                                                      full_image_path);
+        }
+
+        const auto opened_container = wrote_container && container.open(container_path);
+        if(!opened_container && decoded_image != nullptr) {
+            *decoded_image = DecodedImage{.pixels = pixels,
+                                          .mip_chain = Rx::Utility::move(mip_chain),
+                                          .width = width,
+                                          .height = height,
+                                          .format = format};
+
+        } else {
+            free_texture_data(pixels, format);
+        }
+
+        return opened_container;
+    }
+
+    static bool is_image_file(const std::filesystem::path& path) {
+        const auto extension = path.extension();
+        return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp" ||
+               extension == ".hdr";
+    }
+
+    TextureLoadingBenchmarkResult benchmark_texture_loading(const std::filesystem::path& content_directory) {
+        ZoneScoped;
+
+        TextureLoadingBenchmarkResult result;
+
+        Rx::Vector<std::filesystem::path> image_paths;
+        Uint64 max_container_size{0};
+
+        {
+            ZoneScopedN("Write texture containers");
+
+            std::error_code error;
+            for(const auto& entry : std::filesystem::recursive_directory_iterator{get_full_path(content_directory), error}) {
+                if(!entry.is_regular_file() || !is_image_file(entry.path())) {
+                    continue;
+                }
+
+                TextureContainer container;
+                if(load_texture_container(entry.path(), container)) {
+                    image_paths.push_back(entry.path());
+                    max_container_size = std::max(max_container_size, container.get_placed_data().size);
+                }
+            }
+        }
+
+        // Stands in for staging memory, so that the container loads copy their data somewhere
+        Rx::Vector<Uint8> staging_memory;
+        staging_memory.resize(max_container_size);
+
+        {
+            ZoneScopedN("Decode images");
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            image_paths.each_fwd([&](const std::filesystem::path& image_path) {
+                Uint32 width, height;
+                renderer::TextureFormat format;
+                auto* pixels = load_texture(image_path, width, height, format);
+                if(pixels != nullptr) {
+                    result.decoded_size += static_cast<Uint64>(width) * height * renderer::size_in_bytes(format);
+                    free_texture_data(pixels, format);
+                }
+            });
+            const auto duration = std::chrono::high_resolution_clock::now() - start;
+
+            result.decode_ms = static_cast<Float64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000000.0;
+        }
+
+        {
+            ZoneScopedN("Load texture containers");
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            image_paths.each_fwd([&](const std::filesystem::path& image_path) {
+                TextureContainer container;
+                if(container.open(get_texture_container_path(image_path))) {
+                    const auto placed_data = container.get_placed_data();
+                    memcpy(staging_memory.data(), placed_data.data, placed_data.size);
+                    result.container_size += placed_data.size;
+                }
+            });
+            const auto duration = std::chrono::high_resolution_clock::now() - start;
+
+            result.container_ms = static_cast<Float64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000000.0;
+        }
+
+        result.num_images = static_cast<Uint32>(image_paths.size());
+
+        logger->info("Loaded %u images in %fms with stb_image and in %fms from texture containers",
+                     result.num_images,
+                     result.decode_ms,
+                     result.container_ms);
+
+        return result;
+    }
+} // namespace sanity::engine
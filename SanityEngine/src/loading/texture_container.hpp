@@ -0,0 +1,161 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/fs/mapped_file.hpp"
+#include "loading/texture_compression.hpp"
+#include "renderer/rhi/resources.hpp"
+#include "rx/core/optional.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+
+    struct TextureContainerHeader;
+
+    struct TextureContainerMip;
+
+    /*!
+     * \brief An engine-native texture file, mapped into memory
+     *
+     * Texture containers hold every mip of a texture, already laid out the way D3D12 copies textures from buffers, optionally block
+     * compressed. Uploading one is a single copy from the mapped file into staging memory, with no decoding or repacking
+     */
+    class TextureContainer {
+    public:
+        TextureContainer() = default;
+
+        TextureContainer(const TextureContainer& other) = delete;
+        TextureContainer& operator=(const TextureContainer& other) = delete;
+
+        TextureContainer(TextureContainer&& old) noexcept = delete;
+        TextureContainer& operator=(TextureContainer&& old) noexcept = delete;
+
+        ~TextureContainer() = default;
+
+        /*!
+         * \brief Maps a container file and validates its header
+         *
+         * \return false if the file doesn't exist, isn't a texture container, is from an older version of the engine, or is truncated
+         */
+        bool open(const std::filesystem::path& container_path);
+
+        void close();
+
+        [[nodiscard]] bool is_open() const;
+
+        [[nodiscard]] renderer::TextureFormat get_format() const;
+
+        [[nodiscard]] Uint32 get_width() const;
+
+        [[nodiscard]] Uint32 get_height() const;
+
+        [[nodiscard]] Uint32 get_num_mips() const;
+
+        /*!
+         * \brief Checks if the container was written from the current version of the image at the given path
+         */
+        [[nodiscard]] bool is_up_to_date(const std::filesystem::path& full_image_path) const;
+
+        /*!
+         * \brief Info to create the container's texture with. Containers which only hold the top mip get the rest of their mips from the
+         * GPU
+         */
+        [[nodiscard]] renderer::TextureCreateInfo get_create_info(const Rx::String& name) const;
+
+        /*!
+         * \brief The container's mips, pointing into the mapped file. Only valid while the container is open
+         */
+        [[nodiscard]] renderer::PlacedTextureData get_placed_data() const;
+
+    private:
+        MappedFile file;
+
+        const TextureContainerHeader* header{nullptr};
+
+        const TextureContainerMip* mips{nullptr};
+    };
+
+    /*!
+     * \brief Path of the container file of an image. It sits next to the image
+     */
+    [[nodiscard]] std::filesystem::path get_texture_container_path(
+        const std::filesystem::path& image_path, const Rx::Optional<TextureCompressionUsage>& compression_usage = Rx::nullopt);
+
+    /*!
+     * \brief Writes a texture container
+     *
+     * \param mip_chain The texture's mips, tightly packed one after another, like `generate_mip_chain` and `compress_mip_chain` return them
+     * \param full_image_path The image which the texture came from. The container stores its size and modification time, so that it can
+     * tell when it's out of date
+     */
+    bool write_texture_container(const std::filesystem::path& container_path,
+                                 renderer::TextureFormat format,
+                                 Uint32 width,
+                                 Uint32 height,
+                                 Uint32 num_mips,
+                                 const Uint8* mip_chain,
+                                 const std::filesystem::path& full_image_path);
+
+    /*!
+     * \brief An image which was decoded to convert it into a texture container
+     */
+    struct DecodedImage {
+        /*!
+         * \brief The image's pixels, which must be freed with `free_texture_data`
+         */
+        void* pixels{nullptr};
+
+        /*!
+         * \brief All the uncompressed mips of an RGBA8 image. Empty for HDR images
+         */
+        Rx::Vector<Uint8> mip_chain;
+
+        Uint32 width{0};
+
+        Uint32 height{0};
+
+        renderer::TextureFormat format{renderer::TextureFormat::Rgba8};
+    };
+
+    /*!
+     * \brief Opens the container of an image, converting the image into a container first if it doesn't have one or if the image changed
+     *
+     * Converting an LDR image generates its mips on the CPU, and block compresses them if `compression_usage` is set and the image's size
+     * allows it. HDR images are stored with only their top mip
+     *
+     * \param decoded_image If the image was decoded but its container couldn't be written or opened, this receives the image instead of
+     * it being freed, so that the caller can use it without decoding it again
+     *
+     * \return false if the image couldn't be loaded or its container couldn't be written
+     */
+    bool load_texture_container(const std::filesystem::path& image_path,
+                                TextureContainer& container,
+                                const Rx::Optional<TextureCompressionUsage>& compression_usage = Rx::nullopt,
+                                ThreadPool* thread_pool = nullptr,
+                                DecodedImage* decoded_image = nullptr);
+
+    struct TextureLoadingBenchmarkResult {
+        Uint32 num_images{0};
+
+        /*!
+         * \brief Time that decoding all the images with stb_image and padding them to four channels took, like `load_texture` does
+         */
+        Float64 decode_ms{0};
+
+        /*!
+         * \brief Time that mapping all the images' containers and copying their mips into memory that stands in for staging memory took
+         */
+        Float64 container_ms{0};
+
+        Uint64 decoded_size{0};
+
+        Uint64 container_size{0};
+    };
+
+    /*!
+     * \brief Compares loading every image in a directory through stb_image against loading the images' containers. Doesn't need a GPU
+     *
+     * Writes the containers of any images which don't have up-to-date ones before it starts timing
+     */
+    [[nodiscard]] TextureLoadingBenchmarkResult benchmark_texture_loading(const std::filesystem::path& content_directory);
+} // namespace sanity::engine
@@ -0,0 +1,81 @@
+#include "vertex_quantization.hpp"
+
+#include "Tracy.hpp"
+#include "glm/geometric.hpp"
+#include "renderer/mesh.hpp"
+
+namespace sanity::engine {
+    Float32 VertexQuantizationError::get_mean_location_error() const {
+        return num_vertices > 0 ? static_cast<Float32>(total_location_error / static_cast<Float64>(num_vertices)) : 0.0f;
+    }
+
+    Float32 VertexQuantizationError::get_mean_normal_error() const {
+        return num_vertices > 0 ? static_cast<Float32>(total_normal_error / static_cast<Float64>(num_vertices)) : 0.0f;
+    }
+
+    VertexQuantizationError& VertexQuantizationError::operator+=(const VertexQuantizationError& other) {
+        num_vertices += other.num_vertices;
+        max_location_error = glm::max(max_location_error, other.max_location_error);
+        max_normal_error = glm::max(max_normal_error, other.max_normal_error);
+        max_texcoord_error = glm::max(max_texcoord_error, other.max_texcoord_error);
+        total_location_error += other.total_location_error;
+        total_normal_error += other.total_normal_error;
+
+        return *this;
+    }
+
+    Rx::Vector<renderer::PackedVertex> quantize_vertices(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                         renderer::MeshDequantization& dequantization) {
+        ZoneScoped;
+
+        if(vertices.is_empty()) {
+            dequantization = {};
+            return {};
+        }
+
+        const auto bounds = renderer::compute_mesh_bounds(vertices.data(), static_cast<Uint32>(vertices.size()));
+        dequantization = renderer::make_mesh_dequantization(glm::vec3{bounds.x_min, bounds.y_min, bounds.z_min},
+                                                            glm::vec3{bounds.x_max, bounds.y_max, bounds.z_max});
+
+        Rx::Vector<renderer::PackedVertex> packed_vertices;
+        packed_vertices.reserve(vertices.size());
+        for(Size i = 0; i < vertices.size(); i++) {
+            packed_vertices.push_back(renderer::pack_vertex(vertices[i], dequantization));
+        }
+
+        return packed_vertices;
+    }
+
+    VertexQuantizationError measure_quantization_error(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                       const Rx::Vector<renderer::PackedVertex>& packed_vertices,
+                                                       const renderer::MeshDequantization& dequantization) {
+        ZoneScoped;
+
+        VertexQuantizationError error;
+        error.num_vertices = glm::min(vertices.size(), packed_vertices.size());
+
+        for(Size i = 0; i < error.num_vertices; i++) {
+            const auto& vertex = vertices[i];
+            const auto unpacked_vertex = renderer::unpack_vertex(packed_vertices[i], dequantization);
+
+            const auto location_error = glm::length(unpacked_vertex.location - vertex.location);
+            error.max_location_error = glm::max(error.max_location_error, location_error);
+            error.total_location_error += location_error;
+
+            // Zero length normals have no direction to lose
+            const auto normal_length = glm::length(vertex.normal);
+            if(normal_length > 0.0f) {
+                const auto similarity = glm::clamp(glm::dot(vertex.normal / normal_length, unpacked_vertex.normal), -1.0f, 1.0f);
+                const auto normal_error = glm::degrees(glm::acos(similarity));
+                error.max_normal_error = glm::max(error.max_normal_error, normal_error);
+                error.total_normal_error += normal_error;
+            }
+
+            const auto texcoord_error = glm::max(glm::abs(unpacked_vertex.texcoord.x - vertex.texcoord.x),
+                                                 glm::abs(unpacked_vertex.texcoord.y - vertex.texcoord.y));
+            error.max_texcoord_error = glm::max(error.max_texcoord_error, texcoord_error);
+        }
+
+        return error;
+    }
+} // namespace sanity::engine
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    /*!
+     * \brief How far a mesh's packed vertices are from the vertices they were packed from
+     */
+    struct VertexQuantizationError {
+        Uint64 num_vertices{0};
+
+        /*!
+         * \brief Largest distance between a vertex's location and its packed location, in the mesh's units
+         */
+        Float32 max_location_error{0};
+
+        /*!
+         * \brief Largest angle between a vertex's normal and its packed normal, in degrees
+         */
+        Float32 max_normal_error{0};
+
+        /*!
+         * \brief Largest difference between a component of a vertex's texcoord and that component of its packed texcoord
+         */
+        Float32 max_texcoord_error{0};
+
+        Float64 total_location_error{0};
+
+        Float64 total_normal_error{0};
+
+        [[nodiscard]] Float32 get_mean_location_error() const;
+
+        [[nodiscard]] Float32 get_mean_normal_error() const;
+
+        VertexQuantizationError& operator+=(const VertexQuantizationError& other);
+    };
+
+    /*!
+     * \brief Packs a mesh's vertices into PackedVertices, with locations quantized relative to the bounds of the vertices
+     *
+     * Meshes that touch each other get different bounds, so their shared edges may quantize to slightly different locations
+     *
+     * \param dequantization Gets the dequantization that the packed vertices need
+     */
+    [[nodiscard]] Rx::Vector<renderer::PackedVertex> quantize_vertices(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                                       renderer::MeshDequantization& dequantization);
+
+    /*!
+     * \brief Compares the vertices of a mesh to the result of packing them
+     */
+    [[nodiscard]] VertexQuantizationError measure_quantization_error(const Rx::Vector<renderer::StandardVertex>& vertices,
+                                                                     const Rx::Vector<renderer::PackedVertex>& packed_vertices,
+                                                                     const renderer::MeshDequantization& dequantization);
+} // namespace sanity::engine
@@ -0,0 +1,56 @@
+#include "bindless_descriptor_tracker.hpp"
+
+#include <algorithm>
+
+#include "Tracy.hpp"
+
+namespace sanity::engine::renderer {
+    BindlessDescriptorTracker::BindlessDescriptorTracker(const Uint32 num_descriptors_in, const Uint32 num_frames)
+        : num_descriptors{num_descriptors_in}, dirty_flags{num_frames}, dirty_descriptors{num_frames} {
+        dirty_flags.each_fwd([&](Rx::Vector<Uint8>& flags) { flags.resize(num_descriptors, 0); });
+    }
+
+    void BindlessDescriptorTracker::mark_dirty(const Uint32 descriptor_idx) {
+        RX_ASSERT(descriptor_idx < num_descriptors, "Descriptor index %u is out of range", descriptor_idx);
+
+        for(auto frame_idx = 0u; frame_idx < dirty_flags.size(); frame_idx++) {
+            auto& flag = dirty_flags[frame_idx][descriptor_idx];
+            if(flag == 0) {
+                flag = 1;
+                dirty_descriptors[frame_idx].push_back(descriptor_idx);
+            }
+        }
+    }
+
+    Uint32 BindlessDescriptorTracker::flush_frame(const Uint32 frame_idx, const Rx::Function<void(Uint32, Uint32)>& copy_range) {
+        ZoneScoped;
+
+        auto& descriptors = dirty_descriptors[frame_idx];
+        if(descriptors.is_empty()) {
+            return 0;
+        }
+
+        std::sort(descriptors.data(), descriptors.data() + descriptors.size());
+
+        auto& flags = dirty_flags[frame_idx];
+
+        Uint32 run_start = 0;
+        while(run_start < descriptors.size()) {
+            auto run_end = run_start + 1;
+            while(run_end < descriptors.size() && descriptors[run_end] == descriptors[run_end - 1] + 1) {
+                run_end++;
+            }
+
+            copy_range(descriptors[run_start], run_end - run_start);
+
+            run_start = run_end;
+        }
+
+        descriptors.each_fwd([&](const Uint32 descriptor_idx) { flags[descriptor_idx] = 0; });
+
+        const auto num_dirty_descriptors = static_cast<Uint32>(descriptors.size());
+        descriptors.clear();
+
+        return num_dirty_descriptors;
+    }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/function.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief Counts of the descriptor work done for the bindless resource array in one frame
+     */
+    struct BindlessDescriptorStats {
+        /*!
+         * \brief Number of descriptors created because their resource was created, destroyed, or changed
+         */
+        Uint32 num_descriptors_written{0};
+
+        /*!
+         * \brief Number of descriptors copied into the frame's copy of the resource array
+         */
+        Uint32 num_descriptors_copied{0};
+
+        /*!
+         * \brief Number of contiguous ranges that the copied descriptors were grouped into
+         */
+        Uint32 num_copied_ranges{0};
+    };
+
+    /*!
+     * \brief Tracks which descriptors of the bindless resource array changed since each frame's copy of the array was last updated
+     *
+     * Every frame in flight has its own copy of the resource array, so a descriptor which changes has to be copied into each of them the
+     * next time that frame is recorded. This only tracks indices - it knows nothing about D3D12
+     */
+    class BindlessDescriptorTracker {
+    public:
+        BindlessDescriptorTracker(Uint32 num_descriptors_in, Uint32 num_frames);
+
+        BindlessDescriptorTracker(const BindlessDescriptorTracker& other) = delete;
+        BindlessDescriptorTracker& operator=(const BindlessDescriptorTracker& other) = delete;
+
+        BindlessDescriptorTracker(BindlessDescriptorTracker&& old) noexcept = default;
+        BindlessDescriptorTracker& operator=(BindlessDescriptorTracker&& old) noexcept = default;
+
+        ~BindlessDescriptorTracker() = default;
+
+        /*!
+         * \brief Marks a descriptor as changed for every frame
+         */
+        void mark_dirty(Uint32 descriptor_idx);
+
+        /*!
+         * \brief Calls `copy_range` for every run of consecutive descriptors which changed since the last time this was called for the
+         * frame, then marks the frame as up to date
+         *
+         * \param copy_range Function which receives the index of the first descriptor in a run and the number of descriptors in the run
+         *
+         * \return The number of descriptors in all the runs
+         */
+        Uint32 flush_frame(Uint32 frame_idx, const Rx::Function<void(Uint32, Uint32)>& copy_range);
+
+    private:
+        Uint32 num_descriptors;
+
+        /*!
+         * \brief For each frame, whether each descriptor is in that frame's dirty list
+         */
+        Rx::Vector<Rx::Vector<Uint8>> dirty_flags;
+
+        /*!
+         * \brief For each frame, the descriptors which changed since that frame was last flushed
+         */
+        Rx::Vector<Rx::Vector<Uint32>> dirty_descriptors;
+    };
+} // namespace sanity::engine::renderer
@@ -0,0 +1,936 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+
+#include "Tracy.hpp"
+#include "core/async/thread_pool.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include "rx/core/concurrency/atomic.h"
+#include "rx/core/log.h"
+
+namespace sanity::engine::renderer {
+    RX_LOG("Bvh", logger);
+
+    constexpr Uint32 NUM_BINS = 16;
+
+    /*!
+     * \brief Nodes with more primitives than this are always split, even when the surface area heuristic says a leaf would be cheaper
+     */
+    constexpr Uint32 MAX_LEAF_SIZE = 8;
+
+    /*!
+     * \brief Cost of testing a ray against a node's children, relative to the cost of testing it against one primitive
+     */
+    constexpr Float32 TRAVERSAL_COST = 1.0f;
+
+    /*!
+     * \brief Nodes deeper than this are split in the middle of their primitives rather than by the surface area heuristic. That bounds
+     * the depth of the tree, so traversal can use a fixed-size stack
+     */
+    constexpr Uint32 MAX_SAH_DEPTH = 64;
+
+    constexpr Uint32 TRAVERSAL_STACK_SIZE = 128;
+
+    /*!
+     * \brief Nodes with fewer primitives than this bin them on the calling thread, because waking the workers would cost more than it
+     * saves
+     */
+    constexpr Uint32 MIN_PRIMITIVES_FOR_PARALLEL_BINNING = 65536;
+
+    constexpr Uint32 PRIMITIVES_PER_BATCH = 16384;
+
+    /*!
+     * \brief Subtrees with fewer primitives than this are never split further into more subtrees for the workers to build
+     */
+    constexpr Uint32 MIN_PRIMITIVES_PER_SUBTREE = 4096;
+
+    constexpr Uint32 RAYS_PER_BATCH = 1024;
+
+    /*!
+     * \brief Axis-aligned box with an unused fourth lane, so that it can be loaded into SSE registers. Empty boxes are inside out, so
+     * that growing them by anything gives that thing's bounds
+     */
+    struct Aabb {
+        Float32 min[4]{FLT_MAX, FLT_MAX, FLT_MAX, 0};
+        Float32 max[4]{-FLT_MAX, -FLT_MAX, -FLT_MAX, 0};
+
+        void grow(const __m128 other_min, const __m128 other_max) {
+            _mm_storeu_ps(min, _mm_min_ps(_mm_loadu_ps(min), other_min));
+            _mm_storeu_ps(max, _mm_max_ps(_mm_loadu_ps(max), other_max));
+        }
+
+        void grow(const Aabb& other) { grow(_mm_loadu_ps(other.min), _mm_loadu_ps(other.max)); }
+
+        [[nodiscard]] Float32 get_half_area() const {
+            const auto x = max[0] - min[0];
+            const auto y = max[1] - min[1];
+            const auto z = max[2] - min[2];
+            if(x < 0 || y < 0 || z < 0) {
+                return 0;
+            }
+
+            return x * y + y * z + z * x;
+        }
+    };
+
+    struct Bin {
+        Aabb bounds;
+
+        Aabb centroid_bounds;
+
+        Uint32 num_primitives{0};
+    };
+
+    /*!
+     * \brief The bins of all three axes
+     */
+    struct BinSet {
+        Bin bins[3][NUM_BINS];
+    };
+
+    struct BuildTask {
+        Uint32 node_idx{0};
+
+        Uint32 begin{0};
+
+        Uint32 end{0};
+
+        Uint32 depth{0};
+
+        Aabb bounds;
+
+        Aabb centroid_bounds;
+    };
+
+    /*!
+     * \brief The primitives to build a BVH over, and their order in the BVH's leaves
+     */
+    struct BuildContext {
+        const Aabb* primitive_bounds{nullptr};
+
+        /*!
+         * \brief Indices of the primitives. Building a node partitions its range of this array between its children
+         */
+        Uint32* order{nullptr};
+
+        ThreadPool* thread_pool{nullptr};
+    };
+
+    struct Split {
+        Uint32 axis{0};
+
+        /*!
+         * \brief Primitives in bins before this one go to the left child
+         */
+        Uint32 bin{0};
+
+        /*!
+         * \brief Sum of each child's half area times its number of primitives
+         */
+        Float32 cost{FLT_MAX};
+
+        BuildTask left;
+
+        BuildTask right;
+    };
+
+    static __m128 get_centroid(const Aabb& bounds) {
+        return _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(bounds.min), _mm_loadu_ps(bounds.max)), _mm_set1_ps(0.5f));
+    }
+
+    /*!
+     * \brief Finds which bin the primitive's centroid falls into along each axis. Building and partitioning use this same function, so
+     * they can't disagree about a primitive that's right on the border of two bins
+     */
+    static void get_bin_indices(const Aabb& bounds, const __m128 centroid_min, const __m128 bin_scale, Int32 (&bin_indices)[4]) {
+        const auto bin_coordinates = _mm_mul_ps(_mm_sub_ps(get_centroid(bounds), centroid_min), bin_scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bin_indices), _mm_cvttps_epi32(bin_coordinates));
+
+        for(auto& bin_idx : bin_indices) {
+            bin_idx = std::clamp(bin_idx, 0, static_cast<Int32>(NUM_BINS) - 1);
+        }
+    }
+
+    static void bin_primitives(const BuildContext& context,
+                               const Uint32 begin,
+                               const Uint32 end,
+                               const __m128 centroid_min,
+                               const __m128 bin_scale,
+                               BinSet& bin_set) {
+        for(auto i = begin; i < end; i++) {
+            const auto& bounds = context.primitive_bounds[context.order[i]];
+            const auto min = _mm_loadu_ps(bounds.min);
+            const auto max = _mm_loadu_ps(bounds.max);
+            const auto centroid = get_centroid(bounds);
+
+            Int32 bin_indices[4];
+            get_bin_indices(bounds, centroid_min, bin_scale, bin_indices);
+
+            for(Uint32 axis = 0; axis < 3; axis++) {
+                auto& bin = bin_set.bins[axis][bin_indices[axis]];
+                bin.bounds.grow(min, max);
+                bin.centroid_bounds.grow(centroid, centroid);
+                bin.num_primitives++;
+            }
+        }
+    }
+
+    /*!
+     * \brief Computes the bounds of the primitives in `[begin, end)`, and the bounds of their centroids
+     */
+    static void compute_bounds(const BuildContext& context, const Uint32 begin, const Uint32 end, BuildTask& task) {
+        task.bounds = {};
+        task.centroid_bounds = {};
+
+        for(auto i = begin; i < end; i++) {
+            const auto& bounds = context.primitive_bounds[context.order[i]];
+            const auto centroid = get_centroid(bounds);
+            task.bounds.grow(bounds);
+            task.centroid_bounds.grow(centroid, centroid);
+        }
+    }
+
+    /*!
+     * \brief Finds the cheapest way to split a node's primitives between two children according to the surface area heuristic
+     *
+     * \return The best split, or an empty optional if every split would leave one of the children empty
+     */
+    static Rx::Optional<Split> find_best_split(const BuildContext& context, const BuildTask& task) {
+        const auto num_primitives = task.end - task.begin;
+
+        const auto centroid_min = _mm_loadu_ps(task.centroid_bounds.min);
+        const auto centroid_extents = _mm_sub_ps(_mm_loadu_ps(task.centroid_bounds.max), centroid_min);
+
+        // Scale centroids so that they land in [0, NUM_BINS). Axes where all the centroids are in the same place get a scale of zero,
+        // which puts every primitive in the first bin, so that axis never has a valid split
+        Float32 extents[4];
+        _mm_storeu_ps(extents, centroid_extents);
+        Float32 scale[4]{0, 0, 0, 0};
+        for(Uint32 axis = 0; axis < 3; axis++) {
+            if(extents[axis] > 0) {
+                scale[axis] = static_cast<Float32>(NUM_BINS) * (1.0f - 1e-6f) / extents[axis];
+            }
+        }
+        const auto bin_scale = _mm_loadu_ps(scale);
+
+        BinSet bin_set;
+        if(context.thread_pool != nullptr && num_primitives >= MIN_PRIMITIVES_FOR_PARALLEL_BINNING) {
+            Rx::Vector<BinSet> batch_bin_sets;
+            batch_bin_sets.resize((num_primitives + PRIMITIVES_PER_BATCH - 1) / PRIMITIVES_PER_BATCH);
+
+            context.thread_pool->parallel_for(num_primitives, PRIMITIVES_PER_BATCH, [&](const Uint32 begin, const Uint32 end) {
+                bin_primitives(context,
+                               task.begin + begin,
+                               task.begin + end,
+                               centroid_min,
+                               bin_scale,
+                               batch_bin_sets[begin / PRIMITIVES_PER_BATCH]);
+            });
+
+            batch_bin_sets.each_fwd([&](const BinSet& batch_bin_set) {
+                for(Uint32 axis = 0; axis < 3; axis++) {
+                    for(Uint32 bin_idx = 0; bin_idx < NUM_BINS; bin_idx++) {
+                        const auto& batch_bin = batch_bin_set.bins[axis][bin_idx];
+                        auto& bin = bin_set.bins[axis][bin_idx];
+                        bin.bounds.grow(batch_bin.bounds);
+                        bin.centroid_bounds.grow(batch_bin.centroid_bounds);
+                        bin.num_primitives += batch_bin.num_primitives;
+                    }
+                }
+            });
+
+        } else {
+            bin_primitives(context, task.begin, task.end, centroid_min, bin_scale, bin_set);
+        }
+
+        Rx::Optional<Split> best_split;
+        for(Uint32 axis = 0; axis < 3; axis++) {
+            if(scale[axis] == 0) {
+                continue;
+            }
+
+            const auto& bins = bin_set.bins[axis];
+
+            // Sweep from the right to get the cost of the right side of every split, then from the left to find the best split
+            Float32 right_areas[NUM_BINS];
+            Uint32 right_counts[NUM_BINS];
+            Aabb right_bounds;
+            Uint32 right_count = 0;
+            for(auto bin_idx = NUM_BINS - 1; bin_idx > 0; bin_idx--) {
+                right_bounds.grow(bins[bin_idx].bounds);
+                right_count += bins[bin_idx].num_primitives;
+                right_areas[bin_idx] = right_bounds.get_half_area();
+                right_counts[bin_idx] = right_count;
+            }
+
+            Aabb left_bounds;
+            Uint32 left_count = 0;
+            for(Uint32 bin_idx = 1; bin_idx < NUM_BINS; bin_idx++) {
+                left_bounds.grow(bins[bin_idx - 1].bounds);
+                left_count += bins[bin_idx - 1].num_primitives;
+                if(left_count == 0 || right_counts[bin_idx] == 0) {
+                    continue;
+                }
+
+                const auto cost = left_bounds.get_half_area() * static_cast<Float32>(left_count) +
+                                  right_areas[bin_idx] * static_cast<Float32>(right_counts[bin_idx]);
+                if(!best_split || cost < best_split->cost) {
+                    best_split = Split{.axis = axis, .bin = bin_idx, .cost = cost};
+                }
+            }
+        }
+
+        if(!best_split) {
+            return Rx::nullopt;
+        }
+
+        // The bins already know the bounds of each child's primitives and centroids
+        auto& split = *best_split;
+        split.left = BuildTask{.depth = task.depth + 1};
+        split.right = BuildTask{.depth = task.depth + 1};
+        Uint32 num_left = 0;
+        for(Uint32 bin_idx = 0; bin_idx < NUM_BINS; bin_idx++) {
+            const auto& bin = bin_set.bins[split.axis][bin_idx];
+            auto& child = bin_idx < split.bin ? split.left : split.right;
+            child.bounds.grow(bin.bounds);
+            child.centroid_bounds.grow(bin.centroid_bounds);
+            if(bin_idx < split.bin) {
+                num_left += bin.num_primitives;
+            }
+        }
+
+        // Partition the primitives between the children, with the same binning as above
+        const auto split_axis = split.axis;
+        const auto split_bin = static_cast<Int32>(split.bin);
+        const auto* first_right = std::partition(context.order + task.begin,
+                                                 context.order + task.end,
+                                                 [&](const Uint32 primitive_idx) {
+                                                     Int32 bin_indices[4];
+                                                     get_bin_indices(context.primitive_bounds[primitive_idx],
+                                                                     centroid_min,
+                                                                     bin_scale,
+                                                                     bin_indices);
+                                                     return bin_indices[split_axis] < split_bin;
+                                                 });
+
+        const auto mid = static_cast<Uint32>(first_right - context.order);
+        RX_ASSERT(mid - task.begin == num_left, "Partitioning the primitives disagreed with binning them");
+
+        split.left.begin = task.begin;
+        split.left.end = mid;
+        split.right.begin = mid;
+        split.right.end = task.end;
+
+        return best_split;
+    }
+
+    static BvhNode make_node(const Aabb& bounds, const Uint32 first, const Uint32 num_primitives) {
+        return BvhNode{.min = glm::vec3{bounds.min[0], bounds.min[1], bounds.min[2]},
+                       .first = first,
+                       .max = glm::vec3{bounds.max[0], bounds.max[1], bounds.max[2]},
+                       .num_primitives = num_primitives};
+    }
+
+    /*!
+     * \brief Builds the nodes for all the tasks on the stack, and all the nodes below them
+     *
+     * \param deferred_tasks If this isn't nullptr, tasks with no more than `max_deferred_size` primitives are added to it instead of
+     * being built
+     */
+    static void build_tasks(const BuildContext& context,
+                            Rx::Vector<BuildTask>& tasks,
+                            Rx::Vector<BvhNode>& nodes,
+                            Rx::Vector<BuildTask>* deferred_tasks,
+                            const Uint32 max_deferred_size) {
+        while(!tasks.is_empty()) {
+            const auto task = tasks.last();
+            tasks.pop_back();
+
+            const auto num_primitives = task.end - task.begin;
+            if(deferred_tasks != nullptr && num_primitives <= max_deferred_size) {
+                deferred_tasks->push_back(task);
+                continue;
+            }
+
+            if(num_primitives <= 1) {
+                nodes[task.node_idx] = make_node(task.bounds, task.begin, num_primitives);
+                continue;
+            }
+
+            Rx::Optional<Split> split;
+            if(task.depth < MAX_SAH_DEPTH) {
+                split = find_best_split(context, task);
+            }
+
+            const auto leaf_cost = static_cast<Float32>(num_primitives);
+            const auto node_area = task.bounds.get_half_area();
+            const auto is_split_cheaper = split && node_area > 0 && TRAVERSAL_COST + split->cost / node_area < leaf_cost;
+
+            BuildTask left;
+            BuildTask right;
+            if(split && (is_split_cheaper || num_primitives > MAX_LEAF_SIZE)) {
+                left = split->left;
+                right = split->right;
+
+            } else if(num_primitives <= MAX_LEAF_SIZE) {
+                nodes[task.node_idx] = make_node(task.bounds, task.begin, num_primitives);
+                continue;
+
+            } else {
+                // All the centroids are in the same place, or the tree is already very deep. Split the primitives in half as they are
+                const auto mid = task.begin + num_primitives / 2;
+                left = BuildTask{.begin = task.begin, .end = mid, .depth = task.depth + 1};
+                right = BuildTask{.begin = mid, .end = task.end, .depth = task.depth + 1};
+                compute_bounds(context, left.begin, left.end, left);
+                compute_bounds(context, right.begin, right.end, right);
+            }
+
+            const auto first_child_idx = static_cast<Uint32>(nodes.size());
+            nodes.push_back({});
+            nodes.push_back({});
+            nodes[task.node_idx] = make_node(task.bounds, first_child_idx, 0);
+
+            left.node_idx = first_child_idx;
+            right.node_idx = first_child_idx + 1;
+            tasks.push_back(right);
+            tasks.push_back(left);
+        }
+    }
+
+    /*!
+     * \brief Builds BVH nodes over some primitives
+     *
+     * \param order Gets the indices of the primitives, in the order that the leaves refer to them
+     */
+    static void build_nodes(const Rx::Vector<Aabb>& primitive_bounds,
+                            ThreadPool* thread_pool,
+                            Rx::Vector<BvhNode>& nodes,
+                            Rx::Vector<Uint32>& order) {
+        ZoneScoped;
+
+        const auto num_primitives = static_cast<Uint32>(primitive_bounds.size());
+
+        nodes.clear();
+        order.resize(num_primitives);
+        if(num_primitives == 0) {
+            return;
+        }
+
+        for(Uint32 i = 0; i < num_primitives; i++) {
+            order[i] = i;
+        }
+
+        const auto context = BuildContext{.primitive_bounds = primitive_bounds.data(), .order = order.data(), .thread_pool = thread_pool};
+
+        auto root = BuildTask{.begin = 0, .end = num_primitives};
+        compute_bounds(context, 0, num_primitives, root);
+
+        nodes.reserve(num_primitives * 2);
+        nodes.push_back({});
+
+        Rx::Vector<BuildTask> tasks;
+        tasks.push_back(root);
+
+        if(thread_pool == nullptr) {
+            build_tasks(context, tasks, nodes, nullptr, 0);
+            return;
+        }
+
+        // Split the top of the tree on this thread, with parallel binning, until there are enough subtrees to keep every worker busy
+        const auto max_subtree_size = std::max(MIN_PRIMITIVES_PER_SUBTREE, num_primitives / (thread_pool->get_num_threads() * 8));
+
+        Rx::Vector<BuildTask> subtree_tasks;
+        build_tasks(context, tasks, nodes, &subtree_tasks, max_subtree_size);
+
+        // Each subtree goes into its own array of nodes, with the subtree's root at index 0. Subtrees are already built on the workers, so
+        // they bin their primitives without the thread pool
+        const auto subtree_context = BuildContext{.primitive_bounds = context.primitive_bounds, .order = context.order};
+
+        Rx::Vector<Rx::Vector<BvhNode>> subtree_nodes;
+        subtree_nodes.resize(subtree_tasks.size());
+        thread_pool->parallel_for(static_cast<Uint32>(subtree_tasks.size()), 1, [&](const Uint32 begin, const Uint32 end) {
+            Rx::Vector<BuildTask> local_tasks;
+            for(auto subtree_idx = begin; subtree_idx < end; subtree_idx++) {
+                auto& local_nodes = subtree_nodes[subtree_idx];
+                local_nodes.push_back({});
+
+                auto task = subtree_tasks[subtree_idx];
+                task.node_idx = 0;
+                local_tasks.push_back(task);
+
+                build_tasks(subtree_context, local_tasks, local_nodes, nullptr, 0);
+            }
+        });
+
+        // Append each subtree's nodes below its root, which the top of the tree already has a place for
+        for(Uint32 subtree_idx = 0; subtree_idx < subtree_tasks.size(); subtree_idx++) {
+            const auto& local_nodes = subtree_nodes[subtree_idx];
+            const auto base_idx = static_cast<Uint32>(nodes.size()) - 1;
+
+            for(Uint32 local_idx = 0; local_idx < local_nodes.size(); local_idx++) {
+                auto node = local_nodes[local_idx];
+                if(!node.is_leaf()) {
+                    node.first += base_idx;
+                }
+
+                if(local_idx == 0) {
+                    nodes[subtree_tasks[subtree_idx].node_idx] = node;
+
+                } else {
+                    nodes.push_back(node);
+                }
+            }
+        }
+    }
+
+    MeshBvh build_mesh_bvh(const glm::vec3* locations,
+                           const Uint32 num_vertices,
+                           const Uint32* indices,
+                           const Uint32 num_indices,
+                           ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        // Leave out triangles that refer to vertices that don't exist, but keep the indices of the other triangles the same
+        Rx::Vector<Uint32> triangles;
+        triangles.reserve(num_indices / 3);
+        for(Uint32 triangle_idx = 0; triangle_idx < num_indices / 3; triangle_idx++) {
+            const auto* triangle_indices = indices + triangle_idx * 3;
+            if(triangle_indices[0] < num_vertices && triangle_indices[1] < num_vertices && triangle_indices[2] < num_vertices) {
+                triangles.push_back(triangle_idx);
+            }
+        }
+
+        if(triangles.size() * 3 != num_indices) {
+            logger->error("Mesh has %u indices, but only %u triangles with valid indices",
+                          num_indices,
+                          static_cast<Uint32>(triangles.size()));
+        }
+
+        const auto num_triangles = static_cast<Uint32>(triangles.size());
+
+        Rx::Vector<Aabb> triangle_bounds;
+        triangle_bounds.resize(num_triangles);
+
+        const auto compute_triangle_bounds = [&](const Uint32 begin, const Uint32 end) {
+            for(auto i = begin; i < end; i++) {
+                const auto* triangle_indices = indices + triangles[i] * 3;
+                auto& bounds = triangle_bounds[i];
+                for(Uint32 corner = 0; corner < 3; corner++) {
+                    const auto& location = locations[triangle_indices[corner]];
+                    const auto vertex = _mm_setr_ps(location.x, location.y, location.z, 0);
+                    bounds.grow(vertex, vertex);
+                }
+            }
+        };
+
+        if(thread_pool != nullptr && num_triangles >= MIN_PRIMITIVES_FOR_PARALLEL_BINNING) {
+            thread_pool->parallel_for(num_triangles, PRIMITIVES_PER_BATCH, compute_triangle_bounds);
+
+        } else {
+            compute_triangle_bounds(0, num_triangles);
+        }
+
+        MeshBvh bvh;
+        Rx::Vector<Uint32> order;
+        build_nodes(triangle_bounds, thread_pool, bvh.nodes, order);
+
+        bvh.triangles.reserve(num_triangles);
+        order.each_fwd([&](const Uint32 primitive_idx) {
+            const auto triangle_idx = triangles[primitive_idx];
+            const auto* triangle_indices = indices + triangle_idx * 3;
+            const auto& v0 = locations[triangle_indices[0]];
+            bvh.triangles.push_back(BvhTriangle{.v0 = v0,
+                                                .edge1 = locations[triangle_indices[1]] - v0,
+                                                .edge2 = locations[triangle_indices[2]] - v0,
+                                                .triangle_idx = triangle_idx});
+        });
+
+        return bvh;
+    }
+
+    SceneBvh build_scene_bvh(const Rx::Vector<BvhInstance>& instances, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        Rx::Vector<Uint32> used_instances;
+        Rx::Vector<Aabb> instance_bounds;
+        for(Uint32 instance_idx = 0; instance_idx < instances.size(); instance_idx++) {
+            const auto& instance = instances[instance_idx];
+            if(instance.bvh == nullptr || instance.bvh->nodes.is_empty()) {
+                continue;
+            }
+
+            // Transform all eight corners of the mesh's bounds, so that rotated meshes get a tight box
+            const auto& root = instance.bvh->nodes[0];
+            Aabb bounds;
+            for(Uint32 corner = 0; corner < 8; corner++) {
+                const auto local_corner = glm::vec4{(corner & 1) != 0 ? root.max.x : root.min.x,
+                                                    (corner & 2) != 0 ? root.max.y : root.min.y,
+                                                    (corner & 4) != 0 ? root.max.z : root.min.z,
+                                                    1.0f};
+                const auto world_corner = instance.world_matrix * local_corner;
+                const auto point = _mm_setr_ps(world_corner.x, world_corner.y, world_corner.z, 0);
+                bounds.grow(point, point);
+            }
+
+            used_instances.push_back(instance_idx);
+            instance_bounds.push_back(bounds);
+        }
+
+        SceneBvh bvh;
+        Rx::Vector<Uint32> order;
+        build_nodes(instance_bounds, thread_pool, bvh.nodes, order);
+
+        bvh.instances.reserve(order.size());
+        order.each_fwd([&](const Uint32 primitive_idx) {
+            const auto& instance = instances[used_instances[primitive_idx]];
+            bvh.instances.push_back(SceneBvhInstance{.bvh = instance.bvh,
+                                                     .world_to_object_matrix = glm::inverse(instance.world_matrix),
+                                                     .id = instance.id});
+        });
+
+        return bvh;
+    }
+
+    /*!
+     * \brief A ray, prepared for testing against lots of boxes
+     */
+    struct TraversalRay {
+        glm::vec3 origin;
+
+        glm::vec3 direction;
+
+        __m128 simd_origin;
+
+        __m128 simd_inverse_direction;
+    };
+
+    static TraversalRay make_traversal_ray(const glm::vec3& origin, const glm::vec3& direction) {
+        // Nudge zero components of the direction away from zero, so that the slab test never computes zero times infinity
+        const auto get_inverse = [](const Float32 component) {
+            constexpr Float32 MIN_COMPONENT = 1e-30f;
+            return 1.0f / (std::abs(component) > MIN_COMPONENT ? component : std::copysign(MIN_COMPONENT, component));
+        };
+
+        return TraversalRay{.origin = origin,
+                            .direction = direction,
+                            .simd_origin = _mm_setr_ps(origin.x, origin.y, origin.z, 0),
+                            .simd_inverse_direction = _mm_setr_ps(get_inverse(direction.x),
+                                                                  get_inverse(direction.y),
+                                                                  get_inverse(direction.z),
+                                                                  0)};
+    }
+
+    /*!
+     * \brief Tests a ray against a node's bounds, one slab per SSE lane
+     *
+     * \return The distance along the ray where it enters the node, or FLT_MAX if it misses the node or only reaches it after
+     * `max_distance`
+     */
+    static Float32 intersect_node(const BvhNode& node, const TraversalRay& ray, const Float32 max_distance) {
+        // The fourth lane of each load is the node's `first` or `num_primitives`, which the mask replaces with the ray's extent
+        const auto* node_data = reinterpret_cast<const Float32*>(&node);
+        const auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node_data), ray.simd_origin), ray.simd_inverse_direction);
+        const auto t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node_data + 4), ray.simd_origin), ray.simd_inverse_direction);
+
+        const auto xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const auto near = _mm_and_ps(_mm_min_ps(t1, t2), xyz_mask);
+        const auto far = _mm_or_ps(_mm_and_ps(_mm_max_ps(t1, t2), xyz_mask), _mm_andnot_ps(xyz_mask, _mm_set1_ps(max_distance)));
+
+        auto entry = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(2, 3, 0, 1)));
+        entry = _mm_max_ps(entry, _mm_shuffle_ps(entry, entry, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        auto exit = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(2, 3, 0, 1)));
+        exit = _mm_min_ps(exit, _mm_shuffle_ps(exit, exit, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        const auto entry_distance = _mm_cvtss_f32(entry);
+        return entry_distance <= _mm_cvtss_f32(exit) ? entry_distance : FLT_MAX;
+    }
+
+    /*!
+     * \brief Moller-Trumbore ray/triangle intersection, without backface culling
+     *
+     * \return True if the ray hits the triangle closer than `hit.distance`, in which case `hit` gets the new hit
+     */
+    static bool intersect_triangle(const BvhTriangle& triangle, const TraversalRay& ray, RayHit& hit) {
+        const auto p = glm::cross(ray.direction, triangle.edge2);
+        const auto determinant = glm::dot(triangle.edge1, p);
+        if(std::abs(determinant) < 1e-12f) {
+            return false;
+        }
+
+        const auto inverse_determinant = 1.0f / determinant;
+        const auto to_origin = ray.origin - triangle.v0;
+        const auto u = glm::dot(to_origin, p) * inverse_determinant;
+        if(u < 0.0f || u > 1.0f) {
+            return false;
+        }
+
+        const auto q = glm::cross(to_origin, triangle.edge1);
+        const auto v = glm::dot(ray.direction, q) * inverse_determinant;
+        if(v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+
+        const auto distance = glm::dot(triangle.edge2, q) * inverse_determinant;
+        if(distance < 0.0f || distance >= hit.distance) {
+            return false;
+        }
+
+        hit.distance = distance;
+        hit.barycentric_u = u;
+        hit.barycentric_v = v;
+        hit.triangle_idx = triangle.triangle_idx;
+
+        return true;
+    }
+
+    /*!
+     * \brief Walks the nodes that the ray passes through, nearest child first, and calls `intersect_leaf` for every leaf the ray reaches
+     * before `hit.distance`
+     *
+     * \param intersect_leaf Tests the ray against the primitives of a leaf. Returns true if it found a closer hit and updated `hit`
+     */
+    template <typename IntersectLeafFunc>
+    static bool traverse(const Rx::Vector<BvhNode>& nodes, const TraversalRay& ray, RayHit& hit, IntersectLeafFunc&& intersect_leaf) {
+        if(nodes.is_empty() || intersect_node(nodes[0], ray, hit.distance) == FLT_MAX) {
+            return false;
+        }
+
+        struct StackEntry {
+            Uint32 node_idx;
+
+            Float32 distance;
+        };
+
+        StackEntry stack[TRAVERSAL_STACK_SIZE];
+        Uint32 stack_size = 0;
+
+        auto found_hit = false;
+        auto node_idx = 0u;
+        while(true) {
+            const auto& node = nodes[node_idx];
+            if(node.is_leaf()) {
+                found_hit |= intersect_leaf(node, hit);
+
+            } else {
+                auto near_idx = node.first;
+                auto far_idx = node.first + 1;
+                auto near_distance = intersect_node(nodes[near_idx], ray, hit.distance);
+                auto far_distance = intersect_node(nodes[far_idx], ray, hit.distance);
+                if(far_distance < near_distance) {
+                    std::swap(near_idx, far_idx);
+                    std::swap(near_distance, far_distance);
+                }
+
+                if(near_distance != FLT_MAX) {
+                    if(far_distance != FLT_MAX) {
+                        RX_ASSERT(stack_size < TRAVERSAL_STACK_SIZE, "BVH is deeper than its traversal stack");
+                        stack[stack_size] = StackEntry{.node_idx = far_idx, .distance = far_distance};
+                        stack_size++;
+                    }
+
+                    node_idx = near_idx;
+                    continue;
+                }
+            }
+
+            // Skip nodes that are further away than a hit that was found after they were pushed
+            while(stack_size > 0 && stack[stack_size - 1].distance >= hit.distance) {
+                stack_size--;
+            }
+
+            if(stack_size == 0) {
+                break;
+            }
+
+            stack_size--;
+            node_idx = stack[stack_size].node_idx;
+        }
+
+        return found_hit;
+    }
+
+    static bool trace_mesh(const MeshBvh& bvh, const TraversalRay& ray, RayHit& hit) {
+        return traverse(bvh.nodes, ray, hit, [&](const BvhNode& leaf, RayHit& leaf_hit) {
+            auto found_hit = false;
+            for(auto triangle_idx = leaf.first; triangle_idx < leaf.first + leaf.num_primitives; triangle_idx++) {
+                found_hit |= intersect_triangle(bvh.triangles[triangle_idx], ray, leaf_hit);
+            }
+
+            return found_hit;
+        });
+    }
+
+    Rx::Optional<RayHit> trace_ray(const MeshBvh& bvh, const Ray& ray) {
+        auto hit = RayHit{.distance = ray.max_distance};
+        if(trace_mesh(bvh, make_traversal_ray(ray.origin, ray.direction), hit)) {
+            return hit;
+        }
+
+        return Rx::nullopt;
+    }
+
+    Rx::Optional<RayHit> trace_ray(const SceneBvh& bvh, const Ray& ray) {
+        auto hit = RayHit{.distance = ray.max_distance};
+        const auto world_ray = make_traversal_ray(ray.origin, ray.direction);
+
+        const auto found_hit = traverse(bvh.nodes, world_ray, hit, [&](const BvhNode& leaf, RayHit& leaf_hit) {
+            auto found_instance_hit = false;
+            for(auto instance_idx = leaf.first; instance_idx < leaf.first + leaf.num_primitives; instance_idx++) {
+                const auto& instance = bvh.instances[instance_idx];
+
+                // The direction isn't normalized after the transform, so distances along the object-space ray are the same as along the
+                // world-space ray
+                const auto& matrix = instance.world_to_object_matrix;
+                const auto object_ray = make_traversal_ray(glm::vec3{matrix * glm::vec4{ray.origin, 1.0f}},
+                                                           glm::vec3{matrix * glm::vec4{ray.direction, 0.0f}});
+                if(trace_mesh(*instance.bvh, object_ray, leaf_hit)) {
+                    leaf_hit.instance_id = instance.id;
+                    found_instance_hit = true;
+                }
+            }
+
+            return found_instance_hit;
+        });
+
+        if(found_hit) {
+            return hit;
+        }
+
+        return Rx::nullopt;
+    }
+
+    Float32 get_sah_cost(const Rx::Vector<BvhNode>& nodes) {
+        if(nodes.is_empty()) {
+            return 0;
+        }
+
+        const auto get_half_area = [](const BvhNode& node) {
+            const auto extents = node.max - node.min;
+            return extents.x * extents.y + extents.y * extents.z + extents.z * extents.x;
+        };
+
+        const auto root_area = get_half_area(nodes[0]);
+        if(root_area <= 0) {
+            return static_cast<Float32>(nodes[0].num_primitives);
+        }
+
+        auto cost = 0.0;
+        nodes.each_fwd([&](const BvhNode& node) {
+            const auto relative_area = get_half_area(node) / root_area;
+            cost += relative_area * (node.is_leaf() ? static_cast<Float32>(node.num_primitives) : TRAVERSAL_COST);
+        });
+
+        return static_cast<Float32>(cost);
+    }
+
+    /*!
+     * \brief Traces random rays through a MeshBvh or a SceneBvh from all around it, and fills in the ray counts and timings of the result
+     */
+    template <typename BvhType>
+    static void trace_benchmark_rays(const BvhType& bvh, ThreadPool* thread_pool, const Uint32 num_rays, BvhBenchmarkResult& result) {
+        result.num_rays = num_rays;
+        if(bvh.nodes.is_empty() || num_rays == 0) {
+            return;
+        }
+
+        // Shoot rays from a sphere around the BVH at random points inside its bounds, so that most of them hit something
+        const auto& root = bvh.nodes[0];
+        const auto center = (root.min + root.max) * 0.5f;
+        const auto radius = glm::max(glm::length(root.max - root.min), 1e-3f);
+
+        Rx::Vector<Ray> rays;
+        rays.reserve(num_rays);
+
+        // xorshift32, so the rays don't depend on the standard library's random engines
+        Uint32 state = 1;
+        const auto next_float = [&] {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return static_cast<Float32>(state >> 8) / static_cast<Float32>(1 << 24);
+        };
+
+        for(Uint32 ray_idx = 0; ray_idx < num_rays; ray_idx++) {
+            auto direction_to_origin = glm::vec3{next_float() * 2.0f - 1.0f, next_float() * 2.0f - 1.0f, next_float() * 2.0f - 1.0f};
+            if(glm::dot(direction_to_origin, direction_to_origin) < 1e-6f) {
+                direction_to_origin = glm::vec3{0, 0, 1};
+            }
+
+            const auto origin = center + glm::normalize(direction_to_origin) * radius;
+            const auto target = root.min + (root.max - root.min) * glm::vec3{next_float(), next_float(), next_float()};
+            rays.push_back(Ray{.origin = origin, .direction = glm::normalize(target - origin)});
+        }
+
+        Rx::Concurrency::Atomic<Uint32> num_hits{0};
+        const auto trace_rays = [&](const Uint32 begin, const Uint32 end) {
+            Uint32 num_batch_hits = 0;
+            for(auto ray_idx = begin; ray_idx < end; ray_idx++) {
+                if(trace_ray(bvh, rays[ray_idx])) {
+                    num_batch_hits++;
+                }
+            }
+
+            num_hits.fetch_add(num_batch_hits);
+        };
+
+        const auto trace_start = std::chrono::high_resolution_clock::now();
+        if(thread_pool != nullptr) {
+            thread_pool->parallel_for(num_rays, RAYS_PER_BATCH, trace_rays);
+
+        } else {
+            trace_rays(0, num_rays);
+        }
+        const auto trace_ms = std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() - trace_start).count();
+
+        result.num_hits = num_hits.load();
+        result.trace_ms = trace_ms;
+        result.megarays_per_second = trace_ms > 0 ? static_cast<Float64>(num_rays) / (trace_ms * 1000.0) : 0;
+    }
+
+    BvhBenchmarkResult benchmark_bvh(const glm::vec3* locations,
+                                     const Uint32 num_vertices,
+                                     const Uint32* indices,
+                                     const Uint32 num_indices,
+                                     ThreadPool* thread_pool,
+                                     const Uint32 num_rays) {
+        ZoneScoped;
+
+        const auto build_start = std::chrono::high_resolution_clock::now();
+        const auto bvh = build_mesh_bvh(locations, num_vertices, indices, num_indices, thread_pool);
+        const auto build_ms = std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() - build_start).count();
+
+        auto result = BvhBenchmarkResult{.num_triangles = static_cast<Uint32>(bvh.triangles.size()),
+                                         .num_nodes = static_cast<Uint32>(bvh.nodes.size()),
+                                         .build_ms = build_ms,
+                                         .sah_cost = get_sah_cost(bvh.nodes)};
+        trace_benchmark_rays(bvh, thread_pool, num_rays, result);
+
+        return result;
+    }
+
+    BvhBenchmarkResult benchmark_scene_bvh(const Rx::Vector<BvhInstance>& instances, ThreadPool* thread_pool, const Uint32 num_rays) {
+        ZoneScoped;
+
+        const auto build_start = std::chrono::high_resolution_clock::now();
+        const auto bvh = build_scene_bvh(instances, thread_pool);
+        const auto build_ms = std::chrono::duration<Float64, std::milli>(std::chrono::high_resolution_clock::now() - build_start).count();
+
+        Uint32 num_triangles = 0;
+        bvh.instances.each_fwd(
+            [&](const SceneBvhInstance& instance) { num_triangles += static_cast<Uint32>(instance.bvh->triangles.size()); });
+
+        auto result = BvhBenchmarkResult{.num_triangles = num_triangles,
+                                         .num_nodes = static_cast<Uint32>(bvh.nodes.size()),
+                                         .build_ms = build_ms,
+                                         .sah_cost = get_sah_cost(bvh.nodes)};
+        trace_benchmark_rays(bvh, thread_pool, num_rays, result);
+
+        return result;
+    }
+} // namespace sanity::engine::renderer
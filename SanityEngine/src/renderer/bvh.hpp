@@ -0,0 +1,220 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+}
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief A node of a bounding volume hierarchy
+     *
+     * Nodes are 32 bytes. An interior node's children are next to each other, so traversal reads both of their bounds from one place
+     */
+    struct BvhNode {
+        glm::vec3 min{0};
+
+        /*!
+         * \brief Index of the node's first child if it's an interior node, or of its first primitive if it's a leaf. An interior node's
+         * second child directly follows its first child
+         */
+        Uint32 first{0};
+
+        glm::vec3 max{0};
+
+        /*!
+         * \brief Number of primitives in the leaf, or 0 for interior nodes
+         */
+        Uint32 num_primitives{0};
+
+        [[nodiscard]] bool is_leaf() const { return num_primitives != 0; }
+    };
+
+    static_assert(sizeof(BvhNode) == 32, "BVH nodes must stay 32 bytes");
+
+    /*!
+     * \brief A triangle in a MeshBvh, stored as one vertex and two edges so that ray intersection doesn't have to look up the vertices
+     */
+    struct BvhTriangle {
+        glm::vec3 v0{0};
+
+        glm::vec3 edge1{0};
+
+        glm::vec3 edge2{0};
+
+        /*!
+         * \brief Index of the triangle in the mesh's index buffer. The triangle's first index is at three times this
+         */
+        Uint32 triangle_idx{0};
+    };
+
+    /*!
+     * \brief Bounding volume hierarchy over the triangles of one mesh, in the mesh's local space
+     */
+    struct MeshBvh {
+        /*!
+         * \brief All the nodes of the BVH, starting with the root. Empty if the mesh has no triangles
+         */
+        Rx::Vector<BvhNode> nodes;
+
+        /*!
+         * \brief The mesh's triangles, in the order that the leaves refer to them
+         */
+        Rx::Vector<BvhTriangle> triangles;
+    };
+
+    /*!
+     * \brief A mesh placed in the world, for SceneBvh
+     */
+    struct BvhInstance {
+        /*!
+         * \brief The mesh's BVH. It must stay alive for as long as any SceneBvh that uses it
+         */
+        const MeshBvh* bvh{nullptr};
+
+        glm::mat4 world_matrix{1};
+
+        /*!
+         * \brief Identifies the instance in ray hits, such as the entity which placed the mesh
+         */
+        Uint32 id{0};
+    };
+
+    struct SceneBvhInstance {
+        const MeshBvh* bvh{nullptr};
+
+        glm::mat4 world_to_object_matrix{1};
+
+        Uint32 id{0};
+    };
+
+    /*!
+     * \brief Two-level bounding volume hierarchy over placed meshes. The leaves of the top level are mesh instances, and each instance
+     * refers to the BVH of its mesh
+     */
+    struct SceneBvh {
+        Rx::Vector<BvhNode> nodes;
+
+        /*!
+         * \brief The instances with a non-empty BVH, in the order that the leaves refer to them
+         */
+        Rx::Vector<SceneBvhInstance> instances;
+    };
+
+    struct Ray {
+        glm::vec3 origin{0};
+
+        /*!
+         * \brief Direction of the ray. Hit distances are in multiples of this direction's length
+         */
+        glm::vec3 direction{0, 0, 1};
+
+        /*!
+         * \brief Hits further along the ray than this are ignored
+         */
+        Float32 max_distance{1e30f};
+    };
+
+    struct RayHit {
+        /*!
+         * \brief Distance along the ray to the hit, in multiples of the ray direction's length
+         */
+        Float32 distance{0};
+
+        Float32 barycentric_u{0};
+
+        Float32 barycentric_v{0};
+
+        /*!
+         * \brief Index of the triangle that was hit in its mesh's index buffer, divided by three
+         */
+        Uint32 triangle_idx{0};
+
+        /*!
+         * \brief ID of the instance that was hit. Always 0 for hits in a MeshBvh
+         */
+        Uint32 instance_id{0};
+    };
+
+    /*!
+     * \brief Builds a BVH over a triangle list by binning the triangles' centroids, and splitting each node where the surface area
+     * heuristic says it's cheapest to trace rays against its children
+     *
+     * Nodes with many triangles bin them on all the thread pool's threads. Once the top of the tree is split into enough pieces, the
+     * subtrees below are built in parallel
+     *
+     * \param thread_pool Thread pool to build the BVH on. If this is nullptr, the BVH is built on the calling thread
+     */
+    [[nodiscard]] MeshBvh build_mesh_bvh(const glm::vec3* locations,
+                                         Uint32 num_vertices,
+                                         const Uint32* indices,
+                                         Uint32 num_indices,
+                                         ThreadPool* thread_pool = nullptr);
+
+    /*!
+     * \brief Builds the top level of a two-level BVH over the world-space bounds of the instances
+     */
+    [[nodiscard]] SceneBvh build_scene_bvh(const Rx::Vector<BvhInstance>& instances, ThreadPool* thread_pool = nullptr);
+
+    /*!
+     * \brief Finds the closest triangle that the ray hits, from either side
+     */
+    [[nodiscard]] Rx::Optional<RayHit> trace_ray(const MeshBvh& bvh, const Ray& ray);
+
+    /*!
+     * \brief Finds the closest triangle of any instance that the ray hits, from either side
+     */
+    [[nodiscard]] Rx::Optional<RayHit> trace_ray(const SceneBvh& bvh, const Ray& ray);
+
+    /*!
+     * \brief Expected cost of tracing a ray through the BVH according to the surface area heuristic, in units of ray/triangle tests
+     */
+    [[nodiscard]] Float32 get_sah_cost(const Rx::Vector<BvhNode>& nodes);
+
+    struct BvhBenchmarkResult {
+        Uint32 num_triangles{0};
+
+        Uint32 num_nodes{0};
+
+        Float64 build_ms{0};
+
+        Float32 sah_cost{0};
+
+        Uint32 num_rays{0};
+
+        Uint32 num_hits{0};
+
+        Float64 trace_ms{0};
+
+        Float64 megarays_per_second{0};
+    };
+
+    /*!
+     * \brief Builds a BVH over a triangle list, then traces random rays through it from all around the mesh. Doesn't need a GPU
+     *
+     * The rays are the same for the same mesh, so benchmark runs can be compared
+     *
+     * \param thread_pool Thread pool to build the BVH and trace the rays on. If this is nullptr, everything happens on the calling thread
+     */
+    [[nodiscard]] BvhBenchmarkResult benchmark_bvh(const glm::vec3* locations,
+                                                   Uint32 num_vertices,
+                                                   const Uint32* indices,
+                                                   Uint32 num_indices,
+                                                   ThreadPool* thread_pool = nullptr,
+                                                   Uint32 num_rays = 1 << 20);
+
+    /*!
+     * \brief Builds the top level of a two-level BVH over the instances, then traces random rays through it from all around the scene
+     *
+     * The instances' mesh BVHs must already be built. The result's triangle count is the sum of the instances' triangles, and its node
+     * count and SAH cost are the top level's
+     */
+    [[nodiscard]] BvhBenchmarkResult benchmark_scene_bvh(const Rx::Vector<BvhInstance>& instances,
+                                                         ThreadPool* thread_pool = nullptr,
+                                                         Uint32 num_rays = 1 << 20);
+} // namespace sanity::engine::renderer
@@ -0,0 +1,167 @@
+#include "d3d12_frame_backend.hpp"
+
+#include <cstring>
+
+#include "renderer/renderer.hpp"
+#include "renderer/rhi/d3d12_private_data.hpp"
+#include "renderer/rhi/d3dx12.hpp"
+#include "renderer/rhi/render_backend.hpp"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine::renderer {
+    D3D12FrameBackend::D3D12FrameBackend(Renderer& renderer_in) : renderer{&renderer_in} {}
+
+    void D3D12FrameBackend::set_pass_inputs(entt::registry& registry_in, const Uint32 frame_idx_in, const Float32 delta_time_in) {
+        registry = &registry_in;
+        frame_idx = frame_idx_in;
+        delta_time = delta_time_in;
+    }
+
+    Uint32 D3D12FrameBackend::get_max_num_gpu_frames() const { return renderer->backend->get_max_num_gpu_frames(); }
+
+    BufferHandle D3D12FrameBackend::create_upload_buffer(const Rx::String& name, const Uint32 size) {
+        return renderer->create_buffer(BufferCreateInfo{.name = name, .usage = BufferUsage::ConstantBuffer, .size = size});
+    }
+
+    void D3D12FrameBackend::write_buffer(const BufferHandle buffer, const Uint64 offset, const void* data, const Uint64 num_bytes) {
+        auto* dst = static_cast<Uint8*>(renderer->all_buffers[buffer.index].mapped_ptr);
+        memcpy(dst + offset, data, num_bytes);
+    }
+
+    Rx::Optional<BoundingBox> D3D12FrameBackend::get_mesh_bounds(const Mesh& mesh) const {
+        return renderer->get_mesh_store(mesh).get_mesh_bounds(mesh);
+    }
+
+    const Rx::Vector<MeshletBounds>* D3D12FrameBackend::get_meshlet_bounds(const Mesh& mesh) const {
+        return renderer->get_mesh_store(mesh).get_meshlet_bounds(mesh);
+    }
+
+    void D3D12FrameBackend::write_buffer_descriptor(const Uint32 buffer_idx, const Uint32 descriptor_idx) {
+        renderer->write_buffer_descriptor(buffer_idx, get_staging_descriptor(descriptor_idx));
+    }
+
+    void D3D12FrameBackend::write_texture_descriptors(const Uint32 texture_idx,
+                                                      const Uint32 srv_descriptor_idx,
+                                                      const Uint32 uav_descriptor_idx) {
+        renderer->write_texture_descriptors(texture_idx,
+                                            get_staging_descriptor(srv_descriptor_idx),
+                                            get_staging_descriptor(uav_descriptor_idx));
+    }
+
+    void D3D12FrameBackend::copy_descriptors(const Uint32 frame_idx_in, const Uint32 first_descriptor, const Uint32 num_descriptors) {
+        const auto descriptor_size = renderer->backend->get_cbv_srv_uav_allocator().get_descriptor_size();
+        const auto& frame_descriptors = renderer->resource_descriptors[frame_idx_in];
+
+        renderer->backend->get_d3d12_device()->CopyDescriptorsSimple(num_descriptors,
+                                                                     CD3DX12_CPU_DESCRIPTOR_HANDLE{frame_descriptors.cpu_handle,
+                                                                                                   static_cast<INT>(first_descriptor),
+                                                                                                   descriptor_size},
+                                                                     get_staging_descriptor(first_descriptor),
+                                                                     D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+
+    Uint64 D3D12FrameBackend::get_transient_texture_size(const Uint32 texture_idx) const {
+        return renderer->backend->get_reserved_texture_size(renderer->all_textures[texture_idx]);
+    }
+
+    bool D3D12FrameBackend::map_transient_textures(const Rx::Vector<Uint32>& texture_indices,
+                                                   const Rx::Vector<Uint64>& offsets,
+                                                   const Uint64 heap_size) {
+        Rx::Vector<Texture> textures;
+        textures.reserve(texture_indices.size());
+        texture_indices.each_fwd([&](const Uint32 texture_idx) { textures.push_back(renderer->all_textures[texture_idx]); });
+
+        return renderer->backend->map_reserved_textures(textures, offsets, heap_size);
+    }
+
+    void D3D12FrameBackend::begin_render_passes(const Uint32 num_command_lists) {
+        command_lists.clear();
+        command_lists.resize(num_command_lists);
+    }
+
+    void D3D12FrameBackend::resource_barriers(const Uint32 command_list_idx, const Rx::Vector<RenderGraphBarrier>& barriers) {
+        auto d3d12_barriers = Rx::Vector<D3D12_RESOURCE_BARRIER>{};
+        d3d12_barriers.reserve(barriers.size());
+
+        barriers.each_fwd([&](const RenderGraphBarrier& barrier) {
+            ID3D12Resource* resource;
+            if((barrier.resource & FrameStages::RENDER_GRAPH_BUFFER_BIT) != 0) {
+                resource = *renderer->all_buffers[barrier.resource & ~FrameStages::RENDER_GRAPH_BUFFER_BIT].resource;
+            } else {
+                resource = renderer->get_texture(barrier.resource).resource;
+            }
+
+            auto d3d12_barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource,
+                                                                      static_cast<D3D12_RESOURCE_STATES>(barrier.state_before),
+                                                                      static_cast<D3D12_RESOURCE_STATES>(barrier.state_after));
+
+            if(barrier.type == RenderGraphBarrierType::SplitBegin) {
+                d3d12_barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+
+            } else if(barrier.type == RenderGraphBarrierType::SplitEnd) {
+                d3d12_barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            }
+
+            d3d12_barriers.push_back(d3d12_barrier);
+        });
+
+        get_command_list(command_list_idx)->ResourceBarrier(static_cast<UINT>(d3d12_barriers.size()), d3d12_barriers.data());
+    }
+
+    void D3D12FrameBackend::activate_transient_textures(const Uint32 command_list_idx, const Rx::Vector<RenderGraphResourceUsage>& usages) {
+        Rx::Vector<D3D12_RESOURCE_BARRIER> barriers;
+        Rx::Vector<ID3D12Resource*> textures_to_discard;
+        barriers.reserve(usages.size());
+
+        usages.each_fwd([&](const RenderGraphResourceUsage& usage) {
+            const auto& texture = renderer->all_textures[usage.resource];
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, texture.resource));
+
+            // Render targets, depth targets, and UAVs must be initialized after they're activated. Every pass which writes to one of those
+            // overwrites it anyways, so discarding is free
+            constexpr Uint32 DISCARDABLE_STATES = D3D12_RESOURCE_STATE_RENDER_TARGET | D3D12_RESOURCE_STATE_DEPTH_WRITE |
+                                                  D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+            if((usage.begin_state & DISCARDABLE_STATES) != 0) {
+                textures_to_discard.push_back(texture.resource);
+            }
+        });
+
+        auto* commands = get_command_list(command_list_idx);
+        commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+        textures_to_discard.each_fwd([&](ID3D12Resource* texture) { commands->DiscardResource(texture, nullptr); });
+    }
+
+    void D3D12FrameBackend::execute_pass(const Uint32 command_list_idx, const Uint32 pass_idx) {
+        renderer->render_passes[pass_idx]->record_work(get_command_list(command_list_idx), *registry, frame_idx, delta_time);
+    }
+
+    void D3D12FrameBackend::end_render_passes() {
+        command_lists.each_fwd([&](ComPtr<ID3D12GraphicsCommandList4>& commands) {
+            if(*commands != nullptr) {
+                renderer->backend->submit_command_list(Rx::Utility::move(commands));
+            }
+        });
+        command_lists.clear();
+    }
+
+    ID3D12GraphicsCommandList4* D3D12FrameBackend::get_command_list(const Uint32 command_list_idx) {
+        auto& commands = command_lists[command_list_idx];
+        if(*commands == nullptr) {
+            commands = renderer->backend->create_render_command_list(frame_idx);
+            set_object_name(commands, Rx::String::format("Render passes command list %d for frame %d", command_list_idx, frame_idx));
+
+            renderer->bind_global_resources(commands, frame_idx);
+        }
+
+        return commands;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE D3D12FrameBackend::get_staging_descriptor(const Uint32 descriptor_idx) const {
+        const auto descriptor_size = renderer->backend->get_cbv_srv_uav_allocator().get_descriptor_size();
+
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE{renderer->staging_resource_descriptors->GetCPUDescriptorHandleForHeapStart(),
+                                             static_cast<INT>(descriptor_idx),
+                                             descriptor_size};
+    }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "core/types.hpp"
+#include "entt/entity/fwd.hpp"
+#include "renderer/rhi/frame_backend.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    class Renderer;
+
+    /*!
+     * \brief Puts Renderer's D3D12 device behind the FrameBackend interface, so that Renderer's frame stages can run in FrameStages
+     *
+     * Resources are Renderer's buffers and textures, descriptors go through Renderer's staging copy of the resource array, and passes are
+     * Renderer's render passes. Every command list begins with the global resources which all render passes expect to be bound
+     */
+    class D3D12FrameBackend final : public FrameBackend {
+    public:
+        explicit D3D12FrameBackend(Renderer& renderer_in);
+
+        D3D12FrameBackend(const D3D12FrameBackend& other) = delete;
+        D3D12FrameBackend& operator=(const D3D12FrameBackend& other) = delete;
+
+        D3D12FrameBackend(D3D12FrameBackend&& old) noexcept = delete;
+        D3D12FrameBackend& operator=(D3D12FrameBackend&& old) noexcept = delete;
+
+        ~D3D12FrameBackend() override = default;
+
+        /*!
+         * \brief Sets what the render passes record their work with this frame. Must be called before the frame's render passes
+         */
+        void set_pass_inputs(entt::registry& registry_in, Uint32 frame_idx_in, Float32 delta_time_in);
+
+        [[nodiscard]] Uint32 get_max_num_gpu_frames() const override;
+
+        [[nodiscard]] BufferHandle create_upload_buffer(const Rx::String& name, Uint32 size) override;
+
+        void write_buffer(BufferHandle buffer, Uint64 offset, const void* data, Uint64 num_bytes) override;
+
+        [[nodiscard]] Rx::Optional<BoundingBox> get_mesh_bounds(const Mesh& mesh) const override;
+
+        [[nodiscard]] const Rx::Vector<MeshletBounds>* get_meshlet_bounds(const Mesh& mesh) const override;
+
+        void write_buffer_descriptor(Uint32 buffer_idx, Uint32 descriptor_idx) override;
+
+        void write_texture_descriptors(Uint32 texture_idx, Uint32 srv_descriptor_idx, Uint32 uav_descriptor_idx) override;
+
+        void copy_descriptors(Uint32 frame_idx, Uint32 first_descriptor, Uint32 num_descriptors) override;
+
+        [[nodiscard]] Uint64 get_transient_texture_size(Uint32 texture_idx) const override;
+
+        bool map_transient_textures(const Rx::Vector<Uint32>& texture_indices,
+                                    const Rx::Vector<Uint64>& offsets,
+                                    Uint64 heap_size) override;
+
+        void begin_render_passes(Uint32 num_command_lists) override;
+
+        void resource_barriers(Uint32 command_list_idx, const Rx::Vector<RenderGraphBarrier>& barriers) override;
+
+        /*!
+         * \brief Issues aliasing barriers for the textures, and discards the contents of the ones that the pass writes to so that they're
+         * in a valid state
+         */
+        void activate_transient_textures(Uint32 command_list_idx, const Rx::Vector<RenderGraphResourceUsage>& usages) override;
+
+        void execute_pass(Uint32 command_list_idx, Uint32 pass_idx) override;
+
+        void end_render_passes() override;
+
+    private:
+        Renderer* renderer;
+
+        entt::registry* registry{nullptr};
+
+        Uint32 frame_idx{0};
+
+        Float32 delta_time{0};
+
+        /*!
+         * \brief Command lists since `begin_render_passes`. Each one is created the first time something records into it
+         */
+        Rx::Vector<ComPtr<ID3D12GraphicsCommandList4>> command_lists;
+
+        [[nodiscard]] ID3D12GraphicsCommandList4* get_command_list(Uint32 command_list_idx);
+
+        [[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE get_staging_descriptor(Uint32 descriptor_idx) const;
+    };
+} // namespace sanity::engine::renderer
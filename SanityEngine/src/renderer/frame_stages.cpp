@@ -0,0 +1,445 @@
+#include "frame_stages.hpp"
+
+#include "Tracy.hpp"
+#include "core/async/thread_pool.hpp"
+#include "core/components.hpp"
+#include "core/constants.hpp"
+#include "entt/entity/registry.hpp"
+#include "renderer/render_components.hpp"
+#include "rx/console/variable.h"
+#include "rx/core/abort.h"
+#include "rx/core/log.h"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine::renderer {
+    RX_LOG("FrameStages", logger);
+
+    RX_CONSOLE_BVAR(r_enable_frustum_culling,
+                    "render.EnableFrustumCulling",
+                    "Whether to skip drawing objects that are outside the player camera's view",
+                    true);
+
+    RX_CONSOLE_BVAR(r_enable_meshlet_culling,
+                    "render.EnableMeshletCulling",
+                    "Whether to cull the meshlets of visible objects on the CPU, to measure how many the player camera could skip",
+                    false);
+
+    RX_CONSOLE_FVAR(r_lod_pixel_error,
+                    "render.LodPixelError",
+                    "How many pixels the surface of a mesh LOD may be off by on screen. 0 always draws the full meshes",
+                    0.0f,
+                    100.0f,
+                    1.0f);
+
+    FrameStages::FrameStages(const FrameStagesCreateInfo& create_info, FrameBackend& backend_in)
+        : backend{&backend_in},
+          max_num_model_matrices{create_info.max_num_model_matrices},
+          transient_texture_alignment{create_info.transient_texture_alignment},
+          model_matrix_store{create_info.max_num_model_matrices, backend_in.get_max_num_gpu_frames()},
+          bindless_descriptor_tracker{create_info.num_resource_descriptors, backend_in.get_max_num_gpu_frames()},
+          render_graph_compiler{create_info.write_resource_states, create_info.initial_resource_state, false} {
+        // Each frame's model matrix buffer is created by its first `update_model_matrices`
+        model_matrix_buffers.resize(backend_in.get_max_num_gpu_frames());
+    }
+
+    void FrameStages::queue_buffer_descriptor(const Uint32 buffer_idx) { pending_buffer_descriptors.push_back(buffer_idx); }
+
+    void FrameStages::queue_texture_descriptors(const Uint32 texture_idx) { pending_texture_descriptors.push_back(texture_idx); }
+
+    void FrameStages::add_transient_texture(const TextureHandle texture) {
+        transient_textures.push_back(texture);
+        are_transient_textures_changed = true;
+    }
+
+    void FrameStages::remove_transient_texture(const TextureHandle texture) {
+        for(Uint32 i = 0; i < transient_textures.size(); i++) {
+            if(transient_textures[i] == texture) {
+                // Keep the order of the other transient textures, since their packing requests are in the same order
+                for(Uint32 next = i + 1; next < transient_textures.size(); next++) {
+                    transient_textures[next - 1] = transient_textures[next];
+                }
+                transient_textures.pop_back();
+
+                // The texture is gone, so no pass may activate it before we re-pack
+                aliased_transient_texture_indices.erase(texture.index);
+                are_transient_textures_changed = true;
+                break;
+            }
+        }
+    }
+
+    void FrameStages::update_transforms(entt::registry& registry, ThreadPool* thread_pool) {
+        transform_hierarchy.update(registry, thread_pool);
+    }
+
+    void FrameStages::cull_scene(entt::registry& registry,
+                                 const glm::mat4& view_matrix,
+                                 const glm::mat4& projection_matrix,
+                                 const Uint32 output_height) {
+        ZoneScoped;
+
+        frustum_culler.clear();
+        culled_entities.clear();
+        visible_objects.clear();
+        visible_object_lods.clear();
+
+        world_bounds_cache.begin_frame(transform_hierarchy);
+
+        const auto renderable_view = registry.view<TransformComponent, StandardRenderableComponent>();
+        culled_entities.reserve(renderable_view.size());
+
+        renderable_view.each([&](const auto entity, const TransformComponent&, const StandardRenderableComponent& renderable) {
+            culled_entities.push_back(entity);
+
+            if(r_enable_frustum_culling->get()) {
+                frustum_culler.add_object(world_bounds_cache.get_world_bounds(entity, get_local_bounds(renderable), registry));
+            }
+        });
+
+        const auto camera_location = glm::vec3{glm::inverse(view_matrix)[3]};
+        const auto pixels_per_unit = 0.5f * static_cast<Float32>(output_height) * projection_matrix[1][1];
+
+        const auto add_visible_object = [&](const Uint32 object_idx) {
+            const auto entity = culled_entities[object_idx];
+            const auto& renderable = registry.get<StandardRenderableComponent>(entity);
+            const auto model_matrix = transform_hierarchy.get_world_matrix(entity, registry);
+
+            visible_objects.push_back(entity);
+            visible_object_lods.push_back(
+                select_mesh_lod(renderable.mesh, get_local_bounds(renderable), model_matrix, camera_location, pixels_per_unit));
+        };
+
+        const auto view_projection_matrix = projection_matrix * view_matrix;
+
+        if(r_enable_frustum_culling->get()) {
+            frustum_culler.cull(view_projection_matrix);
+
+            const auto& visible_object_indices = frustum_culler.get_visible_objects();
+            visible_objects.reserve(visible_object_indices.size());
+            visible_object_lods.reserve(visible_object_indices.size());
+            visible_object_indices.each_fwd(add_visible_object);
+
+        } else {
+            visible_objects.reserve(culled_entities.size());
+            visible_object_lods.reserve(culled_entities.size());
+            for(Uint32 object_idx = 0; object_idx < culled_entities.size(); object_idx++) {
+                add_visible_object(object_idx);
+            }
+        }
+
+        if(r_enable_meshlet_culling->get()) {
+            cull_visible_meshlets(registry, view_projection_matrix, camera_location);
+        }
+    }
+
+    void FrameStages::update_model_matrices(entt::registry& registry, const Uint32 frame_idx) {
+        ZoneScoped;
+
+        model_matrix_store.begin_update();
+
+        // Every renderable keeps its slot while it's out of view, so a static object's matrix is uploaded once and never again
+        culled_entities.each_fwd([&](const entt::entity entity) { model_matrix_store.use_entity(entity); });
+
+        registry.view<TransformComponent, FluidVolumeComponent>().each(
+            [&](const auto entity, const TransformComponent&, const FluidVolumeComponent&) { model_matrix_store.use_entity(entity); });
+
+        registry.view<TransformComponent, StandardRenderableComponent, OutlineRenderComponent>().each(
+            [&](const auto entity,
+                const TransformComponent& transform,
+                const StandardRenderableComponent& /* renderable */,
+                const OutlineRenderComponent& outline) {
+                // Intentionally a copy - I want to modify the transform for the outline without modifying the transform for the renderable
+                auto outline_transform = transform.transform;
+
+                outline_transform.scale *= outline.outline_scale;
+
+                const auto model_matrix = outline_transform.to_matrix() * transform_hierarchy.get_parent_world_matrix(entity, registry);
+                model_matrix_store.use_derived_matrix(entity, model_matrix);
+            });
+
+        model_matrix_store.end_update(transform_hierarchy, registry);
+
+        auto& model_matrix_buffer = model_matrix_buffers[frame_idx];
+        if(!model_matrix_buffer.is_valid()) {
+            const auto name = Rx::String::format("Model matrix buffer %d", frame_idx);
+            model_matrix_buffer = backend->create_upload_buffer(name, static_cast<Uint32>(sizeof(glm::mat4) * max_num_model_matrices));
+            if(!model_matrix_buffer.is_valid()) {
+                logger->error("Could not create buffer %s", name);
+                return;
+            }
+        }
+
+        model_matrix_store.flush_frame(frame_idx, [&](const Uint32 first_slot, const glm::mat4* matrices, const Uint32 num_matrices) {
+            backend->write_buffer(model_matrix_buffer, first_slot * sizeof(glm::mat4), matrices, num_matrices * sizeof(glm::mat4));
+        });
+    }
+
+    void FrameStages::update_resource_array_descriptors(const Uint32 frame_idx) {
+        ZoneScoped;
+
+        bindless_descriptor_stats = {};
+
+        // Descriptors for new and changed resources are created once, in the CPU-only copy of the resource array. Each frame's copy of
+        // the resource array then copies them from there
+        pending_buffer_descriptors.each_fwd([&](const Uint32 buffer_idx) {
+            backend->write_buffer_descriptor(buffer_idx, buffer_idx);
+
+            bindless_descriptor_tracker.mark_dirty(buffer_idx);
+            bindless_descriptor_stats.num_descriptors_written++;
+        });
+        pending_buffer_descriptors.clear();
+
+        pending_texture_descriptors.each_fwd([&](const Uint32 texture_idx) {
+            const auto srv_idx = MAX_NUM_BUFFERS + texture_idx;
+            const auto uav_idx = srv_idx + UAV_OFFSET;
+            backend->write_texture_descriptors(texture_idx, srv_idx, uav_idx);
+
+            bindless_descriptor_tracker.mark_dirty(srv_idx);
+            bindless_descriptor_tracker.mark_dirty(uav_idx);
+            bindless_descriptor_stats.num_descriptors_written += 2;
+        });
+        pending_texture_descriptors.clear();
+
+        bindless_descriptor_stats.num_descriptors_copied = bindless_descriptor_tracker.flush_frame(
+            frame_idx,
+            [&](const Uint32 first_descriptor, const Uint32 num_descriptors) {
+                backend->copy_descriptors(frame_idx, first_descriptor, num_descriptors);
+                bindless_descriptor_stats.num_copied_ranges++;
+            });
+    }
+
+    void FrameStages::execute_render_graph(const Rx::Vector<RenderGraphPassDescription>& passes, ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        render_graph_compiler.set_split_barriers(thread_pool == nullptr);
+        render_graph = &render_graph_compiler.compile(passes);
+        if(render_graph_compiler.get_num_compiles() != transient_heap_num_compiles || are_transient_textures_changed) {
+            update_transient_texture_memory(passes);
+            transient_heap_num_compiles = render_graph_compiler.get_num_compiles();
+            are_transient_textures_changed = false;
+        }
+
+        const auto num_passes = static_cast<Uint32>(render_graph->pass_order.size());
+
+        if(thread_pool == nullptr) {
+            // One command list for all the passes, so the render graph can split barriers across them
+            backend->begin_render_passes(1);
+
+            for(auto position = 0u; position < num_passes; position++) {
+                record_pass(passes, 0, position);
+            }
+
+            backend->end_render_passes();
+            return;
+        }
+
+        // Every pass gets its own command list, which starts with the barriers before that pass. The lists execute in the order we submit
+        // them, so the barriers end up between the passes just like they would in one big command list
+        backend->begin_render_passes(num_passes);
+
+        thread_pool->parallel_for(num_passes, 1, [&](const Uint32 begin, const Uint32 end) {
+            for(auto position = begin; position < end; position++) {
+                record_pass(passes, position, position);
+            }
+        });
+
+        backend->end_render_passes();
+    }
+
+    const TransformHierarchy& FrameStages::get_transform_hierarchy() const { return transform_hierarchy; }
+
+    Uint32 FrameStages::get_num_culled_objects() const { return static_cast<Uint32>(culled_entities.size()); }
+
+    Uint32 FrameStages::get_num_updated_world_bounds() const { return world_bounds_cache.get_num_updated_bounds(); }
+
+    const Rx::Vector<entt::entity>& FrameStages::get_visible_objects() const { return visible_objects; }
+
+    const Rx::Vector<Uint32>& FrameStages::get_visible_object_lods() const { return visible_object_lods; }
+
+    const MeshletCullingStats& FrameStages::get_meshlet_culling_stats() const { return meshlet_culler.get_stats(); }
+
+    const BufferHandle& FrameStages::get_model_matrix_buffer(const Uint32 frame_idx) const { return model_matrix_buffers[frame_idx]; }
+
+    Uint32 FrameStages::get_model_matrix_slot(const entt::entity entity) const { return model_matrix_store.get_slot(entity); }
+
+    Uint32 FrameStages::get_outline_model_matrix_slot(const entt::entity entity) const {
+        return model_matrix_store.get_derived_slot(entity);
+    }
+
+    const ModelMatrixStats& FrameStages::get_model_matrix_stats() const { return model_matrix_store.get_stats(); }
+
+    const BindlessDescriptorStats& FrameStages::get_bindless_descriptor_stats() const { return bindless_descriptor_stats; }
+
+    const CompiledRenderGraph& FrameStages::get_render_graph() const { return *render_graph; }
+
+    void FrameStages::cull_visible_meshlets(const entt::registry& registry,
+                                            const glm::mat4& view_projection_matrix,
+                                            const glm::vec3& camera_location) {
+        ZoneScoped;
+
+        meshlet_culler.begin_frame(view_projection_matrix, camera_location);
+
+        for(Uint32 object_idx = 0; object_idx < visible_objects.size(); object_idx++) {
+            // Only the full mesh has meshlets, so objects drawn with a simplified LOD have nothing to cull
+            if(visible_object_lods[object_idx] != 0) {
+                continue;
+            }
+
+            const auto entity = visible_objects[object_idx];
+            const auto& renderable = registry.get<StandardRenderableComponent>(entity);
+            const auto* meshlet_bounds = backend->get_meshlet_bounds(renderable.mesh);
+            if(meshlet_bounds == nullptr || meshlet_bounds->is_empty()) {
+                continue;
+            }
+
+            meshlet_culler.cull(*meshlet_bounds,
+                                0,
+                                static_cast<Uint32>(meshlet_bounds->size()),
+                                transform_hierarchy.get_world_matrix(entity, registry));
+        }
+    }
+
+    Rx::Optional<BoundingBox> FrameStages::get_local_bounds(const StandardRenderableComponent& renderable) const {
+        if(renderable.bounds) {
+            return renderable.bounds;
+        }
+
+        return backend->get_mesh_bounds(renderable.mesh);
+    }
+
+    Uint32 FrameStages::select_mesh_lod(const Mesh& mesh,
+                                        const Rx::Optional<BoundingBox>& local_bounds,
+                                        const glm::mat4& model_matrix,
+                                        const glm::vec3& camera_location,
+                                        const Float32 pixels_per_unit) {
+        const auto max_pixel_error = r_lod_pixel_error->get();
+        if(mesh.num_lods == 0 || max_pixel_error <= 0.0f) {
+            return 0;
+        }
+
+        // LOD errors are in the mesh's units, so they grow with the largest scale of the model matrix
+        const auto scale = glm::max(glm::length(glm::vec3{model_matrix[0]}),
+                                    glm::max(glm::length(glm::vec3{model_matrix[1]}), glm::length(glm::vec3{model_matrix[2]})));
+
+        // Measure from the nearest point of the object's bounding sphere, so that big objects don't drop detail right in front of the
+        // camera
+        auto center = glm::vec3{0};
+        auto radius = 0.0f;
+        if(local_bounds) {
+            const auto& bounds = *local_bounds;
+            const auto min = glm::vec3{bounds.x_min, bounds.y_min, bounds.z_min};
+            const auto max = glm::vec3{bounds.x_max, bounds.y_max, bounds.z_max};
+            center = (min + max) * 0.5f;
+            radius = glm::length(max - min) * 0.5f * scale;
+        }
+
+        const auto world_center = glm::vec3{model_matrix * glm::vec4{center, 1.0f}};
+        const auto distance = glm::length(world_center - camera_location) - radius;
+        if(distance <= 0.0f) {
+            return 0;
+        }
+
+        // Later LODs have larger errors, so the first LOD from the end that's accurate enough is the cheapest one that is
+        for(auto lod_idx = mesh.num_lods; lod_idx > 0; lod_idx--) {
+            const auto pixel_error = mesh.lods[lod_idx - 1].error * scale * pixels_per_unit / distance;
+            if(pixel_error <= max_pixel_error) {
+                return lod_idx;
+            }
+        }
+
+        return 0;
+    }
+
+    void FrameStages::update_transient_texture_memory(const Rx::Vector<RenderGraphPassDescription>& passes) {
+        if(transient_textures.is_empty()) {
+            if(!transient_texture_requests.is_empty()) {
+                // The last transient texture was destroyed, so give back the heap
+                backend->map_transient_textures({}, {}, 0);
+                transient_texture_requests.clear();
+                transient_heap_layout = {};
+                aliased_transient_texture_indices.clear();
+            }
+
+            return;
+        }
+
+        ZoneScoped;
+
+        Rx::Vector<Uint32> texture_indices;
+        Rx::Vector<Uint64> texture_sizes;
+        texture_indices.reserve(transient_textures.size());
+        texture_sizes.reserve(transient_textures.size());
+        transient_textures.each_fwd([&](const TextureHandle& handle) {
+            texture_indices.push_back(handle.index);
+            texture_sizes.push_back(backend->get_transient_texture_size(handle.index));
+        });
+
+        auto requests = get_transient_resource_requests(*render_graph, passes, texture_indices, texture_sizes, transient_texture_alignment);
+        if(!transient_lifetimes_changed(transient_texture_requests, requests)) {
+            return;
+        }
+
+        transient_texture_requests = Rx::Utility::move(requests);
+        transient_heap_layout = pack_transient_resources(transient_texture_requests);
+
+        if(!backend->map_transient_textures(texture_indices, transient_heap_layout.offsets, transient_heap_layout.heap_size)) {
+            Rx::abort("Could not allocate memory for transient textures");
+        }
+
+        aliased_transient_texture_indices.clear();
+        for(auto i = 0u; i < transient_textures.size(); i++) {
+            const auto offset = transient_heap_layout.offsets[i];
+            const auto size = transient_texture_requests[i].size;
+            for(auto other = 0u; other < transient_textures.size(); other++) {
+                const auto other_offset = transient_heap_layout.offsets[other];
+                if(other != i && offset < other_offset + transient_texture_requests[other].size && other_offset < offset + size) {
+                    aliased_transient_texture_indices.insert(transient_textures[i].index, i);
+                    break;
+                }
+            }
+        }
+
+        constexpr auto BYTES_PER_MB = 1024.0 * 1024.0;
+        logger->info("Packed %u transient textures into %.2f MB (%.2f MB without aliasing, %.2f MB saved)",
+                     transient_textures.size(),
+                     static_cast<double>(transient_heap_layout.heap_size) / BYTES_PER_MB,
+                     static_cast<double>(transient_heap_layout.total_resource_size) / BYTES_PER_MB,
+                     static_cast<double>(transient_heap_layout.get_saved_bytes()) / BYTES_PER_MB);
+    }
+
+    void FrameStages::record_pass(const Rx::Vector<RenderGraphPassDescription>& passes,
+                                  const Uint32 command_list_idx,
+                                  const Uint32 position) {
+        const auto pass_idx = render_graph->pass_order[position];
+
+        const auto& barriers = render_graph->barrier_batches[position];
+        if(!barriers.is_empty()) {
+            backend->resource_barriers(command_list_idx, barriers);
+        }
+
+        if(!aliased_transient_texture_indices.is_empty()) {
+            Rx::Vector<RenderGraphResourceUsage> activated_textures;
+            passes[pass_idx].resource_usages.each_fwd([&](const RenderGraphResourceUsage& usage) {
+                if((usage.resource & RENDER_GRAPH_BUFFER_BIT) != 0) {
+                    return;
+                }
+
+                const auto* transient_idx = aliased_transient_texture_indices.find(usage.resource);
+                if(transient_idx != nullptr && transient_texture_requests[*transient_idx].first_pass == position) {
+                    activated_textures.push_back(usage);
+                }
+            });
+
+            if(!activated_textures.is_empty()) {
+                backend->activate_transient_textures(command_list_idx, activated_textures);
+            }
+        }
+
+        backend->execute_pass(command_list_idx, pass_idx);
+
+        const auto& final_barriers = render_graph->barrier_batches.last();
+        if(position + 1 == render_graph->pass_order.size() && !final_barriers.is_empty()) {
+            backend->resource_barriers(command_list_idx, final_barriers);
+        }
+    }
+} // namespace sanity::engine::renderer
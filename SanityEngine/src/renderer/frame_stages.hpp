@@ -0,0 +1,313 @@
+#pragma once
+
+#include "core/transform_hierarchy.hpp"
+#include "core/types.hpp"
+#include "entt/entity/fwd.hpp"
+#include "glm/mat4x4.hpp"
+#include "renderer/bindless_descriptor_tracker.hpp"
+#include "renderer/frustum_culler.hpp"
+#include "renderer/mesh.hpp"
+#include "renderer/meshlet_culler.hpp"
+#include "renderer/model_matrix_store.hpp"
+#include "renderer/render_graph.hpp"
+#include "renderer/rhi/frame_backend.hpp"
+#include "renderer/rhi/resources.hpp"
+#include "renderer/transient_resource_packer.hpp"
+#include "renderer/world_bounds_cache.hpp"
+#include "rx/core/map.h"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+}
+
+namespace sanity::engine::renderer {
+    struct StandardRenderableComponent;
+
+    struct FrameStagesCreateInfo {
+        /*!
+         * \brief Number of model matrix slots, which is also the number of matrices in each frame's model matrix buffer
+         */
+        Uint32 max_num_model_matrices{0};
+
+        /*!
+         * \brief Number of descriptors in the bindless resource array. Buffers come first, then texture SRVs, then texture UAVs
+         */
+        Uint32 num_resource_descriptors{0};
+
+        /*!
+         * \brief Bitmask of all the resource states which let a render pass write to a resource
+         */
+        Uint32 write_resource_states{0};
+
+        /*!
+         * \brief The state that every resource is in at the beginning and at the end of a frame
+         */
+        Uint32 initial_resource_state{0};
+
+        /*!
+         * \brief Alignment of the transient textures in the transient texture heap
+         */
+        Uint64 transient_texture_alignment{1};
+    };
+
+    /*!
+     * \brief The CPU side of a frame, which works out what the GPU has to do and hands it to a FrameBackend
+     *
+     * The stages run in this order each frame:
+     * - `update_transforms` updates the world matrices of everything with a TransformComponent
+     * - `cull_scene` culls every StandardRenderableComponent against the player camera, and picks the LOD of each visible object
+     * - `update_model_matrices` writes the model matrices that changed into the frame's model matrix buffer
+     * - `update_resource_array_descriptors` brings the frame's copy of the bindless resource array up to date
+     * - `execute_render_graph` compiles the render graph, packs the transient textures, and records the passes with their barriers
+     *
+     * Renderer runs them against its D3D12 device. HeadlessRenderer runs them against a NullRenderBackend, so they can be measured
+     * without a D3D12 device
+     */
+    class FrameStages {
+    public:
+        /*!
+         * \brief Set in the render graph's ID for a buffer, so that buffers and textures with the same index are different resources
+         */
+        static constexpr Uint32 RENDER_GRAPH_BUFFER_BIT = 0x80000000;
+
+        FrameStages(const FrameStagesCreateInfo& create_info, FrameBackend& backend_in);
+
+        FrameStages(const FrameStages& other) = delete;
+        FrameStages& operator=(const FrameStages& other) = delete;
+
+        FrameStages(FrameStages&& old) noexcept = delete;
+        FrameStages& operator=(FrameStages&& old) noexcept = delete;
+
+        ~FrameStages() = default;
+
+        /*!
+         * \brief Writes the buffer's descriptor at the next `update_resource_array_descriptors`. Call this when a buffer is created or
+         * destroyed
+         */
+        void queue_buffer_descriptor(Uint32 buffer_idx);
+
+        /*!
+         * \brief Writes the texture's descriptors at the next `update_resource_array_descriptors`. Call this when a texture is created or
+         * destroyed
+         */
+        void queue_texture_descriptors(Uint32 texture_idx);
+
+        /*!
+         * \brief Adds a texture which gets its memory from the transient texture heap. The heap is re-packed at the next
+         * `execute_render_graph`
+         */
+        void add_transient_texture(TextureHandle texture);
+
+        /*!
+         * \brief Removes a transient texture, if the texture is one. The heap is re-packed at the next `execute_render_graph`
+         */
+        void remove_transient_texture(TextureHandle texture);
+
+        void update_transforms(entt::registry& registry, ThreadPool* thread_pool = nullptr);
+
+        /*!
+         * \brief Culls every StandardRenderableComponent against the player camera's frustum, filling in the visible objects, and picks the
+         * LOD of each visible object
+         *
+         * \param output_height Height of the image the camera renders to, in pixels
+         */
+        void cull_scene(entt::registry& registry, const glm::mat4& view_matrix, const glm::mat4& projection_matrix, Uint32 output_height);
+
+        /*!
+         * \brief Gives every entity that this frame draws a model matrix slot, and writes the matrices that changed into this frame's model
+         * matrix buffer
+         */
+        void update_model_matrices(entt::registry& registry, Uint32 frame_idx);
+
+        /*!
+         * \brief Writes the descriptors of the resources that changed, then copies the descriptors that the frame's copy of the bindless
+         * resource array is missing
+         */
+        void update_resource_array_descriptors(Uint32 frame_idx);
+
+        /*!
+         * \brief Compiles the render graph, re-packs the transient textures if their lifetimes changed, and records the passes in the order
+         * of the render graph
+         *
+         * Both halves of a split barrier must be in the same command list, so barriers are only split when all the passes record into one
+         * command list
+         *
+         * \param passes Description of each render pass. Must stay the same until the next call
+         * \param thread_pool If provided, every pass records into its own command list on the thread pool. Otherwise, all the passes record
+         * into one command list on this thread
+         */
+        void execute_render_graph(const Rx::Vector<RenderGraphPassDescription>& passes, ThreadPool* thread_pool = nullptr);
+
+        /*!
+         * \brief Gets the world matrices of every entity with a TransformComponent, as of the last `update_transforms`
+         */
+        [[nodiscard]] const TransformHierarchy& get_transform_hierarchy() const;
+
+        /*!
+         * \brief Gets the number of StandardRenderableComponents that the last `cull_scene` looked at
+         */
+        [[nodiscard]] Uint32 get_num_culled_objects() const;
+
+        /*!
+         * \brief Gets the number of world-space bounds that the last `cull_scene` had to recompute
+         */
+        [[nodiscard]] Uint32 get_num_updated_world_bounds() const;
+
+        /*!
+         * \brief Gets all the entities with a StandardRenderableComponent that the player camera can see this frame
+         */
+        [[nodiscard]] const Rx::Vector<entt::entity>& get_visible_objects() const;
+
+        /*!
+         * \brief Gets the LOD to draw each of the visible objects with, in the same order as `get_visible_objects`. LOD 0 is the full mesh,
+         * and LOD n is the mesh's `lods[n - 1]`
+         */
+        [[nodiscard]] const Rx::Vector<Uint32>& get_visible_object_lods() const;
+
+        /*!
+         * \brief How many meshlets of the last frame's visible objects the player camera could skip. Only updated while
+         * `render.EnableMeshletCulling` is on
+         */
+        [[nodiscard]] const MeshletCullingStats& get_meshlet_culling_stats() const;
+
+        /*!
+         * \brief Gets the model matrix buffer of a frame. It's created the first time the frame updates its model matrices
+         */
+        [[nodiscard]] const BufferHandle& get_model_matrix_buffer(Uint32 frame_idx) const;
+
+        /*!
+         * \brief Gets the index of the entity's world matrix in the model matrix buffer, or ModelMatrixStore::NO_SLOT if the entity has no
+         * matrix this frame
+         */
+        [[nodiscard]] Uint32 get_model_matrix_slot(entt::entity entity) const;
+
+        /*!
+         * \brief Gets the index of the matrix to draw the entity's outline with, or ModelMatrixStore::NO_SLOT if the entity has no outline
+         */
+        [[nodiscard]] Uint32 get_outline_model_matrix_slot(entt::entity entity) const;
+
+        [[nodiscard]] const ModelMatrixStats& get_model_matrix_stats() const;
+
+        [[nodiscard]] const BindlessDescriptorStats& get_bindless_descriptor_stats() const;
+
+        /*!
+         * \brief Gets the render graph that the last `execute_render_graph` recorded
+         */
+        [[nodiscard]] const CompiledRenderGraph& get_render_graph() const;
+
+    private:
+        FrameBackend* backend;
+
+        Uint32 max_num_model_matrices;
+
+        Uint64 transient_texture_alignment;
+
+        TransformHierarchy transform_hierarchy;
+
+        FrustumCuller frustum_culler;
+
+        /*!
+         * \brief The entity for each object in `frustum_culler`
+         */
+        Rx::Vector<entt::entity> culled_entities;
+
+        WorldBoundsCache world_bounds_cache;
+
+        Rx::Vector<entt::entity> visible_objects;
+
+        Rx::Vector<Uint32> visible_object_lods;
+
+        MeshletCuller meshlet_culler;
+
+        Rx::Vector<BufferHandle> model_matrix_buffers;
+
+        ModelMatrixStore model_matrix_store;
+
+        BindlessDescriptorTracker bindless_descriptor_tracker;
+
+        /*!
+         * \brief Indices of the buffers whose descriptors must be written
+         */
+        Rx::Vector<Uint32> pending_buffer_descriptors;
+
+        /*!
+         * \brief Indices of the textures whose descriptors must be written
+         */
+        Rx::Vector<Uint32> pending_texture_descriptors;
+
+        BindlessDescriptorStats bindless_descriptor_stats;
+
+        RenderGraphCompiler render_graph_compiler;
+
+        CompiledRenderGraph empty_render_graph;
+
+        const CompiledRenderGraph* render_graph{&empty_render_graph};
+
+        /*!
+         * \brief Transient textures which get their memory from the transient texture heap
+         */
+        Rx::Vector<TextureHandle> transient_textures;
+
+        /*!
+         * \brief Size and lifetime of each transient texture, as of the last time we packed them into the transient texture heap.
+         * Lifetimes are positions in the compiled render graph
+         */
+        Rx::Vector<TransientResourceRequest> transient_texture_requests;
+
+        TransientHeapLayout transient_heap_layout;
+
+        /*!
+         * \brief Map from the index of a transient texture which shares memory with another transient texture to its index in
+         * `transient_textures`. These textures must be activated before their first use each frame
+         */
+        Rx::Map<Uint32, Uint32> aliased_transient_texture_indices;
+
+        /*!
+         * \brief Number of render graph compiles when we last packed the transient textures
+         */
+        Uint32 transient_heap_num_compiles{0};
+
+        /*!
+         * \brief Whether a transient texture was added or removed since we last packed the transient textures
+         */
+        bool are_transient_textures_changed{false};
+
+        /*!
+         * \brief Culls the meshlets of the visible objects that are drawn with their full mesh, for the meshlet culling stats
+         */
+        void cull_visible_meshlets(const entt::registry& registry,
+                                   const glm::mat4& view_projection_matrix,
+                                   const glm::vec3& camera_location);
+
+        /*!
+         * \brief Gets the renderable's bounds, or the bounds of its mesh from the static mesh store if the renderable doesn't have any
+         */
+        [[nodiscard]] Rx::Optional<BoundingBox> get_local_bounds(const StandardRenderableComponent& renderable) const;
+
+        /*!
+         * \brief Picks the least detailed LOD of a mesh whose error covers no more than `render.LodPixelError` pixels on screen
+         *
+         * \param pixels_per_unit How many pixels tall something one unit tall and one unit away from the camera is
+         */
+        [[nodiscard]] static Uint32 select_mesh_lod(const Mesh& mesh,
+                                                    const Rx::Optional<BoundingBox>& local_bounds,
+                                                    const glm::mat4& model_matrix,
+                                                    const glm::vec3& camera_location,
+                                                    Float32 pixels_per_unit);
+
+        /*!
+         * \brief Re-packs the transient textures into the transient texture heap, if the new render graph changed their lifetimes
+         */
+        void update_transient_texture_memory(const Rx::Vector<RenderGraphPassDescription>& passes);
+
+        /*!
+         * \brief Records the barriers before a pass, the activation of the transient textures it's the first to use, the pass itself, and
+         * the final barriers if it's the last pass
+         *
+         * \param position Position of the pass in the compiled render graph
+         */
+        void record_pass(const Rx::Vector<RenderGraphPassDescription>& passes, Uint32 command_list_idx, Uint32 position);
+    };
+} // namespace sanity::engine::renderer
@@ -0,0 +1,180 @@
+#include "frustum_culler.hpp"
+
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+#include "Tracy.hpp"
+
+namespace sanity::engine::renderer {
+#ifdef __AVX2__
+    constexpr Uint32 CULLING_BATCH_SIZE = 8;
+#else
+    constexpr Uint32 CULLING_BATCH_SIZE = 4;
+#endif
+
+    VisibleObjectCullingInformation get_culling_information(const Rx::Optional<BoundingBox>& local_bounds, const glm::mat4& model_matrix) {
+        if(!local_bounds) {
+            return {.aabb_x_min_max = {-FLT_MAX, FLT_MAX}, .aabb_y_min_max = {-FLT_MAX, FLT_MAX}, .aabb_z_min_max = {-FLT_MAX, FLT_MAX}};
+        }
+
+        // Transform the box's center, and grow its extents by the absolute value of the model matrix's rotation and scale, so the
+        // world-space box encloses the transformed local-space box
+        const auto& bounds = *local_bounds;
+        const auto local_center = glm::vec4{(bounds.x_min + bounds.x_max) * 0.5f,
+                                            (bounds.y_min + bounds.y_max) * 0.5f,
+                                            (bounds.z_min + bounds.z_max) * 0.5f,
+                                            1.0f};
+        const auto local_extents = glm::vec3{(bounds.x_max - bounds.x_min) * 0.5f,
+                                             (bounds.y_max - bounds.y_min) * 0.5f,
+                                             (bounds.z_max - bounds.z_min) * 0.5f};
+
+        const auto center = model_matrix * local_center;
+
+        glm::vec3 extents{0};
+        for(Uint32 column = 0; column < 3; column++) {
+            for(Uint32 row = 0; row < 3; row++) {
+                extents[row] += std::abs(model_matrix[column][row]) * local_extents[column];
+            }
+        }
+
+        return {.aabb_x_min_max = {center.x - extents.x, center.x + extents.x},
+                .aabb_y_min_max = {center.y - extents.y, center.y + extents.y},
+                .aabb_z_min_max = {center.z - extents.z, center.z + extents.z}};
+    }
+
+    void FrustumCuller::clear() {
+        num_objects = 0;
+
+        x_min.clear();
+        x_max.clear();
+        y_min.clear();
+        y_max.clear();
+        z_min.clear();
+        z_max.clear();
+
+        visible_objects.clear();
+    }
+
+    Uint32 FrustumCuller::add_object(const VisibleObjectCullingInformation& object) {
+        remove_padding();
+
+        x_min.push_back(object.aabb_x_min_max.x);
+        x_max.push_back(object.aabb_x_min_max.y);
+        y_min.push_back(object.aabb_y_min_max.x);
+        y_max.push_back(object.aabb_y_min_max.y);
+        z_min.push_back(object.aabb_z_min_max.x);
+        z_max.push_back(object.aabb_z_min_max.y);
+
+        const auto object_idx = num_objects;
+        num_objects++;
+
+        return object_idx;
+    }
+
+    void FrustumCuller::cull(const glm::mat4& view_projection_matrix) {
+        ZoneScoped;
+
+        visible_objects.clear();
+        visible_objects.reserve(num_objects);
+
+        pad_to_batch_size(CULLING_BATCH_SIZE);
+
+        // Extract the side planes of the frustum from the rows of the view-projection matrix. A point is inside a plane when
+        // dot(plane, point) >= 0
+        const auto row = [&](const Uint32 idx) {
+            return glm::vec4{view_projection_matrix[0][idx],
+                             view_projection_matrix[1][idx],
+                             view_projection_matrix[2][idx],
+                             view_projection_matrix[3][idx]};
+        };
+        const glm::vec4 planes[] = {row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1)};
+
+        // For each plane, the corner of a box that's furthest along the plane's normal decides whether the box is at least partially
+        // inside the plane. The plane's normal is the same for every box, so we can pick the array to read that corner from up front
+        struct PlaneTest {
+            const Float32* x;
+            const Float32* y;
+            const Float32* z;
+            glm::vec4 plane;
+        };
+
+        PlaneTest plane_tests[4];
+        for(Uint32 i = 0; i < 4; i++) {
+            const auto& plane = planes[i];
+            plane_tests[i] = PlaneTest{.x = plane.x > 0 ? x_max.data() : x_min.data(),
+                                       .y = plane.y > 0 ? y_max.data() : y_min.data(),
+                                       .z = plane.z > 0 ? z_max.data() : z_min.data(),
+                                       .plane = plane};
+        }
+
+        for(Uint32 batch_start = 0; batch_start < num_objects; batch_start += CULLING_BATCH_SIZE) {
+#ifdef __AVX2__
+            auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(const auto& test : plane_tests) {
+                const auto x_distance = _mm256_mul_ps(_mm256_loadu_ps(test.x + batch_start), _mm256_set1_ps(test.plane.x));
+                const auto y_distance = _mm256_mul_ps(_mm256_loadu_ps(test.y + batch_start), _mm256_set1_ps(test.plane.y));
+                const auto z_distance = _mm256_mul_ps(_mm256_loadu_ps(test.z + batch_start), _mm256_set1_ps(test.plane.z));
+                const auto distance = _mm256_add_ps(_mm256_add_ps(x_distance, y_distance),
+                                                    _mm256_add_ps(z_distance, _mm256_set1_ps(test.plane.w)));
+
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            auto visible_mask = static_cast<Uint32>(_mm256_movemask_ps(inside));
+#else
+            auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(const auto& test : plane_tests) {
+                const auto x_distance = _mm_mul_ps(_mm_loadu_ps(test.x + batch_start), _mm_set1_ps(test.plane.x));
+                const auto y_distance = _mm_mul_ps(_mm_loadu_ps(test.y + batch_start), _mm_set1_ps(test.plane.y));
+                const auto z_distance = _mm_mul_ps(_mm_loadu_ps(test.z + batch_start), _mm_set1_ps(test.plane.z));
+                const auto distance = _mm_add_ps(_mm_add_ps(x_distance, y_distance), _mm_add_ps(z_distance, _mm_set1_ps(test.plane.w)));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+            }
+
+            auto visible_mask = static_cast<Uint32>(_mm_movemask_ps(inside));
+#endif
+
+            // Ignore the padding at the end of the arrays
+            const auto num_objects_in_batch = num_objects - batch_start;
+            if(num_objects_in_batch < CULLING_BATCH_SIZE) {
+                visible_mask &= (1u << num_objects_in_batch) - 1;
+            }
+
+            while(visible_mask != 0) {
+                visible_objects.push_back(batch_start + static_cast<Uint32>(std::countr_zero(visible_mask)));
+                visible_mask &= visible_mask - 1;
+            }
+        }
+    }
+
+    const Rx::Vector<Uint32>& FrustumCuller::get_visible_objects() const { return visible_objects; }
+
+    Uint32 FrustumCuller::get_num_objects() const { return num_objects; }
+
+    void FrustumCuller::pad_to_batch_size(const Uint32 batch_size) {
+        const auto padded_size = (num_objects + batch_size - 1) / batch_size * batch_size;
+
+        x_min.resize(padded_size, 0.0f);
+        x_max.resize(padded_size, 0.0f);
+        y_min.resize(padded_size, 0.0f);
+        y_max.resize(padded_size, 0.0f);
+        z_min.resize(padded_size, 0.0f);
+        z_max.resize(padded_size, 0.0f);
+    }
+
+    void FrustumCuller::remove_padding() {
+        if(x_min.size() == num_objects) {
+            return;
+        }
+
+        x_min.resize(num_objects);
+        x_max.resize(num_objects);
+        y_min.resize(num_objects);
+        y_max.resize(num_objects);
+        z_min.resize(num_objects);
+        z_max.resize(num_objects);
+    }
+} // namespace sanity::engine::renderer
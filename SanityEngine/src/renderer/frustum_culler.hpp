@@ -0,0 +1,106 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "glm/mat4x4.hpp"
+#include "renderer/mesh.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief All the information needed to decide whether or not to issue a drawcall for an object
+     */
+    struct VisibleObjectCullingInformation {
+        /*!
+         * \brief Min and max of this object's world-space bounding box, along the x axis
+         */
+        Vec2f aabb_x_min_max{};
+
+        /*!
+         * \brief Min and max of this object's world-space bounding box, along the y axis
+         */
+        Vec2f aabb_y_min_max{};
+
+        /*!
+         * \brief Min and max of this object's world-space bounding box, along the z axis
+         */
+        Vec2f aabb_z_min_max{};
+    };
+
+    /*!
+     * \brief Gets the culling information for an object with the given local-space bounds and model matrix
+     *
+     * \param local_bounds The object's bounds in its own space, or an empty optional if the object has no bounds. Objects without bounds
+     * are never culled
+     */
+    [[nodiscard]] VisibleObjectCullingInformation get_culling_information(const Rx::Optional<BoundingBox>& local_bounds,
+                                                                          const glm::mat4& model_matrix);
+
+    /*!
+     * \brief Tests a lot of bounding boxes against a camera frustum at once
+     *
+     * Objects are stored as structures of arrays so that we can test a batch of objects per SIMD instruction - eight at a time with AVX2,
+     * four at a time with SSE
+     */
+    class FrustumCuller {
+    public:
+        FrustumCuller() = default;
+
+        FrustumCuller(const FrustumCuller& other) = delete;
+        FrustumCuller& operator=(const FrustumCuller& other) = delete;
+
+        FrustumCuller(FrustumCuller&& old) noexcept = default;
+        FrustumCuller& operator=(FrustumCuller&& old) noexcept = default;
+
+        ~FrustumCuller() = default;
+
+        /*!
+         * \brief Removes all objects from the culler, but keeps its memory around for the next frame
+         */
+        void clear();
+
+        /*!
+         * \brief Adds an object to the culler
+         *
+         * \return The index of the new object. This index is what `get_visible_objects` refers to
+         */
+        Uint32 add_object(const VisibleObjectCullingInformation& object);
+
+        /*!
+         * \brief Tests all objects against the frustum of the provided view-projection matrix
+         *
+         * Only the side planes of the frustum are tested. Our projection matrices have an infinite far plane, and the near plane is so
+         * close to the camera that it culls next to nothing
+         */
+        void cull(const glm::mat4& view_projection_matrix);
+
+        /*!
+         * \brief Indices of the objects which passed the last call to `cull`, in increasing order
+         */
+        [[nodiscard]] const Rx::Vector<Uint32>& get_visible_objects() const;
+
+        [[nodiscard]] Uint32 get_num_objects() const;
+
+    private:
+        Uint32 num_objects{0};
+
+        Rx::Vector<Float32> x_min;
+        Rx::Vector<Float32> x_max;
+        Rx::Vector<Float32> y_min;
+        Rx::Vector<Float32> y_max;
+        Rx::Vector<Float32> z_min;
+        Rx::Vector<Float32> z_max;
+
+        Rx::Vector<Uint32> visible_objects;
+
+        /*!
+         * \brief Pads the object arrays with empty objects, so that a full SIMD batch can always be loaded
+         */
+        void pad_to_batch_size(Uint32 batch_size);
+
+        /*!
+         * \brief Resizes the object arrays to hold exactly `num_objects` objects, removing any padding
+         */
+        void remove_padding();
+    };
+} // namespace sanity::engine::renderer
@@ -0,0 +1,201 @@
+#include "headless_renderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Tracy.hpp"
+#include "core/components.hpp"
+#include "core/constants.hpp"
+#include "entt/entity/registry.hpp"
+#include "renderer/render_components.hpp"
+#include "rx/core/utility/move.h"
+
+namespace sanity::engine::renderer {
+    static Float64 milliseconds_since(const std::chrono::high_resolution_clock::time_point start) {
+        const auto duration = std::chrono::high_resolution_clock::now() - start;
+        return static_cast<Float64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000000.0;
+    }
+
+    // 64 KB, like D3D12 tiles
+    constexpr Uint64 TRANSIENT_TEXTURE_ALIGNMENT = 65536;
+
+    HeadlessRenderer::HeadlessRenderer(const Uint32 num_gpu_frames)
+        : backend{num_gpu_frames},
+          frame_stages{FrameStagesCreateInfo{.max_num_model_matrices = MAX_NUM_MODEL_MATRICES,
+                                             .num_resource_descriptors = MAX_NUM_BUFFERS + MAX_NUM_TEXTURES + MAX_NUM_TEXTURES,
+                                             .write_resource_states = static_cast<Uint32>(HeadlessResourceState::Write),
+                                             .transient_texture_alignment = TRANSIENT_TEXTURE_ALIGNMENT},
+                       backend} {}
+
+    TextureHandle HeadlessRenderer::create_texture(const Rx::String& name, const Uint64 size, const bool is_transient) {
+        const auto texture = backend.create_texture(name, size);
+        RX_ASSERT(texture.index < MAX_NUM_TEXTURES, "Can not create more than %u textures", MAX_NUM_TEXTURES);
+
+        frame_stages.queue_texture_descriptors(texture.index);
+        if(is_transient) {
+            frame_stages.add_transient_texture(texture);
+        }
+
+        return texture;
+    }
+
+    BufferHandle HeadlessRenderer::create_buffer(const Rx::String& name, const Uint64 size) {
+        const auto buffer = backend.create_buffer(name, size);
+        RX_ASSERT(buffer.index < MAX_NUM_BUFFERS, "Can not create more than %u buffers", MAX_NUM_BUFFERS);
+
+        frame_stages.queue_buffer_descriptor(buffer.index);
+
+        return buffer;
+    }
+
+    Uint32 HeadlessRenderer::add_render_pass(const Rx::Vector<TextureHandle>& read_textures,
+                                             const Rx::Vector<TextureHandle>& written_textures,
+                                             const bool has_side_effects) {
+        auto description = RenderGraphPassDescription{.has_side_effects = has_side_effects};
+
+        constexpr auto READ_STATE = static_cast<Uint32>(HeadlessResourceState::Read);
+        constexpr auto WRITE_STATE = static_cast<Uint32>(HeadlessResourceState::Write);
+        read_textures.each_fwd([&](const TextureHandle& texture) {
+            description.resource_usages.push_back(
+                RenderGraphResourceUsage{.resource = texture.index, .begin_state = READ_STATE, .end_state = READ_STATE});
+        });
+        written_textures.each_fwd([&](const TextureHandle& texture) {
+            description.resource_usages.push_back(
+                RenderGraphResourceUsage{.resource = texture.index, .begin_state = WRITE_STATE, .end_state = WRITE_STATE});
+        });
+
+        const auto pass_idx = static_cast<Uint32>(render_graph_passes.size());
+        render_graph_passes.push_back(Rx::Utility::move(description));
+
+        return pass_idx;
+    }
+
+    Mesh HeadlessRenderer::add_mesh(const BoundingBox& bounds, const Rx::Vector<MeshletBounds>& meshlet_bounds) {
+        return backend.add_mesh(bounds, meshlet_bounds);
+    }
+
+    void HeadlessRenderer::render_frame(entt::registry& registry,
+                                        const glm::mat4& view_matrix,
+                                        const glm::mat4& projection_matrix,
+                                        const Uint32 output_height,
+                                        ThreadPool* thread_pool) {
+        ZoneScoped;
+
+        const auto frame_start = std::chrono::high_resolution_clock::now();
+        const auto num_bytes_uploaded_before = backend.get_trace().get_total_amount(RenderTraceOp::Upload);
+
+        backend.begin_frame(frame_count);
+        const auto frame_idx = backend.get_cur_gpu_frame_idx();
+
+        last_frame_stats = {};
+
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            frame_stages.update_transforms(registry, thread_pool);
+            last_frame_stats.num_updated_transforms = frame_stages.get_transform_hierarchy().get_num_updated_nodes();
+            last_frame_stats.transform_update_ms = milliseconds_since(start);
+        }
+
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            frame_stages.cull_scene(registry, view_matrix, projection_matrix, output_height);
+            last_frame_stats.culling_ms = milliseconds_since(start);
+
+            last_frame_stats.num_objects = frame_stages.get_num_culled_objects();
+            last_frame_stats.num_visible_objects = static_cast<Uint32>(frame_stages.get_visible_objects().size());
+            last_frame_stats.num_updated_world_bounds = frame_stages.get_num_updated_world_bounds();
+            last_frame_stats.meshlet_stats = frame_stages.get_meshlet_culling_stats();
+        }
+
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            frame_stages.update_model_matrices(registry, frame_idx);
+            frame_stages.update_resource_array_descriptors(frame_idx);
+            last_frame_stats.upload_ms = milliseconds_since(start);
+
+            last_frame_stats.model_matrix_stats = frame_stages.get_model_matrix_stats();
+            last_frame_stats.descriptor_stats = frame_stages.get_bindless_descriptor_stats();
+        }
+
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            frame_stages.execute_render_graph(render_graph_passes, thread_pool);
+            last_frame_stats.render_graph_ms = milliseconds_since(start);
+
+            const auto& render_graph = frame_stages.get_render_graph();
+            last_frame_stats.num_executed_passes = static_cast<Uint32>(render_graph.pass_order.size());
+            last_frame_stats.num_barriers = render_graph.num_barriers;
+        }
+
+        backend.end_frame();
+        frame_count++;
+
+        last_frame_stats.num_bytes_uploaded = backend.get_trace().get_total_amount(RenderTraceOp::Upload) - num_bytes_uploaded_before;
+        last_frame_stats.total_ms = milliseconds_since(frame_start);
+    }
+
+    const HeadlessFrameStats& HeadlessRenderer::get_last_frame_stats() const { return last_frame_stats; }
+
+    const FrameStages& HeadlessRenderer::get_frame_stages() const { return frame_stages; }
+
+    NullRenderBackend& HeadlessRenderer::get_backend() { return backend; }
+
+    Rx::Vector<entt::entity> create_synthetic_scene(entt::registry& registry, const SyntheticSceneCreateInfo& create_info) {
+        ZoneScoped;
+
+        // xorshift32, so the scene doesn't depend on the standard library's random engines
+        auto state = create_info.seed != 0 ? create_info.seed : 1;
+        const auto next_float = [&] {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return static_cast<Float32>(state) / static_cast<Float32>(UINT32_MAX);
+        };
+
+        Rx::Vector<entt::entity> entities;
+        entities.reserve(create_info.num_objects);
+
+        const auto num_levels = create_info.hierarchy_depth > 0 ? create_info.hierarchy_depth : 1;
+        const auto objects_per_level = (create_info.num_objects + num_levels - 1) / num_levels;
+
+        Uint32 prev_level_start = 0;
+        Uint32 prev_level_end = 0;
+        for(auto level = 0u; level < num_levels && entities.size() < create_info.num_objects; level++) {
+            const auto level_start = static_cast<Uint32>(entities.size());
+            const auto level_end = std::min(level_start + objects_per_level, create_info.num_objects);
+
+            for(auto i = level_start; i < level_end; i++) {
+                const auto entity = registry.create();
+
+                auto& transform = registry.emplace<TransformComponent>(entity);
+                if(level == 0) {
+                    // Roots are spread over the whole scene. Children sit close to their parent
+                    transform->location = (glm::vec3{next_float(), next_float(), next_float()} - 0.5f) * create_info.scene_size;
+
+                } else {
+                    transform->location = (glm::vec3{next_float(), next_float(), next_float()} - 0.5f) * 10.0f;
+
+                    const auto parent_offset = static_cast<Uint32>(next_float() * static_cast<Float32>(prev_level_end - prev_level_start));
+                    const auto parent = entities[std::min(prev_level_start + parent_offset, prev_level_end - 1)];
+                    transform.parent = parent;
+                    registry.get<TransformComponent>(parent).children.push_back(entity);
+                }
+
+                auto& renderable = registry.emplace<StandardRenderableComponent>(entity);
+                if(create_info.meshes.is_empty()) {
+                    renderable.bounds = BoundingBox{.x_min = -1, .x_max = 1, .y_min = -1, .y_max = 1, .z_min = -1, .z_max = 1};
+
+                } else {
+                    renderable.mesh = create_info.meshes[i % create_info.meshes.size()];
+                }
+
+                entities.push_back(entity);
+            }
+
+            prev_level_start = level_start;
+            prev_level_end = level_end;
+        }
+
+        return entities;
+    }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "entt/entity/fwd.hpp"
+#include "glm/mat4x4.hpp"
+#include "renderer/frame_stages.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "renderer/mesh.hpp"
+#include "renderer/render_graph.hpp"
+#include "renderer/rhi/null_render_backend.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine {
+    class ThreadPool;
+}
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief Resource states for headless render passes. The render graph only cares about which states allow writes
+     */
+    enum class HeadlessResourceState : Uint32 {
+        Read = 0x1,
+        Write = 0x2,
+    };
+
+    struct HeadlessFrameStats {
+        Uint32 num_objects{0};
+
+        Uint32 num_visible_objects{0};
+
+        /*!
+         * \brief Number of objects whose world-space bounds were recomputed, because they moved or their bounds changed
+         */
+        Uint32 num_updated_world_bounds{0};
+
+        /*!
+         * \brief Only filled in while `render.EnableMeshletCulling` is on
+         */
+        MeshletCullingStats meshlet_stats;
+
+        Uint32 num_updated_transforms{0};
+
+        Uint32 num_executed_passes{0};
+
+        Uint32 num_barriers{0};
+
+        Uint64 num_bytes_uploaded{0};
+
+        ModelMatrixStats model_matrix_stats;
+
+        BindlessDescriptorStats descriptor_stats;
+
+        Float64 transform_update_ms{0};
+
+        Float64 culling_ms{0};
+
+        Float64 upload_ms{0};
+
+        Float64 render_graph_ms{0};
+
+        Float64 total_ms{0};
+    };
+
+    /*!
+     * \brief Runs Renderer's frame stages against a NullRenderBackend, so they can be measured without a D3D12 device
+     *
+     * Each frame runs the same FrameStages that `Renderer::render_frame` does, in the same order, over the registry's
+     * StandardRenderableComponents. Render passes are plain descriptions of the resources they read and write, and executing one only
+     * records it in the backend's trace
+     */
+    class HeadlessRenderer {
+    public:
+        explicit HeadlessRenderer(Uint32 num_gpu_frames = 3);
+
+        HeadlessRenderer(const HeadlessRenderer& other) = delete;
+        HeadlessRenderer& operator=(const HeadlessRenderer& other) = delete;
+
+        HeadlessRenderer(HeadlessRenderer&& old) noexcept = delete;
+        HeadlessRenderer& operator=(HeadlessRenderer&& old) noexcept = delete;
+
+        ~HeadlessRenderer() = default;
+
+        /*!
+         * \param size Number of bytes the texture would take in GPU memory
+         * \param is_transient Whether the texture gets its memory from the transient texture heap
+         */
+        [[nodiscard]] TextureHandle create_texture(const Rx::String& name, Uint64 size, bool is_transient = false);
+
+        [[nodiscard]] BufferHandle create_buffer(const Rx::String& name, Uint64 size);
+
+        /*!
+         * \brief Adds a render pass which reads and writes the provided textures. Passes execute in the order they're added, unless the
+         * render graph reorders or culls them
+         *
+         * \return The index of the new pass
+         */
+        Uint32 add_render_pass(const Rx::Vector<TextureHandle>& read_textures,
+                               const Rx::Vector<TextureHandle>& written_textures,
+                               bool has_side_effects);
+
+        /*!
+         * \brief Adds a mesh for StandardRenderableComponents to draw. The mesh only has bounds, which renderables without bounds of their
+         * own are culled with, and optionally meshlets
+         */
+        [[nodiscard]] Mesh add_mesh(const BoundingBox& bounds, const Rx::Vector<MeshletBounds>& meshlet_bounds = {});
+
+        /*!
+         * \param output_height Height of the image the camera renders to, in pixels. Used to pick the LOD of each visible object
+         * \param thread_pool If provided, the transform hierarchy updates and the passes record on the thread pool, like they do in
+         * Renderer
+         */
+        void render_frame(entt::registry& registry,
+                          const glm::mat4& view_matrix,
+                          const glm::mat4& projection_matrix,
+                          Uint32 output_height = 1080,
+                          ThreadPool* thread_pool = nullptr);
+
+        [[nodiscard]] const HeadlessFrameStats& get_last_frame_stats() const;
+
+        [[nodiscard]] const FrameStages& get_frame_stages() const;
+
+        [[nodiscard]] NullRenderBackend& get_backend();
+
+    private:
+        static constexpr Uint32 MAX_NUM_MODEL_MATRICES = 1 << 20;
+
+        NullRenderBackend backend;
+
+        FrameStages frame_stages;
+
+        Uint64 frame_count{0};
+
+        Rx::Vector<RenderGraphPassDescription> render_graph_passes;
+
+        HeadlessFrameStats last_frame_stats;
+    };
+
+    struct SyntheticSceneCreateInfo {
+        Uint32 num_objects{10000};
+
+        /*!
+         * \brief Objects are spread over a cube of this size, centered at the origin
+         */
+        Float32 scene_size{1000};
+
+        /*!
+         * \brief Number of levels of the transform hierarchy. Objects in every level but the first are parented to an object in the level
+         * above
+         */
+        Uint32 hierarchy_depth{3};
+
+        /*!
+         * \brief Meshes for the objects to draw, handed out in order. If this is empty, every object gets a unit cube as its bounds instead
+         */
+        Rx::Vector<Mesh> meshes;
+
+        Uint32 seed{1};
+    };
+
+    /*!
+     * \brief Fills a registry with objects that have a TransformComponent and a StandardRenderableComponent
+     *
+     * The scene is the same for the same create info, so benchmark runs can be compared
+     *
+     * \return All the new entities, in the order they were created
+     */
+    Rx::Vector<entt::entity> create_synthetic_scene(entt::registry& registry, const SyntheticSceneCreateInfo& create_info);
+} // namespace sanity::engine::renderer
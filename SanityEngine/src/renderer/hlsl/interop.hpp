@@ -35,6 +35,11 @@ static_assert(sizeof(sanity::engine::renderer::BufferHandle) == sizeof(uint));
 #define COLOR_SEMANTIC
 #define TEXCOORD_SEMANTIC
 
+#define PACKED_LOCATION_XY_SEMANTIC
+#define PACKED_LOCATION_Z_NORMAL_SEMANTIC
+#define PACKED_COLOR_SEMANTIC
+#define PACKED_TEXCOORD_SEMANTIC
+
 #else
 
 #define byte4 float4
@@ -44,6 +49,11 @@ static_assert(sizeof(sanity::engine::renderer::BufferHandle) == sizeof(uint));
 #define COLOR_SEMANTIC : Color;
 #define TEXCOORD_SEMANTIC : Texcoord;
 
+#define PACKED_LOCATION_XY_SEMANTIC : LocationXy;
+#define PACKED_LOCATION_Z_NORMAL_SEMANTIC : LocationZNormal;
+#define PACKED_COLOR_SEMANTIC : Color;
+#define PACKED_TEXCOORD_SEMANTIC : Texcoord;
+
 
 
 
@@ -3,6 +3,10 @@
 
 #include "interop.hpp"
 
+#if __cplusplus
+#include "glm/gtc/packing.hpp"
+#endif
+
 #if __cplusplus
 namespace sanity::engine::renderer {
 #endif
@@ -14,9 +18,206 @@ namespace sanity::engine::renderer {
         float2 texcoord TEXCOORD_SEMANTIC;
     };
 
+    /*!
+     * \brief Compact form of a StandardVertex, for meshes that can afford to lose some precision
+     *
+     * The location is quantized to 16-bit unsigned normalized values relative to the mesh's bounds, so it needs the mesh's
+     * MeshDequantization to decode. The normal is octahedral encoded into two 8-bit signed normalized values, and the texcoord is two
+     * half floats
+     */
+    struct PackedVertex {
+        /*!
+         * \brief Quantized x in the low 16 bits, quantized y in the high 16 bits
+         */
+        uint location_xy PACKED_LOCATION_XY_SEMANTIC;
+
+        /*!
+         * \brief Quantized z in the low 16 bits, then the octahedral x and y of the normal in one byte each
+         */
+        uint location_z_normal PACKED_LOCATION_Z_NORMAL_SEMANTIC;
+
+        /*!
+         * \brief Same as StandardVertex::color
+         */
+        uint color PACKED_COLOR_SEMANTIC;
+
+        /*!
+         * \brief Texcoord u in the low 16 bits, v in the high 16 bits
+         */
+        uint texcoord PACKED_TEXCOORD_SEMANTIC;
+    };
+
+    /*!
+     * \brief How to turn the quantized locations of a mesh's PackedVertices back into locations in the mesh's space
+     *
+     * location = offset + quantized_location * scale
+     */
+    struct MeshDequantization {
+        float3 location_offset;
+
+        float3 location_scale;
+    };
+
+    /*!
+     * \brief A small cluster of a mesh's triangles, which can be culled on its own
+     *
+     * A meshlet has its own list of the mesh's vertices, and its triangles index into that list, so that each vertex is transformed once
+     * per meshlet
+     */
+    struct Meshlet {
+        /*!
+         * \brief Offset of the meshlet's first vertex in the mesh's meshlet vertices. Each meshlet vertex is an index of one of the mesh's
+         * vertices
+         */
+        uint vertex_offset;
+
+        /*!
+         * \brief Offset of the meshlet's first triangle in the mesh's meshlet triangles, in triangles. Each meshlet triangle is three
+         * bytes, which are indices into the meshlet's vertices
+         */
+        uint triangle_offset;
+
+        uint num_vertices;
+
+        uint num_triangles;
+    };
+
+    /*!
+     * \brief Bounds of a meshlet, in the mesh's space
+     *
+     * The normal cone encloses the normals of all the meshlet's triangles. The meshlet faces away from a camera at `camera_location` when
+     * dot(normalize(cone_apex - camera_location), cone_axis) >= cone_cutoff. A meshlet whose normals point every which way has a cutoff
+     * of 1, which never culls it
+     */
+    struct MeshletBounds {
+        float3 center;
+        float radius;
+
+        float3 cone_apex;
+        float cone_cutoff;
+
+        float3 cone_axis;
+    };
+
 #if __cplusplus
     static_assert(sizeof(StandardVertex) == 8 * sizeof(float) + sizeof(Uint32));
     static_assert(alignof(StandardVertex) == 4);
+
+    static_assert(sizeof(PackedVertex) == 4 * sizeof(Uint32));
+    static_assert(sizeof(MeshDequantization) == 6 * sizeof(float));
+
+    static_assert(sizeof(Meshlet) == 4 * sizeof(Uint32));
+    static_assert(sizeof(MeshletBounds) == 11 * sizeof(float));
+
+    /*!
+     * \brief The usual meshlet limits for mesh shaders. 124 triangles rather than 128 keeps a meshlet's triangle indices and counts within
+     * three 128-byte blocks
+     */
+    constexpr Uint32 MAX_MESHLET_VERTICES = 64;
+    constexpr Uint32 MAX_MESHLET_TRIANGLES = 124;
+
+    constexpr Uint32 MAX_QUANTIZED_LOCATION = 0xFFFF;
+
+    constexpr Int32 MAX_OCTAHEDRAL_NORMAL = 127;
+
+    /*!
+     * \brief Makes the dequantization for a mesh whose locations are all between `min` and `max`
+     */
+    inline MeshDequantization make_mesh_dequantization(const glm::vec3& min, const glm::vec3& max) {
+        return MeshDequantization{.location_offset = min, .location_scale = (max - min) / static_cast<float>(MAX_QUANTIZED_LOCATION)};
+    }
+
+    /*!
+     * \brief Decodes an octahedral encoded normal, where each component of `encoded` is in [-1, 1]
+     */
+    inline glm::vec3 decode_octahedral(const glm::vec2& encoded) {
+        auto normal = glm::vec3{encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y)};
+        const auto fold = glm::clamp(-normal.z, 0.0f, 1.0f);
+        normal.x += normal.x >= 0.0f ? -fold : fold;
+        normal.y += normal.y >= 0.0f ? -fold : fold;
+
+        return glm::normalize(normal);
+    }
+
+    /*!
+     * \brief Decodes an octahedral normal from two signed normalized bytes, x in the low byte
+     */
+    inline glm::vec3 decode_octahedral(const Uint32 encoded) {
+        const auto x = static_cast<Int8>(encoded & 0xFF);
+        const auto y = static_cast<Int8>((encoded >> 8) & 0xFF);
+        return decode_octahedral(glm::max(glm::vec2{x, y} / static_cast<float>(MAX_OCTAHEDRAL_NORMAL), glm::vec2{-1.0f}));
+    }
+
+    /*!
+     * \brief Octahedral encodes a unit length normal into two signed normalized bytes, x in the low byte
+     *
+     * Rounding each component to the nearest byte isn't always the closest encoding, so this tries all the encodings around the exact
+     * one and keeps the one which decodes closest to `normal`
+     */
+    inline Uint32 encode_octahedral(const glm::vec3& normal) {
+        const auto length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+        if(length <= 0.0f) {
+            return 0;
+        }
+
+        auto encoded = glm::vec2{normal.x, normal.y} / length;
+        if(normal.z < 0.0f) {
+            encoded = glm::vec2{(1.0f - glm::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+                                (1.0f - glm::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f)};
+        }
+
+        const auto scaled = glm::clamp(encoded, glm::vec2{-1.0f}, glm::vec2{1.0f}) * static_cast<float>(MAX_OCTAHEDRAL_NORMAL);
+        const auto base = glm::floor(scaled);
+
+        Uint32 best_encoding = 0;
+        auto best_similarity = -2.0f;
+        for(Uint32 i = 0; i < 4; i++) {
+            const auto x = glm::min(static_cast<Int32>(base.x) + static_cast<Int32>(i & 1), MAX_OCTAHEDRAL_NORMAL);
+            const auto y = glm::min(static_cast<Int32>(base.y) + static_cast<Int32>(i >> 1), MAX_OCTAHEDRAL_NORMAL);
+            const auto candidate = (static_cast<Uint32>(x) & 0xFF) | ((static_cast<Uint32>(y) & 0xFF) << 8);
+
+            const auto similarity = glm::dot(decode_octahedral(candidate), normal);
+            if(similarity > best_similarity) {
+                best_similarity = similarity;
+                best_encoding = candidate;
+            }
+        }
+
+        return best_encoding;
+    }
+
+    /*!
+     * \brief Packs a vertex of a mesh. The vertex's location must be inside the bounds that `dequantization` was made from
+     */
+    inline PackedVertex pack_vertex(const StandardVertex& vertex, const MeshDequantization& dequantization) {
+        // Axes where the mesh is flat have a scale of 0, and all their locations quantize to 0
+        const auto& scale = dequantization.location_scale;
+        const auto inverse_scale = glm::vec3{scale.x > 0.0f ? 1.0f / scale.x : 0.0f,
+                                             scale.y > 0.0f ? 1.0f / scale.y : 0.0f,
+                                             scale.z > 0.0f ? 1.0f / scale.z : 0.0f};
+        const auto quantized_location = glm::clamp(glm::round((vertex.location - dequantization.location_offset) * inverse_scale),
+                                                   glm::vec3{0.0f},
+                                                   glm::vec3{static_cast<float>(MAX_QUANTIZED_LOCATION)});
+        const auto location = glm::uvec3{quantized_location};
+
+        return PackedVertex{.location_xy = location.x | (location.y << 16),
+                            .location_z_normal = location.z | (encode_octahedral(vertex.normal) << 16),
+                            .color = vertex.color,
+                            .texcoord = glm::packHalf1x16(vertex.texcoord.x) |
+                                        (static_cast<Uint32>(glm::packHalf1x16(vertex.texcoord.y)) << 16)};
+    }
+
+    inline StandardVertex unpack_vertex(const PackedVertex& vertex, const MeshDequantization& dequantization) {
+        const auto location = glm::vec3{static_cast<float>(vertex.location_xy & 0xFFFF),
+                                        static_cast<float>(vertex.location_xy >> 16),
+                                        static_cast<float>(vertex.location_z_normal & 0xFFFF)};
+
+        return StandardVertex{.location = dequantization.location_offset + location * dequantization.location_scale,
+                              .normal = decode_octahedral(vertex.location_z_normal >> 16),
+                              .color = vertex.color,
+                              .texcoord = {glm::unpackHalf1x16(static_cast<Uint16>(vertex.texcoord & 0xFFFF)),
+                                           glm::unpackHalf1x16(static_cast<Uint16>(vertex.texcoord >> 16))}};
+    }
 }
 #endif
 
@@ -52,6 +253,41 @@ StandardVertex get_vertex(int address) {
     return v;
 }
 
+float3 decode_octahedral(float2 encoded) {
+    float3 normal = float3(encoded.x, encoded.y, 1.0 - abs(encoded.x) - abs(encoded.y));
+    const float fold = saturate(-normal.z);
+    normal.xy += normal.xy >= 0.0 ? -fold : fold;
+
+    return normalize(normal);
+}
+
+/*!
+ * \brief Decodes a PackedVertex the same way as the C++ unpack_vertex
+ */
+StandardVertex unpack_vertex(PackedVertex packed, MeshDequantization dequantization) {
+    const uint3 quantized_location = uint3(packed.location_xy & 0xFFFF, packed.location_xy >> 16, packed.location_z_normal & 0xFFFF);
+
+    // Sign extend the octahedral normal's bytes
+    const int2 octahedral_normal = int2(packed.location_z_normal << 8, packed.location_z_normal) >> 24;
+
+    StandardVertex v;
+    v.location = dequantization.location_offset + float3(quantized_location) * dequantization.location_scale;
+    v.normal = decode_octahedral(max(float2(octahedral_normal) / 127.0, -1.0));
+    v.color = float4(packed.color & 0xFF, (packed.color >> 8) & 0xFF, (packed.color >> 16) & 0xFF, packed.color >> 24) / 255.0;
+    v.texcoord = f16tof32(uint2(packed.texcoord, packed.texcoord >> 16));
+
+    return v;
+}
+
+/*!
+ * \brief Gets the MeshDequantization of the packed mesh that the current draw draws
+ */
+MeshDequantization get_current_mesh_dequantization() {
+    FrameConstants data = get_frame_constants();
+    ByteAddressBuffer dequantizations = srv_buffers[data.mesh_dequantization_buffer_index];
+    return dequantizations.Load<MeshDequantization>(sizeof(MeshDequantization) * constants.mesh_dequantization_index);
+}
+
 StandardVertex get_vertex_attributes(uint triangle_index, float2 barycentrics) {
     uint3 indices = get_indices(triangle_index);
 
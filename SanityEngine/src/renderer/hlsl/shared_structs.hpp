@@ -42,6 +42,11 @@ namespace sanity::engine::renderer {
         uint vertex_data_buffer_index;
         uint index_buffer_index;
 
+        /**
+         * @brief Index of the packed mesh store's buffer of MeshDequantizations
+         */
+        uint mesh_dequantization_buffer_index;
+
         uint noise_texture_idx;
         uint sky_texture_idx;
 
@@ -87,6 +92,11 @@ namespace sanity::engine::renderer {
          * \brief Identifier for the object currently being rendered. Guaranteed to be unique for each object
          */
         uint object_id;
+
+        /*!
+         * \brief Index of the MeshDequantization of the mesh being drawn, if its vertices are PackedVertices
+         */
+        uint mesh_dequantization_index;
     };
 
     /**
@@ -0,0 +1,54 @@
+#include "mesh.hpp"
+
+#include <xmmintrin.h>
+
+#include "Tracy.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+
+namespace sanity::engine::renderer {
+    static_assert(sizeof(StandardVertex) >= offsetof(StandardVertex, location) + sizeof(Float32) * 4,
+                  "compute_mesh_bounds loads four floats from each vertex's location");
+
+    BoundingBox compute_mesh_bounds(const StandardVertex* vertices, const Uint32 num_vertices) {
+        ZoneScoped;
+
+        if(num_vertices == 0) {
+            return {};
+        }
+
+        // Each load grabs the location and the first float after it. That lane's min and max are garbage, but the other three are what
+        // we want. Two pairs of accumulators keep the loop from waiting on the previous vertex's min and max
+        const auto load_location = [&](const Uint32 vertex_idx) {
+            return _mm_loadu_ps(reinterpret_cast<const Float32*>(&vertices[vertex_idx].location));
+        };
+
+        auto min_a = load_location(0);
+        auto max_a = min_a;
+        auto min_b = min_a;
+        auto max_b = min_a;
+
+        Uint32 vertex_idx = 1;
+        for(; vertex_idx + 1 < num_vertices; vertex_idx += 2) {
+            const auto location_a = load_location(vertex_idx);
+            const auto location_b = load_location(vertex_idx + 1);
+
+            min_a = _mm_min_ps(min_a, location_a);
+            max_a = _mm_max_ps(max_a, location_a);
+            min_b = _mm_min_ps(min_b, location_b);
+            max_b = _mm_max_ps(max_b, location_b);
+        }
+
+        if(vertex_idx < num_vertices) {
+            const auto location = load_location(vertex_idx);
+            min_a = _mm_min_ps(min_a, location);
+            max_a = _mm_max_ps(max_a, location);
+        }
+
+        alignas(16) Float32 min[4];
+        alignas(16) Float32 max[4];
+        _mm_store_ps(min, _mm_min_ps(min_a, min_b));
+        _mm_store_ps(max, _mm_max_ps(max_a, max_b));
+
+        return {.x_min = min[0], .x_max = max[0], .y_min = min[1], .y_max = max[1], .z_min = min[2], .z_max = max[2]};
+    }
+} // namespace sanity::engine::renderer
@@ -3,6 +3,7 @@
 #include "Tracy.hpp"
 #include "TracyD3D12.hpp"
 #include "pix3.h"
+#include "core/constants.hpp"
 #include "renderer.hpp"
 #include "renderer/rhi/helpers.hpp"
 #include "renderer/rhi/render_backend.hpp"
@@ -11,6 +12,22 @@
 namespace sanity::engine::renderer {
     RX_LOG("MeshDataStore", logger);
 
+    static bool are_mesh_lods_valid(const Uint32 num_indices, const MeshLod* lods, const Uint32 num_lods) {
+        if(num_lods > MAX_MESH_LODS) {
+            logger->error("Mesh has %u LODs, but meshes may have at most %u", num_lods, MAX_MESH_LODS);
+            return false;
+        }
+
+        for(Uint32 lod_idx = 0; lod_idx < num_lods; lod_idx++) {
+            if(static_cast<Uint64>(lods[lod_idx].index_offset) + lods[lod_idx].num_indices > num_indices) {
+                logger->error("LOD %u of mesh uses indices past the end of the mesh's %u indices", lod_idx, num_indices);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     MeshUploader::MeshUploader(ID3D12GraphicsCommandList4* cmds_in, MeshDataStore* mesh_store_in)
         : cmds{cmds_in}, mesh_store{mesh_store_in} {
         const auto& index_buffer = mesh_store->get_index_buffer();
@@ -65,9 +82,47 @@ namespace sanity::engine::renderer {
         }
     }
 
-    Mesh MeshUploader::add_mesh(const Rx::Vector<StandardVertex>& vertices, const Rx::Vector<Uint32>& indices) const {
+    MeshObject MeshUploader::add_mesh(const Rx::Vector<StandardVertex>& vertices, const Rx::Vector<Uint32>& indices) const {
+        return add_mesh(vertices.data(), static_cast<Uint32>(vertices.size()), indices.data(), static_cast<Uint32>(indices.size()));
+    }
+
+    MeshObject MeshUploader::add_mesh(const StandardVertex* vertices,
+                                      const Uint32 num_vertices,
+                                      const Uint32* indices,
+                                      const Uint32 num_indices,
+                                      const MeshLod* lods,
+                                      const Uint32 num_lods,
+                                      const MeshletBounds* meshlet_bounds,
+                                      const Uint32 num_meshlets) const {
         if(state == State::AddVerticesAndIndices) {
-            return mesh_store->add_mesh(vertices, indices, cmds);
+            return mesh_store->add_mesh(vertices, num_vertices, indices, num_indices, lods, num_lods, meshlet_bounds, num_meshlets, cmds);
+
+        } else {
+            logger->error("MeshUploader not in the right state to add meshes");
+            return {};
+        }
+    }
+
+    MeshObject MeshUploader::add_mesh(const PackedVertex* vertices,
+                                      const Uint32 num_vertices,
+                                      const MeshDequantization& dequantization,
+                                      const Uint32* indices,
+                                      const Uint32 num_indices,
+                                      const MeshLod* lods,
+                                      const Uint32 num_lods,
+                                      const MeshletBounds* meshlet_bounds,
+                                      const Uint32 num_meshlets) const {
+        if(state == State::AddVerticesAndIndices) {
+            return mesh_store->add_mesh(vertices,
+                                        num_vertices,
+                                        dequantization,
+                                        indices,
+                                        num_indices,
+                                        lods,
+                                        num_lods,
+                                        meshlet_bounds,
+                                        num_meshlets,
+                                        cmds);
 
         } else {
             logger->error("MeshUploader not in the right state to add meshes");
@@ -97,12 +152,37 @@ namespace sanity::engine::renderer {
         }
     }
 
-    MeshDataStore::MeshDataStore(Renderer& renderer_in, BufferHandle vertex_buffer_in, BufferHandle index_buffer_in)
+    MeshDataStore::MeshDataStore(Renderer& renderer_in,
+                                 BufferHandle vertex_buffer_in,
+                                 BufferHandle index_buffer_in,
+                                 const MeshVertexFormat vertex_format_in)
         : renderer{&renderer_in},
           vertex_buffer_handle{Rx::Utility::move(vertex_buffer_in)},
-          index_buffer_handle{Rx::Utility::move(index_buffer_in)} {
+          index_buffer_handle{Rx::Utility::move(index_buffer_in)},
+          vertex_format{vertex_format_in},
+          vertex_size{static_cast<Uint32>(vertex_format == MeshVertexFormat::PackedVertex ? sizeof(PackedVertex) : sizeof(StandardVertex))},
+          vertex_allocator{static_cast<Uint32>(renderer->get_buffer(vertex_buffer_handle)->size / vertex_size)},
+          index_allocator{static_cast<Uint32>(renderer->get_buffer(index_buffer_handle)->size / sizeof(Uint32))} {
         const auto& vertex_buffer = renderer->get_buffer(vertex_buffer_handle);
 
+        const auto num_gpu_frames = renderer->get_render_backend().get_max_num_gpu_frames();
+        retired_vertex_ranges.resize(num_gpu_frames);
+        retired_index_ranges.resize(num_gpu_frames);
+        retired_dequantization_slots.resize(num_gpu_frames);
+
+        if(vertex_format == MeshVertexFormat::PackedVertex) {
+            // The CPU writes each mesh's dequantization once, when the mesh is added, and the slot isn't reused until no frame in flight
+            // can draw the mesh, so there's no need for a copy per frame
+            dequantization_buffer_handle = renderer->create_buffer(
+                BufferCreateInfo{.name = Rx::String::format("%s dequantizations", vertex_buffer->name),
+                                 .usage = BufferUsage::ConstantBuffer,
+                                 .size = MAX_NUM_PACKED_MESHES * sizeof(MeshDequantization)});
+
+            // The packed vertex shader unpacks all the attributes itself
+            vertex_bindings = Rx::Array{VertexBufferBinding{.buffer = *vertex_buffer, .offset = 0, .vertex_size = sizeof(PackedVertex)}};
+            return;
+        }
+
         vertex_bindings = Rx::Array{VertexBufferBinding{.buffer = *vertex_buffer,
                                                         .offset = offsetof(StandardVertex, location),
                                                         .vertex_size = sizeof(StandardVertex)},
@@ -125,6 +205,10 @@ namespace sanity::engine::renderer {
 
         backend.schedule_buffer_destruction(*vertex_buffer);
         backend.schedule_buffer_destruction(*index_buffer);
+
+        if(dequantization_buffer_handle.is_valid()) {
+            backend.schedule_buffer_destruction(*renderer->get_buffer(dequantization_buffer_handle));
+        }
     }
 
     BufferHandle MeshDataStore::get_vertex_buffer_handle() const { return vertex_buffer_handle; }
@@ -135,30 +219,495 @@ namespace sanity::engine::renderer {
 
     Buffer MeshDataStore::get_index_buffer() const { return *renderer->get_buffer(index_buffer_handle); }
 
+    MeshVertexFormat MeshDataStore::get_vertex_format() const { return vertex_format; }
+
+    BufferHandle MeshDataStore::get_dequantization_buffer_handle() const { return dequantization_buffer_handle; }
+
     MeshUploader MeshDataStore::begin_adding_meshes(ID3D12GraphicsCommandList4* commands) { return MeshUploader{commands, this}; }
 
-    Mesh MeshDataStore::add_mesh(const Rx::Vector<StandardVertex>& vertices,
-                                 const Rx::Vector<Uint32>& indices,
-                                 ID3D12GraphicsCommandList4* commands) {
+    void MeshDataStore::remove_mesh(const Mesh& mesh) {
+        if(mesh.num_vertices == 0) {
+            // Empty meshes were never put in the store
+            return;
+        }
+
+        const auto* record = meshes.find(mesh.first_index);
+        if(record == nullptr || record->mesh.first_vertex != mesh.first_vertex) {
+            logger->error("Can not remove mesh with first vertex %u and first index %u: it's not in the mesh store",
+                          mesh.first_vertex,
+                          mesh.first_index);
+            return;
+        }
+
+        const auto frame_idx = renderer->get_render_backend().get_cur_gpu_frame_idx();
+        retired_vertex_ranges[frame_idx].push_back(mesh.first_vertex);
+        retired_index_ranges[frame_idx].push_back(mesh.first_index);
+        if(vertex_format == MeshVertexFormat::PackedVertex) {
+            retired_dequantization_slots[frame_idx].push_back(record->dequantization_idx);
+        }
+
+        first_index_by_first_vertex.erase(mesh.first_vertex);
+        meshes.erase(mesh.first_index);
+    }
+
+    Rx::Optional<BoundingBox> MeshDataStore::get_mesh_bounds(const Mesh& mesh) const {
+        const auto* record = meshes.find(mesh.first_index);
+        if(record == nullptr || record->mesh.first_vertex != mesh.first_vertex) {
+            return Rx::nullopt;
+        }
+
+        return record->bounds;
+    }
+
+    const Rx::Vector<MeshletBounds>* MeshDataStore::get_meshlet_bounds(const Mesh& mesh) const {
+        const auto* record = meshes.find(mesh.first_index);
+        if(record == nullptr || record->mesh.first_vertex != mesh.first_vertex) {
+            return nullptr;
+        }
+
+        return &record->meshlet_bounds;
+    }
+
+    Rx::Optional<Uint32> MeshDataStore::get_mesh_dequantization_index(const Mesh& mesh) const {
+        const auto* record = meshes.find(mesh.first_index);
+        if(record == nullptr || record->mesh.first_vertex != mesh.first_vertex) {
+            return Rx::nullopt;
+        }
+
+        return record->dequantization_idx;
+    }
+
+    void MeshDataStore::set_keep_vertex_locations(const bool keep) { keep_vertex_locations = keep; }
+
+    const MeshBvh* MeshDataStore::get_mesh_bvh(const Mesh& mesh, ThreadPool* thread_pool) {
+        auto* record = meshes.find(mesh.first_index);
+        if(record == nullptr || record->mesh.first_vertex != mesh.first_vertex) {
+            return nullptr;
+        }
+
+        if(!record->bvh) {
+            if(record->locations.is_empty()) {
+                return nullptr;
+            }
+
+            logger->verbose("Building BVH for mesh with first vertex %u and first index %u", mesh.first_vertex, mesh.first_index);
+
+            // The mesh's own indices come before the indices of its LODs
+            record->bvh = Rx::make_ptr<MeshBvh>(RX_SYSTEM_ALLOCATOR,
+                                                build_mesh_bvh(record->locations.data(),
+                                                               static_cast<Uint32>(record->locations.size()),
+                                                               record->indices.data(),
+                                                               record->mesh.num_indices,
+                                                               thread_pool));
+
+            // The BVH's triangles hold their own copy of the locations
+            record->locations = Rx::Vector<glm::vec3>{};
+        }
+
+        return record->bvh.get();
+    }
+
+    void MeshDataStore::begin_frame(const Uint32 frame_idx) {
+        retired_vertex_ranges[frame_idx].each_fwd([&](const Uint32 first_vertex) { vertex_allocator.free(first_vertex); });
+        retired_vertex_ranges[frame_idx].clear();
+
+        retired_index_ranges[frame_idx].each_fwd([&](const Uint32 first_index) { index_allocator.free(first_index); });
+        retired_index_ranges[frame_idx].clear();
+
+        retired_dequantization_slots[frame_idx].each_fwd([&](const Uint32 slot) { free_dequantization_slots.push_back(slot); });
+        retired_dequantization_slots[frame_idx].clear();
+    }
+
+    Rx::Vector<MeshRelocation> MeshDataStore::compact(ID3D12GraphicsCommandList4* commands, const Uint32 max_bytes_to_move) {
+        ZoneScoped;
+
+        // Moving a mesh's vertices means re-uploading its indices too, so both count against the same budget. The moves in a plan don't
+        // depend on each other, so moves that don't fit can be dropped by handing their new range back
+        auto num_bytes_left = max_bytes_to_move;
+
+        // Meshes whose indices are re-uploaded by a vertex move, keyed by their first index. Moving their index range too is free
+        Rx::Map<Uint32, bool> reuploaded_meshes;
+
+        // Ranges of removed meshes stay allocated until the GPU is done with them, so the planner may want to move them. Nothing needs
+        // them any more, so we hand their new ranges straight back
+        Rx::Vector<RangeMove> vertex_moves;
+        vertex_allocator.plan_compaction(num_bytes_left / vertex_size).each_fwd([&](const RangeMove& move) {
+            const auto* first_index = first_index_by_first_vertex.find(move.source_offset);
+            if(first_index == nullptr) {
+                vertex_allocator.free(move.destination_offset);
+                return;
+            }
+
+            const auto num_index_bytes = static_cast<Uint32>(meshes.find(*first_index)->indices.size() * sizeof(Uint32));
+            const auto num_bytes = move.size * vertex_size + num_index_bytes;
+            if(num_bytes > num_bytes_left) {
+                vertex_allocator.free(move.destination_offset);
+                return;
+            }
+
+            vertex_moves.push_back(move);
+            reuploaded_meshes.insert(*first_index, true);
+            num_bytes_left -= num_bytes;
+        });
+
+        Rx::Vector<RangeMove> index_moves;
+        index_allocator.plan_compaction(num_bytes_left / sizeof(Uint32)).each_fwd([&](const RangeMove& move) {
+            if(meshes.find(move.source_offset) == nullptr) {
+                index_allocator.free(move.destination_offset);
+                return;
+            }
+
+            const auto is_reuploaded = reuploaded_meshes.find(move.source_offset) != nullptr;
+            const auto num_bytes = is_reuploaded ? 0 : move.size * static_cast<Uint32>(sizeof(Uint32));
+            if(num_bytes > num_bytes_left) {
+                index_allocator.free(move.destination_offset);
+                return;
+            }
+
+            index_moves.push_back(move);
+            num_bytes_left -= num_bytes;
+        });
+
+        if(vertex_moves.is_empty() && index_moves.is_empty()) {
+            return {};
+        }
+
+        TracyD3D12Zone(RenderBackend::tracy_render_context, commands, "MeshDataStore::compact");
+        PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "MeshDataStore::compact");
+
+        logger->verbose("Moving %u vertex ranges and %u index ranges", vertex_moves.size(), index_moves.size());
+
+        // Figure out where every affected mesh will end up, keyed by its current first index
+        Rx::Map<Uint32, Mesh> new_meshes;
+        vertex_moves.each_fwd([&](const RangeMove& move) {
+            const auto first_index = *first_index_by_first_vertex.find(move.source_offset);
+            auto* new_mesh = new_meshes.find(first_index);
+            if(new_mesh == nullptr) {
+                new_mesh = new_meshes.insert(first_index, meshes.find(first_index)->mesh);
+            }
+
+            new_mesh->first_vertex = move.destination_offset;
+        });
+        index_moves.each_fwd([&](const RangeMove& move) {
+            auto* new_mesh = new_meshes.find(move.source_offset);
+            if(new_mesh == nullptr) {
+                new_mesh = new_meshes.insert(move.source_offset, meshes.find(move.source_offset)->mesh);
+            }
+
+            new_mesh->first_index = move.destination_offset;
+        });
+
+        auto& backend = renderer->get_render_backend();
+
+        const auto& vertex_buffer = get_vertex_buffer();
+        const auto& index_buffer = get_index_buffer();
+
+        auto* vertex_resource = *vertex_buffer.resource;
+        auto* index_resource = *index_buffer.resource;
+
+        // A resource can't be the source and destination of the same copy, so vertex data bounces through a scratch buffer
+        Uint32 num_vertex_bytes_to_move = 0;
+        vertex_moves.each_fwd([&](const RangeMove& move) { num_vertex_bytes_to_move += move.size * vertex_size; });
+
+        Rx::Optional<Buffer> scratch_buffer;
+        if(num_vertex_bytes_to_move > 0) {
+            scratch_buffer = backend.get_scratch_buffer(num_vertex_bytes_to_move);
+
+            Rx::Vector<D3D12_RESOURCE_BARRIER> barriers{2};
+            barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(vertex_resource,
+                                                               D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+                                                               D3D12_RESOURCE_STATE_COPY_SOURCE);
+            barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(scratch_buffer->resource,
+                                                               D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                                               D3D12_RESOURCE_STATE_COPY_DEST);
+            commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+            Uint32 scratch_offset = 0;
+            vertex_moves.each_fwd([&](const RangeMove& move) {
+                const auto num_bytes = move.size * vertex_size;
+                commands->CopyBufferRegion(scratch_buffer->resource,
+                                           scratch_offset,
+                                           vertex_resource,
+                                           static_cast<Uint64>(move.source_offset) * vertex_size,
+                                           num_bytes);
+                scratch_offset += num_bytes;
+            });
+
+            barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(vertex_resource,
+                                                               D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                                               D3D12_RESOURCE_STATE_COPY_DEST);
+            barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(scratch_buffer->resource,
+                                                               D3D12_RESOURCE_STATE_COPY_DEST,
+                                                               D3D12_RESOURCE_STATE_COPY_SOURCE);
+            commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+            scratch_offset = 0;
+            vertex_moves.each_fwd([&](const RangeMove& move) {
+                const auto num_bytes = move.size * vertex_size;
+                commands->CopyBufferRegion(vertex_resource,
+                                           static_cast<Uint64>(move.destination_offset) * vertex_size,
+                                           scratch_buffer->resource,
+                                           scratch_offset,
+                                           num_bytes);
+                scratch_offset += num_bytes;
+            });
+        }
+
+        {
+            const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(index_resource,
+                                                                      D3D12_RESOURCE_STATE_INDEX_BUFFER,
+                                                                      D3D12_RESOURCE_STATE_COPY_DEST);
+            commands->ResourceBarrier(1, &barrier);
+        }
+
+        // Every mesh that moved at all needs its indices re-uploaded, since they're offset by the mesh's first vertex
+        Rx::Vector<MeshRelocation> relocations;
+        relocations.reserve(new_meshes.size());
+        new_meshes.each_pair([&](const Uint32 old_first_index, const Mesh& new_mesh) {
+            auto* record = meshes.find(old_first_index);
+            const auto old_mesh = record->mesh;
+
+            Rx::Vector<Uint32> offset_indices;
+            offset_indices.reserve(record->indices.size());
+            record->indices.each_fwd([&](const Uint32 idx) { offset_indices.push_back(idx + new_mesh.first_vertex); });
+
+            upload_data_with_staging_buffer(commands,
+                                            backend,
+                                            index_resource,
+                                            offset_indices.data(),
+                                            static_cast<Uint32>(offset_indices.size() * sizeof(Uint32)),
+                                            new_mesh.first_index * sizeof(Uint32));
+
+            auto new_record = MeshRecord{.mesh = new_mesh,
+                                         .bounds = record->bounds,
+                                         .indices = Rx::Utility::move(record->indices),
+                                         .locations = Rx::Utility::move(record->locations),
+                                         .meshlet_bounds = Rx::Utility::move(record->meshlet_bounds),
+                                         .dequantization_idx = record->dequantization_idx,
+                                         .bvh = Rx::Utility::move(record->bvh)};
+            meshes.erase(old_first_index);
+            first_index_by_first_vertex.erase(old_mesh.first_vertex);
+
+            meshes.insert(new_mesh.first_index, Rx::Utility::move(new_record));
+            first_index_by_first_vertex.insert(new_mesh.first_vertex, new_mesh.first_index);
+
+            relocations.push_back(MeshRelocation{.old_mesh = old_mesh, .new_mesh = new_mesh});
+        });
+
+        Rx::Vector<D3D12_RESOURCE_BARRIER> barriers;
+        barriers.push_back(
+            CD3DX12_RESOURCE_BARRIER::Transition(index_resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER));
+        if(scratch_buffer) {
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(vertex_resource,
+                                                                    D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                    D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(scratch_buffer->resource,
+                                                                    D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                                                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+        }
+        commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+        if(scratch_buffer) {
+            backend.return_scratch_buffer(*scratch_buffer);
+        }
+
+        // The old ranges may still be drawn from by frames that are in flight
+        const auto frame_idx = backend.get_cur_gpu_frame_idx();
+        vertex_moves.each_fwd([&](const RangeMove& move) { retired_vertex_ranges[frame_idx].push_back(move.source_offset); });
+        index_moves.each_fwd([&](const RangeMove& move) { retired_index_ranges[frame_idx].push_back(move.source_offset); });
+
+        return relocations;
+    }
+
+    RangeAllocatorStats MeshDataStore::get_vertex_allocator_stats() const { return vertex_allocator.get_stats(); }
+
+    RangeAllocatorStats MeshDataStore::get_index_allocator_stats() const { return index_allocator.get_stats(); }
+
+    MeshObject MeshDataStore::add_mesh(const StandardVertex* vertices,
+                                       const Uint32 num_vertices,
+                                       const Uint32* indices,
+                                       const Uint32 num_indices,
+                                       const MeshLod* lods,
+                                       const Uint32 num_lods,
+                                       const MeshletBounds* meshlet_bounds,
+                                       const Uint32 num_meshlets,
+                                       ID3D12GraphicsCommandList4* commands) {
+        ZoneScoped;
+
+        TracyD3D12Zone(RenderBackend::tracy_render_context, commands, "MeshDataStore::add_mesh");
+        PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "MeshDataStore::add_mesh");
+
+        logger->verbose("Adding mesh with %u vertices, %u indices, and %u LODs", num_vertices, num_indices, num_lods);
+
+        if(vertex_format != MeshVertexFormat::StandardVertex) {
+            logger->error("Can not add a mesh of StandardVertices to a mesh store of PackedVertices");
+            return {};
+        }
+
+        if(!are_mesh_lods_valid(num_indices, lods, num_lods)) {
+            return {};
+        }
+
+        // Empty meshes draw nothing, so they're accepted without taking any space in the store
+        if(num_vertices == 0 || num_indices == 0) {
+            return MeshObject{};
+        }
+
+        Rx::Vector<glm::vec3> locations;
+        if(keep_vertex_locations) {
+            locations.resize(num_vertices);
+            for(Uint32 i = 0; i < num_vertices; i++) {
+                locations[i] = vertices[i].location;
+            }
+        }
+
+        return add_mesh_data(vertices,
+                             num_vertices,
+                             indices,
+                             num_indices,
+                             lods,
+                             num_lods,
+                             meshlet_bounds,
+                             num_meshlets,
+                             compute_mesh_bounds(vertices, num_vertices),
+                             Rx::Utility::move(locations),
+                             0,
+                             commands);
+    }
+
+    MeshObject MeshDataStore::add_mesh(const PackedVertex* vertices,
+                                       const Uint32 num_vertices,
+                                       const MeshDequantization& dequantization,
+                                       const Uint32* indices,
+                                       const Uint32 num_indices,
+                                       const MeshLod* lods,
+                                       const Uint32 num_lods,
+                                       const MeshletBounds* meshlet_bounds,
+                                       const Uint32 num_meshlets,
+                                       ID3D12GraphicsCommandList4* commands) {
         ZoneScoped;
 
         TracyD3D12Zone(RenderBackend::tracy_render_context, commands, "MeshDataStore::add_mesh");
         PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "MeshDataStore::add_mesh");
 
-        logger->verbose("Adding mesh with %u vertices and %u indices", vertices.size(), indices.size());
+        logger->verbose("Adding packed mesh with %u vertices, %u indices, and %u LODs", num_vertices, num_indices, num_lods);
+
+        if(vertex_format != MeshVertexFormat::PackedVertex) {
+            logger->error("Can not add a mesh of PackedVertices to a mesh store of StandardVertices");
+            return {};
+        }
+
+        if(!are_mesh_lods_valid(num_indices, lods, num_lods)) {
+            return {};
+        }
+
+        if(num_vertices == 0 || num_indices == 0) {
+            return MeshObject{};
+        }
+
+        Uint32 dequantization_idx;
+        if(!free_dequantization_slots.is_empty()) {
+            dequantization_idx = free_dequantization_slots.last();
+            free_dequantization_slots.pop_back();
+
+        } else if(num_used_dequantization_slots < MAX_NUM_PACKED_MESHES) {
+            dequantization_idx = num_used_dequantization_slots;
+            num_used_dequantization_slots++;
+
+        } else {
+            logger->error("Could not add packed mesh: the mesh store already has %u packed meshes", MAX_NUM_PACKED_MESHES);
+            return {};
+        }
+
+        // Bounds of the quantized locations are exact, and dequantize to the bounds of the locations that the vertex shader sees
+        auto min_location = glm::uvec3{MAX_QUANTIZED_LOCATION};
+        auto max_location = glm::uvec3{0};
+
+        Rx::Vector<glm::vec3> locations;
+        if(keep_vertex_locations) {
+            locations.resize(num_vertices);
+        }
+
+        for(Uint32 i = 0; i < num_vertices; i++) {
+            const auto& vertex = vertices[i];
+            const auto location = glm::uvec3{vertex.location_xy & 0xFFFF, vertex.location_xy >> 16, vertex.location_z_normal & 0xFFFF};
+            min_location = glm::min(min_location, location);
+            max_location = glm::max(max_location, location);
+
+            if(keep_vertex_locations) {
+                locations[i] = dequantization.location_offset + glm::vec3{location} * dequantization.location_scale;
+            }
+        }
+
+        const auto min = dequantization.location_offset + glm::vec3{min_location} * dequantization.location_scale;
+        const auto max = dequantization.location_offset + glm::vec3{max_location} * dequantization.location_scale;
+        const auto bounds = BoundingBox{.x_min = min.x, .x_max = max.x, .y_min = min.y, .y_max = max.y, .z_min = min.z, .z_max = max.z};
+
+        const auto mesh_object = add_mesh_data(vertices,
+                                               num_vertices,
+                                               indices,
+                                               num_indices,
+                                               lods,
+                                               num_lods,
+                                               meshlet_bounds,
+                                               num_meshlets,
+                                               bounds,
+                                               Rx::Utility::move(locations),
+                                               dequantization_idx,
+                                               commands);
+        if(mesh_object.mesh.num_vertices == 0) {
+            free_dequantization_slots.push_back(dequantization_idx);
+            return mesh_object;
+        }
+
+        auto* dequantizations = static_cast<MeshDequantization*>(renderer->get_buffer(dequantization_buffer_handle)->mapped_ptr);
+        dequantizations[dequantization_idx] = dequantization;
+
+        return mesh_object;
+    }
+
+    MeshObject MeshDataStore::add_mesh_data(const void* vertices,
+                                            const Uint32 num_vertices,
+                                            const Uint32* indices,
+                                            const Uint32 num_indices,
+                                            const MeshLod* lods,
+                                            const Uint32 num_lods,
+                                            const MeshletBounds* meshlet_bounds,
+                                            const Uint32 num_meshlets,
+                                            const BoundingBox& bounds,
+                                            Rx::Vector<glm::vec3>&& locations,
+                                            const Uint32 dequantization_idx,
+                                            ID3D12GraphicsCommandList4* commands) {
+        const auto vertex_allocation = vertex_allocator.allocate(num_vertices);
+        if(!vertex_allocation) {
+            logger->error("Could not allocate space for %u vertices", num_vertices);
+            return {};
+        }
+
+        const auto index_allocation = index_allocator.allocate(num_indices);
+        if(!index_allocation) {
+            logger->error("Could not allocate space for %u indices", num_indices);
+            vertex_allocator.free(vertex_allocation->offset);
+            return {};
+        }
 
         auto& backend = renderer->get_render_backend();
 
-        const auto vertex_data_size = static_cast<Uint32>(vertices.size() * sizeof(StandardVertex));
-        const auto index_data_size = static_cast<Uint32>(indices.size() * sizeof(Uint32));
+        const auto vertex_data_size = num_vertices * vertex_size;
+        const auto index_data_size = static_cast<Uint32>(num_indices * sizeof(Uint32));
+
+        const auto vertex_offset = vertex_allocation->offset;
+        const auto index_offset = index_allocation->offset;
 
         // Offset the indices so they'll refer to the right vertex
         Rx::Vector<Uint32> offset_indices;
-        offset_indices.reserve(indices.size());
+        offset_indices.resize(num_indices);
 
-        logger->verbose("Offsetting indices by %d", next_vertex_offset);
+        logger->verbose("Offsetting indices by %d", vertex_offset);
 
-        indices.each_fwd([&](const Uint32 idx) { offset_indices.push_back(idx + next_vertex_offset); });
+        for(Uint32 i = 0; i < num_indices; i++) {
+            offset_indices[i] = indices[i] + vertex_offset;
+        }
 
         const auto& vertex_buffer = get_vertex_buffer();
         const auto& index_buffer = get_index_buffer();
@@ -166,30 +715,45 @@ namespace sanity::engine::renderer {
         auto* vertex_resource = *vertex_buffer.resource;
         auto* index_resource = *index_buffer.resource;
 
-        const auto index_buffer_byte_offset = static_cast<Uint32>(next_index_offset * sizeof(Uint32));
-
-        upload_data_with_staging_buffer(commands, backend, vertex_resource, vertices.data(), vertex_data_size, next_free_vertex_byte);
+        upload_data_with_staging_buffer(commands, backend, vertex_resource, vertices, vertex_data_size, vertex_offset * vertex_size);
 
         upload_data_with_staging_buffer(commands,
                                         backend,
                                         index_resource,
                                         offset_indices.data(),
                                         index_data_size,
-                                        index_buffer_byte_offset);
-
-        const auto vertex_offset = static_cast<Uint32>(next_free_vertex_byte / sizeof(StandardVertex));
+                                        static_cast<Uint32>(index_offset * sizeof(Uint32)));
+
+        auto mesh = Mesh{.first_vertex = vertex_offset,
+                         .num_vertices = num_vertices,
+                         .first_index = index_offset,
+                         .num_indices = num_lods > 0 ? lods[0].index_offset : num_indices,
+                         .num_lods = num_lods,
+                         .is_packed = vertex_format == MeshVertexFormat::PackedVertex};
+        for(Uint32 lod_idx = 0; lod_idx < num_lods; lod_idx++) {
+            mesh.lods[lod_idx] = lods[lod_idx];
+        }
 
-        next_free_vertex_byte += vertex_data_size;
+        Rx::Vector<Uint32> mesh_indices;
+        mesh_indices.resize(num_indices);
+        memcpy(mesh_indices.data(), indices, index_data_size);
 
-        const auto index_offset = next_index_offset;
+        Rx::Vector<MeshletBounds> mesh_meshlet_bounds;
+        mesh_meshlet_bounds.resize(num_meshlets);
+        if(num_meshlets > 0) {
+            memcpy(mesh_meshlet_bounds.data(), meshlet_bounds, num_meshlets * sizeof(MeshletBounds));
+        }
 
-        next_vertex_offset += static_cast<Uint32>(vertices.size());
-        next_index_offset += static_cast<Uint32>(indices.size());
+        meshes.insert(index_offset,
+                      MeshRecord{.mesh = mesh,
+                                 .bounds = bounds,
+                                 .indices = Rx::Utility::move(mesh_indices),
+                                 .locations = Rx::Utility::move(locations),
+                                 .meshlet_bounds = Rx::Utility::move(mesh_meshlet_bounds),
+                                 .dequantization_idx = dequantization_idx});
+        first_index_by_first_vertex.insert(vertex_offset, index_offset);
 
-        return {.first_vertex = vertex_offset,
-                .num_vertices = static_cast<Uint32>(vertices.size()),
-                .first_index = index_offset,
-                .num_indices = static_cast<Uint32>(indices.size())};
+        return MeshObject{.mesh = mesh, .bounds = bounds};
     }
 
     void MeshDataStore::bind_to_command_list(ID3D12GraphicsCommandList* commands) const {
@@ -1,13 +1,21 @@
 #pragma once
 
 #include "core/Prelude.hpp"
+#include "core/range_allocator.hpp"
 #include "core/types.hpp"
+#include "renderer/bvh.hpp"
 #include "renderer/hlsl/mesh_data.hpp"
 #include "renderer/mesh.hpp"
 #include "renderer/rhi/resources.hpp"
+#include "rx/core/map.h"
+#include "rx/core/optional.h"
 #include "rx/core/ptr.h"
 #include "rx/core/vector.h"
 
+namespace sanity::engine {
+    class ThreadPool;
+}
+
 namespace sanity::engine::renderer {
     class Renderer;
     class MeshDataStore;
@@ -34,6 +42,28 @@ namespace sanity::engine::renderer {
         Uint32 vertex_size;
     };
 
+    /*!
+     * \brief What kind of vertices a mesh store holds
+     */
+    enum class MeshVertexFormat {
+        StandardVertex,
+
+        /*!
+         * \brief Each vertex is a PackedVertex. The store keeps each mesh's MeshDequantization in a buffer, which the vertex shader reads
+         * through the mesh's dequantization index
+         */
+        PackedVertex,
+    };
+
+    /*!
+     * \brief Where a mesh used to live in the mesh store, and where compaction moved it to
+     */
+    struct MeshRelocation {
+        Mesh old_mesh;
+
+        Mesh new_mesh;
+    };
+
     class MeshUploader final {
     public:
         explicit MeshUploader(ID3D12GraphicsCommandList4* cmds_in, MeshDataStore* mesh_store_in);
@@ -46,7 +76,44 @@ namespace sanity::engine::renderer {
 
         ~MeshUploader();
 
-        [[nodiscard]] Mesh add_mesh(const Rx::Vector<StandardVertex>& vertices, const Rx::Vector<Uint32>& indices) const;
+        [[nodiscard]] MeshObject add_mesh(const Rx::Vector<StandardVertex>& vertices, const Rx::Vector<Uint32>& indices) const;
+
+        /*!
+         * \brief Adds a mesh whose data is somewhere other than in vectors, such as in a memory-mapped file. The data is copied straight
+         * into staging memory
+         *
+         * If the mesh has LODs, `indices` holds the mesh's own indices followed by the indices of its LODs, and `num_indices` counts all
+         * of them. The mesh's own indices end where the first LOD's begin
+         *
+         * The bounds of the mesh's meshlets, if it has any, are kept on the CPU for meshlet culling
+         *
+         * Meshes with no vertices or no indices are accepted, and come back as an empty mesh which takes no space in the store
+         *
+         * \return The new mesh and the bounds of its vertices, or an empty mesh if there wasn't enough space for it
+         */
+        [[nodiscard]] MeshObject add_mesh(const StandardVertex* vertices,
+                                          Uint32 num_vertices,
+                                          const Uint32* indices,
+                                          Uint32 num_indices,
+                                          const MeshLod* lods = nullptr,
+                                          Uint32 num_lods = 0,
+                                          const MeshletBounds* meshlet_bounds = nullptr,
+                                          Uint32 num_meshlets = 0) const;
+
+        /*!
+         * \brief Adds a mesh of packed vertices to a store of PackedVertices. Otherwise the same as adding a mesh of StandardVertices
+         *
+         * \param dequantization How to decode the mesh's vertices. The vertex shader decodes them with it when the mesh is drawn
+         */
+        [[nodiscard]] MeshObject add_mesh(const PackedVertex* vertices,
+                                          Uint32 num_vertices,
+                                          const MeshDequantization& dequantization,
+                                          const Uint32* indices,
+                                          Uint32 num_indices,
+                                          const MeshLod* lods = nullptr,
+                                          Uint32 num_lods = 0,
+                                          const MeshletBounds* meshlet_bounds = nullptr,
+                                          Uint32 num_meshlets = 0) const;
 
         void prepare_for_raytracing_geometry_build();
 
@@ -65,7 +132,14 @@ namespace sanity::engine::renderer {
 
     class MeshDataStore {
     public:
-        MeshDataStore(Renderer& renderer_in, BufferHandle vertex_buffer_in, BufferHandle index_buffer_in);
+        /*!
+         * \param vertex_format_in What kind of vertices the store holds. Stores of PackedVertices create a buffer for the
+         * MeshDequantizations of their meshes
+         */
+        MeshDataStore(Renderer& renderer_in,
+                      BufferHandle vertex_buffer_in,
+                      BufferHandle index_buffer_in,
+                      MeshVertexFormat vertex_format_in = MeshVertexFormat::StandardVertex);
 
         MeshDataStore(const MeshDataStore& other) = delete;
         MeshDataStore& operator=(const MeshDataStore& other) = delete;
@@ -83,11 +157,89 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] Buffer get_index_buffer() const;
 
+        [[nodiscard]] MeshVertexFormat get_vertex_format() const;
+
+        /*!
+         * \brief Gets the buffer of MeshDequantizations, which is only valid in a store of PackedVertices
+         */
+        [[nodiscard]] BufferHandle get_dequantization_buffer_handle() const;
+
         /*!
          * \brief Prepares the vertex and index buffers to receive new mesh data
          */
         [[nodiscard]] MeshUploader begin_adding_meshes(ID3D12GraphicsCommandList4* commands);
 
+        /*!
+         * \brief Removes a mesh from the mesh store
+         *
+         * The mesh's vertex and index ranges are only reused once every GPU frame that might still be drawing the mesh has finished
+         */
+        void remove_mesh(const Mesh& mesh);
+
+        /*!
+         * \brief Gets the bounds of a mesh's vertices, in the mesh's local space
+         *
+         * \return The mesh's bounds, or an empty optional if the mesh isn't in the mesh store
+         */
+        [[nodiscard]] Rx::Optional<BoundingBox> get_mesh_bounds(const Mesh& mesh) const;
+
+        /*!
+         * \brief Gets the bounds of the meshlets of a mesh's most detailed LOD, in the mesh's local space
+         *
+         * \return The bounds of the mesh's meshlets, which are empty if the mesh was added without meshlets, or nullptr if the mesh isn't
+         * in the mesh store
+         */
+        [[nodiscard]] const Rx::Vector<MeshletBounds>* get_meshlet_bounds(const Mesh& mesh) const;
+
+        /*!
+         * \brief Gets the index of a packed mesh's MeshDequantization in the dequantization buffer, which draws of the mesh pass to the
+         * vertex shader
+         *
+         * \return The index of the mesh's dequantization, or an empty optional if the mesh isn't in the mesh store
+         */
+        [[nodiscard]] Rx::Optional<Uint32> get_mesh_dequantization_index(const Mesh& mesh) const;
+
+        /*!
+         * \brief Sets whether meshes added from now on keep a copy of their vertex locations on the CPU, which their BVH is built from
+         *
+         * Off by default, since the copy costs 12 bytes per vertex and most meshes never get traced on the CPU
+         */
+        void set_keep_vertex_locations(bool keep);
+
+        /*!
+         * \brief Gets a BVH over the triangles of a mesh's most detailed LOD, in the mesh's local space, for tracing rays on the CPU
+         *
+         * The BVH is built the first time it's requested, from the vertex locations that the mesh kept when it was added, and lives until
+         * the mesh is removed. The locations are freed once the BVH is built. Compacting the mesh store doesn't move the BVH
+         *
+         * \param thread_pool Thread pool to build the BVH on, if it needs to be built. If this is nullptr, it's built on the calling thread
+         *
+         * \return The mesh's BVH, or nullptr if the mesh isn't in the mesh store or was added without keeping its vertex locations
+         */
+        [[nodiscard]] const MeshBvh* get_mesh_bvh(const Mesh& mesh, ThreadPool* thread_pool = nullptr);
+
+        /*!
+         * \brief Releases the vertex and index ranges that were retired the last time the GPU frame at `frame_idx` was recorded
+         *
+         * Must be called after the backend has waited for that frame
+         */
+        void begin_frame(Uint32 frame_idx);
+
+        /*!
+         * \brief Moves some meshes towards the start of the vertex and index buffers, to fight fragmentation from removing meshes
+         *
+         * Records the copies into `commands`. The old ranges are retired like removed meshes, so frames that are still in flight can keep
+         * drawing from them. Anything that stores a Mesh must be updated to the new mesh from the returned relocations
+         *
+         * \param max_bytes_to_move Upper bound on how many bytes of vertex and index data to copy, so that the work can be spread over many
+         * frames. Moved vertices and the indices that are re-uploaded because of them share this budget with moved indices
+         */
+        [[nodiscard]] Rx::Vector<MeshRelocation> compact(ID3D12GraphicsCommandList4* commands, Uint32 max_bytes_to_move);
+
+        [[nodiscard]] RangeAllocatorStats get_vertex_allocator_stats() const;
+
+        [[nodiscard]] RangeAllocatorStats get_index_allocator_stats() const;
+
         void bind_to_command_list(ID3D12GraphicsCommandList* commands) const;
 
     private:
@@ -97,24 +249,102 @@ namespace sanity::engine::renderer {
 
         BufferHandle index_buffer_handle;
 
+        MeshVertexFormat vertex_format;
+
+        /*!
+         * \brief Size of one of the store's vertices, in bytes
+         */
+        Uint32 vertex_size;
+
+        BufferHandle dequantization_buffer_handle;
+
         Rx::Vector<VertexBufferBinding> vertex_bindings;
 
+        bool keep_vertex_locations{false};
+
         /*!
-         * \brief Index of the byte in the vertex buffer where the next mesh can be uploaded to
-         *
-         * I'll eventually need a way to unload meshes, but that's more complicated
+         * \brief Everything the mesh store needs to know about a mesh that's in the vertex and index buffers
+         */
+        struct MeshRecord {
+            Mesh mesh;
+
+            /*!
+             * \brief Bounds of the mesh's vertices, computed when the mesh is added
+             */
+            BoundingBox bounds;
+
+            /*!
+             * \brief The mesh's indices, relative to the mesh's first vertex
+             *
+             * The index buffer holds indices that are offset by the mesh's first vertex, so moving a mesh's vertices means re-uploading its
+             * indices. We keep a copy on the CPU so we don't have to read them back from the GPU
+             */
+            Rx::Vector<Uint32> indices;
+
+            /*!
+             * \brief Locations of the mesh's vertices, so that the mesh's BVH can be built without reading the vertices back from the GPU.
+             * Only kept if the mesh was added while `keep_vertex_locations` was on, and only until the BVH is built
+             */
+            Rx::Vector<glm::vec3> locations;
+
+            Rx::Vector<MeshletBounds> meshlet_bounds;
+
+            /*!
+             * \brief Index of the mesh's MeshDequantization in the dequantization buffer. Only meaningful in a store of PackedVertices
+             */
+            Uint32 dequantization_idx{0};
+
+            /*!
+             * \brief BVH over the mesh's triangles, built by the first call to `get_mesh_bvh`
+             */
+            Rx::Ptr<MeshBvh> bvh;
+        };
+
+        /*!
+         * \brief Allocator for the vertex buffer, in units of vertices
          */
-        Uint32 next_free_vertex_byte{0};
+        RangeAllocator vertex_allocator;
 
         /*!
-         * \brief The offset in the vertex buffer, in vertices, where the next mesh's vertex data should start
+         * \brief Allocator for the index buffer, in units of indices
          */
-        Uint32 next_vertex_offset{0};
+        RangeAllocator index_allocator;
 
         /*!
-         * \brief The offset in the index buffer where the next mesh's indices should start
+         * \brief All the meshes in the mesh store, indexed by their first index
          */
-        Uint32 next_index_offset{0};
+        Rx::Map<Uint32, MeshRecord> meshes;
+
+        /*!
+         * \brief Map from a mesh's first vertex to its first index
+         */
+        Rx::Map<Uint32, Uint32> first_index_by_first_vertex;
+
+        /*!
+         * \brief Start of vertex ranges that are free on the CPU but might still be used by in-flight GPU frames, per frame slot
+         */
+        Rx::Vector<Rx::Vector<Uint32>> retired_vertex_ranges;
+
+        /*!
+         * \brief Start of index ranges that are free on the CPU but might still be used by in-flight GPU frames, per frame slot
+         */
+        Rx::Vector<Rx::Vector<Uint32>> retired_index_ranges;
+
+        /*!
+         * \brief Number of slots of the dequantization buffer that have ever been handed out
+         */
+        Uint32 num_used_dequantization_slots{0};
+
+        /*!
+         * \brief Slots of the dequantization buffer that no mesh uses
+         */
+        Rx::Vector<Uint32> free_dequantization_slots;
+
+        /*!
+         * \brief Slots of the dequantization buffer that are free on the CPU but might still be used by in-flight GPU frames, per frame
+         * slot
+         */
+        Rx::Vector<Rx::Vector<Uint32>> retired_dequantization_slots;
 
         friend class MeshUploader;
 
@@ -122,8 +352,46 @@ namespace sanity::engine::renderer {
          * \brief Adds new mesh data to the vertex and index buffers. Must be called after `begin_mesh_data_upload` and before
          * `end_mesh_data_upload`
          */
-        [[nodiscard]] Mesh add_mesh(const Rx::Vector<StandardVertex>& vertices,
-                                    const Rx::Vector<Uint32>& indices,
-                                    ID3D12GraphicsCommandList4* commands);
+        [[nodiscard]] MeshObject add_mesh(const StandardVertex* vertices,
+                                          Uint32 num_vertices,
+                                          const Uint32* indices,
+                                          Uint32 num_indices,
+                                          const MeshLod* lods,
+                                          Uint32 num_lods,
+                                          const MeshletBounds* meshlet_bounds,
+                                          Uint32 num_meshlets,
+                                          ID3D12GraphicsCommandList4* commands);
+
+        [[nodiscard]] MeshObject add_mesh(const PackedVertex* vertices,
+                                          Uint32 num_vertices,
+                                          const MeshDequantization& dequantization,
+                                          const Uint32* indices,
+                                          Uint32 num_indices,
+                                          const MeshLod* lods,
+                                          Uint32 num_lods,
+                                          const MeshletBounds* meshlet_bounds,
+                                          Uint32 num_meshlets,
+                                          ID3D12GraphicsCommandList4* commands);
+
+        /*!
+         * \brief Uploads a mesh's vertices and indices, and remembers everything about the mesh that the store needs
+         *
+         * \param vertices The mesh's vertices, which are in the store's vertex format
+         * \param bounds Bounds of the mesh's vertices
+         * \param locations Locations of the mesh's vertices, if the store keeps them
+         * \param dequantization_idx Index of the mesh's MeshDequantization, if the store holds PackedVertices
+         */
+        [[nodiscard]] MeshObject add_mesh_data(const void* vertices,
+                                               Uint32 num_vertices,
+                                               const Uint32* indices,
+                                               Uint32 num_indices,
+                                               const MeshLod* lods,
+                                               Uint32 num_lods,
+                                               const MeshletBounds* meshlet_bounds,
+                                               Uint32 num_meshlets,
+                                               const BoundingBox& bounds,
+                                               Rx::Vector<glm::vec3>&& locations,
+                                               Uint32 dequantization_idx,
+                                               ID3D12GraphicsCommandList4* commands);
     };
 } // namespace sanity::engine::renderer
@@ -0,0 +1,77 @@
+#include "meshlet_culler.hpp"
+
+#include "Tracy.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+
+namespace sanity::engine::renderer {
+    void MeshletCuller::begin_frame(const glm::mat4& view_projection_matrix_in, const glm::vec3& camera_location_in) {
+        view_projection_matrix = view_projection_matrix_in;
+        camera_location = camera_location_in;
+
+        visible_meshlets.clear();
+        stats = {};
+    }
+
+    void MeshletCuller::cull(const Rx::Vector<MeshletBounds>& bounds,
+                             const Uint32 first_meshlet,
+                             const Uint32 num_meshlets,
+                             const glm::mat4& model_matrix) {
+        ZoneScoped;
+
+        // Extract the side planes of the frustum in the mesh's space from the rows of the model-view-projection matrix, like
+        // FrustumCuller does in world space. Normalizing them makes the distance to a plane comparable with a sphere's radius
+        const auto model_view_projection_matrix = view_projection_matrix * model_matrix;
+        const auto row = [&](const Uint32 idx) {
+            return glm::vec4{model_view_projection_matrix[0][idx],
+                             model_view_projection_matrix[1][idx],
+                             model_view_projection_matrix[2][idx],
+                             model_view_projection_matrix[3][idx]};
+        };
+        glm::vec4 planes[] = {row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1)};
+        for(auto& plane : planes) {
+            const auto normal_length = glm::length(glm::vec3{plane});
+            if(normal_length > 0.0f) {
+                plane /= normal_length;
+            }
+        }
+
+        // A mirroring model matrix flips which side of each triangle faces the camera, so its normal cones can't be trusted
+        const auto can_cull_backfaces = glm::determinant(glm::mat3{model_matrix}) > 0.0f;
+        const auto local_camera_location = glm::vec3{glm::inverse(model_matrix) * glm::vec4{camera_location, 1.0f}};
+
+        stats.num_meshlets += num_meshlets;
+
+        for(auto meshlet = first_meshlet; meshlet < first_meshlet + num_meshlets; meshlet++) {
+            const auto& meshlet_bounds = bounds[meshlet];
+
+            auto is_in_frustum = true;
+            for(const auto& plane : planes) {
+                if(glm::dot(glm::vec3{plane}, meshlet_bounds.center) + plane.w < -meshlet_bounds.radius) {
+                    is_in_frustum = false;
+                    break;
+                }
+            }
+
+            if(!is_in_frustum) {
+                stats.num_frustum_culled++;
+                continue;
+            }
+
+            if(can_cull_backfaces) {
+                const auto apex_offset = meshlet_bounds.cone_apex - local_camera_location;
+                const auto apex_distance = glm::length(apex_offset);
+                if(apex_distance > 0.0f && glm::dot(apex_offset, meshlet_bounds.cone_axis) >= meshlet_bounds.cone_cutoff * apex_distance) {
+                    stats.num_backface_culled++;
+                    continue;
+                }
+            }
+
+            visible_meshlets.push_back(meshlet);
+        }
+    }
+
+    const Rx::Vector<Uint32>& MeshletCuller::get_visible_meshlets() const { return visible_meshlets; }
+
+    const MeshletCullingStats& MeshletCuller::get_stats() const { return stats; }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "glm/mat4x4.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    struct MeshletCullingStats {
+        Uint32 num_meshlets{0};
+
+        /*!
+         * \brief Meshlets that were outside the camera's frustum
+         */
+        Uint32 num_frustum_culled{0};
+
+        /*!
+         * \brief Meshlets that were inside the frustum, but whose triangles all faced away from the camera
+         */
+        Uint32 num_backface_culled{0};
+    };
+
+    /*!
+     * \brief Reference CPU implementation of meshlet culling, so that meshlet bounds can be checked and measured without a GPU
+     *
+     * Each meshlet's bounding sphere is tested against the frustum, and its normal cone against the camera's location. Meshlets are tested
+     * in their mesh's space, which keeps both tests exact under any model matrix
+     */
+    class MeshletCuller {
+    public:
+        /*!
+         * \brief Sets the camera to cull against, and clears the visible meshlets and stats
+         */
+        void begin_frame(const glm::mat4& view_projection_matrix, const glm::vec3& camera_location);
+
+        /*!
+         * \brief Culls the meshlets of one instance of a mesh, and adds the indices of the ones that pass to the visible meshlets
+         *
+         * \param bounds Bounds of meshlets, in the mesh's space. The meshlets of this mesh start at `first_meshlet`
+         */
+        void cull(const Rx::Vector<MeshletBounds>& bounds, Uint32 first_meshlet, Uint32 num_meshlets, const glm::mat4& model_matrix);
+
+        /*!
+         * \brief Indices of the meshlets that passed culling since `begin_frame`, in the order they were culled
+         */
+        [[nodiscard]] const Rx::Vector<Uint32>& get_visible_meshlets() const;
+
+        [[nodiscard]] const MeshletCullingStats& get_stats() const;
+
+    private:
+        glm::mat4 view_projection_matrix{1};
+
+        glm::vec3 camera_location{0};
+
+        Rx::Vector<Uint32> visible_meshlets;
+
+        MeshletCullingStats stats;
+    };
+} // namespace sanity::engine::renderer
@@ -0,0 +1,165 @@
+#include "model_matrix_store.hpp"
+
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "core/components.hpp"
+#include "entt/entity/registry.hpp"
+#include "rx/core/log.h"
+
+namespace sanity::engine::renderer {
+    RX_LOG("ModelMatrixStore", logger);
+
+    ModelMatrixStore::ModelMatrixStore(const Uint32 num_slots_in, const Uint32 num_frames)
+        : num_slots{num_slots_in}, dirty_slot_tracker{num_slots_in, num_frames} {}
+
+    void ModelMatrixStore::begin_update() {
+        cur_frame++;
+
+        stats.num_changed_matrices = 0;
+        stats.num_failed_allocations = 0;
+    }
+
+    Uint32 ModelMatrixStore::use_entity(const entt::entity entity) { return use_slot(slot_by_entity, entity, false); }
+
+    Uint32 ModelMatrixStore::use_derived_matrix(const entt::entity entity, const glm::mat4& matrix) {
+        const auto slot_idx = use_slot(derived_slot_by_entity, entity, true);
+        if(slot_idx != NO_SLOT) {
+            set_matrix(slot_idx, matrix);
+        }
+
+        return slot_idx;
+    }
+
+    void ModelMatrixStore::end_update(const TransformHierarchy& hierarchy, const entt::registry& registry) {
+        ZoneScoped;
+
+        // Node indices change whenever the hierarchy is re-sorted
+        const auto is_hierarchy_rebuilt = &hierarchy != last_hierarchy || hierarchy.get_num_rebuilds() != last_hierarchy_num_rebuilds;
+        last_hierarchy = &hierarchy;
+        last_hierarchy_num_rebuilds = hierarchy.get_num_rebuilds();
+
+        for(Uint32 slot_idx = 0; slot_idx < slots.size(); slot_idx++) {
+            auto& slot = slots[slot_idx];
+            if(!slot.is_allocated) {
+                continue;
+            }
+
+            if(slot.last_used_frame != cur_frame) {
+                free_slot(slot_idx);
+                continue;
+            }
+
+            if(slot.is_derived) {
+                continue;
+            }
+
+            if(is_hierarchy_rebuilt || slot.node_idx == TransformHierarchy::NO_NODE) {
+                slot.node_idx = hierarchy.get_node_idx(slot.entity);
+            }
+
+            if(slot.node_idx != TransformHierarchy::NO_NODE) {
+                // A re-sorted hierarchy may have moved the entity to a node which wasn't updated, so check the matrix anyways
+                if(slot.is_new || is_hierarchy_rebuilt || hierarchy.is_node_updated(slot.node_idx)) {
+                    set_matrix(slot_idx, hierarchy.get_node_world_matrix(slot.node_idx));
+                }
+
+            } else if(const auto* transform = registry.try_get<TransformComponent>(slot.entity); transform != nullptr) {
+                set_matrix(slot_idx, transform->get_model_matrix(registry));
+
+            } else {
+                set_matrix(slot_idx, glm::mat4{1});
+            }
+        }
+
+        if(stats.num_failed_allocations > 0 && !has_reported_full) {
+            logger->warning("All %u model matrix slots are taken, so %u entities can't be drawn. Increase render.MaxDrawcallsPerFrame",
+                            num_slots,
+                            stats.num_failed_allocations);
+            has_reported_full = true;
+        }
+    }
+
+    void ModelMatrixStore::flush_frame(const Uint32 frame_idx, const Rx::Function<void(Uint32, const glm::mat4*, Uint32)>& write_range) {
+        ZoneScoped;
+
+        stats.num_written_ranges = 0;
+        stats.num_written_matrices = dirty_slot_tracker.flush_frame(frame_idx, [&](const Uint32 first_slot, const Uint32 num_dirty_slots) {
+            write_range(first_slot, &matrices[first_slot], num_dirty_slots);
+            stats.num_written_ranges++;
+        });
+        stats.num_bytes_uploaded = static_cast<Uint64>(stats.num_written_matrices) * sizeof(glm::mat4);
+    }
+
+    Uint32 ModelMatrixStore::get_slot(const entt::entity entity) const {
+        const auto* slot_idx = slot_by_entity.find(static_cast<Uint32>(entity));
+        return slot_idx != nullptr ? *slot_idx : NO_SLOT;
+    }
+
+    Uint32 ModelMatrixStore::get_derived_slot(const entt::entity entity) const {
+        const auto* slot_idx = derived_slot_by_entity.find(static_cast<Uint32>(entity));
+        return slot_idx != nullptr ? *slot_idx : NO_SLOT;
+    }
+
+    const ModelMatrixStats& ModelMatrixStore::get_stats() const { return stats; }
+
+    Uint32 ModelMatrixStore::use_slot(Rx::Map<Uint32, Uint32>& slot_by_key, const entt::entity entity, const bool is_derived) {
+        const auto key = static_cast<Uint32>(entity);
+        if(const auto* slot_idx = slot_by_key.find(key); slot_idx != nullptr) {
+            slots[*slot_idx].last_used_frame = cur_frame;
+            return *slot_idx;
+        }
+
+        Uint32 slot_idx;
+        if(!free_slots.is_empty()) {
+            slot_idx = free_slots.last();
+            free_slots.pop_back();
+
+        } else if(slots.size() < num_slots) {
+            slot_idx = static_cast<Uint32>(slots.size());
+            slots.push_back(Slot{.entity = entity});
+            matrices.push_back(glm::mat4{1});
+
+        } else {
+            stats.num_failed_allocations++;
+            return NO_SLOT;
+        }
+
+        slots[slot_idx] = Slot{.entity = entity, .last_used_frame = cur_frame, .is_allocated = true, .is_derived = is_derived};
+        slot_by_key.insert(key, slot_idx);
+        stats.num_used_slots++;
+
+        return slot_idx;
+    }
+
+    void ModelMatrixStore::set_matrix(const Uint32 slot_idx, const glm::mat4& matrix) {
+        auto& slot = slots[slot_idx];
+        auto& old_matrix = matrices[slot_idx];
+
+        // Compare the bytes rather than the floats so that a NaN in the matrix can't make it look different every frame
+        if(!slot.is_new && memcmp(&old_matrix, &matrix, sizeof(glm::mat4)) == 0) {
+            return;
+        }
+
+        old_matrix = matrix;
+        slot.is_new = false;
+
+        dirty_slot_tracker.mark_dirty(slot_idx);
+        stats.num_changed_matrices++;
+    }
+
+    void ModelMatrixStore::free_slot(const Uint32 slot_idx) {
+        auto& slot = slots[slot_idx];
+        const auto key = static_cast<Uint32>(slot.entity);
+        if(slot.is_derived) {
+            derived_slot_by_entity.erase(key);
+        } else {
+            slot_by_entity.erase(key);
+        }
+
+        // Freed slots aren't written, because no draw refers to them until they're reused - and reusing a slot rewrites its matrix
+        slot.is_allocated = false;
+        free_slots.push_back(slot_idx);
+        stats.num_used_slots--;
+    }
+} // namespace sanity::engine::renderer
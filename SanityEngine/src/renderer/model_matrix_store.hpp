@@ -0,0 +1,174 @@
+#pragma once
+
+#include "core/transform_hierarchy.hpp"
+#include "core/types.hpp"
+#include "entt/entity/fwd.hpp"
+#include "glm/mat4x4.hpp"
+#include "renderer/bindless_descriptor_tracker.hpp"
+#include "rx/core/function.h"
+#include "rx/core/map.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    struct ModelMatrixStats {
+        Uint32 num_used_slots{0};
+
+        /*!
+         * \brief Number of slots whose matrix changed in the last update, including the slots that were new
+         */
+        Uint32 num_changed_matrices{0};
+
+        /*!
+         * \brief Number of matrices written into the last flushed frame's buffer
+         */
+        Uint32 num_written_matrices{0};
+
+        /*!
+         * \brief Number of contiguous ranges that the written matrices were grouped into
+         */
+        Uint32 num_written_ranges{0};
+
+        Uint64 num_bytes_uploaded{0};
+
+        /*!
+         * \brief Number of entities that needed a slot in the last update, but didn't get one because all the slots were taken
+         */
+        Uint32 num_failed_allocations{0};
+    };
+
+    /*!
+     * \brief Keeps the model matrices of drawn entities in persistent slots, so that only matrices which changed get uploaded
+     *
+     * Every frame, the renderer tells the store which entities it's going to draw. Entities get a slot the first frame they're drawn
+     * and keep it until a frame where they aren't, so every pass that draws an entity uses the same slot. A slot either holds its
+     * entity's world matrix, which is picked up from the TransformHierarchy when the hierarchy recomputes it, or a matrix derived from
+     * the entity that the renderer provides each frame, such as an outline's
+     *
+     * Every frame in flight has its own copy of the model matrix buffer, so a matrix which changes is written into each copy the next
+     * time that frame is recorded. This class only does the bookkeeping - it knows nothing about D3D12
+     */
+    class ModelMatrixStore {
+    public:
+        static constexpr Uint32 NO_SLOT = 0xFFFFFFFF;
+
+        ModelMatrixStore(Uint32 num_slots_in, Uint32 num_frames);
+
+        ModelMatrixStore(const ModelMatrixStore& other) = delete;
+        ModelMatrixStore& operator=(const ModelMatrixStore& other) = delete;
+
+        ModelMatrixStore(ModelMatrixStore&& old) noexcept = default;
+        ModelMatrixStore& operator=(ModelMatrixStore&& old) noexcept = default;
+
+        ~ModelMatrixStore() = default;
+
+        /*!
+         * \brief Starts this frame's update. Every entity that will be drawn this frame must then go through `use_entity` or
+         * `use_derived_matrix` before `end_update`
+         */
+        void begin_update();
+
+        /*!
+         * \brief Records that an entity will be drawn with its world matrix this frame, giving it a slot if it doesn't have one yet
+         *
+         * \return The entity's slot, or NO_SLOT if all the slots are taken
+         */
+        Uint32 use_entity(entt::entity entity);
+
+        /*!
+         * \brief Records that an entity will be drawn with a matrix other than its world matrix this frame, such as its outline's. Each
+         * entity can have one derived matrix, in a slot of its own. The matrix is only uploaded if it differs from last frame's
+         *
+         * \return The slot for the derived matrix, or NO_SLOT if all the slots are taken
+         */
+        Uint32 use_derived_matrix(entt::entity entity, const glm::mat4& matrix);
+
+        /*!
+         * \brief Frees the slots of entities that weren't used this frame, and picks up the world matrices that changed
+         *
+         * Must be called after the hierarchy's update for this frame
+         */
+        void end_update(const TransformHierarchy& hierarchy, const entt::registry& registry);
+
+        /*!
+         * \brief Calls `write_range` for every run of consecutive slots whose matrix changed since the last time this was called for
+         * the frame, then marks the frame as up to date
+         *
+         * \param write_range Function which receives the first slot in a run, the matrices of the run's slots, and the number of slots
+         * in the run
+         */
+        void flush_frame(Uint32 frame_idx, const Rx::Function<void(Uint32, const glm::mat4*, Uint32)>& write_range);
+
+        /*!
+         * \brief Gets the slot with the entity's world matrix, or NO_SLOT if the entity wasn't used in the last update
+         */
+        [[nodiscard]] Uint32 get_slot(entt::entity entity) const;
+
+        /*!
+         * \brief Gets the slot with the entity's derived matrix, or NO_SLOT if the entity had no derived matrix in the last update
+         */
+        [[nodiscard]] Uint32 get_derived_slot(entt::entity entity) const;
+
+        /*!
+         * \brief Stats of the last update and the last flushed frame
+         */
+        [[nodiscard]] const ModelMatrixStats& get_stats() const;
+
+    private:
+        struct Slot {
+            entt::entity entity;
+
+            /*!
+             * \brief The entity's node in the transform hierarchy, or NO_NODE if it hasn't been looked up since the hierarchy was last
+             * re-sorted
+             */
+            Uint32 node_idx{TransformHierarchy::NO_NODE};
+
+            Uint32 last_used_frame{0};
+
+            bool is_allocated{false};
+
+            bool is_derived{false};
+
+            /*!
+             * \brief Whether the slot's matrix hasn't been written yet
+             */
+            bool is_new{true};
+        };
+
+        Uint32 num_slots;
+
+        Rx::Vector<Slot> slots;
+
+        /*!
+         * \brief The matrix in each slot. The store compares against these to tell if a matrix actually changed
+         */
+        Rx::Vector<glm::mat4> matrices;
+
+        Rx::Vector<Uint32> free_slots;
+
+        Rx::Map<Uint32, Uint32> slot_by_entity;
+
+        Rx::Map<Uint32, Uint32> derived_slot_by_entity;
+
+        /*!
+         * \brief The same per-frame dirty tracking as the bindless resource array, over slots instead of descriptors
+         */
+        BindlessDescriptorTracker dirty_slot_tracker;
+
+        Uint32 cur_frame{0};
+
+        const TransformHierarchy* last_hierarchy{nullptr};
+
+        Uint32 last_hierarchy_num_rebuilds{0};
+
+        ModelMatrixStats stats;
+
+        bool has_reported_full{false};
+
+        [[nodiscard]] Uint32 use_slot(Rx::Map<Uint32, Uint32>& slot_by_key, entt::entity entity, bool is_derived);
+
+        void set_matrix(Uint32 slot_idx, const glm::mat4& matrix);
+
+        void free_slot(Uint32 slot_idx);
+    };
+} // namespace sanity::engine::renderer
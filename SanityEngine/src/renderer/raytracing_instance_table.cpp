@@ -0,0 +1,116 @@
+#include "raytracing_instance_table.hpp"
+
+#include <algorithm>
+
+#include "rx/core/log.h"
+
+namespace sanity::engine::renderer {
+    RX_LOG("RaytracingInstanceTable", logger);
+
+    Uint32 RaytracingInstanceTable::add_instance() {
+        Uint32 slot;
+        if(!free_slots.is_empty()) {
+            slot = free_slots.last();
+            free_slots.pop_back();
+            active_slots[slot] = true;
+
+        } else {
+            slot = static_cast<Uint32>(active_slots.size());
+            active_slots.push_back(true);
+            changed_flags.push_back(false);
+            slot_generations.push_back(0);
+        }
+
+        num_topology_changes++;
+        mark_slot_changed(slot);
+
+        return slot;
+    }
+
+    void RaytracingInstanceTable::remove_instance(const Uint32 slot) {
+        if(!is_instance_active(slot)) {
+            logger->error("Can not remove raytracing instance %u: it's not in the instance table", slot);
+            return;
+        }
+
+        active_slots[slot] = false;
+        slot_generations[slot]++;
+        free_slots.push_back(slot);
+
+        num_topology_changes++;
+        mark_slot_changed(slot);
+    }
+
+    void RaytracingInstanceTable::mark_instance_changed(const Uint32 slot) {
+        if(!is_instance_active(slot)) {
+            logger->error("Can not update raytracing instance %u: it's not in the instance table", slot);
+            return;
+        }
+
+        mark_slot_changed(slot);
+    }
+
+    bool RaytracingInstanceTable::is_instance_active(const Uint32 slot) const { return slot < active_slots.size() && active_slots[slot]; }
+
+    Uint32 RaytracingInstanceTable::get_slot_generation(const Uint32 slot) const { return slot_generations[slot]; }
+
+    Uint32 RaytracingInstanceTable::get_num_slots() const { return static_cast<Uint32>(active_slots.size()); }
+
+    Uint32 RaytracingInstanceTable::get_num_active_instances() const {
+        return static_cast<Uint32>(active_slots.size() - free_slots.size());
+    }
+
+    RaytracingSceneUpdateType RaytracingInstanceTable::get_update_type(const Float32 rebuild_threshold) const {
+        // The structure's instance count is fixed when it's built, so new slots always need a rebuild
+        if(active_slots.size() != num_slots_at_last_build) {
+            return RaytracingSceneUpdateType::Rebuild;
+        }
+
+        if(changed_slots.is_empty()) {
+            return RaytracingSceneUpdateType::None;
+        }
+
+        if(static_cast<Float32>(num_topology_changes) > rebuild_threshold * static_cast<Float32>(active_slots.size())) {
+            return RaytracingSceneUpdateType::Rebuild;
+        }
+
+        return RaytracingSceneUpdateType::Refit;
+    }
+
+    Rx::Vector<RaytracingInstanceRange> RaytracingInstanceTable::get_changed_ranges() const {
+        auto sorted_slots = changed_slots;
+        std::sort(sorted_slots.data(), sorted_slots.data() + sorted_slots.size());
+
+        Rx::Vector<RaytracingInstanceRange> ranges;
+        sorted_slots.each_fwd([&](const Uint32 slot) {
+            if(!ranges.is_empty()) {
+                auto& range = ranges.last();
+                if(range.first_slot + range.num_slots == slot) {
+                    range.num_slots++;
+                    return;
+                }
+            }
+
+            ranges.push_back(RaytracingInstanceRange{.first_slot = slot, .num_slots = 1});
+        });
+
+        return ranges;
+    }
+
+    void RaytracingInstanceTable::finish_update(const RaytracingSceneUpdateType update_type) {
+        if(update_type == RaytracingSceneUpdateType::Rebuild) {
+            num_slots_at_last_build = static_cast<Uint32>(active_slots.size());
+            num_topology_changes = 0;
+        }
+
+        changed_slots.each_fwd([&](const Uint32 slot) { changed_flags[slot] = false; });
+        changed_slots.clear();
+    }
+
+    void RaytracingInstanceTable::mark_slot_changed(const Uint32 slot) {
+        if(!changed_flags[slot]) {
+            changed_flags[slot] = true;
+            changed_slots.push_back(slot);
+        }
+    }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief What the top-level acceleration structure needs to catch up with the instance table
+     */
+    enum class RaytracingSceneUpdateType {
+        /*!
+         * \brief Nothing changed since the last update
+         */
+        None,
+
+        /*!
+         * \brief The slots that changed can be refit into the existing acceleration structure
+         */
+        Refit,
+
+        /*!
+         * \brief The acceleration structure must be built from scratch, because the number of slots changed or too many instances were
+         * added or removed since the last build
+         */
+        Rebuild,
+    };
+
+    /*!
+     * \brief A range of consecutive instance slots
+     */
+    struct RaytracingInstanceRange {
+        Uint32 first_slot{0};
+
+        Uint32 num_slots{0};
+    };
+
+    /*!
+     * \brief Hands out stable slots for the instances of the top-level acceleration structure, and tracks which slots changed since the
+     * structure was last updated
+     *
+     * A slot keeps its index for as long as its instance lives, so the instance descs can live in one persistent buffer and only the
+     * changed ones need to be written. Removed instances leave a hole that the next added instance fills. This class only does the
+     * bookkeeping - the renderer owns the instance data and the GPU resources, so the table can be driven without a GPU around
+     */
+    class RaytracingInstanceTable {
+    public:
+        /*!
+         * \brief Takes a slot for a new instance, reusing the slot of a removed instance if there is one
+         */
+        [[nodiscard]] Uint32 add_instance();
+
+        /*!
+         * \brief Frees an instance's slot and bumps its generation. The slot stays in the acceleration structure as a hole until it's
+         * reused
+         */
+        void remove_instance(Uint32 slot);
+
+        /*!
+         * \brief Records that an instance changed in a way that a refit can handle, such as a new transform
+         */
+        void mark_instance_changed(Uint32 slot);
+
+        [[nodiscard]] bool is_instance_active(Uint32 slot) const;
+
+        /*!
+         * \brief Gets how many times the slot's instance has been removed, so that stale references to the slot can be told apart from
+         * references to its current instance
+         */
+        [[nodiscard]] Uint32 get_slot_generation(Uint32 slot) const;
+
+        /*!
+         * \brief Number of slots, including the holes that removed instances left. The acceleration structure has one instance per slot
+         */
+        [[nodiscard]] Uint32 get_num_slots() const;
+
+        [[nodiscard]] Uint32 get_num_active_instances() const;
+
+        /*!
+         * \brief Decides how to bring the acceleration structure up to date
+         *
+         * \param rebuild_threshold Fraction of the slots which may have had instances added or removed since the last build before the
+         * structure is rebuilt rather than refit, because refitting a structure to different instances makes it slower to trace against
+         */
+        [[nodiscard]] RaytracingSceneUpdateType get_update_type(Float32 rebuild_threshold) const;
+
+        /*!
+         * \brief Gets the slots that changed since the last update, sorted and merged into ranges of consecutive slots. The instance
+         * descs of the other slots are still in the instance buffer, so even a rebuild only needs these written - unless the buffer is
+         * new
+         */
+        [[nodiscard]] Rx::Vector<RaytracingInstanceRange> get_changed_ranges() const;
+
+        /*!
+         * \brief Records that the acceleration structure has caught up with the instance table
+         */
+        void finish_update(RaytracingSceneUpdateType update_type);
+
+    private:
+        /*!
+         * \brief Whether each slot holds a live instance
+         */
+        Rx::Vector<bool> active_slots;
+
+        /*!
+         * \brief Whether each slot is in `changed_slots`
+         */
+        Rx::Vector<bool> changed_flags;
+
+        Rx::Vector<Uint32> slot_generations;
+
+        Rx::Vector<Uint32> changed_slots;
+
+        Rx::Vector<Uint32> free_slots;
+
+        /*!
+         * \brief Number of slots when the acceleration structure was last built. Zero if it's never been built
+         */
+        Uint32 num_slots_at_last_build{0};
+
+        /*!
+         * \brief Number of instances added or removed since the acceleration structure was last built
+         */
+        Uint32 num_topology_changes{0};
+
+        void mark_slot_changed(Uint32 slot);
+    };
+} // namespace sanity::engine::renderer
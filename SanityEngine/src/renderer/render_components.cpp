@@ -18,6 +18,8 @@ namespace sanity::engine::renderer {
 
     void draw_component_properties(RaytracingObjectComponent& raytracing_object) {
         ImGui::LabelText("Handle", "%#010x", raytracing_object.as_handle.index);
+        ImGui::LabelText("Object", "%#010x", raytracing_object.object.slot);
+        ImGui::LabelText("Object Generation", "%u", raytracing_object.object.generation);
     }
 
     void draw_component_properties(CameraComponent& camera) {
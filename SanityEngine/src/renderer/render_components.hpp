@@ -7,6 +7,7 @@
 #include "renderer/lights.hpp"
 #include "renderer/mesh.hpp"
 #include "renderer/rhi/raytracing_structs.hpp"
+#include "rx/core/optional.h"
 
 namespace sanity::engine::renderer {
     /*!
@@ -38,6 +39,13 @@ namespace sanity::engine::renderer {
          */
         Mesh mesh;
 
+        /*!
+         * \brief Bounds of the mesh, in the mesh's local space
+         *
+         * Objects without bounds use the bounds that the mesh store which holds their mesh computed for it
+         */
+        Rx::Optional<BoundingBox> bounds;
+
         /*!
          * \brief Material to use when rendering this mesh
          */
@@ -76,6 +84,12 @@ namespace sanity::engine::renderer {
 
     struct __declspec(uuid("{BB1E8A88-79FE-4934-8335-E5226022F441}")) RaytracingObjectComponent {
         RaytracingAsHandle as_handle{};
+
+        /*!
+         * \brief The entity's object in the renderer's raytracing scene. The renderer moves the object along with the entity's parent,
+         * since the acceleration structure already has the entity's local transform, and removes the object once the component is gone
+         */
+        RaytracingObjectHandle object{};
     };
 
     /*!
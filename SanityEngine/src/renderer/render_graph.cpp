@@ -0,0 +1,319 @@
+#include "render_graph.hpp"
+
+#include <functional>
+#include <queue>
+
+#include "Tracy.hpp"
+#include "rx/core/log.h"
+#include "rx/core/map.h"
+#include "rx/core/optional.h"
+#include "rx/core/utility/pair.h"
+
+namespace sanity::engine::renderer {
+    RX_LOG("RenderGraphCompiler", logger);
+
+    RenderGraphCompiler::RenderGraphCompiler(const Uint32 write_states_in, const Uint32 initial_state_in, const bool split_barriers_in)
+        : write_states{write_states_in}, initial_state{initial_state_in}, split_barriers{split_barriers_in} {}
+
+    const CompiledRenderGraph& RenderGraphCompiler::compile(const Rx::Vector<RenderGraphPassDescription>& passes) {
+        if(has_compiled_graph && matches_cached_passes(passes)) {
+            return compiled_graph;
+        }
+
+        ZoneScoped;
+
+        cached_passes = passes;
+        compiled_graph = {};
+
+        const auto live_passes = find_live_passes();
+        compiled_graph.pass_order = sort_passes(live_passes);
+        compiled_graph.num_culled_passes = static_cast<Uint32>(passes.size() - compiled_graph.pass_order.size());
+
+        const auto merged_usages = merge_read_states();
+        place_barriers(merged_usages);
+
+        has_compiled_graph = true;
+        num_compiles++;
+
+        logger->verbose("Compiled render graph: %u passes, %u culled, %u barriers (%u split)",
+                        compiled_graph.pass_order.size(),
+                        compiled_graph.num_culled_passes,
+                        compiled_graph.num_barriers,
+                        compiled_graph.num_split_barriers);
+
+        return compiled_graph;
+    }
+
+    void RenderGraphCompiler::set_split_barriers(const bool split_barriers_in) {
+        if(split_barriers_in != split_barriers) {
+            split_barriers = split_barriers_in;
+            has_compiled_graph = false;
+        }
+    }
+
+    Uint32 RenderGraphCompiler::get_num_compiles() const { return num_compiles; }
+
+    bool RenderGraphCompiler::is_write_state(const Uint32 state) const { return (state & write_states) != 0; }
+
+    bool RenderGraphCompiler::is_read_only_usage(const RenderGraphResourceUsage& usage) const {
+        // The pass transitions the resource itself if the begin and end states differ, so it needs to see exactly the states it declared
+        return usage.begin_state == usage.end_state && usage.begin_state != initial_state && !is_write_state(usage.begin_state);
+    }
+
+    bool RenderGraphCompiler::matches_cached_passes(const Rx::Vector<RenderGraphPassDescription>& passes) const {
+        if(passes.size() != cached_passes.size()) {
+            return false;
+        }
+
+        for(auto pass_idx = 0u; pass_idx < passes.size(); pass_idx++) {
+            const auto& pass = passes[pass_idx];
+            const auto& cached_pass = cached_passes[pass_idx];
+            if(pass.has_side_effects != cached_pass.has_side_effects || pass.resource_usages.size() != cached_pass.resource_usages.size()) {
+                return false;
+            }
+
+            for(auto usage_idx = 0u; usage_idx < pass.resource_usages.size(); usage_idx++) {
+                const auto& usage = pass.resource_usages[usage_idx];
+                const auto& cached_usage = cached_pass.resource_usages[usage_idx];
+                if(usage.resource != cached_usage.resource || usage.begin_state != cached_usage.begin_state ||
+                   usage.end_state != cached_usage.end_state) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    Rx::Vector<Uint8> RenderGraphCompiler::find_live_passes() const {
+        const auto num_passes = static_cast<Uint32>(cached_passes.size());
+        Rx::Vector<Uint8> live_passes;
+        live_passes.resize(num_passes, 0);
+
+        // Resources which a live pass later in the frame uses. We don't know if a pass reads a render target before writing to it, so any
+        // usage of a resource keeps its earlier writers alive
+        Rx::Map<Uint32, bool> needed_resources;
+
+        for(auto pass_idx = num_passes; pass_idx > 0; pass_idx--) {
+            const auto& pass = cached_passes[pass_idx - 1];
+
+            auto is_live = pass.has_side_effects;
+            pass.resource_usages.each_fwd([&](const RenderGraphResourceUsage& usage) {
+                const auto writes_resource = is_write_state(usage.begin_state) || is_write_state(usage.end_state);
+                if(writes_resource && needed_resources.find(usage.resource) != nullptr) {
+                    is_live = true;
+                }
+            });
+
+            if(is_live) {
+                live_passes[pass_idx - 1] = 1;
+                pass.resource_usages.each_fwd([&](const RenderGraphResourceUsage& usage) {
+                    if(needed_resources.find(usage.resource) == nullptr) {
+                        needed_resources.insert(usage.resource, true);
+                    }
+                });
+            }
+        }
+
+        return live_passes;
+    }
+
+    Rx::Vector<Uint32> RenderGraphCompiler::sort_passes(const Rx::Vector<Uint8>& live_passes) const {
+        const auto num_passes = static_cast<Uint32>(cached_passes.size());
+
+        struct ResourceAccesses {
+            Rx::Optional<Uint32> last_writer;
+            Rx::Vector<Uint32> readers_since_last_write;
+        };
+
+        Rx::Map<Uint32, ResourceAccesses> accesses_by_resource;
+        Rx::Vector<Rx::Vector<Uint32>> dependent_passes{num_passes};
+        Rx::Vector<Uint32> num_dependencies;
+        num_dependencies.resize(num_passes, 0);
+
+        const auto add_dependency = [&](const Uint32 from_pass, const Uint32 to_pass) {
+            if(!dependent_passes[from_pass].find(to_pass)) {
+                dependent_passes[from_pass].push_back(to_pass);
+                num_dependencies[to_pass]++;
+            }
+        };
+
+        for(auto pass_idx = 0u; pass_idx < num_passes; pass_idx++) {
+            if(live_passes[pass_idx] == 0) {
+                continue;
+            }
+
+            cached_passes[pass_idx].resource_usages.each_fwd([&](const RenderGraphResourceUsage& usage) {
+                auto* accesses = accesses_by_resource.find(usage.resource);
+                if(accesses == nullptr) {
+                    accesses = accesses_by_resource.insert(usage.resource, {});
+                }
+
+                if(accesses->last_writer) {
+                    add_dependency(*accesses->last_writer, pass_idx);
+                }
+
+                if(is_write_state(usage.begin_state) || is_write_state(usage.end_state)) {
+                    accesses->readers_since_last_write.each_fwd([&](const Uint32 reader) { add_dependency(reader, pass_idx); });
+                    accesses->readers_since_last_write.clear();
+                    accesses->last_writer = pass_idx;
+
+                } else {
+                    accesses->readers_since_last_write.push_back(pass_idx);
+                }
+            });
+        }
+
+        // Kahn's algorithm. Always picking the ready pass that was declared first keeps independent passes in declaration order
+        std::priority_queue<Uint32, std::vector<Uint32>, std::greater<>> ready_passes;
+        for(auto pass_idx = 0u; pass_idx < num_passes; pass_idx++) {
+            if(live_passes[pass_idx] != 0 && num_dependencies[pass_idx] == 0) {
+                ready_passes.push(pass_idx);
+            }
+        }
+
+        Rx::Vector<Uint32> pass_order;
+        while(!ready_passes.empty()) {
+            const auto pass_idx = ready_passes.top();
+            ready_passes.pop();
+
+            pass_order.push_back(pass_idx);
+
+            dependent_passes[pass_idx].each_fwd([&](const Uint32 dependent_pass) {
+                num_dependencies[dependent_pass]--;
+                if(num_dependencies[dependent_pass] == 0) {
+                    ready_passes.push(dependent_pass);
+                }
+            });
+        }
+
+        return pass_order;
+    }
+
+    Rx::Vector<Rx::Vector<RenderGraphResourceUsage>> RenderGraphCompiler::merge_read_states() const {
+        const auto& pass_order = compiled_graph.pass_order;
+
+        Rx::Vector<Rx::Vector<RenderGraphResourceUsage>> merged_usages;
+        merged_usages.reserve(pass_order.size());
+
+        // Position in `pass_order` and index in the pass's usages of every usage of each resource, in execution order
+        Rx::Map<Uint32, Rx::Vector<Rx::Pair<Uint32, Uint32>>> usages_by_resource;
+
+        for(auto position = 0u; position < pass_order.size(); position++) {
+            const auto& usages = cached_passes[pass_order[position]].resource_usages;
+            merged_usages.push_back(usages);
+
+            for(auto usage_idx = 0u; usage_idx < usages.size(); usage_idx++) {
+                auto* resource_usages = usages_by_resource.find(usages[usage_idx].resource);
+                if(resource_usages == nullptr) {
+                    resource_usages = usages_by_resource.insert(usages[usage_idx].resource, {});
+                }
+
+                resource_usages->push_back(Rx::Pair{position, usage_idx});
+            }
+        }
+
+        usages_by_resource.each_pair([&](const Uint32 /* resource */, const Rx::Vector<Rx::Pair<Uint32, Uint32>>& resource_usages) {
+            Uint32 run_start = 0;
+            while(run_start < resource_usages.size()) {
+                const auto& first_usage = merged_usages[resource_usages[run_start].first][resource_usages[run_start].second];
+                if(!is_read_only_usage(first_usage)) {
+                    run_start++;
+                    continue;
+                }
+
+                auto combined_state = 0u;
+                auto run_end = run_start;
+                while(run_end < resource_usages.size()) {
+                    const auto& usage = merged_usages[resource_usages[run_end].first][resource_usages[run_end].second];
+                    if(!is_read_only_usage(usage)) {
+                        break;
+                    }
+
+                    combined_state |= usage.begin_state;
+                    run_end++;
+                }
+
+                for(auto i = run_start; i < run_end; i++) {
+                    auto& usage = merged_usages[resource_usages[i].first][resource_usages[i].second];
+                    usage.begin_state = combined_state;
+                    usage.end_state = combined_state;
+                }
+
+                run_start = run_end;
+            }
+        });
+
+        return merged_usages;
+    }
+
+    void RenderGraphCompiler::place_barriers(const Rx::Vector<Rx::Vector<RenderGraphResourceUsage>>& merged_usages) {
+        struct ResourceTracking {
+            Uint32 state{0};
+
+            /*!
+             * \brief Position in the pass order of the last pass which used the resource
+             */
+            Uint32 last_use{0};
+        };
+
+        auto& batches = compiled_graph.barrier_batches;
+        batches.resize(compiled_graph.pass_order.size() + 1);
+
+        const auto add_barrier = [&](const Uint32 batch_idx, const RenderGraphBarrier& barrier) {
+            batches[batch_idx].push_back(barrier);
+            compiled_graph.num_barriers++;
+        };
+
+        Rx::Map<Uint32, ResourceTracking> tracking_by_resource;
+
+        for(auto position = 0u; position < merged_usages.size(); position++) {
+            merged_usages[position].each_fwd([&](const RenderGraphResourceUsage& usage) {
+                auto* tracking = tracking_by_resource.find(usage.resource);
+                if(tracking == nullptr) {
+                    if(usage.begin_state != initial_state) {
+                        add_barrier(position,
+                                    {.resource = usage.resource, .state_before = initial_state, .state_after = usage.begin_state});
+                    }
+
+                    tracking_by_resource.insert(usage.resource, {.state = usage.end_state, .last_use = position});
+                    return;
+                }
+
+                if(tracking->state != usage.begin_state) {
+                    const auto barrier = RenderGraphBarrier{.resource = usage.resource,
+                                                            .state_before = tracking->state,
+                                                            .state_after = usage.begin_state};
+
+                    if(split_barriers && tracking->last_use + 1 < position) {
+                        // There's at least one pass between the last use and this one. Begin the transition right after the last use, so
+                        // the GPU can work on it while it executes the passes in between
+                        auto begin_barrier = barrier;
+                        begin_barrier.type = RenderGraphBarrierType::SplitBegin;
+                        add_barrier(tracking->last_use + 1, begin_barrier);
+
+                        auto end_barrier = barrier;
+                        end_barrier.type = RenderGraphBarrierType::SplitEnd;
+                        add_barrier(position, end_barrier);
+
+                        compiled_graph.num_split_barriers++;
+
+                    } else {
+                        add_barrier(position, barrier);
+                    }
+                }
+
+                tracking->state = usage.end_state;
+                tracking->last_use = position;
+            });
+        }
+
+        // Return everything to the initial state right after its last use, so that the next frame can make the same assumptions as this
+        // one
+        tracking_by_resource.each_pair([&](const Uint32 resource, const ResourceTracking& tracking) {
+            if(tracking.state != initial_state) {
+                add_barrier(tracking.last_use + 1, {.resource = resource, .state_before = tracking.state, .state_after = initial_state});
+            }
+        });
+    }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief How a render pass uses one resource
+     *
+     * The render graph doesn't know anything about D3D12. Resources are plain IDs, and states are bitmasks which the graph only compares
+     * and combines
+     */
+    struct RenderGraphResourceUsage {
+        Uint32 resource{0};
+
+        /*!
+         * \brief The state that the resource must be in when the pass begins
+         */
+        Uint32 begin_state{0};
+
+        /*!
+         * \brief The state that the pass leaves the resource in
+         */
+        Uint32 end_state{0};
+    };
+
+    struct RenderGraphPassDescription {
+        Rx::Vector<RenderGraphResourceUsage> resource_usages;
+
+        /*!
+         * \brief Whether the pass does something that the graph can't see, such as writing to a resource that isn't declared or that's
+         * read next frame. Passes without side effects are culled if no live pass reads what they write
+         */
+        bool has_side_effects{true};
+    };
+
+    enum class RenderGraphBarrierType {
+        /*!
+         * \brief A barrier which completes the transition right away
+         */
+        Full,
+
+        /*!
+         * \brief Start of a split barrier. It's issued right after the last pass which used the resource in its old state
+         */
+        SplitBegin,
+
+        /*!
+         * \brief End of a split barrier. It's issued right before the first pass which uses the resource in its new state
+         */
+        SplitEnd,
+    };
+
+    struct RenderGraphBarrier {
+        Uint32 resource{0};
+
+        Uint32 state_before{0};
+
+        Uint32 state_after{0};
+
+        RenderGraphBarrierType type{RenderGraphBarrierType::Full};
+    };
+
+    struct CompiledRenderGraph {
+        /*!
+         * \brief Indices of the passes to execute, in the order to execute them. Culled passes are not present
+         */
+        Rx::Vector<Uint32> pass_order;
+
+        /*!
+         * \brief Barriers to issue before each pass in `pass_order`, plus one final batch of barriers to issue after the last pass
+         */
+        Rx::Vector<Rx::Vector<RenderGraphBarrier>> barrier_batches;
+
+        Uint32 num_culled_passes{0};
+
+        Uint32 num_barriers{0};
+
+        /*!
+         * \brief Number of barriers which were split into a begin and an end. Both halves are counted in `num_barriers`
+         */
+        Uint32 num_split_barriers{0};
+    };
+
+    /*!
+     * \brief Turns a list of render passes and the resource usages they declared into an execution order with all the barriers between
+     * the passes
+     *
+     * Compilation does four things:
+     * - Culls passes without side effects whose outputs are never read
+     * - Sorts the remaining passes topologically, based on which passes read what other passes write. Passes which don't depend on each
+     *   other stay in the order they were declared in
+     * - Merges consecutive read-only usages of a resource into a single state that covers all of them, so that we don't transition
+     *   between e.g. pixel shader resource and non-pixel shader resource
+     * - Splits barriers when there's at least one pass between the two usages of a resource, so the GPU can do the transition while it
+     *   works on that pass. Both halves of a split barrier must be in the same command list, so this is optional
+     *
+     * The result is cached, and only recompiled when the pass descriptions change
+     */
+    class RenderGraphCompiler {
+    public:
+        /*!
+         * \param write_states_in Bitmask of all the states that allow writing to a resource. Any state without any of these bits is
+         * considered read-only
+         * \param initial_state_in The state that every resource is in at the beginning and at the end of a frame
+         * \param split_barriers_in Whether to split barriers. Only enable this if all the passes record into the same command list
+         */
+        explicit RenderGraphCompiler(Uint32 write_states_in, Uint32 initial_state_in = 0, bool split_barriers_in = true);
+
+        RenderGraphCompiler(const RenderGraphCompiler& other) = delete;
+        RenderGraphCompiler& operator=(const RenderGraphCompiler& other) = delete;
+
+        RenderGraphCompiler(RenderGraphCompiler&& old) noexcept = default;
+        RenderGraphCompiler& operator=(RenderGraphCompiler&& old) noexcept = default;
+
+        ~RenderGraphCompiler() = default;
+
+        /*!
+         * \brief Compiles the render graph for the provided passes, or returns the cached graph if the passes haven't changed since the
+         * last compile
+         */
+        [[nodiscard]] const CompiledRenderGraph& compile(const Rx::Vector<RenderGraphPassDescription>& passes);
+
+        /*!
+         * \brief Changes whether to split barriers. The next `compile` recompiles the graph if this changed it
+         */
+        void set_split_barriers(bool split_barriers_in);
+
+        /*!
+         * \brief Number of times that `compile` had to actually compile the render graph
+         */
+        [[nodiscard]] Uint32 get_num_compiles() const;
+
+    private:
+        Uint32 write_states;
+
+        Uint32 initial_state;
+
+        bool split_barriers;
+
+        bool has_compiled_graph{false};
+
+        Uint32 num_compiles{0};
+
+        Rx::Vector<RenderGraphPassDescription> cached_passes;
+
+        CompiledRenderGraph compiled_graph;
+
+        [[nodiscard]] bool is_write_state(Uint32 state) const;
+
+        [[nodiscard]] bool is_read_only_usage(const RenderGraphResourceUsage& usage) const;
+
+        [[nodiscard]] bool matches_cached_passes(const Rx::Vector<RenderGraphPassDescription>& passes) const;
+
+        /*!
+         * \brief Finds the passes which need to execute
+         *
+         * \return A flag for each pass, which is 1 if the pass is live and 0 if it should be culled
+         */
+        [[nodiscard]] Rx::Vector<Uint8> find_live_passes() const;
+
+        /*!
+         * \brief Sorts the live passes so that every pass comes after all the passes that it depends on
+         */
+        [[nodiscard]] Rx::Vector<Uint32> sort_passes(const Rx::Vector<Uint8>& live_passes) const;
+
+        /*!
+         * \brief Decides which state each resource usage will really see, after merging consecutive read-only usages
+         *
+         * \return One vector for each pass in `compiled_graph.pass_order`, with one merged begin and end state for each of that pass's
+         * resource usages
+         */
+        [[nodiscard]] Rx::Vector<Rx::Vector<RenderGraphResourceUsage>> merge_read_states() const;
+
+        void place_barriers(const Rx::Vector<Rx::Vector<RenderGraphResourceUsage>>& merged_usages);
+    };
+} // namespace sanity::engine::renderer
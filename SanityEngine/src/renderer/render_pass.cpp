@@ -10,6 +10,8 @@ namespace sanity::engine::renderer {
         // Default empty implementation so I don't have to change my existing render passes... yet
     }
 
+    bool RenderPass::has_side_effects() const { return true; }
+
     const Rx::Map<TextureHandle, Rx::Optional<BeginEndState>>& RenderPass::get_texture_states() const { return texture_states; }
 
     const Rx::Map<BufferHandle, Rx::Optional<BeginEndState>>& RenderPass::get_buffer_states() const { return buffer_states; }
@@ -50,6 +50,14 @@ namespace sanity::engine {
                                      Uint32 frame_idx,
                                      float delta_time) = 0;
 
+            /*!
+             * \brief Whether this pass does anything that the render graph can't see from its resource usages
+             *
+             * Passes without side effects are culled when nothing reads the resources they write to. Passes which write to resources that
+             * are read in the next frame, or to resources they don't declare with `set_resource_usage`, must keep the default
+             */
+            [[nodiscard]] virtual bool has_side_effects() const;
+
             [[nodiscard]] const Rx::Map<TextureHandle, Rx::Optional<BeginEndState>>& get_texture_states() const;
 
             [[nodiscard]] const Rx::Map<BufferHandle, Rx::Optional<BeginEndState>>& get_buffer_states() const;
@@ -1,5 +1,7 @@
 #include "renderer.hpp"
 
+#include <cstring>
+
 #include "GLFW/glfw3.h"
 #include "Tracy.hpp"
 #include "TracyD3D12.hpp"
@@ -26,19 +28,74 @@
 #include "rx/core/abort.h"
 #include "rx/core/log.h"
 #include "sanity_engine.hpp"
+#include "windows/windows_helpers.hpp"
 
 namespace sanity::engine::renderer {
     constexpr Uint32 MATERIAL_DATA_BUFFER_SIZE = 1 << 20;
 
+    constexpr Uint32 MIN_RAYTRACING_INSTANCES = 64;
+
+    // SRV buffers, SRV textures, UAV textures
+    constexpr Uint32 NUM_RESOURCE_DESCRIPTORS = MAX_NUM_BUFFERS + MAX_NUM_TEXTURES + MAX_NUM_TEXTURES;
+
     RX_LOG("Renderer", logger);
 
     RX_CONSOLE_IVAR(r_max_drawcalls_per_frame,
                     "render.MaxDrawcallsPerFrame",
-                    "Maximum number of drawcalls that may be issued in a given frame",
+                    "Maximum number of drawcalls that may be issued in a given frame, which is also the number of model matrix slots",
                     1,
                     INT_MAX,
                     100000);
 
+    RX_CONSOLE_IVAR(r_mesh_compaction_budget,
+                    "render.MeshCompactionBudget",
+                    "Bytes of mesh data each static mesh store may move each frame to defragment itself. 0 disables compaction",
+                    0,
+                    INT_MAX,
+                    0);
+
+    RX_CONSOLE_FVAR(r_raytracing_rebuild_threshold,
+                    "render.RaytracingRebuildThreshold",
+                    "Fraction of the raytracing scene's objects that may be added or removed before the scene is rebuilt instead of refit",
+                    0.0f,
+                    1.0f,
+                    0.25f);
+
+    RX_CONSOLE_BVAR(r_parallel_pass_recording,
+                    "render.ParallelPassRecording",
+                    "Whether to record each render pass's command list on the engine's worker threads",
+                    true);
+
+    /*!
+     * \brief Points the renderables whose mesh was moved by compacting a mesh store at the mesh's new location
+     *
+     * \return The new location of each moved mesh, keyed by its old first index
+     */
+    static Rx::Map<Uint32, Mesh> relocate_renderables(entt::registry& registry, const Rx::Vector<MeshRelocation>& relocations) {
+        Rx::Map<Uint32, Mesh> new_mesh_by_first_index;
+        if(relocations.is_empty()) {
+            return new_mesh_by_first_index;
+        }
+
+        relocations.each_fwd([&](const MeshRelocation& relocation) {
+            new_mesh_by_first_index.insert(relocation.old_mesh.first_index, relocation.new_mesh);
+        });
+
+        // Each mesh store has its own index buffer, so only renderables from the same store can share a first index with a moved mesh
+        const auto is_packed = relocations[0].old_mesh.is_packed;
+        registry.view<StandardRenderableComponent>().each([&](StandardRenderableComponent& renderable) {
+            if(renderable.mesh.is_packed != is_packed) {
+                return;
+            }
+
+            if(const auto* new_mesh = new_mesh_by_first_index.find(renderable.mesh.first_index); new_mesh != nullptr) {
+                renderable.mesh = *new_mesh;
+            }
+        });
+
+        return new_mesh_by_first_index;
+    }
+
     Renderer::Renderer(GLFWwindow* window)
         : start_time{std::chrono::high_resolution_clock::now()},
           backend{make_render_device(window)},
@@ -55,6 +112,8 @@ namespace sanity::engine::renderer {
 
         buffers_on_copy_queue.resize(backend->get_max_num_gpu_frames());
 
+        create_frame_stages();
+
         create_static_mesh_storage();
 
         allocate_resource_descriptors();
@@ -92,7 +151,8 @@ namespace sanity::engine::renderer {
         frame_constants.frame_count = static_cast<Uint32>(frame_count);
 
         const auto frame_idx = backend->get_cur_gpu_frame_idx();
-        next_unused_model_matrix_per_frame[frame_idx]->store(0);
+        static_mesh_storage->begin_frame(frame_idx);
+        packed_mesh_storage->begin_frame(frame_idx);
     }
 
     void Renderer::render_frame(entt::registry& registry, const float delta_time) {
@@ -106,174 +166,172 @@ namespace sanity::engine::renderer {
         {
             TracyD3D12Zone(RenderBackend::tracy_render_context, *command_list, "Renderer::render_all");
             PIXScopedEvent(*command_list, PIX_COLOR_DEFAULT, "Renderer::render_all");
-            if(raytracing_scene_dirty) {
-                rebuild_raytracing_scene(command_list);
-                raytracing_scene_dirty = false;
-            }
+            // Compaction may rebuild bottom-level acceleration structures, which the top-level one must pick up this frame
+            compact_static_meshes(registry, command_list);
+
+            frame_stages->update_transforms(registry, &g_engine->get_thread_pool());
+
+            update_raytracing_objects(registry);
+
+            update_raytracing_scene(command_list);
 
             update_cameras(registry, frame_idx);
 
+            // Hardcode camera 0 as the player camera, like the renderpasses do
+            const auto& camera_matrices = camera_matrix_buffers->get_camera_matrices(0);
+            frame_stages->cull_scene(registry, camera_matrices.view_matrix, camera_matrices.projection_matrix, output_framebuffer_size.y);
+
+            frame_stages->update_model_matrices(registry, frame_idx);
+
             upload_material_data(frame_idx);
 
             update_light_data_buffer(registry, frame_idx);
 
             update_frame_constants(registry, frame_idx, delta_time);
 
-            command_list->SetGraphicsRootSignature(*backend->get_standard_root_signature());
-
-            update_resource_array_descriptors(command_list, frame_idx);
-
-            execute_all_render_passes(command_list, registry, frame_idx, delta_time);
+            frame_stages->update_resource_array_descriptors(frame_idx);
         }
 
         backend->submit_command_list(Rx::Utility::move(command_list));
+
+        execute_all_render_passes(registry, frame_idx, delta_time);
     }
 
-    void Renderer::issue_pre_pass_barriers(ID3D12GraphicsCommandList* command_list,
-                                           const Uint32 render_pass_index,
-                                           const Rx::Ptr<RenderPass>& render_pass) {
+    void Renderer::describe_render_passes() {
         ZoneScoped;
 
-        const auto& used_resources = render_pass->get_texture_states();
-
-        auto barriers = Rx::Vector<D3D12_RESOURCE_BARRIER>{};
-        barriers.reserve(used_resources.size());
+        render_graph_passes.resize(render_passes.size());
 
-        const auto& previous_resource_usages = get_previous_resource_states(render_pass_index);
+        for(Uint32 i = 0; i < render_passes.size(); i++) {
+            const auto& render_pass = render_passes[i];
+            auto& description = render_graph_passes[i];
 
-        used_resources.each_pair([&](const TextureHandle& texture_handle, const Rx::Optional<BeginEndState>& before_after_state) {
-            if(!before_after_state) {
-                return;
-            }
+            description.has_side_effects = render_pass->has_side_effects();
+            description.resource_usages.clear();
 
-            const auto& image = get_texture(texture_handle);
-            auto* resource = *image.resource;
-
-            if(const auto* previous_state = previous_resource_usages.find(texture_handle)) {
-                if(*previous_state == before_after_state->first) {
-                    return;
-                }
-
-                // Only issue a barrier if we need a state transition
-                auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource, *previous_state, before_after_state->first);
-
-                // Issue the end of a split barrier cause we're the best
-                barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
-
-                barriers.push_back(barrier);
-
-            } else {
-                if(before_after_state->first != D3D12_RESOURCE_STATE_COMMON) {
-                    // no previous usage so just barrier from COMMON
-                    // No split barrier here, that'd be silly
+            render_pass->get_texture_states().each_pair(
+                [&](const TextureHandle& texture_handle, const Rx::Optional<BeginEndState>& before_after_state) {
+                    if(!before_after_state) {
+                        return;
+                    }
 
-                    const auto& barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource,
-                                                                               D3D12_RESOURCE_STATE_COMMON,
-                                                                               before_after_state->first);
+                    description.resource_usages.push_back(
+                        RenderGraphResourceUsage{.resource = texture_handle.index,
+                                                 .begin_state = static_cast<Uint32>(before_after_state->first),
+                                                 .end_state = static_cast<Uint32>(before_after_state->second)});
+                });
 
-                    barriers.push_back(barrier);
-                }
-            }
-        });
+            render_pass->get_buffer_states().each_pair(
+                [&](const BufferHandle& buffer_handle, const Rx::Optional<BeginEndState>& before_after_state) {
+                    if(!before_after_state || all_buffers[buffer_handle.index].mapped_ptr != nullptr) {
+                        return;
+                    }
 
-        if(!barriers.is_empty()) {
-            command_list->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+                    description.resource_usages.push_back(
+                        RenderGraphResourceUsage{.resource = buffer_handle.index | FrameStages::RENDER_GRAPH_BUFFER_BIT,
+                                                 .begin_state = static_cast<Uint32>(before_after_state->first),
+                                                 .end_state = static_cast<Uint32>(before_after_state->second)});
+                });
         }
     }
 
-    void Renderer::issue_post_pass_barriers(ID3D12GraphicsCommandList* command_list,
-                                            const Uint32 render_pass_index,
-                                            const Rx::Ptr<RenderPass>& render_pass) {
-        ZoneScoped;
+    void Renderer::bind_global_resources(ID3D12GraphicsCommandList* command_list, const Uint32 frame_idx) const {
+        auto* heap = backend->get_cbv_srv_uav_heap();
+        command_list->SetDescriptorHeaps(1, &heap);
 
-        const auto& used_resources = render_pass->get_texture_states();
+        const auto root_signature = backend->get_standard_root_signature();
+        command_list->SetGraphicsRootSignature(root_signature);
+        command_list->SetComputeRootSignature(root_signature);
 
-        auto barriers = Rx::Vector<D3D12_RESOURCE_BARRIER>{};
-        barriers.reserve(used_resources.size());
+        const auto resource_array_descriptor = get_resource_array_gpu_descriptor(frame_idx);
+        command_list->SetGraphicsRootDescriptorTable(RenderBackend::RESOURCES_ARRAY_ROOT_PARAMETER_INDEX, resource_array_descriptor);
+        command_list->SetComputeRootDescriptorTable(RenderBackend::RESOURCES_ARRAY_ROOT_PARAMETER_INDEX, resource_array_descriptor);
 
-        const auto& next_resource_usages = get_next_resource_states(render_pass_index);
+        const auto set_root_constant = [&](const Uint32 value, const Uint32 offset) {
+            command_list->SetGraphicsRoot32BitConstant(RenderBackend::ROOT_CONSTANTS_ROOT_PARAMETER_INDEX, value, offset);
+            command_list->SetComputeRoot32BitConstant(RenderBackend::ROOT_CONSTANTS_ROOT_PARAMETER_INDEX, value, offset);
+        };
 
-        used_resources.each_pair([&](const TextureHandle& texture_handle, const Rx::Optional<BeginEndState>& before_after_state) {
-            if(!before_after_state) {
-                return;
-            }
+        set_root_constant(frame_constants_buffers[frame_idx].index, RenderBackend::FRAME_CONSTANTS_BUFFER_INDEX_ROOT_CONSTANT_OFFSET);
+        set_root_constant(0, RenderBackend::CAMERA_INDEX_ROOT_CONSTANT_OFFSET); // Camera 0 is the player camera
+        const auto& model_matrix_buffer = frame_stages->get_model_matrix_buffer(frame_idx);
+        set_root_constant(model_matrix_buffer.index, RenderBackend::MODEL_MATRIX_BUFFER_INDEX_ROOT_CONSTANT_OFFSET);
 
-            const auto& image = get_texture(texture_handle);
+        const auto viewport = D3D12_VIEWPORT{.Width = static_cast<float>(output_framebuffer_size.x),
+                                             .Height = static_cast<float>(output_framebuffer_size.y),
+                                             .MinDepth = 0,
+                                             .MaxDepth = 1};
+        command_list->RSSetViewports(1, &viewport);
 
-            if(const auto* next_state = next_resource_usages.find(texture_handle)) {
-                if(before_after_state->second == *next_state) {
-                    return;
-                }
+        const auto scissor_rect = D3D12_RECT{.right = static_cast<LONG>(output_framebuffer_size.x),
+                                             .bottom = static_cast<LONG>(output_framebuffer_size.y)};
+        command_list->RSSetScissorRects(1, &scissor_rect);
 
-                // Only issue a barrier if we need a state transition
-                auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(image.resource, before_after_state->second, *next_state);
+        command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-                // Issue the end of a split barrier cause we're the best
-                barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+        static_mesh_storage->bind_to_command_list(command_list);
+    }
 
-                barriers.push_back(barrier);
+    void Renderer::execute_all_render_passes(entt::registry& registry, const Uint32 frame_idx, const float delta_time) {
+        ZoneScoped;
 
-            } else {
-                if(before_after_state->second != D3D12_RESOURCE_STATE_COMMON) {
-                    // no next usage so just barrier to COMMON
-                    // No split barrier here, that'd be silly
+        {
+            ZoneScopedN("Collect renderpass work");
+            render_passes.each_fwd([&](const Rx::Ptr<RenderPass>& pass) { pass->prepare_work(registry, frame_idx, delta_time); });
+        }
 
-                    const auto& barrier = CD3DX12_RESOURCE_BARRIER::Transition(image.resource,
-                                                                               before_after_state->second,
-                                                                               D3D12_RESOURCE_STATE_COMMON);
+        describe_render_passes();
 
-                    barriers.push_back(barrier);
-                }
-            }
-        });
+        frame_backend->set_pass_inputs(registry, frame_idx, delta_time);
 
-        if(!barriers.is_empty()) {
-            command_list->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-        }
+        ZoneScopedN("Record renderpass work");
+        auto* thread_pool = r_parallel_pass_recording->get() ? &g_engine->get_thread_pool() : nullptr;
+        frame_stages->execute_render_graph(render_graph_passes, thread_pool);
     }
 
-    void Renderer::bind_global_resources(ID3D12GraphicsCommandList* command_list) const {
-        static_mesh_storage->bind_to_command_list(command_list);
-    }
-
-    void Renderer::execute_all_render_passes(ComPtr<ID3D12GraphicsCommandList4>& command_list,
-                                             entt::registry& registry,
-                                             const Uint32 frame_idx,
-                                             const float delta_time) {
-        {
-            ZoneScoped;
+    void Renderer::end_frame() const { backend->end_frame(); }
 
-            TracyD3D12Zone(RenderBackend::tracy_render_context, *command_list, "Renderer::execute_all_render_passes");
-            PIXScopedEvent(*command_list, PIX_COLOR_DEFAULT, "execute_all_render_passes");
+    Rx::Vector<RaytracingObjectHandle> Renderer::add_raytracing_objects_to_scene(const Rx::Vector<RaytracingObject>& new_objects) {
+        Rx::Vector<RaytracingObjectHandle> handles;
+        handles.reserve(new_objects.size());
 
-            {
-                ZoneScopedN("Collect renderpass work");
-                render_passes.each_fwd([&](const Rx::Ptr<RenderPass>& pass) { pass->prepare_work(registry, frame_idx, delta_time); });
+        new_objects.each_fwd([&](const RaytracingObject& object) {
+            const auto slot = raytracing_instances.add_instance();
+            if(slot == raytracing_objects.size()) {
+                raytracing_objects.push_back(object);
+                raytracing_object_last_seen_frames.push_back(0);
+            } else {
+                raytracing_objects[slot] = object;
+                raytracing_object_last_seen_frames[slot] = 0;
             }
 
-            {
-                ZoneScopedN("Record renderpass work");
-
-                bind_global_resources(command_list);
-
-                for(Uint32 i = 0; i < render_passes.size(); i++) {
-                    Rx::Ptr<RenderPass>& render_pass = render_passes[i];
+            handles.push_back(RaytracingObjectHandle{.slot = slot, .generation = raytracing_instances.get_slot_generation(slot)});
+        });
 
-                    issue_pre_pass_barriers(command_list, i, render_pass);
+        return handles;
+    }
 
-                    render_pass->record_work(command_list, registry, frame_idx, delta_time);
+    void Renderer::remove_raytracing_object_from_scene(const RaytracingObjectHandle handle) {
+        if(!handle.is_valid()) {
+            return;
+        }
 
-                    issue_post_pass_barriers(command_list, i, render_pass);
-                }
-            }
+        if(!is_raytracing_object_in_scene(handle)) {
+            logger->error("Can not remove raytracing object %u: it's not in the raytracing scene", handle.slot);
+            return;
         }
+
+        raytracing_instances.remove_instance(handle.slot);
     }
 
-    void Renderer::end_frame() const { backend->end_frame(); }
+    void Renderer::set_raytracing_object_transform(const RaytracingObjectHandle handle, const glm::mat4& transform) {
+        if(!is_raytracing_object_in_scene(handle)) {
+            logger->error("Can not move raytracing object %u: it's not in the raytracing scene", handle.slot);
+            return;
+        }
 
-    void Renderer::add_raytracing_objects_to_scene(const Rx::Vector<RaytracingObject>& new_objects) {
-        raytracing_objects.append(new_objects);
-        raytracing_scene_dirty = true;
+        raytracing_objects[handle.slot].transform = transform;
+        raytracing_instances.mark_instance_changed(handle.slot);
     }
 
     BufferHandle Renderer::create_buffer(const BufferCreateInfo& create_info) {
@@ -287,6 +345,7 @@ namespace sanity::engine::renderer {
 
         buffer_name_to_handle.insert(create_info.name, handle);
         all_buffers.push_back(*buffer);
+        frame_stages->queue_buffer_descriptor(idx);
 
         return handle;
     }
@@ -303,7 +362,7 @@ namespace sanity::engine::renderer {
             memcpy(staging_buffer.mapped_ptr, data, create_info.size);
 
             auto cmds = backend->create_copy_command_list();
-            cmds->CopyBufferRegion(buffer->resource, 0, staging_buffer.resource, 0, create_info.size);
+            cmds->CopyBufferRegion(buffer->resource, 0, staging_buffer.resource, staging_buffer.offset, create_info.size);
 
             const auto frame_idx = backend->get_cur_gpu_frame_idx();
             buffers_on_copy_queue[frame_idx].push_back(*buffer);
@@ -336,6 +395,11 @@ namespace sanity::engine::renderer {
         if(texture) {
             all_textures.push_back(*texture);
             texture_name_to_index.insert(create_info.name, handle);
+            frame_stages->queue_texture_descriptors(idx);
+
+            if(backend->is_reserved_texture(*texture)) {
+                frame_stages->add_transient_texture(handle);
+            }
 
             // logger->verbose("Created texture %s with index %u", create_info.name, idx);
 
@@ -349,16 +413,44 @@ namespace sanity::engine::renderer {
     TextureHandle Renderer::create_texture(const TextureCreateInfo& create_info, const void* image_data) {
         ZoneScoped;
 
-        const auto handle = create_texture(create_info);
-
         // TODO: Figure out how to upload the initial data on the DMA queue, then execute the compute shader on an async compute queue, then
         // synchronize the resource access for the direct queue
         auto cmds = backend->create_render_command_list();
 
+        const auto handle = create_texture(create_info, image_data, cmds);
+
+        cmds->Close();
+
+        backend->submit_copy_command_list(cmds);
+
+        return handle;
+    }
+
+    TextureHandle Renderer::create_texture(const TextureCreateInfo& create_info, const PlacedTextureData& texture_data) {
+        ZoneScoped;
+
+        auto cmds = backend->create_render_command_list();
+
+        const auto handle = create_texture(create_info, texture_data, cmds);
+
+        cmds->Close();
+
+        backend->submit_copy_command_list(cmds);
+
+        return handle;
+    }
+
+    TextureHandle Renderer::create_texture(const TextureCreateInfo& create_info,
+                                           const void* image_data,
+                                           ID3D12GraphicsCommandList4* cmds) {
+        ZoneScoped;
+
+        const auto handle = create_texture(create_info);
+
         {
             const auto scope_name = Rx::String::format("create_texture(\"%s\")", create_info.name);
-            TracyD3D12Zone(RenderBackend::tracy_render_context, *cmds, scope_name.data());
-            PIXScopedEvent(*cmds, PIX_COLOR_DEFAULT, scope_name.data());
+            TracyD3D12Zone(RenderBackend::tracy_render_context, cmds, scope_name.data());
+            PIXScopedEvent(cmds, PIX_COLOR_DEFAULT, scope_name.data());
 
             auto& image = all_textures[handle.index];
 
@@ -370,47 +462,118 @@ namespace sanity::engine::renderer {
                 cmds->ResourceBarrier(static_cast<Uint32>(barriers.size()), barriers.data());
             }
 
-            const auto& staging_buffer = backend->get_staging_buffer_for_texture(image.resource);
+            // If the texture's mips are in the image data we upload all of them, otherwise we upload the top mip and generate the rest
+            const auto has_all_mips = create_info.num_mips != 0;
+            const auto num_uploaded_mips = has_all_mips ? create_info.num_mips : 1;
 
-            const auto pixel_size = size_in_bytes(create_info.format);
+            Rx::Vector<D3D12_SUBRESOURCE_DATA> subresources;
+            subresources.reserve(num_uploaded_mips);
 
-            const auto subresource = D3D12_SUBRESOURCE_DATA{
-                .pData = image_data,
-                .RowPitch = static_cast<LONG_PTR>(create_info.width) * pixel_size,
-                .SlicePitch = static_cast<LONG_PTR>(create_info.width) * create_info.height * pixel_size,
-            };
+            const auto* mip_data = static_cast<const Uint8*>(image_data);
+            for(Uint32 mip_level = 0; mip_level < num_uploaded_mips; mip_level++) {
+                const auto row_pitch = get_row_pitch(create_info.format, get_mip_dimension(create_info.width, mip_level));
+                const auto slice_pitch = row_pitch * get_num_rows(create_info.format, get_mip_dimension(create_info.height, mip_level));
+
+                subresources.push_back(D3D12_SUBRESOURCE_DATA{
+                    .pData = mip_data,
+                    .RowPitch = static_cast<LONG_PTR>(row_pitch),
+                    .SlicePitch = static_cast<LONG_PTR>(slice_pitch),
+                });
+
+                mip_data += slice_pitch;
+            }
+
+            const auto staging_buffer = backend->get_staging_buffer_for_texture(image.resource, num_uploaded_mips);
 
-            const auto result = UpdateSubresources(*cmds, image.resource, staging_buffer.resource, 0, 0, 1, &subresource);
+            const auto result = UpdateSubresources(cmds,
+                                                  image.resource,
+                                                  staging_buffer.resource,
+                                                  staging_buffer.offset,
+                                                  0,
+                                                  num_uploaded_mips,
+                                                  subresources.data());
             if(result == 0) {
                 logger->error("Could not upload texture data");
 
                 return pink_texture_handle;
             }
 
-            {
-                const auto barriers = Rx::Array{CD3DX12_RESOURCE_BARRIER::Transition(image.resource,
-                                                                                     D3D12_RESOURCE_STATE_COPY_DEST,
-                                                                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS)};
+            finish_texture_upload(create_info, image, cmds);
+        }
+
+        return handle;
+    }
+
+    TextureHandle Renderer::create_texture(const TextureCreateInfo& create_info,
+                                           const PlacedTextureData& texture_data,
+                                           ID3D12GraphicsCommandList4* cmds) {
+        ZoneScoped;
+
+        const auto handle = create_texture(create_info);
+
+        {
+            const auto scope_name = Rx::String::format("create_texture(\"%s\")", create_info.name);
+            TracyD3D12Zone(RenderBackend::tracy_render_context, cmds, scope_name.data());
+            PIXScopedEvent(cmds, PIX_COLOR_DEFAULT, scope_name.data());
+
+            auto& image = all_textures[handle.index];
+
+            if(create_info.usage == TextureUsage::UnorderedAccess) {
+                const auto barriers = Rx::Array{
+                    CD3DX12_RESOURCE_BARRIER::Transition(image.resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST)};
 
                 cmds->ResourceBarrier(static_cast<Uint32>(barriers.size()), barriers.data());
             }
 
-            spd->generate_mip_chain_for_texture(image.resource, *cmds);
+            // The data is already laid out the way the GPU copies it, so it goes into staging memory in one block. The staging buffer's
+            // offset is placement-aligned, so the mips stay aligned
+            const auto staging_buffer = backend->get_staging_buffer(texture_data.size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            memcpy(staging_buffer.mapped_ptr, texture_data.data, texture_data.size);
 
-            {
-                const auto barriers = Rx::Array{CD3DX12_RESOURCE_BARRIER::Transition(image.resource,
-                                                                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-                                                                                     D3D12_RESOURCE_STATE_COMMON)};
+            for(Uint32 mip_level = 0; mip_level < texture_data.mip_footprints.size(); mip_level++) {
+                auto footprint = texture_data.mip_footprints[mip_level];
+                footprint.Offset += staging_buffer.offset;
 
-                cmds->ResourceBarrier(static_cast<Uint32>(barriers.size()), barriers.data());
+                const auto source = CD3DX12_TEXTURE_COPY_LOCATION{staging_buffer.resource, footprint};
+                const auto destination = CD3DX12_TEXTURE_COPY_LOCATION{image.resource, mip_level};
+                cmds->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
             }
+
+            finish_texture_upload(create_info, image, cmds);
         }
 
-        cmds->Close();
+        return handle;
+    }
 
-        backend->submit_copy_command_list(cmds);
+    void Renderer::finish_texture_upload(const TextureCreateInfo& create_info, const Texture& texture, ID3D12GraphicsCommandList4* cmds) {
+        if(create_info.num_mips != 0 || is_block_compressed(create_info.format)) {
+            // The texture came with all the mips it's going to have. Compressed textures can't be unordered access views, so they
+            // always do
+            const auto barriers = Rx::Array{
+                CD3DX12_RESOURCE_BARRIER::Transition(texture.resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON)};
 
-        return handle;
+            cmds->ResourceBarrier(static_cast<Uint32>(barriers.size()), barriers.data());
+
+            return;
+        }
+
+        {
+            const auto barriers = Rx::Array{CD3DX12_RESOURCE_BARRIER::Transition(texture.resource,
+                                                                                 D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                                 D3D12_RESOURCE_STATE_UNORDERED_ACCESS)};
+
+            cmds->ResourceBarrier(static_cast<Uint32>(barriers.size()), barriers.data());
+        }
+
+        spd->generate_mip_chain_for_texture(texture.resource, cmds, true);
+
+        {
+            const auto barriers = Rx::Array{CD3DX12_RESOURCE_BARRIER::Transition(texture.resource,
+                                                                                 D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                                                                 D3D12_RESOURCE_STATE_COMMON)};
+
+            cmds->ResourceBarrier(static_cast<Uint32>(barriers.size()), barriers.data());
+        }
     }
 
     Rx::Optional<TextureHandle> Renderer::get_texture_handle(const Rx::String& name) {
@@ -450,6 +613,8 @@ namespace sanity::engine::renderer {
         backend->schedule_texture_destruction(texture);
 
         all_textures[texture_handle.index] = {};
+        frame_stages->queue_texture_descriptors(texture_handle.index);
+        frame_stages->remove_transient_texture(texture_handle);
     }
 
     FluidVolumeHandle Renderer::create_fluid_volume(const FluidVolumeCreateInfo& create_info) {
@@ -622,6 +787,12 @@ namespace sanity::engine::renderer {
 
     MeshDataStore& Renderer::get_static_mesh_store() const { return *static_mesh_storage; }
 
+    MeshDataStore& Renderer::get_packed_mesh_store() const { return *packed_mesh_storage; }
+
+    MeshDataStore& Renderer::get_mesh_store(const Mesh& mesh) const {
+        return mesh.is_packed ? *packed_mesh_storage : *static_mesh_storage;
+    }
+
     void Renderer::begin_device_capture() const { backend->begin_capture(); }
 
     void Renderer::end_device_capture() const { backend->end_capture(); }
@@ -640,6 +811,12 @@ namespace sanity::engine::renderer {
 
     const RaytracingScene& Renderer::get_raytracing_scene() const { return raytracing_scene; }
 
+    const Rx::Vector<entt::entity>& Renderer::get_visible_objects() const { return frame_stages->get_visible_objects(); }
+
+    const Rx::Vector<Uint32>& Renderer::get_visible_object_lods() const { return frame_stages->get_visible_object_lods(); }
+
+    const TransformHierarchy& Renderer::get_transform_hierarchy() const { return frame_stages->get_transform_hierarchy(); }
+
     RaytracingAsHandle Renderer::create_raytracing_geometry(const Buffer& vertex_buffer,
                                                             const Buffer& index_buffer,
                                                             const Rx::Vector<PlacedMesh>& meshes,
@@ -647,6 +824,20 @@ namespace sanity::engine::renderer {
         TracyD3D12Zone(RenderBackend::tracy_render_context, commands, "Renderer::create_raytracing_geometry");
         PIXScopedEvent(commands, PIX_COLOR_DEFAULT, "Renderer::create_raytracing_geometry");
 
+        auto new_ray_geo = RaytracingAccelerationStructure{.blas_buffer = build_blas(vertex_buffer, index_buffer, meshes, commands),
+                                                           .meshes = meshes};
+
+        const auto handle_idx = static_cast<Uint32>(raytracing_geometries.size());
+        raytracing_geometries.push_back(Rx::Utility::move(new_ray_geo));
+
+        return RaytracingAsHandle(handle_idx);
+    }
+
+    BufferHandle Renderer::build_blas(const Buffer& vertex_buffer,
+                                      const Buffer& index_buffer,
+                                      const Rx::Vector<PlacedMesh>& meshes,
+                                      ID3D12GraphicsCommandList4* commands) {
+
         Rx::Vector<D3D12_RAYTRACING_GEOMETRY_DESC> geom_descs;
         geom_descs.reserve(meshes.size());
         meshes.each_fwd([&](const PlacedMesh& mesh) {
@@ -656,13 +847,15 @@ namespace sanity::engine::renderer {
                                             glm::vec3{mesh.model_matrix[2]},
                                             glm::vec3{mesh.model_matrix[3]}};
             memcpy(transform_buffer.mapped_ptr, &mesh.model_matrix[0][0], sizeof(glm::mat4x3));
+            const auto transform_address = transform_buffer.resource->GetGPUVirtualAddress() + transform_buffer.offset;
 
-            const auto& [first_vertex, num_vertices, first_index, num_indices] = mesh.mesh;
+            // The BLAS always holds the full mesh. LODs are only for rasterization
+            const auto& [first_vertex, num_vertices, first_index, num_indices, num_lods, lods] = mesh.mesh;
 
             // Don't offset the vertex buffer here. We add the vertex offset to the indices when importing the glTF primitive
             auto geom_desc = D3D12_RAYTRACING_GEOMETRY_DESC{.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES,
                                                             .Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE,
-                                                            .Triangles = {.Transform3x4 = transform_buffer.resource->GetGPUVirtualAddress(),
+                                                            .Triangles = {.Transform3x4 = transform_address,
                                                                           .IndexFormat = DXGI_FORMAT_R32_UINT,
                                                                           .VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT,
                                                                           .IndexCount = num_indices,
@@ -674,7 +867,6 @@ namespace sanity::engine::renderer {
                                                                                            .StrideInBytes = sizeof(StandardVertex)}}};
 
             geom_descs.push_back(Rx::Utility::move(geom_desc));
-            backend->return_staging_buffer(transform_buffer);
         });
 
         const auto build_as_inputs = D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS{
@@ -713,18 +905,24 @@ namespace sanity::engine::renderer {
 
         backend->return_scratch_buffer(Rx::Utility::move(scratch_buffer));
 
-        auto new_ray_geo = RaytracingAccelerationStructure{.blas_buffer = result_buffer_handle};
-
-        const auto handle_idx = static_cast<Uint32>(raytracing_geometries.size());
-        raytracing_geometries.push_back(Rx::Utility::move(new_ray_geo));
-
-        return RaytracingAsHandle(handle_idx);
+        return result_buffer_handle;
     }
 
     D3D12_GPU_DESCRIPTOR_HANDLE Renderer::get_resource_array_gpu_descriptor(const Uint32 frame_idx) const {
         return resource_descriptors[frame_idx].gpu_handle;
     }
 
+    void Renderer::create_frame_stages() {
+        frame_backend = Rx::make_ptr<D3D12FrameBackend>(RX_SYSTEM_ALLOCATOR, *this);
+
+        const auto create_info = FrameStagesCreateInfo{.max_num_model_matrices = static_cast<Uint32>(r_max_drawcalls_per_frame->get()),
+                                                       .num_resource_descriptors = NUM_RESOURCE_DESCRIPTORS,
+                                                       .write_resource_states = WRITE_RESOURCE_STATES,
+                                                       .initial_resource_state = D3D12_RESOURCE_STATE_COMMON,
+                                                       .transient_texture_alignment = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES};
+        frame_stages = Rx::make_ptr<FrameStages>(RX_SYSTEM_ALLOCATOR, create_info, *frame_backend);
+    }
+
     void Renderer::create_static_mesh_storage() {
         const auto vertex_create_info = BufferCreateInfo{
             .name = "Static Mesh Vertex Buffer",
@@ -741,6 +939,20 @@ namespace sanity::engine::renderer {
         auto index_buffer = create_buffer(index_buffer_create_info);
 
         static_mesh_storage = Rx::make_ptr<MeshDataStore>(RX_SYSTEM_ALLOCATOR, *this, vertex_buffer, index_buffer);
+
+        const auto packed_vertex_buffer = create_buffer(BufferCreateInfo{.name = "Packed Static Mesh Vertex Buffer",
+                                                                         .usage = BufferUsage::VertexBuffer,
+                                                                         .size = PACKED_MESH_VERTEX_BUFFER_SIZE});
+
+        const auto packed_index_buffer = create_buffer(BufferCreateInfo{.name = "Packed Static Mesh Index Buffer",
+                                                                        .usage = BufferUsage::IndexBuffer,
+                                                                        .size = PACKED_MESH_INDEX_BUFFER_SIZE});
+
+        packed_mesh_storage = Rx::make_ptr<MeshDataStore>(RX_SYSTEM_ALLOCATOR,
+                                                          *this,
+                                                          packed_vertex_buffer,
+                                                          packed_index_buffer,
+                                                          MeshVertexFormat::PackedVertex);
     }
 
     void Renderer::allocate_resource_descriptors() {
@@ -753,9 +965,17 @@ namespace sanity::engine::renderer {
         resource_descriptors.resize(num_gpu_frames);
 
         for(auto i = 0u; i < num_gpu_frames; i++) {
-            // SRV buffers, SRV textures, UAV textures
-            resource_descriptors[i] = descriptors.allocate_descriptors(MAX_NUM_BUFFERS + MAX_NUM_TEXTURES + MAX_NUM_TEXTURES);
+            resource_descriptors[i] = descriptors.allocate_descriptors(NUM_RESOURCE_DESCRIPTORS);
         }
+
+        const auto staging_heap_desc = D3D12_DESCRIPTOR_HEAP_DESC{.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+                                                                  .NumDescriptors = NUM_RESOURCE_DESCRIPTORS,
+                                                                  .Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE};
+        const auto result = backend->device->CreateDescriptorHeap(&staging_heap_desc, IID_PPV_ARGS(&staging_resource_descriptors));
+        if(FAILED(result)) {
+            Rx::abort("Could not create staging descriptor heap: %s", to_string(result));
+        }
+        set_object_name(staging_resource_descriptors, "Staging Resource Descriptors");
     }
 
     void Renderer::create_per_frame_buffers() {
@@ -764,17 +984,12 @@ namespace sanity::engine::renderer {
         const auto num_gpu_frames = backend->get_max_num_gpu_frames();
 
         frame_constants_buffers.reserve(num_gpu_frames);
-        model_matrix_buffers.reserve(num_gpu_frames);
 
         auto frame_constants_buffer_create_info = BufferCreateInfo{
             .usage = BufferUsage::ConstantBuffer,
             .size = sizeof(FrameConstants),
         };
 
-        auto model_matrix_buffer_create_info = BufferCreateInfo{.usage = BufferUsage::ConstantBuffer,
-                                                                .size = static_cast<Uint32>(sizeof(glm::mat4) *
-                                                                                            r_max_drawcalls_per_frame->get())};
-
         for(Uint32 i = 0; i < num_gpu_frames; i++) {
             frame_constants_buffer_create_info.name = Rx::String::format("Frame constants buffer %d", i);
             const auto frame_constants_buffer = create_buffer(frame_constants_buffer_create_info);
@@ -784,17 +999,6 @@ namespace sanity::engine::renderer {
             } else {
                 logger->error("Could not create buffer %s", frame_constants_buffer_create_info.name);
             }
-
-            model_matrix_buffer_create_info.name = Rx::String::format("Model matrix buffer %d", i);
-            const auto model_matrix_buffer = create_buffer(model_matrix_buffer_create_info);
-            if(model_matrix_buffer.is_valid()) {
-                model_matrix_buffers.push_back(model_matrix_buffer);
-
-            } else {
-                logger->error("Could not create buffer %s", model_matrix_buffer_create_info.name);
-            }
-
-            next_unused_model_matrix_per_frame.emplace_back(Rx::make_ptr<Rx::Concurrency::Atomic<Uint32>>(RX_SYSTEM_ALLOCATOR, 0_u32));
         }
     }
 
@@ -932,6 +1136,10 @@ namespace sanity::engine::renderer {
 
     const Rx::Vector<Texture>& Renderer::get_texture_array() const { return all_textures; }
 
+    const BindlessDescriptorStats& Renderer::get_bindless_descriptor_stats() const {
+        return frame_stages->get_bindless_descriptor_stats();
+    }
+
     void Renderer::update_cameras(entt::registry& registry, const Uint32 frame_idx) const {
         ZoneScoped;
 
@@ -965,208 +1173,304 @@ namespace sanity::engine::renderer {
         memcpy(buffer->mapped_ptr, standard_materials.data(), standard_materials.size() * sizeof(StandardMaterial));
     }
 
-    void Renderer::update_resource_array_descriptors(ID3D12GraphicsCommandList* cmds, const Uint32 frame_idx) {
-        ZoneScoped;
-        const auto& resource_descriptors_range = resource_descriptors[frame_idx];
+    void Renderer::write_buffer_descriptor(const Uint32 buffer_idx, const D3D12_CPU_DESCRIPTOR_HANDLE descriptor) const {
+        const auto& buffer = all_buffers[buffer_idx];
+
+        // V0: bind all buffers as SRVs. The debug layers should yell at us if this is bad
+        const auto desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = DXGI_FORMAT_R32_TYPELESS,
+                                                          .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+                                                          .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+                                                          .Buffer = D3D12_BUFFER_SRV{.FirstElement = 0,
+                                                                                     .NumElements = static_cast<UINT>(buffer.size / 4.0),
+                                                                                     .StructureByteStride = 0,
+                                                                                     .Flags = D3D12_BUFFER_SRV_FLAG_RAW}};
 
-        // Intentional copy
-        auto srv_descriptor = resource_descriptors_range.cpu_handle;
+        // A null resource gives a null descriptor, which reads as zero
+        backend->get_d3d12_device()->CreateShaderResourceView(buffer.resource, &desc, descriptor);
+    }
 
+    void Renderer::write_texture_descriptors(const Uint32 texture_idx,
+                                             const D3D12_CPU_DESCRIPTOR_HANDLE srv_descriptor,
+                                             const D3D12_CPU_DESCRIPTOR_HANDLE uav_descriptor) const {
         auto* device = backend->get_d3d12_device();
-        const auto descriptor_size = backend->get_cbv_srv_uav_allocator().get_descriptor_size();
+        const auto& texture = all_textures[texture_idx];
 
-        for(auto i = 0u; i < all_buffers.size(); i++) {
-            const auto& buffer = all_buffers[i];
-            if(!buffer.resource) {
-                continue;
-            }
+        // Null descriptors for slots without a view, so that every descriptor in the staging heap is valid to copy
+        const auto null_uav_desc = D3D12_UNORDERED_ACCESS_VIEW_DESC{.Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+                                                                    .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D};
 
-            // V0: bind all buffers as SRVs. The debug layers should yell at us if this is bad
-            const auto desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = DXGI_FORMAT_R32_TYPELESS,
-                                                              .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
-                                                              .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
-                                                              .Buffer = D3D12_BUFFER_SRV{.FirstElement = 0,
-                                                                                         .NumElements = static_cast<UINT>(buffer.size /
-                                                                                                                          4.0),
-                                                                                         .StructureByteStride = 0,
-                                                                                         .Flags = D3D12_BUFFER_SRV_FLAG_RAW}};
+        if(!texture.resource) {
+            // The texture was destroyed. Replace its descriptors with null descriptors, so shaders which still use its index read zeros
+            const auto null_srv_desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+                                                                       .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+                                                                       .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+                                                                       .Texture2D = D3D12_TEX2D_SRV{.MipLevels = 1}};
+            device->CreateShaderResourceView(nullptr, &null_srv_desc, srv_descriptor);
+            device->CreateUnorderedAccessView(nullptr, nullptr, &null_uav_desc, uav_descriptor);
 
-            device->CreateShaderResourceView(buffer.resource, &desc, srv_descriptor);
+            return;
+        }
 
-            srv_descriptor.Offset(1, descriptor_size);
+        const auto& texture_desc = texture.resource->GetDesc();
+
+        auto format = to_dxgi_format(texture.format);
+        Uint32 mapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        if(format == DXGI_FORMAT_D32_FLOAT) {
+            format = DXGI_FORMAT_R32_FLOAT;
+            mapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 0, 0, 0);
         }
 
-        srv_descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE{resource_descriptors_range.cpu_handle, MAX_NUM_BUFFERS, descriptor_size};
-        auto uav_descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE{srv_descriptor, UAV_OFFSET, descriptor_size};
+        // V0.5: Create both SVR and UAV descriptors for all the textures
+        D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc;
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uav_desc;
 
-        for(int i = 0u; i < all_textures.size(); i++) {
-            const auto& texture = all_textures[i];
-            if(!texture.resource) {
-                continue;
-            }
+        // Static analyzer doesn't realize one branch is 2D and the other is 3D
+        if(texture.depth == 1) { // NOLINT(bugprone-branch-clone)
+            srv_desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = format,
+                                                       .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+                                                       .Shader4ComponentMapping = mapping,
+                                                       .Texture2D = D3D12_TEX2D_SRV{.MostDetailedMip = 0,
+                                                                                    .MipLevels = texture_desc.MipLevels,
+                                                                                    .PlaneSlice = 0,
+                                                                                    .ResourceMinLODClamp = 0}};
 
-            const auto& texture_desc = texture.resource->GetDesc();
+            uav_desc = D3D12_UNORDERED_ACCESS_VIEW_DESC{.Format = format,
+                                                        .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D,
+                                                        .Texture2D = D3D12_TEX2D_UAV{.MipSlice = 0, .PlaneSlice = 0}};
 
-            auto format = to_dxgi_format(texture.format);
-            Uint32 mapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-            if(format == DXGI_FORMAT_D32_FLOAT) {
-                format = DXGI_FORMAT_R32_FLOAT;
-                mapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 0, 0, 0);
-            }
+        } else {
+            srv_desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = format,
+                                                       .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D,
+                                                       .Shader4ComponentMapping = mapping,
+                                                       .Texture3D = D3D12_TEX3D_SRV{.MostDetailedMip = 0,
+                                                                                    .MipLevels = texture_desc.MipLevels,
+                                                                                    .ResourceMinLODClamp = 0}};
+
+            uav_desc = D3D12_UNORDERED_ACCESS_VIEW_DESC{.Format = format,
+                                                        .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE3D,
+                                                        .Texture3D = D3D12_TEX3D_UAV{.MipSlice = 0,
+                                                                                     .FirstWSlice = 0,
+                                                                                     .WSize = texture_desc.DepthOrArraySize}};
+        }
 
-            // V0.5: Create both SVR and UAV descriptors for all the textures
-            D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc;
-            D3D12_UNORDERED_ACCESS_VIEW_DESC uav_desc;
+        device->CreateShaderResourceView(texture.resource, &srv_desc, srv_descriptor);
 
-            // Static analyzer doesn't realize one branch is 2D and the other is 3D
-            if(texture.depth == 1) { // NOLINT(bugprone-branch-clone)
-                srv_desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = format,
-                                                           .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
-                                                           .Shader4ComponentMapping = mapping,
-                                                           .Texture2D = D3D12_TEX2D_SRV{.MostDetailedMip = 0,
-                                                                                        .MipLevels = texture_desc.MipLevels,
-                                                                                        .PlaneSlice = 0,
-                                                                                        .ResourceMinLODClamp = 0}};
+        if((texture_desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) != 0) {
+            device->CreateUnorderedAccessView(texture.resource, nullptr, &uav_desc, uav_descriptor);
+        } else {
+            device->CreateUnorderedAccessView(nullptr, nullptr, &null_uav_desc, uav_descriptor);
+        }
+    }
 
-                uav_desc = D3D12_UNORDERED_ACCESS_VIEW_DESC{.Format = format,
-                                                            .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D,
-                                                            .Texture2D = D3D12_TEX2D_UAV{.MipSlice = 0, .PlaneSlice = 0}};
+    bool Renderer::is_raytracing_object_in_scene(const RaytracingObjectHandle handle) const {
+        return raytracing_instances.is_instance_active(handle.slot) &&
+               raytracing_instances.get_slot_generation(handle.slot) == handle.generation;
+    }
 
-            } else {
-                srv_desc = D3D12_SHADER_RESOURCE_VIEW_DESC{.Format = format,
-                                                           .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D,
-                                                           .Shader4ComponentMapping = mapping,
-                                                           .Texture3D = D3D12_TEX3D_SRV{.MostDetailedMip = 0,
-                                                                                        .MipLevels = texture_desc.MipLevels,
-                                                                                        .ResourceMinLODClamp = 0}};
-
-                uav_desc = D3D12_UNORDERED_ACCESS_VIEW_DESC{.Format = format,
-                                                            .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE3D,
-                                                            .Texture3D = D3D12_TEX3D_UAV{.MipSlice = 0,
-                                                                                         .FirstWSlice = 0,
-                                                                                         .WSize = texture_desc.DepthOrArraySize}};
+    void Renderer::update_raytracing_objects(entt::registry& registry) {
+        ZoneScoped;
+
+        raytracing_objects_frame++;
+
+        const auto& transform_hierarchy = frame_stages->get_transform_hierarchy();
+
+        // Node indices change whenever the hierarchy is re-sorted, so every object must check its matrix
+        const auto is_hierarchy_rebuilt = transform_hierarchy.get_num_rebuilds() != raytracing_hierarchy_num_rebuilds;
+        raytracing_hierarchy_num_rebuilds = transform_hierarchy.get_num_rebuilds();
+
+        registry.view<RaytracingObjectComponent>().each([&](const entt::entity entity, const RaytracingObjectComponent& component) {
+            if(!is_raytracing_object_in_scene(component.object)) {
+                return;
             }
 
-            device->CreateShaderResourceView(texture.resource, &srv_desc, srv_descriptor);
+            auto& last_seen_frame = raytracing_object_last_seen_frames[component.object.slot];
+            const auto is_new = last_seen_frame == 0;
+            last_seen_frame = raytracing_objects_frame;
 
-            if((texture_desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) != 0) {
-                device->CreateUnorderedAccessView(texture.resource, nullptr, &uav_desc, uav_descriptor);
+            // An entity's node is updated whenever its parent's is
+            const auto node_idx = transform_hierarchy.get_node_idx(entity);
+            const auto may_have_moved = is_new || is_hierarchy_rebuilt || node_idx == TransformHierarchy::NO_NODE ||
+                                        transform_hierarchy.is_node_updated(node_idx);
+            if(!may_have_moved) {
+                return;
             }
 
-            srv_descriptor.Offset(1, descriptor_size);
-            uav_descriptor.Offset(1, descriptor_size);
+            // The bottom-level acceleration structure has the entity's local matrix baked in, so the object only takes the parent's
+            const auto transform = transform_hierarchy.get_parent_world_matrix(entity, registry);
+
+            // Compare the bytes like the model matrix store does, so that a NaN can't make the object look moved every frame
+            if(memcmp(&raytracing_objects[component.object.slot].transform, &transform, sizeof(glm::mat4)) != 0) {
+                set_raytracing_object_transform(component.object, transform);
+            }
+        });
+
+        // Objects whose component was removed, or whose entity was destroyed, weren't seen this frame
+        for(Uint32 slot = 0; slot < raytracing_objects.size(); slot++) {
+            if(raytracing_instances.is_instance_active(slot) && raytracing_object_last_seen_frames[slot] != raytracing_objects_frame) {
+                remove_raytracing_object_from_scene(
+                    RaytracingObjectHandle{.slot = slot, .generation = raytracing_instances.get_slot_generation(slot)});
+            }
         }
     }
 
-    Rx::Map<TextureHandle, D3D12_RESOURCE_STATES> Renderer::get_previous_resource_states(const Uint32 cur_renderpass_index) const {
-        const auto& used_resources = render_passes[cur_renderpass_index]->get_texture_states();
-        auto previous_states = Rx::Map<TextureHandle, D3D12_RESOURCE_STATES>{};
-
-        if(cur_renderpass_index > 0) {
-            for(Int32 i = cur_renderpass_index - 1; i >= 0; i--) {
-                used_resources.each_key([&](const TextureHandle& texture) {
-                    const auto& renderpass_resources = render_passes[i]->get_texture_states();
-                    if(previous_states.find(texture) == nullptr) {
-                        // No usage for this resource has been found yes
-                        if(const auto* states = renderpass_resources.find(texture); states != nullptr && states->has_value()) {
-                            // This renderpass has an entry for the resource we care about!
-                            previous_states.insert(texture, (*states)->second);
-                        }
-                    }
-                });
-            }
+    void Renderer::update_raytracing_scene(const ComPtr<ID3D12GraphicsCommandList4>& commands) {
+        const auto update_type = raytracing_instances.get_update_type(r_raytracing_rebuild_threshold->get());
+        if(update_type == RaytracingSceneUpdateType::None) {
+            return;
         }
 
-        return previous_states;
-    }
+        TracyD3D12Zone(RenderBackend::tracy_render_context, *commands, "UpdateRaytracingScene");
+        PIXScopedEvent(*commands, PIX_COLOR_DEFAULT, "Renderer::update_raytracing_scene");
 
-    Rx::Map<TextureHandle, D3D12_RESOURCE_STATES> Renderer::get_next_resource_states(const Uint32 cur_renderpass_index) const {
-        const auto& used_resources = render_passes[cur_renderpass_index]->get_texture_states();
-        auto next_states = Rx::Map<TextureHandle, D3D12_RESOURCE_STATES>{};
-
-        if(cur_renderpass_index < render_passes.size() - 1) {
-            for(Int32 i = cur_renderpass_index + 1; i < render_passes.size(); i++) {
-                used_resources.each_key([&](const TextureHandle& texture) {
-                    const auto& renderpass_resources = render_passes[i]->get_texture_states();
-                    if(next_states.find(texture) == nullptr) {
-                        // No usage for this resource has been found yes
-                        if(const auto* states = renderpass_resources.find(texture); states != nullptr && states->has_value()) {
-                            // This renderpass has an entry for the resource we care about!
-                            next_states.insert(texture, (*states)->first);
-                        }
-                    }
-                });
+        const auto num_slots = raytracing_instances.get_num_slots();
+        constexpr auto max_num_objects = UINT32_MAX / sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+
+        RX_ASSERT(num_slots < max_num_objects, "May not have more than %u objects because uint32", max_num_objects);
+
+        // The instance buffer only grows, so that every slot keeps its desc in the same place
+        auto is_new_instance_buffer = false;
+        if(num_slots > raytracing_instance_buffer_capacity) {
+            if(raytracing_instance_buffer.is_valid()) {
+                backend->schedule_buffer_destruction(*get_buffer(raytracing_instance_buffer));
             }
-        }
 
-        return next_states;
-    }
+            auto new_capacity = raytracing_instance_buffer_capacity > 0 ? raytracing_instance_buffer_capacity : MIN_RAYTRACING_INSTANCES;
+            while(new_capacity < num_slots) {
+                new_capacity *= 2;
+            }
 
-    void Renderer::rebuild_raytracing_scene(const ComPtr<ID3D12GraphicsCommandList4>& commands) {
-        TracyD3D12Zone(RenderBackend::tracy_render_context, *commands, "RebuildRaytracingScene");
-        PIXScopedEvent(*commands, PIX_COLOR_DEFAULT, "Renderer::rebuild_raytracing_scene");
+            logger->verbose("Growing the raytracing instance buffer to %u instances", new_capacity);
 
-        // TODO: figure out how to update the raytracing scene without needing a full rebuild
+            const auto instance_buffer_create_info = BufferCreateInfo{.name = "Raytracing Instances",
+                                                                      .usage = BufferUsage::UnorderedAccess,
+                                                                      .size = new_capacity * sizeof(D3D12_RAYTRACING_INSTANCE_DESC)};
+            raytracing_instance_buffer = create_buffer(instance_buffer_create_info);
+            raytracing_instance_buffer_capacity = new_capacity;
+            is_new_instance_buffer = true;
+        }
 
-        if(has_raytracing_scene) {
-            const auto rt_scene_buffer = get_buffer(raytracing_scene.buffer);
-            backend->schedule_buffer_destruction(*rt_scene_buffer);
+        // A new buffer needs every desc. Otherwise the buffer already has the descs of the slots that didn't change
+        auto ranges = is_new_instance_buffer ? Rx::Vector<RaytracingInstanceRange>{} : raytracing_instances.get_changed_ranges();
+        if(is_new_instance_buffer) {
+            ranges.push_back(RaytracingInstanceRange{.first_slot = 0, .num_slots = num_slots});
         }
 
-        if(!raytracing_objects.is_empty()) {
-            logger->verbose("Building top-level acceleration structure for %u objects", raytracing_objects.size());
-            constexpr auto max_num_objects = UINT32_MAX / sizeof(D3D12_RAYTRACING_INSTANCE_DESC);
+        Uint32 num_descs_to_write = 0;
+        ranges.each_fwd([&](const RaytracingInstanceRange& range) { num_descs_to_write += range.num_slots; });
 
-            RX_ASSERT(raytracing_objects.size() < max_num_objects, "May not have more than %u objects because uint32", max_num_objects);
+        logger->verbose("%s top-level acceleration structure for %u objects, writing %u instance descs in %u ranges",
+                        update_type == RaytracingSceneUpdateType::Refit ? "Refitting" : "Building",
+                        raytracing_instances.get_num_active_instances(),
+                        num_descs_to_write,
+                        ranges.size());
 
-            const auto instance_buffer_size = static_cast<Uint32>(raytracing_objects.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-            auto instance_buffer = backend->get_staging_buffer(instance_buffer_size);
-            set_object_name(instance_buffer.resource, "Raytracing instance description buffer");
-            auto* instance_buffer_array = static_cast<D3D12_RAYTRACING_INSTANCE_DESC*>(instance_buffer.mapped_ptr);
+        const auto instance_buffer = get_buffer(raytracing_instance_buffer);
+        auto* instance_resource = *instance_buffer->resource;
 
-            for(Uint32 i = 0; i < raytracing_objects.size(); i++) {
-                const auto& object = raytracing_objects[i];
-                auto& desc = instance_buffer_array[i];
-                desc = {};
+        if(num_descs_to_write > 0) {
+            const auto staging_buffer = backend->get_staging_buffer(num_descs_to_write * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+            auto* staged_descs = static_cast<D3D12_RAYTRACING_INSTANCE_DESC*>(staging_buffer.mapped_ptr);
 
-                const auto model_matrix = object.transform;
+            // New buffers start in the common state, and get promoted to the copy destination state by the copy
+            if(!is_new_instance_buffer) {
+                const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(instance_resource,
+                                                                          D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                                                          D3D12_RESOURCE_STATE_COPY_DEST);
+                commands->ResourceBarrier(1, &barrier);
+            }
 
-                desc.Transform[0][0] = model_matrix[0][0];
-                desc.Transform[0][1] = model_matrix[0][1];
-                desc.Transform[0][2] = model_matrix[0][2];
-                desc.Transform[0][3] = model_matrix[0][3];
+            Uint32 num_staged_descs = 0;
+            ranges.each_fwd([&](const RaytracingInstanceRange& range) {
+                for(Uint32 i = 0; i < range.num_slots; i++) {
+                    const auto slot = range.first_slot + i;
+                    const auto& object = raytracing_objects[slot];
+                    auto& desc = staged_descs[num_staged_descs + i];
+                    desc = {};
 
-                desc.Transform[1][0] = model_matrix[1][0];
-                desc.Transform[1][1] = model_matrix[1][1];
-                desc.Transform[1][2] = model_matrix[1][2];
-                desc.Transform[1][3] = model_matrix[1][3];
+                    const auto model_matrix = object.transform;
 
-                desc.Transform[2][0] = model_matrix[2][0];
-                desc.Transform[2][1] = model_matrix[2][1];
-                desc.Transform[2][2] = model_matrix[2][2];
-                desc.Transform[2][3] = model_matrix[2][3];
+                    desc.Transform[0][0] = model_matrix[0][0];
+                    desc.Transform[0][1] = model_matrix[0][1];
+                    desc.Transform[0][2] = model_matrix[0][2];
+                    desc.Transform[0][3] = model_matrix[0][3];
 
-                // TODO: Figure out if we want to use the mask to control which kind of rays can hit which objects
-                desc.InstanceMask = 0xFF;
+                    desc.Transform[1][0] = model_matrix[1][0];
+                    desc.Transform[1][1] = model_matrix[1][1];
+                    desc.Transform[1][2] = model_matrix[1][2];
+                    desc.Transform[1][3] = model_matrix[1][3];
 
-                desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE;
+                    desc.Transform[2][0] = model_matrix[2][0];
+                    desc.Transform[2][1] = model_matrix[2][1];
+                    desc.Transform[2][2] = model_matrix[2][2];
+                    desc.Transform[2][3] = model_matrix[2][3];
 
-                desc.InstanceContributionToHitGroupIndex = object.material.handle;
+                    // TODO: Figure out if we want to use the mask to control which kind of rays can hit which objects
+                    // Removed objects keep their acceleration structure and transform, so the top-level structure can still be refit, but
+                    // no ray can hit them
+                    desc.InstanceMask = raytracing_instances.is_instance_active(slot) ? 0xFF : 0;
 
-                const auto& ray_geo = raytracing_geometries[object.as_handle.index];
+                    desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE;
 
-                const auto& buffer = get_buffer(ray_geo.blas_buffer);
-                desc.AccelerationStructure = buffer->resource->GetGPUVirtualAddress();
-            }
+                    desc.InstanceContributionToHitGroupIndex = object.material.handle;
+
+                    const auto& ray_geo = raytracing_geometries[object.as_handle.index];
 
-            const auto as_inputs = D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS{
-                .Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL,
-                .Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD,
-                .NumDescs = static_cast<UINT>(raytracing_objects.size()),
-                .DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY,
-                .InstanceDescs = instance_buffer.resource->GetGPUVirtualAddress(),
+                    const auto& buffer = get_buffer(ray_geo.blas_buffer);
+                    desc.AccelerationStructure = buffer->resource->GetGPUVirtualAddress();
+                }
+
+                commands->CopyBufferRegion(instance_resource,
+                                           range.first_slot * sizeof(D3D12_RAYTRACING_INSTANCE_DESC),
+                                           staging_buffer.resource,
+                                           staging_buffer.offset + num_staged_descs * sizeof(D3D12_RAYTRACING_INSTANCE_DESC),
+                                           range.num_slots * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+                num_staged_descs += range.num_slots;
+            });
+
+            const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(instance_resource,
+                                                                      D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                      D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            commands->ResourceBarrier(1, &barrier);
+        }
+
+        // Rebuilds are rare now, so the structure is built for fast tracing rather than fast building
+        auto as_inputs = D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS{
+            .Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL,
+            .Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
+                     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE,
+            .NumDescs = num_slots,
+            .DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY,
+            .InstanceDescs = instance_resource->GetGPUVirtualAddress(),
+        };
+
+        if(update_type == RaytracingSceneUpdateType::Refit) {
+            as_inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+
+            auto scratch_buffer = backend->get_scratch_buffer(raytracing_scene_update_scratch_size);
+
+            // Refit in place. Frames that are still in flight finished tracing against the structure before this command list runs
+            const auto as_buffer = get_buffer(raytracing_scene.buffer);
+            const auto as_address = as_buffer->resource->GetGPUVirtualAddress();
+            const auto build_desc = D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC{
+                .DestAccelerationStructureData = as_address,
+                .Inputs = as_inputs,
+                .SourceAccelerationStructureData = as_address,
+                .ScratchAccelerationStructureData = scratch_buffer.resource->GetGPUVirtualAddress(),
             };
 
+            commands->BuildRaytracingAccelerationStructure(&build_desc, 0, nullptr);
+
+            const auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(*as_buffer->resource);
+            commands->ResourceBarrier(1, &barrier);
+
+            backend->return_scratch_buffer(Rx::Utility::move(scratch_buffer));
+
+        } else {
+            if(has_raytracing_scene) {
+                const auto rt_scene_buffer = get_buffer(raytracing_scene.buffer);
+                backend->schedule_buffer_destruction(*rt_scene_buffer);
+            }
+
             D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuild_info{};
             backend->device->GetRaytracingAccelerationStructurePrebuildInfo(&as_inputs, &prebuild_info);
 
@@ -1174,6 +1478,8 @@ namespace sanity::engine::renderer {
                                                          prebuild_info.ScratchDataSizeInBytes);
             prebuild_info.ResultDataMaxSizeInBytes = ALIGN(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT,
                                                            prebuild_info.ResultDataMaxSizeInBytes);
+            prebuild_info.UpdateScratchDataSizeInBytes = ALIGN(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT,
+                                                               prebuild_info.UpdateScratchDataSizeInBytes);
 
             auto scratch_buffer = backend->get_scratch_buffer(static_cast<Uint32>(prebuild_info.ScratchDataSizeInBytes));
 
@@ -1196,10 +1502,115 @@ namespace sanity::engine::renderer {
 
             raytracing_scene = {.buffer = as_buffer_handle};
             has_raytracing_scene = true;
+            raytracing_scene_update_scratch_size = static_cast<Uint32>(prebuild_info.UpdateScratchDataSizeInBytes);
 
-            backend->return_staging_buffer(Rx::Utility::move(instance_buffer));
             backend->return_scratch_buffer(Rx::Utility::move(scratch_buffer));
         }
+
+        raytracing_instances.finish_update(update_type);
+    }
+
+    Rx::Vector<BvhInstance> Renderer::get_bvh_instances(const entt::registry& registry) {
+        ZoneScoped;
+
+        auto* thread_pool = &g_engine->get_thread_pool();
+        const auto& transform_hierarchy = frame_stages->get_transform_hierarchy();
+
+        Rx::Vector<BvhInstance> instances;
+        registry.view<TransformComponent, StandardRenderableComponent>().each(
+            [&](const auto entity, const TransformComponent&, const StandardRenderableComponent& renderable) {
+                const auto* mesh_bvh = get_mesh_store(renderable.mesh).get_mesh_bvh(renderable.mesh, thread_pool);
+                if(mesh_bvh == nullptr) {
+                    return;
+                }
+
+                instances.push_back(BvhInstance{.bvh = mesh_bvh,
+                                                .world_matrix = transform_hierarchy.get_world_matrix(entity, registry),
+                                                .id = static_cast<Uint32>(entity)});
+            });
+
+        return instances;
+    }
+
+    void Renderer::compact_static_meshes(entt::registry& registry, const ComPtr<ID3D12GraphicsCommandList4>& commands) {
+        ZoneScoped;
+
+        const auto budget = r_mesh_compaction_budget->get();
+        if(budget == 0) {
+            return;
+        }
+
+        // Packed meshes aren't raytraced, so only their renderables need to follow them
+        relocate_renderables(registry, packed_mesh_storage->compact(commands, static_cast<Uint32>(budget)));
+
+        const auto relocations = static_mesh_storage->compact(commands, static_cast<Uint32>(budget));
+        if(relocations.is_empty()) {
+            return;
+        }
+
+        const auto new_mesh_by_first_index = relocate_renderables(registry, relocations);
+
+        // Bottom-level acceleration structures are built from the mesh store's buffers, so the ones with a moved mesh must be rebuilt
+        // from the mesh's new location
+        Rx::Vector<Uint8> is_geometry_moved;
+        is_geometry_moved.resize(raytracing_geometries.size(), 0);
+
+        Uint32 num_moved_geometries = 0;
+        for(Uint32 geometry_idx = 0; geometry_idx < raytracing_geometries.size(); geometry_idx++) {
+            raytracing_geometries[geometry_idx].meshes.each_fwd([&](PlacedMesh& placed_mesh) {
+                if(const auto* new_mesh = new_mesh_by_first_index.find(placed_mesh.mesh.first_index); new_mesh != nullptr) {
+                    placed_mesh.mesh = *new_mesh;
+                    is_geometry_moved[geometry_idx] = 1;
+                }
+            });
+
+            num_moved_geometries += is_geometry_moved[geometry_idx];
+        }
+
+        if(num_moved_geometries == 0) {
+            return;
+        }
+
+        logger->verbose("Rebuilding %u bottom-level acceleration structures after mesh compaction", num_moved_geometries);
+
+        const auto& vertex_buffer = static_mesh_storage->get_vertex_buffer();
+        const auto& index_buffer = static_mesh_storage->get_index_buffer();
+
+        Rx::Vector<D3D12_RESOURCE_BARRIER> barriers{2};
+        barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(*vertex_buffer.resource,
+                                                           D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+                                                           D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(*index_buffer.resource,
+                                                           D3D12_RESOURCE_STATE_INDEX_BUFFER,
+                                                           D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+        for(Uint32 geometry_idx = 0; geometry_idx < raytracing_geometries.size(); geometry_idx++) {
+            if(is_geometry_moved[geometry_idx] == 0) {
+                continue;
+            }
+
+            auto& ray_geo = raytracing_geometries[geometry_idx];
+
+            // In-flight frames may still trace against the old structure
+            backend->schedule_buffer_destruction(*get_buffer(ray_geo.blas_buffer));
+            ray_geo.blas_buffer = build_blas(vertex_buffer, index_buffer, ray_geo.meshes, commands.Get());
+        }
+
+        barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(*vertex_buffer.resource,
+                                                           D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                                           D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(*index_buffer.resource,
+                                                           D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                                                           D3D12_RESOURCE_STATE_INDEX_BUFFER);
+        commands->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+        // The instances of the rebuilt structures must point the top-level acceleration structure at the new buffers
+        for(Uint32 slot = 0; slot < raytracing_objects.size(); slot++) {
+            if(raytracing_instances.is_instance_active(slot) && is_geometry_moved[raytracing_objects[slot].as_handle.index] != 0) {
+                raytracing_instances.mark_instance_changed(slot);
+            }
+        }
     }
 
     void Renderer::update_light_data_buffer(entt::registry& registry, const Uint32 frame_idx) {
@@ -1241,6 +1652,7 @@ namespace sanity::engine::renderer {
         frame_constants.light_buffer_index = light_device_buffers[frame_idx].index;
         frame_constants.vertex_data_buffer_index = static_mesh_storage->get_vertex_buffer_handle().index;
         frame_constants.index_buffer_index = static_mesh_storage->get_index_buffer_handle().index;
+        frame_constants.mesh_dequantization_buffer_index = packed_mesh_storage->get_dequantization_buffer_handle().index;
 
         frame_constants.noise_texture_idx = noise_texture_handle.index;
 
@@ -1259,17 +1671,19 @@ namespace sanity::engine::renderer {
         memcpy(buffer->mapped_ptr, &frame_constants, sizeof(FrameConstants));
     }
 
-    BufferHandle& Renderer::get_model_matrix_for_frame(const Uint32 frame_idx) { return model_matrix_buffers[frame_idx]; }
-
-    Uint32 Renderer::add_model_matrix_to_frame(const glm::mat4& model_matrix, const Uint32 frame_idx) {
-        const auto index = next_unused_model_matrix_per_frame[frame_idx]->fetch_add(1);
+    const BufferHandle& Renderer::get_model_matrix_for_frame(const Uint32 frame_idx) const {
+        return frame_stages->get_model_matrix_buffer(frame_idx);
+    }
 
-        const auto& model_matrix_buffer = get_buffer(model_matrix_buffers[frame_idx]);
-        auto* dst = static_cast<glm::mat4*>(model_matrix_buffer->mapped_ptr);
-        memcpy(dst + index, &model_matrix, sizeof(glm::mat4));
+    Uint32 Renderer::get_model_matrix_slot(const entt::entity entity) const { return frame_stages->get_model_matrix_slot(entity); }
 
-        return index;
+    Uint32 Renderer::get_outline_model_matrix_slot(const entt::entity entity) const {
+        return frame_stages->get_outline_model_matrix_slot(entity);
     }
 
+    const ModelMatrixStats& Renderer::get_model_matrix_stats() const { return frame_stages->get_model_matrix_stats(); }
+
+    const MeshletCullingStats& Renderer::get_meshlet_culling_stats() const { return frame_stages->get_meshlet_culling_stats(); }
+
     SinglePassDownsampler& Renderer::get_spd() const { return *spd; }
 } // namespace sanity::engine::renderer
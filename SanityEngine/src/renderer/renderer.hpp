@@ -5,12 +5,17 @@
 
 #include "adapters/rex/rex_wrapper.hpp"
 #include "core/Prelude.hpp"
+#include "entt/entity/fwd.hpp"
 #include "renderer.hpp"
+#include "renderer/bvh.hpp"
 #include "renderer/camera_matrix_buffer.hpp"
+#include "renderer/d3d12_frame_backend.hpp"
+#include "renderer/frame_stages.hpp"
 #include "renderer/handles.hpp"
 #include "renderer/hlsl/shared_structs.hpp"
 #include "renderer/hlsl/standard_material.hpp"
 #include "renderer/mesh_data_store.hpp"
+#include "renderer/raytracing_instance_table.hpp"
 #include "renderer/render_components.hpp"
 #include "renderer/renderpasses/DirectLightingPass.hpp"
 #include "renderer/renderpasses/denoiser_pass.hpp"
@@ -39,32 +44,6 @@ namespace sanity::engine::renderer {
     class PostprocessingPass;
     class RenderCommandList;
 
-    /*!
-     * \brief All the information needed to decide whether or not to issue a drawcall for an object
-     */
-    struct VisibleObjectCullingInformation {
-        /*!
-         * \brief Min and max of this object's bounding box, along the x axis
-         */
-        Vec2f aabb_x_min_max{};
-
-        /*!
-         * \brief Min and max of this object's bounding box, along the y axis
-         */
-        Vec2f aabb_y_min_max{};
-
-        /*!
-         * \brief Min and max of this object's bounding box, along the z axis
-         */
-        Vec2f aabb_z_min_max{};
-
-        Mat4x4f model_matrix{};
-
-        Uint32 vertex_count{};
-
-        Uint32 start_vertex_location{};
-    };
-
     /*!
      * \brief Renderer class that uses a clustered forward lighting algorithm
      *
@@ -87,7 +66,25 @@ namespace sanity::engine::renderer {
 
         void end_frame() const;
 
-        void add_raytracing_objects_to_scene(const Rx::Vector<RaytracingObject>& new_objects);
+        /*!
+         * \brief Adds objects to the raytracing scene. The top-level acceleration structure catches up at the start of the next frame
+         *
+         * Store each handle in a RaytracingObjectComponent before the next frame. Every frame, objects follow the transform of their
+         * entity's parent, and objects which no RaytracingObjectComponent refers to any more are removed
+         *
+         * \return A handle for each of the new objects, in the same order as `new_objects`
+         */
+        Rx::Vector<RaytracingObjectHandle> add_raytracing_objects_to_scene(const Rx::Vector<RaytracingObject>& new_objects);
+
+        /*!
+         * \brief Removes an object from the raytracing scene. Invalid handles are ignored
+         */
+        void remove_raytracing_object_from_scene(RaytracingObjectHandle handle);
+
+        /*!
+         * \brief Moves an object in the raytracing scene. Moving objects only refits the top-level acceleration structure
+         */
+        void set_raytracing_object_transform(RaytracingObjectHandle handle, const glm::mat4& transform);
 
         [[nodiscard]] BufferHandle create_buffer(const BufferCreateInfo& create_info);
 
@@ -104,6 +101,26 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] TextureHandle create_texture(const TextureCreateInfo& create_info, const void* image_data);
 
+        /*!
+         * \brief Creates a texture and records the upload of its initial data into the provided command list, so that many uploads can be
+         * submitted together
+         */
+        [[nodiscard]] TextureHandle create_texture(const TextureCreateInfo& create_info,
+                                                   const void* image_data,
+                                                   ID3D12GraphicsCommandList4* cmds);
+
+        [[nodiscard]] TextureHandle create_texture(const TextureCreateInfo& create_info, const PlacedTextureData& texture_data);
+
+        /*!
+         * \brief Creates a texture from data that's already laid out for the GPU to copy, and records the copy into the provided command
+         * list. Skips repacking the data on the CPU
+         *
+         * The data has to hold as many mips as `create_info.num_mips`, or only the top mip if that's 0
+         */
+        [[nodiscard]] TextureHandle create_texture(const TextureCreateInfo& create_info,
+                                                   const PlacedTextureData& texture_data,
+                                                   ID3D12GraphicsCommandList4* cmds);
+
         [[nodiscard]] Rx::Optional<TextureHandle> get_texture_handle(const Rx::String& name);
 
         [[nodiscard]] Texture get_texture(const Rx::String& name) const;
@@ -145,9 +162,32 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] D3D12_GPU_DESCRIPTOR_HANDLE get_resource_array_gpu_descriptor(Uint32 frame_idx) const;
 
-        [[nodiscard]] BufferHandle& get_model_matrix_for_frame(Uint32 frame_idx);
+        [[nodiscard]] const BufferHandle& get_model_matrix_for_frame(Uint32 frame_idx) const;
+
+        /*!
+         * \brief Gets the index of the entity's world matrix in the model matrix buffer, or ModelMatrixStore::NO_SLOT if the entity has no
+         * matrix this frame
+         *
+         * Every entity with a StandardRenderableComponent or a FluidVolumeComponent keeps the same index for as long as it has one of those
+         * components, so all passes share it
+         */
+        [[nodiscard]] Uint32 get_model_matrix_slot(entt::entity entity) const;
+
+        /*!
+         * \brief Gets the index of the matrix to draw the entity's outline with, or ModelMatrixStore::NO_SLOT if the entity has no outline
+         */
+        [[nodiscard]] Uint32 get_outline_model_matrix_slot(entt::entity entity) const;
+
+        /*!
+         * \brief How many model matrices this frame's update changed and uploaded
+         */
+        [[nodiscard]] const ModelMatrixStats& get_model_matrix_stats() const;
 
-        [[nodiscard]] Uint32 add_model_matrix_to_frame(const glm::mat4& model_matrix, Uint32 frame_idx);
+        /*!
+         * \brief How many meshlets of the last frame's visible objects the player camera could skip. Only updated while
+         * `render.EnableMeshletCulling` is on
+         */
+        [[nodiscard]] const MeshletCullingStats& get_meshlet_culling_stats() const;
 
         void begin_device_capture() const;
 
@@ -157,10 +197,27 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] MeshDataStore& get_static_mesh_store() const;
 
+        /*!
+         * \brief Gets the mesh store for meshes of PackedVertices, which are drawn with a vertex shader that unpacks them
+         *
+         * Meshes in this store can't be raytraced, since acceleration structures are built from the static mesh store
+         */
+        [[nodiscard]] MeshDataStore& get_packed_mesh_store() const;
+
+        /*!
+         * \brief Gets the mesh store that holds a mesh, which depends on whether the mesh is packed
+         */
+        [[nodiscard]] MeshDataStore& get_mesh_store(const Mesh& mesh) const;
+
         [[nodiscard]] SinglePassDownsampler& get_spd() const;
 
         [[nodiscard]] const Rx::Vector<Texture>& get_texture_array() const;
 
+        /*!
+         * \brief How much work the last frame's update of the bindless resource array did
+         */
+        [[nodiscard]] const BindlessDescriptorStats& get_bindless_descriptor_stats() const;
+
         [[nodiscard]] TextureHandle get_noise_texture() const;
 
         [[nodiscard]] TextureHandle get_pink_texture() const;
@@ -180,15 +237,52 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] const RaytracingScene& get_raytracing_scene() const;
 
+        /*!
+         * \brief Gets all the entities with a StandardRenderableComponent that the player camera can see this frame
+         */
+        [[nodiscard]] const Rx::Vector<entt::entity>& get_visible_objects() const;
+
+        /*!
+         * \brief Gets the LOD to draw each of the visible objects with, in the same order as `get_visible_objects`. LOD 0 is the full mesh,
+         * and LOD n is the mesh's `lods[n - 1]`
+         */
+        [[nodiscard]] const Rx::Vector<Uint32>& get_visible_object_lods() const;
+
+        /*!
+         * \brief Gets the world matrices of every entity with a TransformComponent, as of the start of this frame
+         */
+        [[nodiscard]] const TransformHierarchy& get_transform_hierarchy() const;
+
+        /*!
+         * \brief Gets the instances of a two-level BVH over every renderable entity whose mesh has a BVH in the static mesh store, for
+         * tracing rays on the CPU. Pass them to `build_scene_bvh`
+         *
+         * Builds the BVHs of the meshes which don't have one yet. Only meshes that were added while the mesh store kept vertex locations
+         * can have a BVH. Each instance's ID is its entity. The instances refer to the mesh store's per-mesh BVHs, so they and any BVH
+         * built from them must not be used after any of their meshes are removed
+         */
+        [[nodiscard]] Rx::Vector<BvhInstance> get_bvh_instances(const entt::registry& registry);
+
     private:
+        friend class D3D12FrameBackend;
+
         std::chrono::high_resolution_clock::time_point start_time;
 
         glm::uvec2 output_framebuffer_size{0, 0};
 
         Rx::Ptr<RenderBackend> backend;
 
+        Rx::Ptr<D3D12FrameBackend> frame_backend;
+
+        /*!
+         * \brief The CPU side of each frame: transforms, culling, model matrices, the bindless resource array, and the render graph
+         */
+        Rx::Ptr<FrameStages> frame_stages;
+
         Rx::Ptr<MeshDataStore> static_mesh_storage;
 
+        Rx::Ptr<MeshDataStore> packed_mesh_storage;
+
         Rx::Map<Rx::String, BufferHandle> buffer_name_to_handle;
         Rx::Vector<Buffer> all_buffers;
 
@@ -216,7 +310,6 @@ namespace sanity::engine::renderer {
         Rx::Vector<BufferHandle> light_device_buffers;
 
         std::queue<Mesh> pending_raytracing_upload_meshes;
-        bool raytracing_scene_dirty{false};
 
         TextureHandle noise_texture_handle;
         TextureHandle pink_texture_handle;
@@ -225,6 +318,18 @@ namespace sanity::engine::renderer {
 
         Rx::Vector<Rx::Ptr<RenderPass>> render_passes;
 
+        /*!
+         * \brief All the resource states which let a render pass write to a resource
+         */
+        static constexpr Uint32 WRITE_RESOURCE_STATES = D3D12_RESOURCE_STATE_RENDER_TARGET | D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+                                                        D3D12_RESOURCE_STATE_DEPTH_WRITE | D3D12_RESOURCE_STATE_STREAM_OUT |
+                                                        D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+        /*!
+         * \brief Description of each render pass, in the same order as `render_passes`. Kept around so we don't reallocate it every frame
+         */
+        Rx::Vector<RenderGraphPassDescription> render_graph_passes;
+
         RenderpassHandle<EarlyDepthPass> early_depth_test{};
         RenderpassHandle<FluidSimPass> fluid_sim_pass_handle{};
         RenderpassHandle<DirectLightingPass> direct_lighting_pass_handle{};
@@ -237,9 +342,18 @@ namespace sanity::engine::renderer {
 
         ComPtr<ID3D12PipelineState> single_pass_denoiser_pipeline;
         Rx::Vector<DescriptorRange> resource_descriptors;
+
+        /*!
+         * \brief CPU-only copy of the resource array, where descriptors are created when their resource changes. Each frame's resource
+         * array copies the descriptors that changed from here
+         */
+        ComPtr<ID3D12DescriptorHeap> staging_resource_descriptors;
+
         Rx::Vector<Rx::Vector<Buffer>> buffers_on_copy_queue;
 
 #pragma region Initialization
+        void create_frame_stages();
+
         void create_static_mesh_storage();
 
         void allocate_resource_descriptors();
@@ -252,6 +366,12 @@ namespace sanity::engine::renderer {
 
         void create_builtin_images();
 
+        /*!
+         * \brief Transitions a texture out of COPY_DEST once its data has been copied in, generating its mips on the GPU if the data
+         * didn't have them
+         */
+        void finish_texture_upload(const TextureCreateInfo& create_info, const Texture& texture, ID3D12GraphicsCommandList4* cmds);
+
         void load_noise_texture(const std::filesystem::path& filepath);
 
         void create_render_passes();
@@ -269,43 +389,98 @@ namespace sanity::engine::renderer {
         void upload_material_data(Uint32 frame_idx);
 
 #pragma region Renderpasses
-        void update_resource_array_descriptors(ID3D12GraphicsCommandList* cmds, Uint32 frame_idx);
-
-        void bind_global_resources(ID3D12GraphicsCommandList* command_list) const;
-
-        void execute_all_render_passes(ComPtr<ID3D12GraphicsCommandList4>& command_list,
-                                       entt::registry& registry,
-                                       const Uint32 frame_idx,
-                                       float delta_time);
+        void write_buffer_descriptor(Uint32 buffer_idx, D3D12_CPU_DESCRIPTOR_HANDLE descriptor) const;
 
-        void issue_pre_pass_barriers(ID3D12GraphicsCommandList* command_list,
-                                     Uint32 render_pass_index,
-                                     const Rx::Ptr<RenderPass>& render_pass);
+        void write_texture_descriptors(Uint32 texture_idx,
+                                       D3D12_CPU_DESCRIPTOR_HANDLE srv_descriptor,
+                                       D3D12_CPU_DESCRIPTOR_HANDLE uav_descriptor) const;
 
-        void issue_post_pass_barriers(ID3D12GraphicsCommandList* command_list,
-                                      Uint32 render_pass_index,
-                                      const Rx::Ptr<RenderPass>& render_pass);
+        /*!
+         * \brief Binds the descriptor heap, root signature, and per-frame root constants that all render passes expect, along with the
+         * static mesh buffers and a full-screen viewport
+         */
+        void bind_global_resources(ID3D12GraphicsCommandList* command_list, Uint32 frame_idx) const;
 
-        [[nodiscard]] Rx::Map<TextureHandle, D3D12_RESOURCE_STATES> get_previous_resource_states(Uint32 cur_renderpass_index) const;
+        /*!
+         * \brief Records the render passes in the order of the render graph and submits them. With `render.ParallelPassRecording`, every
+         * pass records into its own command list on the engine's thread pool, otherwise they all record into one command list
+         *
+         * The frame stages compile the render graph and pack the transient textures, and record the passes through `frame_backend`
+         */
+        void execute_all_render_passes(entt::registry& registry, Uint32 frame_idx, float delta_time);
 
-        [[nodiscard]] Rx::Map<TextureHandle, D3D12_RESOURCE_STATES> get_next_resource_states(Uint32 cur_renderpass_index) const;
+        /*!
+         * \brief Collects the texture and buffer usages that the render passes declared into `render_graph_passes`
+         *
+         * Buffers in upload heaps are left out. They're always in D3D12_RESOURCE_STATE_GENERIC_READ, and can't be transitioned
+         */
+        void describe_render_passes();
 #pragma endregion
 
 #pragma region 3D Scene
         Rx::Vector<RaytracingAccelerationStructure> raytracing_geometries;
 
+        RaytracingInstanceTable raytracing_instances;
+
+        /*!
+         * \brief The object in each slot of `raytracing_instances`. Removed objects stay here until their slot is reused
+         */
         Rx::Vector<RaytracingObject> raytracing_objects;
 
-        Rx::Vector<BufferHandle> model_matrix_buffers;
+        /*!
+         * \brief The last frame that a RaytracingObjectComponent referred to the object in each slot, or zero if none has yet
+         */
+        Rx::Vector<Uint32> raytracing_object_last_seen_frames;
+
+        Uint32 raytracing_objects_frame{0};
+
+        Uint32 raytracing_hierarchy_num_rebuilds{0};
 
-        Rx::Vector<Rx::Ptr<Rx::Concurrency::Atomic<Uint32>>> next_unused_model_matrix_per_frame;
+        /*!
+         * \brief Instance descs of the top-level acceleration structure, one per slot of `raytracing_instances`. Only the descs of
+         * changed slots are written each frame
+         */
+        BufferHandle raytracing_instance_buffer;
+
+        Uint32 raytracing_instance_buffer_capacity{0};
+
+        /*!
+         * \brief Size of the scratch buffer that refitting the current top-level acceleration structure needs
+         */
+        Uint32 raytracing_scene_update_scratch_size{0};
 
         bool has_raytracing_scene{false};
         RaytracingScene raytracing_scene;
 
         Rx::Ptr<BufferHandle> visible_objects_buffer;
 
-        void rebuild_raytracing_scene(const ComPtr<ID3D12GraphicsCommandList4>& commands);
+        /*!
+         * \brief Records a build of a bottom-level acceleration structure over the meshes into a new buffer
+         */
+        [[nodiscard]] BufferHandle build_blas(const Buffer& vertex_buffer,
+                                              const Buffer& index_buffer,
+                                              const Rx::Vector<PlacedMesh>& meshes,
+                                              ID3D12GraphicsCommandList4* commands);
+
+        [[nodiscard]] bool is_raytracing_object_in_scene(RaytracingObjectHandle handle) const;
+
+        /*!
+         * \brief Moves the raytracing objects whose entity moved, and removes the objects whose RaytracingObjectComponent is gone
+         *
+         * Must be called after the transform hierarchy's update for this frame
+         */
+        void update_raytracing_objects(entt::registry& registry);
+
+        /*!
+         * \brief Writes the instance descs that changed since last frame, then refits or rebuilds the top-level acceleration structure
+         */
+        void update_raytracing_scene(const ComPtr<ID3D12GraphicsCommandList4>& commands);
+
+        /*!
+         * \brief Moves a few static meshes to fight fragmentation in the static and packed mesh stores, points renderables at the moved
+         * meshes, and rebuilds the bottom-level acceleration structures of the moved meshes
+         */
+        void compact_static_meshes(entt::registry& registry, const ComPtr<ID3D12GraphicsCommandList4>& commands);
 
         void update_light_data_buffer(entt::registry& registry, Uint32 frame_idx);
 
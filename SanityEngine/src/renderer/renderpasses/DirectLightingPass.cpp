@@ -40,6 +40,26 @@ namespace sanity::engine::renderer {
         });
         logger->verbose("Created standard pipeline");
 
+        packed_standard_pipeline = device.create_render_pipeline_state({
+            .name = "Packed standard material pipeline",
+            .vertex_shader = load_shader("standard_packed.vertex"),
+            .pixel_shader = load_shader("standard.pixel"),
+            .input_assembler_layout = InputAssemblerLayout::PackedVertex,
+            .render_target_formats = Rx::Array{TextureFormat::Rgba16F, TextureFormat::R32UInt},
+            .depth_stencil_format = TextureFormat::Depth32,
+        });
+
+        packed_outline_pipeline = device.create_render_pipeline_state({
+            .name = "Packed outline pipeline",
+            .vertex_shader = load_shader("standard_packed.vertex"),
+            .pixel_shader = load_shader("standard.pixel"),
+            .input_assembler_layout = InputAssemblerLayout::PackedVertex,
+            .rasterizer_state = RasterizerState{.cull_mode = CullMode::Front},
+            .render_target_formats = Rx::Array{TextureFormat::Rgba16F, TextureFormat::R32UInt},
+            .depth_stencil_format = TextureFormat::Depth32,
+        });
+        logger->verbose("Created packed standard pipeline");
+
         atmospheric_sky_pipeline = device.create_render_pipeline_state({
             .name = "Standard material pipeline",
             .vertex_shader = load_shader("fullscreen.vertex"),
@@ -153,7 +173,7 @@ namespace sanity::engine::renderer {
             .format = TextureFormat::Rgba16F,
             .width = render_resolution.x,
             .height = render_resolution.y,
-            .enable_resource_sharing = true,
+            .is_transient = true,
         };
 
         color_target_handle = renderer->create_texture(color_target_create_info);
@@ -239,60 +259,127 @@ namespace sanity::engine::renderer {
         commands->RSSetScissorRects(1, &scissor_rect);
     }
 
-    void DirectLightingPass::draw_objects_in_scene(ID3D12GraphicsCommandList4* commands, entt::registry& registry, const Uint32 frame_idx) {
+    void DirectLightingPass::draw_objects_in_scene(ID3D12GraphicsCommandList4* commands,
+                                                   entt::registry& registry,
+                                                   const Uint32 /* frame_idx */) {
         ZoneScoped;
         PIXScopedEvent(commands, forward_pass_color, "ObjectsPass::draw_objects_in_scene");
 
-        commands->SetPipelineState(standard_pipeline->pso);
+        const auto& visible_objects = renderer->get_visible_objects();
+        const auto& visible_object_lods = renderer->get_visible_object_lods();
 
-        const auto& mesh_storage = renderer->get_static_mesh_store();
-        mesh_storage.bind_to_command_list(commands);
+        const auto draw_objects = [&](const bool draw_packed_meshes) {
+            for(Size object_idx = 0; object_idx < visible_objects.size(); object_idx++) {
+                const auto entity = visible_objects[object_idx];
+                const auto& renderable = registry.get<StandardRenderableComponent>(entity);
+                if(renderable.mesh.is_packed != draw_packed_meshes) {
+                    continue;
+                }
 
-        const auto& renderable_view = registry.view<TransformComponent, StandardRenderableComponent>();
-        renderable_view.each([&](const auto entity, const TransformComponent& transform, const StandardRenderableComponent& renderable) {
-            // TODO: Frustum culling, view distance calculations, etc
+                const auto model_matrix_index = renderer->get_model_matrix_slot(entity);
+                if(model_matrix_index == ModelMatrixStore::NO_SLOT) {
+                    continue;
+                }
 
-            // TODO: Figure out the priority queues to put things in
+                // TODO: View distance calculations, etc
 
-            // TODO: Record drawcalls into an indirect command buffer rather than recording into the command list
+                // TODO: Figure out the priority queues to put things in
 
-            commands->SetGraphicsRoot32BitConstant(0, static_cast<uint32_t>(entity), RenderBackend::ENTITY_ID_ROOT_CONSTANT_OFFSET);
+                // TODO: Record drawcalls into an indirect command buffer rather than recording into the command list
 
-            commands->SetGraphicsRoot32BitConstant(0, renderable.material.index, RenderBackend::DATA_INDEX_ROOT_CONSTANT_OFFSET);
+                const auto& mesh = renderable.mesh;
+                if(!set_mesh_dequantization(commands, mesh)) {
+                    continue;
+                }
 
-            const auto model_matrix_index = renderer->add_model_matrix_to_frame(transform.get_model_matrix(registry), frame_idx);
-            commands->SetGraphicsRoot32BitConstant(0, model_matrix_index, RenderBackend::MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET);
+                commands->SetGraphicsRoot32BitConstant(0, static_cast<uint32_t>(entity), RenderBackend::ENTITY_ID_ROOT_CONSTANT_OFFSET);
 
-            commands->DrawIndexedInstanced(renderable.mesh.num_indices, 1, renderable.mesh.first_index, 0, 0);
-        });
+                commands->SetGraphicsRoot32BitConstant(0, renderable.material.index, RenderBackend::DATA_INDEX_ROOT_CONSTANT_OFFSET);
+
+                commands->SetGraphicsRoot32BitConstant(0, model_matrix_index, RenderBackend::MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET);
+
+                if(const auto lod_idx = visible_object_lods[object_idx]; lod_idx > 0) {
+                    const auto& lod = mesh.lods[lod_idx - 1];
+                    commands->DrawIndexedInstanced(lod.num_indices, 1, mesh.first_index + lod.index_offset, 0, 0);
+
+                } else {
+                    commands->DrawIndexedInstanced(mesh.num_indices, 1, mesh.first_index, 0, 0);
+                }
+            }
+        };
+
+        bind_mesh_store(commands, true, *packed_standard_pipeline);
+        draw_objects(true);
+
+        bind_mesh_store(commands, false, *standard_pipeline);
+        draw_objects(false);
     }
 
-    void DirectLightingPass::draw_outlines(ID3D12GraphicsCommandList4* commands, entt::registry& registry, Uint32 frame_idx) {
+    void DirectLightingPass::draw_outlines(ID3D12GraphicsCommandList4* commands, entt::registry& registry, Uint32 /* frame_idx */) {
         PIXScopedEvent(commands, forward_pass_color, "ObjectsPass::draw_outlines");
-        commands->SetPipelineState(outline_pipeline->pso);
 
         const auto outline_view = registry.view<TransformComponent, StandardRenderableComponent, OutlineRenderComponent>();
-        outline_view.each([&](const auto entity,
-                              const TransformComponent& transform,
-                              const StandardRenderableComponent& renderable,
-                              const OutlineRenderComponent& outline) {
-            // TODO: Culling and whatnot
+        const auto draw_outlines_of = [&](const bool draw_packed_meshes) {
+            outline_view.each([&](const auto entity,
+                                  const TransformComponent& /* transform */,
+                                  const StandardRenderableComponent& renderable,
+                                  const OutlineRenderComponent& outline) {
+                if(renderable.mesh.is_packed != draw_packed_meshes) {
+                    return;
+                }
 
-            const auto entity_id = static_cast<uint32_t>(entity);
-            commands->SetGraphicsRoot32BitConstant(0, entity_id, RenderBackend::ENTITY_ID_ROOT_CONSTANT_OFFSET);
+                // TODO: Culling and whatnot
 
-            commands->SetGraphicsRoot32BitConstant(0, outline.material.index, RenderBackend::DATA_INDEX_ROOT_CONSTANT_OFFSET);
+                // The renderer scales up the outline's matrix when it updates the model matrices
+                const auto model_matrix_index = renderer->get_outline_model_matrix_slot(entity);
+                if(model_matrix_index == ModelMatrixStore::NO_SLOT) {
+                    return;
+                }
 
-            // Intentionally a copy - I want to modify the transform for the outline without modifying the transform for the renderable
-            auto outline_transform = transform;
+                if(!set_mesh_dequantization(commands, renderable.mesh)) {
+                    return;
+                }
 
-            outline_transform.transform.scale *= outline.outline_scale;
+                const auto entity_id = static_cast<uint32_t>(entity);
+                commands->SetGraphicsRoot32BitConstant(0, entity_id, RenderBackend::ENTITY_ID_ROOT_CONSTANT_OFFSET);
 
-            const auto model_material_index = renderer->add_model_matrix_to_frame(outline_transform.get_model_matrix(registry), frame_idx);
-            commands->SetGraphicsRoot32BitConstant(0, model_material_index, RenderBackend::MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET);
+                commands->SetGraphicsRoot32BitConstant(0, outline.material.index, RenderBackend::DATA_INDEX_ROOT_CONSTANT_OFFSET);
 
-            commands->DrawIndexedInstanced(renderable.mesh.num_indices, 1, renderable.mesh.first_index, 0, 0);
-        });
+                commands->SetGraphicsRoot32BitConstant(0, model_matrix_index, RenderBackend::MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET);
+
+                commands->DrawIndexedInstanced(renderable.mesh.num_indices, 1, renderable.mesh.first_index, 0, 0);
+            });
+        };
+
+        bind_mesh_store(commands, true, *packed_outline_pipeline);
+        draw_outlines_of(true);
+
+        bind_mesh_store(commands, false, *outline_pipeline);
+        draw_outlines_of(false);
+    }
+
+    void DirectLightingPass::bind_mesh_store(ID3D12GraphicsCommandList4* commands,
+                                             const bool is_packed,
+                                             const RenderPipelineState& pipeline) const {
+        commands->SetPipelineState(pipeline.pso);
+
+        const auto& mesh_store = is_packed ? renderer->get_packed_mesh_store() : renderer->get_static_mesh_store();
+        mesh_store.bind_to_command_list(commands);
+    }
+
+    bool DirectLightingPass::set_mesh_dequantization(ID3D12GraphicsCommandList4* commands, const Mesh& mesh) const {
+        if(!mesh.is_packed) {
+            return true;
+        }
+
+        const auto dequantization_idx = renderer->get_packed_mesh_store().get_mesh_dequantization_index(mesh);
+        if(!dequantization_idx) {
+            return false;
+        }
+
+        commands->SetGraphicsRoot32BitConstant(0, *dequantization_idx, RenderBackend::MESH_DEQUANTIZATION_INDEX_ROOT_CONSTANT_OFFSET);
+
+        return true;
     }
 
     void DirectLightingPass::draw_atmosphere(ID3D12GraphicsCommandList4* commands, entt::registry& registry) const {
@@ -5,6 +5,7 @@
 #include "glm/vec2.hpp"
 #include "renderer/debugging/pix.hpp"
 #include "renderer/handles.hpp"
+#include "renderer/mesh.hpp"
 #include "renderer/render_pass.hpp"
 #include "renderer/rhi/descriptor_allocator.hpp"
 #include "renderer/rhi/framebuffer.hpp"
@@ -39,6 +40,12 @@ namespace sanity::engine::renderer {
 
         Rx::Ptr<RenderPipelineState> standard_pipeline;
         Rx::Ptr<RenderPipelineState> outline_pipeline;
+
+        /*!
+         * \brief Same as the standard and outline pipelines, but for meshes in the packed mesh store
+         */
+        Rx::Ptr<RenderPipelineState> packed_standard_pipeline;
+        Rx::Ptr<RenderPipelineState> packed_outline_pipeline;
         Rx::Ptr<RenderPipelineState> atmospheric_sky_pipeline;
 
         TextureHandle color_target_handle;
@@ -69,6 +76,20 @@ namespace sanity::engine::renderer {
 
         void draw_outlines(ID3D12GraphicsCommandList4* commands, entt::registry& registry, Uint32 frame_idx);
 
+        /*!
+         * \brief Binds the mesh store that a mesh is in, and the pipeline for that store's vertices
+         *
+         * Packed meshes are drawn before the others, so that the static mesh store is bound again once the pass is done with its draws
+         */
+        void bind_mesh_store(ID3D12GraphicsCommandList4* commands, bool is_packed, const RenderPipelineState& pipeline) const;
+
+        /*!
+         * \brief Sets the root constant for the dequantization of the mesh that's about to be drawn, if the mesh is packed
+         *
+         * \return False if the mesh is packed but isn't in the packed mesh store, so it can't be drawn
+         */
+        [[nodiscard]] bool set_mesh_dequantization(ID3D12GraphicsCommandList4* commands, const Mesh& mesh) const;
+
         void draw_atmosphere(ID3D12GraphicsCommandList4* commands, entt::registry& registry) const;
 
         void copy_render_targets(ID3D12GraphicsCommandList4* commands) const;
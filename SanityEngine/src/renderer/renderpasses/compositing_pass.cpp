@@ -52,7 +52,8 @@ namespace sanity::engine::renderer {
                                                                    .format = TextureFormat::Rgba16F,
                                                                    .width = output_size.x,
                                                                    .height = output_size.y,
-                                                                   .depth = 1});
+                                                                   .depth = 1,
+                                                                   .is_transient = true});
         set_resource_usage(output_handle, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     }
 
@@ -35,6 +35,11 @@ namespace sanity::engine::renderer {
 
         set_resource_usage(accumulation_target_handle, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
         set_resource_usage(denoised_color_target_handle, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+        // The accumulation shader reads the direct lighting results through the bindless texture array. The render graph needs to know
+        // about that so it keeps the scene color target alive until this pass is done with it
+        set_resource_usage(forward_pass.get_color_target_handle(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        set_resource_usage(forward_pass.get_depth_target_handle(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
     }
 
     void DenoiserPass::record_work(ID3D12GraphicsCommandList4* commands,
@@ -111,7 +116,7 @@ namespace sanity::engine::renderer {
                 .format = TextureFormat::Rgba16F,
                 .width = render_resolution.x,
                 .height = render_resolution.y,
-                .enable_resource_sharing = true,
+                .is_transient = true,
             };
             denoised_color_target_handle = renderer->create_texture(color_target_create_info);
 
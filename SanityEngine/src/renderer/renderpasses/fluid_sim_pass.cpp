@@ -84,10 +84,14 @@ namespace sanity::engine::renderer {
         fluid_volume_states.reserve(fluid_sims_view.size());
 
         fluid_sims_view.each(
-            [&](const entt::entity& entity, const TransformComponent& transform, const FluidVolumeComponent& fluid_volume_component) {
+            [&](const entt::entity& entity, const TransformComponent& /* transform */, const FluidVolumeComponent& fluid_volume_component) {
                 auto& fluid_volume = renderer->get_fluid_volume(fluid_volume_component.volume);
 
-                const auto model_matrix_index = renderer->add_model_matrix_to_frame(transform.get_model_matrix(registry), frame_idx);
+                const auto model_matrix_index = renderer->get_model_matrix_slot(entity);
+                if(model_matrix_index == ModelMatrixStore::NO_SLOT) {
+                    return;
+                }
+
                 const ObjectDrawData instance_data{.data_idx = fluid_volume_component.volume.index,
                                                    .entity_id = static_cast<Uint32>(entity),
                                                    .model_matrix_idx = model_matrix_index};
@@ -410,6 +414,7 @@ namespace sanity::engine::renderer {
             .width = render_resolution.x,
             .height = render_resolution.y,
             .depth = 1,
+            .is_transient = true,
         });
         const auto& render_target = renderer->get_texture(fluid_color_texture);
         auto& backend = renderer->get_render_backend();
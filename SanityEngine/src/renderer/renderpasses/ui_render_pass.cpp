@@ -132,14 +132,15 @@ namespace sanity::engine::renderer {
                 const auto vertex_buffer_size = static_cast<Uint32>(cmd_list->VtxBuffer.size_in_bytes());
                 const auto index_buffer_size = static_cast<Uint32>(cmd_list->IdxBuffer.size_in_bytes());
 
-                auto vertex_buffer = device.get_staging_buffer(vertex_buffer_size);
+                const auto vertex_buffer = device.get_staging_buffer(vertex_buffer_size);
                 memcpy(vertex_buffer.mapped_ptr, imgui_vertices, vertex_buffer_size);
 
-                auto index_buffer = device.get_staging_buffer(index_buffer_size);
+                const auto index_buffer = device.get_staging_buffer(index_buffer_size);
                 memcpy(index_buffer.mapped_ptr, imgui_indices, index_buffer_size);
 
                 {
-                    const auto vb_view = D3D12_VERTEX_BUFFER_VIEW{.BufferLocation = vertex_buffer.resource->GetGPUVirtualAddress(),
+                    const auto vb_view = D3D12_VERTEX_BUFFER_VIEW{.BufferLocation = vertex_buffer.resource->GetGPUVirtualAddress() +
+                                                                                    vertex_buffer.offset,
                                                                   .SizeInBytes = static_cast<Uint32>(vertex_buffer.size),
                                                                   .StrideInBytes = sizeof(ImDrawVert)};
                     commands->IASetVertexBuffers(0, 1, &vb_view);
@@ -147,7 +148,8 @@ namespace sanity::engine::renderer {
                     const auto index_buffer_format = sizeof(ImDrawIdx) == sizeof(unsigned int) ? DXGI_FORMAT_R32_UINT :
                                                                                                  DXGI_FORMAT_R16_UINT;
 
-                    const auto ib_view = D3D12_INDEX_BUFFER_VIEW{.BufferLocation = index_buffer.resource->GetGPUVirtualAddress(),
+                    const auto ib_view = D3D12_INDEX_BUFFER_VIEW{.BufferLocation = index_buffer.resource->GetGPUVirtualAddress() +
+                                                                                   index_buffer.offset,
                                                                  .SizeInBytes = static_cast<Uint32>(index_buffer.size),
                                                                  .Format = index_buffer_format};
                     commands->IASetIndexBuffer(&ib_view);
@@ -181,12 +183,6 @@ namespace sanity::engine::renderer {
                         commands->DrawIndexedInstanced(cmd.ElemCount, 1, cmd.IdxOffset, 0, 0);
                     }
                 }
-
-                {
-                    ZoneScopedN("Free vertex and index buffers");
-                    device.return_staging_buffer(Rx::Utility::move(vertex_buffer));
-                    device.return_staging_buffer(Rx::Utility::move(index_buffer));
-                }
             }
         }
         commands->EndRenderPass();
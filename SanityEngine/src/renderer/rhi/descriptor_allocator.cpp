@@ -1,61 +1,104 @@
 #include "descriptor_allocator.hpp"
 
 #include "d3dx12.hpp"
+#include "rx/core/abort.h"
+#include "rx/core/log.h"
 
 namespace sanity::engine::renderer {
-    DescriptorAllocator::DescriptorAllocator(ComPtr<ID3D12DescriptorHeap> heap_in, const UINT descriptor_size_in)
-        : heap{Rx::Utility::move(heap_in)}, descriptor_size{descriptor_size_in} {}
-
-    DescriptorAllocator::DescriptorAllocator(DescriptorAllocator&& old) noexcept
-        : heap{Rx::Utility::move(old.heap)},
-          descriptor_size{old.descriptor_size},
-          next_free_descriptor{old.next_free_descriptor},
-          available_ranges{Rx::Utility::move(old.available_ranges)} {}
-
-    DescriptorAllocator& DescriptorAllocator::operator=(DescriptorAllocator&& old) noexcept {
-        heap = Rx::Utility::move(old.heap);
-        descriptor_size = old.descriptor_size;
-        next_free_descriptor = old.next_free_descriptor;
-        available_ranges = Rx::Utility::move(old.available_ranges);
-
-        return *this;
-    }
+    RX_LOG("DescriptorAllocator", logger);
+
+    DescriptorAllocator::DescriptorAllocator(ComPtr<ID3D12DescriptorHeap> heap_in,
+                                             const UINT descriptor_size_in,
+                                             const Uint32 num_transient_descriptors,
+                                             const Uint32 num_frames)
+        : heap{Rx::Utility::move(heap_in)},
+          descriptor_size{descriptor_size_in},
+          persistent_descriptors{heap->GetDesc().NumDescriptors - num_transient_descriptors},
+          transient_descriptors{num_transient_descriptors, num_frames},
+          frame_descriptor_offsets{num_frames},
+          transient_descriptors_start{heap->GetDesc().NumDescriptors - num_transient_descriptors} {}
 
     DescriptorRange DescriptorAllocator::allocate_descriptors(const Uint32 num_descriptors) {
         RX_ASSERT(num_descriptors > 0, "num_descriptors must be greater than 0!");
 
-        Size best_match_idx = available_ranges.size();
-        Uint32 waste_in_best_match = 0xFFFFFFFF;
-        for(Uint32 i = 0; i < available_ranges.size(); i++) {
-            const auto& range = available_ranges[i];
-            if(range.table_size >= num_descriptors && range.table_size - num_descriptors < waste_in_best_match) {
-                best_match_idx = i;
-                waste_in_best_match = range.table_size - num_descriptors;
+        Rx::Concurrency::ScopeLock lock{persistent_descriptors_mutex};
+
+        const auto allocation = persistent_descriptors.allocate(num_descriptors);
+        if(!allocation) {
+            Rx::abort("Could not allocate %u descriptors, the descriptor heap is full", num_descriptors);
+        }
+
+        return make_descriptor_range(allocation->offset, num_descriptors);
+    }
+
+    void DescriptorAllocator::free_descriptor_range(const DescriptorRange handle) {
+        const auto offset = (handle.cpu_handle.ptr - heap->GetCPUDescriptorHandleForHeapStart().ptr) / descriptor_size;
+
+        Rx::Concurrency::ScopeLock lock{persistent_descriptors_mutex};
+        persistent_descriptors.free(static_cast<Uint32>(offset));
+    }
+
+    DescriptorRange DescriptorAllocator::allocate_transient_descriptors(const Uint32 num_descriptors) {
+        const auto offset = transient_descriptors.allocate(num_descriptors);
+        if(!offset) {
+            if(!has_reported_full_ring) {
+                logger->warning("The frames in flight use %u of %u transient descriptors, so %u more come from the persistent descriptors",
+                                transient_descriptors.get_used_units(),
+                                transient_descriptors.get_capacity(),
+                                num_descriptors);
+                has_reported_full_ring = true;
             }
+
+            return allocate_frame_descriptors(num_descriptors);
         }
 
-        if(best_match_idx != available_ranges.size()) {
-            const auto range = available_ranges[best_match_idx];
-            available_ranges.erase(best_match_idx, best_match_idx + 1);
+        return make_descriptor_range(transient_descriptors_start + *offset, num_descriptors);
+    }
+
+    DescriptorRange DescriptorAllocator::allocate_frame_descriptors(const Uint32 num_descriptors) {
+        RX_ASSERT(num_descriptors > 0, "num_descriptors must be greater than 0!");
+
+        Rx::Concurrency::ScopeLock lock{persistent_descriptors_mutex};
 
-            return range;
+        const auto allocation = persistent_descriptors.allocate(num_descriptors);
+        if(!allocation) {
+            Rx::abort("Could not allocate %u descriptors for this frame, the descriptor heap is full", num_descriptors);
         }
 
-        const auto cpu_handle = CD3DX12_CPU_DESCRIPTOR_HANDLE{heap->GetCPUDescriptorHandleForHeapStart(),
-                                                              next_free_descriptor,
-                                                              descriptor_size};
-        const auto gpu_handle = CD3DX12_GPU_DESCRIPTOR_HANDLE{heap->GetGPUDescriptorHandleForHeapStart(),
-                                                              next_free_descriptor,
-                                                              descriptor_size};
+        frame_descriptor_offsets[cur_frame_idx].push_back(allocation->offset);
 
-        next_free_descriptor += num_descriptors;
+        return make_descriptor_range(allocation->offset, num_descriptors);
+    }
 
-        return {cpu_handle, gpu_handle, num_descriptors};
+    void DescriptorAllocator::begin_frame(const Uint32 frame_idx) {
+        transient_descriptors.begin_frame(frame_idx);
+
+        Rx::Concurrency::ScopeLock lock{persistent_descriptors_mutex};
+
+        auto& offsets = frame_descriptor_offsets[frame_idx];
+        offsets.each_fwd([&](const Uint32 offset) { persistent_descriptors.free(offset); });
+        offsets.clear();
+
+        cur_frame_idx = frame_idx;
     }
 
-    void DescriptorAllocator::free_descriptor_range(const DescriptorRange handle) { available_ranges.push_back(handle); }
+    RangeAllocatorStats DescriptorAllocator::get_persistent_descriptor_stats() const {
+        Rx::Concurrency::ScopeLock lock{persistent_descriptors_mutex};
+        return persistent_descriptors.get_stats();
+    }
 
     UINT DescriptorAllocator::get_descriptor_size() const { return descriptor_size; }
 
     ID3D12DescriptorHeap* DescriptorAllocator::get_heap() const { return heap; }
+
+    DescriptorRange DescriptorAllocator::make_descriptor_range(const Uint32 offset, const Uint32 num_descriptors) const {
+        const auto cpu_handle = CD3DX12_CPU_DESCRIPTOR_HANDLE{heap->GetCPUDescriptorHandleForHeapStart(),
+                                                              static_cast<INT>(offset),
+                                                              descriptor_size};
+        const auto gpu_handle = CD3DX12_GPU_DESCRIPTOR_HANDLE{heap->GetGPUDescriptorHandleForHeapStart(),
+                                                              static_cast<INT>(offset),
+                                                              descriptor_size};
+
+        return {cpu_handle, gpu_handle, num_descriptors};
+    }
 } // namespace sanity::engine::renderer
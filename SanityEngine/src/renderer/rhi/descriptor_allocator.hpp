@@ -2,8 +2,11 @@
 
 #include <d3d12.h>
 
+#include "core/range_allocator.hpp"
+#include "core/ring_allocator.hpp"
 #include "core/types.hpp"
 #include "d3dx12.hpp"
+#include "rx/core/concurrency/mutex.h"
 #include "rx/core/vector.h"
 
 namespace sanity::engine::renderer {
@@ -14,15 +17,32 @@ namespace sanity::engine::renderer {
         Uint32 table_size;
     };
 
+    /*!
+     * \brief Allocates ranges of descriptors from a descriptor heap
+     *
+     * The start of the heap holds persistent descriptors, which live until they're explicitly freed. They're managed by a RangeAllocator,
+     * so freed ranges are split and coalesced instead of fragmenting the heap forever. The end of the heap is a ring of transient
+     * descriptors which are only valid for the frame they were allocated in, and which any thread may allocate
+     *
+     * If the frames in flight use up the whole ring, transient descriptors spill over into the persistent descriptors and get freed once
+     * the frame is done, so a burst of transient descriptors costs heap space instead of crashing
+     */
     class DescriptorAllocator {
     public:
-        DescriptorAllocator(ComPtr<ID3D12DescriptorHeap> heap_in, UINT descriptor_size_in);
+        /*!
+         * \param num_transient_descriptors Number of descriptors at the end of the heap to reserve for transient descriptors
+         * \param num_frames Number of frames that may be in flight at once
+         */
+        DescriptorAllocator(ComPtr<ID3D12DescriptorHeap> heap_in,
+                            UINT descriptor_size_in,
+                            Uint32 num_transient_descriptors = 0,
+                            Uint32 num_frames = 1);
 
         DescriptorAllocator(const DescriptorAllocator& other) = delete;
         DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
 
-        DescriptorAllocator(DescriptorAllocator&& old) noexcept;
-        DescriptorAllocator& operator=(DescriptorAllocator&& old) noexcept;
+        DescriptorAllocator(DescriptorAllocator&& old) noexcept = delete;
+        DescriptorAllocator& operator=(DescriptorAllocator&& old) noexcept = delete;
 
         ~DescriptorAllocator() = default;
 
@@ -30,6 +50,27 @@ namespace sanity::engine::renderer {
 
         void free_descriptor_range(DescriptorRange handle);
 
+        /*!
+         * \brief Allocates descriptors which are only valid until the GPU finishes the current frame. May be called from any thread
+         */
+        [[nodiscard]] DescriptorRange allocate_transient_descriptors(Uint32 num_descriptors);
+
+        /*!
+         * \brief Allocates persistent descriptors which are freed when the GPU finishes the current frame. May be called from any thread
+         *
+         * For work which may need more descriptors in one frame than the transient ring holds, such as generating the mips of every
+         * texture that a level loads
+         */
+        [[nodiscard]] DescriptorRange allocate_frame_descriptors(Uint32 num_descriptors);
+
+        /*!
+         * \brief Reclaims the transient and frame descriptors of the last frame that used the frame index `frame_idx`. The GPU must be
+         * done with that frame
+         */
+        void begin_frame(Uint32 frame_idx);
+
+        [[nodiscard]] RangeAllocatorStats get_persistent_descriptor_stats() const;
+
         [[nodiscard]] UINT get_descriptor_size() const;
 
         [[nodiscard]] ID3D12DescriptorHeap* get_heap() const;
@@ -39,8 +80,30 @@ namespace sanity::engine::renderer {
 
         UINT descriptor_size;
 
-        INT next_free_descriptor{0};
+        RangeAllocator persistent_descriptors;
+
+        /*!
+         * \brief Guards the persistent descriptors and the frame descriptors, which loading threads allocate while the render thread
+         * frees them
+         */
+        mutable Rx::Concurrency::Mutex persistent_descriptors_mutex;
+
+        RingAllocator transient_descriptors;
+
+        /*!
+         * \brief Offsets of the frame descriptors that each frame allocated, which are freed when the frame begins again
+         */
+        Rx::Vector<Rx::Vector<Uint32>> frame_descriptor_offsets;
+
+        Uint32 cur_frame_idx{0};
+
+        bool has_reported_full_ring{false};
+
+        /*!
+         * \brief Index of the first transient descriptor in the heap
+         */
+        Uint32 transient_descriptors_start;
 
-        Rx::Vector<DescriptorRange> available_ranges;
+        [[nodiscard]] DescriptorRange make_descriptor_range(Uint32 offset, Uint32 num_descriptors) const;
     };
 } // namespace sanity::engine::renderer
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/hlsl/mesh_data.hpp"
+#include "renderer/mesh.hpp"
+#include "renderer/render_graph.hpp"
+#include "renderer/rhi/resources.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief Everything the CPU side of a frame asks of the GPU backend
+     *
+     * FrameStages only talks to the GPU through this interface. The renderer puts its D3D12 device behind it, and NullRenderBackend
+     * records the calls into a RenderTrace instead, so the same stages run headless without a D3D12 device
+     *
+     * Render passes record into command lists which the backend owns. FrameStages refers to them by index, between
+     * `begin_render_passes` and `end_render_passes`. Different command lists may be recorded on different threads at the same time, but
+     * each command list must only be recorded on one thread
+     */
+    class FrameBackend {
+    public:
+        virtual ~FrameBackend() = default;
+
+        [[nodiscard]] virtual Uint32 get_max_num_gpu_frames() const = 0;
+
+#pragma region Resources
+        /*!
+         * \brief Creates a buffer which the CPU writes to directly, and gives it a descriptor in the bindless resource array
+         *
+         * \return The new buffer, or an invalid handle if it couldn't be created
+         */
+        [[nodiscard]] virtual BufferHandle create_upload_buffer(const Rx::String& name, Uint32 size) = 0;
+
+        /*!
+         * \brief Copies data into a buffer from `create_upload_buffer`. The GPU only reads the buffer when it executes the frame that the
+         * buffer belongs to, so the data may be written at any point while the frame is recorded
+         */
+        virtual void write_buffer(BufferHandle buffer, Uint64 offset, const void* data, Uint64 num_bytes) = 0;
+
+        /*!
+         * \brief Gets the bounds that the mesh store which holds a mesh computed for it, if it has any
+         */
+        [[nodiscard]] virtual Rx::Optional<BoundingBox> get_mesh_bounds(const Mesh& mesh) const = 0;
+
+        /*!
+         * \brief Gets the bounds of a mesh's meshlets, or nullptr if the mesh has no meshlets
+         */
+        [[nodiscard]] virtual const Rx::Vector<MeshletBounds>* get_meshlet_bounds(const Mesh& mesh) const = 0;
+#pragma endregion
+
+#pragma region Descriptors
+        /*!
+         * \brief Creates the buffer's descriptor in the CPU-only copy of the bindless resource array. Destroyed buffers get a null
+         * descriptor
+         */
+        virtual void write_buffer_descriptor(Uint32 buffer_idx, Uint32 descriptor_idx) = 0;
+
+        /*!
+         * \brief Creates the texture's SRV and UAV in the CPU-only copy of the bindless resource array. Destroyed textures, and textures
+         * which can't be used as a UAV, get null descriptors
+         */
+        virtual void write_texture_descriptors(Uint32 texture_idx, Uint32 srv_descriptor_idx, Uint32 uav_descriptor_idx) = 0;
+
+        /*!
+         * \brief Copies a range of descriptors from the CPU-only copy of the resource array into the frame's copy
+         */
+        virtual void copy_descriptors(Uint32 frame_idx, Uint32 first_descriptor, Uint32 num_descriptors) = 0;
+#pragma endregion
+
+#pragma region Transient textures
+        /*!
+         * \brief Number of bytes of the transient texture heap that the texture needs
+         */
+        [[nodiscard]] virtual Uint64 get_transient_texture_size(Uint32 texture_idx) const = 0;
+
+        /*!
+         * \brief Places the transient textures at the offsets into a transient texture heap of `heap_size` bytes. A heap size of 0 gives
+         * the heap back
+         *
+         * \return True if the heap could be allocated
+         */
+        virtual bool map_transient_textures(const Rx::Vector<Uint32>& texture_indices,
+                                            const Rx::Vector<Uint64>& offsets,
+                                            Uint64 heap_size) = 0;
+#pragma endregion
+
+#pragma region Render passes
+        virtual void begin_render_passes(Uint32 num_command_lists) = 0;
+
+        virtual void resource_barriers(Uint32 command_list_idx, const Rx::Vector<RenderGraphBarrier>& barriers) = 0;
+
+        /*!
+         * \brief Activates transient textures which share memory with other transient textures, before the first pass which uses them
+         *
+         * \param usages How that pass uses each of the textures. Resources are texture indices
+         */
+        virtual void activate_transient_textures(Uint32 command_list_idx, const Rx::Vector<RenderGraphResourceUsage>& usages) = 0;
+
+        virtual void execute_pass(Uint32 command_list_idx, Uint32 pass_idx) = 0;
+
+        /*!
+         * \brief Submits the command lists in the order of their indices
+         */
+        virtual void end_render_passes() = 0;
+#pragma endregion
+    };
+} // namespace sanity::engine::renderer
@@ -41,6 +41,21 @@ namespace sanity::engine::renderer {
             case TextureFormat::Depth24Stencil8:
                 return DXGI_FORMAT_D24_UNORM_S8_UINT;
 
+            case TextureFormat::Bc1:
+                return DXGI_FORMAT_BC1_UNORM;
+
+            case TextureFormat::Bc3:
+                return DXGI_FORMAT_BC3_UNORM;
+
+            case TextureFormat::Bc4:
+                return DXGI_FORMAT_BC4_UNORM;
+
+            case TextureFormat::Bc5:
+                return DXGI_FORMAT_BC5_UNORM;
+
+            case TextureFormat::Bc7:
+                return DXGI_FORMAT_BC7_UNORM;
+
             default:
                 return DXGI_FORMAT_R8G8B8A8_UNORM;
         }
@@ -511,12 +526,10 @@ namespace sanity::engine::renderer {
                                          const void* src,
                                          const Uint32 size,
                                          const Uint32 dst_offset) {
-        auto staging_buffer = device.get_staging_buffer(size);
+        const auto staging_buffer = device.get_staging_buffer(size);
         memcpy(staging_buffer.mapped_ptr, src, size);
 
-        commands->CopyBufferRegion(dst, dst_offset, staging_buffer.resource, 0, size);
-
-        device.return_staging_buffer(Rx::Utility::move(staging_buffer));
+        commands->CopyBufferRegion(dst, dst_offset, staging_buffer.resource, staging_buffer.offset, size);
     }
 
     Rx::String breadcrumb_op_to_string(const D3D12_AUTO_BREADCRUMB_OP op) {
@@ -0,0 +1,173 @@
+#include "null_render_backend.hpp"
+
+#include <cstring>
+
+#include "Tracy.hpp"
+#include "rx/core/abort.h"
+
+namespace sanity::engine::renderer {
+    NullRenderBackend::NullRenderBackend(const Uint32 num_gpu_frames_in)
+        : num_gpu_frames{num_gpu_frames_in},
+          buffer_deletion_list{num_gpu_frames_in},
+          texture_deletion_list{num_gpu_frames_in},
+          staging_ring{STAGING_RING_CHUNK_SIZE, num_gpu_frames_in} {}
+
+    void NullRenderBackend::begin_frame(const Uint64 frame_count) {
+        ZoneScoped;
+
+        trace.set_frame(frame_count);
+        trace.record(RenderTraceOp::BeginFrame, cur_gpu_frame_idx);
+
+        // There's no GPU to wait for, so everything the last frame with this index used can be recycled right away
+        staging_ring.begin_frame(cur_gpu_frame_idx);
+
+        destroy_resources(buffers, buffer_deletion_list[cur_gpu_frame_idx]);
+        destroy_resources(textures, texture_deletion_list[cur_gpu_frame_idx]);
+    }
+
+    void NullRenderBackend::end_frame() {
+        trace.record(RenderTraceOp::EndFrame, cur_gpu_frame_idx);
+
+        cur_gpu_frame_idx = (cur_gpu_frame_idx + 1) % num_gpu_frames;
+    }
+
+    Uint32 NullRenderBackend::get_cur_gpu_frame_idx() const { return cur_gpu_frame_idx; }
+
+    BufferHandle NullRenderBackend::create_buffer(const Rx::String& name, const Uint64 size) {
+        const auto buffer = BufferHandle{static_cast<Uint32>(buffers.size())};
+        buffers.push_back(NullResource{.name = name, .size = size});
+
+        trace.record(RenderTraceOp::CreateBuffer, buffer.index, size);
+
+        return buffer;
+    }
+
+    TextureHandle NullRenderBackend::create_texture(const Rx::String& name, const Uint64 size) {
+        const auto texture = TextureHandle{static_cast<Uint32>(textures.size())};
+        textures.push_back(NullResource{.name = name, .size = size});
+
+        trace.record(RenderTraceOp::CreateTexture, texture.index, size);
+
+        return texture;
+    }
+
+    void NullRenderBackend::schedule_buffer_destruction(const BufferHandle buffer) {
+        RX_ASSERT(buffers[buffer.index].is_alive, "Buffer %u was already destroyed", buffer.index);
+        buffer_deletion_list[cur_gpu_frame_idx].push_back(buffer.index);
+    }
+
+    void NullRenderBackend::schedule_texture_destruction(const TextureHandle texture) {
+        RX_ASSERT(textures[texture.index].is_alive, "Texture %u was already destroyed", texture.index);
+        texture_deletion_list[cur_gpu_frame_idx].push_back(texture.index);
+    }
+
+    const NullResource& NullRenderBackend::get_buffer(const BufferHandle buffer) const { return buffers[buffer.index]; }
+
+    const NullResource& NullRenderBackend::get_texture(const TextureHandle texture) const { return textures[texture.index]; }
+
+    Mesh NullRenderBackend::add_mesh(const BoundingBox& bounds, const Rx::Vector<MeshletBounds>& meshlet_bounds) {
+        const auto mesh = Mesh{.first_index = static_cast<Uint32>(meshes.size())};
+        meshes.push_back(NullMesh{.bounds = bounds, .meshlet_bounds = meshlet_bounds});
+
+        return mesh;
+    }
+
+    const StagingRingStats& NullRenderBackend::get_staging_ring_stats() const { return staging_ring.get_last_frame_stats(); }
+
+    RenderTrace& NullRenderBackend::get_trace() { return trace; }
+
+    const RenderTrace& NullRenderBackend::get_trace() const { return trace; }
+
+    Uint32 NullRenderBackend::get_max_num_gpu_frames() const { return num_gpu_frames; }
+
+    BufferHandle NullRenderBackend::create_upload_buffer(const Rx::String& name, const Uint32 size) { return create_buffer(name, size); }
+
+    void NullRenderBackend::write_buffer(const BufferHandle buffer, const Uint64 offset, const void* data, const Uint64 num_bytes) {
+        RX_ASSERT(offset + num_bytes <= buffers[buffer.index].size, "Write to buffer %u is out of bounds", buffer.index);
+
+        const auto allocation = staging_ring.allocate(num_bytes, DEFAULT_STAGING_BUFFER_ALIGNMENT);
+
+        while(staging_ring_chunks.size() < staging_ring.get_num_chunks()) {
+            const auto chunk_idx = static_cast<Uint32>(staging_ring_chunks.size());
+            staging_ring_chunks.push_back({});
+            staging_ring_chunks.last().resize(staging_ring.get_chunk_size(chunk_idx));
+        }
+
+        memcpy(staging_ring_chunks[allocation.chunk_idx].data() + allocation.offset, data, num_bytes);
+
+        trace.record(RenderTraceOp::Upload, buffer.index, num_bytes);
+    }
+
+    Rx::Optional<BoundingBox> NullRenderBackend::get_mesh_bounds(const Mesh& mesh) const {
+        if(mesh.first_index >= meshes.size()) {
+            return Rx::nullopt;
+        }
+
+        return meshes[mesh.first_index].bounds;
+    }
+
+    const Rx::Vector<MeshletBounds>* NullRenderBackend::get_meshlet_bounds(const Mesh& mesh) const {
+        if(mesh.first_index >= meshes.size()) {
+            return nullptr;
+        }
+
+        return &meshes[mesh.first_index].meshlet_bounds;
+    }
+
+    void NullRenderBackend::write_buffer_descriptor(const Uint32 buffer_idx, const Uint32 /* descriptor_idx */) {
+        trace.record(RenderTraceOp::WriteDescriptors, buffer_idx, 1);
+    }
+
+    void NullRenderBackend::write_texture_descriptors(const Uint32 texture_idx,
+                                                      const Uint32 /* srv_descriptor_idx */,
+                                                      const Uint32 /* uav_descriptor_idx */) {
+        trace.record(RenderTraceOp::WriteDescriptors, texture_idx, 2);
+    }
+
+    void NullRenderBackend::copy_descriptors(const Uint32 /* frame_idx */, const Uint32 first_descriptor, const Uint32 num_descriptors) {
+        trace.record(RenderTraceOp::CopyDescriptors, first_descriptor, num_descriptors);
+    }
+
+    Uint64 NullRenderBackend::get_transient_texture_size(const Uint32 texture_idx) const { return textures[texture_idx].size; }
+
+    bool NullRenderBackend::map_transient_textures(const Rx::Vector<Uint32>& texture_indices,
+                                                   const Rx::Vector<Uint64>& /* offsets */,
+                                                   const Uint64 heap_size) {
+        trace.record(RenderTraceOp::MapTransientResources, static_cast<Uint32>(texture_indices.size()), heap_size);
+
+        return true;
+    }
+
+    void NullRenderBackend::begin_render_passes(const Uint32 num_command_lists) {
+        command_lists.resize(num_command_lists);
+        command_lists.each_fwd([](Rx::Vector<RenderTraceEvent>& events) { events.clear(); });
+    }
+
+    void NullRenderBackend::resource_barriers(const Uint32 command_list_idx, const Rx::Vector<RenderGraphBarrier>& barriers) {
+        command_lists[command_list_idx].push_back(
+            RenderTraceEvent{.op = RenderTraceOp::ResourceBarriers, .amount = static_cast<Uint64>(barriers.size())});
+    }
+
+    void NullRenderBackend::activate_transient_textures(const Uint32 command_list_idx, const Rx::Vector<RenderGraphResourceUsage>& usages) {
+        command_lists[command_list_idx].push_back(
+            RenderTraceEvent{.op = RenderTraceOp::ActivateTransientResources, .amount = static_cast<Uint64>(usages.size())});
+    }
+
+    void NullRenderBackend::execute_pass(const Uint32 command_list_idx, const Uint32 pass_idx) {
+        command_lists[command_list_idx].push_back(RenderTraceEvent{.op = RenderTraceOp::ExecutePass, .id = pass_idx});
+    }
+
+    void NullRenderBackend::end_render_passes() {
+        command_lists.each_fwd([&](const Rx::Vector<RenderTraceEvent>& events) {
+            events.each_fwd([&](const RenderTraceEvent& event) { trace.record(event.op, event.id, event.amount); });
+        });
+    }
+
+    void NullRenderBackend::destroy_resources(Rx::Vector<NullResource>& resources, Rx::Vector<Uint32>& resources_to_destroy) {
+        resources_to_destroy.each_fwd([&](const Uint32 resource) {
+            resources[resource].is_alive = false;
+            trace.record(RenderTraceOp::DestroyResource, resource, resources[resource].size);
+        });
+        resources_to_destroy.clear();
+    }
+} // namespace sanity::engine::renderer
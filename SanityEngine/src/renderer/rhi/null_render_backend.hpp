@@ -0,0 +1,165 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/rhi/frame_backend.hpp"
+#include "renderer/rhi/render_trace.hpp"
+#include "renderer/rhi/staging_ring_allocator.hpp"
+#include "rx/core/string.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    struct NullResource {
+        Rx::String name;
+
+        Uint64 size{0};
+
+        /*!
+         * \brief False once the resource has been destroyed. Its index is never reused
+         */
+        bool is_alive{true};
+    };
+
+    /*!
+     * \brief FrameBackend which doesn't talk to a GPU
+     *
+     * Resources are plain indices with a size, and every operation is recorded into a RenderTrace. Frame pacing, deferred destruction and
+     * the staging ring work like they do in RenderBackend - using the same StagingRingAllocator - so the CPU cost of the bookkeeping is
+     * real. The GPU is assumed to finish every frame instantly. This lets FrameStages run headless, without a D3D12 device
+     */
+    class NullRenderBackend final : public FrameBackend {
+    public:
+        explicit NullRenderBackend(Uint32 num_gpu_frames_in);
+
+        NullRenderBackend(const NullRenderBackend& other) = delete;
+        NullRenderBackend& operator=(const NullRenderBackend& other) = delete;
+
+        NullRenderBackend(NullRenderBackend&& old) noexcept = default;
+        NullRenderBackend& operator=(NullRenderBackend&& old) noexcept = default;
+
+        ~NullRenderBackend() override = default;
+
+        void begin_frame(Uint64 frame_count);
+
+        void end_frame();
+
+        [[nodiscard]] Uint32 get_cur_gpu_frame_idx() const;
+
+        [[nodiscard]] BufferHandle create_buffer(const Rx::String& name, Uint64 size);
+
+        /*!
+         * \param size Number of bytes the texture would take in GPU memory
+         */
+        [[nodiscard]] TextureHandle create_texture(const Rx::String& name, Uint64 size);
+
+        /*!
+         * \brief Destroys a buffer once the GPU has finished the current frame
+         */
+        void schedule_buffer_destruction(BufferHandle buffer);
+
+        /*!
+         * \brief Destroys a texture once the GPU has finished the current frame
+         */
+        void schedule_texture_destruction(TextureHandle texture);
+
+        [[nodiscard]] const NullResource& get_buffer(BufferHandle buffer) const;
+
+        [[nodiscard]] const NullResource& get_texture(TextureHandle texture) const;
+
+        /*!
+         * \brief Adds a mesh to the stand-in for the static mesh store. The mesh has no vertices or indices, only bounds
+         */
+        [[nodiscard]] Mesh add_mesh(const BoundingBox& bounds, const Rx::Vector<MeshletBounds>& meshlet_bounds = {});
+
+        [[nodiscard]] const StagingRingStats& get_staging_ring_stats() const;
+
+        [[nodiscard]] RenderTrace& get_trace();
+
+        [[nodiscard]] const RenderTrace& get_trace() const;
+
+        [[nodiscard]] Uint32 get_max_num_gpu_frames() const override;
+
+        [[nodiscard]] BufferHandle create_upload_buffer(const Rx::String& name, Uint32 size) override;
+
+        /*!
+         * \brief Copies the data into the staging ring, like an upload would
+         */
+        void write_buffer(BufferHandle buffer, Uint64 offset, const void* data, Uint64 num_bytes) override;
+
+        [[nodiscard]] Rx::Optional<BoundingBox> get_mesh_bounds(const Mesh& mesh) const override;
+
+        [[nodiscard]] const Rx::Vector<MeshletBounds>* get_meshlet_bounds(const Mesh& mesh) const override;
+
+        void write_buffer_descriptor(Uint32 buffer_idx, Uint32 descriptor_idx) override;
+
+        void write_texture_descriptors(Uint32 texture_idx, Uint32 srv_descriptor_idx, Uint32 uav_descriptor_idx) override;
+
+        void copy_descriptors(Uint32 frame_idx, Uint32 first_descriptor, Uint32 num_descriptors) override;
+
+        [[nodiscard]] Uint64 get_transient_texture_size(Uint32 texture_idx) const override;
+
+        bool map_transient_textures(const Rx::Vector<Uint32>& texture_indices,
+                                    const Rx::Vector<Uint64>& offsets,
+                                    Uint64 heap_size) override;
+
+        /*!
+         * \brief Starts recording into new command lists. Each command list keeps its events until `end_render_passes`, so that the
+         * trace has them in submission order no matter which threads recorded them
+         */
+        void begin_render_passes(Uint32 num_command_lists) override;
+
+        void resource_barriers(Uint32 command_list_idx, const Rx::Vector<RenderGraphBarrier>& barriers) override;
+
+        void activate_transient_textures(Uint32 command_list_idx, const Rx::Vector<RenderGraphResourceUsage>& usages) override;
+
+        void execute_pass(Uint32 command_list_idx, Uint32 pass_idx) override;
+
+        void end_render_passes() override;
+
+    private:
+        struct NullMesh {
+            BoundingBox bounds;
+
+            Rx::Vector<MeshletBounds> meshlet_bounds;
+        };
+
+        static constexpr Uint64 STAGING_RING_CHUNK_SIZE = 16 * 1024 * 1024;
+
+        static constexpr Uint64 DEFAULT_STAGING_BUFFER_ALIGNMENT = 16;
+
+        Uint32 num_gpu_frames;
+
+        Uint32 cur_gpu_frame_idx{0};
+
+        RenderTrace trace;
+
+        Rx::Vector<NullResource> buffers;
+
+        Rx::Vector<NullResource> textures;
+
+        /*!
+         * \brief Buffers to destroy the next time each frame index begins
+         */
+        Rx::Vector<Rx::Vector<Uint32>> buffer_deletion_list;
+
+        /*!
+         * \brief Textures to destroy the next time each frame index begins
+         */
+        Rx::Vector<Rx::Vector<Uint32>> texture_deletion_list;
+
+        /*!
+         * \brief Meshes from `add_mesh`. A mesh's first index is its index in here
+         */
+        Rx::Vector<NullMesh> meshes;
+
+        StagingRingAllocator staging_ring;
+
+        Rx::Vector<Rx::Vector<Uint8>> staging_ring_chunks;
+
+        /*!
+         * \brief Events of each command list since `begin_render_passes`. Only the event's op, ID, and amount are used
+         */
+        Rx::Vector<Rx::Vector<RenderTraceEvent>> command_lists;
+
+        void destroy_resources(Rx::Vector<NullResource>& resources, Rx::Vector<Uint32>& resources_to_destroy);
+    };
+} // namespace sanity::engine::renderer
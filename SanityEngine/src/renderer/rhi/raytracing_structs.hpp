@@ -4,6 +4,7 @@
 #include "renderer/handles.hpp"
 #include "renderer/mesh.hpp"
 #include "resources.hpp"
+#include "rx/core/vector.h"
 
 namespace sanity::engine::renderer {
     constexpr Uint32 OPAQUE_OBJECT_BIT = 0x01;
@@ -26,6 +27,12 @@ namespace sanity::engine::renderer {
          * \brief Buffer that holds the bottom-level acceleration structure
          */
         BufferHandle blas_buffer{};
+
+        /*!
+         * \brief The meshes that the bottom-level acceleration structure was built from, so it can be rebuilt when the mesh store moves
+         * them
+         */
+        Rx::Vector<PlacedMesh> meshes;
     };
 
 	using RaytracingAsHandle = GpuResourceHandle<RaytracingAccelerationStructure>;
@@ -48,6 +55,20 @@ namespace sanity::engine::renderer {
         glm::mat4 transform{};
     };
 
+    /*!
+     * \brief A RaytracingObject's slot in the raytracing scene
+     *
+     * Slots are reused once their object is removed, so the handle also remembers which generation of the slot it was made for. A
+     * handle whose generation doesn't match its slot's refers to an object that's already gone
+     */
+    struct RaytracingObjectHandle {
+        Uint32 slot{INVALID_RESOURCE_HANDLE};
+
+        Uint32 generation{0};
+
+        [[nodiscard]] bool is_valid() const { return slot != INVALID_RESOURCE_HANDLE; }
+    };
+
     /*!
      * \brief Struct for the top level acceleration structure that we can raytrace against
      */
@@ -21,6 +21,7 @@
 #include "renderer/rhi/helpers.hpp"
 #include "renderer/rhi/render_pipeline_state.hpp"
 #include "rx/core/abort.h"
+#include "rx/core/concurrency/scope_lock.h"
 #include "rx/core/log.h"
 #include "rx/core/string.h"
 #include "windows/windows_helpers.hpp"
@@ -56,10 +57,10 @@ namespace sanity::engine::renderer {
 
     RenderBackend::RenderBackend(HWND window_handle, const glm::uvec2& window_size)
         : command_lists_to_submit_on_end_frame{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())},
-          copy_command_lists_to_submit_on_end_frame{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())},
           buffer_deletion_list{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())},
           texture_deletion_list{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())},
-          staging_buffers_to_free{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())},
+          memory_deletion_list{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())},
+          staging_ring{STAGING_RING_CHUNK_SIZE, static_cast<Uint32>(cvar_max_in_flight_gpu_frames->get())},
           scratch_buffers_to_free{static_cast<Size>(cvar_max_in_flight_gpu_frames->get())} {
 #ifndef NDEBUG
         if(*cvar_enable_debug_layers) {
@@ -103,7 +104,15 @@ namespace sanity::engine::renderer {
     RenderBackend::~RenderBackend() {
         wait_idle();
 
-        staging_buffers.each_fwd([&](const Buffer& buffer) { buffer.allocation->Release(); });
+        staging_ring_chunks.each_fwd([&](const Buffer& buffer) { buffer.allocation->Release(); });
+
+        if(transient_texture_memory != nullptr) {
+            transient_texture_memory->Release();
+        }
+
+        memory_deletion_list.each_fwd([&](const Rx::Vector<D3D12MA::Allocation*>& allocations) {
+            allocations.each_fwd([&](D3D12MA::Allocation* allocation) { allocation->Release(); });
+        });
 
         TracyD3D12Destroy(tracy_render_context);
 
@@ -151,6 +160,8 @@ namespace sanity::engine::renderer {
                 logger->warning("Unknown buffer usage %u", create_info.usage);
         }
 
+        Rx::Concurrency::ScopeLock lock{resource_lifetime_mutex};
+
         auto buffer = Buffer{};
         const auto result = device_allocator->CreateResource(&alloc_desc,
                                                              &desc,
@@ -182,11 +193,17 @@ namespace sanity::engine::renderer {
         if(format == DXGI_FORMAT_D32_FLOAT) {
             format = DXGI_FORMAT_R32_TYPELESS; // Create depth buffers with a TYPELESS format
         }
+        // Block compressed textures can't be written by the mip generator, so they only get the mips that they're created with
+        const auto is_compressed = is_block_compressed(create_info.format);
+        const auto num_mips = is_compressed && create_info.num_mips == 0 ? 1 : create_info.num_mips;
+
         D3D12_RESOURCE_DESC desc;
         if(create_info.depth == 1 || create_info.depth == 0) {
             desc = CD3DX12_RESOURCE_DESC::Tex2D(format,
                                                 static_cast<Uint32>(round(create_info.width)),
-                                                static_cast<Uint32>(round(create_info.height)));
+                                                static_cast<Uint32>(round(create_info.height)),
+                                                1,
+                                                static_cast<Uint16>(num_mips));
         } else {
             desc = CD3DX12_RESOURCE_DESC::Tex3D(format, create_info.width, create_info.height, create_info.depth);
         }
@@ -207,7 +224,9 @@ namespace sanity::engine::renderer {
                 break;
 
             case TextureUsage::SampledTexture:
-                desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+                if(!is_compressed) {
+                    desc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+                }
                 break;
 
             case TextureUsage::DepthStencil:
@@ -220,12 +239,24 @@ namespace sanity::engine::renderer {
                 break;
         }
 
-        const auto result = device_allocator->CreateResource(&alloc_desc,
-                                                             &desc,
-                                                             D3D12_RESOURCE_STATE_COMMON,
-                                                             nullptr,
-                                                             &texture.allocation,
-                                                             IID_PPV_ARGS(&texture.resource));
+        Rx::Concurrency::ScopeLock lock{resource_lifetime_mutex};
+
+        HRESULT result;
+        if(create_info.is_transient && has_tiled_resources && desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D) {
+            // Transient textures are reserved resources. They get their memory from the transient texture heap once the renderer knows
+            // which of them can share memory, and we can create descriptors for them before then
+            desc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+            texture.allocation = nullptr;
+            result = device->CreateReservedResource(&desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&texture.resource));
+
+        } else {
+            result = device_allocator->CreateResource(&alloc_desc,
+                                                      &desc,
+                                                      D3D12_RESOURCE_STATE_COMMON,
+                                                      nullptr,
+                                                      &texture.allocation,
+                                                      IID_PPV_ARGS(&texture.resource));
+        }
         if(FAILED(result)) {
             logger->error("Could not create texture %s", create_info.name);
             return Rx::nullopt;
@@ -247,6 +278,73 @@ namespace sanity::engine::renderer {
         return texture;
     }
 
+    bool RenderBackend::is_reserved_texture(const Texture& texture) const {
+        return has_tiled_resources && texture.allocation == nullptr && texture.resource != nullptr;
+    }
+
+    Uint64 RenderBackend::get_reserved_texture_size(const Texture& texture) const {
+        UINT num_tiles{0};
+        device->GetResourceTiling(texture.resource, &num_tiles, nullptr, nullptr, nullptr, 0, nullptr);
+
+        return static_cast<Uint64>(num_tiles) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    }
+
+    bool RenderBackend::map_reserved_textures(const Rx::Vector<Texture>& textures,
+                                              const Rx::Vector<Uint64>& offsets,
+                                              const Uint64 heap_size) {
+        ZoneScoped;
+
+        if(transient_texture_memory != nullptr) {
+            // The frames in flight may still use the old memory. Tile mappings update in queue order, so they'll finish with the old
+            // mappings no matter what we map now
+            Rx::Concurrency::ScopeLock lock{resource_lifetime_mutex};
+            memory_deletion_list[cur_gpu_frame_idx].push_back(transient_texture_memory);
+            transient_texture_memory = nullptr;
+        }
+
+        if(textures.is_empty()) {
+            return true;
+        }
+
+        const auto alloc_desc = D3D12MA::ALLOCATION_DESC{.Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+                                                         .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+                                                         .ExtraHeapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES};
+        const auto heap_size_in_tiles = (heap_size + D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES - 1) / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+        const auto alloc_info = D3D12_RESOURCE_ALLOCATION_INFO{.SizeInBytes = heap_size_in_tiles * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES,
+                                                               .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT};
+        const auto result = device_allocator->AllocateMemory(&alloc_desc, &alloc_info, &transient_texture_memory);
+        if(FAILED(result)) {
+            logger->error("Could not allocate %llu bytes for transient textures: %s", heap_size, to_string(result));
+            return false;
+        }
+
+        for(auto i = 0u; i < textures.size(); i++) {
+            const auto& texture = textures[i];
+
+            UINT num_tiles{0};
+            device->GetResourceTiling(texture.resource, &num_tiles, nullptr, nullptr, nullptr, 0, nullptr);
+
+            const auto region_start = D3D12_TILED_RESOURCE_COORDINATE{};
+            const auto region_size = D3D12_TILE_REGION_SIZE{.NumTiles = num_tiles, .UseBox = FALSE};
+            const auto range_flags = D3D12_TILE_RANGE_FLAG_NONE;
+            const auto heap_start_tile = static_cast<UINT>((transient_texture_memory->GetOffset() + offsets[i]) /
+                                                           D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+
+            direct_command_queue->UpdateTileMappings(texture.resource,
+                                                     1,
+                                                     &region_start,
+                                                     &region_size,
+                                                     transient_texture_memory->GetHeap(),
+                                                     1,
+                                                     &range_flags,
+                                                     &heap_start_tile,
+                                                     &num_tiles,
+                                                     D3D12_TILE_MAPPING_FLAG_NONE);
+        }
+
+        return true;
+    }
+
     DescriptorRange RenderBackend::create_rtv_handle(const Texture& texture) const {
         const auto handle = rtv_allocator->allocate_descriptors(1);
 
@@ -298,9 +396,13 @@ namespace sanity::engine::renderer {
         return ptr;
     }
 
-    void RenderBackend::schedule_buffer_destruction(const Buffer& buffer) { buffer_deletion_list[cur_gpu_frame_idx].push_back(buffer); }
+    void RenderBackend::schedule_buffer_destruction(const Buffer& buffer) {
+        Rx::Concurrency::ScopeLock lock{resource_lifetime_mutex};
+        buffer_deletion_list[cur_gpu_frame_idx].push_back(buffer);
+    }
 
     void RenderBackend::schedule_texture_destruction(const Texture& texture) {
+        Rx::Concurrency::ScopeLock lock{resource_lifetime_mutex};
         texture_deletion_list[cur_gpu_frame_idx].push_back(texture);
     }
 
@@ -336,16 +438,20 @@ namespace sanity::engine::renderer {
     }
 
     ComPtr<ID3D12CommandAllocator> RenderBackend::get_or_create_command_allocator(const D3D12_COMMAND_LIST_TYPE type) {
-        if(type == D3D12_COMMAND_LIST_TYPE_DIRECT && !direct_command_allocators.is_empty()) {
-            const auto allocator = direct_command_allocators.last();
-            direct_command_allocators.pop_back();
-            return allocator;
-        }
+        {
+            Rx::Concurrency::ScopeLock lock{command_allocator_mutex};
+
+            if(type == D3D12_COMMAND_LIST_TYPE_DIRECT && !direct_command_allocators.is_empty()) {
+                const auto allocator = direct_command_allocators.last();
+                direct_command_allocators.pop_back();
+                return allocator;
+            }
 
-        if(type == D3D12_COMMAND_LIST_TYPE_COPY && !copy_command_allocators.is_empty()) {
-            const auto allocator = copy_command_allocators.last();
-            copy_command_allocators.pop_back();
-            return allocator;
+            if(type == D3D12_COMMAND_LIST_TYPE_COPY && !copy_command_allocators.is_empty()) {
+                const auto allocator = copy_command_allocators.last();
+                copy_command_allocators.pop_back();
+                return allocator;
+            }
         }
 
         ComPtr<ID3D12CommandAllocator> allocator;
@@ -435,16 +541,24 @@ namespace sanity::engine::renderer {
         command_lists_to_submit_on_end_frame[frame_idx].push_back(commands);
 
         const auto allocator = get_com_interface<ID3D12CommandAllocator>(commands);
+
+        Rx::Concurrency::ScopeLock lock{command_allocator_mutex};
         in_use_direct_command_allocators[frame_idx].push_back(allocator);
     }
 
-    void RenderBackend::submit_copy_command_list(const ComPtr<ID3D12GraphicsCommandList4> cmds) {
-        copy_command_lists_to_submit_on_end_frame[cur_gpu_frame_idx].push_back(cmds);
-
+    Uint64 RenderBackend::submit_copy_command_list(const ComPtr<ID3D12GraphicsCommandList4> cmds) {
         const auto allocator = get_com_interface<ID3D12CommandAllocator>(cmds);
+
+        Rx::Concurrency::ScopeLock lock{command_allocator_mutex};
+        copy_command_lists_to_submit.push_back(cmds);
         in_use_copy_command_allocators[cur_gpu_frame_idx].push_back(allocator);
+
+        // The next flush executes this command list, then signals the upload fence with the next value
+        return last_upload_fence_value + 1;
     }
 
+    Uint64 RenderBackend::get_completed_upload_fence_value() const { return upload_fence->GetCompletedValue(); }
+
     void RenderBackend::begin_frame(const uint64_t frame_count) {
         ZoneScoped;
 
@@ -460,17 +574,27 @@ namespace sanity::engine::renderer {
         wait_for_frame(cur_gpu_frame_idx);
         frame_fence_values[cur_gpu_frame_idx] = frame_count;
 
+        cbv_srv_uav_allocator->begin_frame(cur_gpu_frame_idx);
+
         cur_swapchain_idx = swapchain->GetCurrentBackBufferIndex();
 
         // Don't reset per frame resources on the first frame. This allows the engine to submit work while initializing
         if(!in_init_phase) {
-            return_staging_buffers_for_frame(cur_gpu_frame_idx);
+            {
+                // wait_for_frame made sure that the GPU is done with everything the last frame with this index uploaded
+                Rx::Concurrency::ScopeLock lock{staging_ring_mutex};
+                staging_ring.begin_frame(cur_gpu_frame_idx);
+            }
 
-            copy_command_allocators.append(in_use_copy_command_allocators[cur_gpu_frame_idx]);
-            direct_command_allocators.append(in_use_direct_command_allocators[cur_gpu_frame_idx]);
+            {
+                Rx::Concurrency::ScopeLock lock{command_allocator_mutex};
 
-            in_use_copy_command_allocators[cur_gpu_frame_idx].clear();
-            in_use_direct_command_allocators[cur_gpu_frame_idx].clear();
+                copy_command_allocators.append(in_use_copy_command_allocators[cur_gpu_frame_idx]);
+                direct_command_allocators.append(in_use_direct_command_allocators[cur_gpu_frame_idx]);
+
+                in_use_copy_command_allocators[cur_gpu_frame_idx].clear();
+                in_use_direct_command_allocators[cur_gpu_frame_idx].clear();
+            }
 
             destroy_resources_for_frame(cur_gpu_frame_idx);
         }
@@ -554,33 +678,39 @@ namespace sanity::engine::renderer {
 
     bool RenderBackend::has_separate_device_memory() const { return !is_uma; }
 
-    Buffer RenderBackend::get_staging_buffer(const Uint64 num_bytes, const Uint64 alignment) {
+    StagingBuffer RenderBackend::get_staging_buffer(const Uint64 num_bytes, const Uint64 alignment) {
         ZoneScoped;
 
-        for(size_t i = 0; i < staging_buffers.size(); i++) {
-            if(staging_buffers[i].size >= num_bytes && staging_buffers[i].alignment == alignment) {
-                // Return the first suitable buffer we find
-                auto buffer = Rx::Utility::move(staging_buffers[i]);
-                staging_buffers.erase(i, i + 1);
+        Rx::Concurrency::ScopeLock lock{staging_ring_mutex};
 
-                return buffer;
-            }
+        const auto allocation = staging_ring.allocate(num_bytes, alignment == 0 ? DEFAULT_STAGING_BUFFER_ALIGNMENT : alignment);
+
+        // The ring grew, so we need memory for its new chunk
+        while(staging_ring_chunks.size() < staging_ring.get_num_chunks()) {
+            const auto chunk_idx = static_cast<Uint32>(staging_ring_chunks.size());
+            staging_ring_chunks.push_back(create_staging_buffer(staging_ring.get_chunk_size(chunk_idx), 0));
+
+            logger->verbose("Grew the staging ring to %llu bytes", staging_ring.get_capacity());
         }
 
-        // No suitable buffer is available, let's make a new one
-        return create_staging_buffer(num_bytes, alignment);
+        const auto& chunk = staging_ring_chunks[allocation.chunk_idx];
+        return StagingBuffer{.resource = chunk.resource,
+                             .offset = allocation.offset,
+                             .size = num_bytes,
+                             .mapped_ptr = static_cast<Uint8*>(chunk.mapped_ptr) + allocation.offset};
     }
 
-    Buffer RenderBackend::get_staging_buffer_for_texture(ID3D12Resource* texture) {
+    StagingBuffer RenderBackend::get_staging_buffer_for_texture(ID3D12Resource* texture, const Uint32 num_subresources) {
         auto desc = texture->GetDesc();
         Uint64 required_size{0};
-        device->GetCopyableFootprints(&desc, 0, 1, 0, nullptr, nullptr, nullptr, &required_size);
+        device->GetCopyableFootprints(&desc, 0, num_subresources, 0, nullptr, nullptr, nullptr, &required_size);
 
-        return get_staging_buffer(required_size);
+        return get_staging_buffer(required_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
     }
 
-    void RenderBackend::return_staging_buffer(const Buffer& buffer) {
-        staging_buffers_to_free[cur_gpu_frame_idx].push_back(Rx::Utility::move(buffer));
+    StagingRingStats RenderBackend::get_staging_ring_stats() const {
+        Rx::Concurrency::ScopeLock lock{staging_ring_mutex};
+        return staging_ring.get_last_frame_stats();
     }
 
     Buffer RenderBackend::get_scratch_buffer(const Uint32 num_bytes) {
@@ -754,6 +884,8 @@ namespace sanity::engine::renderer {
                     has_raytracing = options5.RaytracingTier != D3D12_RAYTRACING_TIER_NOT_SUPPORTED;
                 }
 
+                has_tiled_resources = d3d12_options.TiledResourcesTier != D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+
 #ifndef NDEBUG
                 info_queue = device.as<ID3D12InfoQueue>();
                 if(info_queue && cvar_break_on_validation_error->get()) {
@@ -866,6 +998,9 @@ namespace sanity::engine::renderer {
 
         device->CreateFence(1, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&copy_queue_sync_fence));
         set_object_name(copy_queue_sync_fence, "Copy Queue Fence");
+
+        device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&upload_fence));
+        set_object_name(upload_fence, "Upload Fence");
     }
 
     void RenderBackend::create_descriptor_heaps() {
@@ -875,13 +1010,19 @@ namespace sanity::engine::renderer {
         const auto total_num_textures = *cvar_max_in_flight_gpu_frames * MAX_NUM_TEXTURES * 2;
         const auto
             num_bespoke_descriptors = 65536; // Descriptors for the RT AS or single-pass downsampler or whatever else wants descriptors
+        const auto num_transient_descriptors = 16384; // Descriptors which only live for one frame, shared by all the frames in flight
 
         const auto [new_cbv_srv_uav_heap,
                     new_cbv_srv_uav_size] = create_descriptor_heap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
-                                                                   total_num_buffers + total_num_textures + num_bespoke_descriptors);
+                                                                   total_num_buffers + total_num_textures + num_bespoke_descriptors +
+                                                                       num_transient_descriptors);
         set_object_name(new_cbv_srv_uav_heap, "CBV/SRV/UAV Heap");
 
-        cbv_srv_uav_allocator = Rx::make_ptr<DescriptorAllocator>(RX_SYSTEM_ALLOCATOR, new_cbv_srv_uav_heap, new_cbv_srv_uav_size);
+        cbv_srv_uav_allocator = Rx::make_ptr<DescriptorAllocator>(RX_SYSTEM_ALLOCATOR,
+                                                                  new_cbv_srv_uav_heap,
+                                                                  new_cbv_srv_uav_size,
+                                                                  num_transient_descriptors,
+                                                                  static_cast<Uint32>(*cvar_max_in_flight_gpu_frames));
 
         const auto [rtv_heap, rtv_size] = create_descriptor_heap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 1024);
         set_object_name(rtv_heap, "RTV Heap");
@@ -1140,6 +1281,45 @@ namespace sanity::engine::renderer {
                                      .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
                                      .InstanceDataStepRate = 0});
 
+        // Every element of a PackedVertex is a bitfield, which the vertex shader unpacks itself
+        packed_graphics_pipeline_input_layout.reserve(4);
+
+        packed_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "LocationXy",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R32_UINT,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
+
+        packed_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "LocationZNormal",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R32_UINT,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
+
+        packed_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "Color",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R32_UINT,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
+
+        packed_graphics_pipeline_input_layout.push_back(
+            D3D12_INPUT_ELEMENT_DESC{.SemanticName = "Texcoord",
+                                     .SemanticIndex = 0,
+                                     .Format = DXGI_FORMAT_R32_UINT,
+                                     .InputSlot = 0,
+                                     .AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+                                     .InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                                     .InstanceDataStepRate = 0});
+
         dear_imgui_graphics_pipeline_input_layout.reserve(3);
 
         dear_imgui_graphics_pipeline_input_layout.push_back(
@@ -1228,6 +1408,11 @@ namespace sanity::engine::renderer {
                 desc.InputLayout.pInputElementDescs = standard_graphics_pipeline_input_layout.data();
                 break;
 
+            case InputAssemblerLayout::PackedVertex:
+                desc.InputLayout.NumElements = static_cast<UINT>(packed_graphics_pipeline_input_layout.size());
+                desc.InputLayout.pInputElementDescs = packed_graphics_pipeline_input_layout.data();
+                break;
+
             case InputAssemblerLayout::DearImGui:
                 desc.InputLayout.NumElements = static_cast<UINT>(dear_imgui_graphics_pipeline_input_layout.size());
                 desc.InputLayout.pInputElementDescs = dear_imgui_graphics_pipeline_input_layout.data();
@@ -1329,13 +1514,22 @@ namespace sanity::engine::renderer {
     }
 
     void RenderBackend::flush_copy_command_lists() {
-        auto& copy_lists = copy_command_lists_to_submit_on_end_frame[cur_gpu_frame_idx];
-        copy_lists.each_fwd([&](const ComPtr<ID3D12GraphicsCommandList4>& cmds) {
-            ID3D12CommandList* list = cmds;
-            direct_command_queue->ExecuteCommandLists(1, &list);
-        });
-        command_lists_outside_render_device.fetch_sub(copy_lists.size());
-        copy_lists.clear();
+        Rx::Concurrency::ScopeLock lock{command_allocator_mutex};
+        if(copy_command_lists_to_submit.is_empty()) {
+            return;
+        }
+
+        Rx::Vector<ID3D12CommandList*> lists;
+        lists.reserve(copy_command_lists_to_submit.size());
+        copy_command_lists_to_submit.each_fwd([&](const ComPtr<ID3D12GraphicsCommandList4>& cmds) { lists.push_back(cmds); });
+
+        direct_command_queue->ExecuteCommandLists(static_cast<Uint32>(lists.size()), lists.data());
+
+        last_upload_fence_value++;
+        direct_command_queue->Signal(upload_fence, last_upload_fence_value);
+
+        command_lists_outside_render_device.fetch_sub(copy_command_lists_to_submit.size());
+        copy_command_lists_to_submit.clear();
     }
 
     void RenderBackend::flush_batched_command_lists() {
@@ -1381,20 +1575,19 @@ namespace sanity::engine::renderer {
         command_lists_to_submit_on_end_frame[cur_gpu_frame_idx] = {};
     }
 
-    void RenderBackend::return_staging_buffers_for_frame(const Uint32 frame_idx) {
-        ZoneScoped;
-        auto& staging_buffers_for_frame = staging_buffers_to_free[frame_idx];
-        staging_buffers.append(staging_buffers_for_frame);
-        staging_buffers_for_frame.clear();
-    }
-
     void RenderBackend::destroy_resources_for_frame(const Uint32 frame_idx) {
         ZoneScoped;
+        Rx::Concurrency::ScopeLock lock{resource_lifetime_mutex};
+
         auto& buffers = buffer_deletion_list[frame_idx];
         buffers.clear();
 
         auto& textures = texture_deletion_list[cur_gpu_frame_idx];
         textures.clear();
+
+        auto& allocations = memory_deletion_list[frame_idx];
+        allocations.each_fwd([&](D3D12MA::Allocation* allocation) { allocation->Release(); });
+        allocations.clear();
     }
 
     void RenderBackend::transition_swapchain_texture_to_render_target() {
@@ -17,6 +17,7 @@
 #include "renderer/rhi/framebuffer.hpp"
 #include "renderer/rhi/raytracing_structs.hpp"
 #include "renderer/rhi/render_pipeline_state.hpp"
+#include "renderer/rhi/staging_ring_allocator.hpp"
 #include "rx/console/variable.h"
 #include "rx/core/concurrency/mutex.h"
 #include "rx/core/map.h"
@@ -71,6 +72,16 @@ namespace sanity::engine::renderer {
                                                                                  4;
         static constexpr Uint32 MODEL_MATRIX_INDEX_ROOT_CONSTANT_OFFSET = offsetof(StandardPushConstants, model_matrix_index) / 4;
         static constexpr Uint32 ENTITY_ID_ROOT_CONSTANT_OFFSET = offsetof(StandardPushConstants, object_id) / 4;
+        static constexpr Uint32 MESH_DEQUANTIZATION_INDEX_ROOT_CONSTANT_OFFSET = offsetof(StandardPushConstants,
+                                                                                          mesh_dequantization_index) /
+                                                                                 4;
+
+        static constexpr Uint64 STAGING_RING_CHUNK_SIZE = 16 * 1024 * 1024;
+
+        /*!
+         * \brief Large enough for acceleration structure instance descriptions and transforms, our strictest buffer uploads
+         */
+        static constexpr Uint64 DEFAULT_STAGING_BUFFER_ALIGNMENT = 16;
 
 #ifdef TRACY_ENABLE
         inline static tracy::D3D12QueueCtx* tracy_render_context{nullptr};
@@ -94,6 +105,28 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] Rx::Optional<Texture> create_texture(const TextureCreateInfo& create_info) const;
 
+        /*!
+         * \brief Checks if the texture is a transient texture without memory of its own
+         *
+         * Transient textures are only created without memory when the device supports tiled resources. Otherwise they're regular
+         * textures, and simply don't share memory
+         */
+        [[nodiscard]] bool is_reserved_texture(const Texture& texture) const;
+
+        /*!
+         * \brief Gets the amount of memory that a reserved texture needs, rounded up to whole tiles
+         */
+        [[nodiscard]] Uint64 get_reserved_texture_size(const Texture& texture) const;
+
+        /*!
+         * \brief Allocates a heap for transient textures and maps each reserved texture into it at the provided offset
+         *
+         * The heap replaces any heap from a previous call. The old heap is released once the frames in flight are done with it, since
+         * their work is ahead of the new tile mappings on the direct queue. Offsets must be multiples of
+         * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES
+         */
+        bool map_reserved_textures(const Rx::Vector<Texture>& textures, const Rx::Vector<Uint64>& offsets, Uint64 heap_size);
+
         [[nodiscard]] DescriptorRange create_rtv_handle(const Texture& texture) const;
 
         [[nodiscard]] DescriptorRange create_dsv_handle(const Texture& texture) const;
@@ -123,7 +156,8 @@ namespace sanity::engine::renderer {
          * You may pass in the index of the GPU frame to submit this command list to. If you do not, the index of the GPU frame currently
          * being recorded is used
          *
-         * This method is internally synchronized. You can (in theory) call it safely from a multithreaded environment
+         * This method is internally synchronized. You can call it safely from multiple threads, such as when recording render passes in
+         * parallel
          */
         [[nodiscard]] ComPtr<ID3D12GraphicsCommandList4> create_render_command_list(Rx::Optional<Uint32> frame_idx = Rx::nullopt);
 
@@ -131,7 +165,19 @@ namespace sanity::engine::renderer {
 
         void submit_command_list(ComPtr<ID3D12GraphicsCommandList4> commands);
 
-        void submit_copy_command_list(ComPtr<ID3D12GraphicsCommandList4> cmds);
+        /*!
+         * \brief Submits a command list which uploads data. All the upload command lists are executed together at the beginning of the next
+         * frame
+         *
+         * \return The value that the upload fence will reach once the command list has finished executing
+         */
+        Uint64 submit_copy_command_list(ComPtr<ID3D12GraphicsCommandList4> cmds);
+
+        /*!
+         * \brief Gets the upload fence's value that the GPU has reached. Every upload command list whose submission returned a value less
+         * than or equal to this one has finished executing
+         */
+        [[nodiscard]] Uint64 get_completed_upload_fence_value() const;
 
         void begin_frame(uint64_t frame_count);
 
@@ -157,11 +203,24 @@ namespace sanity::engine::renderer {
 
         [[nodiscard]] bool has_separate_device_memory() const;
 
-        [[nodiscard]] Buffer get_staging_buffer(Uint64 num_bytes, Uint64 alignment = 0);
+        /*!
+         * \brief Allocates upload memory from the staging ring. May be called from any thread
+         *
+         * The memory is recycled automatically once the GPU has finished the current frame, so there's nothing to return
+         *
+         * \param alignment Alignment of the staging buffer's offset in its resource. 0 means `DEFAULT_STAGING_BUFFER_ALIGNMENT`
+         */
+        [[nodiscard]] StagingBuffer get_staging_buffer(Uint64 num_bytes, Uint64 alignment = 0);
 
-        [[nodiscard]] Buffer get_staging_buffer_for_texture(ID3D12Resource* texture);
+        /*!
+         * \brief Gets a staging buffer which can hold the first `num_subresources` subresources of a texture
+         */
+        [[nodiscard]] StagingBuffer get_staging_buffer_for_texture(ID3D12Resource* texture, Uint32 num_subresources = 1);
 
-        void return_staging_buffer(const Buffer& buffer);
+        /*!
+         * \brief How much data the last frame uploaded through the staging ring, and how often the ring had to grow
+         */
+        [[nodiscard]] StagingRingStats get_staging_ring_stats() const;
 
         [[nodiscard]] Buffer get_scratch_buffer(Uint32 num_bytes);
 
@@ -210,8 +269,19 @@ namespace sanity::engine::renderer {
         ComPtr<ID3D12Fence> copy_queue_sync_fence;
         ComPtr<ID3D12CommandQueue> async_copy_queue;
 
+        /*!
+         * \brief Signalled after each batch of upload command lists, with a value that goes up by one per batch
+         */
+        ComPtr<ID3D12Fence> upload_fence;
+        Uint64 last_upload_fence_value{0};
+
         Rx::Concurrency::Atomic<Size> command_lists_outside_render_device{0};
 
+        /*!
+         * \brief Guards the command allocator pools, so that worker threads can create command lists
+         */
+        Rx::Concurrency::Mutex command_allocator_mutex;
+
         Rx::Vector<ComPtr<ID3D12CommandAllocator>> direct_command_allocators;
         Rx::Vector<ComPtr<ID3D12CommandAllocator>> copy_command_allocators;
 
@@ -219,7 +289,7 @@ namespace sanity::engine::renderer {
         Rx::Vector<Rx::Vector<ComPtr<ID3D12CommandAllocator>>> in_use_copy_command_allocators;
 
         Rx::Vector<Rx::Vector<ComPtr<ID3D12GraphicsCommandList4>>> command_lists_to_submit_on_end_frame;
-        Rx::Vector<Rx::Vector<ComPtr<ID3D12GraphicsCommandList4>>> copy_command_lists_to_submit_on_end_frame;
+        Rx::Vector<ComPtr<ID3D12GraphicsCommandList4>> copy_command_lists_to_submit;
 
         ComPtr<IDXGISwapChain3> swapchain;
         Rx::Vector<ComPtr<ID3D12Resource>> swapchain_textures;
@@ -229,8 +299,15 @@ namespace sanity::engine::renderer {
 
         Rx::Vector<uint64_t> frame_fence_values;
 
+        /*!
+         * \brief Guards resource creation and the deletion lists. Render passes record on multiple threads, and some of them create and
+         * destroy resources while they record
+         */
+        mutable Rx::Concurrency::Mutex resource_lifetime_mutex;
+
         Rx::Vector<Rx::Vector<Buffer>> buffer_deletion_list;
         Rx::Vector<Rx::Vector<Texture>> texture_deletion_list;
+        Rx::Vector<Rx::Vector<D3D12MA::Allocation*>> memory_deletion_list;
 
         Rx::Ptr<DescriptorAllocator> cbv_srv_uav_allocator;
         Rx::Ptr<DescriptorAllocator> rtv_allocator;
@@ -241,16 +318,22 @@ namespace sanity::engine::renderer {
         ComPtr<ID3D12RootSignature> standard_root_signature;
 
         Rx::Vector<D3D12_INPUT_ELEMENT_DESC> standard_graphics_pipeline_input_layout;
+        Rx::Vector<D3D12_INPUT_ELEMENT_DESC> packed_graphics_pipeline_input_layout;
         Rx::Vector<D3D12_INPUT_ELEMENT_DESC> dear_imgui_graphics_pipeline_input_layout;
 
         uint64_t staging_buffer_idx{0};
-        Rx::Vector<Buffer> staging_buffers;
 
         /*!
-         * \brief Array of array of staging buffers to free on a frame. index 0 gets freed on the next frame 0, index 1 gets freed on the
-         * next frame 1, etc
+         * \brief Guards the staging ring and its chunks, since passes record their command lists on multiple threads
+         */
+        mutable Rx::Concurrency::Mutex staging_ring_mutex;
+
+        StagingRingAllocator staging_ring;
+
+        /*!
+         * \brief One persistently mapped upload buffer for each chunk of the staging ring
          */
-        Rx::Vector<Rx::Vector<Buffer>> staging_buffers_to_free;
+        Rx::Vector<Buffer> staging_ring_chunks;
 
         Uint32 scratch_buffer_counter{0};
         Rx::Vector<Buffer> scratch_buffers;
@@ -279,6 +362,16 @@ namespace sanity::engine::renderer {
          */
         bool has_raytracing = false;
 
+        /*!
+         * \brief Indicates support for reserved resources, which transient textures need to share memory
+         */
+        bool has_tiled_resources = false;
+
+        /*!
+         * \brief Memory that all the transient textures are mapped into
+         */
+        D3D12MA::Allocation* transient_texture_memory{nullptr};
+
         DXGI_FORMAT swapchain_format{DXGI_FORMAT_R8G8B8A8_UNORM};
 
         Rx::Vector<ComPtr<ID3D12Fence>> command_list_done_fences;
@@ -360,8 +453,6 @@ namespace sanity::engine::renderer {
 
         void flush_batched_command_lists();
 
-        void return_staging_buffers_for_frame(Uint32 frame_idx);
-
         void destroy_resources_for_frame(Uint32 frame_idx);
 
         void transition_swapchain_texture_to_render_target();
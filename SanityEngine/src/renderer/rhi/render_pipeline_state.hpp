@@ -123,6 +123,11 @@ namespace sanity::engine::renderer {
          */
         StandardVertex,
 
+        /**
+         * @brief Each vertex is a PackedVertex, which the vertex shader must unpack
+         */
+        PackedVertex,
+
         /**
          * @brief Dear ImGUI vertex
          *
@@ -0,0 +1,77 @@
+#include "render_trace.hpp"
+
+namespace sanity::engine::renderer {
+    void RenderTrace::set_frame(const Uint64 frame) { cur_frame = frame; }
+
+    void RenderTrace::record(const RenderTraceOp op, const Uint32 id, const Uint64 amount) {
+        const auto op_idx = static_cast<Uint32>(op);
+        RX_ASSERT(op_idx < NUM_OPS, "Invalid render trace op %u", op_idx);
+
+        num_events[op_idx]++;
+        total_amounts[op_idx] += amount;
+
+        if(keep_events) {
+            events.push_back(RenderTraceEvent{.op = op, .frame = cur_frame, .id = id, .amount = amount});
+        }
+    }
+
+    void RenderTrace::clear() {
+        events.clear();
+
+        for(auto i = 0u; i < NUM_OPS; i++) {
+            num_events[i] = 0;
+            total_amounts[i] = 0;
+        }
+    }
+
+    void RenderTrace::set_keep_events(const bool keep_events_in) { keep_events = keep_events_in; }
+
+    const Rx::Vector<RenderTraceEvent>& RenderTrace::get_events() const { return events; }
+
+    Uint64 RenderTrace::get_num_events(const RenderTraceOp op) const { return num_events[static_cast<Uint32>(op)]; }
+
+    Uint64 RenderTrace::get_total_amount(const RenderTraceOp op) const { return total_amounts[static_cast<Uint32>(op)]; }
+
+    const char* to_string(const RenderTraceOp op) {
+        switch(op) {
+            case RenderTraceOp::BeginFrame:
+                return "BeginFrame";
+
+            case RenderTraceOp::EndFrame:
+                return "EndFrame";
+
+            case RenderTraceOp::CreateBuffer:
+                return "CreateBuffer";
+
+            case RenderTraceOp::CreateTexture:
+                return "CreateTexture";
+
+            case RenderTraceOp::DestroyResource:
+                return "DestroyResource";
+
+            case RenderTraceOp::Upload:
+                return "Upload";
+
+            case RenderTraceOp::WriteDescriptors:
+                return "WriteDescriptors";
+
+            case RenderTraceOp::CopyDescriptors:
+                return "CopyDescriptors";
+
+            case RenderTraceOp::ResourceBarriers:
+                return "ResourceBarriers";
+
+            case RenderTraceOp::MapTransientResources:
+                return "MapTransientResources";
+
+            case RenderTraceOp::ActivateTransientResources:
+                return "ActivateTransientResources";
+
+            case RenderTraceOp::ExecutePass:
+                return "ExecutePass";
+
+            default:
+                return "Unknown";
+        }
+    }
+} // namespace sanity::engine::renderer
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    enum class RenderTraceOp : Uint8 {
+        BeginFrame,
+        EndFrame,
+        CreateBuffer,
+        CreateTexture,
+        DestroyResource,
+
+        /*!
+         * \brief Data written to a buffer. The event's ID is the index of the buffer, and its amount is the number of bytes
+         */
+        Upload,
+
+        /*!
+         * \brief Descriptors created for a resource. The event's ID is the index of the resource, and its amount is the number of
+         * descriptors
+         */
+        WriteDescriptors,
+
+        /*!
+         * \brief Descriptors copied into a frame's copy of the resource array. The event's amount is the number of descriptors
+         */
+        CopyDescriptors,
+
+        /*!
+         * \brief One batch of resource barriers. The event's amount is the number of barriers in the batch
+         */
+        ResourceBarriers,
+
+        /*!
+         * \brief Transient resources were given new places in the transient heap. The event's ID is the number of resources, and its
+         * amount is the size of the heap
+         */
+        MapTransientResources,
+
+        /*!
+         * \brief Transient resources which share memory with others were activated before their first use. The event's amount is the
+         * number of resources
+         */
+        ActivateTransientResources,
+
+        /*!
+         * \brief A render pass recorded its work. The event's ID is the index of the pass
+         */
+        ExecutePass,
+
+        Count,
+    };
+
+    struct RenderTraceEvent {
+        RenderTraceOp op{RenderTraceOp::BeginFrame};
+
+        Uint64 frame{0};
+
+        /*!
+         * \brief The resource or pass that the event is about, if any
+         */
+        Uint32 id{0};
+
+        /*!
+         * \brief Size or count associated with the event. What it means depends on the op
+         */
+        Uint64 amount{0};
+    };
+
+    /*!
+     * \brief In-memory log of everything a backend was asked to do
+     *
+     * The null render backend records its calls here instead of talking to a GPU, so tests and benchmarks can check what the renderer did
+     * without a device. Not thread safe
+     */
+    class RenderTrace {
+    public:
+        RenderTrace() = default;
+
+        RenderTrace(const RenderTrace& other) = delete;
+        RenderTrace& operator=(const RenderTrace& other) = delete;
+
+        RenderTrace(RenderTrace&& old) noexcept = default;
+        RenderTrace& operator=(RenderTrace&& old) noexcept = default;
+
+        ~RenderTrace() = default;
+
+        /*!
+         * \brief Sets the frame which new events are recorded for
+         */
+        void set_frame(Uint64 frame);
+
+        void record(RenderTraceOp op, Uint32 id = 0, Uint64 amount = 0);
+
+        /*!
+         * \brief Removes all events and resets the counters, but keeps the trace's memory around
+         */
+        void clear();
+
+        /*!
+         * \brief Whether to keep every event, or only count them. Counting is enough for long benchmarks, and doesn't grow memory
+         */
+        void set_keep_events(bool keep_events_in);
+
+        [[nodiscard]] const Rx::Vector<RenderTraceEvent>& get_events() const;
+
+        /*!
+         * \brief Number of events with the op that were recorded since the last `clear`, whether or not they were kept
+         */
+        [[nodiscard]] Uint64 get_num_events(RenderTraceOp op) const;
+
+        /*!
+         * \brief Sum of the amounts of all events with the op that were recorded since the last `clear`
+         */
+        [[nodiscard]] Uint64 get_total_amount(RenderTraceOp op) const;
+
+    private:
+        static constexpr auto NUM_OPS = static_cast<Uint32>(RenderTraceOp::Count);
+
+        Uint64 cur_frame{0};
+
+        bool keep_events{true};
+
+        Rx::Vector<RenderTraceEvent> events;
+
+        Uint64 num_events[NUM_OPS]{};
+
+        Uint64 total_amounts[NUM_OPS]{};
+    };
+
+    [[nodiscard]] const char* to_string(RenderTraceOp op);
+} // namespace sanity::engine::renderer
@@ -1,6 +1,10 @@
 #include "resources.hpp"
 
+#include <bit>
+
+#include "core/align.hpp"
 #include "renderer/renderer.hpp"
+#include "renderer/rhi/helpers.hpp"
 #include "rx/core/log.h"
 
 namespace sanity::engine::renderer {
@@ -59,4 +63,105 @@ namespace sanity::engine::renderer {
                 return 4;
         }
     }
+
+    bool is_block_compressed(const TextureFormat format) {
+        switch(format) {
+            case TextureFormat::Bc1:
+                [[fallthrough]];
+            case TextureFormat::Bc3:
+                [[fallthrough]];
+            case TextureFormat::Bc4:
+                [[fallthrough]];
+            case TextureFormat::Bc5:
+                [[fallthrough]];
+            case TextureFormat::Bc7:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    Uint32 get_block_size_in_bytes(const TextureFormat format) {
+        switch(format) {
+            case TextureFormat::Bc1:
+                [[fallthrough]];
+            case TextureFormat::Bc4:
+                return 8;
+
+            case TextureFormat::Bc3:
+                [[fallthrough]];
+            case TextureFormat::Bc5:
+                [[fallthrough]];
+            case TextureFormat::Bc7:
+                return 16;
+
+            default:
+                return size_in_bytes(format);
+        }
+    }
+
+    Uint64 get_row_pitch(const TextureFormat format, const Uint32 width) {
+        if(is_block_compressed(format)) {
+            return static_cast<Uint64>((width + 3) / 4) * get_block_size_in_bytes(format);
+        }
+
+        return static_cast<Uint64>(width) * size_in_bytes(format);
+    }
+
+    Uint32 get_num_rows(const TextureFormat format, const Uint32 height) {
+        return is_block_compressed(format) ? (height + 3) / 4 : height;
+    }
+
+    Uint32 get_num_mips(const Uint32 width, const Uint32 height) {
+        return static_cast<Uint32>(std::bit_width(glm::max(width, height)));
+    }
+
+    Uint32 get_mip_dimension(const Uint32 top_mip_dimension, const Uint32 mip_level) {
+        return glm::max(top_mip_dimension >> mip_level, 1u);
+    }
+
+    Uint64 get_mip_chain_size_in_bytes(const TextureFormat format, const Uint32 width, const Uint32 height, const Uint32 num_mips) {
+        Uint64 size{0};
+        for(Uint32 mip_level = 0; mip_level < num_mips; mip_level++) {
+            const auto mip_width = get_mip_dimension(width, mip_level);
+            const auto mip_height = get_mip_dimension(height, mip_level);
+            size += get_row_pitch(format, mip_width) * get_num_rows(format, mip_height);
+        }
+
+        return size;
+    }
+
+    Rx::Vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> get_placed_mip_footprints(
+        const TextureFormat format, const Uint32 width, const Uint32 height, const Uint32 num_mips, Uint64& total_size) {
+        const auto dxgi_format = to_dxgi_format(format);
+
+        // Footprints of block compressed textures cover whole blocks, even for mips that are smaller than a block
+        const auto footprint_alignment = is_block_compressed(format) ? 4u : 1u;
+
+        Rx::Vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints;
+        footprints.reserve(num_mips);
+
+        total_size = 0;
+        for(Uint32 mip_level = 0; mip_level < num_mips; mip_level++) {
+            const auto mip_width = get_mip_dimension(width, mip_level);
+            const auto mip_height = get_mip_dimension(height, mip_level);
+            const auto tight_row_pitch = get_row_pitch(format, mip_width);
+            const auto row_pitch = ALIGN(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, tight_row_pitch);
+
+            const auto offset = ALIGN(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, total_size);
+            footprints.push_back(D3D12_PLACED_SUBRESOURCE_FOOTPRINT{
+                .Offset = offset,
+                .Footprint = {.Format = dxgi_format,
+                              .Width = ALIGN(footprint_alignment, mip_width),
+                              .Height = ALIGN(footprint_alignment, mip_height),
+                              .Depth = 1,
+                              .RowPitch = static_cast<UINT>(row_pitch)},
+            });
+
+            total_size = offset + row_pitch * get_num_rows(format, mip_height);
+        }
+
+        return footprints;
+    }
 } // namespace sanity::engine::renderer
@@ -11,6 +11,7 @@
 #include "renderer/rhi/per_frame_buffer.hpp"
 #include "rx/core/string.h"
 #include "rx/core/utility/pair.h"
+#include "rx/core/vector.h"
 
 namespace D3D12MA {
     class Allocation;
@@ -58,6 +59,25 @@ namespace sanity::engine::renderer {
 
     using BufferHandle = GpuResourceHandle<Buffer>;
 
+    /*!
+     * \brief A range of upload memory which the CPU may write to, and the GPU may read from until the end of the frame it was allocated in
+     */
+    struct StagingBuffer {
+        /*!
+         * \brief The staging ring chunk which holds this range. Other ranges share the resource, so always add `offset` when using it
+         */
+        ID3D12Resource* resource{nullptr};
+
+        Uint64 offset{0};
+
+        Uint64 size{0};
+
+        /*!
+         * \brief Pointer to the start of this range, not the start of `resource`
+         */
+        void* mapped_ptr{nullptr};
+    };
+
     class BufferRing : public ResourceRing<GpuResourceHandle<Buffer>> {
     public:
         BufferRing() = default;
@@ -77,6 +97,33 @@ namespace sanity::engine::renderer {
         R32UInt,
         Depth32,
         Depth24Stencil8,
+
+        // Block compressed formats. Textures in these formats can't be written to by shaders
+
+        /*!
+         * \brief RGB in 8-byte 4x4 blocks
+         */
+        Bc1,
+
+        /*!
+         * \brief RGBA in 16-byte 4x4 blocks, with a BC1 block for RGB and a BC4 block for alpha
+         */
+        Bc3,
+
+        /*!
+         * \brief One channel in 8-byte 4x4 blocks
+         */
+        Bc4,
+
+        /*!
+         * \brief Two channels in 16-byte 4x4 blocks, with a BC4 block for each
+         */
+        Bc5,
+
+        /*!
+         * \brief RGBA in 16-byte 4x4 blocks, with higher quality than BC3
+         */
+        Bc7,
     };
 
     struct TextureCreateInfo {
@@ -89,10 +136,44 @@ namespace sanity::engine::renderer {
         Uint32 height{1};
         Uint32 depth{1};
 
+        /*!
+         * \brief Number of mips in the texture. 0 means a full mip chain
+         *
+         * When the texture is created with initial data, the data holds this many mips, tightly packed one after another, and the renderer
+         * uploads all of them. If this is 0 the data only holds the top mip, and the renderer generates the others on the GPU
+         */
+        Uint32 num_mips{0};
+
         /*!
          * \brief If true, this resource may be shared with other APIs, such as CUDA
          */
         bool enable_resource_sharing{false};
+
+        /*!
+         * \brief If true, this texture only holds data during part of a frame, and may share memory with other transient textures which
+         * are never used at the same time
+         *
+         * Transient textures have no memory of their own when they're created. The renderer gives them memory after it knows what passes
+         * use them
+         */
+        bool is_transient{false};
+    };
+
+    /*!
+     * \brief Texture data laid out the way D3D12 copies textures from buffers, so that it can be copied into staging memory in one block
+     *
+     * Each mip starts at a multiple of `D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT`, and its rows are padded to
+     * `D3D12_TEXTURE_DATA_PITCH_ALIGNMENT`
+     */
+    struct PlacedTextureData {
+        const void* data{nullptr};
+
+        Uint64 size{0};
+
+        /*!
+         * \brief Layout of each mip which the data holds. Offsets are from the start of `data`
+         */
+        Rx::Vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> mip_footprints;
     };
 
     struct Texture {
@@ -203,8 +284,51 @@ namespace sanity::engine::renderer {
 
     using FluidVolumeHandle = GpuResourceHandle<FluidVolume>;
 
+    /*!
+     * \brief Size of one texel. Meaningless for block compressed formats
+     */
     [[nodiscard]] Uint32 size_in_bytes(TextureFormat format);
 
+    [[nodiscard]] bool is_block_compressed(TextureFormat format);
+
+    /*!
+     * \brief Size of one 4x4 block of a block compressed format
+     */
+    [[nodiscard]] Uint32 get_block_size_in_bytes(TextureFormat format);
+
+    /*!
+     * \brief Number of bytes in one row of texels, or in one row of blocks for block compressed formats
+     */
+    [[nodiscard]] Uint64 get_row_pitch(TextureFormat format, Uint32 width);
+
+    /*!
+     * \brief Number of rows of texels in an image, or number of rows of blocks for block compressed formats
+     */
+    [[nodiscard]] Uint32 get_num_rows(TextureFormat format, Uint32 height);
+
+    /*!
+     * \brief Number of mips in a full mip chain, down to and including the 1x1 mip
+     */
+    [[nodiscard]] Uint32 get_num_mips(Uint32 width, Uint32 height);
+
+    /*!
+     * \brief Width or height of a mip, given the width or height of the top mip
+     */
+    [[nodiscard]] Uint32 get_mip_dimension(Uint32 top_mip_dimension, Uint32 mip_level);
+
+    /*!
+     * \brief Number of bytes in the first `num_mips` mips of a texture, when they're tightly packed one after another
+     */
+    [[nodiscard]] Uint64 get_mip_chain_size_in_bytes(TextureFormat format, Uint32 width, Uint32 height, Uint32 num_mips);
+
+    /*!
+     * \brief Lays out the first `num_mips` mips of a texture the way `PlacedTextureData` holds them
+     *
+     * \param total_size Number of bytes that all the mips take up, including padding
+     */
+    [[nodiscard]] Rx::Vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> get_placed_mip_footprints(
+        TextureFormat format, Uint32 width, Uint32 height, Uint32 num_mips, Uint64& total_size);
+
     template <typename T>
     concept GpuResource = requires(T a) {
         { a.allocation }
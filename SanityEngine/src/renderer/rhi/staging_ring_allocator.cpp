@@ -0,0 +1,112 @@
+#include "staging_ring_allocator.hpp"
+
+#include "Tracy.hpp"
+#include "core/align.hpp"
+
+namespace sanity::engine::renderer {
+    StagingRingAllocator::StagingRingAllocator(const Uint64 chunk_size_in, const Uint32 num_frames)
+        : chunk_size{chunk_size_in}, frame_chunks{num_frames} {}
+
+    StagingRingAllocation StagingRingAllocator::allocate(const Uint64 size, const Uint64 alignment) {
+        ZoneScoped;
+
+        RX_ASSERT(size > 0, "Can not allocate zero bytes of staging memory");
+        RX_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment %llu is not a power of two", alignment);
+
+        cur_frame_stats.num_bytes_uploaded += size;
+        cur_frame_stats.num_allocations++;
+
+        StagingRingAllocation allocation;
+        if(try_allocate_from_current_chunk(size, alignment, allocation)) {
+            return allocation;
+        }
+
+        // Walk the ring in order, so chunks are reused in the order the GPU finishes with them. Chunks start at offset 0, which is aligned
+        // to anything
+        const auto num_chunks = static_cast<Uint32>(chunks.size());
+        for(Uint32 i = 1; i <= num_chunks; i++) {
+            const auto chunk_idx = (cur_chunk_idx + i) % num_chunks;
+            const auto& chunk = chunks[chunk_idx];
+            if(chunk.num_frames_using == 0 && chunk.size >= size) {
+                cur_chunk_idx = chunk_idx;
+                cur_offset = 0;
+
+                // Can't fail, the chunk is empty and large enough
+                (void) try_allocate_from_current_chunk(size, alignment, allocation);
+                return allocation;
+            }
+        }
+
+        // Every chunk is either in use by a frame in flight or too small, so grow the ring
+        cur_frame_stats.num_stalls++;
+
+        const auto new_chunk_idx = num_chunks;
+        chunks.push_back(Chunk{.size = ALIGN(chunk_size, size)});
+
+        cur_chunk_idx = new_chunk_idx;
+        cur_offset = 0;
+
+        (void) try_allocate_from_current_chunk(size, alignment, allocation);
+        return allocation;
+    }
+
+    void StagingRingAllocator::begin_frame(const Uint32 frame_idx) {
+        ZoneScoped;
+
+        auto& chunks_to_recycle = frame_chunks[frame_idx];
+        chunks_to_recycle.each_fwd([&](const Uint32 chunk_idx) {
+            auto& chunk = chunks[chunk_idx];
+            RX_ASSERT(chunk.num_frames_using > 0, "Staging ring chunk %u was recycled more often than it was used", chunk_idx);
+            chunk.num_frames_using--;
+        });
+        chunks_to_recycle.clear();
+
+        cur_frame_idx = frame_idx;
+        cur_frame_serial++;
+
+        last_frame_stats = cur_frame_stats;
+        cur_frame_stats = {};
+    }
+
+    Uint32 StagingRingAllocator::get_num_chunks() const { return static_cast<Uint32>(chunks.size()); }
+
+    Uint64 StagingRingAllocator::get_chunk_size(const Uint32 chunk_idx) const { return chunks[chunk_idx].size; }
+
+    Uint64 StagingRingAllocator::get_capacity() const {
+        Uint64 capacity{0};
+        chunks.each_fwd([&](const Chunk& chunk) { capacity += chunk.size; });
+
+        return capacity;
+    }
+
+    const StagingRingStats& StagingRingAllocator::get_last_frame_stats() const { return last_frame_stats; }
+
+    bool StagingRingAllocator::try_allocate_from_current_chunk(const Uint64 size,
+                                                               const Uint64 alignment,
+                                                               StagingRingAllocation& allocation) {
+        if(chunks.is_empty()) {
+            return false;
+        }
+
+        const auto offset = ALIGN(alignment, cur_offset);
+        if(offset + size > chunks[cur_chunk_idx].size) {
+            return false;
+        }
+
+        use_chunk(cur_chunk_idx);
+
+        cur_offset = offset + size;
+        allocation = StagingRingAllocation{.chunk_idx = cur_chunk_idx, .offset = offset};
+
+        return true;
+    }
+
+    void StagingRingAllocator::use_chunk(const Uint32 chunk_idx) {
+        auto& chunk = chunks[chunk_idx];
+        if(chunk.last_frame_serial != cur_frame_serial) {
+            chunk.last_frame_serial = cur_frame_serial;
+            chunk.num_frames_using++;
+            frame_chunks[cur_frame_idx].push_back(chunk_idx);
+        }
+    }
+} // namespace sanity::engine::renderer
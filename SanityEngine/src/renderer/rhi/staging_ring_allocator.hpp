@@ -0,0 +1,118 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief A range of bytes in one of the staging ring's chunks
+     */
+    struct StagingRingAllocation {
+        Uint32 chunk_idx{0};
+
+        Uint64 offset{0};
+    };
+
+    /*!
+     * \brief Counts of the upload work done through the staging ring in one frame
+     */
+    struct StagingRingStats {
+        Uint64 num_bytes_uploaded{0};
+
+        Uint32 num_allocations{0};
+
+        /*!
+         * \brief Number of allocations which couldn't reuse memory the GPU was done with, so the ring had to grow by a new chunk
+         */
+        Uint32 num_stalls{0};
+    };
+
+    /*!
+     * \brief Sub-allocates upload memory from a ring of chunks, recycling each chunk once the GPU has finished every frame that used it
+     *
+     * Allocations are linear within the current chunk. When the current chunk is full, the allocator moves on to the next chunk in the
+     * ring which no frame in flight is using, or adds a new chunk if there is none. This only does bookkeeping - the owner creates one
+     * buffer for each chunk - so it can be tested without a GPU. Not thread safe
+     */
+    class StagingRingAllocator {
+    public:
+        /*!
+         * \param chunk_size_in Size of each chunk. Allocations larger than this get a chunk of their own, rounded up to a multiple of this
+         * \param num_frames Number of frames that may be in flight at once
+         */
+        StagingRingAllocator(Uint64 chunk_size_in, Uint32 num_frames);
+
+        StagingRingAllocator(const StagingRingAllocator& other) = delete;
+        StagingRingAllocator& operator=(const StagingRingAllocator& other) = delete;
+
+        StagingRingAllocator(StagingRingAllocator&& old) noexcept = default;
+        StagingRingAllocator& operator=(StagingRingAllocator&& old) noexcept = default;
+
+        ~StagingRingAllocator() = default;
+
+        /*!
+         * \brief Allocates `size` bytes for the current frame. May add a new chunk to the ring, which the caller must create memory for
+         *
+         * \param alignment Alignment of the allocation's offset in its chunk. Must be a power of two
+         */
+        [[nodiscard]] StagingRingAllocation allocate(Uint64 size, Uint64 alignment);
+
+        /*!
+         * \brief Recycles every chunk that was only used by the last frame with this index, and starts counting stats for a new frame
+         *
+         * Must be called after the GPU has finished that frame
+         */
+        void begin_frame(Uint32 frame_idx);
+
+        [[nodiscard]] Uint32 get_num_chunks() const;
+
+        [[nodiscard]] Uint64 get_chunk_size(Uint32 chunk_idx) const;
+
+        /*!
+         * \brief Total size of all the chunks in the ring
+         */
+        [[nodiscard]] Uint64 get_capacity() const;
+
+        [[nodiscard]] const StagingRingStats& get_last_frame_stats() const;
+
+    private:
+        struct Chunk {
+            Uint64 size{0};
+
+            /*!
+             * \brief Number of frames in flight which allocated from this chunk. The chunk may be reused once this is zero
+             */
+            Uint32 num_frames_using{0};
+
+            /*!
+             * \brief Serial number of the last frame which allocated from this chunk, so each frame only counts once
+             */
+            Uint64 last_frame_serial{0};
+        };
+
+        Uint64 chunk_size;
+
+        Rx::Vector<Chunk> chunks;
+
+        Uint32 cur_chunk_idx{0};
+
+        Uint64 cur_offset{0};
+
+        Uint32 cur_frame_idx{0};
+
+        Uint64 cur_frame_serial{1};
+
+        /*!
+         * \brief For each frame index, the chunks the last frame with that index allocated from
+         */
+        Rx::Vector<Rx::Vector<Uint32>> frame_chunks;
+
+        StagingRingStats cur_frame_stats;
+
+        StagingRingStats last_frame_stats;
+
+        [[nodiscard]] bool try_allocate_from_current_chunk(Uint64 size, Uint64 alignment, StagingRingAllocation& allocation);
+
+        void use_chunk(Uint32 chunk_idx);
+    };
+} // namespace sanity::engine::renderer
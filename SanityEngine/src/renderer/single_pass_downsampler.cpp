@@ -58,7 +58,9 @@ namespace sanity::engine::renderer {
         return SinglePassDownsampler{spd_root_sig, spd_pipeline, backend};
     }
 
-    void SinglePassDownsampler::generate_mip_chain_for_texture(ID3D12Resource* texture, ID3D12GraphicsCommandList2* cmds) const {
+    void SinglePassDownsampler::generate_mip_chain_for_texture(ID3D12Resource* texture,
+                                                               ID3D12GraphicsCommandList2* cmds,
+                                                               const bool is_loading_texture) const {
         const auto texture_name = get_object_name(texture);
         ZoneScoped;
 
@@ -81,7 +83,7 @@ namespace sanity::engine::renderer {
         const auto num_mips = num_work_groups_and_mips[1];
 
         // Set up descriptors
-        const auto descriptor_table_handle = fill_descriptor_table(texture, device, num_mips);
+        const auto descriptor_table_handle = fill_descriptor_table(texture, device, num_mips, is_loading_texture);
 
         // Allowed usage of creating a non-bindless buffer, since this uses a bindy resource mode
 
@@ -156,13 +158,15 @@ namespace sanity::engine::renderer {
 
     DescriptorRange SinglePassDownsampler::fill_descriptor_table(ID3D12Resource* texture,
                                                                  ID3D12Device* device,
-                                                                 const Uint32 num_mips) const {
+                                                                 const Uint32 num_mips,
+                                                                 const bool is_loading_texture) const {
         const auto& desc = texture->GetDesc();
 
         auto& descriptor_allocator = backend->get_cbv_srv_uav_allocator();
 
         const auto descriptor_size = descriptor_allocator.get_descriptor_size();
-        const auto output_mips_descriptors = descriptor_allocator.allocate_descriptors(16);
+        const auto output_mips_descriptors = is_loading_texture ? descriptor_allocator.allocate_frame_descriptors(16) :
+                                                                  descriptor_allocator.allocate_transient_descriptors(16);
         const auto first_cpu_descriptor_ptr = output_mips_descriptors.cpu_handle.ptr;
 
         auto cur_descriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE{output_mips_descriptors.cpu_handle};
@@ -33,8 +33,12 @@ namespace sanity::engine::renderer {
          *
          * @param texture Texture to generate mips for
          * @param cmds Command list ot use
+         * @param is_loading_texture Whether the texture is being loaded. Loading can generate mips for hundreds of textures in one frame,
+         * which would use up the transient descriptor ring, so those textures get their descriptors from the persistent part of the heap
          */
-        void generate_mip_chain_for_texture(ID3D12Resource* texture, ID3D12GraphicsCommandList2* cmds) const;
+        void generate_mip_chain_for_texture(ID3D12Resource* texture,
+                                            ID3D12GraphicsCommandList2* cmds,
+                                            bool is_loading_texture = false) const;
 
     private:
         ComPtr<ID3D12RootSignature> root_signature;
@@ -47,6 +51,9 @@ namespace sanity::engine::renderer {
                                        ComPtr<ID3D12PipelineState> pipeline_in,
                                        RenderBackend& backend_in);
 
-        [[nodiscard]] DescriptorRange fill_descriptor_table(ID3D12Resource* texture, ID3D12Device* device, Uint32 num_mips) const;
+        [[nodiscard]] DescriptorRange fill_descriptor_table(ID3D12Resource* texture,
+                                                            ID3D12Device* device,
+                                                            Uint32 num_mips,
+                                                            bool is_loading_texture) const;
     };
 } // namespace sanity::engine::renderer
@@ -0,0 +1,148 @@
+#include "transient_resource_packer.hpp"
+
+#include <algorithm>
+
+#include "Tracy.hpp"
+#include "rx/core/map.h"
+
+namespace sanity::engine::renderer {
+    static Uint64 align_offset(const Uint64 offset, const Uint64 alignment) {
+        if(alignment <= 1) {
+            return offset;
+        }
+
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static bool lifetimes_overlap(const TransientResourceRequest& a, const TransientResourceRequest& b) {
+        return a.first_pass <= b.last_pass && b.first_pass <= a.last_pass;
+    }
+
+    Uint64 TransientHeapLayout::get_saved_bytes() const { return total_resource_size - heap_size; }
+
+    TransientHeapLayout pack_transient_resources(const Rx::Vector<TransientResourceRequest>& requests) {
+        ZoneScoped;
+
+        const auto num_requests = static_cast<Uint32>(requests.size());
+
+        TransientHeapLayout layout;
+        layout.offsets.resize(num_requests, 0);
+
+        Rx::Vector<Uint32> placement_order;
+        placement_order.reserve(num_requests);
+        for(auto i = 0u; i < num_requests; i++) {
+            placement_order.push_back(i);
+            layout.total_resource_size += requests[i].size;
+        }
+
+        std::sort(placement_order.data(), placement_order.data() + placement_order.size(), [&](const Uint32 a, const Uint32 b) {
+            if(requests[a].size != requests[b].size) {
+                return requests[a].size > requests[b].size;
+            }
+
+            return requests[a].first_pass < requests[b].first_pass;
+        });
+
+        Rx::Vector<Uint32> placed_requests;
+        placed_requests.reserve(num_requests);
+
+        placement_order.each_fwd([&](const Uint32 request_idx) {
+            const auto& request = requests[request_idx];
+
+            // The lowest valid offset is either the start of the heap or right after some resource that's alive at the same time as this
+            // one, so those are the only offsets we need to try
+            Rx::Vector<Uint64> candidate_offsets;
+            candidate_offsets.push_back(0);
+            placed_requests.each_fwd([&](const Uint32 placed_idx) {
+                if(lifetimes_overlap(request, requests[placed_idx])) {
+                    candidate_offsets.push_back(align_offset(layout.offsets[placed_idx] + requests[placed_idx].size, request.alignment));
+                }
+            });
+
+            std::sort(candidate_offsets.data(), candidate_offsets.data() + candidate_offsets.size());
+
+            auto offset = candidate_offsets.last();
+            candidate_offsets.each_fwd([&](const Uint64 candidate_offset) {
+                auto fits = true;
+                placed_requests.each_fwd([&](const Uint32 placed_idx) {
+                    const auto& placed_request = requests[placed_idx];
+                    const auto placed_offset = layout.offsets[placed_idx];
+                    if(lifetimes_overlap(request, placed_request) && candidate_offset < placed_offset + placed_request.size &&
+                       placed_offset < candidate_offset + request.size) {
+                        fits = false;
+                        return false;
+                    }
+
+                    return true;
+                });
+
+                if(fits) {
+                    offset = candidate_offset;
+                    return false;
+                }
+
+                return true;
+            });
+
+            layout.offsets[request_idx] = offset;
+            layout.heap_size = std::max(layout.heap_size, offset + request.size);
+            placed_requests.push_back(request_idx);
+        });
+
+        return layout;
+    }
+
+    Rx::Vector<TransientResourceRequest> get_transient_resource_requests(const CompiledRenderGraph& render_graph,
+                                                                         const Rx::Vector<RenderGraphPassDescription>& passes,
+                                                                         const Rx::Vector<Uint32>& resources,
+                                                                         const Rx::Vector<Uint64>& sizes,
+                                                                         const Uint64 alignment) {
+        ZoneScoped;
+
+        const auto num_positions = static_cast<Uint32>(render_graph.pass_order.size());
+
+        Rx::Map<Uint32, Uint32> request_idx_by_resource;
+        Rx::Vector<TransientResourceRequest> requests;
+        requests.reserve(resources.size());
+        for(auto i = 0u; i < resources.size(); i++) {
+            request_idx_by_resource.insert(resources[i], i);
+            requests.push_back(
+                TransientResourceRequest{.size = sizes[i], .alignment = alignment, .first_pass = num_positions, .last_pass = 0});
+        }
+
+        for(auto position = 0u; position < num_positions; position++) {
+            passes[render_graph.pass_order[position]].resource_usages.each_fwd([&](const RenderGraphResourceUsage& usage) {
+                if(const auto* request_idx = request_idx_by_resource.find(usage.resource)) {
+                    auto& request = requests[*request_idx];
+                    request.first_pass = std::min(request.first_pass, position);
+                    request.last_pass = std::max(request.last_pass, position);
+                }
+            });
+        }
+
+        requests.each_fwd([&](TransientResourceRequest& request) {
+            if(request.first_pass > request.last_pass) {
+                request.first_pass = 0;
+                request.last_pass = num_positions;
+            }
+        });
+
+        return requests;
+    }
+
+    bool transient_lifetimes_changed(const Rx::Vector<TransientResourceRequest>& old_requests,
+                                     const Rx::Vector<TransientResourceRequest>& new_requests) {
+        if(old_requests.size() != new_requests.size()) {
+            return true;
+        }
+
+        for(auto i = 0u; i < new_requests.size(); i++) {
+            if(old_requests[i].first_pass != new_requests[i].first_pass || old_requests[i].last_pass != new_requests[i].last_pass ||
+               old_requests[i].size != new_requests[i].size) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+} // namespace sanity::engine::renderer
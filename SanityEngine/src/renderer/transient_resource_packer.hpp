@@ -0,0 +1,76 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "renderer/render_graph.hpp"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief A resource which only holds meaningful data between two passes of a frame
+     */
+    struct TransientResourceRequest {
+        Uint64 size{0};
+
+        Uint64 alignment{1};
+
+        /*!
+         * \brief Index of the first pass which uses the resource
+         */
+        Uint32 first_pass{0};
+
+        /*!
+         * \brief Index of the last pass which uses the resource
+         */
+        Uint32 last_pass{0};
+    };
+
+    struct TransientHeapLayout {
+        /*!
+         * \brief Offset of each resource in the heap, in the same order as the requests
+         */
+        Rx::Vector<Uint64> offsets;
+
+        /*!
+         * \brief Size of the heap that all the resources fit in
+         */
+        Uint64 heap_size{0};
+
+        /*!
+         * \brief Sum of the sizes of all the resources - how much memory they'd take without aliasing
+         */
+        Uint64 total_resource_size{0};
+
+        [[nodiscard]] Uint64 get_saved_bytes() const;
+    };
+
+    /*!
+     * \brief Packs transient resources into a single heap, letting resources whose lifetimes don't overlap share memory
+     *
+     * This is the interval graph coloring problem with weights, which is NP-hard, so we use the usual greedy heuristic instead: resources
+     * are placed from largest to smallest, each one at the lowest offset which doesn't overlap the memory of any already-placed resource
+     * that's alive at the same time as it
+     */
+    [[nodiscard]] TransientHeapLayout pack_transient_resources(const Rx::Vector<TransientResourceRequest>& requests);
+
+    /*!
+     * \brief Builds a packing request for each transient resource, with the lifetime that the resource has in the compiled render graph
+     *
+     * Lifetimes are positions in `render_graph.pass_order`. Resources which no live pass declared a usage of might still be read through
+     * the bindless array, so they live for the whole frame
+     *
+     * \param passes The pass descriptions that `render_graph` was compiled from
+     * \param resources IDs of the transient resources, as used in the pass descriptions
+     * \param sizes Size of each transient resource, in the same order as `resources`
+     */
+    [[nodiscard]] Rx::Vector<TransientResourceRequest> get_transient_resource_requests(const CompiledRenderGraph& render_graph,
+                                                                                       const Rx::Vector<RenderGraphPassDescription>& passes,
+                                                                                       const Rx::Vector<Uint32>& resources,
+                                                                                       const Rx::Vector<Uint64>& sizes,
+                                                                                       Uint64 alignment);
+
+    /*!
+     * \brief Checks if a new set of requests would pack differently from the requests that were packed last time
+     */
+    [[nodiscard]] bool transient_lifetimes_changed(const Rx::Vector<TransientResourceRequest>& old_requests,
+                                                   const Rx::Vector<TransientResourceRequest>& new_requests);
+} // namespace sanity::engine::renderer
@@ -0,0 +1,60 @@
+#include "world_bounds_cache.hpp"
+
+#include "Tracy.hpp"
+#include "core/components.hpp"
+#include "entt/entity/registry.hpp"
+
+namespace sanity::engine::renderer {
+    static bool are_bounds_equal(const Rx::Optional<BoundingBox>& lhs, const Rx::Optional<BoundingBox>& rhs) {
+        if(!lhs || !rhs) {
+            return !lhs && !rhs;
+        }
+
+        return lhs->x_min == rhs->x_min && lhs->x_max == rhs->x_max && lhs->y_min == rhs->y_min && lhs->y_max == rhs->y_max &&
+               lhs->z_min == rhs->z_min && lhs->z_max == rhs->z_max;
+    }
+
+    void WorldBoundsCache::begin_frame(const TransformHierarchy& hierarchy_in) {
+        ZoneScoped;
+
+        const auto num_rebuilds = hierarchy_in.get_num_rebuilds();
+        if(hierarchy != &hierarchy_in || hierarchy_num_rebuilds != num_rebuilds) {
+            cached_bounds.clear();
+            hierarchy = &hierarchy_in;
+            hierarchy_num_rebuilds = num_rebuilds;
+        }
+
+        cached_bounds.resize(hierarchy->get_num_nodes());
+
+        cur_frame++;
+        num_updated_bounds = 0;
+    }
+
+    VisibleObjectCullingInformation WorldBoundsCache::get_world_bounds(const entt::entity entity,
+                                                                       const Rx::Optional<BoundingBox>& local_bounds,
+                                                                       const entt::registry& registry) {
+        const auto node_idx = hierarchy->get_node_idx(entity);
+        if(node_idx == TransformHierarchy::NO_NODE) {
+            num_updated_bounds++;
+            return get_culling_information(local_bounds, registry.get<TransformComponent>(entity).get_model_matrix(registry));
+        }
+
+        auto& cached = cached_bounds[node_idx];
+        const auto is_up_to_date = cached.is_valid && cached.entity == entity && cur_frame - cached.last_checked_frame <= 1 &&
+                                   !hierarchy->is_node_updated(node_idx) && are_bounds_equal(cached.local_bounds, local_bounds);
+        if(!is_up_to_date) {
+            cached.local_bounds = local_bounds;
+            cached.world_bounds = get_culling_information(local_bounds, hierarchy->get_node_world_matrix(node_idx));
+            cached.entity = entity;
+            cached.is_valid = true;
+
+            num_updated_bounds++;
+        }
+
+        cached.last_checked_frame = cur_frame;
+
+        return cached.world_bounds;
+    }
+
+    Uint32 WorldBoundsCache::get_num_updated_bounds() const { return num_updated_bounds; }
+} // namespace sanity::engine::renderer
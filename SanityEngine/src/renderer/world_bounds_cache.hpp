@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core/transform_hierarchy.hpp"
+#include "core/types.hpp"
+#include "renderer/frustum_culler.hpp"
+#include "renderer/mesh.hpp"
+#include "rx/core/optional.h"
+#include "rx/core/vector.h"
+
+namespace sanity::engine::renderer {
+    /*!
+     * \brief Keeps the world-space bounding boxes of objects from one frame to the next, so that only the boxes of objects which moved or
+     * changed their bounds get recomputed
+     *
+     * Boxes are stored per node of a TransformHierarchy, and the hierarchy's dirty flags say which nodes moved. The dirty flags only cover
+     * the hierarchy's last update, so a box is only reused if it was also checked the frame before
+     */
+    class WorldBoundsCache {
+    public:
+        WorldBoundsCache() = default;
+
+        WorldBoundsCache(const WorldBoundsCache& other) = delete;
+        WorldBoundsCache& operator=(const WorldBoundsCache& other) = delete;
+
+        WorldBoundsCache(WorldBoundsCache&& old) noexcept = default;
+        WorldBoundsCache& operator=(WorldBoundsCache&& old) noexcept = default;
+
+        ~WorldBoundsCache() = default;
+
+        /*!
+         * \brief Catches up with the hierarchy's last update. Must be called every frame after updating the hierarchy, and before getting
+         * any world bounds
+         *
+         * Re-sorting the hierarchy changes every node's index, so it throws away all the cached boxes
+         */
+        void begin_frame(const TransformHierarchy& hierarchy);
+
+        /*!
+         * \brief Gets the world-space bounding box of an entity with the given local-space bounds
+         *
+         * The box is recomputed if the entity's world matrix changed in the hierarchy's last update, if the local bounds aren't the same
+         * as last time, if the box wasn't checked last frame, or if the node belonged to another entity. Entities which aren't in the
+         * hierarchy yet get a new box every time
+         */
+        [[nodiscard]] VisibleObjectCullingInformation get_world_bounds(entt::entity entity,
+                                                                       const Rx::Optional<BoundingBox>& local_bounds,
+                                                                       const entt::registry& registry);
+
+        /*!
+         * \brief Number of world-space boxes which were recomputed since the last call to `begin_frame`
+         */
+        [[nodiscard]] Uint32 get_num_updated_bounds() const;
+
+    private:
+        struct CachedBounds {
+            Rx::Optional<BoundingBox> local_bounds;
+
+            VisibleObjectCullingInformation world_bounds;
+
+            /*!
+             * \brief The entity whose bounds these are, in case the entity's node went to another entity
+             */
+            entt::entity entity{};
+
+            /*!
+             * \brief The last frame these bounds were checked in. Frames where they weren't checked might have moved the node
+             */
+            Uint32 last_checked_frame{0};
+
+            bool is_valid{false};
+        };
+
+        const TransformHierarchy* hierarchy{nullptr};
+
+        Uint32 hierarchy_num_rebuilds{0};
+
+        Uint32 cur_frame{0};
+
+        /*!
+         * \brief The cached bounds of each node of the hierarchy
+         */
+        Rx::Vector<CachedBounds> cached_bounds;
+
+        Uint32 num_updated_bounds{0};
+    };
+} // namespace sanity::engine::renderer
@@ -1,7 +1,9 @@
 ﻿#include "sanity_engine.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <ranges>
+#include <thread>
 
 #include "GLFW/glfw3.h"
 #include "TracyD3D12.hpp"
@@ -103,6 +105,10 @@ namespace sanity::engine {
 
             register_engine_component_type_reflection();
 
+            // Leave one core for the main thread, which helps out with parallel work anyways
+            const auto num_worker_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+            thread_pool = Rx::make_ptr<ThreadPool>(RX_SYSTEM_ALLOCATOR, num_worker_threads);
+
             renderer = Rx::make_ptr<renderer::Renderer>(RX_SYSTEM_ALLOCATOR, window);
             logger->info("Initialized renderer");
 
@@ -216,6 +222,8 @@ namespace sanity::engine {
 
     InputManager& SanityEngine::get_input_manager() const { return *input_manager; }
 
+    ThreadPool& SanityEngine::get_thread_pool() const { return *thread_pool; }
+
     Uint32 SanityEngine::get_frame_count() const { return frame_count; }
 
     void SanityEngine::register_cvar_change_listeners() {
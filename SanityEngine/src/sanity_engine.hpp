@@ -5,6 +5,7 @@
 #include "adapters/rex/rex_wrapper.hpp"
 #include "core/Prelude.hpp"
 #include "core/asset_registry.hpp"
+#include "core/async/thread_pool.hpp"
 #include "core/reflection/type_reflection.hpp"
 #include "entt/entity/registry.hpp"
 #include "input/input_manager.hpp"
@@ -62,6 +63,8 @@ namespace sanity::engine {
         [[nodiscard]] renderer::Renderer& get_renderer() const;
 
         [[nodiscard]] InputManager& get_input_manager() const;
+
+        [[nodiscard]] ThreadPool& get_thread_pool() const;
     	
         [[nodiscard]] Uint32 get_frame_count() const;
 
@@ -72,6 +75,8 @@ namespace sanity::engine {
 
         Rx::Ptr<InputManager> input_manager;
 
+        Rx::Ptr<ThreadPool> thread_pool;
+
         Rx::Ptr<renderer::Renderer> renderer;
 
         Rx::Ptr<DearImguiAdapter> imgui_adapter;
@@ -105,6 +105,11 @@ namespace sanity::engine::ui {
         ImGui::LabelText("Num vertices", "%d", mesh.num_vertices);
         ImGui::LabelText("First index", "%d", mesh.first_index);
         ImGui::LabelText("Num indices", "%d", mesh.num_indices);
+        ImGui::LabelText("Num LODs", "%d", mesh.num_lods);
+        for(Uint32 lod_idx = 0; lod_idx < mesh.num_lods; lod_idx++) {
+            const auto& lod = mesh.lods[lod_idx];
+            ImGui::Text("LOD %u: %u indices, error %f", lod_idx + 1, lod.num_indices, lod.error);
+        }
     }
 
     void draw_property(const Rx::String& label, renderer::StandardMaterialHandle& handle) {